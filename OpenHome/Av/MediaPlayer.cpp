@@ -191,7 +191,8 @@ MediaPlayer::MediaPlayer(Net::DvStack& aDvStack, Net::CpStack& aCpStack, Net::Dv
     }
     Optional<IConfigInitialiser> configInit(aInitParams->ConfigStartupMode() ? iConfigManager : nullptr);
     iPowerManager = new OpenHome::PowerManager(configInit);
-    iThreadPool = new OpenHome::ThreadPool(aInitParams->ThreadPoolCountHigh(),
+    iThreadPool = new OpenHome::ThreadPool(aInfoAggregator,
+                                           aInitParams->ThreadPoolCountHigh(),
                                            aInitParams->ThreadPoolCountMedium(),
                                            aInitParams->ThreadPoolCountLow());
     auto ssl = aInitParams->Ssl();
@@ -23,6 +23,7 @@ namespace Av {
 class ProtocolQobuz : public Media::ProtocolNetwork, private IReader
 {
     static const TUint kTcpConnectTimeoutMs = 10 * 1000;
+    static const TUint kRecvBufBytes = 256 * 1024; // ~1s of 192/24 FLAC
 public:
     ProtocolQobuz(Environment& aEnv, SslContext& aSsl, const Brx& aAppId, const Brx& aAppSecret,
                    Credentials& aCredentialsManager, Configuration::IConfigInitialiser& aConfigInitialiser,
@@ -114,7 +115,7 @@ ProtocolQobuz::ProtocolQobuz(Environment& aEnv, SslContext& aSsl, const Brx& aAp
                              IUnixTimestamp& aUnixTimestamp, Net::DvDeviceStandard& aDevice, 
                              Media::TrackFactory& aTrackFactory, Net::CpStack& aCpStack, Optional<IPinsInvocable> aPinsInvocable, 
                              IThreadPool& aThreadPool, Media::IPipelineObservable& aPipelineObservable)
-    : ProtocolNetwork(aEnv)
+    : ProtocolNetwork(aEnv, kReadBufferBytes, kRecvBufBytes)
     , iSupply(nullptr)
     , iQobuzTrack(nullptr)
     , iWriterRequest(iWriterBuf)
@@ -446,7 +447,7 @@ ProtocolStreamResult ProtocolQobuz::ProcessContent()
         iStarted = true;
     }
     iContentProcessor = iProtocolManager->GetAudioProcessor();
-    auto res = iContentProcessor->Stream(*this, iTotalBytes);
+    auto res = StreamAudio(*iContentProcessor, *this, iTotalBytes);
     if (res == EProtocolStreamErrorRecoverable && !(iSeek || iStopped)) {
         if (iQobuz->TryUpdateStreamUrl(*iQobuzTrack)) {
             iUri.Replace(iQobuzTrack->Url());
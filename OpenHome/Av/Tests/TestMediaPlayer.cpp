@@ -6,6 +6,7 @@
 #include <OpenHome/Net/Core/DvDevice.h>
 #include <OpenHome/Media/PipelineManager.h>
 #include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Media/Utils/ShellCommandPipelineTrace.h>
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Private/TestFramework.h>
 #include <OpenHome/Media/Codec/CodecFactory.h>
@@ -247,6 +248,7 @@ TestMediaPlayer::TestMediaPlayer(Net::DvStack& aDvStack, Net::CpStack& aCpStack,
     delete mpInit;
     iPipelineObserver = new LoggingPipelineObserver();
     iMediaPlayer->Pipeline().AddObserver(*iPipelineObserver);
+    iPipelineTrace = new ShellCommandPipelineTrace(*(aDvStack.Env().Shell()), iMediaPlayer->Pipeline().Trace());
 
     iFnUpdaterStandard = new FriendlyNameAttributeUpdater(iMediaPlayer->FriendlyNameObservable(), iMediaPlayer->ThreadPool(), *iDevice);
     iFnManagerUpnpAv = new FriendlyNameManagerUpnpAv(kFriendlyNamePrefix, iMediaPlayer->Product());
@@ -277,6 +279,7 @@ TestMediaPlayer::~TestMediaPlayer()
     delete iFnUpdaterUpnpAv;
     delete iFnManagerUpnpAv;
     delete iFsFlushPeriodic;
+    delete iPipelineTrace;
     delete iMediaPlayer;
     delete iPipelineObserver;
     delete iInfoLogger;
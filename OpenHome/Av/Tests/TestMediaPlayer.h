@@ -43,6 +43,7 @@ namespace Media {
     class DriverSongcastSender;
     class IPullableClock;
     class AllocatorInfoLogger;
+    class ShellCommandPipelineTrace;
 }
 namespace Configuration {
     class ConfigRamStore;
@@ -178,6 +179,7 @@ private:
     VolumeSinkLogger iVolumeLogger;
     Bws<Uri::kMaxUriBytes+1> iPresentationUrl;
     Media::LoggingPipelineObserver* iPipelineObserver;
+    Media::ShellCommandPipelineTrace* iPipelineTrace;
     Av::FriendlyNameAttributeUpdater* iFnUpdaterStandard;
     FriendlyNameManagerUpnpAv* iFnManagerUpnpAv;
     Av::FriendlyNameAttributeUpdater* iFnUpdaterUpnpAv;
@@ -25,6 +25,7 @@ class ProtocolTidal : public Media::ProtocolNetworkSsl, private IReader
 {
     static const TUint kMaxErrorReadBytes = 1024;
     static const TUint kTcpConnectTimeoutMs = 10 * 1000;
+    static const TUint kSocketReadBytes = 16 * 1024; // max TLS record
 
 
     static const TUint kMinSupportedTrackVersion = 1;
@@ -122,7 +123,7 @@ ProtocolTidal::ProtocolTidal(Environment& aEnv, SslContext& aSsl, Tidal::Configu
                              IConfigInitialiser& aConfigInitialiser, Net::DvDeviceStandard& aDevice,
                              Media::TrackFactory& aTrackFactory, Net::CpStack& aCpStack,
                              Optional<IPinsInvocable> aPinsInvocable, IThreadPool& aThreadPool, ProviderOAuth& aOAuthManager)
-    : ProtocolNetworkSsl(aEnv, aSsl)
+    : ProtocolNetworkSsl(aEnv, aSsl, kSocketReadBytes)
     , iTokenProvider(nullptr)
     , iSupply(nullptr)
     , iTokenId(128)
@@ -586,7 +587,7 @@ ProtocolStreamResult ProtocolTidal::ProcessContent()
         iStarted = true;
     }
     iContentProcessor = iProtocolManager->GetAudioProcessor();
-    auto res = iContentProcessor->Stream(*this, iTotalBytes);
+    auto res = StreamAudio(*iContentProcessor, *this, iTotalBytes);
 
     if (res == EProtocolStreamErrorRecoverable && !(iSeek || iStopped))
     {
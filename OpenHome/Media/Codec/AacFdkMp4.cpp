@@ -57,6 +57,7 @@ CodecAacFdkMp4::CodecAacFdkMp4(IMimeTypeList& aMimeTypeList)
     : CodecAacFdkBase("AAC", aMimeTypeList)
     , iAudioSpecificConfig(kDefaultAscBytes)
 {
+    AddSignature("mp4a"); // written by Mpeg4Container ahead of codec config
 }
 
 CodecAacFdkMp4::~CodecAacFdkMp4()
@@ -13,6 +13,7 @@ CodecAiffBase::CodecAiffBase(const TChar* aName)
     : CodecBase(aName, kCostLow)
     , iName(aName)
 {
+    AddSignature(aName, 8); // FORM type
 }
 
 CodecAiffBase::~CodecAiffBase()
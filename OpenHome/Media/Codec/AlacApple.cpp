@@ -60,6 +60,7 @@ CodecAlacApple::CodecAlacApple(IMimeTypeList& aMimeTypeList)
 {
     LOG(kCodec, "CodecAlac::CodecAlac\n");
     aMimeTypeList.Add("audio/x-m4a");
+    AddSignature("alac"); // written by Mpeg4Container ahead of codec config
 }
 
 CodecAlacApple::~CodecAlacApple()
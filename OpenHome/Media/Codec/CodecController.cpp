@@ -148,11 +148,63 @@ CodecBase::CodecBase(const TChar* aId, RecognitionComplexity aRecognitionCost)
 {
 }
 
+void CodecBase::AddSignature(const TChar* aMagic, TUint aOffset)
+{
+    iSignatures.push_back(Signature(aMagic, aOffset));
+    ASSERT(iSignatures.back().Bytes() <= kMaxSignatureBytes);
+}
+
 void CodecBase::Construct(ICodecController& aController)
 {
     iController = &aController;
 }
 
+TBool CodecBase::HasSignature() const
+{
+    return iSignatures.size() > 0;
+}
+
+TBool CodecBase::MatchesSignature(const Brx& aHeader) const
+{
+    for (auto& signature : iSignatures) {
+        if (signature.Matches(aHeader)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TUint CodecBase::SignatureBytes() const
+{
+    TUint bytes = 0;
+    for (auto& signature : iSignatures) {
+        bytes = std::max(bytes, signature.Bytes());
+    }
+    return bytes;
+}
+
+
+// CodecBase::Signature
+
+CodecBase::Signature::Signature(const TChar* aMagic, TUint aOffset)
+    : iMagic(aMagic)
+    , iOffset(aOffset)
+{
+}
+
+TBool CodecBase::Signature::Matches(const Brx& aHeader) const
+{
+    if (aHeader.Bytes() < Bytes()) {
+        return false;
+    }
+    return Brn(aHeader.Ptr() + iOffset, iMagic.Bytes()) == iMagic;
+}
+
+TUint CodecBase::Signature::Bytes() const
+{
+    return iOffset + iMagic.Bytes();
+}
+
 SpeakerProfile CodecBase::DeriveProfile(TUint aChannels)
 {
     return (aChannels == 1) ? SpeakerProfile(1) : SpeakerProfile(2);
@@ -172,6 +224,7 @@ CodecController::CodecController(MsgFactory& aMsgFactory, IPipelineElementUpstre
     , iLock("CDCC")
     , iShutdownSem("CDC2", 0)
     , iAnimator(nullptr)
+    , iSignatureBytes(0)
     , iActiveCodec(nullptr)
     , iPendingMsg(nullptr)
     , iPendingQuit(nullptr)
@@ -190,6 +243,11 @@ CodecController::CodecController(MsgFactory& aMsgFactory, IPipelineElementUpstre
     , iBitDepth(0)
     , iStreamLength(0)
     , iStreamPos(0)
+    , iDecodeAhead(nullptr)
+    , iThreadScheduler(nullptr)
+    , iDecodeAheadJiffies(0)
+    , iDecodedTrackLength(0)
+    , iDecodeAheadNotified(false)
     , iTrackId(UINT_MAX)
     , iMaxOutputSamples(0)
     , iMaxOutputBytes(0)
@@ -237,6 +295,8 @@ void CodecController::AddCodec(CodecBase* aCodec)
         }
     }
     iCodecs.insert(it, aCodec);
+    iRecognitionCandidates.reserve(iCodecs.size());
+    iSignatureBytes = std::max(iSignatureBytes, aCodec->SignatureBytes());
 #if 0
     Log::Print("Sorted codecs are: ");
     it = iCodecs.begin();
@@ -257,6 +317,17 @@ void CodecController::SetAnimator(IPipelineAnimator& aAnimator)
     iAnimator = &aAnimator;
 }
 
+void CodecController::SetDecodeAhead(IDecodeAhead& aDecodeAhead, TUint aJiffies)
+{
+    iDecodeAhead = &aDecodeAhead;
+    iDecodeAheadJiffies = aJiffies;
+}
+
+void CodecController::SetThreadScheduler(IPipelineThreadScheduler& aThreadScheduler)
+{
+    iThreadScheduler = &aThreadScheduler;
+}
+
 void CodecController::StartSeek(TUint aStreamId, TUint aSecondsAbsolute, ISeekObserver& aObserver, TUint& aHandle)
 {
     AutoMutex a(iLock);
@@ -288,6 +359,9 @@ void CodecController::StartSeek(TUint aStreamId, TUint aSecondsAbsolute, ISeekOb
 
 void CodecController::CodecThread()
 {
+    if (iThreadScheduler != nullptr) {
+        iThreadScheduler->ApplyToCurrentThread(PipelineThread::Codec);
+    }
     iStreamStarted = false;
     iSeek = false;
     iQuit = false;
@@ -306,6 +380,8 @@ void CodecController::CodecThread()
             iChannels = iBitDepth = iBytesPerSample = 0;
             iSampleRate = iSeekSeconds = 0;
             iStreamPos = 0LL;
+            iDecodedTrackLength = 0LL;
+            iDecodeAheadNotified = false;
             ReleaseAudioEncoded();
             ReleaseAudioDecoded();
             iLock.Signal();
@@ -338,9 +414,10 @@ void CodecController::CodecThread()
 
             LOG(kMedia, "CodecThread: start recognition.  iTrackId=%u, iStreamId=%u\n", iTrackId, iStreamId);
             TBool streamEnded = false;
+            const TBool flushing = !SelectRecognitionCandidates(streamInfo, streamEnded);
 
-            for (size_t i=0; i<iCodecs.size() && !iQuit && !iStreamStopped; i++) {
-                CodecBase* codec = iCodecs[i];
+            for (size_t i=0; i<iRecognitionCandidates.size() && !flushing && !iQuit && !iStreamStopped; i++) {
+                CodecBase* codec = iRecognitionCandidates[i];
                 TBool recognised = false;
                 try {
                     recognised = codec->Recognise(streamInfo);
@@ -409,6 +486,10 @@ void CodecController::CodecThread()
                         iExpectedSeekFlushId = MsgFlush::kIdInvalid;
                         TUint64 sampleNum = iSeekSeconds * static_cast<TUint64>(iSampleRate);
                         iSeekInProgress = true;
+                        if (iDecodeAheadNotified) {
+                            iDecodeAheadNotified = false;
+                            iDecodeAhead->NotifyStreamSeek(iStreamId);
+                        }
                         try {
                             (void)iActiveCodec->TrySeek(iStreamId, sampleNum);
                         }
@@ -481,6 +562,48 @@ void CodecController::CodecThread()
     }
 }
 
+TBool CodecController::SelectRecognitionCandidates(const EncodedStreamInfo& aStreamInfo, TBool& aStreamEnded)
+{
+    /* Read enough of the stream to check every declared signature then rewind.
+       Codecs whose signature matches are tried first, followed by any that don't declare
+       a signature (in cost order).  Codecs whose signatures don't match are skipped,
+       saving the Read()/Rewind() of a failed Recognise() for each. */
+    iRecognitionCandidates.clear();
+    iRecognitionHeader.SetBytes(0);
+    if (aStreamInfo.StreamFormat() == EncodedStreamInfo::Format::Encoded && iSignatureBytes > 0) {
+        try {
+            Read(iRecognitionHeader, iSignatureBytes);
+        }
+        catch (CodecStreamStart&) {}
+        catch (CodecStreamEnded&) {}
+        catch (CodecStreamStopped&) {}
+        catch (CodecStreamFlush&) {
+            return false;
+        }
+        catch (CodecRecognitionOutOfData&) {}
+        iLock.Wait();
+        if (iStreamStarted || iStreamEnded) {
+            aStreamEnded = true;
+        }
+        iStreamStarted = iStreamEnded = false;
+        Rewind();
+        iLock.Signal();
+    }
+    for (auto codec : iCodecs) {
+        if (codec->HasSignature() && codec->MatchesSignature(iRecognitionHeader)) {
+            iRecognitionCandidates.push_back(codec);
+        }
+    }
+    for (auto codec : iCodecs) {
+        if (!codec->HasSignature()) {
+            iRecognitionCandidates.push_back(codec);
+        }
+    }
+    LOG(kMedia, "CodecThread: %u of %u codecs are recognition candidates\n",
+                (TUint)iRecognitionCandidates.size(), (TUint)iCodecs.size());
+    return true;
+}
+
 void CodecController::Rewind()
 {
     iRewinder.Rewind();
@@ -538,6 +661,7 @@ void CodecController::ReleaseAudioDecoded()
         iAudioDecoded->RemoveRef();
         iAudioDecoded = nullptr;
     }
+    iAudioDecodedBytes = 0;
 }
 
 void CodecController::Read(Bwx& aBuf, TUint aBytes)
@@ -752,6 +876,7 @@ void CodecController::DoOutputDecodedStream(MsgDecodedStream* aMsg)
         iSampleRate = stream.SampleRate();
         iBitDepth = stream.BitDepth();
         iBytesPerSample = iChannels * iBitDepth / 8;
+        iDecodedTrackLength = stream.TrackLength();
 
         // Handle when the new MsgDecodedStream should be output.
         if (iPostSeekStreamInfo != nullptr) {
@@ -818,7 +943,7 @@ TUint64 CodecController::OutputAudioPcm(MsgAudioEncoded* aMsg, TUint aChannels,
     return DoOutputAudio(audio);
 }
 
-TUint64 CodecController::DoOutputAudio(MsgAudio* aAudioMsg)
+TUint64 CodecController::DoOutputAudio(MsgAudioDecoded* aAudioMsg)
 {
     if (iExpectedFlushId != MsgFlush::kIdInvalid) {
         // Codec outputting audio while flush is pending
@@ -839,6 +964,14 @@ TUint64 CodecController::DoOutputAudio(MsgAudio* aAudioMsg)
         iPostSeekStreamInfo = nullptr;
     }
     const TUint jiffies= aAudioMsg->Jiffies();
+    if (iDecodeAhead != nullptr && !iDecodeAheadNotified && !iLive && iDecodedTrackLength > 0) {
+        // Notify before queueing so that this msg can use any extra space
+        const TUint64 decoded = aAudioMsg->TrackOffset() + jiffies;
+        if (decoded + iDecodeAheadJiffies >= iDecodedTrackLength) {
+            iDecodeAheadNotified = true;
+            iDecodeAhead->NotifyStreamEnding(iStreamId);
+        }
+    }
     Queue(aAudioMsg);
     return jiffies;
 }
@@ -911,13 +1044,26 @@ void CodecController::GetAudioBuf(TByte*& aDest, TUint& aSamples)
         iAudioDecodedBytes = 0;
     }
     aDest = iAudioDecoded->PtrW() + iAudioDecodedBytes;
-    const auto samplesMsg = (AudioData::kMaxBytes - iAudioDecodedBytes) / iBytesPerSample;
-    aSamples = std::min(iMaxOutputSamples, samplesMsg);
+    const auto samplesMsg = std::min(iMaxOutputSamples, AudioData::kMaxBytes / iBytesPerSample);
+    aSamples = samplesMsg - (iAudioDecodedBytes / iBytesPerSample);
+}
+
+void CodecController::AppendAudioBuf(TUint aSamples)
+{
+    ASSERT(iAudioDecoded != nullptr);
+    iAudioDecodedBytes += (aSamples * iBytesPerSample);
+    ASSERT(iAudioDecodedBytes <= AudioData::kMaxBytes);
 }
 
 void CodecController::OutputAudioBuf(TUint aSamples, TUint64& aTrackOffset)
 {
+    if (iAudioDecoded == nullptr) {
+        return; // no buffer, or buffer discarded (e.g. by a seek) since GetAudioBuf() was last called
+    }
     iAudioDecodedBytes += (aSamples * iBytesPerSample);
+    if (iAudioDecodedBytes == 0) {
+        return; // nothing written; keep iAudioDecoded for the next call to GetAudioBuf()
+    }
     iAudioDecoded->SetBytes(iAudioDecodedBytes);
     auto audioPcm = iMsgFactory.CreateMsgAudioPcm(iAudioDecoded, iChannels, iSampleRate, iBitDepth, aTrackOffset);
     iAudioDecoded = nullptr; // ownership of reference passed to audioPcm
@@ -1114,9 +1260,14 @@ Msg* CodecController::ProcessMsg(MsgDecodedStream* /*aMsg*/)
     return nullptr;
 }
 
-Msg* CodecController::ProcessMsg(MsgBitRate* /*aMsg*/)
+Msg* CodecController::ProcessMsg(MsgBitRate* aMsg)
 {
-    ASSERTS(); // expect this to be generated by a codec
+    // Generated by a codec or, when switching between encodings of a stream, by a protocol.
+    if (iRecognising) {
+        aMsg->RemoveRef();
+        return nullptr;
+    }
+    Queue(aMsg);
     return nullptr;
 }
 
@@ -6,6 +6,7 @@
 #include <OpenHome/Private/Standard.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Pipeline/Rewinder.h>
+#include <OpenHome/Media/Utils/ThreadScheduler.h>
 
 #include <atomic>
 #include <vector>
@@ -227,7 +228,39 @@ public:
      * This allows the pipeline to ramp audio down/up to avoid glitches caused by a stream discontinuity. A MsgDecodedStream must follow this.
      */
     virtual void OutputStreamInterrupted() = 0;
+    /**
+     * Borrow pipeline memory to write decoded (PCM) audio into.
+     *
+     * Avoids the copy made by OutputAudioPcm(const Brx&...).  Audio written must be big endian,
+     * packed PCM in the format given by the most recent call to OutputDecodedStream().
+     * The buffer remains owned by the controller.  It is discarded if the codec seeks or its
+     * stream ends without the audio being output.
+     *
+     * @param[out] aDest         Location to write audio to.  Follows any samples already
+     *                           added by AppendAudioBuf().
+     * @param[out] aSamples      Maximum number of samples that can be written to aDest.
+     *                           Always greater than 0.
+     */
     virtual void GetAudioBuf(TByte*& aDest, TUint& aSamples) = 0;
+    /**
+     * Record samples written to the buffer returned by GetAudioBuf() without outputting them.
+     *
+     * Allows a codec that decodes in small blocks to fill a msg over several calls.
+     * GetAudioBuf() must be called again before writing more audio.
+     *
+     * @param[in] aSamples       Number of samples written.  No more than reported by GetAudioBuf().
+     */
+    virtual void AppendAudioBuf(TUint aSamples) = 0;
+    /**
+     * Output audio written to the buffer returned by GetAudioBuf().
+     *
+     * Does nothing if no samples have been written.
+     *
+     * @param[in] aSamples       Number of samples written since the last call to GetAudioBuf().
+     *                           No more than reported by GetAudioBuf().  May be 0.
+     * @param[in,out] aTrackOffset  Offset (in jiffies) into the stream at the start of the buffer.
+     *                           Incremented by the number of jiffies output.
+     */
     virtual void OutputAudioBuf(TUint aSamples, TUint64& aTrackOffset) = 0;
     virtual TUint MaxBitDepth() const = 0;
 };
@@ -348,16 +381,44 @@ public:
      * @return     Codec identifier
      */
     const TChar* Id() const;
+public:
+    static const TUint kMaxSignatureBytes = 64;
 protected:
     CodecBase(const TChar* aId, RecognitionComplexity aRecognitionCost=kCostMedium);
     static SpeakerProfile DeriveProfile(TUint aChannels);
+    /**
+     * Declare bytes that appear at a fixed offset in every stream this codec decodes.
+     *
+     * Should be called from the codec's constructor.  A codec may declare several signatures.
+     * Codecs that declare any signature are only asked to Recognise() encoded streams whose
+     * first bytes match one of them; codecs declaring none are offered every stream.
+     *
+     * @param[in] aMagic     Bytes to match.  Must remain valid for the lifetime of the codec.
+     * @param[in] aOffset    Offset of aMagic from the start of the stream.
+     */
+    void AddSignature(const TChar* aMagic, TUint aOffset = 0);
 private:
     void Construct(ICodecController& aController);
+    TBool HasSignature() const;
+    TBool MatchesSignature(const Brx& aHeader) const;
+    TUint SignatureBytes() const;
 protected:
     ICodecController* iController;
+private:
+    class Signature
+    {
+    public:
+        Signature(const TChar* aMagic, TUint aOffset);
+        TBool Matches(const Brx& aHeader) const;
+        TUint Bytes() const;
+    private:
+        Brn iMagic;
+        TUint iOffset;
+    };
 private:
     const TChar* iId;
     RecognitionComplexity iRecognitionCost;
+    std::vector<Signature> iSignatures;
 };
 
 class CodecController : public ISeeker, private ICodecController, private IMsgProcessor, private IStreamHandler, private INonCopyable
@@ -369,8 +430,16 @@ public:
     void AddCodec(CodecBase* aCodec);
     void Start();
     void SetAnimator(IPipelineAnimator& aAnimator);
+    /*
+     * Optional.  aDecodeAhead is notified once the remaining audio in a stream is no more
+     * than aJiffies, allowing decoding to run ahead into the next stream sooner.
+     * Seeking withdraws the notification; it is repeated if the end of the stream is reached again.
+     */
+    void SetDecodeAhead(IDecodeAhead& aDecodeAhead, TUint aJiffies);
+    void SetThreadScheduler(IPipelineThreadScheduler& aThreadScheduler); // optional.  Must be called before Start()
 private:
     void CodecThread();
+    TBool SelectRecognitionCandidates(const EncodedStreamInfo& aStreamInfo, TBool& aStreamEnded);
     void Rewind();
     Msg* PullMsg();
     void Queue(Msg* aMsg);
@@ -379,7 +448,7 @@ private:
     void ReleaseAudioDecoded();
     TBool DoRead(Bwx& aBuf, TUint aBytes);
     void DoOutputDecodedStream(MsgDecodedStream* aMsg);
-    TUint64 DoOutputAudio(MsgAudio* aAudioMsg);
+    TUint64 DoOutputAudio(MsgAudioDecoded* aAudioMsg);
 private: // ISeeker
     void StartSeek(TUint aStreamId, TUint aSecondsAbsolute, ISeekObserver& aObserver, TUint& aHandle) override;
 private: // ICodecController
@@ -400,6 +469,7 @@ private: // ICodecController
     void OutputMetaText(const Brx& aMetaText) override;
     void OutputStreamInterrupted() override;
     void GetAudioBuf(TByte*& aDest, TUint& aSamples) override;
+    void AppendAudioBuf(TUint aSamples) override;
     void OutputAudioBuf(TUint aSamples, TUint64& aTrackOffset) override;
     TUint MaxBitDepth() const override;
 private: // IMsgProcessor
@@ -438,6 +508,9 @@ private:
     Mutex iLock;
     Semaphore iShutdownSem;
     std::vector<CodecBase*> iCodecs;
+    std::vector<CodecBase*> iRecognitionCandidates;
+    Bws<CodecBase::kMaxSignatureBytes> iRecognitionHeader;
+    TUint iSignatureBytes;
     ThreadFunctor* iDecoderThread;
     IPipelineAnimator* iAnimator;
     CodecBase* iActiveCodec;
@@ -476,6 +549,11 @@ private:
     TUint iBytesPerSample;
     TUint64 iStreamLength;
     TUint64 iStreamPos;
+    IDecodeAhead* iDecodeAhead;
+    IPipelineThreadScheduler* iThreadScheduler;
+    TUint iDecodeAheadJiffies;
+    TUint64 iDecodedTrackLength;
+    TBool iDecodeAheadNotified;
     TUint iTrackId;
     TUint iMaxOutputSamples;
     TUint iMaxOutputBytes;
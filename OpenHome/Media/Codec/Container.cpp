@@ -804,10 +804,14 @@ Msg* ContainerController::ProcessMsg(MsgDecodedStream* /*aMsg*/)
     return nullptr;
 }
 
-Msg* ContainerController::ProcessMsg(MsgBitRate* /*aMsg*/)
+Msg* ContainerController::ProcessMsg(MsgBitRate* aMsg)
 {
-    ASSERTS(); // expect this Msg to be generated by a downstream decoder element
-    return nullptr;
+    // May be output by a protocol that switches between encodings of a stream (e.g. HLS variants).
+    if (iRecognising) {
+        aMsg->RemoveRef();
+        return nullptr;
+    }
+    return aMsg;
 }
 
 Msg* ContainerController::ProcessMsg(MsgAudioPcm* /*aMsg*/)
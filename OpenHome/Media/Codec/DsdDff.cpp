@@ -92,6 +92,7 @@ CodecDsdDff::CodecDsdDff(IMimeTypeList& aMimeTypeList, TUint aSampleBlockWords,
     ASSERT((iSampleBlockWords * 4) % iTotalBytesPerChunk == 0);
     aMimeTypeList.Add("audio/dff");
     aMimeTypeList.Add("audio/x-dff");
+    AddSignature("FRM8");
 }
 
 
@@ -108,6 +108,7 @@ CodecDsdDsf::CodecDsdDsf(IMimeTypeList& aMimeTypeList, TUint aSampleBlockWords,
     ASSERT((iSampleBlockWords * 4) % iTotalBytesPerChunk == 0);
     aMimeTypeList.Add("audio/dsf");
     aMimeTypeList.Add("audio/x-dsf");
+    AddSignature("DSD ");
 }
 
 
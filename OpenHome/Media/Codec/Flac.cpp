@@ -8,6 +8,7 @@
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Media/Utils/PcmInterleave.h>
 
 #include <algorithm>
 #include <string.h>
@@ -46,7 +47,6 @@ public:
     void CallbackError(const FLAC__StreamDecoder* aDecoder,
                        FLAC__StreamDecoderErrorStatus aStatus);
 private:
-    TByte iBuf[DecodedAudio::kMaxBytes];
     FLAC__StreamDecoder* iDecoder;
     Brn iName;
     TUint64 iSampleStart;
@@ -143,6 +143,8 @@ CodecFlac::CodecFlac(IMimeTypeList& aMimeTypeList)
     // By default, only the STREAMINFO metadata block is returned, but let's just explicitly tell the decoder that's all we want.
     ASSERT(FLAC__stream_decoder_set_metadata_respond(iDecoder, FLAC__METADATA_TYPE_STREAMINFO));
     aMimeTypeList.Add("audio/x-flac");
+    AddSignature("fLaC");
+    AddSignature("fLaC", 37); // native FLAC header inside first Ogg page
 }
 
 CodecFlac::~CodecFlac()
@@ -361,6 +363,11 @@ FLAC__StreamDecoderWriteStatus CodecFlac::CallbackWrite(const FLAC__StreamDecode
         iStreamMsgDue = true; // OutputDecodedStream below
     }
 
+    if (bitDepth != 8 && bitDepth != 16 && bitDepth != 24) {
+        Log::Print("Unsupported bit depth in CodecFlac::CallbackWrite - %u\n", bitDepth);
+        THROW(CodecStreamFeatureUnsupported);
+    }
+
     if (iStreamMsgDue) {
         /* If we get a Audio Frame prior to a metadata frame (and therefore
            iStreamMsgDue is still true) we must have picked up a file mid-stream.
@@ -370,41 +377,17 @@ FLAC__StreamDecoderWriteStatus CodecFlac::CallbackWrite(const FLAC__StreamDecode
         iStreamMsgDue = false;
     }
     
-    const TUint bytesPerSample = (bitDepth/8) * channels;
-    const TUint maxSamples = sizeof(iBuf) / bytesPerSample;
+    // decode straight into pipeline memory
     TUint startI=0, endI;
     while (samplesToWrite > 0) {
+        TByte* p;
+        TUint maxSamples;
+        iController->GetAudioBuf(p, maxSamples);
         const TUint samples = (samplesToWrite > maxSamples? maxSamples : samplesToWrite);
-        TByte* p = iBuf;
         endI = startI + samples;
-        for (TUint i=startI; i<endI; i++) {
-            for (TUint j=0; j<channels; j++) {
-                TUint subsample = aBuffer[j][i];
-                // pipeline audio data is big endian so we might as well convert to that here
-                switch (bitDepth)
-                {
-                case 8:
-                    *p++ = (TByte)subsample;
-                    break;
-                case 16:
-                    *p++ = (TByte)(subsample >> 8);
-                    *p++ = (TByte)subsample;
-                    break;
-                case 24:
-                    *p++ = (TByte)(subsample >> 16);
-                    *p++ = (TByte)(subsample >> 8);
-                    *p++ = (TByte)subsample;
-                    break;
-                default:
-                    Log::Print("Unsupported bit depth in CodecFlac::CallbackWrite - %u\n", bitDepth);
-                    THROW(CodecStreamFeatureUnsupported);
-                }
-            }
-        }
-        const TUint bytes = samples * bytesPerSample;
-        Brn encodedAudio(iBuf, bytes);
-        iTrackOffset += iController->OutputAudioPcm(encodedAudio, channels, sampleRate,
-                                                    bitDepth, AudioDataEndian::Big, iTrackOffset);
+        // pipeline audio data is big endian so we might as well convert to that here
+        PcmInterleave::Pack(aBuffer, startI, samples, channels, bitDepth, p);
+        iController->OutputAudioBuf(samples, iTrackOffset);
         samplesToWrite -= samples;
         startI = endI;
     }
@@ -9,10 +9,12 @@
 #include <OpenHome/Exception.h>
 #include <OpenHome/Private/Standard.h>
 #include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Media/Utils/PcmInterleave.h>
 #include <mad.h>
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 
 EXCEPTION(Mp3SampleInvalid);
 
@@ -156,7 +158,6 @@ private:
     Bws<kInBufBytes> iInput;
     TUint64     iTrackLengthJiffies;
     TUint64     iTrackOffset;
-    Bws<DecodedAudio::kMaxBytes> iOutput;
     TBool       iStreamEnded;
     Bws<6*1024> iRecogBuf;
 };
@@ -653,25 +654,10 @@ TUint Mp3Header::ValidSync(const Brx& aSync, TUint& layer, TUint& mode)
 // MAD_F_FRACBITS is the number of F's and is architecture dependent (28 on all
 // platforms we currently care about).
 //
-// After checking for clipping (first two if's) we then convert to 24-bit with the bottom 8 bits unused.
-static TUint32 fixedToPcm(mad_fixed_t aFixed)
-{
-    const TUint32 kPlusOne  = 0x7FFFFF00l;
-    const TUint32 kMinusOne = 0x80000000l;
-    if (aFixed >= MAD_F_ONE) {
-        //LOG(kCodec, "fixedToPcm upper CLIPPED: %08x ret: %08x\n", aFixed, kPlusOne);
-        return kPlusOne;
-    }
-    if (aFixed <= -MAD_F_ONE) {
-        //LOG(kCodec, "fixedToPcm lower CLIPPED: %08x ret: %08x\n", aFixed, kMinusOne);
-        return kMinusOne; 
-    }
-    // if no clipping, then the 24 bit number is composed of the lsb W and 23 of
-    // the most significant F's.  Linn stores the 24 bits in the higher order
-    // bits with the bottom eight bits zeroed.
-    TInt32 value = (aFixed << 3) & 0xFFFFFF00l;
-    return (TUint32)value;
-}
+// Samples are clipped to +/-1.0 then shifted down so that the 24-bit output is composed
+// of the lsb W and the 23 most significant F's.
+static const TUint kMadShift = MAD_F_FRACBITS + 1 - kBitDepth;
+static_assert(sizeof(mad_fixed_t) == sizeof(TInt32), "PcmInterleave requires 32-bit mad_fixed_t");
 
 
 // CodecMp3
@@ -723,7 +709,6 @@ void CodecMp3::StreamInitialise()
     mad_frame_init(&iMadFrame);
     mad_synth_init(&iMadSynth);
 
-    iOutput.SetBytes(0);
     // Discard bytes preceeding frame start.
     iInput.SetBytes(0);
     if (iHeaderBytes > 0) {
@@ -749,7 +734,6 @@ void CodecMp3::StreamCompleted()
     //LOG(kCodec, "CodecMp3::Deinitialise\n");
     iHeader.Clear();
     iInput.SetBytes(0);
-    iOutput.SetBytes(0);
     iHeaderBytes = 0;
 
     mad_synth_finish(&iMadSynth);
@@ -775,7 +759,6 @@ TBool CodecMp3::TrySeek(TUint aStreamId, TUint64 aSample)
     TBool canSeek = iController->TrySeekTo(aStreamId, bytes);
     if (canSeek) {
         iInput.SetBytes(0);
-        iOutput.SetBytes(0);
         iSamplesWrittenTotal = aSample;
         iTrackOffset = (aSample * Jiffies::kPerSecond) / iHeader.SampleRate();
         iController->OutputDecodedStream(iHeader.BitRate(), kBitDepth, iHeader.SampleRate(), iHeader.Channels(), iHeader.Name(), iTrackLengthJiffies, aSample, false, DeriveProfile(iHeader.Channels()));
@@ -882,45 +865,35 @@ void CodecMp3::Process()
         }
     }
 
+    const TInt32* const planes[] = {
+        reinterpret_cast<const TInt32*>(iMadSynth.pcm.samples[0]),
+        reinterpret_cast<const TInt32*>(iMadSynth.pcm.samples[1])
+    };
     TUint pcmIndex = 0;
-    do {
-        TUint bytes = samplesToWrite * (kBitDepth/8) * channels;
-        TUint samples = samplesToWrite;
-        TUint outputSpace = iOutput.MaxBytes() - iOutput.Bytes();
-        if (bytes > outputSpace) {
-            samples = outputSpace / (channels * (kBitDepth/8));
-            bytes = samples * (kBitDepth/8) * channels;
-        }
-        TByte* dst = const_cast<TByte*>(iOutput.Ptr()) + iOutput.Bytes();
-        for (TUint i=pcmIndex; i<pcmIndex+samples; i++) {
-            for (TUint j=0; j<channels; j++) {
-                TUint subsample = fixedToPcm(iMadSynth.pcm.samples[j][i]);
-                // output is always 24-bit
-                *dst++ = (TByte)(subsample >> 24);
-                *dst++ = (TByte)(subsample >> 16);
-                *dst++ = (TByte)(subsample >> 8);
-            }
-        }
+    while (samplesToWrite > 0) {
+        // synthesise straight into pipeline memory
+        TByte* dst;
+        TUint outputSpace;
+        iController->GetAudioBuf(dst, outputSpace);
+        const TUint samples = std::min(samplesToWrite, outputSpace);
+        PcmInterleave::PackScaled(planes, pcmIndex, samples, channels, kMadShift, kBitDepth, dst);
         pcmIndex += samples;
-        iOutput.SetBytes(iOutput.Bytes() + bytes);
         // only output audio when we have data for a full-sized msg.
         // any data not output now will be picked up the next time round
-        if (iOutput.MaxBytes() - iOutput.Bytes() < (kBitDepth/8) * channels) {
-            iTrackOffset += iController->OutputAudioPcm(iOutput, channels, iHeader.SampleRate(),
-                                                        kBitDepth, AudioDataEndian::Big, iTrackOffset);
-            iOutput.SetBytes(0);
+        if (samples == outputSpace) {
+            iController->OutputAudioBuf(samples, iTrackOffset);
+        }
+        else {
+            iController->AppendAudioBuf(samples);
         }
         iSamplesWrittenTotal += samples;
         samplesToWrite -= samples;
-    } while (samplesToWrite > 0);
+    }
 
     // now propogate any end of stream exception
     // first check we have processed remaining frames of this stream
     if ((iMadStream.md_len == 0) && (iStreamEnded || newStreamStarted)) {
-        if (iOutput.Bytes() > 0) { // only output if there is audio remaining
-            iController->OutputAudioPcm(iOutput, channels, iHeader.SampleRate(),
-                                        kBitDepth, AudioDataEndian::Big, iTrackOffset);
-        }
+        iController->OutputAudioBuf(0, iTrackOffset); // only outputs if there is audio remaining
         if (newStreamStarted) {
             THROW(CodecStreamStart);
         }
@@ -445,10 +445,10 @@ Msg* StreamTerminatorDetector::ProcessMsg(MsgDecodedStream* /*aMsg*/)
     return nullptr;
 }
 
-Msg* StreamTerminatorDetector::ProcessMsg(MsgBitRate* /*aMsg*/)
+Msg* StreamTerminatorDetector::ProcessMsg(MsgBitRate* aMsg)
 {
-    ASSERTS();
-    return nullptr;
+    ASSERT(iStreamTerminated == false);
+    return aMsg;
 }
 
 Msg* StreamTerminatorDetector::ProcessMsg(MsgAudioPcm* /*aMsg*/)
@@ -9,6 +9,7 @@
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Media/Utils/ByteSwap.h>
 
 extern "C" {
 #include <ivorbisfile.h>
@@ -16,6 +17,8 @@ extern "C" {
 }
 
 #include <limits>
+#include <string.h>
+#include <algorithm>
 
 namespace OpenHome {
 namespace Media {
@@ -53,6 +56,7 @@ private:
     TBool FindSync();
     TUint64 GetTotalSamples();
     void BigEndian(TInt16* aDst, TInt16* aSrc, TUint aSamples);
+    void OutputSamples(TInt16* aPcm, TUint aSamples);
     void FlushOutput();
     TBool StreamInfoChanged(TUint aChannels, TUint aSampleRate) const;
     void OutputMetaData();
@@ -63,7 +67,6 @@ private:
     OggVorbis_File iVf;
 
     Bws<DecodedAudio::kMaxBytes> iInBuf;
-    Bws<DecodedAudio::kMaxBytes> iOutBuf;
     Bws<2*kSearchChunkSize> iSeekBuf;   // can store 2 read chunks, to check for sync word across read boundaries
 
     TUint iSampleRate;
@@ -181,6 +184,7 @@ CodecVorbis::CodecVorbis(IMimeTypeList& aMimeTypeList)
     aMimeTypeList.Add("audio/ogg");
     aMimeTypeList.Add("audio/x-ogg");
     aMimeTypeList.Add("application/ogg");
+    AddSignature("OggS");
 }
 
 CodecVorbis::~CodecVorbis()
@@ -218,7 +222,6 @@ void CodecVorbis::StreamInitialise()
 
     iTotalSamplesOutput = 0;
     iInBuf.SetBytes(0);
-    iOutBuf.SetBytes(0);
 
     iBytesPerSample = iChannels*kBitDepth/8;
     iBytesPerSec = iBitrateAverage/8; // bitrate of raw data rather than the output bitrate
@@ -293,7 +296,6 @@ TBool CodecVorbis::TrySeek(TUint aStreamId, TUint64 aSample)
         iTotalSamplesOutput = aSample;
         iTrackOffset = (aSample * Jiffies::kPerSecond) / iSampleRate;
         iInBuf.SetBytes(0);
-        iOutBuf.SetBytes(0);
         iController->OutputDecodedStream(0, kBitDepth, iSampleRate, iChannels, kCodecVorbis, iTrackLengthJiffies, aSample, false, DeriveProfile(iChannels));
     }
     return canSeek;
@@ -393,22 +395,47 @@ TUint64 CodecVorbis::GetTotalSamples()
 // copy audio data to output buffer, converting to big endian if required.
 void CodecVorbis::BigEndian(TInt16* aDst, TInt16* aSrc, TUint aSamples)
 {
-    aSamples *= iChannels;
-    while(aSamples--) {
-        *aDst++ = Arch::BigEndian2(*aSrc++);
+    const TUint bytes = aSamples * iChannels * sizeof(TInt16);
+#ifdef DEFINE_BIG_ENDIAN
+    (void)memcpy(aDst, aSrc, bytes);
+#else
+    ByteSwap::ToBigEndian16(reinterpret_cast<const TByte*>(aSrc), reinterpret_cast<TByte*>(aDst), bytes);
+#endif
+}
+
+// convert to big endian straight into pipeline memory, outputting each msg once it is full
+void CodecVorbis::OutputSamples(TInt16* aPcm, TUint aSamples)
+{
+    while (aSamples > 0) {
+        TByte* dest;
+        TUint samplesDest;
+        iController->GetAudioBuf(dest, samplesDest);
+        const TUint samples = std::min(aSamples, samplesDest);
+        BigEndian(reinterpret_cast<TInt16*>(dest), aPcm, samples);
+        if (samples == samplesDest) {
+            iController->OutputAudioBuf(samples, iTrackOffset);
+            LOG(kCodec, "CodecVorbis::OutputSamples output - total samples = %llu\n", iTotalSamplesOutput);
+        }
+        else {
+            iController->AppendAudioBuf(samples);
+        }
+        aPcm += samples * iChannels;
+        aSamples -= samples;
     }
 }
 
 void CodecVorbis::Process()
 {
     TInt bitstream = 0;
-    TUint iPrevBytes = iOutBuf.Bytes();
 
     if(!iStreamEnded || !iNewStreamStarted) {
         LOG(kCodec, "CodecVorbis::Process bitstream %d\n", bitstream);
         try {
             char *pcm = (char *)iInBuf.Ptr();
-            TInt request = (iOutBuf.MaxBytes() - iOutBuf.Bytes());
+            TByte* dest;
+            TUint samplesDest;
+            iController->GetAudioBuf(dest, samplesDest);
+            TInt request = samplesDest * iBytesPerSample;
             ASSERT((TInt)iInBuf.MaxBytes() >= request);
 
             TInt bytes = 0;
@@ -434,12 +461,8 @@ void CodecVorbis::Process()
 
                 // Encountered a new logical bitstream. Better push any
                 // buffered PCM from previous stream.
-                if (iOutBuf.Bytes() > 0) {
-                    iTrackOffset += iController->OutputAudioPcm(iOutBuf, iChannels, iSampleRate,
-                        kBitDepth, AudioDataEndian::Big, iTrackOffset);
-                    iOutBuf.SetBytes(0);
-                    LOG(kCodec, "CodecVorbis::Process output (new bitstream detected) - total samples = %llu\n", iTotalSamplesOutput);
-                }
+                iController->OutputAudioBuf(0, iTrackOffset);
+                LOG(kCodec, "CodecVorbis::Process output (new bitstream detected) - total samples = %llu\n", iTotalSamplesOutput);
 
                 // From ov_read() docs:
                 // "However, when reading audio back, the application must be aware that multiple bitstream sections do not necessarily use the same number of channels or sampling rate."
@@ -471,19 +494,9 @@ void CodecVorbis::Process()
             }
 
             TUint samples = bytes/iBytesPerSample;
-            TByte* dstByte = const_cast<TByte*>(iOutBuf.Ptr()) + iOutBuf.Bytes();
-            TInt16* dst = reinterpret_cast<TInt16*>(dstByte);
-            BigEndian(dst, (TInt16 *)pcm, samples);
-            iOutBuf.SetBytes(iOutBuf.Bytes()+bytes);
+            OutputSamples((TInt16 *)pcm, samples);
             iTotalSamplesOutput += samples;
-
-            LOG(kCodec, "CodecVorbis::Process read - bytes %d, iPrevBytes %d\n", bytes, iPrevBytes);
-            if (iOutBuf.MaxBytes() - iOutBuf.Bytes() < (TUint)((kBitDepth/8) * iChannels)) {
-                iTrackOffset += iController->OutputAudioPcm(iOutBuf, iChannels, iSampleRate,
-                    kBitDepth, AudioDataEndian::Big, iTrackOffset);
-                iOutBuf.SetBytes(0);
-                LOG(kCodec, "CodecVorbis::Process output - total samples = %llu\n", iTotalSamplesOutput);
-            }
+            LOG(kCodec, "CodecVorbis::Process read - bytes %d\n", bytes);
         }
         catch(CodecStreamEnded&) {
             iStreamEnded = true;
@@ -502,11 +515,7 @@ void CodecVorbis::FlushOutput()
     LOG(kCodec, "CodecVorbis::FlushOutput\n");
 
     if (iStreamEnded || iNewStreamStarted) {
-        if (iOutBuf.Bytes() > 0) {
-            iTrackOffset += iController->OutputAudioPcm(iOutBuf, iChannels, iSampleRate,
-                kBitDepth, AudioDataEndian::Big, iTrackOffset);
-            iOutBuf.SetBytes(0);
-        }
+        iController->OutputAudioBuf(0, iTrackOffset);
         if (iNewStreamStarted) {
             THROW(CodecStreamStart);
         }
@@ -78,6 +78,7 @@ CodecWav::CodecWav(IMimeTypeList& aMimeTypeList)
     aMimeTypeList.Add("audio/wav");
     aMimeTypeList.Add("audio/wave");
     aMimeTypeList.Add("audio/x-wav");
+    AddSignature("WAVE", 8); // RIFF form type
 }
 
 CodecWav::~CodecWav()
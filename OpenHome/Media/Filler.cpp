@@ -129,6 +129,7 @@ Filler::Filler(IPipelineElementDownstream& aPipeline, IPipelineIdTracker& aIdTra
     , iStreamPlayObserver(aStreamPlayObserver)
     , iDefaultDelay(aDefaultDelay)
     , iPrefetchTrackId(kPrefetchTrackIdInvalid)
+    , iThreadScheduler(nullptr)
 {
     iNullTrack = aTrackFactory.CreateNullTrack();
 }
@@ -147,6 +148,11 @@ void Filler::Add(UriProvider& aUriProvider)
     iUriProviders.push_back(&aUriProvider);
 }
 
+void Filler::SetThreadScheduler(IPipelineThreadScheduler& aThreadScheduler)
+{
+    iThreadScheduler = &aThreadScheduler;
+}
+
 void Filler::Start(IUriStreamer& aUriStreamer)
 {
     iUriStreamer = &aUriStreamer;
@@ -330,6 +336,9 @@ void Filler::Run()
 {
     try {
         Wait();
+        if (iThreadScheduler != nullptr) {
+            iThreadScheduler->ApplyToCurrentThread(PipelineThread::Filler);
+        }
         for (;;) {
             for (;;) {
                 iLock.Wait();
@@ -539,7 +548,10 @@ Msg* Filler::ProcessMsg(MsgDecodedStream* aMsg)
 
 Msg* Filler::ProcessMsg(MsgBitRate* aMsg)
 {
-    ASSERTS();
+    if (iNoAudioBeforeNextTrack) {
+        aMsg->RemoveRef();
+        return nullptr;
+    }
     return aMsg;
 }
 
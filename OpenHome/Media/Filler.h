@@ -7,6 +7,7 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Protocol/Protocol.h>
 #include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Media/Utils/ThreadScheduler.h>
 
 #include <limits.h>
 #include <vector>
@@ -78,6 +79,7 @@ public:
            TUint aDefaultDelay);
     ~Filler();
     void Add(UriProvider& aUriProvider);
+    void SetThreadScheduler(IPipelineThreadScheduler& aThreadScheduler); // optional.  Must be called before Start()
     void Start(IUriStreamer& aUriStreamer);
     void Quit();
     void Play(const Brx& aMode, TUint aTrackId);
@@ -161,6 +163,7 @@ private:
     IStreamPlayObserver& iStreamPlayObserver;
     const TUint iDefaultDelay;
     TUint iPrefetchTrackId;
+    IPipelineThreadScheduler* iThreadScheduler;
 };
 
 } // namespace Media
@@ -2,6 +2,7 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/FlywheelRamper.h>
+#include <OpenHome/Media/Utils/LpcKernels.h>
 #include <OpenHome/Private/Debug.h>
 
 using namespace OpenHome;
@@ -15,6 +16,7 @@ static const TUint kDegree = 3;
 
 static const TUint kFeedbackDataDescaleBitCount = 0;
 static const TUint kFeedbackDataFormat = 1;
+static const TInt kFeedbackOutputShift = kFeedbackDataFormat+kFeedbackDataDescaleBitCount-1; // matches FeedbackModel's output format of 1
 
 static const TUint kMaxChannelCount = 10;
 static const TUint kMaxSampleRate = 384000;
@@ -23,15 +25,22 @@ const TUint FlywheelRamperManager::kMaxOutputJiffiesBlockSize = Jiffies::kPerMs;
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-FlywheelRamperManager::FlywheelRamperManager(IPcmProcessor& aOutput, TUint aInputJiffies, TUint aOutputJiffies)
+FlywheelRamperManager::FlywheelRamperManager(IPcmProcessor& aOutput, TUint aInputJiffies, TUint aOutputJiffies, Render aRender)
     :iOutput(aOutput)
     ,iOutBuf(Jiffies::ToSamples(kMaxOutputJiffiesBlockSize, kMaxSampleRate)*kMaxChannelCount*4)
     ,iOutputJiffies(aOutputJiffies)
+    ,iRender(aRender)
+    ,iTrainingSampleRate(0)
+    ,iTrainingChannels(0)
+    ,iTrainingSamples(0)
 {
+    static_assert(kMaxChannelCount <= LpcKernels::kFeedbackStride, "LpcKernels::Feedback can't handle kMaxChannelCount channels");
     for(TUint i=0; i<kMaxChannelCount; i++)
     {
         iRampers.push_back(new FlywheelRamper(kDegree, aInputJiffies));
     }
+    iFeedbackCoeffs = (TInt32*) calloc (kDegree*LpcKernels::kFeedbackStride, sizeof(TInt32));
+    iFeedbackStates = (TInt32*) calloc (kDegree*LpcKernels::kFeedbackStride, sizeof(TInt32));
 }
 
 FlywheelRamperManager::~FlywheelRamperManager()
@@ -40,12 +49,87 @@ FlywheelRamperManager::~FlywheelRamperManager()
     {
         delete iRampers[i];
     }
+    free(iFeedbackCoeffs);
+    free(iFeedbackStates);
 }
 
 void FlywheelRamperManager::Ramp(const Brx& aSamples, TUint aSampleRate, TUint aChannelCount)
 {
     InitChannels(aSamples, aSampleRate, aChannelCount); // prepare the ramp generation
+    RenderRamp(aSampleRate, aChannelCount);
+    Reset(); // clear memory ready for next ramp request
+}
+
+void FlywheelRamperManager::TrainingReset(TUint aSampleRate, TUint aChannelCount)
+{
+    ASSERT(aSampleRate<=kMaxSampleRate);
+    ASSERT(aChannelCount<=kMaxChannelCount);
+    iTrainingSampleRate = aSampleRate;
+    iTrainingChannels = aChannelCount;
+    iTrainingSamples = 0;
+    for(TUint i=0; i<aChannelCount; i++)
+    {
+        iRampers[i]->HistoryReset(aSampleRate);
+    }
+}
+
+void FlywheelRamperManager::TrainingAppend(const Brx& aSamples, TUint aSubsampleBytes)
+{
+    ASSERT(iTrainingChannels > 0);
+    const TUint frameBytes = aSubsampleBytes*iTrainingChannels;
+    const TUint frames = aSamples.Bytes()/frameBytes;
+    const TByte* ptr = aSamples.Ptr();
+
+    for(TUint i=0; i<frames; i++)
+    {
+        for(TUint j=0; j<iTrainingChannels; j++)
+        {
+            // msb aligned, zero padded to 32 bits (as FlywheelInput)
+            TUint32 sample = 0;
+            for(TUint k=0; k<4; k++)
+            {
+                sample <<= 8;
+                if (k<aSubsampleBytes)
+                {
+                    sample |= *ptr++;
+                }
+            }
+            iRampers[j]->HistoryAppend((TInt32)sample);
+        }
+    }
+    iTrainingSamples += frames;
+}
+
+void FlywheelRamperManager::TrainingUpdate()
+{
+    for(TUint i=0; i<iTrainingChannels; i++)
+    {
+        FlywheelRamper& ramper = *iRampers[i];
+        if (!ramper.iTrained || ramper.iTrainedAt != iTrainingSamples)
+        {
+            ramper.iTrainedAt = iTrainingSamples;
+            ramper.TrainFromHistory();
+        }
+    }
+}
+
+void FlywheelRamperManager::RampFromTraining()
+{
+    ASSERT(iTrainingChannels > 0);
+    for(TUint i=0; i<iTrainingChannels; i++)
+    {
+        iRampers[i]->InitialiseFromHistory();
+    }
+    if (iRender == Render::ChannelParallel)
+    {
+        GatherFeedback(iTrainingChannels);
+    }
+    RenderRamp(iTrainingSampleRate, iTrainingChannels);
+    TrainingReset(iTrainingSampleRate, iTrainingChannels); // as Ramp(), the next ramp starts from silence
+}
 
+void FlywheelRamperManager::RenderRamp(TUint aSampleRate, TUint aChannelCount)
+{
     TUint decFactor = FlywheelRamper::DecimationFactor(aSampleRate);
     TUint maxOutputSamplesBlockSize = Jiffies::ToSamples(kMaxOutputJiffiesBlockSize, aSampleRate);
     TUint remainingSamples = Jiffies::ToSamples(iOutputJiffies, aSampleRate);
@@ -59,10 +143,15 @@ void FlywheelRamperManager::Ramp(const Brx& aSamples, TUint aSampleRate, TUint a
         }
 
         remainingSamples -= outputSamples;
-        RenderChannels(outputSamples, decFactor, aChannelCount); // output ramp audio data
+        if (iRender == Render::ChannelParallel)
+        {
+            RenderChannelsParallel(outputSamples, decFactor, aChannelCount); // output ramp audio data
+        }
+        else
+        {
+            RenderChannels(outputSamples, decFactor, aChannelCount); // output ramp audio data
+        }
     }
-
-    Reset(); // clear memory ready for next ramp request
 }
 
 void FlywheelRamperManager::InitChannels(const Brx& aSamples, TUint aSampleRate, TUint aChannelCount)
@@ -77,6 +166,24 @@ void FlywheelRamperManager::InitChannels(const Brx& aSamples, TUint aSampleRate,
         iRampers[i]->Initialise(chanSamples, aSampleRate);
         ptr += bytesPerChan;
     }
+
+    if (iRender == Render::ChannelParallel)
+    {
+        GatherFeedback(aChannelCount);
+    }
+}
+
+void FlywheelRamperManager::GatherFeedback(TUint aChannelCount)
+{
+    // gather each channel's (already initialised) feedback filter into [tap][channel] order
+    for(TUint i=0; i<aChannelCount; i++)
+    {
+        for(TUint j=0; j<kDegree; j++)
+        {
+            iFeedbackCoeffs[j*LpcKernels::kFeedbackStride + i] = iRampers[i]->iFeedbackCoeffs[j];
+            iFeedbackStates[j*LpcKernels::kFeedbackStride + i] = iRampers[i]->iFeedbackSamples[j];
+        }
+    }
 }
 
 void FlywheelRamperManager::RenderChannels(TUint aSampleCount, TUint aDecFactor, TUint aChannelCount)
@@ -102,15 +209,7 @@ void FlywheelRamperManager::RenderChannels(TUint aSampleCount, TUint aDecFactor,
                 sample = prevSample[k];
             }
 
-            // write out in big endian format
-            *(ptr+3) = (TByte)sample;
-            sample >>= 8;
-            *(ptr+2) = (TByte)sample;
-            sample >>= 8;
-            *(ptr+1) = (TByte)sample;
-            sample >>= 8;
-            *(ptr) = (TByte)sample;
-
+            WriteBe32(ptr, sample);
             ptr += 4;
             outputBytes += 4;
         }
@@ -121,11 +220,58 @@ void FlywheelRamperManager::RenderChannels(TUint aSampleCount, TUint aDecFactor,
         }
     }
 
-    iOutBuf.SetBytes(outputBytes);
+    OutputBlock(outputBytes, aChannelCount);
+}
+
+void FlywheelRamperManager::RenderChannelsParallel(TUint aSampleCount, TUint aDecFactor, TUint aChannelCount)
+{
+    TByte* ptr = (TByte*)iOutBuf.Ptr();
+    TUint outputBytes = 0;
+    TUint sampleHoldCount = 0;
+
+    TInt32 samples[LpcKernels::kFeedbackStride];
+
+    for(TUint j=0; j<aSampleCount; j++)
+    {
+        if (sampleHoldCount==0)
+        {
+            LpcKernels::Feedback(iFeedbackCoeffs, iFeedbackStates, kDegree, aChannelCount, kBurgOutputFormat, kFeedbackOutputShift, samples);
+        }
+
+        for(TUint k=0; k<aChannelCount; k++)
+        {
+            WriteBe32(ptr, samples[k]);
+            ptr += 4;
+        }
+        outputBytes += 4*aChannelCount;
+
+        if (++sampleHoldCount == aDecFactor)
+        {
+            sampleHoldCount = 0;
+        }
+    }
+
+    OutputBlock(outputBytes, aChannelCount);
+}
+
+void FlywheelRamperManager::OutputBlock(TUint aBytes, TUint aChannelCount)
+{
+    iOutBuf.SetBytes(aBytes);
     iOutput.BeginBlock();
     iOutput.ProcessFragment(iOutBuf, aChannelCount, 4);
     iOutput.EndBlock();
+}
 
+void FlywheelRamperManager::WriteBe32(TByte* aPtr, TInt32 aSample)
+{
+    // write out in big endian format
+    *(aPtr+3) = (TByte)aSample;
+    aSample >>= 8;
+    *(aPtr+2) = (TByte)aSample;
+    aSample >>= 8;
+    *(aPtr+1) = (TByte)aSample;
+    aSample >>= 8;
+    *(aPtr) = (TByte)aSample;
 }
 
 void FlywheelRamperManager::Reset()
@@ -152,6 +298,13 @@ FlywheelRamper::FlywheelRamper(TUint aDegree, TUint aInputJiffies)
 
     iFeedbackSamples = (TInt32*) calloc (iDegree, sizeof(TInt32));
     iFeedbackCoeffs = (TInt32*) calloc (iDegree, sizeof(TInt32));
+
+    iHistory = (TInt32*) calloc (iMaxInputSampleCount, sizeof(TInt32));
+    iHistoryCount = 0;
+    iHistoryIndex = 0;
+    iHistoryDecFactor = 1;
+    iTrained = false;
+    iTrainedAt = 0;
 }
 
 FlywheelRamper::~FlywheelRamper()
@@ -163,6 +316,7 @@ FlywheelRamper::~FlywheelRamper()
     free(iBurgPef);
     free(iFeedbackSamples);
     free(iFeedbackCoeffs);
+    free(iHistory);
     delete iFeedback;
 }
 
@@ -223,6 +377,73 @@ void FlywheelRamper::Initialise(const Brx& aSamples, TUint aSampleRate)
     iFeedback->Initialise(iFeedbackCoeffs, iFeedbackSamples);
 }
 
+void FlywheelRamper::HistoryReset(TUint aSampleRate)
+{
+    ASSERT(aSampleRate<=kMaxSampleRate);
+    iHistoryCount = SampleCount(aSampleRate, iInputJiffies);
+    iHistoryDecFactor = DecimationFactor(aSampleRate);
+    ASSERT(iHistoryCount/iHistoryDecFactor > iDegree);
+    memset(iHistory, 0, iHistoryCount*sizeof(TInt32)); // silence, as StarvationRamper pads short input
+    iHistoryIndex = 0;
+    iTrained = false;
+    iTrainedAt = 0;
+}
+
+void FlywheelRamper::HistoryAppend(TInt32 aSample)
+{
+    iHistory[iHistoryIndex] = aSample;
+    if (++iHistoryIndex == iHistoryCount)
+    {
+        iHistoryIndex = 0;
+    }
+}
+
+void FlywheelRamper::TrainFromHistory()
+{
+    // decimate from the oldest sample, exactly as Initialise() does for a block of input
+    const TUint sampleCount = iHistoryCount/iHistoryDecFactor;
+    TUint index = iHistoryIndex;
+    for(TUint i=0; i<sampleCount; i++)
+    {
+        TInt16 sample16 = (TInt16)(((TUint32)iHistory[index])>>16);
+        iInputSamples[i] = sample16>>kBurgDataDescaleBitCount;
+        index += iHistoryDecFactor;
+        if (index >= iHistoryCount)
+        {
+            index -= iHistoryCount;
+        }
+    }
+
+    Reset(); // Burg's method requires per/pef to start cleared
+    BurgsMethod(iInputSamples, sampleCount, iDegree, iBurgCoeffs, iBurgH, iBurgPer, iBurgPef);
+
+    CorrectBurgCoeffs(); // remove overflow
+    PrepareFeedbackCoeffs(); // upcast and invert
+    iTrained = true;
+}
+
+void FlywheelRamper::InitialiseFromHistory()
+{
+    if (!iTrained)
+    {
+        TrainFromHistory();
+    }
+
+    // initial states are the most recent decimated samples, newest first
+    const TUint sampleCount = iHistoryCount/iHistoryDecFactor;
+    for(TUint i=0; i<iDegree; i++)
+    {
+        TUint index = iHistoryIndex + (sampleCount-i-1)*iHistoryDecFactor;
+        if (index >= iHistoryCount)
+        {
+            index -= iHistoryCount;
+        }
+        iFeedbackSamples[i] = iHistory[index];
+    }
+
+    iFeedback->Initialise(iFeedbackCoeffs, iFeedbackSamples);
+}
+
 void FlywheelRamper::PrepareFeedbackCoeffs()
 {
     for(TUint i=0; i<iDegree; i++)
@@ -250,19 +471,9 @@ void FlywheelRamper::BurgsMethod(TInt16* aSamples, TUint aSamplesCount, TUint aD
 
     for (TUint n = 0; n < aDegree; n++)
     {
-        TInt32 sn = 0;
-        TInt32 sd = 0;
-
-        for (TUint j=0; j < limit1; j++)
-        {
-            TInt16 t1 =  (aSamples[j+n+1] + aPef[j]);
-            TInt16 t2 =  (aSamples[j] + aPer[j]);
-            TInt32 t1t1 = (TInt32)t1*(TInt32)t1;
-            TInt32 t2t2 = (TInt32)t2*(TInt32)t2;
-            TInt32 t1t2 = (TInt32)t1*(TInt32)t2;
-            sn -= (2*t1t2);  // 2.30
-            sd += t1t1 + t2t2; // 2.30
-        }
+        TInt32 sn = 0; // 2.30
+        TInt32 sd = 0; // 2.30
+        LpcKernels::BurgSums(aSamples+n+1, aPef, aSamples, aPer, limit1, sn, sd);
 
         limit1--;
 
@@ -298,18 +509,7 @@ void FlywheelRamper::BurgsMethod(TInt16* aSamples, TUint aSamplesCount, TUint aD
             break;
         }
 
-        for (TUint j = 0; j < limit2; j++)
-        {
-            TUint i = j+1;
-            TInt32 per = aPef[j] + aSamples[i+n];
-            per *= t3;
-            aPer[j] += (TInt16)(per>>kBurgScaleShift);
-
-            TInt32 pef = aPer[i] + aSamples[i];
-            pef *= t3;
-            aPef[j] = (TInt16)(pef>>kBurgScaleShift);
-            aPef[j] += aPef[i];
-        }
+        LpcKernels::BurgUpdate(aSamples+n+1, aSamples+1, aPer, aPef, limit2, t3, kBurgScaleShift);
     }
 }
 
@@ -236,16 +236,7 @@ Msg* AirplayReporter::Pull()
     Msg* msg = nullptr;
     while (msg == nullptr) {
         if (!iInterceptMode) {
-            msg = iUpstreamElement.Pull();
-            msg = msg->Process(*this);
-
-            if (iInterceptMode) {
-                // Mode changed. Need to set up some variables that are
-                // accessed from different threads, so need to acquire iLock.
-                AutoMutex _(iLock);
-                iMsgDecodedStreamPending = true;
-                iSamples = 0;
-            }
+            msg = ProcessBypassed(iUpstreamElement.Pull());
         }
         else {
             {
@@ -332,6 +323,48 @@ Msg* AirplayReporter::Pull()
     return msg;
 }
 
+void AirplayReporter::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    if (!BypassPull()) {
+        aQueue.Enqueue(Pull());
+        return;
+    }
+    // BypassPull() only changes on a MsgMode, which is always pulled as a batch of one
+    MsgQueueLite batch;
+    while (aQueue.IsEmpty()) {
+        iUpstreamElement.PullBatch(batch, aMaxJiffies);
+        while (!batch.IsEmpty()) {
+            Msg* msg = ProcessBypassed(batch.Dequeue());
+            if (msg != nullptr) {
+                aQueue.Enqueue(msg);
+            }
+        }
+    }
+}
+
+TBool AirplayReporter::BypassPull() const
+{
+    return !iInterceptMode;
+}
+
+TBool AirplayReporter::BypassAudio() const
+{
+    return !iInterceptMode;
+}
+
+Msg* AirplayReporter::ProcessBypassed(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
+    if (iInterceptMode) {
+        // Mode changed. Need to set up some variables that are
+        // accessed from different threads, so need to acquire iLock.
+        AutoMutex _(iLock);
+        iMsgDecodedStreamPending = true;
+        iSamples = 0;
+    }
+    return msg;
+}
+
 TUint64 AirplayReporter::Samples() const
 {
     AutoMutex _(iLock);
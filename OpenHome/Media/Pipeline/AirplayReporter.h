@@ -91,7 +91,7 @@ private:
 /*
  * Element to report number of samples seen since last MsgMode.
  */
-class AirplayReporter : public PipelineElement, public IPipelineElementUpstream, public IAirplayReporter, public IAirplayTrackObserver, private INonCopyable
+class AirplayReporter : public PipelineElement, public IPipelineElementUpstream, public IPipelineElementBypassable, public IAirplayReporter, public IAirplayTrackObserver, private INonCopyable
 {
 private:
     static const TUint kSupportedMsgTypes;
@@ -103,6 +103,11 @@ public:
     ~AirplayReporter();
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+public: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 public: // from IAirplayReporter
     TUint64 Samples() const override;
     void ReportSamples(TUint aAdditionalSamples) override;
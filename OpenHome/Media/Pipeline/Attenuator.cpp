@@ -39,7 +39,36 @@ void Attenuator::SetAttenuation(TUint aAttenuation)
 
 Msg* Attenuator::Pull()
 {
-    Msg* msg = iUpstreamElement.Pull()->Process(*this);
+    return ProcessBypassed(iUpstreamElement.Pull());
+}
+
+void Attenuator::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    MsgQueueLite batch;
+    while (aQueue.IsEmpty()) {
+        iUpstreamElement.PullBatch(batch, aMaxJiffies);
+        while (!batch.IsEmpty()) {
+            Msg* msg = ProcessBypassed(batch.Dequeue());
+            if (msg != nullptr) {
+                aQueue.Enqueue(msg);
+            }
+        }
+    }
+}
+
+TBool Attenuator::BypassPull() const
+{
+    return true;
+}
+
+TBool Attenuator::BypassAudio() const
+{
+    return !iActive;
+}
+
+Msg* Attenuator::ProcessBypassed(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
 
     ASSERT(msg != nullptr);
     return msg;
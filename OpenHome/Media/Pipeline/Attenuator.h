@@ -22,7 +22,7 @@ public:
 Element which sets attenuation value in PCM audio message:
 */
 
-class Attenuator : public PipelineElement, public IPipelineElementUpstream, public IAttenuator, private INonCopyable
+class Attenuator : public PipelineElement, public IPipelineElementUpstream, public IPipelineElementBypassable, public IAttenuator, private INonCopyable
 {
     static const TUint kSupportedMsgTypes;
 public:
@@ -31,6 +31,11 @@ public: // from IAttenuator
     void SetAttenuation(TUint aAttenuation) override;
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+public: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
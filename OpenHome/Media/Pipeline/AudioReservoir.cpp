@@ -10,9 +10,12 @@ using namespace OpenHome::Media;
 
 // AudioReservoir
 
-AudioReservoir::AudioReservoir()
-    : iLock("ARES")
+AudioReservoir::AudioReservoir(ReservoirQueue aQueue)
+    : MsgReservoir(aQueue)
+    , iQueueType(aQueue)
+    , iLock("ARES")
     , iSem("ARES", 0)
+    , iBlocked(false)
 {
 }
 
@@ -30,6 +33,15 @@ Msg* AudioReservoir::Pull()
     return msg;
 }
 
+void AudioReservoir::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    TUint count;
+    do {
+        count = DoDequeueBatch(aQueue, aMaxJiffies);
+        UnblockIfNotFull();
+    } while (count == 0);
+}
+
 void AudioReservoir::Push(Msg* aMsg)
 {
     DoEnqueue(aMsg);
@@ -37,6 +49,22 @@ void AudioReservoir::Push(Msg* aMsg)
 
 void AudioReservoir::BlockIfFull()
 {
+    if (iQueueType == ReservoirQueue::LockFree) {
+        // loop in case we consumed a signal intended for an earlier call
+        while (IsFull()) {
+            iBlocked.store(true);
+            if (IsFull()) {
+                HandleBlocked();
+                iSem.Wait();
+            }
+            else if (!iBlocked.exchange(false)) {
+                // a puller saw iBlocked and has signalled (or is about to) - consume that signal
+                iSem.Wait();
+            }
+        }
+        return;
+    }
+
     iLock.Wait();
     const TBool full = IsFull();
     (void)iSem.Clear();
@@ -49,6 +77,14 @@ void AudioReservoir::BlockIfFull()
 
 void AudioReservoir::UnblockIfNotFull()
 {
+    if (iQueueType == ReservoirQueue::LockFree) {
+        // only wake the pushing thread on the full -> not full transition
+        if (iBlocked.load() && !IsFull() && iBlocked.exchange(false)) {
+            iSem.Signal();
+        }
+        return;
+    }
+
     AutoMutex _(iLock);
     if (!IsFull()) {
         iSem.Signal();
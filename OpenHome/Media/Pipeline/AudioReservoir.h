@@ -5,6 +5,8 @@
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 
+#include <atomic>
+
 namespace OpenHome {
 namespace Media {
 
@@ -14,6 +16,7 @@ Msgs can be pulled whenever available.
 Blocks further data being enqueued when size is greater that MaxSize.
 Discards all data when a Flush msg is queued.
 FIXME - no handling of Halt
+ReservoirQueue::LockFree avoids all locks but requires a single pushing and a single pulling thread.
 */
     
 class AudioReservoir : protected MsgReservoir, public IPipelineElementUpstream, public IPipelineElementDownstream
@@ -23,18 +26,21 @@ public:
     ~AudioReservoir();
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 public: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
 protected:
-    AudioReservoir();
+    AudioReservoir(ReservoirQueue aQueue);
     void BlockIfFull();
     void UnblockIfNotFull();
 private:
     virtual TBool IsFull() const = 0;
     virtual void HandleBlocked();
 private:
+    const ReservoirQueue iQueueType;
     Mutex iLock;
     Semaphore iSem;
+    std::atomic<TBool> iBlocked; // ReservoirQueue::LockFree only
 };
 
 } // namespace Media
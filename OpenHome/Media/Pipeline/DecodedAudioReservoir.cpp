@@ -12,12 +12,17 @@ using namespace OpenHome::Media;
 // DecodedAudioReservoir
 
 DecodedAudioReservoir::DecodedAudioReservoir(MsgFactory& aMsgFactory, IFlushIdProvider& aFlushIdProvider,
-                                             TUint aMaxSize, TUint aMaxStreamCount, TUint aGorgeSize)
-    : iMsgFactory(aMsgFactory)
+                                             TUint aMaxSize, TUint aMaxStreamCount, TUint aGorgeSize,
+                                             TUint aDecodeAheadSize, ReservoirQueue aQueue)
+    : AudioReservoir(aQueue)
+    , iMsgFactory(aMsgFactory)
     , iFlushIdProvider(aFlushIdProvider)
     , iLock("DCR1")
     , iMaxJiffies(aMaxSize)
     , iMaxStreamCount(aMaxStreamCount)
+    , iDecodeAheadJiffies(aDecodeAheadSize)
+    , iDecodeAhead(false)
+    , iDecodeAheadStreamId(UINT_MAX)
     , iClockPuller(nullptr)
     , iStreamHandler(nullptr)
     , iDecodedStream(nullptr)
@@ -47,6 +52,24 @@ TUint DecodedAudioReservoir::SizeInJiffies() const
 }
 
 Msg* DecodedAudioReservoir::Pull()
+{
+    WaitIfGorging();
+    Msg* msg = AudioReservoir::Pull();
+    StartGorgingIfRequired();
+    return msg;
+}
+
+void DecodedAudioReservoir::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    /* MsgQueue::DequeueBatch() only batches runs of MsgAudioPcm and always returns
+       any priority msg on its own so gorging decisions see the same msg boundaries
+       as a series of Pull() calls */
+    WaitIfGorging();
+    AudioReservoir::PullBatch(aQueue, aMaxJiffies);
+    StartGorgingIfRequired();
+}
+
+void DecodedAudioReservoir::WaitIfGorging()
 {
     TBool wait = false;
     {
@@ -60,20 +83,18 @@ Msg* DecodedAudioReservoir::Pull()
     if (wait) {
         iSemOut.Wait();
     }
-    Msg* msg = AudioReservoir::Pull();
+}
 
-    {
-        AutoMutex _(iGorgeLock);
-        if (iShouldGorge
-            && iPriorityMsgCount == 0
-            && !iStartOfMode
-            && Jiffies() < iGorgeSize) {
-            iShouldGorge = false;
-            SetGorging(true, "Pull");
-        }
+void DecodedAudioReservoir::StartGorgingIfRequired()
+{
+    AutoMutex _(iGorgeLock);
+    if (iShouldGorge
+        && iPriorityMsgCount == 0
+        && !iStartOfMode
+        && Jiffies() < iGorgeSize) {
+        iShouldGorge = false;
+        SetGorging(true, "Pull");
     }
-
-    return msg;
 }
 
 void DecodedAudioReservoir::Push(Msg* aMsg)
@@ -97,9 +118,33 @@ void DecodedAudioReservoir::Push(Msg* aMsg)
     iGorgeLock.Signal();
 }
 
+void DecodedAudioReservoir::NotifyStreamEnding(TUint aStreamId)
+{
+    if (iDecodeAheadJiffies == 0) {
+        return;
+    }
+    LOG(kPipeline, "DecodedAudioReservoir: decode-ahead from end of stream %u\n", aStreamId);
+    {
+        AutoMutex _(iLock);
+        iDecodeAheadStreamId = aStreamId;
+    }
+    iDecodeAhead.store(true);
+}
+
+void DecodedAudioReservoir::NotifyStreamSeek(TUint aStreamId)
+{
+    AutoMutex _(iLock);
+    if (iDecodeAheadStreamId == aStreamId) {
+        LOG(kPipeline, "DecodedAudioReservoir: seek withdraws decode-ahead for stream %u\n", aStreamId);
+        iDecodeAheadStreamId = UINT_MAX;
+        iDecodeAhead.store(false);
+    }
+}
+
 TBool DecodedAudioReservoir::IsFull() const
 {
-    return (Jiffies() > iMaxJiffies            ||
+    const TUint maxJiffies = iMaxJiffies + (iDecodeAhead.load()? iDecodeAheadJiffies : 0);
+    return (Jiffies() > maxJiffies             ||
             TrackCount() >= iMaxStreamCount    ||
             DelayCount() >= iMaxStreamCount    ||
             MetaTextCount() >= iMaxStreamCount ||
@@ -135,7 +180,9 @@ void DecodedAudioReservoir::ProcessMsgIn(MsgMode* aMsg)
         iClockPuller = aMsg->ClockPuller().Ptr();
 
         iStartOfMode = true;
+        iDecodeAheadStreamId = UINT_MAX;
     }
+    iDecodeAhead.store(false);
     iGorgeLock.Wait();
     iShouldGorge = false;
     iPriorityMsgCount++;
@@ -260,6 +307,16 @@ Msg* DecodedAudioReservoir::ProcessMsgOut(MsgDecodedStream* aMsg)
 {
     iStreamHandler.store(aMsg->StreamInfo().StreamHandler());
     auto msg = iMsgFactory.CreateMsgDecodedStream(aMsg, this);
+    {
+        AutoMutex _(iLock);
+        if (iDecodedStream != nullptr
+            && iDecodedStream->StreamInfo().StreamId() == iDecodeAheadStreamId
+            && aMsg->StreamInfo().StreamId() != iDecodeAheadStreamId) {
+            // playback has moved on from the stream that enabled decode-ahead
+            iDecodeAheadStreamId = UINT_MAX;
+            iDecodeAhead.store(false);
+        }
+    }
     if (iDecodedStream != nullptr) {
         iDecodedStream->RemoveRef();
     }
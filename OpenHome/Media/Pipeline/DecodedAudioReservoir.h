@@ -11,12 +11,22 @@
 namespace OpenHome {
 namespace Media {
 
-class DecodedAudioReservoir : public AudioReservoir, private IStreamHandler
+/*
+ * aDecodeAheadSize extends aMaxSize once the codec reports (via IDecodeAhead) that the
+ * remainder of its current stream will fit in it.  This lets the codec finish that stream
+ * and start recognising and decoding the next one while more of the current stream is still
+ * buffered.  The extra space is withdrawn once the next stream starts being pulled or the
+ * current stream is seeked.
+ * Zero disables decode-ahead.
+ */
+
+class DecodedAudioReservoir : public AudioReservoir, public IDecodeAhead, private IStreamHandler
 {
     friend class SuiteGorger;
 public:
     DecodedAudioReservoir(MsgFactory& aMsgFactory, IFlushIdProvider& aFlushIdProvider,
-                          TUint aMaxSize, TUint aMaxStreamCount, TUint aGorgeSize);
+                          TUint aMaxSize, TUint aMaxStreamCount, TUint aGorgeSize, TUint aDecodeAheadSize,
+                          ReservoirQueue aQueue);
     ~DecodedAudioReservoir();
     TUint SizeInJiffies() const;
 private: // from AudioReservoir
@@ -24,10 +34,16 @@ private: // from AudioReservoir
     void HandleBlocked() override;
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 public: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
+public: // from IDecodeAhead
+    void NotifyStreamEnding(TUint aStreamId) override;
+    void NotifyStreamSeek(TUint aStreamId) override;
 private:
     void SetGorging(TBool aGorging, const TChar* aId);
+    void WaitIfGorging();
+    void StartGorgingIfRequired();
     void ProcessAudioIn(MsgAudioDecoded* aAudio);
     Msg* ProcessAudioOut(MsgAudioDecoded* aAudio);
 private: // from MsgReservoir
@@ -62,6 +78,9 @@ private:
     Mutex iLock;
     const TUint iMaxJiffies;
     const TUint iMaxStreamCount;
+    const TUint iDecodeAheadJiffies;
+    std::atomic<TBool> iDecodeAhead;
+    TUint iDecodeAheadStreamId;
     IClockPuller* iClockPuller;
     std::atomic<IStreamHandler*> iStreamHandler;
     MsgDecodedStream *iDecodedStream;
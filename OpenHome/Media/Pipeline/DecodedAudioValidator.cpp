@@ -60,6 +60,20 @@ Msg* DecodedAudioValidator::Pull()
     return msg;
 }
 
+void DecodedAudioValidator::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    ASSERT(iUpstream != nullptr);
+    MsgQueueLite batch;
+    iUpstream->PullBatch(batch, aMaxJiffies);
+    while (!batch.IsEmpty()) {
+        Msg* msg = batch.Dequeue();
+        if (iEnabled) {
+            msg = msg->Process(*this);
+        }
+        aQueue.Enqueue(msg);
+    }
+}
+
 void DecodedAudioValidator::Push(Msg* aMsg)
 {
     ASSERT(iDownstream != nullptr);
@@ -17,6 +17,7 @@ public:
                           Can disable manually to limit testing to certain points in the pipeline */
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 public: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
 private: // from IMsgProcessor
@@ -85,6 +85,26 @@ Msg* DrainerBase::Pull()
     return msg;
 }
 
+void DrainerBase::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    iUpstream.PullBatch(*this, *this, iUpstream, aQueue, aMaxJiffies);
+}
+
+TBool DrainerBase::BypassPull() const
+{
+    return !iWaitForDrained && iPending == nullptr && !iGenerateDrainMsg.load();
+}
+
+TBool DrainerBase::BypassAudio() const
+{
+    return false;
+}
+
+Msg* DrainerBase::ProcessBypassed(Msg* aMsg)
+{
+    return aMsg->Process(*this);
+}
+
 
 // DrainerLeft
 
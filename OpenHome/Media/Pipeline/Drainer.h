@@ -10,7 +10,7 @@
 namespace OpenHome {
 namespace Media {
 
-class DrainerBase : public PipelineElement, public IPipelineElementUpstream, private INonCopyable
+class DrainerBase : public PipelineElement, public IPipelineElementUpstream, private IPipelineElementBypassable, private INonCopyable
 {
     static const TUint kSupportedMsgTypes;
 protected:
@@ -18,11 +18,16 @@ protected:
     ~DrainerBase();
 private: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 protected:
     MsgFactory& iMsgFactory;
     std::atomic<TBool> iGenerateDrainMsg;
 private:
-    IPipelineElementUpstream& iUpstream;
+    BatchingUpstream iUpstream;
     Semaphore iSem;
     Msg* iPending;
     TBool iWaitForDrained;
@@ -0,0 +1,123 @@
+#include <OpenHome/Media/Pipeline/ElementBypass.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// ElementBypass
+
+const TUint ElementBypass::kSupportedMsgTypes =   eMode
+                                                | eTrack
+                                                | eDrain
+                                                | eDelay
+                                                | eMetatext
+                                                | eStreamInterrupted
+                                                | eHalt
+                                                | eFlush
+                                                | eWait
+                                                | eDecodedStream
+                                                | eBitRate
+                                                | eAudioPcm
+                                                | eAudioDsd
+                                                | eSilence
+                                                | eQuit;
+
+ElementBypass::ElementBypass(IPipelineElementUpstream& aUpstream, IPipelineElementUpstream& aTail)
+    : PipelineElement(kSupportedMsgTypes)
+    , iUpstream(aUpstream)
+    , iTail(aTail)
+    , iUpdate(true)
+    , iCanBypass(false)
+{
+}
+
+void ElementBypass::AddElement(IPipelineElementBypassable& aElement)
+{
+    iElements.push_back(&aElement);
+    iUpdate = true;
+}
+
+Msg* ElementBypass::Pull()
+{
+    Msg* msg;
+    do {
+        if (iUpdate) {
+            UpdateBypass();
+        }
+        msg = (iCanBypass? iUpstream.Pull() : iTail.Pull());
+        if (!msg->IsAudioPcm()) {
+            /* Note MsgMode/MsgDecodedStream before the run processes (and maybe consumes) them.
+               Elements are re-queried once they've processed the msg, on the next pass. */
+            (void)msg->Process(*this);
+        }
+        if (iCanBypass) {
+            msg = ProcessBypassed(msg->IsAudioPcm()? iAudioElements : iElements, msg);
+        }
+    } while (msg == nullptr);
+    return msg;
+}
+
+void ElementBypass::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    // a batch holding anything other than MsgAudioPcm holds a single msg, so iUpdate can only be set by its last msg
+    MsgQueueLite batch;
+    while (aQueue.IsEmpty()) {
+        if (iUpdate) {
+            UpdateBypass();
+        }
+        if (!iCanBypass) {
+            iTail.PullBatch(aQueue, aMaxJiffies);
+            return;
+        }
+        iUpstream.PullBatch(batch, aMaxJiffies);
+        while (!batch.IsEmpty()) {
+            Msg* msg = batch.Dequeue();
+            if (!msg->IsAudioPcm()) {
+                (void)msg->Process(*this);
+            }
+            msg = ProcessBypassed(msg->IsAudioPcm()? iAudioElements : iElements, msg);
+            if (msg != nullptr) {
+                aQueue.Enqueue(msg);
+            }
+        }
+    }
+}
+
+Msg* ElementBypass::ProcessBypassed(const std::vector<IPipelineElementBypassable*>& aElements, Msg* aMsg)
+{
+    for (auto element : aElements) {
+        aMsg = element->ProcessBypassed(aMsg);
+        if (aMsg == nullptr) {
+            break;
+        }
+    }
+    return aMsg;
+}
+
+void ElementBypass::UpdateBypass()
+{
+    iUpdate = false;
+    iCanBypass = true;
+    iAudioElements.clear();
+    for (auto element : iElements) {
+        if (!element->BypassPull()) {
+            iCanBypass = false;
+        }
+        if (!element->BypassAudio()) {
+            iAudioElements.push_back(element);
+        }
+    }
+}
+
+Msg* ElementBypass::ProcessMsg(MsgMode* aMsg)
+{
+    iUpdate = true;
+    return aMsg;
+}
+
+Msg* ElementBypass::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    iUpdate = true;
+    return aMsg;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <vector>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+Element which replaces a run of IPipelineElementBypassable elements with a single Pull().
+Pulls directly from the element upstream of the run then calls ProcessBypassed() on each element in turn.
+MsgAudioPcm skips any element that reports BypassAudio().  All other msgs visit every element.
+Falls back to pulling from the last element of the run if any element can't currently be bypassed.
+Elements are only queried when the run is first pulled from and after each MsgMode or
+MsgDecodedStream leaves it, so their bypass state may only change on those msgs.
+PullBatch() passes a run of MsgAudioPcm through the bypassed elements without re-querying them.
+*/
+
+class ElementBypass : public PipelineElement, public IPipelineElementUpstream, private INonCopyable
+{
+    static const TUint kSupportedMsgTypes;
+public:
+    ElementBypass(IPipelineElementUpstream& aUpstream, IPipelineElementUpstream& aTail);
+    void AddElement(IPipelineElementBypassable& aElement); // call in pull order, nearest to aUpstream first
+public: // from IPipelineElementUpstream
+    Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private:
+    static Msg* ProcessBypassed(const std::vector<IPipelineElementBypassable*>& aElements, Msg* aMsg);
+    void UpdateBypass();
+private: // from PipelineElement
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+private:
+    IPipelineElementUpstream& iUpstream;
+    IPipelineElementUpstream& iTail;
+    std::vector<IPipelineElementBypassable*> iElements;
+    std::vector<IPipelineElementBypassable*> iAudioElements; // elements that currently process MsgAudioPcm
+    TBool iUpdate;
+    TBool iCanBypass;
+};
+
+} // namespace Media
+} // namespace OpenHome
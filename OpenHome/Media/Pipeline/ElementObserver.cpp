@@ -1,24 +1,41 @@
 #include <OpenHome/Media/Pipeline/ElementObserver.h>
 #include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Stream.h>
 #include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Timer.h>
 #include <OpenHome/Private/Standard.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Net/Private/Globals.h>
 
 #include <atomic>
+#include <climits>
 #include <vector>
 
 using namespace OpenHome;
 using namespace OpenHome::Media;
 
-PipelineElementObserverThread::PipelineElementObserverThread(TUint aPriority)
-    : iLock("PEOT")
+const Brn PipelineElementObserverThread::kQueryEvents("events");
+
+PipelineElementObserverThread::PipelineElementObserverThread(IInfoAggregator& aInfoAggregator, TUint aPriority)
+    : iTimer(nullptr)
+    , iLock("PEOT")
     , iNextId(0)
     , iStarted(false)
+    , iWakePending(false)
+    , iBatches(0)
 {
     iThread = new ThreadFunctor("PipelineEvents", MakeFunctor(*this, &PipelineElementObserverThread::PipelineEventThread), aPriority);
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryEvents);
+    aInfoAggregator.Register(*this, infoQueries);
 }
 
 PipelineElementObserverThread::~PipelineElementObserverThread()
 {
+    delete iTimer;
     delete iThread;
     for (auto it=iCallbacks.begin(); it!=iCallbacks.end(); ++it) {
         delete *it;
@@ -34,28 +51,86 @@ void PipelineElementObserverThread::Start()
 
 void PipelineElementObserverThread::Stop()
 {
+    if (iTimer != nullptr) {
+        iTimer->Cancel();
+    }
     iThread->Kill();
     iThread->Join();
 }
 
+void PipelineElementObserverThread::GetStats(TUint64& aScheduled, TUint64& aCoalesced, TUint64& aDispatched, TUint64& aBatches) const
+{
+    aScheduled = aCoalesced = aDispatched = 0;
+    for (auto cb : iCallbacks) {
+        TUint64 scheduled, coalesced, dispatched;
+        cb->GetStats(scheduled, coalesced, dispatched);
+        aScheduled += scheduled;
+        aCoalesced += coalesced;
+        aDispatched += dispatched;
+    }
+    aBatches = iBatches.load();
+}
+
+void PipelineElementObserverThread::GetStats(TUint aId, TUint64& aScheduled, TUint64& aCoalesced, TUint64& aDispatched) const
+{
+    for (auto cb : iCallbacks) {
+        if (cb->Id() == aId) {
+            cb->GetStats(aScheduled, aCoalesced, aDispatched);
+            return;
+        }
+    }
+    ASSERTS();
+}
+
 void PipelineElementObserverThread::PipelineEventThread()
 {
     try {
         for (;;) {
             iThread->Wait();
+            // clear before running callbacks so that any Schedule() from now on wakes us again
+            iWakePending.store(false);
+            iBatches++;
+            const TUint now = (iTimer == nullptr? 0 : NowMs());
+            TUint delayMs = UINT_MAX;
+            TBool deferred = false;
             for (auto cb : iCallbacks) {
-                cb->RunIfPending();
+                if (cb->RunIfDue(now, delayMs)) {
+                    deferred = true;
+                }
+            }
+            if (deferred) {
+                iTimer->FireIn(delayMs);
             }
         }
     }
     catch (ThreadKill&) {}
 }
 
+void PipelineElementObserverThread::Wake()
+{
+    if (!iWakePending.exchange(true)) {
+        iThread->Signal();
+    }
+}
+
+TUint PipelineElementObserverThread::NowMs() const
+{
+    return Os::TimeInMs(gEnv->OsCtx());
+}
+
 TUint PipelineElementObserverThread::Register(Functor aCallback)
+{
+    return RegisterThrottled(aCallback, 0);
+}
+
+TUint PipelineElementObserverThread::RegisterThrottled(Functor aCallback, TUint aMinIntervalMs)
 {
     ASSERT(!iStarted.load());
+    if (aMinIntervalMs > 0 && iTimer == nullptr) {
+        iTimer = new Timer(*gEnv, MakeFunctor(*this, &PipelineElementObserverThread::Wake), "PipelineEvents");
+    }
     const TUint id = iNextId++;
-    auto cb = new Callback(id, aCallback);
+    auto cb = new Callback(id, aCallback, aMinIntervalMs);
     iLock.Wait();
     iCallbacks.push_back(cb);
     iLock.Signal();
@@ -66,8 +141,9 @@ void PipelineElementObserverThread::Schedule(TUint aId)
 {
     for (auto cb : iCallbacks) {
         if (cb->Id() == aId) {
-            cb->SetPending();
-            iThread->Signal();
+            if (!cb->SetPending()) {
+                Wake();
+            }
             return;
         }
     }
@@ -75,27 +151,95 @@ void PipelineElementObserverThread::Schedule(TUint aId)
     ASSERTS();
 }
 
+void PipelineElementObserverThread::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    if (aQuery != kQueryEvents) {
+        return;
+    }
+    TUint64 scheduled, coalesced, dispatched, batches;
+    GetStats(scheduled, coalesced, dispatched, batches);
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("Pipeline events: scheduled="));
+    writer.WriteUint64(scheduled);
+    writer.Write(Brn(" coalesced="));
+    writer.WriteUint64(coalesced);
+    writer.Write(Brn(" dispatched="));
+    writer.WriteUint64(dispatched);
+    writer.Write(Brn(" batches="));
+    writer.WriteUint64(batches);
+    writer.Write(Brn("\n"));
+    for (auto cb : iCallbacks) {
+        cb->GetStats(scheduled, coalesced, dispatched);
+        writer.Write(Brn("    "));
+        writer.WriteUint(cb->Id());
+        writer.Write(Brn(": interval="));
+        writer.WriteUint(cb->MinIntervalMs());
+        writer.Write(Brn("ms scheduled="));
+        writer.WriteUint64(scheduled);
+        writer.Write(Brn(" coalesced="));
+        writer.WriteUint64(coalesced);
+        writer.Write(Brn(" dispatched="));
+        writer.WriteUint64(dispatched);
+        writer.Write(Brn("\n"));
+    }
+}
+
 
 // PipelineElementObserverThread::Callback
 
-PipelineElementObserverThread::Callback::Callback(TUint aId, Functor aCallback)
+PipelineElementObserverThread::Callback::Callback(TUint aId, Functor aCallback, TUint aMinIntervalMs)
     : iId(aId)
     , iCallback(aCallback)
+    , iMinIntervalMs(aMinIntervalMs)
+    , iLastRunMs(0)
+    , iHasRun(false)
+    , iScheduled(0)
+    , iCoalesced(0)
+    , iDispatched(0)
 {
     iPending.store(false);
     ASSERT(iPending.is_lock_free());
 }
 
-void PipelineElementObserverThread::Callback::SetPending()
+TBool PipelineElementObserverThread::Callback::SetPending()
 {
-    iPending.store(true);
+    iScheduled++;
+    if (iPending.exchange(true)) {
+        iCoalesced++;
+        return true;
+    }
+    return false;
 }
 
-void PipelineElementObserverThread::Callback::RunIfPending()
+TBool PipelineElementObserverThread::Callback::RunIfDue(TUint aNowMs, TUint& aDelayMs)
 {
+    if (!iPending.load()) {
+        return false;
+    }
+    if (iMinIntervalMs > 0) {
+        const TUint elapsed = aNowMs - iLastRunMs; // unsigned arithmetic copes with wrap
+        if (iHasRun && elapsed < iMinIntervalMs) {
+            const TUint remaining = iMinIntervalMs - elapsed;
+            if (remaining < aDelayMs) {
+                aDelayMs = remaining;
+            }
+            return true;
+        }
+        iLastRunMs = aNowMs;
+        iHasRun = true;
+    }
     if (iPending.exchange(false)) {
+        iDispatched++;
         iCallback();
     }
+    return false;
+}
+
+void PipelineElementObserverThread::Callback::GetStats(TUint64& aScheduled, TUint64& aCoalesced, TUint64& aDispatched) const
+{
+    aScheduled = iScheduled.load();
+    aCoalesced = iCoalesced.load();
+    aDispatched = iDispatched.load();
 }
 
 
@@ -110,6 +254,11 @@ TUint ElementObserverSync::Register(Functor aCallback)
     return kId;
 }
 
+TUint ElementObserverSync::RegisterThrottled(Functor aCallback, TUint /*aMinIntervalMs*/)
+{
+    return Register(aCallback);
+}
+
 void ElementObserverSync::Schedule(TUint aId)
 {
     ASSERT(aId == kId);
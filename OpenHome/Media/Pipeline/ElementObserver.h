@@ -1,21 +1,28 @@
 #pragma once
 
 #include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/InfoProvider.h>
 #include <OpenHome/Functor.h>
 
 #include <atomic>
 #include <vector>
 
 namespace OpenHome {
+    class Timer;
 namespace Media {
 
 /*
     Runs callbacks from any pipeline element in a dedicated thread.
     (i.e. Ensures callbacks don't block flow of pipeline msgs)
-    Effect of calling Schedule while a previous callback is pending is slightly
-    unpredictable - the callback is guaranteed to be called at least once.
+    Callbacks are expected to report their element's latest state so calls to Schedule
+    are coalesced - calling Schedule while a callback is pending neither wakes the thread
+    nor causes an extra call.  The callback is guaranteed to be called at least once.
+    Each wake of the thread runs all pending callbacks as a single batch.
+    RegisterThrottled limits a callback to one call per aMinIntervalMs.  Schedule within
+    that interval of the previous call is deferred until the interval expires.
 */
 
 class IPipelineElementCallback
@@ -30,40 +37,67 @@ class IPipelineElementObserverThread
 public:
     virtual ~IPipelineElementObserverThread() {}
     virtual TUint Register(Functor aCallback) = 0;
+    virtual TUint RegisterThrottled(Functor aCallback, TUint aMinIntervalMs) = 0;
     virtual void Schedule(TUint aId) = 0;
 };
 
-class PipelineElementObserverThread : public IPipelineElementObserverThread, private INonCopyable
+/*
+ * Counts of scheduled, coalesced and dispatched callbacks (plus number of batches)
+ * are reported via IInfoAggregator's "events" query.
+ */
+class PipelineElementObserverThread : public IPipelineElementObserverThread
+                                    , private IInfoProvider
+                                    , private INonCopyable
 {
 public:
-    PipelineElementObserverThread(TUint aPriority);
+    static const Brn kQueryEvents;
+public:
+    PipelineElementObserverThread(IInfoAggregator& aInfoAggregator, TUint aPriority);
     ~PipelineElementObserverThread();
     void Start();
     void Stop();
+    void GetStats(TUint64& aScheduled, TUint64& aCoalesced, TUint64& aDispatched, TUint64& aBatches) const;
+    void GetStats(TUint aId, TUint64& aScheduled, TUint64& aCoalesced, TUint64& aDispatched) const;
 private:
     void PipelineEventThread();
+    void Wake();
+    TUint NowMs() const;
 private: // from IPipelineElementObserverThread
     TUint Register(Functor aCallback) override;
+    TUint RegisterThrottled(Functor aCallback, TUint aMinIntervalMs) override;
     void Schedule(TUint aId) override;
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
 private:
     class Callback : private INonCopyable
     {
     public:
-        Callback(TUint aId, Functor aCallback);
+        Callback(TUint aId, Functor aCallback, TUint aMinIntervalMs);
         TUint Id() const { return iId; }
-        void SetPending();
-        void RunIfPending();
+        TUint MinIntervalMs() const { return iMinIntervalMs; }
+        TBool SetPending(); // returns true if the callback was already pending
+        TBool RunIfDue(TUint aNowMs, TUint& aDelayMs); // returns true if deferred; aDelayMs reduced to time until due
+        void GetStats(TUint64& aScheduled, TUint64& aCoalesced, TUint64& aDispatched) const;
     private:
-        TUint iId;
+        const TUint iId;
         Functor iCallback;
+        const TUint iMinIntervalMs;
+        TUint iLastRunMs;
+        TBool iHasRun;
         std::atomic<bool> iPending;
+        std::atomic<TUint64> iScheduled;
+        std::atomic<TUint64> iCoalesced;
+        std::atomic<TUint64> iDispatched;
     };
 private:
     ThreadFunctor* iThread;
+    Timer* iTimer; // only created if a throttled callback is registered
     Mutex iLock;
     std::vector<Callback*> iCallbacks;
     std::atomic<TUint> iNextId;
     std::atomic<TBool> iStarted;
+    std::atomic<TBool> iWakePending;
+    std::atomic<TUint64> iBatches;
 };
 
 // Test helper - supports a single callback and runs it synchronously, inside calls to Schedule()
@@ -72,6 +106,7 @@ class ElementObserverSync : public IPipelineElementObserverThread
     static const TUint kId;
 private: // from IPipelineElementObserverThread
     TUint Register(Functor aCallback) override;
+    TUint RegisterThrottled(Functor aCallback, TUint aMinIntervalMs) override; // aMinIntervalMs ignored
     void Schedule(TUint aId) override;
 private:
     Functor iCallback;
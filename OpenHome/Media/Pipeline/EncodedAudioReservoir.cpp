@@ -12,8 +12,10 @@ using namespace OpenHome::Media;
 const TUint EncodedAudioReservoir::kEncodedBytesInvalid = 0x80000000;
 const TUint EncodedAudioReservoir::kMsgCountInvalid     = kEncodedBytesInvalid;
 
-EncodedAudioReservoir::EncodedAudioReservoir(MsgFactory& aMsgFactory, IFlushIdProvider& aFlushIdProvider, TUint aMsgCount, TUint aMaxStreamCount)
-    : iMsgFactory(aMsgFactory)
+EncodedAudioReservoir::EncodedAudioReservoir(MsgFactory& aMsgFactory, IFlushIdProvider& aFlushIdProvider, TUint aMsgCount, TUint aMaxStreamCount,
+                                             ReservoirQueue aQueue)
+    : AudioReservoir(aQueue)
+    , iMsgFactory(aMsgFactory)
     , iFlushIdProvider(aFlushIdProvider)
     , iMsgCount(aMsgCount)
     , iMaxStreamCount(aMaxStreamCount)
@@ -18,7 +18,8 @@ class EncodedAudioReservoir : public AudioReservoir, private IStreamHandler, pri
     static const TUint kEncodedBytesInvalid; // values larger than this will have been caused by unsigned underflow (i.e. implementation error)
     static const TUint kMsgCountInvalid; // values larger than this will have been caused by unsigned underflow (i.e. implementation error)
 public:
-    EncodedAudioReservoir(MsgFactory& aMsgFactory, IFlushIdProvider& aFlushIdProvider, TUint aMsgCount, TUint aMaxStreamCount);
+    EncodedAudioReservoir(MsgFactory& aMsgFactory, IFlushIdProvider& aFlushIdProvider, TUint aMsgCount, TUint aMaxStreamCount,
+                          ReservoirQueue aQueue);
     TUint SizeInBytes() const;
 private:
     Msg* EndSeek(Msg* aMsg);
@@ -73,6 +73,34 @@ Msg* Flusher::Pull()
     return msg;
 }
 
+void Flusher::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    MsgQueueLite batch;
+    for (;;) {
+        iLock.Wait();
+        const TBool pendingMetatext = (!IsFlushing() && iPendingMetatext != nullptr);
+        iLock.Signal();
+        if (pendingMetatext) {
+            aQueue.Enqueue(Pull());
+            return;
+        }
+        iUpstream.PullBatch(batch, aMaxJiffies);
+        TBool appended = false;
+        iLock.Wait();
+        while (!batch.IsEmpty()) {
+            Msg* msg = batch.Dequeue()->Process(*this);
+            if (msg != nullptr) {
+                aQueue.Enqueue(msg);
+                appended = true;
+            }
+        }
+        iLock.Signal();
+        if (appended) {
+            return;
+        }
+    }
+}
+
 inline TBool Flusher::IsFlushing() const
 {
     return (iTargetHaltId != MsgHalt::kIdInvalid || iTargetFlushId != MsgFlush::kIdInvalid);
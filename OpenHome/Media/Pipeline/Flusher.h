@@ -17,6 +17,7 @@ public:
     void DiscardUntilFlush(TUint aId);
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 private:
     inline TBool IsFlushing() const;
     Msg* ProcessFlushable(Msg* aMsg);
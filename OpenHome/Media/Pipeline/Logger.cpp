@@ -2,6 +2,7 @@
 #include <OpenHome/Types.h>
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Pipeline/PipelineTrace.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Media;
@@ -18,6 +19,7 @@ Logger::Logger(IPipelineElementUpstream& aUpstreamElement, const TChar* aId)
     , iId(aId)
     , iEnabled(false)
     , iFilter(EMsgNone)
+    , iTracePoint(nullptr)
     , iShutdownSem("PDSD", 0)
 {
 }
@@ -28,6 +30,7 @@ Logger::Logger(const TChar* aId, IPipelineElementDownstream& aDownstreamElement)
     , iId(aId)
     , iEnabled(false)
     , iFilter(EMsgNone)
+    , iTracePoint(nullptr)
     , iShutdownSem("PDSD", 0)
 {
 }
@@ -49,21 +52,82 @@ void Logger::SetFilter(TUint aMsgTypes)
     iFilter = aMsgTypes;
 }
 
+void Logger::SetTracePoint(PipelineTracePoint& aTracePoint)
+{
+    iTracePoint = &aTracePoint;
+}
+
+const TChar* Logger::Id() const
+{
+    return iId;
+}
+
 Msg* Logger::Pull()
 {
+    const TBool trace = (iTracePoint != nullptr && iTracePoint->Enabled());
+    PipelineTracePoint::Span span;
+    if (trace) {
+        span = PipelineTracePoint::Begin();
+    }
     Msg* msg = iUpstreamElement->Pull();
+    if (trace) {
+        TUint type, jiffies;
+        iTracePoint->Classify(*msg, type, jiffies);
+        iTracePoint->Record(span, type, jiffies);
+    }
     if (iEnabled) {
         (void)msg->Process(*this);
     }
     return msg;
 }
 
+void Logger::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    if (!BypassPull()) {
+        aQueue.Enqueue(Pull());
+        return;
+    }
+    MsgQueueLite batch;
+    iUpstreamElement->PullBatch(batch, aMaxJiffies);
+    while (!batch.IsEmpty()) {
+        aQueue.Enqueue(ProcessBypassed(batch.Dequeue()));
+    }
+}
+
 void Logger::Push(Msg* aMsg)
 {
     if (iEnabled) {
         (void)aMsg->Process(*this);
     }
+    const TBool trace = (iTracePoint != nullptr && iTracePoint->Enabled());
+    if (!trace) {
+        iDownstreamElement->Push(aMsg);
+        return;
+    }
+    // classify before pushing - aMsg may have been consumed by the time Push() returns
+    TUint type, jiffies;
+    iTracePoint->Classify(*aMsg, type, jiffies);
+    const PipelineTracePoint::Span span = PipelineTracePoint::Begin();
     iDownstreamElement->Push(aMsg);
+    iTracePoint->Record(span, type, jiffies);
+}
+
+TBool Logger::BypassPull() const
+{
+    return (iTracePoint == nullptr || !iTracePoint->Enabled());
+}
+
+TBool Logger::BypassAudio() const
+{
+    return !iEnabled;
+}
+
+Msg* Logger::ProcessBypassed(Msg* aMsg)
+{
+    if (iEnabled) {
+        (void)aMsg->Process(*this);
+    }
+    return aMsg;
 }
 
 inline TBool Logger::IsEnabled(EMsgType aType) const
@@ -7,12 +7,18 @@
 namespace OpenHome {
 namespace Media {
 
+class PipelineTracePoint;
+
 /*
 Element which logs msgs as they pass through.
 Can be inserted [0..n] times through the pipeline, depending on your debugging needs.
+Optionally also times each Pull()/Push() into a PipelineTracePoint.  Batches are only passed on
+while the trace point is disabled so that timings remain per msg.
+Can be bypassed (see ElementBypass) while its trace point is disabled.  Audio is only bypassed
+while logging is disabled.
 */
 
-class Logger : public IPipelineElementUpstream, public IPipelineElementDownstream, private IMsgProcessor, private INonCopyable
+class Logger : public IPipelineElementUpstream, public IPipelineElementDownstream, public IPipelineElementBypassable, private IMsgProcessor, private INonCopyable
 {
     static const TUint kMaxLogBytes = 10 * 1024;
 public:
@@ -47,10 +53,17 @@ public:
     virtual ~Logger();
     void SetEnabled(TBool aEnabled);
     void SetFilter(TUint aMsgTypes);
+    void SetTracePoint(PipelineTracePoint& aTracePoint);
+    const TChar* Id() const;
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 public: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
+public: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgTrack* aMsg) override;
@@ -81,6 +94,7 @@ private:
     const TChar* iId;
     TBool iEnabled;
     TInt iFilter;
+    PipelineTracePoint* iTracePoint;
     Semaphore iShutdownSem;
     Bws<kMaxLogBytes> iBuf;
 };
@@ -8,7 +8,10 @@
 #include <OpenHome/Private/Stream.h>
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Private/Arch.h>
+#include <OpenHome/OsWrapper.h>
 #include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Media/Utils/ByteSwap.h>
+#include <OpenHome/Media/Utils/PcmGain.h>
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Media/Debug.h>
@@ -25,34 +28,82 @@ using namespace OpenHome::Media;
 const TChar* OpenHome::Media::kStreamPlayNames[] = { "Yes", "No", "Later" };
 
 
+// AllocatorBase::Magazine
+
+AllocatorBase::Magazine::Magazine()
+    : iCount(0)
+    , iBusy(false)
+{
+}
+
+TBool AllocatorBase::Magazine::TryLock()
+{
+    return !iBusy.exchange(true, std::memory_order_acquire);
+}
+
+void AllocatorBase::Magazine::Lock()
+{
+    // Owners only hold a magazine for a handful of instructions so a short spin is cheaper than blocking.
+    // Only used when stealing from other threads' magazines, which only happens when a pool is almost exhausted.
+    // The owner may have been preempted while holding the magazine though.  A real-time stealer on the same
+    // core would then spin forever so sleep after kMaxSpins attempts, giving the owner a chance to run.
+    TUint spins = 0;
+    while (!TryLock()) {
+        if (++spins == kMaxSpins) {
+            Thread::Sleep(kSleepMs);
+            spins = 0;
+        }
+    }
+}
+
+void AllocatorBase::Magazine::Unlock()
+{
+    iBusy.store(false, std::memory_order_release);
+}
+
+
 // AllocatorBase
 
 const Brn AllocatorBase::kQueryMemory = Brn("memory");
+const TUint AllocatorBase::kMagazineCellsMax;
 
 AllocatorBase::~AllocatorBase()
 {
-    LOG(kPipeline, "> ~AllocatorBase for %s. (Peak %u/%u)\n", iName, iCellsUsedMax, iFree.Slots());
-    const TUint slots = iFree.Slots();
-    for (TUint i=0; i<slots; i++) {
-        //Log::Print("  %u", i);
-        try {
-            Allocated* ptr = Read();
-            //Log::Print("(%p)", ptr);
-            delete ptr;
-        }
-        catch (AssertionFailed&) {
-            Log::Print("...leak at %u of %u\n", i+1, slots);
-            ASSERTS();
+    LOG(kPipeline, "> ~AllocatorBase for %s. (Peak %u/%u)\n", iName, iCellsUsedMax.load(), iCellsTotal);
+    if (iCellsUsed.load() != 0) {
+        Log::Print("...leak of %u of %u\n", iCellsUsed.load(), iCellsTotal);
+        ASSERTS();
+    }
+    for (auto cell : iCells) {
+        if (cell != nullptr) {
+            cell->~Allocated();
         }
     }
+    for (auto slab : iSlabs) {
+        ::operator delete(slab);
+    }
+    delete[] iMagazines;
     LOG(kPipeline, "< ~AllocatorBase for %s\n", iName);
 }
 
 void AllocatorBase::Free(Allocated* aPtr)
 {
+    if (iMode == AllocatorMode::LockFree) {
+        FreeLockFree(aPtr);
+        return;
+    }
     iLock.Wait();
     iCellsUsed--;
     iFree.Write(aPtr);
+    const TUint slab = aPtr->iCellIndex / iSlabCells;
+    const TUint slabCells = SlabCellCount(slab);
+    if (++iSlabCellsFree[slab] == slabCells &&
+        iReserve == AllocatorReserve::LazyReleaseIdle &&
+        iFree.SlotsUsed() >= slabCells + iSlabCells) {
+        // only release if a slab's worth of free cells would remain - avoids thrashing the heap
+        // when a pool is repeatedly emptied and refilled around a slab boundary
+        ReleaseSlab(slab);
+    }
     iLock.Signal();
 }
 
@@ -68,54 +119,92 @@ TUint AllocatorBase::CellBytes() const
 
 TUint AllocatorBase::CellsUsed() const
 {
-    iLock.Wait();
-    TUint cellsUsed = iCellsUsed;
-    iLock.Signal();
-    return cellsUsed;
+    return iCellsUsed.load();
 }
 
 TUint AllocatorBase::CellsUsedMax() const
 {
-    iLock.Wait();
-    TUint cellsUsedMax = iCellsUsedMax;
-    iLock.Signal();
-    return cellsUsedMax;
+    return iCellsUsedMax.load();
 }
 
 void AllocatorBase::GetStats(TUint& aCellsTotal, TUint& aCellBytes, TUint& aCellsUsed, TUint& aCellsUsedMax) const
 {
     aCellsTotal = iCellsTotal;
     aCellBytes = iCellBytes;
-    iLock.Wait();
-    aCellsUsed = iCellsUsed;
-    aCellsUsedMax = iCellsUsedMax;
-    iLock.Signal();
+    aCellsUsed = iCellsUsed.load();
+    aCellsUsedMax = iCellsUsedMax.load();
+}
+
+TUint AllocatorBase::CellsReserved() const
+{
+    return iCellsReserved.load();
 }
 
-AllocatorBase::AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator)
-    : iFree(aNumCells)
+AllocatorBase::AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator,
+                             AllocatorMode aMode, AllocatorReserve aReserve)
+    : iFree(aMode == AllocatorMode::Locked? aNumCells : 0)
     , iLock("PAL1")
     , iName(aName)
+    , iMode(aMode)
+    , iReserve(aReserve)
     , iCellsTotal(aNumCells)
     , iCellBytes(aCellBytes)
+    , iSlabCells(std::max(1u, std::min(aNumCells, kSlabBytes / aCellBytes)))
     , iCellsUsed(0)
     , iCellsUsedMax(0)
-{
+    , iCellsReserved(0)
+    , iReserveUs(0)
+    , iSharedNext(aMode == AllocatorMode::LockFree? aNumCells : 0)
+    , iSharedHead(kCellNone)
+    , iMagazines(nullptr)
+    , iMagazineCells(0)
+{
+    const TUint numSlabs = (aNumCells + iSlabCells - 1) / iSlabCells;
+    iCells.resize(aNumCells, nullptr);
+    iSlabs.resize(numSlabs, nullptr);
+    if (iMode == AllocatorMode::Locked) {
+        iSlabCellsFree.resize(numSlabs, 0);
+    }
+    else {
+        /* Limit magazines to holding half of all cells between them.  This leaves
+           enough in the shared stack that small pools (or a thread that only ever
+           frees) can't strand cells and cause allocations elsewhere to fail. */
+        iMagazineCells = std::min(kMagazineCellsMax, aNumCells / (2 * kMaxMagazines));
+        if (iMagazineCells > 0) {
+            iMagazines = new Magazine[kMaxMagazines];
+        }
+    }
     std::vector<Brn> infoQueries;
     infoQueries.push_back(kQueryMemory);
     aInfoAggregator.Register(*this, infoQueries);
 }
 
+void AllocatorBase::Reserve()
+{
+    // called from Allocator<T>'s constructor, once ConstructCell() can be used
+    const TUint64 start = Os::TimeInUs(gEnv->OsCtx());
+    if (iReserve == AllocatorReserve::Full) {
+        while (iCellsReserved.load() < iCellsTotal) {
+            AddSlab();
+        }
+    }
+    iReserveUs = Os::TimeInUs(gEnv->OsCtx()) - start;
+}
+
 Allocated* AllocatorBase::DoAllocate()
 {
+    if (iMode == AllocatorMode::LockFree) {
+        return DoAllocateLockFree();
+    }
     iLock.Wait();
+    if (iFree.SlotsUsed() == 0 && iCellsReserved.load() < iCellsTotal) {
+        AddSlab();
+    }
     Allocated* cell = Read();
     ASSERT_VA(cell->iRefCount == 0, "%s has count %u\n", iName, cell->iRefCount.load());
     cell->iRefCount = 1;
-    iCellsUsed++;
-    if (iCellsUsed > iCellsUsedMax) {
-        iCellsUsedMax = iCellsUsed;
-    }
+    iSlabCellsFree[cell->iCellIndex / iSlabCells]--;
+    CellAllocated();
     iLock.Signal();
     return cell;
 }
@@ -133,10 +222,202 @@ Allocated* AllocatorBase::Read()
     return p;
 }
 
+void AllocatorBase::AddSlab()
+{
+    // called with iLock held, or from Reserve() before the allocator is visible to other threads
+    TUint slab = 0;
+    while (iSlabs[slab] != nullptr) {
+        slab++;
+    }
+    const TUint count = SlabCellCount(slab);
+    TByte* mem = static_cast<TByte*>(::operator new(count * iCellBytes));
+    iSlabs[slab] = mem;
+    const TUint first = slab * iSlabCells;
+    for (TUint i=0; i<count; i++) {
+        Allocated* cell = ConstructCell(mem + (i * iCellBytes));
+        cell->iCellIndex = first + i;
+        iCells[first + i] = cell;
+        if (iMode == AllocatorMode::LockFree) {
+            PushShared(first + i);
+        }
+        else {
+            iFree.Write(cell);
+        }
+    }
+    if (iMode == AllocatorMode::Locked) {
+        iSlabCellsFree[slab] = count;
+    }
+    iCellsReserved += count;
+}
+
+void AllocatorBase::ReleaseSlab(TUint aSlab)
+{
+    // called with iLock held, when all cells from aSlab are in iFree
+    const TUint slots = iFree.SlotsUsed();
+    for (TUint i=0; i<slots; i++) {
+        Allocated* cell = iFree.Read();
+        if (cell->iCellIndex / iSlabCells == aSlab) {
+            iCells[cell->iCellIndex] = nullptr;
+            cell->~Allocated();
+        }
+        else {
+            iFree.Write(cell);
+        }
+    }
+    ::operator delete(iSlabs[aSlab]);
+    iSlabs[aSlab] = nullptr;
+    iSlabCellsFree[aSlab] = 0;
+    iCellsReserved -= SlabCellCount(aSlab);
+}
+
+TUint AllocatorBase::SlabCellCount(TUint aSlab) const
+{
+    return std::min(iSlabCells, iCellsTotal - (aSlab * iSlabCells));
+}
+
+Allocated* AllocatorBase::DoAllocateLockFree()
+{
+    TUint index = kCellNone;
+    if (iMagazines != nullptr) {
+        Magazine& mag = iMagazines[MagazineIndex()];
+        if (mag.TryLock()) {
+            if (mag.iCount == 0) {
+                // only refill half the magazine, leaving space for cells this thread later frees
+                const TUint refill = (iMagazineCells + 1) / 2;
+                for (TUint i=0; i<refill; i++) {
+                    const TUint shared = PopShared();
+                    if (shared == kCellNone) {
+                        break;
+                    }
+                    mag.iCells[mag.iCount++] = shared;
+                }
+            }
+            if (mag.iCount > 0) {
+                index = mag.iCells[--mag.iCount];
+            }
+            mag.Unlock();
+        }
+    }
+    if (index == kCellNone) {
+        index = PopShared();
+    }
+    if (index == kCellNone) {
+        index = StealCell();
+    }
+    if (index == kCellNone) {
+        index = GrowLockFree();
+    }
+    if (index == kCellNone) {
+        Log::Print("Warning: Allocator error for %s\n", iName);
+        ASSERTS();
+    }
+    Allocated* cell = iCells[index];
+    ASSERT_VA(cell->iRefCount == 0, "%s has count %u\n", iName, cell->iRefCount.load());
+    cell->iRefCount = 1;
+    CellAllocated();
+    return cell;
+}
+
+TUint AllocatorBase::GrowLockFree()
+{
+    AutoMutex _(iLock);
+    TUint index = PopShared(); // another thread may have grown the pool while we waited for iLock
+    if (index == kCellNone && iCellsReserved.load() < iCellsTotal) {
+        AddSlab();
+        index = PopShared();
+    }
+    return index;
+}
+
+void AllocatorBase::FreeLockFree(Allocated* aPtr)
+{
+    // decrement before the cell is visible to other threads so CellsUsed() can never exceed CellsTotal()
+    iCellsUsed--;
+    const TUint index = aPtr->iCellIndex;
+    if (iMagazines != nullptr) {
+        Magazine& mag = iMagazines[MagazineIndex()];
+        if (mag.TryLock()) {
+            if (mag.iCount == iMagazineCells) {
+                const TUint spill = (iMagazineCells + 1) / 2;
+                for (TUint i=0; i<spill; i++) {
+                    PushShared(mag.iCells[--mag.iCount]);
+                }
+            }
+            mag.iCells[mag.iCount++] = index;
+            mag.Unlock();
+            return;
+        }
+    }
+    PushShared(index);
+}
+
+void AllocatorBase::PushShared(TUint aIndex)
+{
+    TUint64 head = iSharedHead.load(std::memory_order_relaxed);
+    TUint64 next;
+    do {
+        iSharedNext[aIndex].store((TUint)head, std::memory_order_relaxed);
+        next = ((((head >> 32) + 1) & 0xffffffff) << 32) | aIndex;
+    } while (!iSharedHead.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+}
+
+TUint AllocatorBase::PopShared()
+{
+    TUint64 head = iSharedHead.load(std::memory_order_acquire);
+    for (;;) {
+        const TUint index = (TUint)head;
+        if (index == kCellNone) {
+            return kCellNone;
+        }
+        // tag is incremented on every push/pop so a stale head (ABA) fails the exchange below
+        const TUint64 next = ((((head >> 32) + 1) & 0xffffffff) << 32)
+                           | iSharedNext[index].load(std::memory_order_relaxed);
+        if (iSharedHead.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)) {
+            return index;
+        }
+    }
+}
+
+TUint AllocatorBase::StealCell()
+{
+    // Shared stack is empty so any free cells are held in magazines
+    if (iMagazines == nullptr) {
+        return kCellNone;
+    }
+    for (TUint i=0; i<kMaxMagazines; i++) {
+        Magazine& mag = iMagazines[i];
+        TUint index = kCellNone;
+        mag.Lock();
+        if (mag.iCount > 0) {
+            index = mag.iCells[--mag.iCount];
+        }
+        mag.Unlock();
+        if (index != kCellNone) {
+            return index;
+        }
+    }
+    return PopShared(); // cells may have been freed to the shared stack while we scanned magazines
+}
+
+TUint AllocatorBase::MagazineIndex() const
+{
+    /* Thread objects are long-lived so their addresses give a cheap, stable per-thread key.
+       Collisions are harmless - a thread that finds its magazine busy uses the shared stack. */
+    const uintptr_t thread = reinterpret_cast<uintptr_t>(Thread::Current());
+    return (TUint)(((thread >> 6) ^ (thread >> 12)) % kMaxMagazines);
+}
+
+void AllocatorBase::CellAllocated()
+{
+    const TUint used = ++iCellsUsed;
+    TUint usedMax = iCellsUsedMax.load(std::memory_order_relaxed);
+    while (used > usedMax && !iCellsUsedMax.compare_exchange_weak(usedMax, used, std::memory_order_relaxed)) {
+    }
+}
+
 void AllocatorBase::QueryInfo(const Brx& aQuery, IWriter& aWriter)
 {
-    // Note that value of iCellsUsed may be slightly out of date as Allocator doesn't hold any lock while updating its fifo and iCellsUsed
-    AutoMutex a(iLock);
+    // Note that value of iCellsUsed may be slightly out of date as other threads may be allocating/freeing concurrently
     if (aQuery == kQueryMemory) {
         WriterAscii writer(aWriter);
         writer.Write(Brn("Allocator: "));
@@ -146,10 +427,17 @@ void AllocatorBase::QueryInfo(const Brx& aQuery, IWriter& aWriter)
         writer.Write(Brn(" cells x "));
         writer.WriteUint(iCellBytes);
         writer.Write(Brn(" bytes, in use:"));
-        writer.WriteUint(iCellsUsed);
+        writer.WriteUint(iCellsUsed.load());
         writer.Write(Brn(" cells, peak:"));
-        writer.WriteUint(iCellsUsedMax);
-        aWriter.Write(Brn(" cells\n"));
+        writer.WriteUint(iCellsUsedMax.load());
+        const TUint reserved = iCellsReserved.load();
+        writer.Write(Brn(" cells, reserved:"));
+        writer.WriteUint(reserved);
+        writer.Write(Brn(" cells ("));
+        writer.WriteUint(reserved * iCellBytes);
+        writer.Write(Brn(" bytes), startup:"));
+        writer.WriteUint((TUint)iReserveUs);
+        aWriter.Write(Brn("us\n"));
     }
 }
 
@@ -171,6 +459,11 @@ void Allocated::RemoveRef()
     }
 }
 
+TBool Allocated::IsShared() const
+{
+    return iRefCount.load() > 1;
+}
+
 void Allocated::Clear()
 {
 }
@@ -178,6 +471,7 @@ void Allocated::Clear()
 Allocated::Allocated(AllocatorBase& aAllocator)
     : iAllocator(aAllocator)
     , iRefCount(0)
+    , iCellIndex(0)
 {
     ASSERT(iRefCount.is_lock_free());
 }
@@ -344,6 +638,13 @@ void DecodedAudio::SetBytes(TUint aBytes)
     iData.SetBytes(aBytes);
 }
 
+DecodedAudio* DecodedAudio::AllocateScratch()
+{
+    auto scratch = static_cast<DecodedAudio*>(static_cast<Allocator<AudioData>&>(iAllocator).Allocate());
+    scratch->Construct();
+    return scratch;
+}
+
 void DecodedAudio::ConstructPcm(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian)
 {
     ASSERT((aBitDepth & 7) == 0);
@@ -353,13 +654,13 @@ void DecodedAudio::ConstructPcm(const Brx& aData, TUint aBitDepth, AudioDataEndi
         (void)memcpy(ptr, aData.Ptr(), aData.Bytes());
     }
     else if (aBitDepth == 16) {
-        CopyToBigEndian16(aData, ptr);
+        ByteSwap::ToBigEndian16(aData.Ptr(), ptr, aData.Bytes());
     }
     else if (aBitDepth == 24) {
-        CopyToBigEndian24(aData, ptr);
+        ByteSwap::ToBigEndian24(aData.Ptr(), ptr, aData.Bytes());
     }
     else if (aBitDepth == 32) {
-        CopyToBigEndian32(aData, ptr);
+        ByteSwap::ToBigEndian32(aData.Ptr(), ptr, aData.Bytes());
     }
     else { // unsupported bit depth
         ASSERTS();
@@ -377,36 +678,6 @@ void DecodedAudio::Construct()
     iData.Replace(Brx::Empty());
 }
 
-void DecodedAudio::CopyToBigEndian16(const Brx& aData, TByte* aDest)
-{ // static
-    const TByte* src = aData.Ptr();
-    for (TUint i=0; i<aData.Bytes(); i+=2) {
-        *aDest++ = src[i+1];
-        *aDest++ = src[i];
-    }
-}
-
-void DecodedAudio::CopyToBigEndian24(const Brx& aData, TByte* aDest)
-{ // static
-    const TByte* src = aData.Ptr();
-    for (TUint i=0; i<aData.Bytes(); i+=3) {
-        *aDest++ = src[i+2];
-        *aDest++ = src[i+1];
-        *aDest++ = src[i];
-    }
-}
-
-void DecodedAudio::CopyToBigEndian32(const Brx& aData, TByte* aDest)
-{ // static
-    const TByte* src = aData.Ptr();
-    for (TUint i=0; i<aData.Bytes(); i+=4) {
-        *aDest++ = src[i+3];
-        *aDest++ = src[i+2];
-        *aDest++ = src[i+1];
-        *aDest++ = src[i];
-    }
-}
-
 
 // Jiffies
 
@@ -547,6 +818,7 @@ TUint Jiffies::SongcastTicksPerSecond(TUint aSampleRate)
 
 Msg::Msg(AllocatorBase& aAllocator)
     : Allocated(aAllocator)
+    , iIsAudioPcm(false)
     , iNextMsg(nullptr)
 {
 }
@@ -820,9 +1092,7 @@ TUint RampApplicator::Start(const Brx& aData, TUint aBitDepth, TUint aNumChannel
 void RampApplicator::GetNextSample(TByte* aDest)
 {
     ASSERT_DEBUG(iPtr != nullptr);
-    const TUint16 ramp = (iNumSamples==1? (TUint16)iRamp.Start() : (TUint16)(iRamp.Start() - ((iLoopCount * iTotalRamp)/(iNumSamples-1))));
-    //Log::Print(" %04x ", ramp);
-    const TUint rampIndex = std::min(kRampArrayCount-1, (kFullRampSpan - ramp + (1<<4)) >> 5); // assumes fullRampSpan==2^14 and kRampArray has 512 (2^9) items. (1<<4 allows rounding up)
+    const TUint rampIndex = RampIndex(iLoopCount);
     for (TUint i=0; i<iNumChannels; i++) {
         TInt16 subsample16 = 0;
         switch (iBitDepth)
@@ -886,6 +1156,53 @@ void RampApplicator::GetNextSample(TByte* aDest)
     iLoopCount++;
 }
 
+TUint RampApplicator::Apply(const Brx& aData, TByte* aDest, TUint aBitDepth, TUint aNumChannels)
+{
+    return Apply(aData, aDest, aBitDepth, aNumChannels, PcmGain::kUnity);
+}
+
+TUint RampApplicator::Apply(const Brx& aData, TByte* aDest, TUint aBitDepth, TUint aNumChannels, TUint aGain)
+{
+    const TUint numSamples = Start(aData, aBitDepth, aNumChannels);
+    const TUint bytesPerSample = (aBitDepth/8) * aNumChannels;
+    const TByte* src = aData.Ptr();
+    TByte* dest = aDest;
+    TUint gains[kGainBlockSamples];
+    while (iLoopCount < iNumSamples) {
+        const TUint count = std::min(kGainBlockSamples, (TUint)(iNumSamples - iLoopCount));
+        if (aGain == PcmGain::kUnity) {
+            for (TUint i=0; i<count; i++) {
+                gains[i] = kRampArray[RampIndex(iLoopCount++)];
+            }
+        }
+        else {
+            for (TUint i=0; i<count; i++) {
+                gains[i] = (kRampArray[RampIndex(iLoopCount++)] * aGain) >> PcmGain::kShift;
+            }
+        }
+        PcmGain::Apply(src, dest, count, aBitDepth, aNumChannels, gains);
+        src += count * bytesPerSample;
+        dest += count * bytesPerSample;
+    }
+    if (aBitDepth == 32 && aNumChannels == 6) {
+        // set channel id for efficiency on 6channel 192k
+        TByte* ptr = aDest + 3;
+        for (TUint i=0; i<numSamples; i++) {
+            for (TUint ch=0; ch<aNumChannels; ch++) {
+                *ptr = (TByte)(ch << 4);
+                ptr += 4;
+            }
+        }
+    }
+    return numSamples;
+}
+
+TUint RampApplicator::RampIndex(TInt aSampleIndex) const
+{
+    const TUint16 ramp = (iNumSamples==1? (TUint16)iRamp.Start() : (TUint16)(iRamp.Start() - ((aSampleIndex * iTotalRamp)/(iNumSamples-1))));
+    return std::min(kRampArrayCount-1, (kFullRampSpan - ramp + (1<<4)) >> 5); // assumes fullRampSpan==2^14 and kRampArray has 512 (2^9) items. (1<<4 allows rounding up)
+}
+
 TUint RampApplicator::MedianMultiplier(const Media::Ramp& aRamp)
 { // static
     TUint medRamp;
@@ -908,6 +1225,69 @@ TUint RampApplicator::MedianMultiplier(const Media::Ramp& aRamp)
 }
 
 
+// PcmGainStats
+
+const Brn PcmGainStats::kQueryDsp("dsp");
+
+PcmGainStats::PcmGainStats(IInfoAggregator& aInfoAggregator)
+    : iCount(0)
+    , iBytes(0)
+    , iTimedBytes(0)
+    , iDurationUs(0)
+{
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryDsp);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+TBool PcmGainStats::ShouldTime()
+{
+    return (iCount.fetch_add(1, std::memory_order_relaxed) % kTimingInterval) == 0;
+}
+
+void PcmGainStats::Add(TUint aBytes)
+{
+    iBytes.fetch_add(aBytes, std::memory_order_relaxed);
+}
+
+void PcmGainStats::AddTimed(TUint aBytes, TUint64 aDurationUs)
+{
+    iBytes.fetch_add(aBytes, std::memory_order_relaxed);
+    iTimedBytes.fetch_add(aBytes, std::memory_order_relaxed);
+    iDurationUs.fetch_add(aDurationUs, std::memory_order_relaxed);
+}
+
+TUint64 PcmGainStats::Bytes() const
+{
+    return iBytes.load();
+}
+
+TUint64 PcmGainStats::BytesPerSecond() const
+{
+    const TUint64 us = iDurationUs.load();
+    if (us == 0) {
+        return 0;
+    }
+    return (iTimedBytes.load() * 1000000) / us;
+}
+
+void PcmGainStats::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    if (aQuery == kQueryDsp) {
+        WriterAscii writer(aWriter);
+        writer.Write(Brn("PcmGain: processed:"));
+        writer.WriteUint64(Bytes());
+        writer.Write(Brn(" bytes (sampled "));
+        writer.WriteUint64(iTimedBytes.load());
+        writer.Write(Brn(" bytes in "));
+        writer.WriteUint64(iDurationUs.load());
+        writer.Write(Brn("us, "));
+        writer.WriteUint64(BytesPerSecond());
+        aWriter.Write(Brn(" bytes/s)\n"));
+    }
+}
+
+
 // Track
 
 Track::Track(AllocatorBase& aAllocator)
@@ -1621,6 +2001,24 @@ TUint MsgAudioEncoded::Append(const Brx& aData, TUint aMaxBytes)
     return consumed;
 }
 
+TByte* MsgAudioEncoded::AppendSpace(TUint aMaxBytes, TUint& aBytes)
+{
+    ASSERT(iNextAudio == nullptr);
+    ASSERT(aMaxBytes <= EncodedAudio::kMaxBytes);
+    const TUint used = iAudioData->Bytes();
+    aBytes = (used >= aMaxBytes? 0 : aMaxBytes - used);
+    return iAudioData->PtrW() + used;
+}
+
+void MsgAudioEncoded::AppendInPlace(TUint aBytes)
+{
+    ASSERT(iNextAudio == nullptr);
+    const TUint bytes = iAudioData->Bytes() + aBytes;
+    ASSERT(bytes <= EncodedAudio::kMaxBytes);
+    iAudioData->SetBytes(bytes);
+    iSize += aBytes;
+}
+
 TUint MsgAudioEncoded::Bytes() const
 {
     TUint bytes = iSize;
@@ -2226,6 +2624,7 @@ const TUint MsgAudioPcm::kUnityAttenuation = 256;
 MsgAudioPcm::MsgAudioPcm(AllocatorBase& aAllocator)
     : MsgAudioDecoded(aAllocator)
 {
+    iIsAudioPcm = true;
 }
 
 MsgAudio* MsgAudioPcm::Clone()
@@ -2233,6 +2632,7 @@ MsgAudio* MsgAudioPcm::Clone()
     MsgAudioPcm* clone = static_cast<MsgAudioPcm*>(MsgAudioDecoded::Clone());
     clone->iAllocatorPlayablePcm = iAllocatorPlayablePcm;
     clone->iAttenuation = iAttenuation;
+    clone->iGainStats = iGainStats;
     return clone;
 }
 
@@ -2251,7 +2651,7 @@ MsgPlayable* MsgAudioPcm::CreatePlayable()
         auto playablePcm = iAllocatorPlayablePcm->Allocate();
         Optional<IPipelineBufferObserver> bufferObserver(iPipelineBufferObserver);
         playablePcm->Initialise(iAudioData, sizeBytes, iSampleRate, iBitDepth, iNumChannels,
-                                offsetBytes, iAttenuation, iRamp, bufferObserver);
+                                offsetBytes, iAttenuation, iRamp, bufferObserver, *iGainStats);
         playable = playablePcm;
     }
     else {
@@ -2268,7 +2668,8 @@ MsgPlayable* MsgAudioPcm::CreatePlayable()
 
 void MsgAudioPcm::Initialise(DecodedAudio* aDecodedAudio, TUint aSampleRate, TUint aBitDepth, TUint aChannels, TUint64 aTrackOffset,
                              Allocator<MsgPlayablePcm>& aAllocatorPlayablePcm,
-                             Allocator<MsgPlayableSilence>& aAllocatorPlayableSilence)
+                             Allocator<MsgPlayableSilence>& aAllocatorPlayableSilence,
+                             PcmGainStats& aGainStats)
 {
     const TUint bytes = aDecodedAudio->Bytes();
     const TUint byteDepth = aBitDepth / 8;
@@ -2278,6 +2679,7 @@ void MsgAudioPcm::Initialise(DecodedAudio* aDecodedAudio, TUint aSampleRate, TUi
                                 aTrackOffset, numSubsamples, aAllocatorPlayableSilence);
     iAllocatorPlayablePcm = &aAllocatorPlayablePcm;
     iAttenuation = MsgAudioPcm::kUnityAttenuation;
+    iGainStats = &aGainStats;
 }
 
 void MsgAudioPcm::SplitCompleted(MsgAudio& aRemaining)
@@ -2286,6 +2688,7 @@ void MsgAudioPcm::SplitCompleted(MsgAudio& aRemaining)
     MsgAudioPcm& remaining = static_cast<MsgAudioPcm&>(aRemaining);
     remaining.iAllocatorPlayablePcm = iAllocatorPlayablePcm;
     remaining.iAttenuation = iAttenuation;
+    remaining.iGainStats = iGainStats;
 }
 
 MsgAudio* MsgAudioPcm::Allocate()
@@ -2297,6 +2700,7 @@ void MsgAudioPcm::Clear()
 {
     MsgAudioDecoded::Clear();
     iAttenuation = MsgAudioPcm::kUnityAttenuation;
+    iGainStats = nullptr;
 }
 
 Msg* MsgAudioPcm::Process(IMsgProcessor& aProcessor)
@@ -2751,65 +3155,60 @@ MsgPlayablePcm::MsgPlayablePcm(AllocatorBase& aAllocator)
 
 void MsgPlayablePcm::Initialise(DecodedAudio* aDecodedAudio, TUint aSizeBytes, TUint aSampleRate, TUint aBitDepth,
                                 TUint aNumChannels, TUint aOffsetBytes, TUint aAttenuation, const Media::Ramp& aRamp,
-                                Optional<IPipelineBufferObserver> aPipelineBufferObserver)
+                                Optional<IPipelineBufferObserver> aPipelineBufferObserver, PcmGainStats& aGainStats)
 {
     MsgPlayable::Initialise(aSizeBytes, aSampleRate, aBitDepth, aNumChannels,
                             aOffsetBytes, aRamp, aPipelineBufferObserver);
     iAudioData = aDecodedAudio;
     iAudioData->AddRef();
     iAttenuation = aAttenuation;
-}
-
-void MsgPlayablePcm::ApplyAttenuation(Bwx& aData)
-{
-    if (iAttenuation == MsgAudioPcm::kUnityAttenuation) {
-        return;
-    }
-    ASSERT(iBitDepth == 16);
-    TByte* ptr = (TByte*)aData.Ptr();
-    const TUint samples = aData.Bytes() / 2;
-    for (TUint sampleIndex = 0; sampleIndex < samples; sampleIndex++) {
-        TInt16 sample = *ptr << 8;
-        sample += *(ptr + 1);
-        TInt16 attenuatedSample = (TInt16)(((TInt)sample) * iAttenuation / MsgAudioPcm::kUnityAttenuation);
-        *ptr++ = (TByte)(attenuatedSample >> 8);
-        *ptr++ = (TByte)attenuatedSample;
-    }
+    iGainStats = &aGainStats;
 }
 
 void MsgPlayablePcm::ReadBlock(IPcmProcessor& aProcessor)
 {
     Bwn audioBuf(iAudioData->Ptr(iOffset), iSize, iSize);
-    ApplyAttenuation(audioBuf);
-
     const TUint numChannels = iNumChannels;
     const TUint bitDepth = iBitDepth;
     const TUint subsampleBytes = bitDepth / 8;
+    const TBool attenuate = (iAttenuation != MsgAudioPcm::kUnityAttenuation);
+    if (!iRamp.IsEnabled() && !attenuate) {
+        aProcessor.ProcessFragment(audioBuf, numChannels, subsampleBytes);
+        return;
+    }
+
+    /* Attenuation and ramp are combined into a single gain per sample so audio is only traversed once.
+       Apply gain in place if this msg holds the only reference to iAudioData.  Otherwise, other msgs
+       (e.g. the remainder of a split, or a clone held by StarvationRamper) still need the
+       unmodified audio so write into a scratch buffer from the same pool.  Either way, the whole
+       msg is passed on as a single fragment. */
+    const TUint gain = (iAttenuation * PcmGain::kUnity) / MsgAudioPcm::kUnityAttenuation;
+    DecodedAudio* scratch = nullptr;
+    TByte* dest = const_cast<TByte*>(audioBuf.Ptr());
+    if (iAudioData->IsShared()) {
+        scratch = iAudioData->AllocateScratch();
+        dest = scratch->PtrW();
+    }
+    const TBool timed = iGainStats->ShouldTime();
+    const TUint64 start = (timed? Os::TimeInUs(gEnv->OsCtx()) : 0);
     if (iRamp.IsEnabled()) {
-        Bws<256> rampedBuf;
         RampApplicator ra(iRamp);
-        const TUint numSamples = ra.Start(audioBuf, bitDepth, numChannels);
-        const TUint bytesPerSample = subsampleBytes * numChannels;
-        const TUint samplesPerFragment = rampedBuf.MaxBytes() / bytesPerSample;
-        TByte* ptr = (TByte*)rampedBuf.Ptr();
-        TUint fragmentSamples = 0;
-        for (TUint i=0; i<numSamples; i++) {
-            ra.GetNextSample(ptr);
-
-            fragmentSamples++;
-            ptr += bytesPerSample;
-            if (fragmentSamples == samplesPerFragment || i == numSamples-1) {
-                rampedBuf.SetBytes(fragmentSamples * bytesPerSample);
-                aProcessor.ProcessFragment(rampedBuf, numChannels, subsampleBytes);
-                ptr = (TByte*)rampedBuf.Ptr();
-                fragmentSamples = 0;
-            }
-        }
+        (void)ra.Apply(audioBuf, dest, bitDepth, numChannels, gain);
     }
     else {
-        aProcessor.ProcessFragment(audioBuf, numChannels, subsampleBytes);
+        PcmGain::ApplyConstant(audioBuf.Ptr(), dest, iSize / subsampleBytes, bitDepth, gain);
+    }
+    if (timed) {
+        iGainStats->AddTimed(iSize, Os::TimeInUs(gEnv->OsCtx()) - start);
+    }
+    else {
+        iGainStats->Add(iSize);
+    }
+    Brn processed(dest, iSize);
+    aProcessor.ProcessFragment(processed, numChannels, subsampleBytes);
+    if (scratch != nullptr) {
+        scratch->RemoveRef();
     }
-
 }
 
 TBool MsgPlayablePcm::TryLogTimestamps()
@@ -3049,6 +3448,21 @@ void MsgQueueBase::DoEnqueueAtHead(Msg* aMsg)
     iNumMsgs++;
 }
 
+void MsgQueueBase::DoEnqueueAtHead(MsgQueueBase& aQueue)
+{
+    if (aQueue.iHead == nullptr) {
+        return;
+    }
+    aQueue.iTail->iNextMsg = iHead;
+    iHead = aQueue.iHead;
+    if (iTail == nullptr) {
+        iTail = aQueue.iTail;
+    }
+    iNumMsgs += aQueue.iNumMsgs;
+    aQueue.iHead = aQueue.iTail = nullptr;
+    aQueue.iNumMsgs = 0;
+}
+
 TBool MsgQueueBase::IsEmpty() const
 {
     const TBool empty = (iHead == nullptr);
@@ -3063,6 +3477,11 @@ void MsgQueueBase::DoClear()
     }
 }
 
+Msg* MsgQueueBase::Head() const
+{
+    return iHead;
+}
+
 TUint MsgQueueBase::NumMsgs() const
 {
     return iNumMsgs;
@@ -3110,6 +3529,28 @@ Msg* MsgQueue::Dequeue()
     return MsgQueueBase::DoDequeue();
 }
 
+void MsgQueue::DequeueBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    iSem.Wait();
+    AutoMutex _(iLock);
+    Msg* msg = MsgQueueBase::DoDequeue();
+    aQueue.Enqueue(msg);
+    if (!msg->IsAudioPcm()) {
+        return;
+    }
+    TUint jiffies = static_cast<MsgAudio*>(msg)->Jiffies();
+    while (jiffies < aMaxJiffies) {
+        msg = Head();
+        if (msg == nullptr || !msg->IsAudioPcm()) {
+            break;
+        }
+        // iSem counts queued msgs and we're the only consumer so this won't block
+        iSem.Wait();
+        aQueue.Enqueue(MsgQueueBase::DoDequeue());
+        jiffies += static_cast<MsgAudio*>(msg)->Jiffies();
+    }
+}
+
 void MsgQueue::EnqueueAtHead(Msg* aMsg)
 {
     AutoMutex _(iLock);
@@ -3117,6 +3558,16 @@ void MsgQueue::EnqueueAtHead(Msg* aMsg)
     iSem.Signal();
 }
 
+void MsgQueue::EnqueueAtHead(MsgQueueLite& aQueue)
+{
+    AutoMutex _(iLock);
+    TUint count = aQueue.NumMsgs();
+    DoEnqueueAtHead(aQueue);
+    while (count-- > 0) {
+        iSem.Signal();
+    }
+}
+
 TBool MsgQueue::IsEmpty() const
 {
     AutoMutex _(iLock);
@@ -3137,10 +3588,154 @@ TUint MsgQueue::NumMsgs() const
 }
 
 
+// MsgQueueSpsc
+
+MsgQueueSpsc::MsgQueueSpsc()
+    : iNumMsgs(0)
+    , iConsumerWaiting(false)
+    , iSem("MQSP", 0)
+    , iSpare(nullptr)
+    , iTailIndex(0)
+    , iHeadIndex(0)
+{
+    ASSERT(iNumMsgs.is_lock_free());
+    ASSERT(iConsumerWaiting.is_lock_free());
+    ASSERT(iSpare.is_lock_free());
+    iTailBlock = iHeadBlock = new Block;
+    iHeadBlock->iNext = nullptr;
+}
+
+MsgQueueSpsc::~MsgQueueSpsc()
+{
+    while (!IsEmpty()) {
+        DoDequeue()->RemoveRef();
+    }
+    while (iHeadBlock != nullptr) {
+        Block* next = iHeadBlock->iNext;
+        delete iHeadBlock;
+        iHeadBlock = next;
+    }
+    delete iSpare.load();
+}
+
+void MsgQueueSpsc::Enqueue(Msg* aMsg)
+{
+    ASSERT(aMsg != nullptr);
+    iTailBlock->iMsgs[iTailIndex] = aMsg;
+    if (++iTailIndex == kBlockMsgs) {
+        Block* block = iSpare.exchange(nullptr);
+        if (block == nullptr) {
+            block = new Block;
+        }
+        block->iNext = nullptr;
+        iTailBlock->iNext = block;
+        iTailBlock = block;
+        iTailIndex = 0;
+    }
+    (void)iNumMsgs.fetch_add(1);
+    if (iConsumerWaiting.load() && iConsumerWaiting.exchange(false)) {
+        iSem.Signal();
+    }
+}
+
+Msg* MsgQueueSpsc::Dequeue()
+{
+    WaitNotEmpty();
+    return DoDequeue();
+}
+
+void MsgQueueSpsc::DequeueBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    WaitNotEmpty();
+    Msg* msg = DoDequeue();
+    aQueue.Enqueue(msg);
+    if (!msg->IsAudioPcm()) {
+        return;
+    }
+    TUint jiffies = static_cast<MsgAudio*>(msg)->Jiffies();
+    while (jiffies < aMaxJiffies && !IsEmpty()) {
+        msg = Head();
+        if (!msg->IsAudioPcm()) {
+            break;
+        }
+        aQueue.Enqueue(DoDequeue());
+        jiffies += static_cast<MsgAudio*>(msg)->Jiffies();
+    }
+}
+
+void MsgQueueSpsc::EnqueueAtHead(Msg* aMsg)
+{
+    iRequeued.EnqueueAtHead(aMsg);
+    (void)iNumMsgs.fetch_add(1);
+}
+
+void MsgQueueSpsc::EnqueueAtHead(MsgQueueLite& aQueue)
+{
+    const TUint count = aQueue.NumMsgs();
+    iRequeued.EnqueueAtHead(aQueue);
+    (void)iNumMsgs.fetch_add(count);
+}
+
+TBool MsgQueueSpsc::IsEmpty() const
+{
+    return iNumMsgs.load() == 0;
+}
+
+TUint MsgQueueSpsc::NumMsgs() const
+{
+    return iNumMsgs.load();
+}
+
+void MsgQueueSpsc::WaitNotEmpty()
+{
+    /* loop as a producer that saw iConsumerWaiting set by an earlier call may only
+       signal after we've consumed its msg and started waiting again */
+    while (IsEmpty()) {
+        iConsumerWaiting.store(true);
+        if (IsEmpty()) {
+            iSem.Wait();
+        }
+        else if (!iConsumerWaiting.exchange(false)) {
+            // producer saw iConsumerWaiting and has signalled (or is about to) - consume that signal
+            iSem.Wait();
+        }
+    }
+}
+
+Msg* MsgQueueSpsc::Head() const
+{
+    if (!iRequeued.IsEmpty()) {
+        return iRequeued.Head();
+    }
+    return iHeadBlock->iMsgs[iHeadIndex];
+}
+
+Msg* MsgQueueSpsc::DoDequeue()
+{
+    Msg* msg;
+    if (!iRequeued.IsEmpty()) {
+        msg = iRequeued.Dequeue();
+    }
+    else {
+        msg = iHeadBlock->iMsgs[iHeadIndex];
+        if (++iHeadIndex == kBlockMsgs) {
+            // producer linked the next block before publishing the last msg in this one
+            Block* block = iHeadBlock;
+            iHeadBlock = block->iNext;
+            iHeadIndex = 0;
+            delete iSpare.exchange(block);
+        }
+    }
+    (void)iNumMsgs.fetch_sub(1);
+    return msg;
+}
+
+
 // MsgReservoir
 
-MsgReservoir::MsgReservoir()
-    : iLockEncoded("MSGR")
+MsgReservoir::MsgReservoir(ReservoirQueue aQueue)
+    : iQueueSpsc(nullptr)
+    , iDequeueBatch(nullptr)
     , iEncodedBytes(0)
     , iJiffies(0)
     , iTrackCount(0)
@@ -3151,17 +3746,23 @@ MsgReservoir::MsgReservoir()
     , iEncodedAudioCount(0)
     , iDecodedAudioCount(0)
 {
+    if (aQueue == ReservoirQueue::LockFree) {
+        iQueueSpsc = new MsgQueueSpsc();
+    }
+    ASSERT(iEncodedBytes.is_lock_free());
     ASSERT(iJiffies.is_lock_free());
     ASSERT(iTrackCount.is_lock_free());
     ASSERT(iDelayCount.is_lock_free());
     ASSERT(iEncodedStreamCount.is_lock_free());
     ASSERT(iMetaTextCount.is_lock_free());
     ASSERT(iDecodedStreamCount.is_lock_free());
+    ASSERT(iEncodedAudioCount.is_lock_free());
     ASSERT(iDecodedAudioCount.is_lock_free());
 }
 
 MsgReservoir::~MsgReservoir()
 {
+    delete iQueueSpsc;
 }
 
 void MsgReservoir::DoEnqueue(Msg* aMsg)
@@ -3169,25 +3770,73 @@ void MsgReservoir::DoEnqueue(Msg* aMsg)
     ASSERT(aMsg != nullptr);
     ProcessorQueueIn procIn(*this);
     Msg* msg = aMsg->Process(procIn);
-    iQueue.Enqueue(msg);
+    if (iQueueSpsc != nullptr) {
+        iQueueSpsc->Enqueue(msg);
+    }
+    else {
+        iQueue.Enqueue(msg);
+    }
 }
 
 Msg* MsgReservoir::DoDequeue(TBool aAllowNull)
 {
     Msg* msg;
     do {
-        msg = iQueue.Dequeue();
+        msg = (iQueueSpsc != nullptr? iQueueSpsc->Dequeue() : iQueue.Dequeue());
         ProcessorQueueOut procOut(*this);
         msg = msg->Process(procOut);
     } while (!aAllowNull && msg == nullptr);
     return msg;
 }
 
+TUint MsgReservoir::DoDequeueBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    MsgQueueLite batch;
+    if (iQueueSpsc != nullptr) {
+        iQueueSpsc->DequeueBatch(batch, aMaxJiffies);
+    }
+    else {
+        iQueue.DequeueBatch(batch, aMaxJiffies);
+    }
+    iDequeueBatch = &batch; // any msgs ProcessMsgOut() puts back must precede the rest of the batch
+    ProcessorQueueOut procOut(*this);
+    TUint count = 0;
+    for (;;) {
+        Msg* msg = batch.Dequeue()->Process(procOut);
+        if (msg != nullptr) {
+            aQueue.Enqueue(msg);
+            count++;
+        }
+        if (batch.IsEmpty()) {
+            break;
+        }
+        if (!ContinueDequeueBatch()) {
+            if (iQueueSpsc != nullptr) {
+                iQueueSpsc->EnqueueAtHead(batch);
+            }
+            else {
+                iQueue.EnqueueAtHead(batch);
+            }
+            break;
+        }
+    }
+    iDequeueBatch = nullptr;
+    return count;
+}
+
 void MsgReservoir::EnqueueAtHead(Msg* aMsg)
 {
     ProcessorEnqueue proc(*this);
     Msg* msg = aMsg->Process(proc);
-    iQueue.EnqueueAtHead(msg);
+    if (iDequeueBatch != nullptr) {
+        iDequeueBatch->EnqueueAtHead(msg);
+    }
+    else if (iQueueSpsc != nullptr) {
+        iQueueSpsc->EnqueueAtHead(msg);
+    }
+    else {
+        iQueue.EnqueueAtHead(msg);
+    }
 }
 
 TUint MsgReservoir::Jiffies() const
@@ -3197,12 +3846,14 @@ TUint MsgReservoir::Jiffies() const
 
 TUint MsgReservoir::EncodedBytes() const
 {
-    AutoMutex _(iLockEncoded);
     return iEncodedBytes;
 }
 
 TBool MsgReservoir::IsEmpty() const
 {
+    if (iQueueSpsc != nullptr) {
+        return iQueueSpsc->IsEmpty();
+    }
     return iQueue.IsEmpty();
 }
 
@@ -3233,7 +3884,6 @@ TUint MsgReservoir::DecodedStreamCount() const
 
 TUint MsgReservoir::EncodedAudioCount() const
 {
-    AutoMutex _(iLockEncoded);
     return iEncodedAudioCount;
 }
 
@@ -3244,9 +3894,17 @@ TUint MsgReservoir::DecodedAudioCount() const
 
 TUint MsgReservoir::NumMsgs() const
 {
+    if (iQueueSpsc != nullptr) {
+        return iQueueSpsc->NumMsgs();
+    }
     return iQueue.NumMsgs();
 }
 
+TBool MsgReservoir::ContinueDequeueBatch() const
+{
+    return true;
+}
+
 void MsgReservoir::ProcessMsgIn(MsgMode* /*aMsg*/)              { }
 void MsgReservoir::ProcessMsgIn(MsgTrack* /*aMsg*/)             { }
 void MsgReservoir::ProcessMsgIn(MsgDrain* /*aMsg*/)             { }
@@ -3321,7 +3979,6 @@ Msg* MsgReservoir::ProcessorEnqueue::ProcessMsg(MsgStreamSegment* aMsg)
 
 Msg* MsgReservoir::ProcessorEnqueue::ProcessMsg(MsgAudioEncoded* aMsg)
 {
-    AutoMutex _(iQueue.iLockEncoded);
     iQueue.iEncodedAudioCount++;
     iQueue.iEncodedBytes += aMsg->Bytes();
     return aMsg;
@@ -3554,11 +4211,8 @@ Msg* MsgReservoir::ProcessorQueueOut::ProcessMsg(MsgStreamSegment* aMsg)
 
 Msg* MsgReservoir::ProcessorQueueOut::ProcessMsg(MsgAudioEncoded* aMsg)
 {
-    {
-        AutoMutex _(iQueue.iLockEncoded);
-        iQueue.iEncodedAudioCount--;
-        iQueue.iEncodedBytes -= aMsg->Bytes();
-    }
+    iQueue.iEncodedAudioCount--;
+    iQueue.iEncodedBytes -= aMsg->Bytes();
     return iQueue.ProcessMsgOut(aMsg);
 }
 
@@ -3636,6 +4290,71 @@ Msg* MsgReservoir::ProcessorQueueOut::ProcessMsg(MsgQuit* aMsg)
 }
 
 
+// IPipelineElementUpstream
+
+void IPipelineElementUpstream::PullBatch(MsgQueueLite& aQueue, TUint /*aMaxJiffies*/)
+{
+    aQueue.Enqueue(Pull());
+}
+
+
+// BatchingUpstream
+
+BatchingUpstream::BatchingUpstream(IPipelineElementUpstream& aUpstream)
+    : iUpstream(aUpstream)
+{
+}
+
+BatchingUpstream::~BatchingUpstream()
+{
+    iReturned.Clear();
+}
+
+void BatchingUpstream::PullBatch(IPipelineElementUpstream& aElement, IPipelineElementBypassable& aBypassable,
+                                 IPipelineElementUpstream& aSource, MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    MsgQueueLite batch;
+    while (aBypassable.BypassPull()) {
+        aSource.PullBatch(batch, aMaxJiffies);
+        TBool appended = false;
+        while (!batch.IsEmpty()) {
+            Msg* msg = aBypassable.ProcessBypassed(batch.Dequeue());
+            if (msg != nullptr) {
+                aQueue.Enqueue(msg);
+                appended = true;
+            }
+            if (!batch.IsEmpty() && !aBypassable.BypassPull()) {
+                iReturned.EnqueueAtHead(batch);
+            }
+        }
+        if (appended) {
+            return;
+        }
+    }
+    aQueue.Enqueue(aElement.Pull());
+}
+
+Msg* BatchingUpstream::Pull()
+{
+    if (!iReturned.IsEmpty()) {
+        return iReturned.Dequeue();
+    }
+    return iUpstream.Pull();
+}
+
+void BatchingUpstream::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    if (iReturned.IsEmpty()) {
+        iUpstream.PullBatch(aQueue, aMaxJiffies);
+    }
+    else {
+        while (!iReturned.IsEmpty()) {
+            aQueue.Enqueue(iReturned.Dequeue());
+        }
+    }
+}
+
+
 // PipelineElement
 
 PipelineElement::PipelineElement(TUint aSupportedTypes)
@@ -3815,30 +4534,31 @@ Track* TrackFactory::CreateNullTrack()
 // MsgFactory
 
 MsgFactory::MsgFactory(IInfoAggregator& aInfoAggregator, const MsgFactoryInitParams& aInitParams)
-    : iAllocatorMsgMode("MsgMode", aInitParams.iMsgModeCount, aInfoAggregator)
-    , iAllocatorMsgTrack("MsgTrack", aInitParams.iMsgTrackCount, aInfoAggregator)
-    , iAllocatorMsgDrain("MsgDrain", aInitParams.iMsgDrainCount, aInfoAggregator)
+    : iAllocatorMsgMode("MsgMode", aInitParams.iMsgModeCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgTrack("MsgTrack", aInitParams.iMsgTrackCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgDrain("MsgDrain", aInitParams.iMsgDrainCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
     , iDrainId(0)
-    , iAllocatorMsgDelay("MsgDelay", aInitParams.iMsgDelayCount, aInfoAggregator)
-    , iAllocatorMsgEncodedStream("MsgEncodedStream", aInitParams.iMsgEncodedStreamCount, aInfoAggregator)
-    , iAllocatorMsgStreamSegment("MsgStreamSegment", aInitParams.iMsgStreamSegmentCount, aInfoAggregator)
-    , iAllocatorAudioData("AudioData", aInitParams.iEncodedAudioCount + aInitParams.iDecodedAudioCount, aInfoAggregator)
-    , iAllocatorMsgAudioEncoded("MsgAudioEncoded", aInitParams.iMsgAudioEncodedCount, aInfoAggregator)
-    , iAllocatorMsgMetaText("MsgMetaText", aInitParams.iMsgMetaTextCount, aInfoAggregator)
-    , iAllocatorMsgStreamInterrupted("MsgStreamInterrupted", aInitParams.iMsgStreamInterruptedCount, aInfoAggregator)
-    , iAllocatorMsgHalt("MsgHalt", aInitParams.iMsgHaltCount, aInfoAggregator)
-    , iAllocatorMsgFlush("MsgFlush", aInitParams.iMsgFlushCount, aInfoAggregator)
-    , iAllocatorMsgWait("MsgWait", aInitParams.iMsgWaitCount, aInfoAggregator)
-    , iAllocatorMsgDecodedStream("MsgDecodedStream", aInitParams.iMsgDecodedStreamCount, aInfoAggregator)
-    , iAllocatorMsgBitRate("MsgBitRate", aInitParams.iMsgBitRateCount, aInfoAggregator)
-    , iAllocatorMsgAudioPcm("MsgAudioPcm", aInitParams.iMsgAudioPcmCount, aInfoAggregator)
-    , iAllocatorMsgAudioDsd("MsgAudioDsd", aInitParams.iMsgAudioDsdCount, aInfoAggregator)
-    , iAllocatorMsgSilence("MsgSilence", aInitParams.iMsgSilenceCount, aInfoAggregator)
-    , iAllocatorMsgPlayablePcm("MsgPlayablePcm", aInitParams.iMsgPlayablePcmCount, aInfoAggregator)
-    , iAllocatorMsgPlayableDsd("MsgPlayableDsd", aInitParams.iMsgPlayableDsdCount, aInfoAggregator)
-    , iAllocatorMsgPlayableSilence("MsgPlayableSilence", aInitParams.iMsgPlayableSilenceCount, aInfoAggregator)
-    , iAllocatorMsgPlayableSilenceDsd("MsgPlayableSilenceDsd", aInitParams.iMsgPlayableSilenceCount, aInfoAggregator)
-    , iAllocatorMsgQuit("MsgQuit", aInitParams.iMsgQuitCount, aInfoAggregator)
+    , iAllocatorMsgDelay("MsgDelay", aInitParams.iMsgDelayCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgEncodedStream("MsgEncodedStream", aInitParams.iMsgEncodedStreamCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgStreamSegment("MsgStreamSegment", aInitParams.iMsgStreamSegmentCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorAudioData("AudioData", aInitParams.iEncodedAudioCount + aInitParams.iDecodedAudioCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgAudioEncoded("MsgAudioEncoded", aInitParams.iMsgAudioEncodedCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgMetaText("MsgMetaText", aInitParams.iMsgMetaTextCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgStreamInterrupted("MsgStreamInterrupted", aInitParams.iMsgStreamInterruptedCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgHalt("MsgHalt", aInitParams.iMsgHaltCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgFlush("MsgFlush", aInitParams.iMsgFlushCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgWait("MsgWait", aInitParams.iMsgWaitCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgDecodedStream("MsgDecodedStream", aInitParams.iMsgDecodedStreamCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgBitRate("MsgBitRate", aInitParams.iMsgBitRateCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgAudioPcm("MsgAudioPcm", aInitParams.iMsgAudioPcmCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgAudioDsd("MsgAudioDsd", aInitParams.iMsgAudioDsdCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgSilence("MsgSilence", aInitParams.iMsgSilenceCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgPlayablePcm("MsgPlayablePcm", aInitParams.iMsgPlayablePcmCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgPlayableDsd("MsgPlayableDsd", aInitParams.iMsgPlayableDsdCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgPlayableSilence("MsgPlayableSilence", aInitParams.iMsgPlayableSilenceCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgPlayableSilenceDsd("MsgPlayableSilenceDsd", aInitParams.iMsgPlayableSilenceCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iAllocatorMsgQuit("MsgQuit", aInitParams.iMsgQuitCount, aInfoAggregator, aInitParams.iAllocatorMode, aInitParams.iAllocatorReserve)
+    , iPcmGainStats(aInfoAggregator)
 {
 }
 
@@ -4080,6 +4800,38 @@ DecodedAudio* MsgFactory::CreateDecodedAudio()
     return static_cast<DecodedAudio*>(iAllocatorAudioData.Allocate());
 }
 
+const PcmGainStats& MsgFactory::GainStats() const
+{
+    return iPcmGainStats;
+}
+
+void MsgFactory::GetAllocators(std::vector<const AllocatorBase*>& aAllocators) const
+{
+    aAllocators.push_back(&iAllocatorMsgMode);
+    aAllocators.push_back(&iAllocatorMsgTrack);
+    aAllocators.push_back(&iAllocatorMsgDrain);
+    aAllocators.push_back(&iAllocatorMsgDelay);
+    aAllocators.push_back(&iAllocatorMsgEncodedStream);
+    aAllocators.push_back(&iAllocatorMsgStreamSegment);
+    aAllocators.push_back(&iAllocatorAudioData);
+    aAllocators.push_back(&iAllocatorMsgAudioEncoded);
+    aAllocators.push_back(&iAllocatorMsgMetaText);
+    aAllocators.push_back(&iAllocatorMsgStreamInterrupted);
+    aAllocators.push_back(&iAllocatorMsgHalt);
+    aAllocators.push_back(&iAllocatorMsgFlush);
+    aAllocators.push_back(&iAllocatorMsgWait);
+    aAllocators.push_back(&iAllocatorMsgDecodedStream);
+    aAllocators.push_back(&iAllocatorMsgBitRate);
+    aAllocators.push_back(&iAllocatorMsgAudioPcm);
+    aAllocators.push_back(&iAllocatorMsgAudioDsd);
+    aAllocators.push_back(&iAllocatorMsgSilence);
+    aAllocators.push_back(&iAllocatorMsgPlayablePcm);
+    aAllocators.push_back(&iAllocatorMsgPlayableDsd);
+    aAllocators.push_back(&iAllocatorMsgPlayableSilence);
+    aAllocators.push_back(&iAllocatorMsgPlayableSilenceDsd);
+    aAllocators.push_back(&iAllocatorMsgQuit);
+}
+
 EncodedAudio* MsgFactory::CreateEncodedAudio(const Brx& aData)
 {
     EncodedAudio* encodedAudio = static_cast<EncodedAudio*>(iAllocatorAudioData.Allocate());
@@ -4099,7 +4851,7 @@ MsgAudioPcm* MsgFactory::CreateMsgAudioPcm(DecodedAudio* aAudioData, TUint aChan
     MsgAudioPcm* msg = iAllocatorMsgAudioPcm.Allocate();
     try {
         msg->Initialise(aAudioData, aSampleRate, aBitDepth, aChannels, aTrackOffset,
-                        iAllocatorMsgPlayablePcm, iAllocatorMsgPlayableSilence);
+                        iAllocatorMsgPlayablePcm, iAllocatorMsgPlayableSilence, iPcmGainStats);
     }
     catch (AssertionFailed&) { // test code helper
         msg->RemoveRef();
@@ -13,6 +13,8 @@
 
 #include <limits.h>
 #include <atomic>
+#include <new>
+#include <vector>
 
 EXCEPTION(SampleRateInvalid);
 EXCEPTION(SampleRateUnsupported);
@@ -26,10 +28,24 @@ namespace Media {
 
 class Allocated;
 
+enum class AllocatorMode
+{
+    Locked,     // single mutex-protected free list
+    LockFree    // per-thread magazines backed by a shared lock-free stack
+};
+
+enum class AllocatorReserve
+{
+    Full,           // all cells constructed up front
+    Lazy,           // cells constructed in slabs on demand; cell count is a limit rather than a reservation
+    LazyReleaseIdle // as Lazy, also returning slabs to the heap once all their cells are free
+                    // (AllocatorMode::LockFree pools never release slabs)
+};
+
 class AllocatorBase : private IInfoProvider
 {
 public:
-    ~AllocatorBase();
+    virtual ~AllocatorBase();
     void Free(Allocated* aPtr);
     TUint CellsTotal() const;
     TUint CellBytes() const;
@@ -37,39 +53,89 @@ public:
     TUint CellsUsedMax() const;
     void GetStats(TUint& aCellsTotal, TUint& aCellBytes, TUint& aCellsUsed, TUint& aCellsUsedMax) const;
     inline const TChar* Name() const;
+    TUint CellsReserved() const;
+    inline AllocatorMode Mode() const;
     static const Brn kQueryMemory;
 protected:
-    AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator);
+    AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator,
+                  AllocatorMode aMode, AllocatorReserve aReserve);
+    void Reserve();
     Allocated* DoAllocate();
 private:
+    virtual Allocated* ConstructCell(void* aMem) = 0;
     Allocated* Read();
+    void AddSlab();
+    void ReleaseSlab(TUint aSlab);
+    TUint SlabCellCount(TUint aSlab) const;
+    Allocated* DoAllocateLockFree();
+    TUint GrowLockFree();
+    void FreeLockFree(Allocated* aPtr);
+    void PushShared(TUint aIndex);
+    TUint PopShared();
+    TUint StealCell();
+    TUint MagazineIndex() const;
+    void CellAllocated();
 private: // from IInfoProvider
     void QueryInfo(const Brx& aQuery, IWriter& aWriter);
-protected:
-    FifoLiteDynamic<Allocated*> iFree;
 private:
+    static const TUint kMaxMagazines = 16;
+    static const TUint kMagazineCellsMax = 14; // Magazine then fills a 64 byte cache line
+    static const TUint kCellNone = 0xffffffff;
+    static const TUint kSlabBytes = 64 * 1024;
+    class Magazine
+    {
+        static const TUint kMaxSpins = 64;
+        static const TUint kSleepMs = 1;
+    public:
+        Magazine();
+        TBool TryLock();
+        void Lock();
+        void Unlock();
+    public:
+        TUint iCount;
+        TUint iCells[kMagazineCellsMax];
+    private:
+        std::atomic<TBool> iBusy;
+    };
+private:
+    FifoLiteDynamic<Allocated*> iFree;
     mutable Mutex iLock;
     const TChar* iName;
+    const AllocatorMode iMode;
+    const AllocatorReserve iReserve;
     const TUint iCellsTotal;
     const TUint iCellBytes;
-    TUint iCellsUsed;
-    TUint iCellsUsedMax;
+    const TUint iSlabCells;
+    std::atomic<TUint> iCellsUsed;
+    std::atomic<TUint> iCellsUsedMax;
+    std::atomic<TUint> iCellsReserved;
+    TUint64 iReserveUs;
+    std::vector<Allocated*> iCells;     // indexed by Allocated::iCellIndex; nullptr for cells in unallocated slabs
+    std::vector<TByte*> iSlabs;
+    std::vector<TUint> iSlabCellsFree;  // only maintained for AllocatorMode::Locked
+    // only used for AllocatorMode::LockFree
+    std::vector<std::atomic<TUint>> iSharedNext;
+    std::atomic<TUint64> iSharedHead; // ABA tag in upper 32 bits, index of top cell in lower
+    Magazine* iMagazines;
+    TUint iMagazineCells;
 };
 
 template <class T> class Allocator : public AllocatorBase
 {
 public:
-    Allocator(const TChar* aName, TUint aNumCells, IInfoAggregator& aInfoAggregator);
+    Allocator(const TChar* aName, TUint aNumCells, IInfoAggregator& aInfoAggregator,
+              AllocatorMode aMode = AllocatorMode::Locked, AllocatorReserve aReserve = AllocatorReserve::Full);
     virtual ~Allocator();
     T* Allocate();
+private: // from AllocatorBase
+    Allocated* ConstructCell(void* aMem) override;
 };
 
-template <class T> Allocator<T>::Allocator(const TChar* aName, TUint aNumCells, IInfoAggregator& aInfoAggregator)
-    : AllocatorBase(aName, aNumCells, sizeof(T), aInfoAggregator)
+template <class T> Allocator<T>::Allocator(const TChar* aName, TUint aNumCells, IInfoAggregator& aInfoAggregator,
+                                           AllocatorMode aMode, AllocatorReserve aReserve)
+    : AllocatorBase(aName, aNumCells, sizeof(T), aInfoAggregator, aMode, aReserve)
 {
-    for (TUint i=0; i<aNumCells; i++) {
-        iFree.Write(new T(*this));
-    }
+    Reserve();
 }
 
 template <class T> Allocator<T>::~Allocator()
@@ -81,6 +147,11 @@ template <class T> T* Allocator<T>::Allocate()
     return static_cast<T*>(DoAllocate());
 }
 
+template <class T> Allocated* Allocator<T>::ConstructCell(void* aMem)
+{
+    return new (aMem) T(*this);
+}
+
 class Logger;
 
 class Allocated
@@ -91,6 +162,7 @@ class Allocated
 public:
     void AddRef();
     void RemoveRef();
+    TBool IsShared() const; // more than one reference held.  Only meaningful to a holder of a reference
 protected:
     Allocated(AllocatorBase& aAllocator);
 protected:
@@ -101,6 +173,7 @@ protected:
     AllocatorBase& iAllocator;
 private:
     std::atomic<TUint> iRefCount;
+    TUint iCellIndex;
 };
 
 enum class AudioDataEndian
@@ -171,14 +244,12 @@ public:
 public:
     void Aggregate(DecodedAudio& aDecodedAudio);
     void SetBytes(TUint aBytes);
+    DecodedAudio* AllocateScratch(); // empty DecodedAudio from the same pool
 private:
     DecodedAudio(AllocatorBase& aAllocator);
     void ConstructPcm(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian);
     void ConstructDsd(const Brx& aData);
     void Construct();
-    static void CopyToBigEndian16(const Brx& aData, TByte* aDest);
-    static void CopyToBigEndian24(const Brx& aData, TByte* aDest);
-    static void CopyToBigEndian32(const Brx& aData, TByte* aDest);
 };
 
 /**
@@ -242,8 +313,11 @@ class Msg : public Allocated
     friend class MsgQueueBase;
 public:
     virtual Msg* Process(IMsgProcessor& aProcessor) = 0;
+    inline TBool IsAudioPcm() const; // cheaper than Process() for callers that only need to spot MsgAudioPcm
 protected:
     Msg(AllocatorBase& aAllocator);
+protected:
+    TBool iIsAudioPcm;
 private:
     Msg* iNextMsg;
 };
@@ -290,8 +364,18 @@ public:
     RampApplicator(const Media::Ramp& aRamp);
     TUint Start(const Brx& aData, TUint aBitDepth, TUint aNumChannels); // returns number of samples
     void GetNextSample(TByte* aDest);
+    /*
+     * Ramps all of aData into aDest (which must have space for aData.Bytes() and may be aData).  Returns number of samples.
+     * Output for 8 and 16-bit audio matches GetNextSample().  Unlike GetNextSample(), which truncates
+     * to 16 bits, 24 and 32-bit audio keeps its full precision.
+     */
+    TUint Apply(const Brx& aData, TByte* aDest, TUint aBitDepth, TUint aNumChannels);
+    TUint Apply(const Brx& aData, TByte* aDest, TUint aBitDepth, TUint aNumChannels, TUint aGain); // aGain is Q15, applied on top of the ramp
     static TUint MedianMultiplier(const Media::Ramp& aRamp);
 private:
+    TUint RampIndex(TInt aSampleIndex) const;
+private:
+    static const TUint kGainBlockSamples = 256;
     const Media::Ramp& iRamp;
     const TByte* iPtr;
     TUint iBitDepth;
@@ -301,6 +385,33 @@ private:
     TInt iLoopCount;
 };
 
+/*
+ * Running totals for the gain (ramp + attenuation) stage applied as MsgPlayablePcm is read.
+ * Reported via IInfoAggregator's "dsp" query.
+ * Every msg's bytes are counted but only one msg in kTimingInterval is timed, keeping clock
+ * reads off the per-msg path.  Throughput is estimated from the timed msgs.
+ */
+class PcmGainStats : private IInfoProvider
+{
+public:
+    static const Brn kQueryDsp;
+    static const TUint kTimingInterval = 64;
+public:
+    PcmGainStats(IInfoAggregator& aInfoAggregator);
+    TBool ShouldTime(); // true for one call in every kTimingInterval
+    void Add(TUint aBytes);
+    void AddTimed(TUint aBytes, TUint64 aDurationUs);
+    TUint64 Bytes() const;
+    TUint64 BytesPerSecond() const; // throughput while processing, not averaged over wall clock time
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
+private:
+    std::atomic<TUint> iCount;
+    std::atomic<TUint64> iBytes;
+    std::atomic<TUint64> iTimedBytes;
+    std::atomic<TUint64> iDurationUs;
+};
+
 class MsgFactory;
 
 
@@ -669,6 +780,8 @@ public:
     void Add(MsgAudioEncoded* aMsg); // combines MsgAudioEncoded instances so they report larger sizes etc
     TUint Append(const Brx& aData); // Appends a Data to existing msg.  Returns index into aData where copying terminated.
     TUint Append(const Brx& aData, TUint aMaxBytes); // Appends a Data to existing msg.  Returns index into aData where copying terminated.
+    TByte* AppendSpace(TUint aMaxBytes, TUint& aBytes); // Returns writable space (aBytes long) following this msg's data, for use with AppendInPlace().
+    void AppendInPlace(TUint aBytes); // Appends aBytes that have already been written to the start of AppendSpace().
     TUint Bytes() const;
     void CopyTo(TByte* aPtr);
     MsgAudioEncoded* Clone();
@@ -945,7 +1058,8 @@ public: // from MsgAudio
 private:
     void Initialise(DecodedAudio* aDecodedAudio, TUint aSampleRate, TUint aBitDepth, TUint aChannels, TUint64 aTrackOffset,
                     Allocator<MsgPlayablePcm>& aAllocatorPlayablePcm,
-                    Allocator<MsgPlayableSilence>& aAllocatorPlayableSilence);
+                    Allocator<MsgPlayableSilence>& aAllocatorPlayableSilence,
+                    PcmGainStats& aGainStats);
 private: // from MsgAudio
     MsgAudio* Allocate() override;
     void SplitCompleted(MsgAudio& aRemaining) override;
@@ -955,6 +1069,7 @@ private: // from Msg
 private:
     Allocator<MsgPlayablePcm>* iAllocatorPlayablePcm;
     TUint iAttenuation;
+    PcmGainStats* iGainStats;
 };
 
 class MsgAudioDsd : public MsgAudioDecoded
@@ -1083,7 +1198,7 @@ public:
 private:
     void Initialise(DecodedAudio* aDecodedAudio, TUint aSizeBytes, TUint aSampleRate, TUint aBitDepth,
                     TUint aNumChannels, TUint aOffsetBytes, TUint aAttenuation, const Media::Ramp& aRamp,
-                    Optional<IPipelineBufferObserver> aPipelineBufferObserver);
+                    Optional<IPipelineBufferObserver> aPipelineBufferObserver, PcmGainStats& aGainStats);
 private: // from MsgPlayable
     MsgPlayable* Allocate() override;
     void SplitCompleted(MsgPlayable& aRemaining) override;
@@ -1091,11 +1206,10 @@ private: // from MsgPlayable
     TBool TryLogTimestamps() override;
 private: // from Msg
     void Clear() override;
-private:
-    void ApplyAttenuation(Bwx& aData);
 private:
     DecodedAudio* iAudioData;
     TUint iAttenuation;
+    PcmGainStats* iGainStats;
 };
 
 class MsgPlayableDsd : public MsgPlayable
@@ -1284,9 +1398,11 @@ protected:
     void DoEnqueue(Msg* aMsg);
     Msg* DoDequeue();
     void DoEnqueueAtHead(Msg* aMsg);
+    void DoEnqueueAtHead(MsgQueueBase& aQueue); // moves all of aQueue, preserving its order
     TBool IsEmpty() const;
     void DoClear();
     TUint NumMsgs() const;
+    Msg* Head() const;
 private:
     void CheckMsgNotQueued(Msg* aMsg) const;
 private:
@@ -1301,9 +1417,11 @@ public:
     inline void Enqueue(Msg* aMsg);
     inline Msg* Dequeue();
     inline void EnqueueAtHead(Msg* aMsg);
+    inline void EnqueueAtHead(MsgQueueLite& aQueue);
     inline TBool IsEmpty() const;
     inline void Clear();
     inline TUint NumMsgs() const;
+    inline Msg* Head() const;
 };
 
 class MsgQueue : public MsgQueueBase
@@ -1312,7 +1430,16 @@ public:
     MsgQueue();
     void Enqueue(Msg* aMsg);
     Msg* Dequeue();
+    /**
+     * Blocks until at least one msg is available then moves it to aQueue.
+     *
+     * If that msg is MsgAudioPcm, any immediately following MsgAudioPcm are also moved,
+     * up to aMaxJiffies in total.  Any other msg type is always returned on its own.
+     * All msgs are moved under a single acquisition of the queue's lock.
+     */
+    void DequeueBatch(MsgQueueLite& aQueue, TUint aMaxJiffies);
     void EnqueueAtHead(Msg* aMsg);
+    void EnqueueAtHead(MsgQueueLite& aQueue);
     TBool IsEmpty() const;
     void Clear();
     TUint NumMsgs() const; // test/debug use only
@@ -1321,13 +1448,65 @@ private:
     Semaphore iSem;
 };
 
+/**
+ * Unbounded msg queue for exactly one producer thread and one consumer thread.
+ *
+ * Enqueue() may only be called by the producer.  Dequeue(), DequeueBatch() and
+ * EnqueueAtHead() may only be called by the consumer.  IsEmpty() and NumMsgs() are
+ * safe from any thread.
+ * No locks are taken.  The consumer only blocks, and the producer only signals it,
+ * when the queue is empty.  Msgs are stored in fixed size blocks; the block most
+ * recently emptied by the consumer is recycled by the producer so steady state
+ * operation doesn't allocate.
+ */
+class MsgQueueSpsc : private INonCopyable
+{
+    static const TUint kBlockMsgs = 64;
+public:
+    MsgQueueSpsc();
+    ~MsgQueueSpsc();
+    void Enqueue(Msg* aMsg);
+    Msg* Dequeue();
+    void DequeueBatch(MsgQueueLite& aQueue, TUint aMaxJiffies); // as MsgQueue::DequeueBatch
+    void EnqueueAtHead(Msg* aMsg);
+    void EnqueueAtHead(MsgQueueLite& aQueue);
+    TBool IsEmpty() const;
+    TUint NumMsgs() const;
+private:
+    struct Block
+    {
+        Msg* iMsgs[kBlockMsgs];
+        Block* iNext;
+    };
+    void WaitNotEmpty();
+    Msg* Head() const;
+    Msg* DoDequeue();
+private:
+    std::atomic<TUint> iNumMsgs; // includes iRequeued; incremented after a msg is written so also publishes it
+    std::atomic<TBool> iConsumerWaiting;
+    Semaphore iSem;
+    std::atomic<Block*> iSpare;
+    Block* iTailBlock;  // producer only
+    TUint iTailIndex;   // producer only
+    Block* iHeadBlock;  // consumer only
+    TUint iHeadIndex;   // consumer only
+    MsgQueueLite iRequeued; // consumer only
+};
+
+enum class ReservoirQueue
+{
+    Locked,     // MsgQueue - any number of producer and consumer threads
+    LockFree    // MsgQueueSpsc - exactly one producer thread and one consumer thread
+};
+
 class MsgReservoir
 {
 protected:
-    MsgReservoir();
+    MsgReservoir(ReservoirQueue aQueue = ReservoirQueue::Locked);
     virtual ~MsgReservoir();
     void DoEnqueue(Msg* aMsg);
     Msg* DoDequeue(TBool aAllowNull = false);
+    TUint DoDequeueBatch(MsgQueueLite& aQueue, TUint aMaxJiffies); // returns number of msgs added to aQueue (may be 0)
     void EnqueueAtHead(Msg* aMsg);
     TUint Jiffies() const;
     TUint EncodedBytes() const;
@@ -1341,6 +1520,7 @@ protected:
     TUint DecodedAudioCount() const;
     TUint NumMsgs() const; // Test use only
 private:
+    virtual TBool ContinueDequeueBatch() const; // checked before each msg after the first in DoDequeueBatch()
     virtual void ProcessMsgIn(MsgMode* aMsg);
     virtual void ProcessMsgIn(MsgTrack* aMsg);
     virtual void ProcessMsgIn(MsgDrain* aMsg);
@@ -1463,15 +1643,16 @@ private:
     };
 private:
     MsgQueue iQueue;
-    mutable Mutex iLockEncoded; // see #5098
-    TUint iEncodedBytes;
+    MsgQueueSpsc* iQueueSpsc; // used instead of iQueue if non-null
+    MsgQueueLite* iDequeueBatch; // non-null only while DoDequeueBatch() is processing msgs
+    std::atomic<TUint> iEncodedBytes;
     std::atomic<TUint> iJiffies;
     std::atomic<TUint> iTrackCount;
     std::atomic<TUint> iDelayCount;
     std::atomic<TUint> iEncodedStreamCount;
     std::atomic<TUint> iMetaTextCount;
     std::atomic<TUint> iDecodedStreamCount;
-    TUint iEncodedAudioCount;
+    std::atomic<TUint> iEncodedAudioCount;
     std::atomic<TUint> iDecodedAudioCount;
 };
 
@@ -1831,6 +2012,14 @@ public:
     virtual void StartSeek(TUint aStreamId, TUint aSecondsAbsolute, ISeekObserver& aObserver, TUint& aHandle) = 0; // aHandle will be set to value that is later passed to NotifySeekComplete.  Or kHandleError.
 };
 
+class IDecodeAhead
+{
+public:
+    virtual ~IDecodeAhead() {}
+    virtual void NotifyStreamEnding(TUint aStreamId) = 0; // remaining audio for aStreamId fits in the decode-ahead allowance
+    virtual void NotifyStreamSeek(TUint aStreamId) = 0;   // aStreamId is being seeked; any allowance from NotifyStreamEnding is withdrawn
+};
+
 class ISeekRestreamer
 {
 public:
@@ -1850,6 +2039,17 @@ class IPipelineElementUpstream
 public:
     virtual ~IPipelineElementUpstream() {}
     virtual Msg* Pull() = 0;
+    /**
+     * Pull one or more msgs, appending them to aQueue in pipeline order.
+     *
+     * Always appends at least one msg.  A batch is either a single msg of any type or a run
+     * of MsgAudioPcm so elements only ever see other msg types on their own.
+     * aMaxJiffies is a soft limit on the total duration of audio returned.
+     * Reservoirs override this to hand over several msgs under one lock; elements between
+     * them pass batches on (see BatchingUpstream).
+     * The default implementation appends the result of a single Pull().
+     */
+    virtual void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies);
 };
 
 class IPipelineElementDownstream
@@ -1859,6 +2059,67 @@ public:
     virtual void Push(Msg* aMsg) = 0;
 };
 
+/**
+ * Optional interface for upstream elements which an ElementBypass can collapse into a single Pull().
+ *
+ * All functions are only called from the thread that pulls from the element.
+ */
+class IPipelineElementBypassable
+{
+public:
+    virtual ~IPipelineElementBypassable() {}
+    /**
+     * @return  true if Pull() currently does nothing more than pull from upstream and pass the
+     *          msg to ProcessBypassed(), repeating while that returns nullptr.
+     */
+    virtual TBool BypassPull() const = 0;
+    /**
+     * @return  true if ProcessBypassed() currently returns MsgAudioPcm unchanged, with no side effects.
+     */
+    virtual TBool BypassAudio() const = 0;
+    /**
+     * Process a msg exactly as Pull() would after pulling it from upstream.
+     *
+     * @param[in] aMsg     Msg pulled from upstream of this element.
+     *
+     * @return  Msg to pass downstream or nullptr if aMsg was consumed.
+     */
+    virtual Msg* ProcessBypassed(Msg* aMsg) = 0;
+};
+
+/**
+ * Wraps the upstream of an element, letting it pass batches on without changing the
+ * order in which its Pull() sees msgs.
+ *
+ * The element pulls from this rather than its upstream and implements IPipelineElementBypassable.
+ * While BypassPull() is true, PullBatch(aElement, ...) passes each msg of a batch to
+ * ProcessBypassed().  If BypassPull() becomes false part way through a batch (say a msg
+ * starts a ramp or another thread requests a seek), the rest of the batch is returned here
+ * and will be pulled again, ahead of any newer msgs, by the element's own Pull().
+ */
+class BatchingUpstream : public IPipelineElementUpstream, private INonCopyable
+{
+public:
+    BatchingUpstream(IPipelineElementUpstream& aUpstream);
+    ~BatchingUpstream();
+    /**
+     * Implementation of PullBatch() for an element that pulls from this.
+     *
+     * @param[in] aElement     Element whose PullBatch() is being called.
+     * @param[in] aBypassable  aElement's IPipelineElementBypassable implementation.
+     * @param[in] aSource      Where aElement's Pull() takes msgs from.  Either this or
+     *                         something (e.g. a Flusher) which pulls from this.
+     */
+    void PullBatch(IPipelineElementUpstream& aElement, IPipelineElementBypassable& aBypassable,
+                   IPipelineElementUpstream& aSource, MsgQueueLite& aQueue, TUint aMaxJiffies);
+public: // from IPipelineElementUpstream
+    Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private:
+    IPipelineElementUpstream& iUpstream;
+    MsgQueueLite iReturned;
+};
+
 
 /**
  * Should be implemented by the object that animates (calls Pull() on) Pipeline.
@@ -1962,6 +2223,8 @@ public:
     inline void SetMsgSilenceCount(TUint aCount);
     inline void SetMsgPlayableCount(TUint aPcmCount, TUint aDsdCount, TUint aSilenceCount);
     inline void SetMsgQuitCount(TUint aCount);
+    inline void SetAllocatorMode(AllocatorMode aMode);
+    inline void SetAllocatorReserve(AllocatorReserve aReserve);
 private:
     TUint iMsgModeCount;
     TUint iMsgTrackCount;
@@ -1986,6 +2249,8 @@ private:
     TUint iMsgPlayableDsdCount;
     TUint iMsgPlayableSilenceCount;
     TUint iMsgQuitCount;
+    AllocatorMode iAllocatorMode;
+    AllocatorReserve iAllocatorReserve;
 };
 
 class MsgFactory
@@ -2025,6 +2290,8 @@ public:
     MsgSilence* CreateMsgSilenceDsd(TUint& aSizeJiffies, TUint aSampleRate, TUint aChannels, TUint aSampleBlockWords);
     MsgQuit* CreateMsgQuit();
     DecodedAudio* CreateDecodedAudio();
+    const PcmGainStats& GainStats() const;
+    void GetAllocators(std::vector<const AllocatorBase*>& aAllocators) const; // appends all allocators owned by this factory
 private:
     EncodedAudio* CreateEncodedAudio(const Brx& aData);
     DecodedAudio* CreateDecodedAudio(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian);
@@ -2054,6 +2321,7 @@ private:
     Allocator<MsgPlayableSilence> iAllocatorMsgPlayableSilence;
     Allocator<MsgPlayableSilenceDsd> iAllocatorMsgPlayableSilenceDsd;
     Allocator<MsgQuit> iAllocatorMsgQuit;
+    PcmGainStats iPcmGainStats;
 };
 
 #include <OpenHome/Media/Pipeline/Msg.inl>
@@ -5,6 +5,19 @@ inline const TChar* AllocatorBase::Name() const
     return iName;
 }
 
+inline AllocatorMode AllocatorBase::Mode() const
+{
+    return iMode;
+}
+
+
+// Msg
+
+inline TBool Msg::IsAudioPcm() const
+{
+    return iIsAudioPcm;
+}
+
 
 // Jiffies
 
@@ -273,6 +286,10 @@ inline void MsgQueueLite::EnqueueAtHead(Msg* aMsg)
 {
     DoEnqueueAtHead(aMsg);
 }
+inline void MsgQueueLite::EnqueueAtHead(MsgQueueLite& aQueue)
+{
+    DoEnqueueAtHead(aQueue);
+}
 inline TBool MsgQueueLite::IsEmpty() const
 {
     return MsgQueueBase::IsEmpty();
@@ -285,6 +302,10 @@ inline TUint MsgQueueLite::NumMsgs() const
 {
     return MsgQueueBase::NumMsgs();
 }
+inline Msg* MsgQueueLite::Head() const
+{
+    return MsgQueueBase::Head();
+}
 
 
 // MsgFactoryInitParams
@@ -313,6 +334,8 @@ inline MsgFactoryInitParams::MsgFactoryInitParams()
     , iMsgPlayableDsdCount(1)
     , iMsgPlayableSilenceCount(1)
     , iMsgQuitCount(1)
+    , iAllocatorMode(AllocatorMode::Locked)
+    , iAllocatorReserve(AllocatorReserve::Full)
 {
 }
 inline void MsgFactoryInitParams::SetMsgModeCount(TUint aCount)
@@ -395,3 +418,11 @@ inline void MsgFactoryInitParams::SetMsgQuitCount(TUint aCount)
 {
     iMsgQuitCount = aCount;
 }
+inline void MsgFactoryInitParams::SetAllocatorMode(AllocatorMode aMode)
+{
+    iAllocatorMode = aMode;
+}
+inline void MsgFactoryInitParams::SetAllocatorReserve(AllocatorReserve aReserve)
+{
+    iAllocatorReserve = aReserve;
+}
@@ -27,7 +27,9 @@
 #include <OpenHome/Media/Pipeline/Router.h>
 #include <OpenHome/Media/Pipeline/Drainer.h>
 #include <OpenHome/Media/Pipeline/Attenuator.h>
+#include <OpenHome/Media/Pipeline/ElementBypass.h>
 #include <OpenHome/Media/Pipeline/Logger.h>
+#include <OpenHome/Media/Pipeline/PipelineTrace.h>
 #include <OpenHome/Media/Pipeline/PhaseAdjuster.h>
 #include <OpenHome/Media/Pipeline/StarvationRamper.h>
 #include <OpenHome/Media/Pipeline/Muter.h>
@@ -52,6 +54,7 @@ PipelineInitParams* PipelineInitParams::New()
 PipelineInitParams::PipelineInitParams()
     : iEncodedReservoirBytes(kEncodedReservoirSizeBytes)
     , iDecodedReservoirJiffies(kDecodedReservoirSize)
+    , iDecodeAheadJiffies(kDecodeAheadSizeDefault)
     , iGorgeDurationJiffies(kGorgerSizeDefault)
     , iStarvationRamperMinJiffies(kStarvationRamperSizeDefault)
     , iMaxStreamsPerReservoir(kMaxReservoirStreamsDefault)
@@ -59,12 +62,24 @@ PipelineInitParams::PipelineInitParams()
     , iRampShortJiffies(kShortRampDurationDefault)
     , iRampEmergencyJiffies(kEmergencyRampDurationDefault)
     , iSenderMinLatency(kSenderMinLatency)
+    , iThreadPriorityAnimator(kThreadPriorityAnimatorDefault)
     , iMaxLatencyJiffies(kMaxLatencyDefault)
     , iSupportElements(EPipelineSupportElementsAll)
     , iMuter(kMuterDefault)
     , iDsdMaxSampleRate(kDsdMaxSampleRateDefault)
+    , iAllocatorMode(kAllocatorModeDefault)
+    , iAllocatorReserve(kAllocatorReserveDefault)
+    , iElementBypass(kElementBypassDefault)
+    , iEncodedReservoirQueue(kReservoirQueueDefault)
+    , iDecodedReservoirQueue(kReservoirQueueDefault)
+    , iSchedPolicy(kSchedPolicyDefault)
+    , iLockMemory(kLockMemoryDefault)
+    , iFlywheelTraining(kFlywheelTrainingDefault)
 {
     SetThreadPriorityMax(kThreadPriorityMax);
+    for (TUint i=0; i<ThreadScheduler::kNumThreads; i++) {
+        iThreadCpuMasks[i] = 0;
+    }
 }
 
 PipelineInitParams::~PipelineInitParams()
@@ -81,6 +96,11 @@ void PipelineInitParams::SetDecodedReservoirSize(TUint aJiffies)
     iDecodedReservoirJiffies = aJiffies;
 }
 
+void PipelineInitParams::SetDecodeAheadSize(TUint aJiffies)
+{
+    iDecodeAheadJiffies = aJiffies;
+}
+
 void PipelineInitParams::SetGorgerDuration(TUint aJiffies)
 {
     iGorgeDurationJiffies = aJiffies;
@@ -130,6 +150,11 @@ void PipelineInitParams::SetThreadPriorities(TUint aStarvationRamper, TUint aCod
     iThreadPriorityEvent            = aEvent;
 }
 
+void PipelineInitParams::SetThreadPriorityAnimator(TUint aPriority)
+{
+    iThreadPriorityAnimator = aPriority;
+}
+
 void PipelineInitParams::SetMaxLatency(TUint aJiffies)
 {
     iMaxLatencyJiffies = aJiffies;
@@ -150,6 +175,51 @@ void PipelineInitParams::SetDsdMaxSampleRate(TUint aMaxSampleRate)
     iDsdMaxSampleRate = aMaxSampleRate;
 }
 
+void PipelineInitParams::SetAllocatorMode(AllocatorMode aMode)
+{
+    iAllocatorMode = aMode;
+}
+
+void PipelineInitParams::SetAllocatorReserve(AllocatorReserve aReserve)
+{
+    iAllocatorReserve = aReserve;
+}
+
+void PipelineInitParams::SetElementBypass(TBool aEnable)
+{
+    iElementBypass = aEnable;
+}
+
+void PipelineInitParams::SetEncodedReservoirQueue(ReservoirQueue aQueue)
+{
+    iEncodedReservoirQueue = aQueue;
+}
+
+void PipelineInitParams::SetDecodedReservoirQueue(ReservoirQueue aQueue)
+{
+    iDecodedReservoirQueue = aQueue;
+}
+
+void PipelineInitParams::SetThreadCpuMask(PipelineThread aThread, TUint64 aCpuMask)
+{
+    iThreadCpuMasks[(TUint)aThread] = aCpuMask;
+}
+
+void PipelineInitParams::SetThreadSchedPolicy(ThreadSchedPolicy aPolicy)
+{
+    iSchedPolicy = aPolicy;
+}
+
+void PipelineInitParams::SetLockMemory(TBool aLock)
+{
+    iLockMemory = aLock;
+}
+
+void PipelineInitParams::SetFlywheelTraining(FlywheelTraining aTraining)
+{
+    iFlywheelTraining = aTraining;
+}
+
 TUint PipelineInitParams::EncodedReservoirBytes() const
 {
     return iEncodedReservoirBytes;
@@ -160,6 +230,11 @@ TUint PipelineInitParams::DecodedReservoirJiffies() const
     return iDecodedReservoirJiffies;
 }
 
+TUint PipelineInitParams::DecodeAheadJiffies() const
+{
+    return iDecodeAheadJiffies;
+}
+
 TUint PipelineInitParams::GorgeDurationJiffies() const
 {
    return iGorgeDurationJiffies;
@@ -210,6 +285,11 @@ TUint PipelineInitParams::ThreadPriorityEvent() const
     return iThreadPriorityEvent;
 }
 
+TUint PipelineInitParams::ThreadPriorityAnimator() const
+{
+    return iThreadPriorityAnimator;
+}
+
 TUint PipelineInitParams::MaxLatencyJiffies() const
 {
     return iMaxLatencyJiffies;
@@ -230,6 +310,51 @@ TUint OpenHome::Media::PipelineInitParams::DsdMaxSampleRate() const
     return iDsdMaxSampleRate;
 }
 
+AllocatorMode PipelineInitParams::MsgAllocatorMode() const
+{
+    return iAllocatorMode;
+}
+
+AllocatorReserve PipelineInitParams::MsgAllocatorReserve() const
+{
+    return iAllocatorReserve;
+}
+
+TBool PipelineInitParams::ElementBypass() const
+{
+    return iElementBypass;
+}
+
+ReservoirQueue PipelineInitParams::EncodedReservoirQueue() const
+{
+    return iEncodedReservoirQueue;
+}
+
+ReservoirQueue PipelineInitParams::DecodedReservoirQueue() const
+{
+    return iDecodedReservoirQueue;
+}
+
+TUint64 PipelineInitParams::ThreadCpuMask(PipelineThread aThread) const
+{
+    return iThreadCpuMasks[(TUint)aThread];
+}
+
+ThreadSchedPolicy PipelineInitParams::SchedPolicy() const
+{
+    return iSchedPolicy;
+}
+
+TBool PipelineInitParams::LockMemory() const
+{
+    return iLockMemory;
+}
+
+FlywheelTraining PipelineInitParams::FlywheelTrainingMode() const
+{
+    return iFlywheelTraining;
+}
+
 
 // Pipeline
 
@@ -258,6 +383,7 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     , iNextFlushId(MsgFlush::kIdInvalid + 1)
     , iMaxSampleRatePcm(0)
     , iMaxSampleRateDsd(0)
+    , iAnimatorScheduled(false)
 {
     const TUint perStreamMsgCount = aInitParams->MaxStreamsPerReservoir() * kReservoirCount;
     TUint encodedAudioCount = ((aInitParams->EncodedReservoirBytes() + EncodedAudio::kMaxBytes - 1) / EncodedAudio::kMaxBytes); // this may only be required on platforms that don't guarantee priority based thread scheduling
@@ -266,7 +392,8 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     const TUint maxEncodedReservoirMsgs = encodedAudioCount;
     encodedAudioCount += kRewinderMaxMsgs; // this may only be required on platforms that don't guarantee priority based thread scheduling
     const TUint msgEncodedAudioCount = encodedAudioCount + 100; // +100 allows for Split()ing by Container and CodecController
-    const TUint decodedReservoirSize = aInitParams->DecodedReservoirJiffies() + aInitParams->StarvationRamperMinJiffies();
+    const TUint decodedReservoirSize = aInitParams->DecodedReservoirJiffies() + aInitParams->DecodeAheadJiffies()
+                                     + aInitParams->StarvationRamperMinJiffies();
 
     // Work out number of decoded audio (AudioData) and MsgAudioDsd required, based on the maximum DSD sample rate supported.
     // Where empirical measurements are referenced below, these were achieved in the following way:
@@ -315,6 +442,7 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     msgInit.SetMsgStreamSegmentCount(perStreamMsgCount);
     msgInit.SetMsgAudioEncodedCount(msgEncodedAudioCount, encodedAudioCount);
     msgInit.SetMsgMetaTextCount(perStreamMsgCount);
+    msgInit.SetMsgBitRateCount(perStreamMsgCount);
     msgInit.SetMsgStreamInterruptedCount(perStreamMsgCount);
     msgInit.SetMsgHaltCount(msgHaltCount);
     msgInit.SetMsgFlushCount(kMsgCountFlush);
@@ -327,9 +455,24 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     msgInit.SetMsgSilenceCount(kMsgCountSilence);
     msgInit.SetMsgPlayableCount(kMsgCountPlayablePcm, kMsgCountPlayableDsd, kMsgCountPlayableSilence);
     msgInit.SetMsgQuitCount(kMsgCountQuit);
+    msgInit.SetAllocatorMode(aInitParams->MsgAllocatorMode());
+    msgInit.SetAllocatorReserve(aInitParams->MsgAllocatorReserve());
     iMsgFactory = new MsgFactory(aInfoAggregator, msgInit);
 
-    iEventThread = new PipelineElementObserverThread(aInitParams->ThreadPriorityEvent());
+    // created before any element so that threads can apply settings as they start
+    iThreadScheduler = new ThreadScheduler(aInfoAggregator, aInitParams->SchedPolicy());
+    const TUint priorityStarvationRamper = aInitParams->ThreadPriorityStarvationRamper();
+    iThreadScheduler->SetPriority(PipelineThread::Filler, aInitParams->ThreadPriorityCodec() - 1); // matches PipelineManager
+    iThreadScheduler->SetPriority(PipelineThread::Codec, aInitParams->ThreadPriorityCodec());
+    iThreadScheduler->SetPriority(PipelineThread::StarvationRamper, priorityStarvationRamper - 1);
+    iThreadScheduler->SetPriority(PipelineThread::FlywheelRamper, priorityStarvationRamper);
+    iThreadScheduler->SetPriority(PipelineThread::Animator, aInitParams->ThreadPriorityAnimator());
+    for (TUint i=0; i<ThreadScheduler::kNumThreads; i++) {
+        const auto thread = (PipelineThread)i;
+        iThreadScheduler->SetCpuMask(thread, aInitParams->ThreadCpuMask(thread));
+    }
+
+    iEventThread = new PipelineElementObserverThread(aInfoAggregator, aInitParams->ThreadPriorityEvent());
     IPipelineElementDownstream* downstream = nullptr;
     IPipelineElementUpstream* upstream = nullptr;
     const auto elementsSupported = aInitParams->SupportElements();
@@ -341,7 +484,8 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
 #endif // _WIN32
 
     // Construct encoded reservoir out of sequence.  It doesn't pull from the left so doesn't need to know its preceding element
-    iEncodedAudioReservoir = new EncodedAudioReservoir(*iMsgFactory, *this, maxEncodedReservoirMsgs, aInitParams->MaxStreamsPerReservoir());
+    iEncodedAudioReservoir = new EncodedAudioReservoir(*iMsgFactory, *this, maxEncodedReservoirMsgs, aInitParams->MaxStreamsPerReservoir(),
+                                                       aInitParams->EncodedReservoirQueue());
     upstream = iEncodedAudioReservoir;
     ATTACH_ELEMENT(iLoggerEncodedAudioReservoir, new Logger(*upstream, "Encoded Audio Reservoir"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -365,7 +509,9 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     iDecodedAudioReservoir = new DecodedAudioReservoir(*iMsgFactory, *this,
                                                        aInitParams->DecodedReservoirJiffies(),
                                                        aInitParams->MaxStreamsPerReservoir(),
-                                                       aInitParams->GorgeDurationJiffies());
+                                                       aInitParams->GorgeDurationJiffies(),
+                                                       aInitParams->DecodeAheadJiffies(),
+                                                       aInitParams->DecodedReservoirQueue());
     downstream = iDecodedAudioReservoir;
 
     ATTACH_ELEMENT(iDecodedAudioValidatorDecodedAudioAggregator, new DecodedAudioValidator("Decoded Audio Aggregator", *iDecodedAudioReservoir),
@@ -393,6 +539,10 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     iCodecController = new Codec::CodecController(*iMsgFactory, *upstream, *downstream, aUrlBlockWriter,
                                                   kSongcastFrameJiffies, aInitParams->ThreadPriorityCodec(),
                                                   createLoggers);
+    iCodecController->SetThreadScheduler(*iThreadScheduler);
+    if (aInitParams->DecodeAheadJiffies() > 0) {
+        iCodecController->SetDecodeAhead(*iDecodedAudioReservoir, aInitParams->DecodeAheadJiffies());
+    }
 
     upstream = iDecodedAudioReservoir;
     ATTACH_ELEMENT(iLoggerDecodedAudioReservoir,
@@ -462,6 +612,7 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
                    upstream, elementsSupported, EPipelineSupportElementsRampValidator);
     ATTACH_ELEMENT(iDecodedAudioValidatorStopper, new DecodedAudioValidator(*upstream, "Stopper"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
+    IPipelineElementUpstream* upstreamReporters = upstream;
     ATTACH_ELEMENT(iAirplayReporter, new Media::AirplayReporter(*upstream, *iMsgFactory, aTrackFactory),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iSpotifyReporter, new Media::SpotifyReporter(*upstream, *iMsgFactory, aTrackFactory),
@@ -478,7 +629,28 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iAttenuator, new Attenuator(*upstream),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
-    ATTACH_ELEMENT(iLoggerAttenuator, new Logger(*iAttenuator, "Attenuator"),
+    // Reporters, Router and Attenuator (plus any loggers between them) are usually idle for
+    // audio.  Collapse them into a single Pull().
+    iElementBypass = nullptr;
+    if (aInitParams->ElementBypass()) {
+        iElementBypass = new Media::ElementBypass(*upstreamReporters, *upstream);
+        iElementBypass->AddElement(*iAirplayReporter);
+        iElementBypass->AddElement(*iSpotifyReporter);
+        if (iLoggerSpotifyReporter != nullptr) {
+            iElementBypass->AddElement(*iLoggerSpotifyReporter);
+        }
+        iElementBypass->AddElement(*iReporter);
+        if (iLoggerReporter != nullptr) {
+            iElementBypass->AddElement(*iLoggerReporter);
+        }
+        iElementBypass->AddElement(*iRouter);
+        if (iLoggerRouter != nullptr) {
+            iElementBypass->AddElement(*iLoggerRouter);
+        }
+        iElementBypass->AddElement(*iAttenuator);
+        upstream = iElementBypass;
+    }
+    ATTACH_ELEMENT(iLoggerAttenuator, new Logger(*upstream, "Attenuator"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iDecodedAudioValidatorRouter, new DecodedAudioValidator(*upstream, "Router"),
                    upstream, elementsSupported, EPipelineSupportElementsDecodedAudioValidator);
@@ -502,7 +674,9 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
                    new StarvationRamper(*iMsgFactory, *upstream, *this, *iEventThread,
                                         aInitParams->StarvationRamperMinJiffies(),
                                         aInitParams->ThreadPriorityStarvationRamper(),
-                                        aInitParams->RampShortJiffies(), aInitParams->MaxStreamsPerReservoir()),
+                                        aInitParams->RampShortJiffies(), aInitParams->MaxStreamsPerReservoir(),
+                                        Optional<IPipelineThreadScheduler>(iThreadScheduler),
+                                        aInitParams->FlywheelTrainingMode()),
                                         upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerStarvationRamper, new Logger(*iStarvationRamper, "StarvationRamper"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -560,6 +734,20 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     }
     iMuteCounted = new MuteCounted(*muter);
 
+    iTrace = new PipelineTrace();
+    Logger* loggers[] = { iLoggerEncodedAudioReservoir, iLoggerContainer, iLoggerCodecController,
+                          iLoggerStreamValidator, iLoggerDecodedAudioAggregator, iLoggerDecodedAudioReservoir,
+                          iLoggerRamper, iLoggerSeeker, iLoggerDrainer1, iLoggerVariableDelay1, iLoggerSkipper,
+                          iLoggerTrackInspector, iLoggerWaiter, iLoggerStopper, iLoggerSpotifyReporter,
+                          iLoggerReporter, iLoggerRouter, iLoggerAttenuator, iLoggerDrainer2, iLoggerVariableDelay2,
+                          iLoggerStarvationRamper, iLoggerPhaseAdjuster, iLoggerMuter, iLoggerVolumeRamper,
+                          iLoggerPreDriver };
+    for (auto logger : loggers) {
+        if (logger != nullptr) {
+            logger->SetTracePoint(iTrace->CreatePoint(logger->Id()));
+        }
+    }
+
     gPipeline = this;
 
     //iAudioDumper->SetEnabled(true);
@@ -593,6 +781,13 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     // i.e. NEVER DISABLE THIS LOGGER
     iLoggerPreDriver->SetEnabled(true);
 
+
+    if (aInitParams->LockMemory()) {
+        // all msg allocator pools and the stacks of threads created so far are faulted in
+        // now; later allocations (lazily reserved pools, Filler/animator stacks) on creation
+        iThreadScheduler->LockMemory();
+    }
+
     //iLoggerEncodedAudioReservoir->SetFilter(Logger::EMsgAll);
     //iLoggerContainer->SetFilter(Logger::EMsgAll);
     //iLoggerCodecController->SetFilter(Logger::EMsgAll);
@@ -645,6 +840,7 @@ Pipeline::~Pipeline()
     delete iLoggerStarvationRamper;
     delete iStarvationRamper;
     delete iLoggerAttenuator;
+    delete iElementBypass;
     delete iAttenuator;
     delete iDecodedAudioValidatorDelay2;
     delete iRampValidatorDelay2;
@@ -707,6 +903,8 @@ Pipeline::~Pipeline()
     delete iLoggerEncodedAudioReservoir;
     delete iEncodedAudioReservoir;
     delete iEventThread;
+    delete iTrace; // after all loggers
+    delete iThreadScheduler;
     delete iMsgFactory;
     delete iInitParams;
 }
@@ -777,6 +975,16 @@ MsgFactory& Pipeline::Factory()
     return *iMsgFactory;
 }
 
+PipelineTrace& Pipeline::Trace()
+{
+    return *iTrace;
+}
+
+IPipelineThreadScheduler& Pipeline::Scheduler()
+{
+    return *iThreadScheduler;
+}
+
 void Pipeline::Play()
 {
     DoPlay(false);
@@ -946,6 +1154,10 @@ void Pipeline::Push(Msg* aMsg)
 
 Msg* Pipeline::Pull()
 {
+    if (!iAnimatorScheduled) {
+        iThreadScheduler->ApplyToCurrentThread(PipelineThread::Animator);
+        iAnimatorScheduled = true;
+    }
     return iPipelineEnd->Pull();
 }
 
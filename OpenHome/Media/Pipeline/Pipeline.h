@@ -11,6 +11,7 @@
 #include <OpenHome/Media/Pipeline/StarvationRamper.h>
 #include <OpenHome/Media/MuteManager.h>
 #include <OpenHome/Media/Pipeline/Attenuator.h>
+#include <OpenHome/Media/Utils/ThreadScheduler.h>
 
 EXCEPTION(PipelineStreamNotPausable)
 
@@ -42,6 +43,7 @@ public:
     // setters
     void SetEncodedReservoirSize(TUint aBytes);
     void SetDecodedReservoirSize(TUint aJiffies);
+    void SetDecodeAheadSize(TUint aJiffies); // extra decoded audio allowed at the end of a stream so the next one is decoded sooner.  0 disables
     void SetGorgerDuration(TUint aJiffies); // amount of audio required before non-pullable sources will start playing
     void SetStarvationRamperMinSize(TUint aJiffies);
     void SetMaxStreamsPerReservoir(TUint aCount);
@@ -51,13 +53,24 @@ public:
     void SetSenderMinLatency(TUint aJiffies);
     void SetThreadPriorityMax(TUint aPriority); // highest priority used by pipeline
     void SetThreadPriorities(TUint aStarvationRamper, TUint aCodec, TUint aEvent);
+    void SetThreadPriorityAnimator(TUint aPriority); // priority of the thread that calls Pull().  Sets its place among pipeline threads under SetThreadSchedPolicy()
     void SetMaxLatency(TUint aJiffies);
     void SetSupportElements(TUint aElements); // EPipelineSupportElements members OR'd together
     void SetMuter(MuterImpl aMuter);
     void SetDsdMaxSampleRate(TUint aMaxSampleRate);
+    void SetAllocatorMode(AllocatorMode aMode);
+    void SetAllocatorReserve(AllocatorReserve aReserve); // Lazy reduces startup time and RSS for pipelines that rarely approach worst case msg counts
+    void SetElementBypass(TBool aEnable); // let audio skip idle elements
+    void SetEncodedReservoirQueue(ReservoirQueue aQueue); // LockFree requires that only one thread calls Push()
+    void SetDecodedReservoirQueue(ReservoirQueue aQueue);
+    void SetThreadCpuMask(PipelineThread aThread, TUint64 aCpuMask); // bit n => may run on cpu n.  0 (default) => no restriction.  Linux only
+    void SetThreadSchedPolicy(ThreadSchedPolicy aPolicy); // real-time policy for pipeline threads.  Linux only; needs CAP_SYS_NICE
+    void SetLockMemory(TBool aLock); // lock allocator pools and thread stacks into RAM.  Linux only; needs CAP_IPC_LOCK
+    void SetFlywheelTraining(FlywheelTraining aTraining); // Incremental spreads starvation ramp training over playback
     // getters
     TUint EncodedReservoirBytes() const;
     TUint DecodedReservoirJiffies() const;
+    TUint DecodeAheadJiffies() const;
     TUint GorgeDurationJiffies() const;
     TUint StarvationRamperMinJiffies() const;
     TUint MaxStreamsPerReservoir() const;
@@ -68,15 +81,26 @@ public:
     TUint ThreadPriorityStarvationRamper() const;
     TUint ThreadPriorityCodec() const;
     TUint ThreadPriorityEvent() const;
+    TUint ThreadPriorityAnimator() const;
     TUint MaxLatencyJiffies() const;
     TUint SupportElements() const;
     MuterImpl Muter() const;
     TUint DsdMaxSampleRate() const;
+    AllocatorMode MsgAllocatorMode() const;
+    AllocatorReserve MsgAllocatorReserve() const;
+    TBool ElementBypass() const;
+    ReservoirQueue EncodedReservoirQueue() const;
+    ReservoirQueue DecodedReservoirQueue() const;
+    TUint64 ThreadCpuMask(PipelineThread aThread) const;
+    ThreadSchedPolicy SchedPolicy() const;
+    TBool LockMemory() const;
+    FlywheelTraining FlywheelTrainingMode() const;
 private:
     PipelineInitParams();
 private:
     TUint iEncodedReservoirBytes;
     TUint iDecodedReservoirJiffies;
+    TUint iDecodeAheadJiffies;
     TUint iGorgeDurationJiffies;
     TUint iStarvationRamperMinJiffies;
     TUint iMaxStreamsPerReservoir;
@@ -87,13 +111,24 @@ private:
     TUint iThreadPriorityStarvationRamper;
     TUint iThreadPriorityCodec;
     TUint iThreadPriorityEvent;
+    TUint iThreadPriorityAnimator;
     TUint iMaxLatencyJiffies;
     TUint iSupportElements;
     MuterImpl iMuter;
     TUint iDsdMaxSampleRate;
+    AllocatorMode iAllocatorMode;
+    AllocatorReserve iAllocatorReserve;
+    TBool iElementBypass;
+    ReservoirQueue iEncodedReservoirQueue;
+    ReservoirQueue iDecodedReservoirQueue;
+    TUint64 iThreadCpuMasks[ThreadScheduler::kNumThreads];
+    ThreadSchedPolicy iSchedPolicy;
+    TBool iLockMemory;
+    FlywheelTraining iFlywheelTraining;
 private:
     static const TUint kEncodedReservoirSizeBytes       = 1536 * 1024;
     static const TUint kDecodedReservoirSize            = Jiffies::kPerMs * 2000;
+    static const TUint kDecodeAheadSizeDefault          = 0;
     static const TUint kGorgerSizeDefault               = Jiffies::kPerMs * 1000;
     static const TUint kStarvationRamperSizeDefault     = Jiffies::kPerMs * 20;
     static const TUint kMaxReservoirStreamsDefault      = 10;
@@ -102,9 +137,17 @@ private:
     static const TUint kEmergencyRampDurationDefault    = Jiffies::kPerMs * 20;
     static const TUint kSenderMinLatency                = Jiffies::kPerMs * 150;
     static const TUint kThreadPriorityMax               = kPriorityHighest - 1;
+    static const TUint kThreadPriorityAnimatorDefault   = kPrioritySystemHighest; // as used by AnimatorBasic, AnimatorFile
     static const TUint kMaxLatencyDefault               = Jiffies::kPerMs * 2000;
     static const MuterImpl kMuterDefault                = MuterImpl::eRampSamples;
     static const TUint kDsdMaxSampleRateDefault         = 0;
+    static const AllocatorMode kAllocatorModeDefault    = AllocatorMode::Locked;
+    static const AllocatorReserve kAllocatorReserveDefault = AllocatorReserve::Full;
+    static const TBool kElementBypassDefault            = true;
+    static const ReservoirQueue kReservoirQueueDefault  = ReservoirQueue::Locked;
+    static const ThreadSchedPolicy kSchedPolicyDefault  = ThreadSchedPolicy::Default;
+    static const TBool kLockMemoryDefault               = false;
+    static const FlywheelTraining kFlywheelTrainingDefault = FlywheelTraining::OnStarvation;
 };
 
 namespace Codec {
@@ -135,6 +178,7 @@ class AirplayReporter;
 class SpotifyReporter;
 class Router;
 class Attenuator;
+class ElementBypass;
 class DrainerRight;
 class VariableDelayRight;
 class PhaseAdjuster;
@@ -151,6 +195,7 @@ class ISpotifyTrackObserver;
 class IMimeTypeList;
 class VolumeRamper;
 class IVolumeRamper;
+class PipelineTrace;
 
 class Pipeline : public IPipelineElementDownstream
                , public IPipeline
@@ -188,6 +233,8 @@ public:
     void Start(IVolumeRamper& aVolumeRamper, IVolumeMuterStepped& aVolumeMuter);
     void Quit();
     MsgFactory& Factory();
+    PipelineTrace& Trace();
+    IPipelineThreadScheduler& Scheduler();
     void Play();
     void Pause();
     void Wait(TUint aFlushId);
@@ -306,6 +353,7 @@ private:
     Router* iRouter;
     Logger* iLoggerRouter;
     Attenuator* iAttenuator;
+    Media::ElementBypass* iElementBypass; // nullptr unless PipelineInitParams::ElementBypass()
     Logger* iLoggerAttenuator;
     DecodedAudioValidator* iDecodedAudioValidatorRouter;
     DrainerRight* iDrainer2;
@@ -334,6 +382,7 @@ private:
     IPipelineElementDownstream* iPipelineStart;
     IPipelineElementUpstream* iPipelineEnd;
     IMute* iMuteCounted;
+    PipelineTrace* iTrace;
     EStatus iState;
     EPipelineState iLastReportedState;
     TBool iBuffering;
@@ -342,6 +391,8 @@ private:
     TUint iNextFlushId;
     TUint iMaxSampleRatePcm;
     TUint iMaxSampleRateDsd;
+    ThreadScheduler* iThreadScheduler;
+    TBool iAnimatorScheduled; // only accessed from animator thread
 };
 
 } // namespace Media
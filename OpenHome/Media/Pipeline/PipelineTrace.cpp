@@ -0,0 +1,439 @@
+#include <OpenHome/Media/Pipeline/PipelineTrace.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Json.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits.h>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+static const TChar* kMsgTypeNames[PipelineTracePoint::EMsgTypeCount] = {
+    "Mode", "Track", "Drain", "Delay", "EncodedStream", "StreamSegment", "AudioEncoded", "MetaText",
+    "StreamInterrupted", "Halt", "Flush", "Wait", "DecodedStream", "BitRate", "AudioPcm", "AudioDsd",
+    "Silence", "Playable", "Quit"
+};
+
+// Total duration of trace points completed on this thread since the innermost open Span began
+static thread_local TUint64 tNestedNs = 0;
+
+// PipelineTracePoint::Span
+
+PipelineTracePoint::Span::Span()
+    : iStartNs(0)
+    , iOuterNestedNs(0)
+{
+}
+
+
+// PipelineTracePoint
+
+TUint64 PipelineTracePoint::NowNs()
+{ // static
+    // Logger elements have no access to an Environment so can't use Os::TimeInUs
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (TUint64)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+PipelineTracePoint::Span PipelineTracePoint::Begin()
+{ // static
+    Span span;
+    span.iOuterNestedNs = tNestedNs;
+    tNestedNs = 0;
+    span.iStartNs = NowNs();
+    return span;
+}
+
+const TChar* PipelineTracePoint::MsgTypeName(TUint aType)
+{ // static
+    ASSERT(aType < EMsgTypeCount);
+    return kMsgTypeNames[aType];
+}
+
+PipelineTracePoint::PipelineTracePoint(PipelineTrace& aTrace, const TChar* aName)
+    : iTrace(aTrace)
+    , iName(aName)
+    , iRing(nullptr)
+    , iWriteIndex(0)
+    , iReadFloor(0)
+    , iClassifiedType(EMsgQuit)
+    , iClassifiedJiffies(0)
+{
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "PipelineTracePoint::kCapacity must be a power of 2");
+}
+
+PipelineTracePoint::~PipelineTracePoint()
+{
+    delete[] iRing;
+}
+
+const TChar* PipelineTracePoint::Name() const
+{
+    return iName;
+}
+
+void PipelineTracePoint::Classify(Msg& aMsg, TUint& aType, TUint& aJiffies)
+{
+    iClassifiedJiffies = 0;
+    (void)aMsg.Process(*this);
+    aType = iClassifiedType;
+    aJiffies = iClassifiedJiffies;
+}
+
+void PipelineTracePoint::Record(const Span& aSpan, TUint aType, TUint aJiffies)
+{
+    const TUint64 duration = NowNs() - aSpan.iStartNs;
+    const TUint64 self = (duration > tNestedNs? duration - tNestedNs : 0);
+    tNestedNs = aSpan.iOuterNestedNs + duration;
+    const TUint64 index = iWriteIndex.load(std::memory_order_relaxed);
+    Event& ev = iRing[index & (kCapacity - 1)];
+    ev.iStartNs = aSpan.iStartNs;
+    ev.iDurationNs = (duration > UINT_MAX? UINT_MAX : (TUint)duration);
+    ev.iSelfNs = (self > UINT_MAX? UINT_MAX : (TUint)self);
+    ev.iJiffies = aJiffies;
+    ev.iType = aType;
+    iWriteIndex.store(index + 1, std::memory_order_release);
+}
+
+void PipelineTracePoint::Snapshot(std::vector<Event>& aEvents) const
+{
+    aEvents.clear();
+    if (iRing == nullptr) {
+        return;
+    }
+    const TUint64 end = iWriteIndex.load(std::memory_order_acquire);
+    TUint64 begin = (end > kCapacity? end - kCapacity : 0);
+    begin = std::max(begin, iReadFloor.load(std::memory_order_relaxed));
+    aEvents.reserve((size_t)(end - begin));
+    for (TUint64 i=begin; i<end; i++) {
+        aEvents.push_back(iRing[i & (kCapacity - 1)]);
+    }
+    // discard any entries the writer may have overwritten (or be overwriting) while we copied
+    const TUint64 latest = iWriteIndex.load(std::memory_order_acquire);
+    if (latest + 1 > kCapacity) {
+        const TUint64 firstIntact = latest + 1 - kCapacity;
+        if (firstIntact > begin) {
+            const TUint64 discard = std::min((TUint64)aEvents.size(), firstIntact - begin);
+            aEvents.erase(aEvents.begin(), aEvents.begin() + (size_t)discard);
+        }
+    }
+}
+
+void PipelineTracePoint::AllocateRing()
+{
+    if (iRing == nullptr) {
+        iRing = new Event[kCapacity];
+    }
+}
+
+void PipelineTracePoint::Reset()
+{
+    iReadFloor.store(iWriteIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgMode* aMsg)
+{
+    iClassifiedType = EMsgMode;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgTrack* aMsg)
+{
+    iClassifiedType = EMsgTrack;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgDrain* aMsg)
+{
+    iClassifiedType = EMsgDrain;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgDelay* aMsg)
+{
+    iClassifiedType = EMsgDelay;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgEncodedStream* aMsg)
+{
+    iClassifiedType = EMsgEncodedStream;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgStreamSegment* aMsg)
+{
+    iClassifiedType = EMsgStreamSegment;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgAudioEncoded* aMsg)
+{
+    iClassifiedType = EMsgAudioEncoded;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgMetaText* aMsg)
+{
+    iClassifiedType = EMsgMetaText;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgStreamInterrupted* aMsg)
+{
+    iClassifiedType = EMsgStreamInterrupted;
+    iClassifiedJiffies = aMsg->Jiffies();
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgHalt* aMsg)
+{
+    iClassifiedType = EMsgHalt;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgFlush* aMsg)
+{
+    iClassifiedType = EMsgFlush;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgWait* aMsg)
+{
+    iClassifiedType = EMsgWait;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    iClassifiedType = EMsgDecodedStream;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgBitRate* aMsg)
+{
+    iClassifiedType = EMsgBitRate;
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgAudioPcm* aMsg)
+{
+    iClassifiedType = EMsgAudioPcm;
+    iClassifiedJiffies = aMsg->Jiffies();
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgAudioDsd* aMsg)
+{
+    iClassifiedType = EMsgAudioDsd;
+    iClassifiedJiffies = aMsg->Jiffies();
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgSilence* aMsg)
+{
+    iClassifiedType = EMsgSilence;
+    iClassifiedJiffies = aMsg->Jiffies();
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgPlayable* aMsg)
+{
+    iClassifiedType = EMsgPlayable;
+    iClassifiedJiffies = aMsg->Jiffies();
+    return aMsg;
+}
+
+Msg* PipelineTracePoint::ProcessMsg(MsgQuit* aMsg)
+{
+    iClassifiedType = EMsgQuit;
+    return aMsg;
+}
+
+
+// PipelineTrace::Stats
+
+PipelineTrace::Stats::Stats()
+    : iName("")
+    , iMsgs(0)
+    , iJiffies(0)
+    , iSpanNs(0)
+    , iP50Ns(0)
+    , iP90Ns(0)
+    , iP99Ns(0)
+    , iMaxNs(0)
+{
+}
+
+
+// PipelineTrace
+
+PipelineTrace::PipelineTrace()
+    : iLock("PTRC")
+    , iEnabled(false)
+    , iEpochNs(PipelineTracePoint::NowNs())
+{
+}
+
+PipelineTrace::~PipelineTrace()
+{
+    for (auto point : iPoints) {
+        delete point;
+    }
+}
+
+PipelineTracePoint& PipelineTrace::CreatePoint(const TChar* aName)
+{
+    AutoMutex _(iLock);
+    auto point = new PipelineTracePoint(*this, aName);
+    if (iEnabled.load()) {
+        point->AllocateRing();
+    }
+    iPoints.push_back(point);
+    return *point;
+}
+
+void PipelineTrace::SetEnabled(TBool aEnabled)
+{
+    AutoMutex _(iLock);
+    if (aEnabled) {
+        // rings are only allocated once tracing is first requested and are never freed
+        // while the pipeline exists, so writers never observe a null ring
+        for (auto point : iPoints) {
+            point->AllocateRing();
+        }
+    }
+    iEnabled.store(aEnabled, std::memory_order_release);
+}
+
+TBool PipelineTrace::Enabled() const
+{
+    return iEnabled.load();
+}
+
+void PipelineTrace::Reset()
+{
+    AutoMutex _(iLock);
+    for (auto point : iPoints) {
+        point->Reset();
+    }
+    iEpochNs = PipelineTracePoint::NowNs();
+}
+
+void PipelineTrace::GetStats(std::vector<Stats>& aStats) const
+{
+    aStats.clear();
+    std::vector<PipelineTracePoint::Event> events;
+    AutoMutex _(iLock);
+    for (auto point : iPoints) {
+        point->Snapshot(events);
+        Stats stats;
+        stats.iName = point->Name();
+        ComputeStats(events, stats);
+        aStats.push_back(stats);
+    }
+}
+
+void PipelineTrace::ComputeStats(std::vector<PipelineTracePoint::Event>& aEvents, Stats& aStats)
+{ // static
+    aStats.iMsgs = (TUint)aEvents.size();
+    aStats.iJiffies = 0;
+    if (aEvents.size() == 0) {
+        return;
+    }
+    TUint64 end = 0;
+    for (const auto& ev : aEvents) {
+        aStats.iJiffies += ev.iJiffies;
+        end = std::max(end, ev.iStartNs + ev.iDurationNs);
+    }
+    aStats.iSpanNs = end - aEvents[0].iStartNs;
+    std::sort(aEvents.begin(), aEvents.end(),
+              [](const PipelineTracePoint::Event& aA, const PipelineTracePoint::Event& aB) {
+                  return aA.iSelfNs < aB.iSelfNs;
+              });
+    const size_t last = aEvents.size() - 1;
+    aStats.iP50Ns = aEvents[(last * 50) / 100].iSelfNs;
+    aStats.iP90Ns = aEvents[(last * 90) / 100].iSelfNs;
+    aStats.iP99Ns = aEvents[(last * 99) / 100].iSelfNs;
+    aStats.iMaxNs = aEvents[last].iSelfNs;
+}
+
+void PipelineTrace::WriteStats(IWriter& aWriter) const
+{
+    std::vector<Stats> stats;
+    GetStats(stats);
+    Bws<256> buf;
+    buf.AppendPrintf("%-24s %8s %10s %14s %10s %10s %10s %10s\n",
+                     "element", "msgs", "msgs/s", "jiffies/s", "p50 (us)", "p90 (us)", "p99 (us)", "max (us)");
+    aWriter.Write(buf);
+    for (const auto& s : stats) {
+        TUint64 msgsPerSec = 0;
+        TUint64 jiffiesPerSec = 0;
+        if (s.iSpanNs > 0) {
+            msgsPerSec = ((TUint64)s.iMsgs * 1000000000LL) / s.iSpanNs;
+            // divide span first to avoid overflowing with large jiffy totals
+            const TUint64 spanUs = std::max(s.iSpanNs / 1000, (TUint64)1);
+            jiffiesPerSec = (s.iJiffies * 1000000LL) / spanUs;
+        }
+        buf.SetBytes(0);
+        buf.AppendPrintf("%-24s %8u %10llu %14llu %10llu %10llu %10llu %10llu\n",
+                         s.iName, s.iMsgs, msgsPerSec, jiffiesPerSec,
+                         s.iP50Ns / 1000, s.iP90Ns / 1000, s.iP99Ns / 1000, s.iMaxNs / 1000);
+        aWriter.Write(buf);
+    }
+}
+
+void PipelineTrace::WriteChromeTrace(IWriter& aWriter) const
+{
+    std::vector<PipelineTracePoint::Event> events;
+    Bws<32> buf;
+    WriterJsonObject root(aWriter);
+    WriterJsonArray traceEvents = root.CreateArray("traceEvents", WriterJsonArray::WriteOnEmpty::eEmptyArray);
+    AutoMutex _(iLock);
+    TUint tid = 1;
+    for (auto point : iPoints) {
+        WriterJsonObject meta = traceEvents.CreateObject();
+        meta.WriteString("name", "thread_name");
+        meta.WriteString("ph", "M");
+        meta.WriteUint("pid", 1);
+        meta.WriteUint("tid", tid);
+        WriterJsonObject metaArgs = meta.CreateObject("args");
+        metaArgs.WriteString("name", point->Name());
+        metaArgs.WriteEnd();
+        meta.WriteEnd();
+
+        point->Snapshot(events);
+        for (const auto& ev : events) {
+            WriterJsonObject obj = traceEvents.CreateObject();
+            obj.WriteString("name", PipelineTracePoint::MsgTypeName(ev.iType));
+            obj.WriteString("cat", "pipeline");
+            obj.WriteString("ph", "X");
+            obj.WriteUint("pid", 1);
+            obj.WriteUint("tid", tid);
+            const TUint64 ts = (ev.iStartNs > iEpochNs? ev.iStartNs - iEpochNs : 0);
+            buf.SetBytes(0);
+            buf.AppendPrintf("%llu.%03u", ts / 1000, (TUint)(ts % 1000));
+            obj.WriteRaw("ts", buf);
+            buf.SetBytes(0);
+            buf.AppendPrintf("%u.%03u", ev.iDurationNs / 1000, ev.iDurationNs % 1000);
+            obj.WriteRaw("dur", buf);
+            WriterJsonObject args = obj.CreateObject("args");
+            args.WriteUint("jiffies", ev.iJiffies);
+            args.WriteUint("selfNs", ev.iSelfNs);
+            args.WriteEnd();
+            obj.WriteEnd();
+        }
+        tid++;
+    }
+    traceEvents.WriteEnd();
+    root.WriteString("displayTimeUnit", "ns");
+    root.WriteEnd();
+}
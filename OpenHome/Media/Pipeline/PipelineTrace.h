@@ -0,0 +1,164 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <atomic>
+#include <vector>
+
+namespace OpenHome {
+    class IWriter;
+namespace Media {
+
+/*
+Low overhead timing of msgs passing through the pipeline.
+Each trace point records the time taken to Pull() (or Push()) one msg, its type and
+the jiffies it carries into a fixed size ring buffer.  Pulls nest (a trace point's Pull()
+includes those of every trace point upstream of it on the same thread) so each event also
+records its self time, excluding time spent in nested trace points.  Stats report self time.  A trace point is only ever written
+by the single thread that pulls/pushes through its element, so no locks are taken on the
+audio path.  Readers take a snapshot of each ring and discard any entries overwritten
+while copying.
+Trace points are normally owned by Logger elements; see Pipeline::Trace().
+*/
+
+class PipelineTrace;
+
+class PipelineTracePoint : private IMsgProcessor, private INonCopyable
+{
+    friend class PipelineTrace;
+public:
+    static const TUint kCapacity = 4096; // must be a power of 2
+    enum EMsgType
+    {
+        EMsgMode
+       ,EMsgTrack
+       ,EMsgDrain
+       ,EMsgDelay
+       ,EMsgEncodedStream
+       ,EMsgStreamSegment
+       ,EMsgAudioEncoded
+       ,EMsgMetaText
+       ,EMsgStreamInterrupted
+       ,EMsgHalt
+       ,EMsgFlush
+       ,EMsgWait
+       ,EMsgDecodedStream
+       ,EMsgBitRate
+       ,EMsgAudioPcm
+       ,EMsgAudioDsd
+       ,EMsgSilence
+       ,EMsgPlayable
+       ,EMsgQuit
+       ,EMsgTypeCount
+    };
+    struct Event
+    {
+        TUint64 iStartNs;
+        TUint iDurationNs;
+        TUint iSelfNs; // iDurationNs less time recorded by trace points nested inside this one
+        TUint iJiffies;
+        TUint iType;
+    };
+    class Span
+    {
+        friend class PipelineTracePoint;
+    public:
+        Span();
+    private:
+        TUint64 iStartNs;
+        TUint64 iOuterNestedNs;
+    };
+public:
+    static TUint64 NowNs();
+    static Span Begin(); // call immediately before the Pull()/Push() passed to Record()
+    static const TChar* MsgTypeName(TUint aType);
+    const TChar* Name() const;
+    inline TBool Enabled() const;
+    void Classify(Msg& aMsg, TUint& aType, TUint& aJiffies);
+    void Record(const Span& aSpan, TUint aType, TUint aJiffies);
+    void Snapshot(std::vector<Event>& aEvents) const;
+private:
+    PipelineTracePoint(PipelineTrace& aTrace, const TChar* aName);
+    ~PipelineTracePoint();
+    void AllocateRing();
+    void Reset();
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgDelay* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgStreamSegment* aMsg) override;
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgMetaText* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgWait* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgBitRate* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgAudioDsd* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private:
+    PipelineTrace& iTrace;
+    const TChar* iName;
+    Event* iRing;
+    std::atomic<TUint64> iWriteIndex;
+    std::atomic<TUint64> iReadFloor; // entries below this were discarded by Reset()
+    TUint iClassifiedType;
+    TUint iClassifiedJiffies;
+};
+
+class PipelineTrace : private INonCopyable
+{
+    friend class PipelineTracePoint;
+public:
+    class Stats
+    {
+    public:
+        Stats();
+    public:
+        const TChar* iName;
+        TUint iMsgs;
+        TUint64 iJiffies;
+        TUint64 iSpanNs;
+        TUint64 iP50Ns;
+        TUint64 iP90Ns;
+        TUint64 iP99Ns;
+        TUint64 iMaxNs;
+    };
+public:
+    PipelineTrace();
+    ~PipelineTrace();
+    PipelineTracePoint& CreatePoint(const TChar* aName);
+    void SetEnabled(TBool aEnabled);
+    TBool Enabled() const;
+    void Reset();
+    void GetStats(std::vector<Stats>& aStats) const;
+    void WriteStats(IWriter& aWriter) const;
+    void WriteChromeTrace(IWriter& aWriter) const; // Chrome trace-event format, load via chrome://tracing
+    static void ComputeStats(std::vector<PipelineTracePoint::Event>& aEvents, Stats& aStats); // sorts aEvents
+private:
+    mutable Mutex iLock;
+    std::vector<PipelineTracePoint*> iPoints;
+    std::atomic<TBool> iEnabled;
+    TUint64 iEpochNs;
+};
+
+// PipelineTracePoint
+
+inline TBool PipelineTracePoint::Enabled() const
+{
+    return iTrace.iEnabled.load(std::memory_order_acquire);
+}
+
+} // namespace Media
+} // namespace OpenHome
+
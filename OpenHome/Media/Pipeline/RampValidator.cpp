@@ -62,6 +62,18 @@ Msg* RampValidator::Pull()
     return msg;
 }
 
+void RampValidator::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    ASSERT(iUpstream != nullptr);
+    MsgQueueLite batch;
+    iUpstream->PullBatch(batch, aMaxJiffies);
+    while (!batch.IsEmpty()) {
+        Msg* msg = batch.Dequeue()->Process(*this);
+        ASSERT(msg != nullptr);
+        aQueue.Enqueue(msg);
+    }
+}
+
 void RampValidator::Push(Msg* aMsg)
 {
     ASSERT(iDownstream != nullptr);
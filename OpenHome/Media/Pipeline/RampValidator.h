@@ -21,6 +21,7 @@ public:
     virtual ~RampValidator();
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 public: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
 private:
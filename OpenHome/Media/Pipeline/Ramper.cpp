@@ -56,6 +56,28 @@ Msg* Ramper::Pull()
     return msg;
 }
 
+void Ramper::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    iUpstreamElement.PullBatch(*this, *this, iUpstreamElement, aQueue, aMaxJiffies);
+}
+
+TBool Ramper::BypassPull() const
+{
+    return iQueue.IsEmpty(); // split msgs must be passed on before anything else is pulled
+}
+
+TBool Ramper::BypassAudio() const
+{
+    return false;
+}
+
+Msg* Ramper::ProcessBypassed(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
+    ASSERT(msg != nullptr);
+    return msg;
+}
+
 Msg* Ramper::ProcessMsg(MsgMode* aMsg)
 {
     iRampJiffies = aMsg->Info().RampPauseResumeLong()?
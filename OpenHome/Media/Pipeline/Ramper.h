@@ -12,7 +12,7 @@ Element which applies a ramp up at the start of a stream when necessary.
 Is NOT responsible for all ramping.  Many other elements also apply ramps in other circumstances.
 */
 
-class Ramper : public PipelineElement, public IPipelineElementUpstream, private INonCopyable
+class Ramper : public PipelineElement, public IPipelineElementUpstream, private IPipelineElementBypassable, private INonCopyable
 {
     friend class SuiteRamper;
 
@@ -22,6 +22,11 @@ public:
     virtual ~Ramper();
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgHalt* aMsg) override;
@@ -32,7 +37,7 @@ private: // IMsgProcessor
 private:
     Msg* ProcessAudio(MsgAudioDecoded* aMsg);
 private:
-    IPipelineElementUpstream& iUpstreamElement;
+    BatchingUpstream iUpstreamElement;
     TUint iStreamId;
     TBool iRamping;
     const TUint iRampJiffiesLong;
@@ -54,7 +54,7 @@ Reporter::Reporter(IPipelineElementUpstream& aUpstreamElement, IPipelineObserver
     */
     ASSERT(iSeconds.is_lock_free());
     ASSERT(iPipelineState.is_lock_free());
-    iEventId = iObserverThread.Register(MakeFunctor(*this, &Reporter::EventCallback));
+    iEventId = iObserverThread.RegisterThrottled(MakeFunctor(*this, &Reporter::EventCallback), kEventIntervalMs);
 }
 
 Reporter::~Reporter()
@@ -81,9 +81,37 @@ void Reporter::SetPipelineState(EPipelineState aState)
 
 Msg* Reporter::Pull()
 {
-    Msg* msg = iUpstreamElement.Pull();
-    (void)msg->Process(*this);
-    return msg;
+    return ProcessBypassed(iUpstreamElement.Pull());
+}
+
+void Reporter::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    MsgQueueLite batch;
+    while (aQueue.IsEmpty()) {
+        iUpstreamElement.PullBatch(batch, aMaxJiffies);
+        while (!batch.IsEmpty()) {
+            Msg* msg = ProcessBypassed(batch.Dequeue());
+            if (msg != nullptr) {
+                aQueue.Enqueue(msg);
+            }
+        }
+    }
+}
+
+TBool Reporter::BypassPull() const
+{
+    return true;
+}
+
+TBool Reporter::BypassAudio() const
+{
+    return false; // audio always updates track position
+}
+
+Msg* Reporter::ProcessBypassed(Msg* aMsg)
+{
+    (void)aMsg->Process(*this);
+    return aMsg;
 }
 
 Msg* Reporter::ProcessMsg(MsgMode* aMsg)
@@ -19,17 +19,23 @@ Is passive - it reports on Msgs but doesn't create/destroy/edit them.
 
 class IPipelineElementObserverThread;
 
-class Reporter : public PipelineElement, public IPipelineElementUpstream, private INonCopyable
+class Reporter : public PipelineElement, public IPipelineElementUpstream, public IPipelineElementBypassable, private INonCopyable
 {
     static const TUint kSupportedMsgTypes;
     static const Brn kNullMetaText;
     static const TUint kTrackNotifyDelayMs = 10;
+    static const TUint kEventIntervalMs = 20; // limits observer notifications during bursts of msgs
 public:
     Reporter(IPipelineElementUpstream& aUpstreamElement, IPipelineObserver& aObserver, IPipelineElementObserverThread& aObserverThread);
     virtual ~Reporter();
     void SetPipelineState(EPipelineState aState);
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+public: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgTrack* aMsg) override;
@@ -119,7 +119,7 @@ protected: // from IMsgProcessor
     Msg* ProcessMsg(MsgFlush* aMsg) override                { return aMsg; }
     Msg* ProcessMsg(MsgWait* aMsg) override                 { return aMsg; }
     Msg* ProcessMsg(MsgDecodedStream* aMsg) override        { ASSERTS(); return aMsg; }
-    Msg* ProcessMsg(MsgBitRate* aMsg) override              { ASSERTS(); return aMsg; }
+    Msg* ProcessMsg(MsgBitRate* aMsg) override              { return aMsg; }
     Msg* ProcessMsg(MsgAudioPcm* aMsg) override             { ASSERTS(); return aMsg; }
     Msg* ProcessMsg(MsgAudioDsd* aMsg) override             { ASSERTS(); return aMsg; }
     Msg* ProcessMsg(MsgSilence* aMsg) override              { ASSERTS(); return aMsg; }
@@ -248,10 +248,10 @@ Msg* MsgCloner::ProcessMsg(MsgDecodedStream* /*aMsg*/)
     return nullptr;
 }
 
-Msg* MsgCloner::ProcessMsg(MsgBitRate* /*aMsg*/)
+Msg* MsgCloner::ProcessMsg(MsgBitRate* aMsg)
 {
-    ASSERTS();
-    return nullptr;
+    aMsg->AddRef();
+    return aMsg;
 }
 
 Msg* MsgCloner::ProcessMsg(MsgAudioPcm* /*aMsg*/)
@@ -371,7 +371,6 @@ Msg* RewinderBufferProcessor::ProcessMsg(MsgDecodedStream* /*aMsg*/)
 
 Msg* RewinderBufferProcessor::ProcessMsg(MsgBitRate* /*aMsg*/)
 {
-    ASSERTS(); // only expect encoded audio at this stage of the pipeline
     return nullptr;
 }
 
@@ -578,10 +577,10 @@ Msg* Rewinder::ProcessMsg(MsgDecodedStream* /*aMsg*/)
     return nullptr;
 }
 
-Msg* Rewinder::ProcessMsg(MsgBitRate* /*aMsg*/)
+Msg* Rewinder::ProcessMsg(MsgBitRate* aMsg)
 {
-    ASSERTS(); // expect this Msg to be generated by a downstream decoder element
-    return nullptr;
+    TryBuffer(aMsg);    // Keep in sequence with audio, as for MsgMetaText.
+    return aMsg;
 }
 
 Msg* Rewinder::ProcessMsg(MsgAudioPcm* /*aMsg*/)
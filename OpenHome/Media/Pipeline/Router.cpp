@@ -27,3 +27,28 @@ Msg* Router::Pull()
     }
     return iUpstream.Pull();
 }
+
+void Router::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    if (iBranch != nullptr) {
+        iBranch->PullBatch(aQueue, aMaxJiffies);
+    }
+    else {
+        iUpstream.PullBatch(aQueue, aMaxJiffies);
+    }
+}
+
+TBool Router::BypassPull() const
+{
+    return iBranch == nullptr;
+}
+
+TBool Router::BypassAudio() const
+{
+    return true;
+}
+
+Msg* Router::ProcessBypassed(Msg* aMsg)
+{
+    return aMsg;
+}
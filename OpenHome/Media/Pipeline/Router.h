@@ -7,13 +7,18 @@
 namespace OpenHome {
 namespace Media {
 
-class Router : public IPipelineElementUpstream, private INonCopyable
+class Router : public IPipelineElementUpstream, public IPipelineElementBypassable, private INonCopyable
 {
 public:
     Router(IPipelineElementUpstream& aUpstream);
     IPipelineElementUpstream& InsertElements(IPipelineElementUpstream& aTail);
 private: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private:
     IPipelineElementUpstream& iUpstream;
     IPipelineElementUpstream* iBranch;
@@ -10,9 +10,9 @@ using namespace OpenHome;
 using namespace OpenHome::Media;
 
 Seeker::Seeker(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstreamElement, ISeeker& aSeeker, ISeekRestreamer& aRestreamer, TUint aRampDuration)
-    : iFlusher(aUpstreamElement, "Seeker")
+    : iUpstreamElement(aUpstreamElement)
+    , iFlusher(iUpstreamElement, "Seeker")
     , iMsgFactory(aMsgFactory)
-    , iUpstreamElement(aUpstreamElement)
     , iSeeker(aSeeker)
     , iRestreamer(aRestreamer)
     , iLock("SEEK")
@@ -91,6 +91,31 @@ Msg* Seeker::Pull()
     return msg;
 }
 
+void Seeker::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    /* Msgs returned part way through a batch have already passed iFlusher.  They are
+       pulled through it again so are still discarded if a seek has started a flush. */
+    iUpstreamElement.PullBatch(*this, *this, iFlusher, aQueue, aMaxJiffies);
+}
+
+TBool Seeker::BypassPull() const
+{
+    /* Read without iLock, as Pull() does.  A stale value only changes whether the next msg
+       is batched; ProcessBypassed() sees the current state. */
+    return iState == ERunning && iQueue.IsEmpty();
+}
+
+TBool Seeker::BypassAudio() const
+{
+    return false;
+}
+
+Msg* Seeker::ProcessBypassed(Msg* aMsg)
+{
+    AutoMutex _(iLock);
+    return aMsg->Process(*this);
+}
+
 Msg* Seeker::ProcessMsg(MsgMode* aMsg)
 {
     iMode.Replace(aMsg->Mode());
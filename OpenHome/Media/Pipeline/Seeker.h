@@ -25,7 +25,7 @@ Calls to Seek() are ignored if a previous seek is in progress
 If TrySeek returned a valid flush id, the MsgFlush with this id is consumed
 */
 
-class Seeker : public IPipelineElementUpstream, private IMsgProcessor, private ISeekObserver
+class Seeker : public IPipelineElementUpstream, private IPipelineElementBypassable, private IMsgProcessor, private ISeekObserver
 {
     friend class SuiteSeeker;
 public:
@@ -34,6 +34,11 @@ public:
     void Seek(TUint aStreamId, TUint aSecondsAbsolute, TBool aRampDown);
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private: // from IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgTrack* aMsg) override;
@@ -70,9 +75,9 @@ private:
        ,EFlushing
     };
 private:
+    BatchingUpstream iUpstreamElement;
     Flusher iFlusher;
     MsgFactory& iMsgFactory;
-    IPipelineElementUpstream& iUpstreamElement;
     ISeeker& iSeeker;
     ISeekRestreamer& iRestreamer;
     Mutex iLock;
@@ -13,7 +13,8 @@ using namespace OpenHome::Media;
 
 Skipper::Skipper(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstreamElement,
                  TUint aRampJiffiesLong, TUint aRampJiffiesShort)
-    : iFlusher(aUpstreamElement, "Skipper")
+    : iUpstreamElement(aUpstreamElement)
+    , iFlusher(iUpstreamElement, "Skipper")
     , iMsgFactory(aMsgFactory)
     , iLock("SKP1")
     , iBlocker("SKP2")
@@ -88,6 +89,30 @@ Msg* Skipper::Pull()
     return msg;
 }
 
+void Skipper::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    // msgs returned part way through a batch go through iFlusher again so are discarded if a skip starts
+    iUpstreamElement.PullBatch(*this, *this, iFlusher, aQueue, aMaxJiffies);
+}
+
+TBool Skipper::BypassPull() const
+{
+    return iState == eRunning && !iHaltPending.load(); // unlocked read; ProcessBypassed() sees the current state
+}
+
+TBool Skipper::BypassAudio() const
+{
+    return false;
+}
+
+Msg* Skipper::ProcessBypassed(Msg* aMsg)
+{
+    iBlocker.Wait();
+    iBlocker.Signal();
+    AutoMutex _(iLock);
+    return aMsg->Process(*this);
+}
+
 Msg* Skipper::ProcessMsg(MsgMode* aMsg)
 {
     iStreamId = IPipelineIdProvider::kStreamIdInvalid;
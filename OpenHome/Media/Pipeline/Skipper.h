@@ -19,7 +19,7 @@ If the pipeline is paused when *RemoveStream() is called, we move straight to pu
 If TryStop returned a valid flush id, the MsgFlush with this id is consumed
 */
 
-class Skipper : public IPipelineElementUpstream, private IMsgProcessor, private IStreamHandler
+class Skipper : public IPipelineElementUpstream, private IPipelineElementBypassable, private IMsgProcessor, private IStreamHandler
 {
     friend class SuiteSkipper;
 public:
@@ -33,6 +33,11 @@ public:
     void RemoveAll(TUint aHaltId, TBool aRampDown);
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private: // from IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgTrack* aMsg) override;
@@ -75,6 +80,7 @@ private:
        ,eFlushing
     };
 private:
+    BatchingUpstream iUpstreamElement;
     Flusher iFlusher;
     MsgFactory& iMsgFactory;
     Mutex iLock;
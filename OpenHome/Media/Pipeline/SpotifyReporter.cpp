@@ -257,19 +257,7 @@ Msg* SpotifyReporter::Pull()
     Msg* msg = nullptr;
     while (msg == nullptr) {
         if (!iInterceptMode) {
-            msg = iUpstreamElement.Pull();
-            msg = msg->Process(*this);
-
-            if (iInterceptMode) {
-                // Mode changed. Need to set up some variables that are
-                // accessed from different threads, so need to acquire iLock.
-                AutoMutex amx(iLock);
-                iMsgDecodedStreamPending = true;
-                iSubSamples = 0;
-                iSubSamplesTrack = 0;
-                iStreamId = kStreamIdInvalid;
-                iTrackDurationMsDecodedStream = 0;
-            }
+            msg = ProcessBypassed(iUpstreamElement.Pull());
         }
         else {
             {
@@ -356,6 +344,51 @@ Msg* SpotifyReporter::Pull()
     return msg;
 }
 
+void SpotifyReporter::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    if (!BypassPull()) {
+        aQueue.Enqueue(Pull());
+        return;
+    }
+    // BypassPull() only changes on a MsgMode, which is always pulled as a batch of one
+    MsgQueueLite batch;
+    while (aQueue.IsEmpty()) {
+        iUpstreamElement.PullBatch(batch, aMaxJiffies);
+        while (!batch.IsEmpty()) {
+            Msg* msg = ProcessBypassed(batch.Dequeue());
+            if (msg != nullptr) {
+                aQueue.Enqueue(msg);
+            }
+        }
+    }
+}
+
+TBool SpotifyReporter::BypassPull() const
+{
+    return !iInterceptMode;
+}
+
+TBool SpotifyReporter::BypassAudio() const
+{
+    return !iInterceptMode;
+}
+
+Msg* SpotifyReporter::ProcessBypassed(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
+    if (iInterceptMode) {
+        // Mode changed. Need to set up some variables that are
+        // accessed from different threads, so need to acquire iLock.
+        AutoMutex amx(iLock);
+        iMsgDecodedStreamPending = true;
+        iSubSamples = 0;
+        iSubSamplesTrack = 0;
+        iStreamId = kStreamIdInvalid;
+        iTrackDurationMsDecodedStream = 0;
+    }
+    return msg;
+}
+
 void SpotifyReporter::AddSpotifyPlaybackObserver(ISpotifyPlaybackObserver& aObserver)
 {
     AutoMutex amx(iLock);
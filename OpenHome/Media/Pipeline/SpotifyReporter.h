@@ -122,7 +122,7 @@ private:
 /*
  * Element to report number of samples seen since last MsgMode.
  */
-class SpotifyReporter : public PipelineElement, public IPipelineElementUpstream, public ISpotifyReporter, public ISpotifyTrackObserver, private INonCopyable
+class SpotifyReporter : public PipelineElement, public IPipelineElementUpstream, public IPipelineElementBypassable, public ISpotifyReporter, public ISpotifyTrackObserver, private INonCopyable
 {
 private:
     static const TUint kSupportedMsgTypes;
@@ -137,6 +137,11 @@ public:
     ~SpotifyReporter();
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+public: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 public: // from ISpotifyReporter
     void AddSpotifyPlaybackObserver(ISpotifyPlaybackObserver& aObserver) override;
     TUint64 SubSamples() const override;
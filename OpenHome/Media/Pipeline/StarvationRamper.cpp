@@ -195,13 +195,55 @@ void FlywheelInput::Flush()
 }
 
 
+// FlywheelTrainer
+
+FlywheelTrainer::FlywheelTrainer(FlywheelRamperManager& aFlywheelRamper)
+    : iFlywheelRamper(aFlywheelRamper)
+{
+}
+
+void FlywheelTrainer::Append(MsgAudio* aAudio)
+{
+    FlywheelPlayableCreator playableCreator;
+    MsgPlayable* playable = playableCreator.CreatePlayable(aAudio);
+    playable->Read(*this);
+    playable->RemoveRef();
+}
+
+void FlywheelTrainer::BeginBlock()
+{
+}
+
+void FlywheelTrainer::ProcessFragment(const Brx& aData, TUint /*aNumChannels*/, TUint aSubsampleBytes)
+{
+    iFlywheelRamper.TrainingAppend(aData, aSubsampleBytes);
+}
+
+void FlywheelTrainer::ProcessSilence(const Brx& aData, TUint /*aNumChannels*/, TUint aSubsampleBytes)
+{
+    iFlywheelRamper.TrainingAppend(aData, aSubsampleBytes);
+}
+
+void FlywheelTrainer::EndBlock()
+{
+}
+
+void FlywheelTrainer::Flush()
+{
+}
+
+
 // RampGenerator
 
-RampGenerator::RampGenerator(MsgFactory& aMsgFactory, TUint aInputJiffies, TUint aRampJiffies, TUint aThreadPriority)
+RampGenerator::RampGenerator(MsgFactory& aMsgFactory, TUint aInputJiffies, TUint aRampJiffies, TUint aThreadPriority,
+                             IPipelineThreadScheduler* aThreadScheduler)
     : iMsgFactory(aMsgFactory)
     , iRampJiffies(aRampJiffies)
+    , iThreadScheduler(aThreadScheduler)
     , iSem("FWRG", 0)
     , iRecentAudio(nullptr)
+    , iFromTraining(false)
+    , iTrainingChannels(0)
     , iSampleRate(0)
     , iNumChannels(0)
     , iBitDepth(0)
@@ -212,6 +254,7 @@ RampGenerator::RampGenerator(MsgFactory& aMsgFactory, TUint aInputJiffies, TUint
     iActive.store(false);
 
     iFlywheelRamper = new FlywheelRamperManager(*this, aInputJiffies, aRampJiffies);
+    iTrainer = new FlywheelTrainer(*iFlywheelRamper);
 
     const TUint minJiffiesPerSample = Jiffies::PerSample(kMaxSampleRate);
     const TUint numSamples = (FlywheelRamperManager::kMaxOutputJiffiesBlockSize + minJiffiesPerSample - 1) / minJiffiesPerSample;
@@ -230,12 +273,42 @@ RampGenerator::~RampGenerator()
     ASSERT(iQueue.IsEmpty());
     delete iThread;
     delete iFlywheelAudio;
+    delete iTrainer;
     delete iFlywheelRamper;
 }
 
 void RampGenerator::Start(const Brx& aRecentAudio, TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint aCurrentRampValue)
 {
     iRecentAudio = &aRecentAudio;
+    iFromTraining = false;
+    DoStart(aSampleRate, aNumChannels, aBitDepth, aCurrentRampValue);
+}
+
+void RampGenerator::TrainingReset(TUint aSampleRate, TUint aNumChannels)
+{
+    ASSERT(!iActive.load());
+    iFlywheelRamper->TrainingReset(aSampleRate, aNumChannels);
+    iTrainingChannels = aNumChannels;
+}
+
+void RampGenerator::TrainingAppend(MsgAudio* aAudio)
+{
+    ASSERT(!iActive.load());
+    iTrainer->Append(aAudio);
+    // called from the animator's pull thread.  Retraining every channel costs ~1.3us per
+    // channel per msg (see FlywheelRamperManager) so is cheaper than Append() above
+    iFlywheelRamper->TrainingUpdate();
+}
+
+void RampGenerator::StartFromTraining(TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint aCurrentRampValue)
+{
+    ASSERT(aNumChannels == iTrainingChannels);
+    iFromTraining = true;
+    DoStart(aSampleRate, aNumChannels, aBitDepth, aCurrentRampValue);
+}
+
+void RampGenerator::DoStart(TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint aCurrentRampValue)
+{
     iSampleRate = aSampleRate;
     iNumChannels = aNumChannels;
     iBitDepth = aBitDepth;
@@ -262,10 +335,18 @@ TBool RampGenerator::TryGetAudio(Msg*& aMsg)
 
 void RampGenerator::FlywheelRamperThread()
 {
+    if (iThreadScheduler != nullptr) {
+        iThreadScheduler->ApplyToCurrentThread(PipelineThread::FlywheelRamper);
+    }
     try {
         for (;;) {
             iThread->Wait();
-            iFlywheelRamper->Ramp(*iRecentAudio, iSampleRate, iNumChannels);
+            if (iFromTraining) {
+                iFlywheelRamper->RampFromTraining();
+            }
+            else {
+                iFlywheelRamper->Ramp(*iRecentAudio, iSampleRate, iNumChannels);
+            }
             iActive.store(false);
             iSem.Signal();
         }
@@ -379,7 +460,9 @@ const TUint StarvationRamper::kMaxAudioOutJiffies = Jiffies::kPerMs * 5;
 StarvationRamper::StarvationRamper(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstream,
                                    IStarvationRamperObserver& aObserver,
                                    IPipelineElementObserverThread& aObserverThread, TUint aSizeJiffies,
-                                   TUint aThreadPriority, TUint aRampUpSize, TUint aMaxStreamCount)
+                                   TUint aThreadPriority, TUint aRampUpSize, TUint aMaxStreamCount,
+                                   Optional<IPipelineThreadScheduler> aThreadScheduler,
+                                   FlywheelTraining aFlywheelTraining)
     : iMsgFactory(aMsgFactory)
     , iUpstream(aUpstream)
     , iObserver(aObserver)
@@ -387,8 +470,10 @@ StarvationRamper::StarvationRamper(MsgFactory& aMsgFactory, IPipelineElementUpst
     , iMaxJiffies(aSizeJiffies)
     , iThreadPriorityFlywheelRamper(aThreadPriority)
     , iThreadPriorityStarvationRamper(iThreadPriorityFlywheelRamper-1)
+    , iThreadScheduler(aThreadScheduler.Ptr())
     , iRampUpJiffies(aRampUpSize)
     , iMaxStreamCount(aMaxStreamCount)
+    , iFlywheelTraining(aFlywheelTraining)
     , iLock("SRM1")
     , iSem("SRM2", 0)
     , iFlywheelInput(kTrainingJiffies)
@@ -419,7 +504,8 @@ StarvationRamper::StarvationRamper(MsgFactory& aMsgFactory, IPipelineElementUpst
     iEventBuffering.store(false); // ensure SetBuffering call below detects a state change
     SetBuffering(true);
 
-    iRampGenerator = new RampGenerator(aMsgFactory, kTrainingJiffies, kRampDownJiffies, iThreadPriorityFlywheelRamper);
+    iRampGenerator = new RampGenerator(aMsgFactory, kTrainingJiffies, kRampDownJiffies,
+                                       iThreadPriorityFlywheelRamper, iThreadScheduler);
     iPullerThread = new ThreadFunctor("StarvationRamper",
                                       MakeFunctor(*this, &StarvationRamper::PullerThread),
                                       iThreadPriorityStarvationRamper);
@@ -468,10 +554,16 @@ inline TBool StarvationRamper::IsFull() const
 
 void StarvationRamper::PullerThread()
 {
+    if (iThreadScheduler != nullptr) {
+        iThreadScheduler->ApplyToCurrentThread(PipelineThread::StarvationRamper);
+    }
+    MsgQueueLite batch;
     do {
-        Msg* msg = iUpstream.Pull();
+        iUpstream.PullBatch(batch, kMaxAudioOutJiffies);
         iLock.Wait();
-        DoEnqueue(msg);
+        while (!batch.IsEmpty()) {
+            DoEnqueue(batch.Dequeue());
+        }
         TBool isFull = IsFull();
         if (isFull) {
             iSem.Clear();
@@ -491,6 +583,13 @@ void StarvationRamper::PullerThread()
 void StarvationRamper::StartFlywheelRamp()
 {
     LOG(kPipeline, "StarvationRamper::StartFlywheelRamp()\n");
+    if (iFlywheelTraining == FlywheelTraining::Incremental && iFormat == AudioFormat::Pcm) {
+        iRampGenerator->StartFromTraining(iSampleRate, iNumChannels, iBitDepth, iCurrentRampValue);
+        iState = State::FlywheelRamping;
+        iStarving = true;
+        iStreamHandler->NotifyStarving(iMode, iStreamId, true);
+        return;
+    }
 //    const TUint startTime = Time::Now(*gEnv);
     if (iRecentAudioJiffies > kTrainingJiffies) {
         TInt excess = iRecentAudioJiffies - kTrainingJiffies;
@@ -543,6 +642,16 @@ void StarvationRamper::NewStream()
     iRecentAudioJiffies = 0;
     iStreamId = IPipelineIdProvider::kStreamIdInvalid;
     iLastPulledAudioRampValue = Ramp::kMax;
+    ResetTraining();
+}
+
+void StarvationRamper::ResetTraining()
+{
+    // as iRecentAudio, training restarts (from silence) for each stream
+    if (iFlywheelTraining == FlywheelTraining::Incremental &&
+        iFormat == AudioFormat::Pcm && iSampleRate != 0) {
+        iRampGenerator->TrainingReset(iSampleRate, iNumChannels);
+    }
 }
 
 void StarvationRamper::ProcessAudioOut(MsgAudio* aMsg)
@@ -560,6 +669,13 @@ void StarvationRamper::ProcessAudioOut(MsgAudio* aMsg)
 
     iLastPulledAudioRampValue = aMsg->Ramp().End();
 
+    if (iFlywheelTraining == FlywheelTraining::Incremental) {
+        if (iFormat == AudioFormat::Pcm) {
+            iRampGenerator->TrainingAppend(aMsg->Clone());
+        }
+        return; // iRecentAudio is only used by FlywheelTraining::OnStarvation
+    }
+
     auto clone = aMsg->Clone();
     iRecentAudio.Enqueue(clone);
     iRecentAudioJiffies += clone->Jiffies();
@@ -671,6 +787,34 @@ Msg* StarvationRamper::Pull()
     return msg;
 }
 
+void StarvationRamper::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    // Only steady state playback is batched.  Start-up, starvation, draining, ramps and
+    // flushes are all left to Pull() which deals with them one msg at a time.
+    if (iState != State::Running
+        || iStartOccupancyJiffies.load() > 0
+        || iStartDrain.load()
+        || IsEmpty()) {
+        aQueue.Enqueue(Pull());
+        return;
+    }
+
+    const TUint count = DoDequeueBatch(aQueue, aMaxJiffies);
+    iLock.Wait();
+    if (!IsFull()) {
+        iSem.Signal();
+    }
+    iLock.Signal();
+    if (count == 0) {
+        aQueue.Enqueue(Pull());
+    }
+}
+
+TBool StarvationRamper::ContinueDequeueBatch() const
+{
+    return iState == State::Running && !iStartDrain.load();
+}
+
 void StarvationRamper::ProcessMsgIn(MsgTrack* /*aMsg*/)
 {
     iTrackStreamCount++;
@@ -776,6 +920,7 @@ Msg* StarvationRamper::ProcessMsgOut(MsgDecodedStream* aMsg)
     iNumChannels = streamInfo.NumChannels();
     iFormat = streamInfo.Format();
     iCurrentRampValue = Ramp::kMax;
+    ResetTraining();
     return aMsg;
 }
 
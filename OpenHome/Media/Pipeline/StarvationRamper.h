@@ -1,7 +1,9 @@
 #pragma once
 
 #include <OpenHome/Types.h>
+#include <OpenHome/Optional.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/ThreadScheduler.h>
 #include <OpenHome/Private/Thread.h>
 
 #include <cstdint>
@@ -30,6 +32,12 @@ public:
     virtual void WaitForOccupancy(TUint aJiffies) = 0;
 };
 
+enum class FlywheelTraining
+{
+    OnStarvation, // train FlywheelRamper from recent audio once starvation is detected
+    Incremental   // retrain as audio is output so that a ramp starts from a ready model
+};
+
 class FlywheelInput : public IPcmProcessor
 {
     static const TUint kMaxSampleRate = 192000;
@@ -59,17 +67,38 @@ private:
 
 class FlywheelRamperManager;
 
+class FlywheelTrainer : public IPcmProcessor
+{
+public:
+    FlywheelTrainer(FlywheelRamperManager& aFlywheelRamper);
+    void Append(MsgAudio* aAudio); // consumes aAudio
+private: // from IPcmProcessor
+    void BeginBlock() override;
+    void ProcessFragment(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override;
+    void ProcessSilence(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override;
+    void EndBlock() override;
+    void Flush() override;
+private:
+    FlywheelRamperManager& iFlywheelRamper;
+};
+
 class RampGenerator : public IPcmProcessor
 {
     static const TUint kMaxSampleRate = 192000; // FIXME - duplicated in FlywheelInput
     static const TUint kMaxChannels = 8;
     static const TUint kSubsampleBytes = 4;
 public:
-    RampGenerator(MsgFactory& iMsgFactory, TUint aInputJiffies, TUint aRampJiffies, TUint aThreadPriority);
+    RampGenerator(MsgFactory& iMsgFactory, TUint aInputJiffies, TUint aRampJiffies, TUint aThreadPriority,
+                  IPipelineThreadScheduler* aThreadScheduler);
     ~RampGenerator();
     void Start(const Brx& aRecentAudio, TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint aCurrentRampValue);
     TBool TryGetAudio(Msg*& aMsg); // returns false / nullptr when all msgs generated & returned
+    // Incremental training.  None of these may be called while a ramp is being generated
+    void TrainingReset(TUint aSampleRate, TUint aNumChannels);
+    void TrainingAppend(MsgAudio* aAudio); // consumes aAudio
+    void StartFromTraining(TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint aCurrentRampValue);
 private:
+    void DoStart(TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint aCurrentRampValue);
     void FlywheelRamperThread();
 private: // from IPcmProcessor
     void BeginBlock() override;
@@ -80,12 +109,16 @@ private: // from IPcmProcessor
 private:
     MsgFactory& iMsgFactory;
     const TUint iRampJiffies;
+    IPipelineThreadScheduler* iThreadScheduler;
     Semaphore iSem;
     FlywheelRamperManager* iFlywheelRamper;
+    FlywheelTrainer* iTrainer;
     Thread* iThread;
     Bwh* iFlywheelAudio;
     MsgQueue iQueue;
     const Brx* iRecentAudio;
+    TBool iFromTraining;
+    TUint iTrainingChannels;
     TUint iSampleRate;
     TUint iNumChannels;
     TUint iBitDepth;
@@ -110,7 +143,9 @@ public:
     StarvationRamper(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstream,
                      IStarvationRamperObserver& aObserver,
                      IPipelineElementObserverThread& aObserverThread, TUint aSizeJiffies,
-                     TUint aThreadPriority, TUint aRampUpSize, TUint aMaxStreamCount);
+                     TUint aThreadPriority, TUint aRampUpSize, TUint aMaxStreamCount,
+                     Optional<IPipelineThreadScheduler> aThreadScheduler,
+                     FlywheelTraining aFlywheelTraining);
     ~StarvationRamper();
     void Flush(TUint aId); // ramps down quickly then discards everything up to a flush with the given id
     void DiscardAllAudio(); // discards any buffered audio, forcing a starvation ramp.  Flushes all audio until the next MsgDrain.
@@ -124,13 +159,16 @@ private:
     void PullerThread();
     void StartFlywheelRamp();
     void NewStream();
+    void ResetTraining();
     void ProcessAudioOut(MsgAudio* aMsg);
     void ApplyRamp(MsgAudioDecoded* aMsg);
     void SetBuffering(TBool aBuffering);
     void EventCallback();
 private: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 private: // from MsgReservoir
+    TBool ContinueDequeueBatch() const override;
     void ProcessMsgIn(MsgTrack* aMsg) override;
     void ProcessMsgIn(MsgDelay* aMsg) override;
     void ProcessMsgIn(MsgHalt* aMsg) override;
@@ -168,8 +206,10 @@ private:
     TUint iMaxJiffies;
     const TUint iThreadPriorityFlywheelRamper;
     const TUint iThreadPriorityStarvationRamper;
+    IPipelineThreadScheduler* iThreadScheduler;
     const TUint iRampUpJiffies;
     const TUint iMaxStreamCount;
+    const FlywheelTraining iFlywheelTraining;
     Mutex iLock;
     Semaphore iSem;
     FlywheelInput iFlywheelInput;
@@ -209,6 +209,32 @@ Msg* Stopper::Pull()
     return msg;
 }
 
+void Stopper::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    iUpstreamElement.PullBatch(*this, *this, iUpstreamElement, aQueue, aMaxJiffies);
+}
+
+TBool Stopper::BypassPull() const
+{
+    // unlocked read; ProcessBypassed() sees the current state
+    return iState == ERunning && !iHaltPending && iQueue.IsEmpty();
+}
+
+TBool Stopper::BypassAudio() const
+{
+    return false;
+}
+
+Msg* Stopper::ProcessBypassed(Msg* aMsg)
+{
+    AutoMutex _(iLock);
+    Msg* msg = aMsg->Process(*this);
+    if (msg != nullptr) {
+        iBuffering = false;
+    }
+    return msg;
+}
+
 Msg* Stopper::ProcessMsg(MsgMode* aMsg)
 {
     iRampJiffies = aMsg->Info().RampPauseResumeLong()?
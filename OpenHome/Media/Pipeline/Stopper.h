@@ -37,7 +37,7 @@ public:
 
 class IPipelineElementObserverThread;
 
-class Stopper : public IPipelineElementUpstream, private IMsgProcessor, private IStreamHandler
+class Stopper : public IPipelineElementUpstream, private IPipelineElementBypassable, private IMsgProcessor, private IStreamHandler
 {
     friend class SuiteStopper;
 public:
@@ -51,6 +51,11 @@ public:
     void Quit();
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private: // from IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgTrack* aMsg) override;
@@ -109,7 +114,7 @@ private:
     static const TChar* State(EState aState);
 private:
     MsgFactory& iMsgFactory;
-    IPipelineElementUpstream& iUpstreamElement;
+    BatchingUpstream iUpstreamElement;
     IStopperObserver& iObserver;
     IPipelineElementObserverThread& iObserverThread;
     Mutex iLock;
@@ -52,6 +52,17 @@ Msg* TrackInspector::Pull()
     return msg;
 }
 
+void TrackInspector::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    MsgQueueLite batch;
+    iUpstreamElement.PullBatch(batch, aMaxJiffies);
+    while (!batch.IsEmpty()) {
+        Msg* msg = batch.Dequeue();
+        (void)msg->Process(*this);
+        aQueue.Enqueue(msg);
+    }
+}
+
 void TrackInspector::NotifyTrackPlaying()
 {
     ASSERT(iTrack!=nullptr);
@@ -35,6 +35,7 @@ public:
     void AddObserver(ITrackObserver& aObserver);
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 private:
     void NotifyTrackPlaying();
     void NotifyTrackFailed();
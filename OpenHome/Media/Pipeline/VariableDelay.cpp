@@ -194,6 +194,30 @@ Msg* VariableDelayBase::Pull()
     return msg;
 }
 
+void VariableDelayBase::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    iUpstreamElement.PullBatch(*this, *this, iUpstreamElement, aQueue, aMaxJiffies);
+}
+
+TBool VariableDelayBase::BypassPull() const
+{
+    // only a running delay pulls straight from upstream; delay changes and ramps go via DoPull()
+    return iStatus == ERunning
+        && !iWaitForAudioBeforeGeneratingSilence
+        && iPendingStream == nullptr
+        && iQueue.IsEmpty();
+}
+
+TBool VariableDelayBase::BypassAudio() const
+{
+    return false;
+}
+
+Msg* VariableDelayBase::ProcessBypassed(Msg* aMsg)
+{
+    return aMsg->Process(*this);
+}
+
 Msg* VariableDelayBase::DoPull()
 {
     Msg* msg = nullptr;
@@ -648,6 +672,11 @@ Msg* VariableDelayRight::Pull()
     return VariableDelayBase::Pull();
 }
 
+TBool VariableDelayRight::BypassPull() const
+{
+    return !iPostPipelineLatencyChanged.load() && VariableDelayBase::BypassPull();
+}
+
 Msg* VariableDelayRight::ProcessMsg(MsgMode* aMsg)
 {
     iDelayJiffiesTotal = 0;
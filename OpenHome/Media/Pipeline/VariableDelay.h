@@ -27,7 +27,7 @@ public:
     virtual void NotifyDelayApplied(TUint aJiffies) = 0;
 };
 
-class VariableDelayBase : public PipelineElement, public IPipelineElementUpstream
+class VariableDelayBase : public PipelineElement, public IPipelineElementUpstream, protected IPipelineElementBypassable
 {
     static const TUint kMaxMsgSilenceDuration = Jiffies::kPerMs * 2;
     friend class SuiteVariableDelay;
@@ -41,6 +41,11 @@ protected:
     VariableDelayBase(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstreamElement, TUint aRampDuration, const TChar* aId);
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+protected: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 protected:
     void HandleDelayChange(TUint aNewDelay);
     inline const TChar* Status() const;
@@ -81,7 +86,7 @@ protected:
     TInt iDelayAdjustment;
     MsgDecodedStream* iDecodedStream;
 private:
-    IPipelineElementUpstream& iUpstreamElement;
+    BatchingUpstream iUpstreamElement;
     const TUint iRampDuration;
     const TChar* iId;
     MsgQueueLite iQueue;
@@ -122,6 +127,8 @@ public:
                        TUint aRampDuration, TUint aMinDelay);
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+private: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
 private: // from PipelineElement (IMsgProcessor)
     using VariableDelayBase::ProcessMsg;
     Msg* ProcessMsg(MsgMode* aMsg) override;
@@ -98,6 +98,27 @@ Msg* Waiter::Pull()
     return msg;
 }
 
+void Waiter::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    iUpstreamElement.PullBatch(*this, *this, iUpstreamElement, aQueue, aMaxJiffies);
+}
+
+TBool Waiter::BypassPull() const
+{
+    return iState == ERunning && iQueue.IsEmpty(); // unlocked read; ProcessBypassed() sees the current state
+}
+
+TBool Waiter::BypassAudio() const
+{
+    return false;
+}
+
+Msg* Waiter::ProcessBypassed(Msg* aMsg)
+{
+    AutoMutex _(iLock);
+    return aMsg->Process(*this);
+}
+
 Msg* Waiter::ProcessMsg(MsgMode* aMsg)
 {
     if (iState != ERunning) {
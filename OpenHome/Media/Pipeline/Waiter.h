@@ -32,7 +32,7 @@ public:
 
 class IPipelineElementObserverThread;
 
-class Waiter : public PipelineElement, public IPipelineElementUpstream
+class Waiter : public PipelineElement, public IPipelineElementUpstream, private IPipelineElementBypassable
 {
     static const TUint kSupportedMsgTypes;
 public:
@@ -42,6 +42,11 @@ public:
     void Wait(TUint aFlushId, TBool aRampDown);
 public: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
 private: // from IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgMetaText* aMsg) override;
@@ -71,7 +76,7 @@ private:
     };
 private:
     MsgFactory& iMsgFactory;
-    IPipelineElementUpstream& iUpstreamElement;
+    BatchingUpstream iUpstreamElement;
     IWaiterObserver& iObserver;
     IPipelineElementObserverThread& iObserverThread;
     Mutex iLock;
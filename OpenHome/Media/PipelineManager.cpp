@@ -1,6 +1,7 @@
 #include <OpenHome/Media/PipelineManager.h>
 #include <OpenHome/Media/Pipeline/Pipeline.h>
 #include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Protocol/UrlBlockCache.h>
 #include <OpenHome/Media/Filler.h>
 #include <OpenHome/Media/IdManager.h>
 #include <OpenHome/Private/Printer.h>
@@ -62,7 +63,9 @@ PipelineManager::PipelineManager(PipelineInitParams* aInitParams, IInfoAggregato
                          iPipeline->Factory(), aTrackFactory, *iPrefetchObserver,
                          *iIdManager, PhaseAdjuster(), iFillerPriority,
                          iPipeline->SenderMinLatencyMs() * Jiffies::kPerMs);
-    iProtocolManager = new ProtocolManager(*iFiller, iPipeline->Factory(), *iIdManager, *iPipeline);
+    iFiller->SetThreadScheduler(iPipeline->Scheduler());
+    iProtocolManager = new ProtocolManager(*iFiller, iPipeline->Factory(), *iIdManager, *iPipeline, aInfoAggregator);
+    iUrlBlockCache = new UrlBlockCache(*iProtocolManager, aInfoAggregator);
     iFiller->Start(*iProtocolManager);
 }
 
@@ -70,6 +73,7 @@ PipelineManager::~PipelineManager()
 {
     delete iPipeline;
     delete iPrefetchObserver;
+    delete iUrlBlockCache;
     delete iProtocolManager;
     delete iFiller;
     delete iIdManager;
@@ -185,6 +189,11 @@ MsgFactory& PipelineManager::Factory()
     return iPipeline->Factory();
 }
 
+PipelineTrace& PipelineManager::Trace()
+{
+    return iPipeline->Trace();
+}
+
 void PipelineManager::Begin(const Brx& aMode, TUint aTrackId)
 {
     AutoMutex _(iPublicLock);
@@ -489,7 +498,7 @@ TUint PipelineManager::SeekRestream(const Brx& aMode, TUint aTrackId)
 
 TBool PipelineManager::TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes)
 {
-    return iProtocolManager->TryGet(aWriter, aUrl, aOffset, aBytes);
+    return iUrlBlockCache->TryGet(aWriter, aUrl, aOffset, aBytes);
 }
 
 
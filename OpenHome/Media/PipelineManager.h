@@ -21,8 +21,10 @@ namespace Media {
     }
 class Pipeline;
 class PipelineInitParams;
+class PipelineTrace;
 class IPipelineAnimator;
 class ProtocolManager;
+class UrlBlockCache;
 class ITrackObserver;
 class Filler;
 class IdManager;
@@ -179,6 +181,13 @@ public:
      *          it to adjust the initial phase delay of streams that require lip syncing.
      */
     IClockPuller& PhaseAdjuster();
+    /**
+     * Retrieve per-element timing traces.
+     *
+     * @return  PipelineTrace that can be enabled to record how long each msg takes
+     *          to pass each (logger) element of the pipeline.
+     */
+    PipelineTrace& Trace();
     /**
      * Instruct the pipeline what should be streamed next.
      *
@@ -340,6 +349,7 @@ private:
     Mutex iPublicLock;
     Pipeline* iPipeline;
     ProtocolManager* iProtocolManager;
+    UrlBlockCache* iUrlBlockCache;
     TUint iFillerPriority;
     Filler* iFiller;
     IdManager* iIdManager;
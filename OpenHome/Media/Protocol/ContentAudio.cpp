@@ -26,6 +26,11 @@ TBool ContentAudio::Recognise(const Brx& /*aUri*/, const Brx& /*aMimeType*/, con
     return true;
 }
 
+ISupplyBuffer* ContentAudio::SupplyBuffer()
+{
+    return iSupply;
+}
+
 ProtocolStreamResult ContentAudio::Stream(IReader& aReader, TUint64 aTotalBytes)
 {
     static const TUint kBlocksPerYield = 12; /* Pipeline threads will take priority over
@@ -22,8 +22,9 @@ public:
 private: // from ContentProcessor
     TBool Recognise(const Brx& aUri, const Brx& aMimeType, const Brx& aData);
     ProtocolStreamResult Stream(IReader& aReader, TUint64 aTotalBytes);
+    ISupplyBuffer* SupplyBuffer() override;
 private:
-    SupplyAggregator* iSupply;
+    SupplyAggregatorBytes* iSupply;
 };
 
 } // namespace Media
@@ -0,0 +1,241 @@
+#include <OpenHome/Media/Protocol/HttpConnectionPool.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/SocketHttp.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Uri.h>
+
+#include <iterator>
+#include <list>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// HttpConnectionPool::Connection
+
+HttpConnectionPool::Connection::Connection(Environment& aEnv, SslContext& aSsl, const Brx& aKey)
+    : iEnv(aEnv)
+    , iSocket(aEnv, aSsl, Brx::Empty(), kReadBufferBytes, kWriteBufferBytes, kConnectTimeoutMs, kResponseTimeoutMs, false /* redirects would change the key */)
+    , iKey(aKey)
+    , iIdleSinceMs(0)
+    , iReused(false)
+{
+}
+
+SocketHttp& HttpConnectionPool::Connection::Socket()
+{
+    return iSocket;
+}
+
+TBool HttpConnectionPool::Connection::Reused() const
+{
+    return iReused;
+}
+
+void HttpConnectionPool::Connection::Interrupt(TBool aInterrupt)
+{
+    iSocket.Interrupt(aInterrupt);
+}
+
+
+// HttpConnectionPool
+
+const Brn HttpConnectionPool::kQueryConnections("connections");
+
+HttpConnectionPool::HttpConnectionPool()
+    : iLock("HCPL")
+    , iHits(0)
+    , iMisses(0)
+    , iExpired(0)
+    , iEvicted(0)
+    , iHandshakes(0)
+    , iHandshakeUsTotal(0)
+    , iHandshakeUsMax(0)
+{
+}
+
+HttpConnectionPool::HttpConnectionPool(IInfoAggregator& aInfoAggregator)
+    : HttpConnectionPool()
+{
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryConnections);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+HttpConnectionPool::~HttpConnectionPool()
+{
+    for (auto conn : iIdle) {
+        delete conn;
+    }
+}
+
+HttpConnectionPool::Connection* HttpConnectionPool::Acquire(Environment& aEnv, SslContext& aSsl, const Uri& aUri)
+{
+    Bws<kMaxKeyBytes> key;
+    try {
+        MakeKey(aUri, key);
+    }
+    catch (BufferOverflow&) {
+        THROW(SocketHttpUriError);
+    }
+
+    Connection* conn = nullptr;
+    std::list<Connection*> expired;
+    {
+        AutoMutex _(iLock);
+        RemoveExpiredLocked(Os::TimeInMs(aEnv.OsCtx()), expired);
+        // most recently used connections are least likely to have been closed by the server
+        for (auto it = iIdle.rbegin(); it != iIdle.rend(); ++it) {
+            if ((*it)->iKey == key) {
+                conn = *it;
+                iIdle.erase(std::next(it).base());
+                break;
+            }
+        }
+    }
+    for (auto c : expired) {
+        delete c;
+    }
+
+    if (conn != nullptr) {
+        iHits++;
+    }
+    else {
+        iMisses++;
+        conn = new Connection(aEnv, aSsl, key);
+    }
+    try {
+        conn->iSocket.Reset();
+        conn->iSocket.SetUri(aUri);
+    }
+    catch (SocketHttpUriError&) {
+        delete conn;
+        throw;
+    }
+    conn->iReused = conn->iSocket.IsConnected();
+    return conn;
+}
+
+void HttpConnectionPool::Connect(Connection& aConnection)
+{
+    if (aConnection.iSocket.IsConnected()) {
+        return;
+    }
+    aConnection.iReused = false;
+    OsContext* osCtx = aConnection.iEnv.OsCtx();
+    const TUint64 start = Os::TimeInUs(osCtx);
+    aConnection.iSocket.Connect();
+    const TUint64 elapsed = Os::TimeInUs(osCtx) - start;
+    iHandshakes++;
+    iHandshakeUsTotal += elapsed;
+    TUint64 max = iHandshakeUsMax.load();
+    while (elapsed > max && !iHandshakeUsMax.compare_exchange_weak(max, elapsed)) {
+    }
+}
+
+void HttpConnectionPool::Release(Connection* aConnection, TBool aReusable)
+{
+    aConnection->Interrupt(false);
+    if (!aReusable || !aConnection->iSocket.IsConnected()) {
+        delete aConnection;
+        return;
+    }
+    aConnection->iIdleSinceMs = Os::TimeInMs(aConnection->iEnv.OsCtx());
+
+    std::list<Connection*> discard;
+    {
+        AutoMutex _(iLock);
+        RemoveExpiredLocked(aConnection->iIdleSinceMs, discard);
+        TUint sameKey = 0;
+        for (auto conn : iIdle) {
+            if (conn->iKey == aConnection->iKey) {
+                sameKey++;
+            }
+        }
+        if (sameKey >= kMaxIdlePerHost) {
+            discard.push_back(aConnection);
+            iEvicted++;
+        }
+        else {
+            if (iIdle.size() >= kMaxIdle) {
+                discard.push_back(iIdle.front());
+                iIdle.pop_front();
+                iEvicted++;
+            }
+            iIdle.push_back(aConnection);
+        }
+    }
+    for (auto conn : discard) {
+        delete conn;
+    }
+}
+
+TUint HttpConnectionPool::IdleCount() const
+{
+    AutoMutex _(iLock);
+    return static_cast<TUint>(iIdle.size());
+}
+
+void HttpConnectionPool::GetStats(TUint64& aHits, TUint64& aMisses, TUint64& aHandshakes, TUint64& aHandshakeUsTotal) const
+{
+    aHits = iHits.load();
+    aMisses = iMisses.load();
+    aHandshakes = iHandshakes.load();
+    aHandshakeUsTotal = iHandshakeUsTotal.load();
+}
+
+void HttpConnectionPool::MakeKey(const Uri& aUri, Bwx& aKey)
+{ // static
+    aKey.Replace(aUri.Scheme());
+    aKey.Append(Brn("://"));
+    aKey.Append(aUri.Host());
+    aKey.Append(':');
+    TInt port = aUri.Port();
+    if (port == Uri::kPortNotSpecified) {
+        port = (aUri.Scheme() == Brn("https")? 443 : 80);
+    }
+    Ascii::AppendDec(aKey, port);
+}
+
+void HttpConnectionPool::RemoveExpiredLocked(TUint aNowMs, std::list<Connection*>& aExpired)
+{
+    // iIdle is ordered by release time so expired connections are all at the front
+    while (iIdle.size() > 0 && aNowMs - iIdle.front()->iIdleSinceMs >= kIdleTimeoutMs) {
+        aExpired.push_back(iIdle.front());
+        iIdle.pop_front();
+        iExpired++;
+    }
+}
+
+void HttpConnectionPool::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    if (aQuery != kQueryConnections) {
+        return;
+    }
+    TUint64 hits, misses, handshakes, handshakeUsTotal;
+    GetStats(hits, misses, handshakes, handshakeUsTotal);
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("HttpConnectionPool\n    idle="));
+    writer.WriteUint(IdleCount());
+    writer.Write(Brn(" hits="));
+    writer.WriteUint64(hits);
+    writer.Write(Brn(" misses="));
+    writer.WriteUint64(misses);
+    writer.Write(Brn(" expired="));
+    writer.WriteUint64(iExpired.load());
+    writer.Write(Brn(" evicted="));
+    writer.WriteUint64(iEvicted.load());
+    writer.Write(Brn(" handshakes="));
+    writer.WriteUint64(handshakes);
+    writer.Write(Brn(" handshakeAvgUs="));
+    writer.WriteUint64(handshakes == 0? 0 : handshakeUsTotal / handshakes);
+    writer.Write(Brn(" handshakeMaxUs="));
+    writer.WriteUint64(iHandshakeUsMax.load());
+    writer.Write(Brn("\n"));
+}
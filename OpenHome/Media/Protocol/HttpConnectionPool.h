@@ -0,0 +1,104 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/SocketHttp.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Uri.h>
+
+#include <atomic>
+#include <list>
+
+namespace OpenHome {
+    class Environment;
+    class SslContext;
+namespace Media {
+
+/*
+ * Persistent (keep-alive) HTTP connections, shared by all protocols owned by a ProtocolManager.
+ *
+ * Idle connections are keyed by scheme://host:port.  At most kMaxIdlePerHost are kept for
+ * any key and kMaxIdle in total (oldest discarded first).  A connection idle for longer than
+ * kIdleTimeoutMs is closed rather than reused as the server has probably timed it out.
+ * Servers may still close an idle connection at any time so callers should retry a request
+ * that failed on a Reused() connection once, on a new connection.
+ *
+ * Acquire() never blocks on the network.  Connect() opens (TCP and, for https, TLS) a
+ * connection that isn't already open; these handshakes are counted and timed.
+ *
+ * Clients that write their own requests and parse their own responses (e.g. ProtocolHttp
+ * streams, which need ICY and other headers) can do so over SocketHttp::Socket().  They
+ * should only Release() a connection as reusable after reading a response body in full.
+ */
+class HttpConnectionPool : private IInfoProvider, private INonCopyable
+{
+public:
+    static const Brn kQueryConnections;
+    static const TUint kIdleTimeoutMs = 10 * 1000;
+    static const TUint kMaxIdlePerHost = 2;
+    static const TUint kMaxIdle = 8;
+    static const TUint kReadBufferBytes = 6 * 1024;
+    static const TUint kConnectTimeoutMs = 3000;
+private:
+    static const TUint kWriteBufferBytes = 1024;
+    static const TUint kResponseTimeoutMs = 60 * 1000;
+    static const TUint kMaxKeyBytes = 300; // scheme:// + max DNS name + :port
+public:
+    class Connection : private INonCopyable
+    {
+        friend class HttpConnectionPool;
+    public:
+        SocketHttp& Socket();
+        TBool Reused() const; // true if this connection was open before Acquire() returned it
+        void Interrupt(TBool aInterrupt);
+    private:
+        Connection(Environment& aEnv, SslContext& aSsl, const Brx& aKey);
+    private:
+        Environment& iEnv;
+        SocketHttp iSocket;
+        Bws<kMaxKeyBytes> iKey;
+        TUint iIdleSinceMs;
+        TBool iReused;
+    };
+public:
+    HttpConnectionPool();
+    HttpConnectionPool(IInfoAggregator& aInfoAggregator);
+    ~HttpConnectionPool();
+    /*
+     * Returns an idle connection to aUri's server if one is available or a new, unopened,
+     * one if not.  The request is reset to a GET of aUri with no custom headers.
+     *
+     * Throws SocketHttpUriError.
+     */
+    Connection* Acquire(Environment& aEnv, SslContext& aSsl, const Uri& aUri);
+    /*
+     * Throws SocketHttpConnectionError.
+     */
+    void Connect(Connection& aConnection);
+    /*
+     * aReusable should only be true if the last response body was read in full.
+     * Transfers ownership of aConnection back to the pool.
+     */
+    void Release(Connection* aConnection, TBool aReusable);
+    TUint IdleCount() const;
+    void GetStats(TUint64& aHits, TUint64& aMisses, TUint64& aHandshakes, TUint64& aHandshakeUsTotal) const;
+private:
+    static void MakeKey(const Uri& aUri, Bwx& aKey);
+    void RemoveExpiredLocked(TUint aNowMs, std::list<Connection*>& aExpired);
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
+private:
+    mutable Mutex iLock;
+    std::list<Connection*> iIdle; // least recently used first
+    std::atomic<TUint64> iHits;
+    std::atomic<TUint64> iMisses;
+    std::atomic<TUint64> iExpired;
+    std::atomic<TUint64> iEvicted;
+    std::atomic<TUint64> iHandshakes;
+    std::atomic<TUint64> iHandshakeUsTotal;
+    std::atomic<TUint64> iHandshakeUsMax;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -1,5 +1,7 @@
 #include <OpenHome/Media/Protocol/Protocol.h>
 #include <OpenHome/Media/Protocol/ContentAudio.h>
+#include <OpenHome/Media/Protocol/HttpConnectionPool.h>
+#include <OpenHome/Media/SupplyAggregator.h>
 #include <OpenHome/Exception.h>
 #include <OpenHome/SocketSsl.h>
 #include <OpenHome/Private/Debug.h>
@@ -100,14 +102,94 @@ Protocol::AutoStream::~AutoStream()
 
 
 
+// ReaderSocket
+
+ReaderSocket::ReaderSocket(IReaderSource& aSource, TUint aBufferBytes)
+    : iSource(aSource)
+    , iBuf(aBufferBytes)
+    , iOffset(0)
+    , iSupplyBuffer(nullptr)
+{
+}
+
+void ReaderSocket::SetSupplyBuffer(ISupplyBuffer* aSupplyBuffer)
+{
+    iSupplyBuffer = aSupplyBuffer;
+}
+
+Brn ReaderSocket::Read(TUint aBytes)
+{
+    if (aBytes == 0) {
+        return Brn(Brx::Empty());
+    }
+    if (iOffset == iBuf.Bytes()) {
+        if (iSupplyBuffer != nullptr) {
+            TUint bytes = aBytes;
+            TByte* ptr = iSupplyBuffer->WriteBuffer(bytes);
+            Bwn buf(ptr, 0, bytes);
+            iSource.Read(buf);
+            return Brn(buf);
+        }
+        iBuf.SetBytes(0);
+        iOffset = 0;
+        iSource.Read(iBuf);
+    }
+    const TUint bytes = std::min(aBytes, iBuf.Bytes() - iOffset);
+    Brn buf(iBuf.Ptr() + iOffset, bytes);
+    iOffset += bytes;
+    return buf;
+}
+
+void ReaderSocket::ReadFlush()
+{
+    iBuf.SetBytes(0);
+    iOffset = 0;
+}
+
+void ReaderSocket::ReadInterrupt()
+{
+    iSource.ReadInterrupt();
+}
+
+
+// AutoSupplyBuffer
+
+namespace OpenHome {
+namespace Media {
+
+class AutoSupplyBuffer : private INonCopyable
+{
+public:
+    AutoSupplyBuffer(ReaderSocket& aReader, ContentProcessor& aProcessor);
+    ~AutoSupplyBuffer();
+private:
+    ReaderSocket& iReader;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+AutoSupplyBuffer::AutoSupplyBuffer(ReaderSocket& aReader, ContentProcessor& aProcessor)
+    : iReader(aReader)
+{
+    iReader.SetSupplyBuffer(aProcessor.SupplyBuffer());
+}
+
+AutoSupplyBuffer::~AutoSupplyBuffer()
+{
+    iReader.SetSupplyBuffer(nullptr);
+}
+
+
 // ProtocolNetwork  
 
-ProtocolNetwork::ProtocolNetwork(Environment& aEnv)
+ProtocolNetwork::ProtocolNetwork(Environment& aEnv, TUint aReadBufferBytes, TUint aRecvBufBytes)
     : Protocol(aEnv)
-    , iReaderBuf(iTcpClient)
+    , iReaderBuf(iTcpClient, aReadBufferBytes)
     , iWriterBuf(iTcpClient)
     , iLock("PRNW")
     , iSocketIsOpen(false)
+    , iRecvBufBytes(aRecvBufBytes)
 {
 }
 
@@ -154,6 +236,12 @@ TBool ProtocolNetwork::Connect(const Uri& aUri, TUint aDefaultPort, TUint aTimeo
     return true;
 }
 
+ProtocolStreamResult ProtocolNetwork::StreamAudio(ContentProcessor& aProcessor, IReader& aReader, TUint64 aTotalBytes)
+{
+    AutoSupplyBuffer _(iReaderBuf, aProcessor);
+    return aProcessor.Stream(aReader, aTotalBytes);
+}
+
 void ProtocolNetwork::Interrupt(TBool aInterrupt)
 {
     iLock.Wait();
@@ -170,6 +258,9 @@ void ProtocolNetwork::Open()
     iTcpClient.Open(iEnv);
     ASSERT(!iSocketIsOpen);
     iSocketIsOpen = true;
+    if (iRecvBufBytes > 0) {
+        iTcpClient.SetRecvBufBytes(iRecvBufBytes);
+    }
 }
     
 void ProtocolNetwork::Close()
@@ -187,10 +278,11 @@ void ProtocolNetwork::Close()
 
 // ProtocolNetworkSsl
 ProtocolNetworkSsl::ProtocolNetworkSsl(Environment& aEnv,
-                                       SslContext& aSsl)
+                                       SslContext& aSsl,
+                                       TUint aReadBufferBytes)
     : Protocol(aEnv)
-    , iSocket(aEnv, aSsl, kReadBufferBytes)
-    , iReaderBuf(iSocket)
+    , iSocket(aEnv, aSsl, aReadBufferBytes)
+    , iReaderBuf(iSocket, aReadBufferBytes)
     , iWriterBuf(iSocket)
     , iLock("PRNWS")
     , iSocketIsOpen(false)
@@ -243,6 +335,12 @@ TBool ProtocolNetworkSsl::Connect(const Uri& aUri,
     return true;
 }
 
+ProtocolStreamResult ProtocolNetworkSsl::StreamAudio(ContentProcessor& aProcessor, IReader& aReader, TUint64 aTotalBytes)
+{
+    AutoSupplyBuffer _(iReaderBuf, aProcessor);
+    return aProcessor.Stream(aReader, aTotalBytes);
+}
+
 
 void ProtocolNetworkSsl::Interrupt(TBool aInterrupt)
 {
@@ -312,6 +410,11 @@ void ContentProcessor::Reset()
     iReader = nullptr;
 }
 
+ISupplyBuffer* ContentProcessor::SupplyBuffer()
+{
+    return nullptr;
+}
+
 void ContentProcessor::SetStream(IReader& aStream)
 {
     iReader = &aStream;
@@ -473,6 +576,18 @@ ProtocolManager::ProtocolManager(IPipelineElementDownstream& aDownstream, MsgFac
     , iLock("PMGR")
 {
     iAudioProcessor = new ContentAudio(aMsgFactory, aDownstream);
+    iConnectionPool = new HttpConnectionPool();
+}
+
+ProtocolManager::ProtocolManager(IPipelineElementDownstream& aDownstream, MsgFactory& aMsgFactory, IPipelineIdProvider& aIdProvider, IFlushIdProvider& aFlushIdProvider, IInfoAggregator& aInfoAggregator)
+    : iDownstream(aDownstream)
+    , iMsgFactory(aMsgFactory)
+    , iIdProvider(aIdProvider)
+    , iFlushIdProvider(aFlushIdProvider)
+    , iLock("PMGR")
+{
+    iAudioProcessor = new ContentAudio(aMsgFactory, aDownstream);
+    iConnectionPool = new HttpConnectionPool(aInfoAggregator);
 }
 
 ProtocolManager::~ProtocolManager()
@@ -486,6 +601,7 @@ ProtocolManager::~ProtocolManager()
         delete iContentProcessors[i];
     }
     delete iAudioProcessor;
+    delete iConnectionPool; // after protocols, which may hold connections
 }
 
 void ProtocolManager::Add(Protocol* aProtocol)
@@ -494,6 +610,11 @@ void ProtocolManager::Add(Protocol* aProtocol)
     aProtocol->Initialise(*this, iIdProvider, iMsgFactory, iDownstream, iFlushIdProvider);
 }
 
+HttpConnectionPool& ProtocolManager::ConnectionPool()
+{
+    return *iConnectionPool;
+}
+
 void ProtocolManager::Add(ContentProcessor* aProcessor)
 {
     iContentProcessors.push_back(aProcessor);
@@ -49,6 +49,8 @@ public:
 };
 
 class ContentProcessor;
+class HttpConnectionPool;
+class ISupplyBuffer;
 class IProtocolManager : public IProtocolSet
 {
 public:
@@ -57,6 +59,7 @@ public:
     virtual ContentProcessor* GetContentProcessor(const Brx& aUri, const Brx& aMimeType, const Brx& aData) const = 0;
     virtual ContentProcessor* GetAudioProcessor() const = 0;
     virtual TBool Get(IWriter& aWriter, const Brx& aUri, TUint64 aOffset, TUint aBytes) = 0;
+    virtual HttpConnectionPool& ConnectionPool() = 0;
 };
 
 /**
@@ -150,6 +153,28 @@ private:
     };
 };
 
+/*
+ * Buffered reader for a protocol's socket.  Behaves as Srs unless SetSupplyBuffer() is passed
+ * a non-null buffer.  Reads that can't be satisfied from already buffered data then receive
+ * directly into the EncodedAudio that the supply is filling, so audio isn't copied on its
+ * way from the socket to the pipeline.
+ */
+class ReaderSocket : public IReader, private INonCopyable
+{
+public:
+    ReaderSocket(IReaderSource& aSource, TUint aBufferBytes);
+    void SetSupplyBuffer(ISupplyBuffer* aSupplyBuffer);
+public: // from IReader
+    Brn Read(TUint aBytes) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+private:
+    IReaderSource& iSource;
+    Bwh iBuf;
+    TUint iOffset;
+    ISupplyBuffer* iSupplyBuffer;
+};
+
 class ProtocolNetwork : public Protocol
 {
 protected:
@@ -157,19 +182,29 @@ protected:
     static const TUint kWriteBufferBytes = 1024;
     static const TUint kConnectTimeoutMs = 3000;
 protected:
-    ProtocolNetwork(Environment& aEnv);
+    /*
+     * aRecvBufBytes sets the socket's receive buffer size.  0 uses the OS default.
+     */
+    ProtocolNetwork(Environment& aEnv, TUint aReadBufferBytes = kReadBufferBytes, TUint aRecvBufBytes = 0);
     TBool Connect(const Uri& aUri, TUint aDefaultPort, TUint aTimeoutMs = kConnectTimeoutMs);
+    /*
+     * Streams audio via aProcessor.  aReader must read from iReaderBuf.  If aProcessor supports
+     * it, data no longer buffered by iReaderBuf is read directly into the pipeline's msgs.
+     */
+    ProtocolStreamResult StreamAudio(ContentProcessor& aProcessor, IReader& aReader, TUint64 aTotalBytes);
 protected: // from Protocol
     void Interrupt(TBool aInterrupt) override;
 protected:
     void Open();
     void Close();
 protected:
-    Srs<kReadBufferBytes> iReaderBuf;
+    ReaderSocket iReaderBuf;
     Sws<kWriteBufferBytes> iWriterBuf;
     SocketTcpClient iTcpClient;
     Mutex iLock;
     TBool iSocketIsOpen;
+private:
+    const TUint iRecvBufBytes;
 };
 
 class ProtocolNetworkSsl : public Protocol
@@ -180,9 +215,13 @@ class ProtocolNetworkSsl : public Protocol
         static const TUint kConnectTimeoutMs = 3000;
 
     protected:
+        // aReadBufferBytes sizes both the socket's buffer of decrypted data and iReaderBuf
         ProtocolNetworkSsl(Environment&,
-                           SslContext&);
+                           SslContext&,
+                           TUint aReadBufferBytes = kReadBufferBytes);
         TBool Connect(const Uri& aUri, TUint aDefaultPort, TUint aTimeoutMs = kConnectTimeoutMs);
+        // as ProtocolNetwork::StreamAudio()
+        ProtocolStreamResult StreamAudio(ContentProcessor& aProcessor, IReader& aReader, TUint64 aTotalBytes);
 
     protected: // from Protocol
         void Interrupt(TBool aInterrupt) override;
@@ -193,7 +232,7 @@ class ProtocolNetworkSsl : public Protocol
 
     protected:
         SocketSsl iSocket;
-        Srs<kReadBufferBytes> iReaderBuf;
+        ReaderSocket iReaderBuf;
         Sws<kWriteBufferBytes> iWriterBuf;
         Mutex iLock;
         TBool iSocketIsOpen;
@@ -215,6 +254,7 @@ public:
     virtual TBool Recognise(const Brx& aUri, const Brx& aMimeType, const Brx& aData) = 0;
     virtual void Reset();
     virtual ProtocolStreamResult Stream(IReader& aReader, TUint64 aTotalBytes) = 0;
+    virtual ISupplyBuffer* SupplyBuffer(); // returns nullptr if Stream() can't accept data read directly into pipeline msgs
 protected:
     void SetStream(IReader& aStream);
     Brn ReadLine(ReaderUntil& aReader, TUint64& aBytesRemaining);
@@ -255,9 +295,11 @@ class ProtocolManager : public IUriStreamer, public IUrlBlockWriter, private IPr
     static const TUint kMaxUriBytes = 1024;
 public:
     ProtocolManager(IPipelineElementDownstream& aDownstream, MsgFactory& aMsgFactory, IPipelineIdProvider& aIdProvider, IFlushIdProvider& aFlushIdProvider);
+    ProtocolManager(IPipelineElementDownstream& aDownstream, MsgFactory& aMsgFactory, IPipelineIdProvider& aIdProvider, IFlushIdProvider& aFlushIdProvider, IInfoAggregator& aInfoAggregator);
     virtual ~ProtocolManager();
     void Add(Protocol* aProtocol);
     void Add(ContentProcessor* aProcessor);
+    HttpConnectionPool& ConnectionPool() override; // also from IProtocolManager
 public: // from IUriStreamer
     ProtocolStreamResult DoStream(Track& aTrack) override;
     void Interrupt(TBool aInterrupt) override;
@@ -277,6 +319,7 @@ private:
     std::vector<Protocol*> iProtocols;
     std::vector<ContentProcessor*> iContentProcessors;
     ContentProcessor* iAudioProcessor;
+    HttpConnectionPool* iConnectionPool;
 };
 
 } // namespace Media
@@ -18,6 +18,7 @@
 #include <OpenHome/OsWrapper.h>
 
 #include <algorithm>
+#include <string.h>
 
 namespace OpenHome {
 namespace Media {
@@ -30,7 +31,7 @@ private:
     static const Brn kSchemeHttp;
     static const Brn kSchemeHttps;
 public:
-    ProtocolHls(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent);
+    ProtocolHls(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, TUint aPrefetchSegments);
     ~ProtocolHls();
 private: // from Protocol
     void Initialise(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream) override;
@@ -46,6 +47,8 @@ private:
     void StartStream(const Uri& aUri);
     TBool IsCurrentStream(TUint aStreamId) const;
     void WaitForDrain();
+    ProtocolStreamResult LoadMasterPlaylist(const Uri& aUri);
+    void UpdateVariant();
     ProtocolStreamResult OutputAudio(const Brx& aUri); // FIXME - passing aUri in here to report overall stream URI for each segment for now instead of individual segment URI.
 private:
     TimerFactory iTimerFactory;
@@ -56,6 +59,13 @@ private:
     HlsM3uReader iM3uReader;
     SegmentProvider iSegmentProvider;
     SegmentStreamer iSegmentStreamer;
+    HlsMasterPlaylistParser iMasterParser;
+    HlsVariantSelector iVariantSelector;
+    Uri iMasterUri;
+    Uri iMediaPlaylistUri;
+    std::vector<HlsSegmentStats> iSegmentStats;
+    TUint64 iSegmentIndex;  // segments started since iM3uReader was last reset
+    TBool iSegmentStarting;
     TUint iStreamId;
     TBool iStarted;
     TBool iStopped;
@@ -82,7 +92,12 @@ Protocol* ProtocolFactory::NewHls(Environment& aEnv, SslContext& aSsl, const Brx
      * into an IProtocol interface, is to require ProtocolHls to take ownership
      * of objects passed in.
      */
-    return new ProtocolHls(aEnv, aSsl, aUserAgent);
+    return new ProtocolHls(aEnv, aSsl, aUserAgent, SegmentProvider::kDefaultPrefetchSegments);
+}
+
+Protocol* ProtocolFactory::NewHls(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, TUint aPrefetchSegments)
+{ // static
+    return new ProtocolHls(aEnv, aSsl, aUserAgent, aPrefetchSegments);
 }
 
 
@@ -239,6 +254,86 @@ void ReaderLogger::ReadInterrupt()
 }
 
 
+// ReaderReplay
+
+ReaderReplay::ReaderReplay()
+    : iReader(nullptr)
+    , iReplayOffset(0)
+    , iRecording(false)
+    , iReplaying(false)
+{
+}
+
+void ReaderReplay::Record(IReader& aReader)
+{
+    iReader = &aReader;
+    iBuf.SetBytes(0);
+    iReplayOffset = 0;
+    iRecording = true;
+    iReplaying = false;
+}
+
+TBool ReaderReplay::Replay()
+{
+    if (!iRecording) {
+        return false;
+    }
+    iRecording = false;
+    iReplayOffset = 0;
+    iReplaying = true;
+    return true;
+}
+
+void ReaderReplay::Clear()
+{
+    iReader = nullptr;
+    iBuf.SetBytes(0);
+    iRecording = iReplaying = false;
+}
+
+Brn ReaderReplay::Read(TUint aBytes)
+{
+    if (iReader == nullptr) {
+        THROW(ReaderError);
+    }
+    if (iReplaying) {
+        const TUint remaining = iBuf.Bytes() - iReplayOffset;
+        if (remaining > 0) {
+            const TUint bytes = std::min(aBytes, remaining);
+            Brn buf(iBuf.Ptr() + iReplayOffset, bytes);
+            iReplayOffset += bytes;
+            return buf;
+        }
+        iReplaying = false;
+    }
+    Brn buf = iReader->Read(aBytes);
+    if (iRecording) {
+        if (iBuf.Bytes() + buf.Bytes() > iBuf.MaxBytes()) {
+            iRecording = false; // too much read to replay
+        }
+        else {
+            iBuf.Append(buf);
+        }
+    }
+    return buf;
+}
+
+void ReaderReplay::ReadFlush()
+{
+    iReplaying = false;
+    if (iReader != nullptr) {
+        iReader->ReadFlush();
+    }
+}
+
+void ReaderReplay::ReadInterrupt()
+{
+    if (iReader != nullptr) {
+        iReader->ReadInterrupt();
+    }
+}
+
+
 // UriLoader
 
 UriLoader::UriLoader(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory, TUint aRetryInterval)
@@ -352,11 +447,18 @@ void UriLoader::Interrupt(TBool aInterrupt)
 
 PlaylistProvider::PlaylistProvider(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory)
     : iLoader(aEnv, aSsl, aUserAgent, aTimerFactory, kConnectRetryIntervalMs)
+    , iRewound(false)
 {
 }
 
 void PlaylistProvider::SetUri(const Uri& aUri)
 {
+    if (aUri.AbsoluteUri() != iUri.AbsoluteUri()) {
+        // Previous playlist may not have been read to its end so its connection can't be re-used.
+        iLoader.Reset();
+        iReplay.Clear();
+        iRewound = false;
+    }
     try {
         iUri.Replace(aUri.AbsoluteUri());
     }
@@ -369,11 +471,31 @@ void PlaylistProvider::Reset()
 {
     iLoader.Reset();
     iUri.Clear();
+    iReplay.Clear();
+    iRewound = false;
+}
+
+IReader& PlaylistProvider::Probe()
+{
+    iRewound = false;
+    iReplay.Record(Reload());
+    return iReplay;
+}
+
+TBool PlaylistProvider::Rewind()
+{
+    iRewound = iReplay.Replay();
+    return iRewound;
 }
 
 IReader& PlaylistProvider::Reload()
 {
     LOG(kMedia, ">PlaylistProvider::Reload\n");
+    if (iRewound) {
+        iRewound = false;
+        LOG(kMedia, "<PlaylistProvider::Reload rewound\n");
+        return iReplay;
+    }
     try {
         auto& reader = iLoader.Load(iUri);
         LOG(kMedia, "<PlaylistProvider::Reload reloaded\n");
@@ -396,25 +518,91 @@ void PlaylistProvider::InterruptPlaylistProvider(TBool aInterrupt)
 }
 
 
-// SegmentProvider
+// HlsSegmentStats
 
-SegmentProvider::SegmentProvider(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory, ISegmentUriProvider& aProvider)
-    : iLoader(aEnv, aSsl, aUserAgent, aTimerFactory, kConnectRetryIntervalMs)
-    , iProvider(aProvider)
+HlsSegmentStats::HlsSegmentStats(TUint64 aIndex, TUint aBytes, TUint aDurationMs, TUint aLatencyMs, TUint aDownloadMs)
+    : iIndex(aIndex)
+    , iBytes(aBytes)
+    , iDurationMs(aDurationMs)
+    , iLatencyMs(aLatencyMs)
+    , iDownloadMs(aDownloadMs)
 {
 }
 
-void SegmentProvider::Reset()
+TUint64 HlsSegmentStats::Index() const
+{
+    return iIndex;
+}
+
+TUint HlsSegmentStats::Bytes() const
+{
+    return iBytes;
+}
+
+TUint HlsSegmentStats::DurationMs() const
+{
+    return iDurationMs;
+}
+
+TUint HlsSegmentStats::LatencyMs() const
+{
+    return iLatencyMs;
+}
+
+TUint HlsSegmentStats::DownloadMs() const
+{
+    return iDownloadMs;
+}
+
+TUint HlsSegmentStats::BitsPerSecond() const
+{
+    const TUint64 ms = std::max(iDownloadMs, 1u);
+    return static_cast<TUint>((static_cast<TUint64>(iBytes) * 8 * 1000) / ms);
+}
+
+
+// SegmentLoader
+
+SegmentLoader::SegmentLoader(Environment& aEnv, ISegmentUriProvider& aUriProvider, IUriLoader& aLoader)
+    : iCtx(*aEnv.OsCtx())
+    , iUriProvider(aUriProvider)
+    , iLoader(aLoader)
+    , iReader(nullptr)
+    , iNextIndex(0)
+    , iIndex(0)
+    , iBytes(0)
+    , iDurationMs(0)
+    , iLatencyMs(0)
+    , iDownloadMs(0)
+{
+}
+
+void SegmentLoader::Reset()
 {
     iLoader.Reset();
+    iReader = nullptr;
+    iNextIndex = 0;
 }
 
-IReader& SegmentProvider::NextSegment()
+void SegmentLoader::GetStats(std::vector<HlsSegmentStats>& aStats) const
+{
+    aStats = iStats;
+}
+
+IReader& SegmentLoader::NextSegment()
 {
+    iReader = nullptr;
     try {
         Uri uri;
-        iProvider.NextSegmentUri(uri);
-        return iLoader.Load(uri);
+        iDurationMs = iUriProvider.NextSegmentUri(uri);
+        iIndex = iNextIndex++;
+        const TUint startMs = NowMs();
+        IReader& reader = iLoader.Load(uri);
+        iLatencyMs = NowMs() - startMs;
+        iDownloadMs = iLatencyMs;
+        iBytes = 0;
+        iReader = &reader;
+        return *this;
     }
     catch (const HlsSegmentUriError&) {
         // From NextSegmentUri().
@@ -430,50 +618,673 @@ IReader& SegmentProvider::NextSegment()
     }
 }
 
-void SegmentProvider::InterruptSegmentProvider(TBool aInterrupt)
+void SegmentLoader::InterruptSegmentProvider(TBool aInterrupt)
+{
+    iLoader.Interrupt(aInterrupt);
+}
+
+Brn SegmentLoader::Read(TUint aBytes)
+{
+    if (iReader == nullptr) {
+        return Brx::Empty();
+    }
+    // A ReaderError leaves the segment incomplete so no stats are recorded for it.
+    const TUint startMs = NowMs();
+    Brn buf = iReader->Read(aBytes);
+    iDownloadMs += NowMs() - startMs;
+    if (buf.Bytes() > 0) {
+        iBytes += buf.Bytes();
+        return buf;
+    }
+
+    iReader = nullptr;
+    const HlsSegmentStats stats(iIndex, iBytes, iDurationMs, iLatencyMs, iDownloadMs);
+    LOG(kMedia, "SegmentLoader::Read segment %llu complete. bytes: %u, durationMs: %u, latencyMs: %u, downloadMs: %u, bps: %u\n",
+                iIndex, iBytes, iDurationMs, iLatencyMs, iDownloadMs, stats.BitsPerSecond());
+    if (iStats.size() == kMaxStats) {
+        iStats.erase(iStats.begin());
+    }
+    iStats.push_back(stats);
+    return buf;
+}
+
+void SegmentLoader::ReadFlush()
+{
+    if (iReader != nullptr) {
+        iReader->ReadFlush();
+    }
+}
+
+void SegmentLoader::ReadInterrupt()
+{
+    if (iReader != nullptr) {
+        iReader->ReadInterrupt();
+    }
+}
+
+TUint SegmentLoader::NowMs() const
+{
+    return Os::TimeInMs(&iCtx);
+}
+
+
+// SegmentPrefetcher::Fetcher
+
+SegmentPrefetcher::Fetcher::Fetcher(SegmentPrefetcher& aOwner, IUriLoader& aLoader, TUint aThreadPriority)
+    : iOwner(aOwner)
+    , iLoader(aLoader)
+    , iSem("HLSF", 0)
+    , iBuf(0)
+    , iReadPos(0)
+    , iBytes(0)
+    , iPending(0)
+    , iIndex(0)
+    , iState(EState::Free)
+    , iCancelled(false)
+    , iReleased(false)
+    , iWaitingForSpace(false)
+{
+    iThread = new ThreadFunctor("HlsSegmentFetcher", MakeFunctor(*this, &SegmentPrefetcher::Fetcher::Run), aThreadPriority);
+}
+
+SegmentPrefetcher::Fetcher::~Fetcher()
+{
+    delete iThread;
+}
+
+void SegmentPrefetcher::Fetcher::Start()
+{
+    iThread->Start();
+}
+
+Brn SegmentPrefetcher::Fetcher::Read(TUint aBytes)
+{
+    return iOwner.Read(*this, aBytes);
+}
+
+void SegmentPrefetcher::Fetcher::ReadFlush()
+{
+}
+
+void SegmentPrefetcher::Fetcher::ReadInterrupt()
+{
+    // Reads are interrupted by SegmentPrefetcher::InterruptSegmentProvider(), which also cancels fetches.
+}
+
+void SegmentPrefetcher::Fetcher::Run()
+{
+    for (;;) {
+        iSem.Wait();
+        {
+            AutoMutex _(iOwner.iLock);
+            if (iOwner.iQuit) {
+                break;
+            }
+        }
+        iOwner.Fetch(*this);
+    }
+}
+
+void SegmentPrefetcher::Fetcher::ResetBuffer()
+{
+    iReadPos = 0;
+    iBytes = 0;
+    iPending = 0;
+    iWaitingForSpace = false;
+}
+
+void SegmentPrefetcher::Fetcher::FreeBuffer()
+{
+    Brh discard;
+    iBuf.TransferTo(discard);
+    ResetBuffer();
+}
+
+
+// SegmentPrefetcher
+
+SegmentPrefetcher::SegmentPrefetcher(Environment& aEnv, ISegmentUriProvider& aUriProvider, std::vector<IUriLoader*>& aLoaders, TUint aBufferBytes, TUint aThreadPriority)
+    : iCtx(*aEnv.OsCtx())
+    , iUriProvider(aUriProvider)
+    , iBufferBytes(aBufferBytes)
+    , iLoaders(aLoaders)
+    , iLock("HLPL")
+    , iLockUri("HLPU")
+    , iSemReader("HLPR", 0)
+    , iSemIdle("HLPI", 0)
+    , iCurrent(nullptr)
+    , iNextIndex(0)
+    , iNextReadIndex(0)
+    , iWorking(0)
+    , iRunning(false)
+    , iAssignStopped(false)
+    , iInterrupted(false)
+    , iReaderWaiting(false)
+    , iQuit(false)
+{
+    ASSERT(iLoaders.size() > 0);
+    ASSERT(iBufferBytes > 0);
+    for (auto loader : iLoaders) {
+        iFetchers.push_back(new Fetcher(*this, *loader, aThreadPriority));
+    }
+    for (auto fetcher : iFetchers) {
+        fetcher->Start();
+    }
+}
+
+SegmentPrefetcher::~SegmentPrefetcher()
+{
+    TBool working = false;
+    {
+        AutoMutex _(iLock);
+        iQuit = true;
+        iRunning = false;
+        CancelLocked();
+        working = (iWorking > 0);
+    }
+    if (working) {
+        iUriProvider.InterruptSegmentUriProvider(true);
+    }
+    for (auto loader : iLoaders) {
+        loader->Interrupt(true);
+    }
+    for (auto fetcher : iFetchers) {
+        fetcher->iSem.Signal();
+        delete fetcher;
+    }
+}
+
+void SegmentPrefetcher::Reset()
+{
+    TBool working = false;
+    {
+        AutoMutex _(iLock);
+        iRunning = false;
+        CancelLocked();
+        working = (iWorking > 0);
+        iSemIdle.Clear();
+    }
+    if (working) {
+        // Fetchers may be blocked waiting for a live playlist to be updated or for a server to respond.
+        iUriProvider.InterruptSegmentUriProvider(true);
+        for (auto loader : iLoaders) {
+            loader->Interrupt(true);
+        }
+        for (;;) {
+            {
+                AutoMutex _(iLock);
+                if (iWorking == 0) {
+                    break;
+                }
+            }
+            iSemIdle.Wait();
+        }
+        // Leave interrupt state as set by the most recent call to InterruptSegmentProvider().
+        TBool interrupted = false;
+        {
+            AutoMutex _(iLock);
+            interrupted = iInterrupted;
+        }
+        iUriProvider.InterruptSegmentUriProvider(interrupted);
+        for (auto loader : iLoaders) {
+            loader->Interrupt(interrupted);
+        }
+    }
+    for (auto loader : iLoaders) {
+        loader->Reset();
+    }
+
+    AutoMutex _(iLock);
+    for (auto fetcher : iFetchers) {
+        fetcher->FreeBuffer();
+        fetcher->iState = EState::Free;
+        fetcher->iCancelled = false;
+        fetcher->iReleased = false;
+    }
+    iCurrent = nullptr;
+    iNextIndex = 0;
+    iNextReadIndex = 0;
+    iAssignStopped = false;
+    iReaderWaiting = false;
+    iSemReader.Clear();
+}
+
+void SegmentPrefetcher::GetStats(std::vector<HlsSegmentStats>& aStats) const
+{
+    AutoMutex _(iLock);
+    aStats = iStats;
+}
+
+IReader& SegmentPrefetcher::NextSegment()
+{
+    AutoMutex _(iLock);
+    if (iCurrent != nullptr) {
+        ReleaseLocked(*iCurrent);
+        iCurrent = nullptr;
+    }
+    if (!iRunning) {
+        iRunning = true;
+        for (auto fetcher : iFetchers) {
+            fetcher->iSem.Signal();
+        }
+    }
+
+    for (;;) {
+        if (iInterrupted) {
+            THROW(HlsSegmentError);
+        }
+        Fetcher* next = nullptr;
+        for (auto fetcher : iFetchers) {
+            if (fetcher->iState != EState::Free && fetcher->iState != EState::Claimed && fetcher->iIndex == iNextReadIndex) {
+                next = fetcher;
+                break;
+            }
+        }
+        if (next == nullptr) {
+            if (iAssignStopped) {
+                // Error fetching a segment uri has already been reported.
+                THROW(HlsSegmentError);
+            }
+        }
+        else if (next->iState == EState::EndOfStream) {
+            THROW(HlsEndOfStream);
+        }
+        else if (next->iState == EState::Failed && next->iBytes == 0) {
+            LOG(kMedia, "SegmentPrefetcher::NextSegment segment %llu failed\n", next->iIndex);
+            iNextReadIndex++;
+            FreeLocked(*next);
+            THROW(HlsSegmentError);
+        }
+        else if (next->iState != EState::Loading) {
+            iCurrent = next;
+            iNextReadIndex++;
+            return *next;
+        }
+
+        iReaderWaiting = true;
+        iSemReader.Clear();
+        iLock.Signal();
+        iSemReader.Wait();
+        iLock.Wait();
+    }
+}
+
+void SegmentPrefetcher::InterruptSegmentProvider(TBool aInterrupt)
+{
+    LOG(kMedia, "SegmentPrefetcher::InterruptSegmentProvider aInterrupt: %u\n", aInterrupt);
+    {
+        AutoMutex _(iLock);
+        iInterrupted = aInterrupt;
+        if (aInterrupt) {
+            CancelLocked();
+            SignalReaderLocked();
+        }
+    }
+    for (auto loader : iLoaders) {
+        loader->Interrupt(aInterrupt);
+    }
+}
+
+void SegmentPrefetcher::Fetch(Fetcher& aFetcher)
+{
+    {
+        AutoMutex _(iLock);
+        if (!CanStartLocked(aFetcher)) {
+            return;
+        }
+        aFetcher.iState = EState::Claimed;
+        aFetcher.iCancelled = false;
+        iWorking++;
+    }
+    if (aFetcher.iBuf.MaxBytes() < iBufferBytes) {
+        aFetcher.iBuf.Grow(iBufferBytes);
+    }
+
+    Uri uri;
+    TUint durationMs = 0;
+    TBool haveUri = false;
+    {
+        // Segment uris are requested one at a time so that indices match playlist order.
+        AutoMutex _(iLockUri);
+        TBool assigned = false;
+        {
+            AutoMutex __(iLock);
+            if (!iQuit && iRunning && !iAssignStopped && !iInterrupted && !aFetcher.iCancelled) {
+                aFetcher.iIndex = iNextIndex++;
+                aFetcher.iState = EState::Loading;
+                assigned = true;
+            }
+            else {
+                aFetcher.iState = EState::Free;
+            }
+        }
+        if (assigned) {
+            try {
+                durationMs = iUriProvider.NextSegmentUri(uri);
+                haveUri = true;
+            }
+            catch (const HlsEndOfStream&) {
+                AutoMutex __(iLock);
+                iAssignStopped = true;
+                SetStateLocked(aFetcher, EState::EndOfStream);
+            }
+            catch (const HlsSegmentUriError&) {
+                AutoMutex __(iLock);
+                iAssignStopped = true;
+                SetStateLocked(aFetcher, EState::Failed);
+            }
+        }
+    }
+    if (haveUri) {
+        Download(aFetcher, uri, durationMs);
+    }
+
+    AutoMutex _(iLock);
+    if (aFetcher.iReleased) {
+        FreeLocked(aFetcher);
+    }
+    ASSERT(iWorking > 0);
+    if (--iWorking == 0) {
+        iSemIdle.Signal();
+    }
+}
+
+TBool SegmentPrefetcher::CanStartLocked(const Fetcher& aFetcher) const
+{
+    return !iQuit && iRunning && !iAssignStopped && !iInterrupted && aFetcher.iState == EState::Free;
+}
+
+void SegmentPrefetcher::Download(Fetcher& aFetcher, const Uri& aUri, TUint aDurationMs)
+{
+    const TUint startMs = NowMs();
+    TUint latencyMs = 0;
+    TUint stalledMs = 0;
+    TUint bytes = 0;
+    try {
+        IReader& reader = aFetcher.iLoader.Load(aUri);
+        latencyMs = NowMs() - startMs;
+        {
+            AutoMutex _(iLock);
+            if (aFetcher.iCancelled) {
+                SetStateLocked(aFetcher, EState::Failed);
+                return;
+            }
+            SetStateLocked(aFetcher, EState::Streaming);
+        }
+        for (;;) {
+            Brn buf = reader.Read(kReadBytes);
+            if (buf.Bytes() == 0) {
+                break;
+            }
+            if (!Write(aFetcher, buf, stalledMs)) {
+                return;
+            }
+            bytes += buf.Bytes();
+        }
+    }
+    catch (const UriLoaderError&) {
+        LOG(kMedia, "SegmentPrefetcher::Download segment %llu caught UriLoaderError\n", aFetcher.iIndex);
+        AutoMutex _(iLock);
+        SetStateLocked(aFetcher, EState::Failed);
+        return;
+    }
+    catch (const ReaderError&) {
+        LOG(kMedia, "SegmentPrefetcher::Download segment %llu caught ReaderError after %u bytes\n", aFetcher.iIndex, bytes);
+        AutoMutex _(iLock);
+        SetStateLocked(aFetcher, EState::Failed);
+        return;
+    }
+
+    const TUint downloadMs = (NowMs() - startMs) - stalledMs;
+    const HlsSegmentStats stats(aFetcher.iIndex, bytes, aDurationMs, latencyMs, downloadMs);
+    LOG(kMedia, "SegmentPrefetcher::Download segment %llu complete. bytes: %u, durationMs: %u, latencyMs: %u, downloadMs: %u, stalledMs: %u, bps: %u\n",
+                aFetcher.iIndex, bytes, aDurationMs, latencyMs, downloadMs, stalledMs, stats.BitsPerSecond());
+    AutoMutex _(iLock);
+    if (iStats.size() == kMaxStats) {
+        iStats.erase(iStats.begin());
+    }
+    iStats.push_back(stats);
+    SetStateLocked(aFetcher, EState::Complete);
+}
+
+TBool SegmentPrefetcher::Write(Fetcher& aFetcher, const Brx& aBuf, TUint& aStalledMs)
+{
+    const TByte* src = aBuf.Ptr();
+    TUint remaining = aBuf.Bytes();
+    while (remaining > 0) {
+        TUint writePos = 0;
+        TUint bytes = 0;
+        {
+            AutoMutex _(iLock);
+            if (aFetcher.iCancelled) {
+                SetStateLocked(aFetcher, EState::Failed);
+                return false;
+            }
+            if (aFetcher.iBytes == iBufferBytes) {
+                // Buffer full; wait for reader to catch up.
+                aFetcher.iWaitingForSpace = true;
+                aFetcher.iSem.Clear();
+            }
+            else {
+                writePos = (aFetcher.iReadPos + aFetcher.iBytes) % iBufferBytes;
+                bytes = std::min(iBufferBytes - aFetcher.iBytes, iBufferBytes - writePos);
+                bytes = std::min(bytes, remaining);
+            }
+        }
+        if (bytes == 0) {
+            const TUint waitStartMs = NowMs();
+            aFetcher.iSem.Wait();
+            aStalledMs += NowMs() - waitStartMs;
+            continue;
+        }
+        // Reader only accesses [iReadPos, iReadPos+iBytes) so this can be written without holding iLock.
+        (void)memcpy(const_cast<TByte*>(aFetcher.iBuf.Ptr()) + writePos, src, bytes);
+        src += bytes;
+        remaining -= bytes;
+        AutoMutex _(iLock);
+        aFetcher.iBytes += bytes;
+        SignalReaderLocked();
+    }
+    return true;
+}
+
+Brn SegmentPrefetcher::Read(Fetcher& aFetcher, TUint aBytes)
+{
+    AutoMutex _(iLock);
+    for (;;) {
+        if (aFetcher.iPending > 0) {
+            aFetcher.iReadPos = (aFetcher.iReadPos + aFetcher.iPending) % iBufferBytes;
+            aFetcher.iBytes -= aFetcher.iPending;
+            aFetcher.iPending = 0;
+            if (aFetcher.iWaitingForSpace) {
+                aFetcher.iWaitingForSpace = false;
+                aFetcher.iSem.Signal();
+            }
+        }
+        if (iInterrupted || aFetcher.iCancelled) {
+            THROW(ReaderError);
+        }
+        if (aFetcher.iBytes > 0) {
+            TUint bytes = std::min(aFetcher.iBytes, iBufferBytes - aFetcher.iReadPos);
+            bytes = std::min(bytes, aBytes);
+            aFetcher.iPending = bytes;
+            return Brn(aFetcher.iBuf.Ptr() + aFetcher.iReadPos, bytes);
+        }
+        if (aFetcher.iState == EState::Complete) {
+            return Brx::Empty();
+        }
+        if (aFetcher.iState == EState::Failed) {
+            THROW(ReaderError);
+        }
+
+        iReaderWaiting = true;
+        iSemReader.Clear();
+        iLock.Signal();
+        iSemReader.Wait();
+        iLock.Wait();
+    }
+}
+
+void SegmentPrefetcher::SetStateLocked(Fetcher& aFetcher, EState aState)
+{
+    aFetcher.iState = aState;
+    SignalReaderLocked();
+}
+
+void SegmentPrefetcher::FreeLocked(Fetcher& aFetcher)
+{
+    aFetcher.ResetBuffer();
+    aFetcher.iState = EState::Free;
+    aFetcher.iCancelled = false;
+    aFetcher.iReleased = false;
+    aFetcher.iSem.Signal();
+}
+
+void SegmentPrefetcher::ReleaseLocked(Fetcher& aFetcher)
+{
+    if (aFetcher.iState == EState::Loading || aFetcher.iState == EState::Streaming) {
+        // Reader moved on before the end of this segment.  Stop fetching it; slot is freed once its fetcher finishes.
+        aFetcher.iCancelled = true;
+        aFetcher.iReleased = true;
+        if (aFetcher.iWaitingForSpace) {
+            aFetcher.iWaitingForSpace = false;
+            aFetcher.iSem.Signal();
+        }
+    }
+    else {
+        FreeLocked(aFetcher);
+    }
+}
+
+void SegmentPrefetcher::CancelLocked()
+{
+    for (auto fetcher : iFetchers) {
+        fetcher->iCancelled = true;
+        if (fetcher->iWaitingForSpace) {
+            fetcher->iWaitingForSpace = false;
+            fetcher->iSem.Signal();
+        }
+    }
+}
+
+void SegmentPrefetcher::SignalReaderLocked()
+{
+    if (iReaderWaiting) {
+        iReaderWaiting = false;
+        iSemReader.Signal();
+    }
+}
+
+TUint SegmentPrefetcher::NowMs() const
+{
+    return Os::TimeInMs(&iCtx);
+}
+
+
+// SegmentProvider
+
+SegmentProvider::SegmentProvider(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory, ISegmentUriProvider& aProvider)
+    : SegmentProvider(aEnv, aSsl, aUserAgent, aTimerFactory, aProvider, kDefaultPrefetchSegments)
+{
+}
+
+SegmentProvider::SegmentProvider(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory, ISegmentUriProvider& aProvider, TUint aPrefetchSegments)
+    : iEnv(aEnv)
+    , iSsl(aSsl)
+    , iUserAgent(aUserAgent)
+    , iTimerFactory(aTimerFactory)
+    , iLoader(aEnv, aSsl, aUserAgent, aTimerFactory, kConnectRetryIntervalMs)
+    , iProvider(aProvider)
+    , iSegmentLoader(aEnv, aProvider, iLoader)
+    , iPrefetchSegments(aPrefetchSegments)
+    , iPrefetcher(nullptr)
+    , iLock("HSPL")
+    , iInterrupted(false)
 {
-    iLoader.Interrupt(aInterrupt);
 }
 
+SegmentProvider::~SegmentProvider()
+{
+    delete iPrefetcher;
+    for (TUint i=1; i<iPrefetchLoaders.size(); i++) {
+        delete iPrefetchLoaders[i];
+    }
+}
 
-// SegmentDescriptor
+void SegmentProvider::Reset()
+{
+    if (iPrefetcher != nullptr) {
+        iPrefetcher->Reset();
+    }
+    else {
+        iSegmentLoader.Reset();
+    }
+}
 
-SegmentDescriptor::SegmentDescriptor(TUint64 aIndex, const Brx& aUri, TUint aDurationMs)
-    : iIndex(aIndex)
-    , iUri(aUri)
-    , iDurationMs(aDurationMs)
+void SegmentProvider::GetStats(std::vector<HlsSegmentStats>& aStats) const
 {
+    if (iPrefetcher != nullptr) {
+        iPrefetcher->GetStats(aStats);
+    }
+    else {
+        iSegmentLoader.GetStats(aStats);
+    }
 }
 
-SegmentDescriptor::SegmentDescriptor(const SegmentDescriptor& aDescriptor)
-    : iIndex(aDescriptor.iIndex)
-    , iUri(Brn(aDescriptor.iUri))
-    , iDurationMs(aDescriptor.iDurationMs)
+IReader& SegmentProvider::NextSegment()
 {
+    if (iPrefetchSegments > 0) {
+        return Prefetcher().NextSegment();
+    }
+    return iSegmentLoader.NextSegment();
 }
 
-TUint64 SegmentDescriptor::Index() const
+void SegmentProvider::InterruptSegmentProvider(TBool aInterrupt)
 {
-    return iIndex;
+    AutoMutex _(iLock);
+    iInterrupted = aInterrupt;
+    if (iPrefetcher != nullptr) {
+        iPrefetcher->InterruptSegmentProvider(aInterrupt);
+    }
+    else {
+        iSegmentLoader.InterruptSegmentProvider(aInterrupt);
+    }
 }
 
-const Brx& SegmentDescriptor::SegmentUri() const
+SegmentPrefetcher& SegmentProvider::Prefetcher()
 {
-    return iUri;
+    // Fetch threads and connections are only created once a stream is played.
+    // iPrefetcher is only set here, on the thread that calls Reset() and GetStats().
+    AutoMutex _(iLock);
+    if (iPrefetcher == nullptr) {
+        // One fetch for the segment being read plus one for each segment fetched ahead of it.
+        iPrefetchLoaders.push_back(&iLoader);
+        for (TUint i=0; i<iPrefetchSegments; i++) {
+            iPrefetchLoaders.push_back(new UriLoader(iEnv, iSsl, iUserAgent, iTimerFactory, kConnectRetryIntervalMs));
+        }
+        iPrefetcher = new SegmentPrefetcher(iEnv, iProvider, iPrefetchLoaders, kPrefetchBufferBytes, kPriorityNormal);
+        if (iInterrupted) {
+            iPrefetcher->InterruptSegmentProvider(true);
+        }
+    }
+    return *iPrefetcher;
 }
 
-void SegmentDescriptor::AbsoluteUri(const Uri& aBaseUri, Uri& aUriOut) const
+
+// MakeAbsoluteUri
+
+static void MakeAbsoluteUri(const Brx& aUri, const Uri& aBaseUri, Uri& aUriOut)
 {
-    // Segment URI MAY be relative.
-    // If it is relative, it is relative to URI of playlist that contains it.
-    Parser p(iUri);
+    // Segment and variant URIs MAY be relative.
+    // If relative, they are relative to URI of playlist that contains them.
+    Parser p(aUri);
     const auto parseEntry = p.Next(':');
-    if (parseEntry.Bytes() > 0 && parseEntry.Bytes() < iUri.Bytes()) {
-        // Segment URI starts with a scheme (terminated by ':'), so URI is absolute.
-        aUriOut.Replace(iUri); // May throw UriError.
+    if (parseEntry.Bytes() > 0 && parseEntry.Bytes() < aUri.Bytes()) {
+        // URI starts with a scheme (terminated by ':'), so URI is absolute.
+        aUriOut.Replace(aUri); // May throw UriError.
     }
     else {
-        // Segment URI is relative.
+        // URI is relative.
         Bws<Uri::kMaxUriBytes> uriBuf;
         uriBuf.Replace(aBaseUri.Scheme());
         uriBuf.Append("://");
@@ -494,10 +1305,42 @@ void SegmentDescriptor::AbsoluteUri(const Uri& aBaseUri, Uri& aUriOut) const
             }
         }
 
-        aUriOut.Replace(uriBuf, iUri); // May throw UriError.
+        aUriOut.Replace(uriBuf, aUri); // May throw UriError.
     }
 }
 
+
+// SegmentDescriptor
+
+SegmentDescriptor::SegmentDescriptor(TUint64 aIndex, const Brx& aUri, TUint aDurationMs)
+    : iIndex(aIndex)
+    , iUri(aUri)
+    , iDurationMs(aDurationMs)
+{
+}
+
+SegmentDescriptor::SegmentDescriptor(const SegmentDescriptor& aDescriptor)
+    : iIndex(aDescriptor.iIndex)
+    , iUri(Brn(aDescriptor.iUri))
+    , iDurationMs(aDescriptor.iDurationMs)
+{
+}
+
+TUint64 SegmentDescriptor::Index() const
+{
+    return iIndex;
+}
+
+const Brx& SegmentDescriptor::SegmentUri() const
+{
+    return iUri;
+}
+
+void SegmentDescriptor::AbsoluteUri(const Uri& aBaseUri, Uri& aUriOut) const
+{
+    MakeAbsoluteUri(iUri, aBaseUri, aUriOut);
+}
+
 TUint SegmentDescriptor::DurationMs() const
 {
     return iDurationMs;
@@ -704,6 +1547,269 @@ void HlsPlaylistParser::ReadNextLine()
 }
 
 
+// HlsVariantStream
+
+HlsVariantStream::HlsVariantStream(const Brx& aUri, TUint aBandwidth, const Brx& aCodecs)
+    : iUri(aUri)
+    , iBandwidth(aBandwidth)
+    , iCodecs(aCodecs)
+{
+}
+
+const Brx& HlsVariantStream::VariantUri() const
+{
+    return iUri;
+}
+
+void HlsVariantStream::AbsoluteUri(const Uri& aBaseUri, Uri& aUriOut) const
+{
+    MakeAbsoluteUri(iUri, aBaseUri, aUriOut);
+}
+
+TUint HlsVariantStream::Bandwidth() const
+{
+    return iBandwidth;
+}
+
+const Brx& HlsVariantStream::Codecs() const
+{
+    return iCodecs;
+}
+
+
+// HlsMasterPlaylistParser
+
+const TUint HlsMasterPlaylistParser::kMaxLineBytes;
+
+HlsMasterPlaylistParser::HlsMasterPlaylistParser()
+{
+}
+
+HlsMasterPlaylistParser::~HlsMasterPlaylistParser()
+{
+    Reset();
+}
+
+TBool HlsMasterPlaylistParser::Parse(IReader& aReader)
+{
+    Reset();
+    ReaderUntilS<kMaxLineBytes> readerUntil(aReader);
+    TBool master = false;
+    TBool expectUri = false;
+    TUint bandwidth = 0;
+    Bws<kMaxLineBytes> codecs;
+    try {
+        for (;;) {
+            Brn line = Ascii::Trim(readerUntil.ReadUntil(Ascii::kLf));
+            if (line.Bytes() == 0) {
+                continue;
+            }
+            if (expectUri) {
+                if (line[0] == '#') {
+                    continue;
+                }
+                expectUri = false;
+                if (bandwidth > 0) {
+                    iVariants.push_back(new HlsVariantStream(line, bandwidth, codecs));
+                }
+                else {
+                    LOG(kMedia, "HlsMasterPlaylistParser::Parse skipping variant without bandwidth: %.*s\n", PBUF(line));
+                }
+                continue;
+            }
+
+            Parser p(line);
+            Brn tag = p.Next(':');
+            if (tag == Brn("#EXT-X-STREAM-INF")) {
+                master = true;
+                expectUri = true;
+                try {
+                    Brn codecsAttr;
+                    ParseAttributes(p.Remaining(), bandwidth, codecsAttr);
+                    codecs.Replace(codecsAttr);
+                }
+                catch (AsciiError&) {
+                    bandwidth = 0;
+                }
+            }
+            else if (!master && (tag == Brn("#EXTINF") || tag == Brn("#EXT-X-TARGETDURATION") || tag == Brn("#EXT-X-MEDIA-SEQUENCE"))) {
+                // Tags that only appear in media playlists.
+                return false;
+            }
+        }
+    }
+    catch (ReaderError&) {
+        // End of playlist.
+    }
+    if (!master) {
+        return false;
+    }
+
+    std::stable_sort(iVariants.begin(), iVariants.end(), CompareBandwidth);
+    if (iVariants.size() > 0) {
+        const Brx& lowestCodecs = iVariants[0]->Codecs();
+        for (auto it = iVariants.begin(); it != iVariants.end();) {
+            if ((*it)->Codecs() != lowestCodecs) {
+                LOG(kMedia, "HlsMasterPlaylistParser::Parse skipping variant with codecs: %.*s\n", PBUF((*it)->Codecs()));
+                delete *it;
+                it = iVariants.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+    if (iVariants.size() == 0) {
+        THROW(HlsPlaylistInvalid);
+    }
+    LOG(kMedia, "HlsMasterPlaylistParser::Parse found %u variants\n", (TUint)iVariants.size());
+    return true;
+}
+
+void HlsMasterPlaylistParser::Reset()
+{
+    for (auto variant : iVariants) {
+        delete variant;
+    }
+    iVariants.clear();
+}
+
+const std::vector<HlsVariantStream*>& HlsMasterPlaylistParser::Variants() const
+{
+    return iVariants;
+}
+
+TBool HlsMasterPlaylistParser::CompareBandwidth(const HlsVariantStream* aFirst, const HlsVariantStream* aSecond)
+{ // static
+    return aFirst->Bandwidth() < aSecond->Bandwidth();
+}
+
+void HlsMasterPlaylistParser::ParseAttributes(const Brx& aAttributes, TUint& aBandwidth, Brn& aCodecs)
+{ // static
+    // Attribute list is comma separated NAME=VALUE pairs.  Quoted string values may contain commas.
+    aBandwidth = 0;
+    aCodecs.Set(Brx::Empty());
+    const TUint bytes = aAttributes.Bytes();
+    TUint i = 0;
+    while (i < bytes) {
+        const TUint nameStart = i;
+        while (i < bytes && aAttributes[i] != '=') {
+            i++;
+        }
+        if (i == bytes) {
+            break;
+        }
+        const Brn name = Ascii::Trim(aAttributes.Split(nameStart, i - nameStart));
+        i++; // skip '='
+        Brn value;
+        if (i < bytes && aAttributes[i] == '"') {
+            const TUint valueStart = ++i;
+            while (i < bytes && aAttributes[i] != '"') {
+                i++;
+            }
+            value.Set(aAttributes.Split(valueStart, i - valueStart));
+            while (i < bytes && aAttributes[i] != ',') {
+                i++;
+            }
+        }
+        else {
+            const TUint valueStart = i;
+            while (i < bytes && aAttributes[i] != ',') {
+                i++;
+            }
+            value.Set(Ascii::Trim(aAttributes.Split(valueStart, i - valueStart)));
+        }
+        i++; // skip ','
+
+        if (name == Brn("BANDWIDTH")) {
+            aBandwidth = Ascii::Uint(value);
+        }
+        else if (name == Brn("CODECS")) {
+            aCodecs.Set(value);
+        }
+    }
+}
+
+
+// HlsVariantSelector
+
+const TUint HlsVariantSelector::kEstimateSegments;
+const TUint HlsVariantSelector::kSafetyPercent;
+const TUint HlsVariantSelector::kDownSwitchPercent;
+const TUint HlsVariantSelector::kUpSwitchCount;
+
+HlsVariantSelector::HlsVariantSelector()
+    : iCurrent(0)
+    , iEstimateBps(0)
+    , iUpCount(0)
+{
+}
+
+void HlsVariantSelector::SetVariants(const std::vector<TUint>& aBandwidths)
+{
+    iBandwidths = aBandwidths;
+    iCurrent = 0;
+    iEstimateBps = 0;
+    iUpCount = 0;
+}
+
+TUint HlsVariantSelector::Current() const
+{
+    return iCurrent;
+}
+
+TUint HlsVariantSelector::EstimateBps() const
+{
+    return iEstimateBps;
+}
+
+TBool HlsVariantSelector::Update(const std::vector<HlsSegmentStats>& aStats)
+{
+    if (iBandwidths.size() == 0 || aStats.size() == 0) {
+        return false;
+    }
+
+    // Total bits over total download time, i.e. the harmonic mean of segment download rates, weighted by size.
+    const TUint count = std::min(static_cast<TUint>(aStats.size()), kEstimateSegments);
+    TUint64 bits = 0;
+    TUint64 ms = 0;
+    for (TUint i=static_cast<TUint>(aStats.size())-count; i<aStats.size(); i++) {
+        bits += static_cast<TUint64>(aStats[i].Bytes()) * 8;
+        ms += aStats[i].DownloadMs();
+    }
+    const TUint64 estimate = (bits * 1000) / std::max(ms, (TUint64)1);
+    iEstimateBps = static_cast<TUint>(std::min(estimate, (TUint64)0xffffffff));
+
+    TUint target = 0; // highest variant that leaves kSafetyPercent headroom
+    for (TUint i=1; i<iBandwidths.size(); i++) {
+        if (static_cast<TUint64>(iBandwidths[i]) * 100 <= estimate * kSafetyPercent) {
+            target = i;
+        }
+    }
+
+    if (static_cast<TUint64>(iBandwidths[iCurrent]) * 100 > estimate * kDownSwitchPercent) {
+        iUpCount = 0;
+        if (target < iCurrent) {
+            LOG(kMedia, "HlsVariantSelector::Update estimate %u bps, down to variant %u (%u bps)\n", iEstimateBps, target, iBandwidths[target]);
+            iCurrent = target;
+            return true;
+        }
+        return false;
+    }
+    if (target > iCurrent) {
+        if (++iUpCount >= kUpSwitchCount) {
+            iUpCount = 0;
+            iCurrent++;
+            LOG(kMedia, "HlsVariantSelector::Update estimate %u bps, up to variant %u (%u bps)\n", iEstimateBps, iCurrent, iBandwidths[iCurrent]);
+            return true;
+        }
+        return false;
+    }
+    iUpCount = 0;
+    return false;
+}
+
+
 // HlsReloadTimer
 
 HlsReloadTimer::HlsReloadTimer(Environment& aEnv, ITimerFactory& aTimerFactory)
@@ -777,6 +1883,10 @@ HlsM3uReader::HlsM3uReader(IHlsPlaylistProvider& aProvider, IHlsReloadTimer& aRe
     , iNewSegmentEncountered(false)
     , iInterrupted(false)
     , iError(false)
+    , iLockVariant("HMRV")
+    , iPendingBandwidth(0)
+    , iVariantPending(false)
+    , iSegmentCount(0)
 {
 }
 
@@ -812,6 +1922,11 @@ void HlsM3uReader::Reset()
     iReloadTimer.Restart();
     iParser.Reset();
     iError = false;
+
+    AutoMutex _(iLockVariant);
+    iVariantPending = false;
+    iSegmentCount = 0;
+    iVariantChanges.clear();
 }
 
 void HlsM3uReader::SetStartSegment(TUint64 aPreferredStartSegment)
@@ -824,10 +1939,61 @@ TUint64 HlsM3uReader::LastSegment() const
     return iLastSegment;
 }
 
+void HlsM3uReader::SwitchVariant(const Uri& aUri, TUint aBandwidth)
+{
+    LOG(kMedia, "HlsM3uReader::SwitchVariant %.*s, bandwidth: %u\n", PBUF(aUri.AbsoluteUri()), aBandwidth);
+    AutoMutex _(iLockVariant);
+    iPendingVariantUri.Replace(aUri.AbsoluteUri());
+    iPendingBandwidth = aBandwidth;
+    iVariantPending = true;
+}
+
+TBool HlsM3uReader::VariantChanged(TUint64 aSegment, TUint& aBandwidth)
+{
+    AutoMutex _(iLockVariant);
+    for (auto it = iVariantChanges.begin(); it != iVariantChanges.end();) {
+        if (it->first == aSegment) {
+            aBandwidth = it->second;
+            iVariantChanges.erase(it);
+            return true;
+        }
+        else if (it->first < aSegment) {
+            it = iVariantChanges.erase(it); // segment has already been read
+        }
+        else {
+            ++it;
+        }
+    }
+    return false;
+}
+
 TUint HlsM3uReader::NextSegmentUri(Uri& aUri)
 {
     TUint64 sequenceNo = 0;
     TBool reload = false;
+    TBool switched = false;
+    TUint bandwidth = 0;
+    {
+        AutoMutex _(iLockVariant);
+        if (iVariantPending) {
+            iVariantPending = false;
+            try {
+                // Segment numbering is common to all variants so continuity is still checked against iLastSegment.
+                // Discarding the old variant's playlist means the new one is loaded without waiting for the reload timer.
+                const Uri uri(iPendingVariantUri);
+                iProvider.SetUri(uri);
+                iParser.Reset();
+                switched = true;
+                bandwidth = iPendingBandwidth;
+            }
+            catch (const UriError&) {
+                LOG(kMedia, "HlsM3uReader::NextSegmentUri invalid variant URI\n");
+            }
+            catch (const HlsPlaylistProviderError&) {
+                LOG(kMedia, "HlsM3uReader::NextSegmentUri unable to switch variant\n");
+            }
+        }
+    }
     for (;;) {
         try {
             if (reload) {
@@ -849,6 +2015,13 @@ TUint HlsM3uReader::NextSegmentUri(Uri& aUri)
                         sd.AbsoluteUri(iProvider.GetUri(), aUri);
                         iNewSegmentEncountered = true;
                         iLastSegment = sd.Index();
+                        {
+                            AutoMutex _(iLockVariant);
+                            if (switched) {
+                                iVariantChanges.push_back(std::make_pair(iSegmentCount, bandwidth));
+                            }
+                            iSegmentCount++;
+                        }
                         LOG(kMedia, "HlsM3uReader::NextSegmentUri returning sd: %llu\n", sd.Index());
                         return sd.DurationMs();
                     }
@@ -1055,7 +2228,7 @@ const Brn ProtocolHls::kSchemeHlsSecure("hlss");
 const Brn ProtocolHls::kSchemeHttp("http");
 const Brn ProtocolHls::kSchemeHttps("https");
 
-ProtocolHls::ProtocolHls(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent)
+ProtocolHls::ProtocolHls(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, TUint aPrefetchSegments)
     : Protocol(aEnv)
     , iTimerFactory(aEnv)
     , iSupply(nullptr)
@@ -1063,8 +2236,10 @@ ProtocolHls::ProtocolHls(Environment& aEnv, SslContext& aSsl, const Brx& aUserAg
     , iPlaylistProvider(aEnv, aSsl, aUserAgent, iTimerFactory)
     , iReloadTimer(aEnv, iTimerFactory)
     , iM3uReader(iPlaylistProvider, iReloadTimer)
-    , iSegmentProvider(aEnv, aSsl, aUserAgent, iTimerFactory, iM3uReader)
+    , iSegmentProvider(aEnv, aSsl, aUserAgent, iTimerFactory, iM3uReader, aPrefetchSegments)
     , iSegmentStreamer(iSegmentProvider)
+    , iSegmentIndex(0)
+    , iSegmentStarting(true)
     , iSem("PRTH", 0)
     , iLock("PRHL")
 {
@@ -1187,6 +2362,9 @@ ProtocolStreamResult ProtocolHls::Stream(const Brx& aUri)
     }
 
     ProtocolStreamResult res = EProtocolStreamErrorRecoverable;
+    TBool playlistLoaded = false;
+    iSegmentIndex = 0;
+    iSegmentStarting = true;
     while (res == EProtocolStreamErrorRecoverable) {
         {
             AutoMutex a(iLock);
@@ -1196,7 +2374,17 @@ ProtocolStreamResult ProtocolHls::Stream(const Brx& aUri)
             }
         }
 
-        res = OutputAudio(aUri);
+        if (!playlistLoaded) {
+            // Until it has been read, uriHttp may be a master or a media playlist.
+            res = LoadMasterPlaylist(uriHttp);
+            if (res == EProtocolStreamErrorUnrecoverable) {
+                break;
+            }
+            playlistLoaded = (res == EProtocolStreamSuccess);
+        }
+        if (playlistLoaded) {
+            res = OutputAudio(aUri);
+        }
 
         // Check for context of above method returning.
         // i.e., identify whether it was actually caused by:
@@ -1263,8 +2451,12 @@ ProtocolStreamResult ProtocolHls::Stream(const Brx& aUri)
 
             // Try continue on from previous segment in stream, if possible (even with a discontinuity in audio, still better than potentially repeating already-played segments, if any such segments still present in playlist).
             Reinitialise();
-            iPlaylistProvider.SetUri(uriHttp);
-            iM3uReader.SetStartSegment(lastSegment+1);
+            if (playlistLoaded) {
+                iPlaylistProvider.SetUri(iMediaPlaylistUri);  // variant in use when the stream was interrupted
+                iM3uReader.SetStartSegment(lastSegment+1);
+            }
+            iSegmentIndex = 0;
+            iSegmentStarting = true;
 
             StartStream(uriHls);    // Output new MsgEncodedStream to signify discontinuity.
             continue;
@@ -1382,6 +2574,80 @@ void ProtocolHls::WaitForDrain()
     semDrain.Wait();
 }
 
+ProtocolStreamResult ProtocolHls::LoadMasterPlaylist(const Uri& aUri)
+{
+    // aUri may refer to either a master playlist (listing variants of the stream) or a media playlist.
+    iMasterParser.Reset();
+    iVariantSelector.SetVariants(std::vector<TUint>());
+    try {
+        iPlaylistProvider.SetUri(aUri);
+        if (!iMasterParser.Parse(iPlaylistProvider.Probe())) {
+            // Media playlist.  Have iM3uReader parse it from the start rather than fetching it again.
+            iMediaPlaylistUri.Replace(aUri.AbsoluteUri());
+            if (!iPlaylistProvider.Rewind()) {
+                // Too much was read to rewind; load it again from a new connection.
+                iPlaylistProvider.Reset();
+                iPlaylistProvider.SetUri(aUri);
+            }
+            return EProtocolStreamSuccess;
+        }
+    }
+    catch (const HlsPlaylistProviderError&) {
+        // Unavailable or interrupted.  Caller retries.
+        LOG(kMedia, "ProtocolHls::LoadMasterPlaylist unable to load %.*s\n", PBUF(aUri.AbsoluteUri()));
+        return EProtocolStreamErrorRecoverable;
+    }
+    catch (const HlsPlaylistInvalid&) {
+        LOG(kMedia, "ProtocolHls::LoadMasterPlaylist no usable variants in %.*s\n", PBUF(aUri.AbsoluteUri()));
+        return EProtocolStreamErrorUnrecoverable;
+    }
+
+    std::vector<TUint> bandwidths;
+    for (auto variant : iMasterParser.Variants()) {
+        bandwidths.push_back(variant->Bandwidth());
+    }
+    iVariantSelector.SetVariants(bandwidths);
+    const auto& variant = *iMasterParser.Variants()[iVariantSelector.Current()];
+    try {
+        iMasterUri.Replace(aUri.AbsoluteUri());
+        Uri uri;
+        variant.AbsoluteUri(iMasterUri, uri);
+        iMediaPlaylistUri.Replace(uri.AbsoluteUri());
+        iPlaylistProvider.SetUri(iMediaPlaylistUri);
+    }
+    catch (const UriError&) {
+        LOG(kMedia, "ProtocolHls::LoadMasterPlaylist invalid variant URI: %.*s\n", PBUF(variant.VariantUri()));
+        return EProtocolStreamErrorUnrecoverable;
+    }
+    catch (const HlsPlaylistProviderError&) {
+        return EProtocolStreamErrorUnrecoverable;
+    }
+    LOG(kMedia, "ProtocolHls::LoadMasterPlaylist starting with variant %.*s (%u bps)\n", PBUF(iMediaPlaylistUri.AbsoluteUri()), variant.Bandwidth());
+    return EProtocolStreamSuccess;
+}
+
+void ProtocolHls::UpdateVariant()
+{
+    const auto& variants = iMasterParser.Variants();
+    if (variants.size() < 2) {
+        return;
+    }
+    iSegmentProvider.GetStats(iSegmentStats);
+    if (!iVariantSelector.Update(iSegmentStats)) {
+        return;
+    }
+    const auto& variant = *variants[iVariantSelector.Current()];
+    try {
+        Uri uri;
+        variant.AbsoluteUri(iMasterUri, uri);
+        iMediaPlaylistUri.Replace(uri.AbsoluteUri());
+        iM3uReader.SwitchVariant(uri, variant.Bandwidth());
+    }
+    catch (const UriError&) {
+        LOG(kMedia, "ProtocolHls::UpdateVariant invalid variant URI: %.*s\n", PBUF(variant.VariantUri()));
+    }
+}
+
 ProtocolStreamResult ProtocolHls::OutputAudio(const Brx& aUri)
 {
     // Manipulating SegmentStreamer directly instead of using ContentAudio.
@@ -1397,8 +2663,19 @@ ProtocolStreamResult ProtocolHls::OutputAudio(const Brx& aUri)
                 iSegmentStreamer.Reset();
                 // No need to flush iSupply, as Supply immediately pushes audio into pipeline.
                 iSupply->OutputSegment(aUri); // FIXME - re-using aUri instead of getting specific segment URI.
+                iSegmentIndex++;
+                iSegmentStarting = true;
+                // Any change of variant applies to the next segment whose uri hasn't yet been requested.
+                UpdateVariant();
             }
             else { // else block instead of using continue above to jump over this section if buf.Bytes() == 0.
+                if (iSegmentStarting) {
+                    iSegmentStarting = false;
+                    TUint bitRate = 0;
+                    if (iM3uReader.VariantChanged(iSegmentIndex, bitRate)) {
+                        iSupply->OutputBitRate(bitRate);
+                    }
+                }
                 iSupply->OutputData(buf);
                 if (totalBytes > 0) {
                     if (buf.Bytes() > totalBytes) { // totalBytes is inaccurate - ignore it
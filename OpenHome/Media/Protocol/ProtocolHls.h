@@ -7,8 +7,12 @@
 #include <OpenHome/Private/Uri.h>
 #include <OpenHome/Media/Supply.h>
 #include <OpenHome/SocketHttp.h>
+#include <OpenHome/Private/Thread.h>
 
 #include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
 
 EXCEPTION(UriLoaderError);
 
@@ -35,6 +39,12 @@ public:
      * Throws HlsPlaylistProviderError if manifest unavailable (or Interrupt() is called while in this call).
      */
     virtual IReader& Reload() = 0;
+    /*
+     * Sets the playlist returned by subsequent Reload() calls.
+     *
+     * Throws HlsPlaylistProviderError if aUri is invalid.
+     */
+    virtual void SetUri(const Uri& aUri) = 0;
     virtual const Uri& GetUri() const = 0;
     virtual void InterruptPlaylistProvider(TBool aInterrupt) = 0;
     virtual ~IHlsPlaylistProvider() {};
@@ -120,14 +130,57 @@ private:
     TBool iEnabled;
 };
 
-class UriLoader
+/*
+ * Passes reads through to another IReader, retaining up to kMaxBytes of the data read.
+ * After a successful Replay(), the retained data is read again before reads continue from the
+ * underlying IReader.
+ */
+class ReaderReplay : public IReader
+{
+public:
+    static const TUint kMaxBytes = 4 * 1024;
+public:
+    ReaderReplay();
+    void Record(IReader& aReader);
+    TBool Replay(); // returns false (and doesn't replay) if more than kMaxBytes have been read
+    void Clear();
+public: // from IReader
+    Brn Read(TUint aBytes) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+private:
+    IReader* iReader;
+    Bws<kMaxBytes> iBuf;
+    TUint iReplayOffset;
+    TBool iRecording;
+    TBool iReplaying;
+};
+
+class IUriLoader
+{
+public:
+    /*
+     * Blocks until a successful response to a GET of aUri is received, retrying on connection errors.
+     *
+     * Returned IReader is valid until the next call to Load() or Reset().
+     *
+     * THROWS UriLoaderError if the server returned an error or Interrupt() was called.
+     */
+    virtual IReader& Load(const Uri& aUri) = 0;
+    virtual void Reset() = 0;
+    virtual void Interrupt(TBool aInterrupt) = 0;
+    virtual ~IUriLoader() {}
+};
+
+class UriLoader : public IUriLoader
 {
 public:
     UriLoader(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory, TUint aRetryInterval);
     ~UriLoader();
-    IReader& Load(const Uri& aUri); // THROWS UriLoaderError
-    void Reset();
-    void Interrupt(TBool aInterrupt);
+public: // from IUriLoader
+    IReader& Load(const Uri& aUri) override; // THROWS UriLoaderError
+    void Reset() override;
+    void Interrupt(TBool aInterrupt) override;
 private:
     SocketHttp iSocket;
     const TUint iRetryInterval;
@@ -145,30 +198,225 @@ private:
     static const TUint kConnectRetryIntervalMs = 1 * 1000;
 public:
     PlaylistProvider(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory);
-    void SetUri(const Uri& aUri);
     void Reset();
+    /*
+     * As Reload() but retains the start of the playlist.  If only its start was read, Rewind()
+     * has the next Reload() return the same playlist from its start rather than fetching it again.
+     */
+    IReader& Probe();
+    TBool Rewind(); // returns false if the playlist can't be rewound.  Reload() then fetches it again.
 public: // from IHlsPlaylistProvider
     IReader& Reload() override;
+    void SetUri(const Uri& aUri) override;
     const Uri& GetUri() const override;
     void InterruptPlaylistProvider(TBool aInterrupt) override;
 private:
     UriLoader iLoader;
     Uri iUri;
+    ReaderReplay iReplay;
+    TBool iRewound;
 };
 
-class SegmentProvider : public ISegmentProvider
+class HlsSegmentStats
+{
+public:
+    HlsSegmentStats(TUint64 aIndex, TUint aBytes, TUint aDurationMs, TUint aLatencyMs, TUint aDownloadMs);
+    TUint64 Index() const;      // order segment was requested in, counting from 0 after each Reset()
+    TUint Bytes() const;
+    TUint DurationMs() const;   // media duration, from playlist
+    TUint LatencyMs() const;    // from request to response being received
+    TUint DownloadMs() const;   // from request to last byte, excluding time spent waiting for buffer space
+    TUint BitsPerSecond() const;
+private:
+    TUint64 iIndex;
+    TUint iBytes;
+    TUint iDurationMs;
+    TUint iLatencyMs;
+    TUint iDownloadMs;
+};
+
+/*
+ * ISegmentProvider that requests each segment from aLoader as the previous one finishes.
+ *
+ * Segments are timed as they are read, in the manner of ReaderLoggerTime.  Only time spent in
+ * Read() counts towards a segment's download time, so a reader that is slow to consume a
+ * segment doesn't lower its measured throughput.  Stats are recorded for a segment once it
+ * has been read to its end (i.e. until Read() returns an empty buffer).
+ */
+class SegmentLoader : public ISegmentProvider, private IReader, private INonCopyable
+{
+public:
+    static const TUint kMaxStats = 16;
+public:
+    SegmentLoader(Environment& aEnv, ISegmentUriProvider& aUriProvider, IUriLoader& aLoader);
+    void Reset();
+    void GetStats(std::vector<HlsSegmentStats>& aStats) const; // most recent kMaxStats segments, oldest first
+public: // from ISegmentProvider
+    IReader& NextSegment() override;
+    void InterruptSegmentProvider(TBool aInterrupt) override;
+private: // from IReader
+    Brn Read(TUint aBytes) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+private:
+    TUint NowMs() const;
+private:
+    OsContext& iCtx;
+    ISegmentUriProvider& iUriProvider;
+    IUriLoader& iLoader;
+    IReader* iReader;       // nullptr once the current segment has been read to its end
+    TUint64 iNextIndex;
+    TUint64 iIndex;
+    TUint iBytes;
+    TUint iDurationMs;
+    TUint iLatencyMs;
+    TUint iDownloadMs;
+    std::vector<HlsSegmentStats> iStats;
+};
+
+/*
+ * ISegmentProvider that fetches several segments concurrently, one per IUriLoader passed in.
+ *
+ * Segment URIs are requested from aUriProvider one at a time so segments are returned from
+ * NextSegment() in playlist order, regardless of the order their downloads complete in.
+ * Each fetch writes into its own buffer of aBufferBytes.  A fetch that fills its buffer
+ * waits for its segment to be read, so segments larger than aBufferBytes are streamed.
+ *
+ * Fetching starts on the first call to NextSegment() after construction or Reset().
+ * Buffers are allocated when a fetch first uses them and freed by Reset().
+ * Reading a segment to its end (i.e. until Read() returns an empty buffer) then calling
+ * NextSegment() frees its buffer for the next fetch.
+ *
+ * InterruptSegmentProvider(true) cancels all fetches in progress; Reset() must then be
+ * called before further segments can be read.  Reset() must not be called concurrently
+ * with NextSegment() or with any Read() from a segment.
+ */
+class SegmentPrefetcher : public ISegmentProvider, private INonCopyable
+{
+public:
+    static const TUint kMaxStats = 16;
+private:
+    static const TUint kReadBytes = 4 * 1024;
+    enum class EState
+    {
+        Free,
+        Claimed,     // waiting to be assigned a segment
+        Loading,     // segment assigned; waiting for uri and/or response
+        Streaming,
+        Complete,
+        Failed,
+        EndOfStream
+    };
+    class Fetcher : public IReader, private INonCopyable
+    {
+        friend class SegmentPrefetcher;
+    public:
+        Fetcher(SegmentPrefetcher& aOwner, IUriLoader& aLoader, TUint aThreadPriority);
+        ~Fetcher();
+        void Start();
+    private: // from IReader
+        Brn Read(TUint aBytes) override;
+        void ReadFlush() override;
+        void ReadInterrupt() override;
+    private:
+        void Run();
+        void ResetBuffer();
+        void FreeBuffer();
+    private:
+        SegmentPrefetcher& iOwner;
+        IUriLoader& iLoader;
+        Semaphore iSem;
+        ThreadFunctor* iThread;
+        Bwh iBuf;           // ring buffer
+        TUint iReadPos;
+        TUint iBytes;       // includes iPending
+        TUint iPending;     // returned by last Read(); freed by next Read()
+        TUint64 iIndex;
+        EState iState;
+        TBool iCancelled;
+        TBool iReleased;    // reader has moved on; free slot when fetch ends
+        TBool iWaitingForSpace;
+    };
+public:
+    SegmentPrefetcher(Environment& aEnv, ISegmentUriProvider& aUriProvider, std::vector<IUriLoader*>& aLoaders, TUint aBufferBytes, TUint aThreadPriority);
+    ~SegmentPrefetcher();
+    void Reset();
+    void GetStats(std::vector<HlsSegmentStats>& aStats) const; // most recent kMaxStats segments, oldest first
+public: // from ISegmentProvider
+    IReader& NextSegment() override;
+    void InterruptSegmentProvider(TBool aInterrupt) override;
+private:
+    void Fetch(Fetcher& aFetcher);
+    TBool CanStartLocked(const Fetcher& aFetcher) const;
+    void Download(Fetcher& aFetcher, const Uri& aUri, TUint aDurationMs);
+    TBool Write(Fetcher& aFetcher, const Brx& aBuf, TUint& aStalledMs);
+    Brn Read(Fetcher& aFetcher, TUint aBytes);
+    void SetStateLocked(Fetcher& aFetcher, EState aState);
+    void FreeLocked(Fetcher& aFetcher);
+    void ReleaseLocked(Fetcher& aFetcher);
+    void CancelLocked();
+    void SignalReaderLocked();
+    TUint NowMs() const;
+private:
+    OsContext& iCtx;
+    ISegmentUriProvider& iUriProvider;
+    const TUint iBufferBytes;
+    std::vector<IUriLoader*> iLoaders;
+    std::vector<Fetcher*> iFetchers;
+    mutable Mutex iLock;
+    Mutex iLockUri;
+    Semaphore iSemReader;
+    Semaphore iSemIdle;
+    Fetcher* iCurrent;
+    TUint64 iNextIndex;     // next to be assigned to a fetcher
+    TUint64 iNextReadIndex; // next to be returned from NextSegment()
+    TUint iWorking;
+    TBool iRunning;
+    TBool iAssignStopped;   // end of stream or error reached; no more segments will be assigned
+    TBool iInterrupted;
+    TBool iReaderWaiting;
+    TBool iQuit;
+    std::vector<HlsSegmentStats> iStats;
+};
+
+class SegmentProvider : public ISegmentProvider, private INonCopyable
 {
 private:
     static const TUint kConnectRetryIntervalMs = 1 * 1000;
 public:
+    static const TUint kDefaultPrefetchSegments = 2;
+    static const TUint kPrefetchBufferBytes = 256 * 1024; // per segment being fetched
+public:
+    /*
+     * aPrefetchSegments is the number of segments fetched ahead of the one being read.
+     * 0 disables prefetching; each segment is then requested as the previous one finishes.
+     * Otherwise, aPrefetchSegments+1 fetch threads are used, each with its own connection and
+     * a buffer of kPrefetchBufferBytes.  Threads and connections are created by the first call
+     * to NextSegment(); buffers are allocated on first use and freed by Reset().
+     */
     SegmentProvider(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory, ISegmentUriProvider& aProvider);
+    SegmentProvider(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, ITimerFactory& aTimerFactory, ISegmentUriProvider& aProvider, TUint aPrefetchSegments);
+    ~SegmentProvider();
     void Reset();
+    void GetStats(std::vector<HlsSegmentStats>& aStats) const;
 public: // from ISegmentProvider
     IReader& NextSegment() override;
     void InterruptSegmentProvider(TBool aInterrupt) override;
 private:
+    SegmentPrefetcher& Prefetcher();
+private:
+    Environment& iEnv;
+    SslContext& iSsl;
+    const Brh iUserAgent;
+    ITimerFactory& iTimerFactory;
     UriLoader iLoader;
     ISegmentUriProvider& iProvider;
+    SegmentLoader iSegmentLoader;
+    const TUint iPrefetchSegments;
+    std::vector<IUriLoader*> iPrefetchLoaders;
+    SegmentPrefetcher* iPrefetcher;
+    Mutex iLock;
+    TBool iInterrupted;
 };
 
 class SegmentDescriptor
@@ -236,6 +484,94 @@ private:
     TBool iInvalid;
 };
 
+class HlsVariantStream : private INonCopyable
+{
+public:
+    HlsVariantStream(const Brx& aUri, TUint aBandwidth, const Brx& aCodecs);
+    /*
+     * This is the URI contained within the master playlist.  It MAY be relative to the master playlist's URI.
+     */
+    const Brx& VariantUri() const;
+    /*
+     * THROWS UriError.
+     */
+    void AbsoluteUri(const Uri& aBaseUri, Uri& aUriOut) const;
+    TUint Bandwidth() const;    // peak bits per second, from BANDWIDTH attribute
+    const Brx& Codecs() const;  // from CODECS attribute; may be empty
+private:
+    const Brh iUri;
+    const TUint iBandwidth;
+    const Brh iCodecs;
+};
+
+/*
+ * Reads the variant streams listed by #EXT-X-STREAM-INF tags in a master playlist.
+ *
+ * Variants are sorted by increasing bandwidth.  Switching codec between segments isn't
+ * supported so variants whose CODECS differ from those of the lowest bandwidth variant are
+ * discarded, as are variants without a BANDWIDTH attribute.  I-frame only variants are ignored.
+ */
+class HlsMasterPlaylistParser : private INonCopyable
+{
+private:
+    static const TUint kMaxLineBytes = 2048;
+public:
+    HlsMasterPlaylistParser();
+    ~HlsMasterPlaylistParser();
+    /*
+     * Returns false if aReader is a media playlist rather than a master playlist.
+     *
+     * THROWS HlsPlaylistInvalid if aReader is a master playlist without any usable variants.
+     */
+    TBool Parse(IReader& aReader);
+    void Reset();
+    const std::vector<HlsVariantStream*>& Variants() const;
+private:
+    static TBool CompareBandwidth(const HlsVariantStream* aFirst, const HlsVariantStream* aSecond);
+    static void ParseAttributes(const Brx& aAttributes, TUint& aBandwidth, Brn& aCodecs); // THROWS AsciiError
+private:
+    std::vector<HlsVariantStream*> iVariants;
+};
+
+/*
+ * Chooses which variant of a stream to fetch based on the download rate of recent segments.
+ *
+ * Starts on the lowest bandwidth variant.  Steps up one variant at a time once kUpSwitchCount
+ * consecutive estimates show that the next variant would use no more than kSafetyPercent of
+ * the available throughput.  Drops straight to the highest variant that fits as soon as the
+ * current variant would use more than kDownSwitchPercent of it.
+ *
+ * Throughput is estimated as the harmonic mean of the download rates of the most recent
+ * kEstimateSegments segments, so a single fast segment can't cause an up-switch.
+ */
+class HlsVariantSelector
+{
+public:
+    static const TUint kEstimateSegments = 4;
+    static const TUint kSafetyPercent = 75;
+    static const TUint kDownSwitchPercent = 90;
+    static const TUint kUpSwitchCount = 2;
+public:
+    HlsVariantSelector();
+    void SetVariants(const std::vector<TUint>& aBandwidths); // aBandwidths must be in increasing order
+    /*
+     * Index into aBandwidths passed to SetVariants().
+     */
+    TUint Current() const;
+    TUint EstimateBps() const; // 0 if no segments have been downloaded
+    /*
+     * aStats are ordered oldest first (as returned by SegmentProvider::GetStats()).
+     *
+     * Returns true if Current() has changed.
+     */
+    TBool Update(const std::vector<HlsSegmentStats>& aStats);
+private:
+    std::vector<TUint> iBandwidths;
+    TUint iCurrent;
+    TUint iEstimateBps;
+    TUint iUpCount;
+};
+
 class IHlsReloadTimer
 {
 public:
@@ -291,6 +627,19 @@ public:
      */
     void SetStartSegment(TUint64 aPreferredStartSegment);
     TUint64 LastSegment() const;
+    /*
+     * Switch to another variant of the current stream.  May be called from any thread.
+     *
+     * Takes effect on the next call to NextSegmentUri(), which loads aUri and continues from the
+     * segment following LastSegment().
+     */
+    void SwitchVariant(const Uri& aUri, TUint aBandwidth);
+    /*
+     * Returns true (and the bandwidth passed to SwitchVariant()) if aSegment is the first segment
+     * returned from a new variant.  Segments are numbered from 0 in the order NextSegmentUri()
+     * returned them since Reset().
+     */
+    TBool VariantChanged(TUint64 aSegment, TUint& aBandwidth);
 public: // from ISegmentUriProvider
     TUint NextSegmentUri(Uri& aUri) override;
     void InterruptSegmentUriProvider(TBool aInterrupt) override;
@@ -305,6 +654,12 @@ private:
     TBool iNewSegmentEncountered;
     std::atomic<TBool> iInterrupted;
     TBool iError;
+    Mutex iLockVariant;
+    Bws<Uri::kMaxUriBytes> iPendingVariantUri;
+    TUint iPendingBandwidth;
+    TBool iVariantPending;
+    TUint64 iSegmentCount;
+    std::vector<std::pair<TUint64, TUint>> iVariantChanges; // (first segment, bandwidth)
 };
 
 /*
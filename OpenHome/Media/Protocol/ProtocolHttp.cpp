@@ -1,5 +1,6 @@
 #include <OpenHome/Media/Protocol/ProtocolFactory.h>
 #include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Protocol/HttpConnectionPool.h>
 #include <OpenHome/Exception.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Types.h>
@@ -7,6 +8,7 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Network.h>
 #include <OpenHome/SocketSsl.h>
+#include <OpenHome/SocketHttp.h>
 #include <OpenHome/Private/Uri.h>
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Private/Parser.h>
@@ -36,15 +38,61 @@ private:
     std::vector<IServerObserver*> iServerObservers;
 };
 
+/*
+ * Forwards to the socket of the pooled connection a stream is currently using.
+ * Reads and writes fail if there is no connection.
+ */
+class SocketProxy : public IWriter, public IReaderSource, private INonCopyable
+{
+public:
+    SocketProxy();
+    void Set(SocketSsl* aSocket);
+public: // from IWriter
+    void Write(TByte aValue) override;
+    void Write(const Brx& aBuffer) override;
+    void WriteFlush() override;
+public: // from IReaderSource
+    void Read(Bwx& aBuffer) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+private:
+    SocketSsl* Socket();
+private:
+    Mutex iLock;
+    SocketSsl* iSocket;
+};
+
+/*
+ * Limits reads to the body of the current response.  Reading past the end of a body on a
+ * persistent connection throws ReaderError (as a closed connection would) rather than
+ * blocking until the server times the connection out.
+ */
+class ReaderHttpBody : public IReader
+{
+public:
+    ReaderHttpBody(IReader& aReader);
+    void SetContentLength(TUint64 aBytes);
+    void SetUnbounded(); // length unknown; read until the server closes the connection
+    TBool Complete() const; // true if a body of known length has been read in full
+public: // from IReader
+    Brn Read(TUint aBytes) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+private:
+    IReader& iReader;
+    TBool iBounded;
+    TUint64 iRemaining;
+};
+
 class ProtocolHttp : public Protocol , private IReader , private IIcyObserver
 {
     static const Brn kSchemeHttp;
     static const Brn kSchemeHttps;
     static const TUint kReadBufferBytes = 6 * 1024;
     static const TUint kWriteBufferBytes = 1024;
-    static const TUint kConnectTimeoutMs = 3000;
     static const TUint kMaxUserAgentBytes = 64;
     static const TUint kMaxContentRecognitionBytes = 100;
+    static const TUint kMaxRangeBytes = 64;
 public:
     ProtocolHttp(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent);
     ProtocolHttp(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, Optional<IServerObserver> aServerObserver);
@@ -66,22 +114,24 @@ private: // from IReader
 private: // from IIcyObserver
     void NotifyIcyData(const Brx& aIcyData) override;
 private:
-    TBool Connect(const Uri& aUri);
+    TBool Connect(const Uri& aUri, TBool& aReused);
     TInt PortFromUri(const Uri& aUri) const;
     void Close();
     void Reinitialise(const Brx& aUri);
     ProtocolStreamResult DoStream();
-    ProtocolGetResult DoGet(IWriter& aWriter, TUint64 aOffset, TUint aBytes);
+    ProtocolGetResult DoGet(HttpConnectionPool::Connection& aConnection, IWriter& aWriter, TUint64 aOffset, TUint aBytes, TBool& aReusable, TBool& aRetry);
     ProtocolStreamResult DoSeek(TUint64 aOffset);
     ProtocolStreamResult DoLiveStream();
     void StartStream();
     TUint WriteRequest(TUint64 aOffset);
+    TUint TryWriteRequest(TUint64 aOffset, TBool& aReused);
     ProtocolStreamResult ProcessContent();
     TBool ContinueStreaming(ProtocolStreamResult aResult);
     TBool IsCurrentStream(TUint aStreamId) const;
 private:
     Mutex iLock;
-    SocketSsl iSocket;
+    SslContext& iSsl;
+    SocketProxy iSocket;
     Srs<kReadBufferBytes> iReaderBuf;
     Sws<kWriteBufferBytes> iWriterBuf;
     SupplyAggregator* iSupply;
@@ -89,12 +139,14 @@ private:
     ReaderUntilS<2048> iReaderUntil;
     ReaderHttpResponse iReaderResponse;
     ReaderHttpChunked iDechunker;
+    ReaderHttpBody iReaderBody;
     ContentRecogBuf iContentRecogBuf;
     ReaderIcy* iReaderIcy;
     HttpHeaderContentType iHeaderContentType;
     HttpHeaderContentLength iHeaderContentLength;
     HttpHeaderLocation iHeaderLocation;
     HttpHeaderTransferEncoding iHeaderTransferEncoding;
+    SocketHttpHeaderConnection iHeaderConnection;
     HeaderIcyMetadata iHeaderIcyMetadata;
     HeaderServer iHeaderServer;
     Bws<kMaxUserAgentBytes> iUserAgent;
@@ -115,6 +167,9 @@ private:
     TUint iNextFlushId;
     Semaphore iSem;
     Optional<IServerObserver> iServerObserver;
+    HttpConnectionPool::Connection* iConnection;    // used by Stream()
+    HttpConnectionPool::Connection* iGetConnection;
+    TBool iKeepAlive;                               // server allows iConnection to be reused
 };
 
 };  // namespace Media
@@ -195,6 +250,134 @@ void HeaderServer::RemoveServerObserver(IServerObserver& aObserver)
 }
 
 
+// SocketProxy
+
+SocketProxy::SocketProxy()
+    : iLock("PHSP")
+    , iSocket(nullptr)
+{
+}
+
+void SocketProxy::Set(SocketSsl* aSocket)
+{
+    AutoMutex _(iLock);
+    iSocket = aSocket;
+}
+
+SocketSsl* SocketProxy::Socket()
+{
+    // Don't hold iLock while reading or writing as these block.  The socket is only
+    // replaced by the thread that reads and writes.
+    AutoMutex _(iLock);
+    return iSocket;
+}
+
+void SocketProxy::Write(TByte aValue)
+{
+    auto socket = Socket();
+    if (socket == nullptr) {
+        THROW(WriterError);
+    }
+    socket->Write(aValue);
+}
+
+void SocketProxy::Write(const Brx& aBuffer)
+{
+    auto socket = Socket();
+    if (socket == nullptr) {
+        THROW(WriterError);
+    }
+    socket->Write(aBuffer);
+}
+
+void SocketProxy::WriteFlush()
+{
+    auto socket = Socket();
+    if (socket == nullptr) {
+        THROW(WriterError);
+    }
+    socket->WriteFlush();
+}
+
+void SocketProxy::Read(Bwx& aBuffer)
+{
+    auto socket = Socket();
+    if (socket == nullptr) {
+        THROW(ReaderError);
+    }
+    socket->Read(aBuffer);
+}
+
+void SocketProxy::ReadFlush()
+{
+    AutoMutex _(iLock);
+    if (iSocket != nullptr) {
+        iSocket->ReadFlush();
+    }
+}
+
+void SocketProxy::ReadInterrupt()
+{
+    AutoMutex _(iLock);
+    if (iSocket != nullptr) {
+        iSocket->ReadInterrupt();
+    }
+}
+
+
+// ReaderHttpBody
+
+ReaderHttpBody::ReaderHttpBody(IReader& aReader)
+    : iReader(aReader)
+    , iBounded(false)
+    , iRemaining(0)
+{
+}
+
+void ReaderHttpBody::SetContentLength(TUint64 aBytes)
+{
+    iBounded = true;
+    iRemaining = aBytes;
+}
+
+void ReaderHttpBody::SetUnbounded()
+{
+    iBounded = false;
+    iRemaining = 0;
+}
+
+TBool ReaderHttpBody::Complete() const
+{
+    return iBounded && iRemaining == 0;
+}
+
+Brn ReaderHttpBody::Read(TUint aBytes)
+{
+    if (!iBounded) {
+        return iReader.Read(aBytes);
+    }
+    if (iRemaining == 0) {
+        THROW(ReaderError);
+    }
+    if (aBytes > iRemaining) {
+        aBytes = (TUint)iRemaining;
+    }
+    Brn buf = iReader.Read(aBytes);
+    iRemaining -= buf.Bytes();
+    return buf;
+}
+
+void ReaderHttpBody::ReadFlush()
+{
+    iReader.ReadFlush();
+}
+
+void ReaderHttpBody::ReadInterrupt()
+{
+    iReader.ReadInterrupt();
+}
+
+
 // ProtocolHttp
 
 const Brn ProtocolHttp::kSchemeHttp("http");
@@ -209,7 +392,7 @@ ProtocolHttp::ProtocolHttp(Environment& aEnv, SslContext& aSsl, const Brx& aUser
 ProtocolHttp::ProtocolHttp(Environment& aEnv, SslContext& aSsl, const Brx& aUserAgent, Optional<IServerObserver> aServerObserver)
     : Protocol(aEnv)
     , iLock("PHTP")
-    , iSocket(aEnv, aSsl, kReadBufferBytes)
+    , iSsl(aSsl)
     , iReaderBuf(iSocket)
     , iWriterBuf(iSocket)
     , iSupply(nullptr)
@@ -217,7 +400,8 @@ ProtocolHttp::ProtocolHttp(Environment& aEnv, SslContext& aSsl, const Brx& aUser
     , iReaderUntil(iReaderBuf)
     , iReaderResponse(aEnv, iReaderUntil)
     , iDechunker(iReaderUntil)
-    , iContentRecogBuf(iDechunker)
+    , iReaderBody(iDechunker)
+    , iContentRecogBuf(iReaderBody)
     , iUserAgent(aUserAgent)
     , iTotalStreamBytes(0)
     , iTotalBytes(0)
@@ -225,6 +409,9 @@ ProtocolHttp::ProtocolHttp(Environment& aEnv, SslContext& aSsl, const Brx& aUser
     , iSeekable(false)
     , iSem("PRTH", 0)
     , iServerObserver(aServerObserver)
+    , iConnection(nullptr)
+    , iGetConnection(nullptr)
+    , iKeepAlive(false)
 {
     iIcyObserverDidlLite = new IcyObserverDidlLite(*this);
     iReaderIcy = new ReaderIcy(iContentRecogBuf, *iIcyObserverDidlLite, iOffset);
@@ -233,6 +420,7 @@ ProtocolHttp::ProtocolHttp(Environment& aEnv, SslContext& aSsl, const Brx& aUser
     iReaderResponse.AddHeader(iHeaderContentLength);
     iReaderResponse.AddHeader(iHeaderLocation);
     iReaderResponse.AddHeader(iHeaderTransferEncoding);
+    iReaderResponse.AddHeader(iHeaderConnection);
     iReaderResponse.AddHeader(iHeaderIcyMetadata);
     iReaderResponse.AddHeader(iHeaderServer);
     if (iServerObserver.Ok()) {
@@ -264,7 +452,12 @@ void ProtocolHttp::Interrupt(TBool aInterrupt)
             iStopped = true;
             iSem.Signal(); // no need to check iLive - iSem will be cleared when this protocol is next reused anyway
         }
-        iSocket.Interrupt(aInterrupt);
+        if (iConnection != nullptr) {
+            iConnection->Interrupt(aInterrupt);
+        }
+        if (iGetConnection != nullptr) {
+            iGetConnection->Interrupt(aInterrupt);
+        }
     }
 }
 
@@ -279,6 +472,7 @@ ProtocolStreamResult ProtocolHttp::Stream(const Brx& aUri)
 
     ProtocolStreamResult res = DoStream();
     if (res == EProtocolStreamErrorUnrecoverable) {
+        Close();
         if (iContentProcessor != nullptr) {
             iContentProcessor->Reset();
         }
@@ -352,21 +546,43 @@ ProtocolGetResult ProtocolHttp::Get(IWriter& aWriter, const Brx& aUri, TUint64 a
     LOG(kMedia, "> ProtocolHttp::Get\n");
     Reinitialise(aUri);
 
-    if (iUri.Scheme() != Brn("http")) {
+    if (iUri.Scheme() != kSchemeHttp && iUri.Scheme() != kSchemeHttps) {
         LOG(kMedia, "ProtocolHttp::Get Scheme not recognised\n");
-        Close();
         return EProtocolGetErrorNotSupported;
     }
 
-    Close();
-    if (!Connect(iUri)) {
-        LOG(kMedia, "ProtocolHttp::Get Connection failure\n");
-        return EProtocolGetErrorUnrecoverable;
+    // Reads are made over persistent connections shared with other protocol instances.
+    // A server may close an idle connection at any point so a request that fails before
+    // any response is read from a reused connection is retried once on a new one.
+    HttpConnectionPool& pool = iProtocolManager->ConnectionPool();
+    ProtocolGetResult res = EProtocolGetErrorUnrecoverable;
+    TBool retry = true;
+    for (TUint attempt = 0; attempt < 2 && retry; attempt++) {
+        HttpConnectionPool::Connection* conn = nullptr;
+        try {
+            conn = pool.Acquire(iEnv, iSsl, iUri);
+        }
+        catch (SocketHttpUriError&) {
+            LOG(kMedia, "ProtocolHttp::Get Connection failure\n");
+            break;
+        }
+        {
+            AutoMutex _(iLock);
+            if (iStopped) {
+                pool.Release(conn, false);
+                break;
+            }
+            iGetConnection = conn;
+        }
+        TBool reusable = false;
+        res = DoGet(*conn, aWriter, aOffset, aBytes, reusable, retry);
+        {
+            AutoMutex _(iLock);
+            iGetConnection = nullptr;
+            retry = retry && !iStopped;
+        }
+        pool.Release(conn, reusable);
     }
-
-    ProtocolGetResult res = DoGet(aWriter, aOffset, aBytes);
-    iSocket.Interrupt(false);
-    Close();
     LOG(kMedia, "< ProtocolHttp::Get\n");
     return res;
 }
@@ -415,7 +631,9 @@ TUint ProtocolHttp::TrySeek(TUint aStreamId, TUint64 aOffset)
         iNextFlushId = iFlushIdProvider->NextFlushId();
     }
 
-    iSocket.Interrupt(true);
+    if (iConnection != nullptr) {
+        iConnection->Interrupt(true);
+    }
     return iNextFlushId;
 }
 
@@ -435,7 +653,9 @@ TUint ProtocolHttp::TryStop(TUint aStreamId)
     }
     LOG(kMedia, "ProtocolHttp::TryStop(%u), iStreamId=%u, iNextFlushId=%u\n", aStreamId, iStreamId, iNextFlushId);
     iStopped = true;
-    iSocket.Interrupt(true);
+    if (iConnection != nullptr) {
+        iConnection->Interrupt(true);
+    }
     if (iLive) {
         iSem.Signal();
     }
@@ -464,37 +684,38 @@ void ProtocolHttp::NotifyIcyData(const Brx& aIcyData)
     iSupply->OutputMetadata(aIcyData);
 }
 
-TBool ProtocolHttp::Connect(const Uri& aUri)
+TBool ProtocolHttp::Connect(const Uri& aUri, TBool& aReused)
 {
-    Endpoint endpoint;
+    HttpConnectionPool& pool = iProtocolManager->ConnectionPool();
+    HttpConnectionPool::Connection* conn = nullptr;
     try {
-        endpoint.SetAddress(aUri.Host());
-        const TInt port = PortFromUri(aUri);
-        endpoint.SetPort(port);
+        conn = pool.Acquire(iEnv, iSsl, aUri);
     }
-    catch (NetworkError&) {
+    catch (SocketHttpUriError&) {
         LOG(kMedia, "<ProtocolHttp::Connect error setting address and port\n");
         return false;
     }
-
-    const TBool isSecure = aUri.Scheme() == kSchemeHttps;
-    iSocket.SetSecure(isSecure);
+    {
+        AutoMutex _(iLock);
+        if (iStopped) {
+            pool.Release(conn, false);
+            return false;
+        }
+        iConnection = conn;
+    }
 
     try {
-        iSocket.Connect(endpoint, aUri.Host(), kConnectTimeoutMs);
+        pool.Connect(*conn);
     }
-    catch (NetworkTimeout&) {
-        Close();
-        LOG(kMedia, "<ProtocolHttp::Connect timeout connecting\n");
-        return false;
-    }
-    catch (NetworkError&) {
+    catch (SocketHttpConnectionError&) {
         Close();
         LOG(kMedia, "<ProtocolHttp::Connect error connecting\n");
         return false;
     }
+    aReused = conn->Reused();
+    iSocket.Set(&conn->Socket().Socket());
 
-    LOG(kMedia, "<ProtocolHttp::Connect\n");
+    LOG(kMedia, "<ProtocolHttp::Connect (%s connection)\n", aReused? "reused" : "new");
     return true;
 }
 
@@ -512,7 +733,19 @@ TInt ProtocolHttp::PortFromUri(const Uri& aUri) const
 
 void ProtocolHttp::Close()
 {
-    iSocket.Close();
+    HttpConnectionPool::Connection* conn = nullptr;
+    {
+        AutoMutex _(iLock);
+        conn = iConnection;
+        iConnection = nullptr;
+    }
+    iSocket.Set(nullptr);
+    if (conn != nullptr) {
+        // the connection can only carry another request if we read all of this response
+        const TBool reusable = iKeepAlive && iReaderBody.Complete();
+        iProtocolManager->ConnectionPool().Release(conn, reusable);
+    }
+    iKeepAlive = false;
 }
 
 void ProtocolHttp::Reinitialise(const Brx& aUri)
@@ -579,53 +812,55 @@ ProtocolStreamResult ProtocolHttp::DoStream()
     return ProcessContent();
 }
 
-ProtocolGetResult ProtocolHttp::DoGet(IWriter& aWriter, TUint64 aOffset, TUint aBytes)
+ProtocolGetResult ProtocolHttp::DoGet(HttpConnectionPool::Connection& aConnection, IWriter& aWriter, TUint64 aOffset, TUint aBytes, TBool& aReusable, TBool& aRetry)
 {
+    aReusable = aRetry = false;
+    SocketHttp& socket = aConnection.Socket();
     try {
-        LOG(kMedia, "ProtocolHttp::DoGet send request\n");
-        iWriterRequest.WriteMethod(Http::kMethodGet, iUri.PathAndQuery(), Http::eHttp11);
-        const TUint port = PortFromUri(iUri);
-        Http::WriteHeaderHostAndPort(iWriterRequest, iUri.Host(), port);
-        Http::WriteHeaderConnectionClose(iWriterRequest);
+        LOG(kMedia, "ProtocolHttp::DoGet send request (%s connection)\n", aConnection.Reused()? "reused" : "new");
         TUint64 last = aOffset+aBytes;
         if (last > 0) {
             last -= 1;  // need to adjust for last byte position as request
                         // requires absolute positions, rather than range
         }
-        Http::WriteHeaderRange(iWriterRequest, aOffset, last);
-        iWriterRequest.WriteFlush();
-    }
-    catch(WriterError&) {
-        LOG(kMedia, "ProtocolHttp::DoGet WriterError\n");
-        return EProtocolGetErrorUnrecoverable;
-    }
+        Bws<kMaxRangeBytes> range("bytes=");
+        Ascii::AppendDec(range, aOffset);
+        range.Append('-');
+        Ascii::AppendDec(range, last);
+        socket.SetRequestHeader(Http::kHeaderRange, range);
+        socket.SetRequestHeader(Http::kHeaderConnection, SocketHttpHeaderConnection::kConnectionKeepAlive);
+        iProtocolManager->ConnectionPool().Connect(aConnection);
 
-    try {
         LOG(kMedia, "ProtocolHttp::DoGet read response\n");
-        iReaderResponse.Read();
-
-        const TUint code = iReaderResponse.Status().Code();
-        iTotalBytes = iHeaderContentLength.ContentLength();
-        iTotalBytes = std::min(iTotalBytes, (TUint64)aBytes);
+        const TInt code = socket.GetResponseCode();
         // FIXME - should parse the Content-Range response to ensure we're
         // getting the bytes requested - the server may (validly) opt not to
         // honour our request.
         LOG(kMedia, "ProtocolHttp::DoGet response code %d\n", code);
-        if (code != HttpStatus::kPartialContent.Code() && code != HttpStatus::kOk.Code()) {
-            LOG(kMedia, "ProtocolHttp::DoGet server returned error %u\n", code);
+        if (code != (TInt)HttpStatus::kPartialContent.Code() && code != (TInt)HttpStatus::kOk.Code()) {
+            LOG(kMedia, "ProtocolHttp::DoGet server returned error %d\n", code);
             return EProtocolGetErrorUnrecoverable;
         }
-        if (code == HttpStatus::kPartialContent.Code()) {
-            LOG(kMedia, "ProtocolHttp::DoGet 'Partial Content' (%lld bytes)\n", iTotalBytes);
-            if (iTotalBytes >= aBytes) {
-                TUint64 count = 0;
+        const TInt contentLength = socket.GetContentLength(); // -1 if chunked
+        if (code == (TInt)HttpStatus::kPartialContent.Code()) {
+            LOG(kMedia, "ProtocolHttp::DoGet 'Partial Content' (%d bytes)\n", contentLength);
+            if (contentLength >= 0) {
+                // A server clamps a range that runs past the end of the resource, returning
+                // fewer bytes than requested.  Pass these on (and read the whole body so the
+                // connection can be reused) but still report failure as aBytes weren't read.
+                const TUint toRead = ((TUint64)contentLength < aBytes? (TUint)contentLength : aBytes);
+                IReader& reader = socket.GetInputStream();
+                TUint count = 0;
                 TUint bytes = 1024; // FIXME - choose better value or justify this
-                while (count < iTotalBytes) {
-                    const TUint remaining = static_cast<TUint>(iTotalBytes-count);
+                while (count < toRead) {
+                    const TUint remaining = toRead - count;
                     if (remaining < bytes) {
                         bytes = remaining;
                     }
-                    Brn buf = Read(bytes);
+                    Brn buf = reader.Read(bytes);
+                    if (buf.Bytes() == 0) {
+                        THROW(ReaderError);
+                    }
                     aWriter.Write(buf);
                     count += buf.Bytes();
                     // If we start pushing some bytes to IWriter then get an
@@ -634,18 +869,28 @@ ProtocolGetResult ProtocolHttp::DoGet(IWriter& aWriter, TUint64 aOffset, TUint a
                     // receive duplicate data and TryGet() will return false,
                     // so IWriter knows to invalidate any data it's received.
                 }
+                // connection can only be reused if the server sent no more than we asked for
+                aReusable = (reader.Read(1).Bytes() == 0);
+                if (count < aBytes) {
+                    LOG(kMedia, "ProtocolHttp::DoGet short range (%u of %u bytes)\n", count, aBytes);
+                    return EProtocolGetErrorUnrecoverable;
+                }
                 return EProtocolGetSuccess;
             }
         }
         else { // code == HttpStatus::kOk.Code()
-            LOG(kMedia, "ProtocolHttp::DoGet 'OK' (%lld bytes)\n", iTotalBytes);
+            LOG(kMedia, "ProtocolHttp::DoGet 'OK' (%d bytes)\n", contentLength);
         }
-
     }
-    catch(HttpError&) {
-        LOG(kMedia, "ProtocolHttp::DoGet HttpError\n");
+    catch (SocketHttpConnectionError&) {
+        LOG(kMedia, "ProtocolHttp::DoGet SocketHttpConnectionError\n");
+        aRetry = aConnection.Reused();
     }
-    catch(ReaderError&) {
+    catch (SocketHttpError&) {
+        LOG(kMedia, "ProtocolHttp::DoGet SocketHttpError\n");
+        aRetry = aConnection.Reused();
+    }
+    catch (ReaderError&) {
         LOG(kMedia, "ProtocolHttp::DoGet ReaderError\n");
     }
     return EProtocolGetErrorUnrecoverable;
@@ -687,11 +932,30 @@ void ProtocolHttp::StartStream()
 }
 
 TUint ProtocolHttp::WriteRequest(TUint64 aOffset)
+{
+    // Requests are made over persistent connections shared with other protocol instances.
+    // A server may close an idle connection at any point so a request that fails on a
+    // reused connection is retried once on a new one.
+    TUint code = 0;
+    for (TUint attempt = 0; attempt < 2; attempt++) {
+        TBool reused = false;
+        code = TryWriteRequest(aOffset, reused);
+        if (code != 0 || !reused) {
+            break;
+        }
+        AutoMutex _(iLock);
+        if (iStopped || iSeek) {
+            break;
+        }
+    }
+    return code;
+}
+
+TUint ProtocolHttp::TryWriteRequest(TUint64 aOffset, TBool& aReused)
 {
     iContentRecogBuf.ReadFlush();
-    //iSocket.LogVerbose(true);
     Close();
-    if (!Connect(iUri)) {
+    if (!Connect(iUri, aReused)) {
         LOG(kMedia, "ProtocolHttp::WriteRequest Connection failure\n");
         return 0;
     }
@@ -724,7 +988,7 @@ TUint ProtocolHttp::WriteRequest(TUint64 aOffset)
         if (iUserAgent.Bytes() > 0) {
             iWriterRequest.WriteHeader(Http::kHeaderUserAgent, iUserAgent);
         }
-        Http::WriteHeaderConnectionClose(iWriterRequest);
+        iWriterRequest.WriteHeader(Http::kHeaderConnection, SocketHttpHeaderConnection::kConnectionKeepAlive);
         if (!nonAudioUri) {
             // Suppress ICY metadata and Range header for resources such as playlist files.
             HeaderIcyMetadata::Write(iWriterRequest);
@@ -753,6 +1017,15 @@ TUint ProtocolHttp::WriteRequest(TUint64 aOffset)
     }
     const TUint code = iReaderResponse.Status().Code();
     LOG(kMedia, "ProtocolHttp::WriteRequest response code %d\n", code);
+    // See https://tools.ietf.org/html/rfc7230#section-6.3 (as SocketHttp)
+    iKeepAlive = !iHeaderConnection.Close()
+              && (iReaderResponse.Version() == Http::EVersion::eHttp11 || iHeaderConnection.KeepAlive());
+    if (iHeaderContentLength.Received() && !iHeaderTransferEncoding.IsChunked()) {
+        iReaderBody.SetContentLength(iHeaderContentLength.ContentLength());
+    }
+    else {
+        iReaderBody.SetUnbounded();
+    }
     return code;
 }
 
@@ -0,0 +1,266 @@
+#include <OpenHome/Media/Protocol/UrlBlockCache.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <algorithm>
+#include <list>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// UrlBlockCache::Block
+
+UrlBlockCache::Block::Block()
+    : iIndex(0)
+    , iValid(false)
+{
+}
+
+
+// UrlBlockCache::BlockWriter
+
+UrlBlockCache::BlockWriter::BlockWriter(std::vector<Block*>& aBlocks)
+    : iBlocks(aBlocks)
+    , iIndex(0)
+    , iBytes(0)
+{
+}
+
+TUint64 UrlBlockCache::BlockWriter::Bytes() const
+{
+    return iBytes;
+}
+
+void UrlBlockCache::BlockWriter::Write(TByte aValue)
+{
+    Write(Brn(&aValue, 1));
+}
+
+void UrlBlockCache::BlockWriter::Write(const Brx& aBuffer)
+{
+    TUint offset = 0;
+    while (offset < aBuffer.Bytes() && iIndex < iBlocks.size()) {
+        Bwx& data = iBlocks[iIndex]->iData;
+        const TUint bytes = std::min(aBuffer.Bytes() - offset, data.MaxBytes() - data.Bytes());
+        data.Append(Brn(aBuffer.Ptr() + offset, bytes));
+        offset += bytes;
+        if (data.Bytes() == data.MaxBytes()) {
+            iIndex++;
+        }
+    }
+    iBytes += offset;
+}
+
+void UrlBlockCache::BlockWriter::WriteFlush()
+{
+}
+
+
+// UrlBlockCache
+
+const Brn UrlBlockCache::kQueryBlockCache("blockcache");
+
+UrlBlockCache::UrlBlockCache(IUrlBlockWriter& aUpstream)
+    : iUpstream(aUpstream)
+    , iLock("UBCL")
+    , iRequests(0)
+    , iHits(0)
+    , iFetches(0)
+    , iFetchedBytes(0)
+    , iEvictions(0)
+{
+    for (TUint i=0; i<kMaxBlocks; i++) {
+        iBlocks.push_back(new Block());
+    }
+}
+
+UrlBlockCache::UrlBlockCache(IUrlBlockWriter& aUpstream, IInfoAggregator& aInfoAggregator)
+    : UrlBlockCache(aUpstream)
+{
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryBlockCache);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+UrlBlockCache::~UrlBlockCache()
+{
+    for (auto block : iBlocks) {
+        delete block;
+    }
+}
+
+void UrlBlockCache::GetStats(TUint64& aRequests, TUint64& aHits, TUint64& aFetches, TUint64& aFetchedBytes) const
+{
+    aRequests = iRequests.load();
+    aHits = iHits.load();
+    aFetches = iFetches.load();
+    aFetchedBytes = iFetchedBytes.load();
+}
+
+TBool UrlBlockCache::TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes)
+{
+    iRequests++;
+    if (aBytes == 0 || aBytes > kBlockBytes || aUrl.Bytes() > kMaxUrlBytes) {
+        return FetchUncached(aWriter, aUrl, aOffset, aBytes);
+    }
+
+    AutoMutex _(iLock);
+    if (aUrl != iUrl) {
+        for (auto block : iBlocks) {
+            block->iValid = false;
+        }
+        iUrl.Replace(aUrl);
+    }
+
+    const TUint64 first = aOffset / kBlockBytes;
+    const TUint64 last = (aOffset + aBytes - 1) / kBlockBytes;
+    TUint64 fetchIndex = 0;
+    TUint fetchCount = 0;
+    for (TUint64 i=first; i<=last; i++) {
+        Block* block = Find(i);
+        if (block != nullptr && Covers(block, aOffset, aBytes)) {
+            Use(block);
+        }
+        else {
+            if (block != nullptr) {
+                // block is short (end of stream or an earlier fetch failed) - try fetching it again
+                block->iValid = false;
+            }
+            if (fetchCount == 0) {
+                fetchIndex = i;
+            }
+            fetchCount = (TUint)(i - fetchIndex + 1);
+        }
+    }
+
+    if (fetchCount == 0) {
+        iHits++;
+    }
+    else {
+        if (fetchIndex + fetchCount - 1 == last) {
+            for (TUint i=0; i<kReadAheadBlocks && Find(fetchIndex + fetchCount) == nullptr; i++) {
+                fetchCount++;
+            }
+        }
+        Fetch(fetchIndex, fetchCount);
+    }
+    if (TryWrite(aWriter, aOffset, aBytes)) {
+        return true;
+    }
+    return FetchUncached(aWriter, aUrl, aOffset, aBytes);
+}
+
+UrlBlockCache::Block* UrlBlockCache::Find(TUint64 aIndex)
+{
+    for (auto block : iBlocks) {
+        if (block->iValid && block->iIndex == aIndex) {
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+TBool UrlBlockCache::Covers(const Block* aBlock, TUint64 aOffset, TUint aBytes) const
+{
+    const TUint64 blockStart = aBlock->iIndex * kBlockBytes;
+    const TUint64 end = std::min(aOffset + aBytes, blockStart + kBlockBytes);
+    return aBlock->iData.Bytes() >= end - blockStart;
+}
+
+void UrlBlockCache::Use(Block* aBlock)
+{
+    iBlocks.remove(aBlock);
+    iBlocks.push_back(aBlock);
+}
+
+void UrlBlockCache::Fetch(TUint64 aIndex, TUint aCount)
+{
+    /* Blocks for the current request were moved to the back of iBlocks by Use() so won't be
+       reclaimed here.  A request spans at most 2 blocks so kMaxBlocks leaves enough for read-ahead. */
+    std::vector<Block*> blocks;
+    for (TUint i=0; i<aCount; i++) {
+        auto it = iBlocks.begin();
+        while (it != iBlocks.end() && (*it)->iValid) {
+            ++it;
+        }
+        if (it == iBlocks.end()) { // no unused blocks; reclaim the least recently used
+            it = iBlocks.begin();
+            iEvictions++;
+        }
+        Block* block = *it;
+        iBlocks.erase(it);
+        iBlocks.push_back(block);
+        block->iIndex = aIndex + i;
+        block->iData.SetBytes(0);
+        block->iValid = true;
+        blocks.push_back(block);
+    }
+
+    BlockWriter writer(blocks);
+    iFetches++;
+    // failure is expected if read-ahead went past the end of the stream.  Keep whatever was read.
+    (void)iUpstream.TryGet(writer, iUrl, aIndex * kBlockBytes, aCount * kBlockBytes);
+    iFetchedBytes += writer.Bytes();
+    for (auto block : blocks) {
+        block->iValid = (block->iData.Bytes() > 0);
+    }
+}
+
+TBool UrlBlockCache::TryWrite(IWriter& aWriter, TUint64 aOffset, TUint aBytes)
+{
+    const TUint64 first = aOffset / kBlockBytes;
+    const TUint64 last = (aOffset + aBytes - 1) / kBlockBytes;
+    for (TUint64 i=first; i<=last; i++) {
+        Block* block = Find(i);
+        if (block == nullptr || !Covers(block, aOffset, aBytes)) {
+            return false;
+        }
+    }
+    const TUint64 end = aOffset + aBytes;
+    TUint64 offset = aOffset;
+    while (offset < end) {
+        Block* block = Find(offset / kBlockBytes);
+        const TUint start = (TUint)(offset - block->iIndex * kBlockBytes);
+        const TUint bytes = (TUint)std::min(end - offset, (TUint64)(kBlockBytes - start));
+        aWriter.Write(Brn(block->iData.Ptr() + start, bytes));
+        offset += bytes;
+    }
+    return true;
+}
+
+TBool UrlBlockCache::FetchUncached(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes)
+{
+    iFetches++;
+    const TBool ok = iUpstream.TryGet(aWriter, aUrl, aOffset, aBytes);
+    if (ok) {
+        iFetchedBytes += aBytes;
+    }
+    return ok;
+}
+
+void UrlBlockCache::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    if (aQuery != kQueryBlockCache) {
+        return;
+    }
+    TUint64 requests, hits, fetches, fetchedBytes;
+    GetStats(requests, hits, fetches, fetchedBytes);
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("UrlBlockCache\n    requests="));
+    writer.WriteUint64(requests);
+    writer.Write(Brn(" hits="));
+    writer.WriteUint64(hits);
+    writer.Write(Brn(" fetches="));
+    writer.WriteUint64(fetches);
+    writer.Write(Brn(" fetchedBytes="));
+    writer.WriteUint64(fetchedBytes);
+    writer.Write(Brn(" evictions="));
+    writer.WriteUint64(iEvictions.load());
+    writer.Write(Brn("\n"));
+}
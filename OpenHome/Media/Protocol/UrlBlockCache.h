@@ -0,0 +1,94 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <atomic>
+#include <list>
+#include <vector>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Read-ahead cache for out-of-band reads (IUrlBlockWriter::TryGet()) of a stream.
+ *
+ * Containers and codecs read metadata in small blocks, often working sequentially through a
+ * table near the end of a file.  Requests of up to kBlockBytes are served from cached
+ * kBlockBytes-aligned blocks.  Missing blocks are fetched, along with up to kReadAheadBlocks
+ * following ones, in a single upstream request.  The kMaxBlocks most recently used blocks
+ * are kept.  Blocks are cached for one url at a time; a request for another url discards them.
+ *
+ * A read ahead that runs past the end of the stream fails upstream but still returns the
+ * bytes up to the end; these are cached.  Larger requests, and any that can't be satisfied
+ * from the cache (e.g. because they extend past the end of the stream), are passed upstream
+ * unchanged.
+ * Cached requests are serialised; an upstream fetch blocks other cached requests.
+ */
+class UrlBlockCache : public IUrlBlockWriter, private IInfoProvider, private INonCopyable
+{
+public:
+    static const Brn kQueryBlockCache;
+    static const TUint kBlockBytes = 16 * 1024;
+    static const TUint kReadAheadBlocks = 2;
+    static const TUint kMaxBlocks = 8;
+private:
+    static const TUint kMaxUrlBytes = 1024;
+    class Block
+    {
+    public:
+        Block();
+    public:
+        TUint64 iIndex;
+        TBool iValid;
+        Bws<kBlockBytes> iData;
+    };
+    class BlockWriter : public IWriter, private INonCopyable
+    {
+    public:
+        BlockWriter(std::vector<Block*>& aBlocks);
+        TUint64 Bytes() const;
+    public: // from IWriter
+        void Write(TByte aValue) override;
+        void Write(const Brx& aBuffer) override;
+        void WriteFlush() override;
+    private:
+        std::vector<Block*>& iBlocks;
+        TUint iIndex;
+        TUint64 iBytes;
+    };
+public:
+    UrlBlockCache(IUrlBlockWriter& aUpstream);
+    UrlBlockCache(IUrlBlockWriter& aUpstream, IInfoAggregator& aInfoAggregator);
+    ~UrlBlockCache();
+    void GetStats(TUint64& aRequests, TUint64& aHits, TUint64& aFetches, TUint64& aFetchedBytes) const;
+public: // from IUrlBlockWriter
+    TBool TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes) override;
+private:
+    Block* Find(TUint64 aIndex);
+    TBool Covers(const Block* aBlock, TUint64 aOffset, TUint aBytes) const;
+    void Use(Block* aBlock);
+    void Fetch(TUint64 aIndex, TUint aCount);
+    TBool TryWrite(IWriter& aWriter, TUint64 aOffset, TUint aBytes);
+    TBool FetchUncached(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes);
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
+private:
+    IUrlBlockWriter& iUpstream;
+    Mutex iLock;
+    Bws<kMaxUrlBytes> iUrl;
+    std::list<Block*> iBlocks; // least recently used first
+    std::atomic<TUint64> iRequests;
+    std::atomic<TUint64> iHits;
+    std::atomic<TUint64> iFetches;
+    std::atomic<TUint64> iFetchedBytes;
+    std::atomic<TUint64> iEvictions;
+};
+
+} // namespace Media
+} // namespace OpenHome
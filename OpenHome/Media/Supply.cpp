@@ -86,6 +86,12 @@ void Supply::OutputMetadata(const Brx& aMetadata)
     iDownStreamElement.Push(msg);
 }
 
+void Supply::OutputBitRate(TUint aBitRate)
+{
+    MsgBitRate* msg = iMsgFactory.CreateMsgBitRate(aBitRate);
+    iDownStreamElement.Push(msg);
+}
+
 void Supply::OutputHalt(TUint aHaltId)
 {
     MsgHalt* msg = iMsgFactory.CreateMsgHalt(aHaltId);
@@ -32,6 +32,12 @@ public: // from ISupply
     void OutputHalt(TUint aHaltId = MsgHalt::kIdNone) override;
     void OutputFlush(TUint aFlushId) override;
     void OutputWait() override;
+public:
+    /*
+     * Report a change in the bit rate of the encoded stream (e.g. a protocol switching
+     * between alternative encodings of the same stream).
+     */
+    void OutputBitRate(TUint aBitRate);
 private:
     MsgFactory& iMsgFactory;
     IPipelineElementDownstream& iDownStreamElement;
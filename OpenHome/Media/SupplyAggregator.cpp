@@ -5,6 +5,8 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/ClockPuller.h>
 
+#include <string.h>
+
 using namespace OpenHome;
 using namespace OpenHome::Media;
 
@@ -102,7 +104,12 @@ void SupplyAggregator::Output(Msg* aMsg)
 
 void SupplyAggregator::OutputEncodedAudio()
 {
-    iDownStreamElement.Push(iAudioEncoded);
+    if (iAudioEncoded->Bytes() == 0) { // WriteBuffer() was called but nothing was read into it
+        iAudioEncoded->RemoveRef();
+    }
+    else {
+        iDownStreamElement.Push(iAudioEncoded);
+    }
     iAudioEncoded = nullptr;
 }
 
@@ -121,6 +128,26 @@ void SupplyAggregatorBytes::SetMaxBytes(TUint aMaxBytes)
     iDataMaxBytes = aMaxBytes;
 }
 
+TByte* SupplyAggregatorBytes::WriteBuffer(TUint& aBytes)
+{
+    TUint space = 0;
+    TByte* ptr = nullptr;
+    if (iAudioEncoded != nullptr) {
+        ptr = iAudioEncoded->AppendSpace(iDataMaxBytes, space);
+        if (space == 0) {
+            OutputEncodedAudio();
+        }
+    }
+    if (iAudioEncoded == nullptr) {
+        iAudioEncoded = iMsgFactory.CreateMsgAudioEncoded(Brx::Empty());
+        ptr = iAudioEncoded->AppendSpace(iDataMaxBytes, space);
+    }
+    if (aBytes > space) {
+        aBytes = space;
+    }
+    return ptr;
+}
+
 void SupplyAggregatorBytes::OutputStream(const Brx& aUri, TUint64 aTotalBytes, TUint64 aStartPos, TBool aSeekable, TBool aLive, Media::Multiroom aMultiroom, IStreamHandler& aStreamHandler, TUint aStreamId)
 {
     // FIXME - no metatext available
@@ -147,6 +174,18 @@ void SupplyAggregatorBytes::OutputData(const Brx& aData)
     if (aData.Bytes() == 0) {
         return;
     }
+    if (iAudioEncoded != nullptr) {
+        TUint space = 0;
+        TByte* ptr = iAudioEncoded->AppendSpace(iDataMaxBytes, space);
+        if (aData.Ptr() >= ptr && aData.Ptr() + aData.Bytes() <= ptr + space) {
+            // data was read into space from WriteBuffer().  Readers that strip headers may have moved its start
+            if (aData.Ptr() != ptr) {
+                (void)memmove(ptr, aData.Ptr(), aData.Bytes());
+            }
+            iAudioEncoded->AppendInPlace(aData.Bytes());
+            return;
+        }
+    }
     if (iAudioEncoded == nullptr) {
         iAudioEncoded = iMsgFactory.CreateMsgAudioEncoded(aData);
     }
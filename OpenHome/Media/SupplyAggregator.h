@@ -8,6 +8,20 @@
 namespace OpenHome {
 namespace Media {
 
+/*
+ * Allows a reader to receive audio directly into the EncodedAudio that a supply is filling.
+ *
+ * WriteBuffer() returns space for up to aBytes (updated to the space available) of data.
+ * Data written there is only added to the stream when a buffer pointing to it (or to a
+ * subset of it) is passed to OutputData().  Any other call to the supply invalidates the space.
+ */
+class ISupplyBuffer
+{
+public:
+    virtual ~ISupplyBuffer() {}
+    virtual TByte* WriteBuffer(TUint& aBytes) = 0;
+};
+
 class SupplyAggregator : public ISupply, private INonCopyable
 {
 public:
@@ -35,11 +49,13 @@ private:
     IPipelineElementDownstream& iDownStreamElement;
 };
 
-class SupplyAggregatorBytes : public SupplyAggregator
+class SupplyAggregatorBytes : public SupplyAggregator, public ISupplyBuffer
 {
 public:
     SupplyAggregatorBytes(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownStreamElement);
     void SetMaxBytes(TUint aMaxBytes);
+public: // from ISupplyBuffer
+    TByte* WriteBuffer(TUint& aBytes) override;
 public: // from ISupply
     void OutputStream(const Brx& aUri, TUint64 aTotalBytes, TUint64 aStartPos, TBool aSeekable, TBool aLive, Media::Multiroom aMultiroom, IStreamHandler& aStreamHandler, TUint aStreamId) override;
     void OutputPcmStream(const Brx& aUri, TUint64 aTotalBytes, TBool aSeekable, TBool aLive, Media::Multiroom aMultiroom, IStreamHandler& aStreamHandler, TUint aStreamId, const PcmStreamInfo& aPcmStream) override;
@@ -8,6 +8,8 @@
 #include <OpenHome/Media/Utils/ProcessorAudioUtils.h>
 #include <OpenHome/Media/ClockPuller.h>
 #include <OpenHome/Functor.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Net/Private/Globals.h>
 
 #include <string.h>
 #include <vector>
@@ -257,6 +259,7 @@ private: // from IFlushIdProvider
 private:
     void Queue(Msg* aMsg);
     void PullNext(EMsgType aExpectedMsg);
+    void PullBatchNext(TUint aMaxJiffies, TUint aExpectedCount, EMsgType aExpectedMsg);
     Msg* CreateMode(const Brx& aMode, TBool aSupportsLatency);
     Msg* CreateTrack();
     Msg* CreateDecodedStream();
@@ -267,6 +270,10 @@ private:
     void TestGorgingEndsWithNewMode();
     void TestHaltEnablesGorging();
     void TestStarvationEnablesGorging();
+    void TestDecodeAheadExtendsCapacity();
+    void TestDecodeAheadWithdrawnBySeek();
+    void TestPullBatchGroupsAudio();
+    void TestPullBatchReturnsControlMsgsAlone();
 private:
     Mutex iLock;
     AllocatorInfoLogger iInfoAggregator;
@@ -280,6 +287,30 @@ private:
     TUint iStarvationNotifications;
 };
 
+class SuiteReservoirContention : public Suite, private IFlushIdProvider
+{
+    static const TUint kSampleRate = 44100;
+    static const TUint kNumChannels = 2;
+    static const TUint kBitDepth = 16;
+    static const TUint kSamplesPerMsg = 4; // tiny msgs so queue overhead dominates
+    static const TUint kReservoirMsgs = 32;
+    static const TUint kMsgCount = 200000;
+public:
+    SuiteReservoirContention();
+    ~SuiteReservoirContention();
+    void Test() override;
+private: // from IFlushIdProvider
+    TUint NextFlushId() override;
+private:
+    void Run(ReservoirQueue aQueue, const TChar* aName);
+    void PushThread();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    DecodedAudioReservoir* iReservoir;
+    TByte iAudioData[kSamplesPerMsg * kNumChannels * (kBitDepth / 8)];
+};
+
 } // namespace Media
 } // namespace OpenHome
 
@@ -307,7 +338,7 @@ SuiteAudioReservoir::SuiteAudioReservoir()
     init.SetMsgEncodedStreamCount(2);
     iMsgFactory = new MsgFactory(iInfoAggregator, init);
     iTrackFactory = new TrackFactory(iInfoAggregator, 1);
-    iReservoir = new DecodedAudioReservoir(*iMsgFactory, *this, kReservoirSize, kMaxStreams, 0);
+    iReservoir = new DecodedAudioReservoir(*iMsgFactory, *this, kReservoirSize, kMaxStreams, 0, 0, ReservoirQueue::Locked);
     iNextFlushId = MsgFlush::kIdInvalid;
     iThread = new ThreadFunctor("TEST", MakeFunctor(*this, &SuiteAudioReservoir::MsgEnqueueThread));
     iThread->Start();
@@ -696,7 +727,7 @@ void SuiteEncodedReservoir::Setup()
     init.SetMsgModeCount(2);
     iMsgFactory = new MsgFactory(iInfoAggregator, init);
     iTrackFactory = new TrackFactory(iInfoAggregator, 1);
-    iReservoir = new EncodedAudioReservoir(*iMsgFactory, *this, 100/*max_msg*/, 10/*max_streams*/);
+    iReservoir = new EncodedAudioReservoir(*iMsgFactory, *this, 100/*max_msg*/, 10/*max_streams*/, ReservoirQueue::Locked);
     iNextFlushId = MsgFlush::kIdInvalid;
     iLastMsg = ENone;
     iOkToPlayCount = iTrySeekCount = iTryStopCount = iNotifyStarvingCount = 0;
@@ -928,6 +959,10 @@ SuiteGorger::SuiteGorger()
     AddTest(MakeFunctor(*this, &SuiteGorger::TestGorgingEndsWithNewMode), "TestGorgingEndsWithNewMode");
     AddTest(MakeFunctor(*this, &SuiteGorger::TestHaltEnablesGorging), "TestHaltEnablesGorging");
     AddTest(MakeFunctor(*this, &SuiteGorger::TestStarvationEnablesGorging), "TestStarvationEnablesGorging");
+    AddTest(MakeFunctor(*this, &SuiteGorger::TestDecodeAheadExtendsCapacity), "TestDecodeAheadExtendsCapacity");
+    AddTest(MakeFunctor(*this, &SuiteGorger::TestDecodeAheadWithdrawnBySeek), "TestDecodeAheadWithdrawnBySeek");
+    AddTest(MakeFunctor(*this, &SuiteGorger::TestPullBatchGroupsAudio), "TestPullBatchGroupsAudio");
+    AddTest(MakeFunctor(*this, &SuiteGorger::TestPullBatchReturnsControlMsgsAlone), "TestPullBatchReturnsControlMsgsAlone");
 }
 
 SuiteGorger::~SuiteGorger()
@@ -947,7 +982,7 @@ void SuiteGorger::Setup()
     init.SetMsgFlushCount(2);
     init.SetMsgModeCount(3);
     iMsgFactory = new MsgFactory(iInfoAggregator, init);
-    iDecodedReservoir = new DecodedAudioReservoir(*iMsgFactory, *this, kGorgeSize * 3, 10, kGorgeSize);
+    iDecodedReservoir = new DecodedAudioReservoir(*iMsgFactory, *this, kGorgeSize * 3, 10, kGorgeSize, kGorgeSize, ReservoirQueue::Locked);
     iNextFlushId = MsgFlush::kIdInvalid;
     iLastPulledMsg = ENone;
     iTrackOffset = 0;
@@ -1125,6 +1160,19 @@ void SuiteGorger::PullNext(EMsgType aExpectedMsg)
     TEST(iLastPulledMsg == aExpectedMsg);
 }
 
+void SuiteGorger::PullBatchNext(TUint aMaxJiffies, TUint aExpectedCount, EMsgType aExpectedMsg)
+{
+    MsgQueueLite batch;
+    iDecodedReservoir->PullBatch(batch, aMaxJiffies);
+    TEST(batch.NumMsgs() == aExpectedCount);
+    while (!batch.IsEmpty()) {
+        iLastPulledMsg = ENone;
+        Msg* msg = batch.Dequeue()->Process(*this);
+        msg->RemoveRef();
+        TEST(iLastPulledMsg == aExpectedMsg);
+    }
+}
+
 Msg* SuiteGorger::CreateMode(const Brx& aMode, TBool aSupportsLatency)
 {
     ModeInfo info;
@@ -1346,7 +1394,187 @@ void SuiteGorger::TestStarvationEnablesGorging()
     PullNext(EMsgQuit);
 }
 
+void SuiteGorger::TestDecodeAheadExtendsCapacity()
+{
+    Queue(CreateMode(kModeRealTime, true));
+    Queue(CreateTrack());
+    Queue(CreateDecodedStream());
+    PullNext(EMsgMode);
+    PullNext(EMsgTrack);
+    PullNext(EMsgDecodedStream);
+
+    TUint numAudioMsgs = 0;
+    while (!iDecodedReservoir->IsFull()) {
+        Queue(CreateAudio());
+        numAudioMsgs++;
+    }
+    TEST(!iDecodedReservoir->iDecodeAhead.load());
+
+    // end of current stream is near - reservoir accepts the head of the next stream
+    iDecodedReservoir->NotifyStreamEnding(iNextStreamId);
+    TEST(iDecodedReservoir->iDecodeAhead.load());
+    TEST(!iDecodedReservoir->IsFull());
+    iNextStreamId++;
+    iTrackOffset = 0;
+    Queue(CreateDecodedStream());
+    TUint numNextAudioMsgs = 0;
+    while (!iDecodedReservoir->IsFull()) {
+        Queue(CreateAudio());
+        numNextAudioMsgs++;
+    }
+    TEST(iDecodedReservoir->SizeInJiffies() > kGorgeSize * 4);
+
+    do {
+        PullNext(EMsgAudioPcm);
+    } while (--numAudioMsgs > 0);
+    TEST(iDecodedReservoir->iDecodeAhead.load());
+    PullNext(EMsgDecodedStream);
+    TEST(!iDecodedReservoir->iDecodeAhead.load());
+    do {
+        PullNext(EMsgAudioPcm);
+    } while (--numNextAudioMsgs > 0);
+
+    Queue(iMsgFactory->CreateMsgQuit());
+    PullNext(EMsgQuit);
+}
+
+void SuiteGorger::TestDecodeAheadWithdrawnBySeek()
+{
+    Queue(CreateMode(kModeRealTime, true));
+    Queue(CreateTrack());
+    Queue(CreateDecodedStream());
+    PullNext(EMsgMode);
+    PullNext(EMsgTrack);
+    PullNext(EMsgDecodedStream);
+
+    const TUint streamId = iNextStreamId;
+    iDecodedReservoir->NotifyStreamEnding(streamId);
+    TEST(iDecodedReservoir->iDecodeAhead.load());
+    iDecodedReservoir->NotifyStreamSeek(streamId + 1);
+    TEST(iDecodedReservoir->iDecodeAhead.load());
+    iDecodedReservoir->NotifyStreamSeek(streamId);
+    TEST(!iDecodedReservoir->iDecodeAhead.load());
+    iDecodedReservoir->NotifyStreamEnding(streamId);
+    TEST(iDecodedReservoir->iDecodeAhead.load());
+
+    Queue(iMsgFactory->CreateMsgQuit());
+    PullNext(EMsgQuit);
+}
+
+
+
+void SuiteGorger::TestPullBatchGroupsAudio()
+{
+    Queue(CreateMode(kModeRealTime, true));
+    Queue(CreateTrack());
+    Queue(CreateDecodedStream());
+    Queue(CreateAudio());
+    const TUint audioJiffies = (TUint)iTrackOffset;
+    Queue(CreateAudio());
+    Queue(CreateAudio());
+    Queue(CreateAudio());
+    Queue(CreateAudio());
+    Queue(iMsgFactory->CreateMsgHalt());
+    PullNext(EMsgMode);
+    PullNext(EMsgTrack);
+    PullNext(EMsgDecodedStream);
+
+    PullBatchNext(2 * audioJiffies, 2, EMsgAudioPcm);
+    PullBatchNext(1, 1, EMsgAudioPcm); // first audio msg is returned even if it exceeds aMaxJiffies
+    PullBatchNext(100 * audioJiffies, 2, EMsgAudioPcm); // batch stops before the halt
+    PullBatchNext(100 * audioJiffies, 1, EMsgHalt);
+    TEST(iDecodedReservoir->SizeInJiffies() == 0);
+}
+
+void SuiteGorger::TestPullBatchReturnsControlMsgsAlone()
+{
+    Queue(CreateMode(kModeRealTime, true));
+    Queue(CreateTrack());
+    Queue(CreateDecodedStream());
+    Queue(iMsgFactory->CreateMsgMetaText(Brx::Empty()));
+    Queue(CreateAudio());
+
+    PullBatchNext(kGorgeSize, 1, EMsgMode);
+    PullBatchNext(kGorgeSize, 1, EMsgTrack);
+    PullBatchNext(kGorgeSize, 1, EMsgDecodedStream);
+    PullBatchNext(kGorgeSize, 1, EMsgMetaText);
+    PullBatchNext(kGorgeSize, 1, EMsgAudioPcm);
+}
+
+// SuiteReservoirContention
+
+SuiteReservoirContention::SuiteReservoirContention()
+    : Suite("Reservoir push/pull contention")
+    , iReservoir(nullptr)
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioPcmCount(kReservoirMsgs * 2, kReservoirMsgs * 2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    (void)memset(iAudioData, 0x7f, sizeof iAudioData);
+}
 
+SuiteReservoirContention::~SuiteReservoirContention()
+{
+    delete iMsgFactory;
+}
+
+void SuiteReservoirContention::Test()
+{
+    Run(ReservoirQueue::Locked, "Locked");
+    Run(ReservoirQueue::LockFree, "LockFree");
+}
+
+TUint SuiteReservoirContention::NextFlushId()
+{
+    return MsgFlush::kIdInvalid;
+}
+
+void SuiteReservoirContention::Run(ReservoirQueue aQueue, const TChar* aName)
+{
+    const TUint msgJiffies = kSamplesPerMsg * Jiffies::PerSample(kSampleRate);
+    iReservoir = new DecodedAudioReservoir(*iMsgFactory, *this, kReservoirMsgs * msgJiffies, 10, 0, 0, aQueue);
+    ThreadFunctor* pusher = new ThreadFunctor("CONT", MakeFunctor(*this, &SuiteReservoirContention::PushThread));
+
+    const TUint64 start = Os::TimeInUs(gEnv->OsCtx());
+    pusher->Start();
+    TUint64 expectedOffset = 0;
+    TUint count = 0;
+    TBool inOrder = true;
+    for (;;) {
+        Msg* msg = iReservoir->Pull();
+        if (!msg->IsAudioPcm()) {
+            msg->RemoveRef();
+            break; // MsgQuit
+        }
+        auto audio = static_cast<MsgAudioPcm*>(msg);
+        inOrder = inOrder && (audio->TrackOffset() == expectedOffset);
+        expectedOffset += audio->Jiffies();
+        count++;
+        msg->RemoveRef();
+    }
+    const TUint64 durationUs = Os::TimeInUs(gEnv->OsCtx()) - start;
+    TEST(inOrder);
+    TEST(count == kMsgCount);
+    TEST(iReservoir->SizeInJiffies() == 0);
+    Print("%8s: %u msgs in %llums (%llu msgs/ms)\n", aName, count, durationUs / 1000,
+          (TUint64)count * 1000 / (durationUs == 0? 1 : durationUs));
+
+    delete pusher;
+    delete iReservoir;
+    iReservoir = nullptr;
+}
+
+void SuiteReservoirContention::PushThread()
+{
+    Brn audioBuf(iAudioData, sizeof iAudioData);
+    TUint64 trackOffset = 0;
+    for (TUint i=0; i<kMsgCount; i++) {
+        auto audio = iMsgFactory->CreateMsgAudioPcm(audioBuf, kNumChannels, kSampleRate, kBitDepth, AudioDataEndian::Little, trackOffset);
+        trackOffset += audio->Jiffies();
+        iReservoir->Push(audio);
+    }
+    iReservoir->Push(iMsgFactory->CreateMsgQuit());
+}
 
 void TestAudioReservoir()
 {
@@ -1354,5 +1582,6 @@ void TestAudioReservoir()
     runner.Add(new SuiteAudioReservoir());
     runner.Add(new SuiteEncodedReservoir());
     runner.Add(new SuiteGorger());
+    runner.Add(new SuiteReservoirContention());
     runner.Run();
 }
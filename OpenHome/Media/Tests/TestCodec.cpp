@@ -194,6 +194,7 @@ TestCodecFiller::TestCodecFiller(Environment& aEnv, IPipelineElementDownstream&
     iProtocolManager = new ProtocolManager(aDownstream, aMsgFactory, *this, aFlushIdProvider);
     iProtocolManager->Add(ProtocolFactory::NewHttp(aEnv, *iSsl, Brx::Empty()));
     iProtocolManager->Add(ProtocolFactory::NewHttp(aEnv, *iSsl, Brx::Empty()));    // Second ProtocolHttp to allow out-of-band reads.
+    iProtocolManager->Add(ProtocolFactory::NewFile(aEnv));
     iTrackFactory = new TrackFactory(aInfoAggregator, 1);
 }
 
@@ -277,7 +278,7 @@ TestCodecMinimalPipeline::TestCodecMinimalPipeline(Environment& aEnv, IMsgProces
     // iFiller(ProtocolManager) -> iSupply -> iReservoir -> iContainer -> iController -> iElementDownstream(this)
     iFlushIdProvider = new TestCodecFlushIdProvider();
     iElementDownstream = new TestCodecPipelineElementDownstream(aMsgProcessor);
-    iReservoir = new EncodedAudioReservoir(*iMsgFactory, *iFlushIdProvider, kReservoirEncodedAudioMsgs, kEncodedReservoirMaxStreams);
+    iReservoir = new EncodedAudioReservoir(*iMsgFactory, *iFlushIdProvider, kReservoirEncodedAudioMsgs, kEncodedReservoirMaxStreams, ReservoirQueue::Locked);
     iLoggerEncodedAudioReservoir = new Logger(*iReservoir, "Encoded Audio Reservoir");
     iContainer = new ContainerController(*iMsgFactory, *iLoggerEncodedAudioReservoir, *this, true);
     iLoggerContainer = new Logger(*iContainer, "Codec Container");
@@ -1042,6 +1043,90 @@ void SuiteCodecInvalidType::TestInvalidType()
 }
 
 
+// SuiteCodecThroughput
+
+SuiteCodecThroughput::SuiteCodecThroughput(std::vector<AudioFileDescriptor>& aFiles, Environment& aEnv, CreateTestCodecPipelineFunc aFunc, const Uri& aUri)
+    : SuiteCodecStream("Codec throughput tests", aFiles, aEnv, aFunc, aUri)
+{
+    for (TUint i=0; i<kNumCodecs; i++) {
+        iCodecSamples[i] = 0;
+        iCodecDurationUs[i] = 0;
+    }
+    for (auto it = iFiles.begin(); it != iFiles.end(); ++it) {
+        AddTest(MakeFunctor(*this, &SuiteCodecThroughput::TestThroughput));
+    }
+}
+
+SuiteCodecThroughput::~SuiteCodecThroughput()
+{
+}
+
+void SuiteCodecThroughput::TestThroughput()
+{
+    const AudioFileDescriptor& file = iFiles[iFileNum];
+    iFileNum++;
+
+    const TUint64 start = Os::TimeInUs(iEnv.OsCtx());
+    Brx* fileLocation = StartStreaming(Brn("SuiteCodecThroughput"), file.Filename());
+    iSem.Wait();
+    const TUint64 durationUs = Os::TimeInUs(iEnv.OsCtx()) - start;
+    delete fileLocation;
+
+    TEST(iJiffies == file.Jiffies());
+    const TUint64 samples = Jiffies::ToSamples(iJiffies, file.SampleRate());
+    const TUint64 us = (durationUs == 0? 1 : durationUs);
+    Log::Print("%s: %llu samples in %llums, %llu samples/s (%llux realtime)\n",
+               CodecName(file.Codec()), samples, durationUs / 1000, (samples * 1000000) / us,
+               (samples * 1000000) / (us * file.SampleRate()));
+
+    ASSERT(file.Codec() < kNumCodecs);
+    iCodecSamples[file.Codec()] += samples;
+    iCodecDurationUs[file.Codec()] += durationUs;
+    if (iFileNum == iFiles.size()) {
+        Report();
+    }
+}
+
+void SuiteCodecThroughput::Report()
+{
+    Log::Print("Decode throughput by codec:\n");
+    for (TUint i=0; i<kNumCodecs; i++) {
+        if (iCodecSamples[i] == 0) {
+            continue;
+        }
+        const TUint64 us = (iCodecDurationUs[i] == 0? 1 : iCodecDurationUs[i]);
+        Log::Print("    %-6s %llu samples/s\n", CodecName(i), (iCodecSamples[i] * 1000000) / us);
+    }
+}
+
+const TChar* SuiteCodecThroughput::CodecName(TUint aCodec)
+{ // static
+    switch (aCodec)
+    {
+    case AudioFileDescriptor::kCodecWav:
+        return "WAV";
+    case AudioFileDescriptor::kCodecFlac:
+        return "FLAC";
+    case AudioFileDescriptor::kCodecAlac:
+        return "ALAC";
+    case AudioFileDescriptor::kCodecAac:
+        return "AAC";
+    case AudioFileDescriptor::kCodecVorbis:
+        return "Vorbis";
+    case AudioFileDescriptor::kCodecAiff:
+        return "AIFF";
+    case AudioFileDescriptor::kCodecAifc:
+        return "AIFC";
+    case AudioFileDescriptor::kCodecAdts:
+        return "ADTS";
+    case AudioFileDescriptor::kCodecMp3:
+        return "MP3";
+    default:
+        return "Unknown";
+    }
+}
+
+
 void TestCodec(Environment& aEnv, CreateTestCodecPipelineFunc aFunc, GetTestFiles aFileFunc, const std::vector<Brn>& aArgs)
 {
     Log::Print("TestCodec\n");
@@ -1053,7 +1138,7 @@ void TestCodec(Environment& aEnv, CreateTestCodecPipelineFunc aFunc, GetTestFile
     parser.AddOption(&optionPort);
     OptionString optionPath("", "--path", Brn(""), "path to use on server");
     parser.AddOption(&optionPath);
-    OptionString optionTestType("-t", "--type", Brn("full"), "type of test (quick | full)");
+    OptionString optionTestType("-t", "--type", Brn("full"), "type of test (quick | full | throughput)");
     parser.AddOption(&optionTestType);
     if (!parser.Parse(aArgs) || parser.HelpDisplayed()) {
         return;
@@ -1098,9 +1183,13 @@ void TestCodec(Environment& aEnv, CreateTestCodecPipelineFunc aFunc, GetTestFile
 
     // set test type
     TBool testFull = true;
+    TBool testThroughput = false;
     if (optionTestType.Value() == Brn("quick")) {
         testFull = false;
     }
+    else if (optionTestType.Value() == Brn("throughput")) {
+        testThroughput = true;
+    }
 
     // set up bare minimum files (and include extra files if full test being run)
     AudioFileCollection* files = (*aFileFunc)();
@@ -1112,6 +1201,12 @@ void TestCodec(Environment& aEnv, CreateTestCodecPipelineFunc aFunc, GetTestFile
     }
 
     Runner runner("Codec tests\n");
+    if (testThroughput) {
+        runner.Add(new SuiteCodecThroughput(stdFiles, aEnv, aFunc, uri));
+        runner.Run();
+        delete files;
+        return;
+    }
     runner.Add(new SuiteCodecZeroCrossings(stdFiles, aEnv, aFunc, uri));
     if (testFull) {
         //runner.Add(new SuiteCodecStream(stdFiles, aEnv, aFunc, uri));    // now done as part of SuiteCodecZeroCrossings to speed things up
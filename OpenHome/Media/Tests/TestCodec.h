@@ -327,6 +327,26 @@ private:
     void TestInvalidType();
 };
 
+/*
+ * Reports decode throughput (samples/s) for each file and a total for each codec.
+ * Timing includes fetching the (local) file so serve test files from the same machine.
+ */
+class SuiteCodecThroughput : public SuiteCodecStream
+{
+private:
+    static const TUint kNumCodecs = AudioFileDescriptor::kCodecMp3 + 1;
+public:
+    SuiteCodecThroughput(std::vector<AudioFileDescriptor>& aFiles, Environment& aEnv, CreateTestCodecPipelineFunc aFunc, const Uri& aUri);
+private:
+    ~SuiteCodecThroughput();
+    void TestThroughput();
+    void Report();
+    static const TChar* CodecName(TUint aCodec);
+private:
+    TUint64 iCodecSamples[kNumCodecs];
+    TUint64 iCodecDurationUs[kNumCodecs];
+};
+
 } // namespace Codec
 } // namespace Media
 } // namespace OpenHome
@@ -0,0 +1,643 @@
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Json.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/File.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Tests/TestCodec.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Pipeline/EncodedAudioReservoir.h>
+#include <OpenHome/Media/Codec/CodecController.h>
+#include <OpenHome/Media/Codec/CodecFactory.h>
+#include <OpenHome/Media/Codec/Container.h>
+#include <OpenHome/Media/Codec/Id3v2.h>
+#include <OpenHome/Media/Codec/Mpeg4.h>
+#include <OpenHome/Media/Codec/MpegTs.h>
+#include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+
+#include <ctime>
+#include <vector>
+
+/*
+ * Decode throughput benchmark.
+ *
+ * Decodes each file in a corpus (the TestCodec files by default) using every codec and container that
+ * TestCodec registers, then writes a JSON report containing wall time, process CPU time, decoded
+ * samples/s, allocator high-water marks and msg counts at the output of each pipeline element.
+ *
+ * Files are read using the file protocol unless --path is an http:// uri.
+ */
+
+namespace OpenHome {
+namespace Media {
+namespace Codec {
+
+class MsgCounter : private IMsgProcessor, private INonCopyable
+{
+public:
+    MsgCounter();
+    void Reset();
+    void Count(Msg* aMsg);
+    void WriteJson(WriterJsonObject& aWriter, const TChar* aKey) const;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgDelay* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgStreamSegment* aMsg) override;
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgMetaText* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgWait* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgBitRate* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgAudioDsd* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private:
+    enum EMsgType
+    {
+        EMsgMode
+       ,EMsgTrack
+       ,EMsgDrain
+       ,EMsgDelay
+       ,EMsgEncodedStream
+       ,EMsgStreamSegment
+       ,EMsgAudioEncoded
+       ,EMsgMetaText
+       ,EMsgStreamInterrupted
+       ,EMsgHalt
+       ,EMsgFlush
+       ,EMsgWait
+       ,EMsgDecodedStream
+       ,EMsgBitRate
+       ,EMsgAudioPcm
+       ,EMsgAudioDsd
+       ,EMsgSilence
+       ,EMsgPlayable
+       ,EMsgQuit
+       ,EMsgTypeCount
+    };
+    static const TChar* kMsgNames[EMsgTypeCount];
+private:
+    Msg* Count(EMsgType aType, Msg* aMsg);
+private:
+    TUint iCounts[EMsgTypeCount];
+};
+
+class ElementMsgCounter : public IPipelineElementUpstream, private INonCopyable
+{
+public:
+    ElementMsgCounter(IPipelineElementUpstream& aUpstream, MsgCounter& aCounter);
+public: // from IPipelineElementUpstream
+    Msg* Pull() override;
+private:
+    IPipelineElementUpstream& iUpstream;
+    MsgCounter& iCounter;
+};
+
+class BenchmarkSink : public IPipelineElementDownstream, private IMsgProcessor, private INonCopyable
+{
+public:
+    BenchmarkSink(Semaphore& aSemQuit);
+    void Reset();
+    TUint64 Samples() const;
+    const MsgCounter& Counter() const;
+    const Brx& CodecName() const;
+    TUint SampleRate() const;
+    TUint BitDepth() const;
+    TUint Channels() const;
+public: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgDelay* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgStreamSegment* aMsg) override;
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgMetaText* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgWait* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgBitRate* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgAudioDsd* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private:
+    Semaphore& iSemQuit;
+    MsgCounter iCounter;
+    TUint64 iJiffies;
+    BwsCodecName iCodecName;
+    TUint iSampleRate;
+    TUint iBitDepth;
+    TUint iChannels;
+};
+
+class BenchmarkPipeline : private IUrlBlockWriter, private IMimeTypeList, private INonCopyable
+{
+    static const TUint kEncodedAudioCount = 100;
+    static const TUint kMsgAudioEncodedCount = 100;
+    static const TUint kDecodedAudioCount = 5;
+    static const TUint kMsgAudioPcmCount = 5;
+    static const TUint kReservoirEncodedAudioMsgs = 50;
+    static const TUint kEncodedReservoirMaxStreams = 10;
+public:
+    BenchmarkPipeline(Environment& aEnv, BenchmarkSink& aSink);
+    ~BenchmarkPipeline();
+    void Start(const Brx& aUrl);
+    void WriteJson(WriterJsonObject& aWriter);
+private: // from IUrlBlockWriter
+    TBool TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes) override;
+private: // from IMimeTypeList
+    void Add(const TChar* aMimeType) override;
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    TestCodecFlushIdProvider iFlushIdProvider;
+    EncodedAudioReservoir* iReservoir;
+    MsgCounter iCounterReservoir;
+    ElementMsgCounter* iElementCounterReservoir;
+    ContainerController* iContainer;
+    MsgCounter iCounterContainer;
+    ElementMsgCounter* iElementCounterContainer;
+    CodecController* iController;
+    TestCodecFiller* iFiller;
+};
+
+class CodecBenchmark : private INonCopyable
+{
+public:
+    CodecBenchmark(Environment& aEnv, const Brx& aPath, TUint aIterations);
+    void Run(const Brx& aFilename, WriterJsonArray& aWriter);
+private:
+    Environment& iEnv;
+    Brn iPath;
+    const TUint iIterations;
+    Semaphore iSemQuit;
+    BenchmarkSink iSink;
+};
+
+} // namespace Codec
+} // namespace Media
+} // namespace OpenHome
+
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+using namespace OpenHome::TestFramework;
+
+
+// MsgCounter
+
+const TChar* MsgCounter::kMsgNames[EMsgTypeCount] = {
+    "Mode", "Track", "Drain", "Delay", "EncodedStream", "StreamSegment", "AudioEncoded", "MetaText",
+    "StreamInterrupted", "Halt", "Flush", "Wait", "DecodedStream", "BitRate", "AudioPcm", "AudioDsd",
+    "Silence", "Playable", "Quit"
+};
+
+MsgCounter::MsgCounter()
+{
+    Reset();
+}
+
+void MsgCounter::Reset()
+{
+    for (TUint i=0; i<EMsgTypeCount; i++) {
+        iCounts[i] = 0;
+    }
+}
+
+void MsgCounter::Count(Msg* aMsg)
+{
+    (void)aMsg->Process(*this);
+}
+
+void MsgCounter::WriteJson(WriterJsonObject& aWriter, const TChar* aKey) const
+{
+    auto writer = aWriter.CreateObject(aKey);
+    for (TUint i=0; i<EMsgTypeCount; i++) {
+        if (iCounts[i] > 0) {
+            writer.WriteUint(kMsgNames[i], iCounts[i]);
+        }
+    }
+    writer.WriteEnd();
+}
+
+Msg* MsgCounter::Count(EMsgType aType, Msg* aMsg)
+{
+    iCounts[aType]++;
+    return aMsg;
+}
+
+Msg* MsgCounter::ProcessMsg(MsgMode* aMsg)              { return Count(EMsgMode, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgTrack* aMsg)             { return Count(EMsgTrack, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgDrain* aMsg)             { return Count(EMsgDrain, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgDelay* aMsg)             { return Count(EMsgDelay, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgEncodedStream* aMsg)     { return Count(EMsgEncodedStream, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgStreamSegment* aMsg)     { return Count(EMsgStreamSegment, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgAudioEncoded* aMsg)      { return Count(EMsgAudioEncoded, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgMetaText* aMsg)          { return Count(EMsgMetaText, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgStreamInterrupted* aMsg) { return Count(EMsgStreamInterrupted, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgHalt* aMsg)              { return Count(EMsgHalt, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgFlush* aMsg)             { return Count(EMsgFlush, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgWait* aMsg)              { return Count(EMsgWait, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgDecodedStream* aMsg)     { return Count(EMsgDecodedStream, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgBitRate* aMsg)           { return Count(EMsgBitRate, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgAudioPcm* aMsg)          { return Count(EMsgAudioPcm, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgAudioDsd* aMsg)          { return Count(EMsgAudioDsd, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgSilence* aMsg)           { return Count(EMsgSilence, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgPlayable* aMsg)          { return Count(EMsgPlayable, aMsg); }
+Msg* MsgCounter::ProcessMsg(MsgQuit* aMsg)              { return Count(EMsgQuit, aMsg); }
+
+
+// ElementMsgCounter
+
+ElementMsgCounter::ElementMsgCounter(IPipelineElementUpstream& aUpstream, MsgCounter& aCounter)
+    : iUpstream(aUpstream)
+    , iCounter(aCounter)
+{
+}
+
+Msg* ElementMsgCounter::Pull()
+{
+    Msg* msg = iUpstream.Pull();
+    if (msg != nullptr) {
+        iCounter.Count(msg);
+    }
+    return msg;
+}
+
+
+// BenchmarkSink
+
+BenchmarkSink::BenchmarkSink(Semaphore& aSemQuit)
+    : iSemQuit(aSemQuit)
+{
+    Reset();
+}
+
+void BenchmarkSink::Reset()
+{
+    iCounter.Reset();
+    iJiffies = 0;
+    iCodecName.Replace(Brx::Empty());
+    iSampleRate = 0;
+    iBitDepth = 0;
+    iChannels = 0;
+}
+
+TUint64 BenchmarkSink::Samples() const
+{
+    if (iSampleRate == 0) {
+        return 0;
+    }
+    return Jiffies::ToSamples(iJiffies, iSampleRate);
+}
+
+const MsgCounter& BenchmarkSink::Counter() const
+{
+    return iCounter;
+}
+
+const Brx& BenchmarkSink::CodecName() const
+{
+    return iCodecName;
+}
+
+TUint BenchmarkSink::SampleRate() const
+{
+    return iSampleRate;
+}
+
+TUint BenchmarkSink::BitDepth() const
+{
+    return iBitDepth;
+}
+
+TUint BenchmarkSink::Channels() const
+{
+    return iChannels;
+}
+
+void BenchmarkSink::Push(Msg* aMsg)
+{
+    iCounter.Count(aMsg);
+    Msg* msg = aMsg->Process(*this);
+    if (msg != nullptr) {
+        msg->RemoveRef();
+    }
+}
+
+Msg* BenchmarkSink::ProcessMsg(MsgMode* aMsg)               { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgTrack* aMsg)              { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgDrain* aMsg)              { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgDelay* aMsg)              { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgEncodedStream* aMsg)      { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgStreamSegment* aMsg)      { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgAudioEncoded* aMsg)       { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgMetaText* aMsg)           { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgStreamInterrupted* aMsg)  { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgHalt* aMsg)               { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgFlush* aMsg)              { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgWait* aMsg)               { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgBitRate* aMsg)            { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgAudioDsd* aMsg)           { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgSilence* aMsg)            { return aMsg; }
+Msg* BenchmarkSink::ProcessMsg(MsgPlayable* aMsg)           { return aMsg; }
+
+Msg* BenchmarkSink::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    const DecodedStreamInfo& info = aMsg->StreamInfo();
+    iCodecName.Replace(info.CodecName());
+    iSampleRate = info.SampleRate();
+    iBitDepth = info.BitDepth();
+    iChannels = info.NumChannels();
+    return aMsg;
+}
+
+Msg* BenchmarkSink::ProcessMsg(MsgAudioPcm* aMsg)
+{
+    iJiffies += aMsg->Jiffies();
+    return aMsg;
+}
+
+Msg* BenchmarkSink::ProcessMsg(MsgQuit* aMsg)
+{
+    aMsg->RemoveRef();
+    iSemQuit.Signal();
+    return nullptr;
+}
+
+
+// BenchmarkPipeline
+
+BenchmarkPipeline::BenchmarkPipeline(Environment& aEnv, BenchmarkSink& aSink)
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(kMsgAudioEncodedCount, kEncodedAudioCount);
+    init.SetMsgAudioPcmCount(kMsgAudioPcmCount, kDecodedAudioCount);
+    init.SetMsgEncodedStreamCount(2);
+    init.SetMsgFlushCount(2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    // iFiller(ProtocolManager) -> iReservoir -> iContainer -> iController -> aSink
+    iReservoir = new EncodedAudioReservoir(*iMsgFactory, iFlushIdProvider, kReservoirEncodedAudioMsgs, kEncodedReservoirMaxStreams, ReservoirQueue::Locked);
+    iElementCounterReservoir = new ElementMsgCounter(*iReservoir, iCounterReservoir);
+    iContainer = new ContainerController(*iMsgFactory, *iElementCounterReservoir, *this, true);
+    iElementCounterContainer = new ElementMsgCounter(*iContainer, iCounterContainer);
+    iController = new CodecController(*iMsgFactory, *iElementCounterContainer, aSink, *this, Jiffies::kPerMs * 5, kPriorityNormal, true);
+    iFiller = new TestCodecFiller(aEnv, *iReservoir, *iMsgFactory, iFlushIdProvider, iInfoAggregator);
+
+    // Same plugins as TestCodecMinimalPipeline
+    iContainer->AddContainer(new Id3v2());
+    iContainer->AddContainer(new Mpeg4Container(*this));
+    iContainer->AddContainer(new MpegTsContainer(*this));
+    iController->AddCodec(CodecFactory::NewWav(*this));
+    iController->AddCodec(CodecFactory::NewAiff(*this));
+    iController->AddCodec(CodecFactory::NewAifc(*this));
+    iController->AddCodec(CodecFactory::NewFlac(*this));
+    iController->AddCodec(CodecFactory::NewAacFdkAdts(*this));
+    iController->AddCodec(CodecFactory::NewAacFdkMp4(*this));
+    iController->AddCodec(CodecFactory::NewAlacApple(*this));
+    iController->AddCodec(CodecFactory::NewMp3(*this));
+    iController->AddCodec(CodecFactory::NewVorbis(*this));
+}
+
+BenchmarkPipeline::~BenchmarkPipeline()
+{
+    delete iFiller;
+    delete iController;
+    delete iElementCounterContainer;
+    delete iContainer;
+    delete iElementCounterReservoir;
+    delete iReservoir;
+    delete iMsgFactory;
+}
+
+void BenchmarkPipeline::Start(const Brx& aUrl)
+{
+    iController->Start();
+    iFiller->Start(aUrl);
+}
+
+void BenchmarkPipeline::WriteJson(WriterJsonObject& aWriter)
+{
+    std::vector<const AllocatorBase*> allocators;
+    iMsgFactory->GetAllocators(allocators);
+    auto writerAllocators = aWriter.CreateArray("allocators", WriterJsonArray::WriteOnEmpty::eEmptyArray);
+    for (auto allocator : allocators) {
+        TUint cellsTotal, cellBytes, cellsUsed, cellsUsedMax;
+        allocator->GetStats(cellsTotal, cellBytes, cellsUsed, cellsUsedMax);
+        auto writer = writerAllocators.CreateObject();
+        writer.WriteString("name", allocator->Name());
+        writer.WriteUint("capacity", cellsTotal);
+        writer.WriteUint("cellBytes", cellBytes);
+        writer.WriteUint("inUse", cellsUsed);
+        writer.WriteUint("peak", cellsUsedMax);
+        writer.WriteUint64("peakBytes", (TUint64)cellsUsedMax * cellBytes);
+        writer.WriteEnd();
+    }
+    writerAllocators.WriteEnd();
+    auto msgs = aWriter.CreateObject("msgs");
+    iCounterReservoir.WriteJson(msgs, "reservoir");
+    iCounterContainer.WriteJson(msgs, "container");
+    msgs.WriteEnd();
+}
+
+TBool BenchmarkPipeline::TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes)
+{
+    return iFiller->TryGet(aWriter, aUrl, aOffset, aBytes);
+}
+
+void BenchmarkPipeline::Add(const TChar* /*aMimeType*/)
+{
+}
+
+
+// CodecBenchmark
+
+CodecBenchmark::CodecBenchmark(Environment& aEnv, const Brx& aPath, TUint aIterations)
+    : iEnv(aEnv)
+    , iPath(aPath)
+    , iIterations(aIterations)
+    , iSemQuit("TCBM", 0)
+    , iSink(iSemQuit)
+{
+}
+
+void CodecBenchmark::Run(const Brx& aFilename, WriterJsonArray& aWriter)
+{
+    Log::Print("CodecBenchmark: ");
+    Log::Print(aFilename);
+    Log::Print("\n");
+
+    Bwh url(iPath.Bytes() + aFilename.Bytes() + 16);
+    if (!iPath.BeginsWith(Brn("http://"))) {
+        url.Append("file://");
+    }
+    url.Append(iPath);
+    if (iPath.Bytes() > 0 && iPath[iPath.Bytes() - 1] != '/') {
+        url.Append('/');
+    }
+    url.Append(aFilename);
+
+    auto writer = aWriter.CreateObject();
+    writer.WriteString("file", aFilename);
+    TUint64 samples = 0;
+    TUint64 wallUs = 0;
+    TUint64 cpuUs = 0;
+    for (TUint i=0; i<iIterations; i++) {
+        iSink.Reset();
+        auto pipeline = new BenchmarkPipeline(iEnv, iSink);
+        const TUint64 wallStart = Os::TimeInUs(iEnv.OsCtx());
+        const std::clock_t cpuStart = std::clock();
+        pipeline->Start(url);
+        iSemQuit.Wait();
+        cpuUs += ((TUint64)(std::clock() - cpuStart) * 1000000) / CLOCKS_PER_SEC;
+        wallUs += Os::TimeInUs(iEnv.OsCtx()) - wallStart;
+        samples += iSink.Samples();
+        if (i == iIterations - 1) {
+            // allocator high-water marks and msg counts are the same for each iteration so only report the last
+            writer.WriteString("codec", iSink.CodecName());
+            writer.WriteUint("sampleRate", iSink.SampleRate());
+            writer.WriteUint("bitDepth", iSink.BitDepth());
+            writer.WriteUint("channels", iSink.Channels());
+            pipeline->WriteJson(writer);
+            auto msgs = writer.CreateObject("msgsDecoded");
+            iSink.Counter().WriteJson(msgs, "codec");
+            msgs.WriteEnd();
+        }
+        delete pipeline;
+    }
+
+    const TUint64 us = (wallUs == 0? 1 : wallUs);
+    writer.WriteUint("iterations", iIterations);
+    writer.WriteUint64("samples", samples);
+    writer.WriteUint64("wallUs", wallUs);
+    writer.WriteUint64("cpuUs", cpuUs);
+    writer.WriteUint64("samplesPerSecond", (samples * 1000000) / us);
+    writer.WriteEnd();
+    Log::Print("    %llu samples, wall: %llums, cpu: %llums, %llu samples/s\n",
+               samples, wallUs / 1000, cpuUs / 1000, (samples * 1000000) / us);
+}
+
+
+extern AudioFileCollection* TestCodecFiles();
+
+static void ReadCorpus(const Brx& aCorpusFile, std::vector<Brh*>& aFiles)
+{
+    // One filename per line.  Blank lines and lines starting with '#' are ignored.
+    Bwh filename(aCorpusFile.Bytes() + 1);
+    filename.Replace(aCorpusFile);
+    IFile* file = new FileAnsi(filename.PtrZ(), eFileReadOnly); // throws FileOpenError
+    Bwh contents(file->Bytes());
+    file->Read(contents);
+    delete file;
+    Parser parser(contents);
+    while (!parser.Finished()) {
+        Brn line = Ascii::Trim(parser.Next('\n'));
+        if (line.Bytes() > 0 && line[0] != '#') {
+            aFiles.push_back(new Brh(line));
+        }
+    }
+}
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    OptionParser parser;
+    OptionString optionPath("-p", "--path", Brn(""), "directory (or http:// uri) containing test files");
+    parser.AddOption(&optionPath);
+    OptionString optionCorpus("-c", "--corpus", Brn(""), "file listing files to decode, one per line (default: TestCodec files)");
+    parser.AddOption(&optionCorpus);
+    OptionUint optionIterations("-n", "--iterations", 1, "number of times to decode each file");
+    parser.AddOption(&optionIterations);
+    OptionString optionOut("-o", "--out", Brn(""), "file to write JSON results to (default: stdout)");
+    parser.AddOption(&optionOut);
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        return;
+    }
+    if (optionIterations.Value() == 0) {
+        Log::Print("Error: --iterations must be at least 1\n");
+        return;
+    }
+
+    std::vector<Brh*> files;
+    if (optionCorpus.Value().Bytes() > 0) {
+        try {
+            ReadCorpus(optionCorpus.Value(), files);
+        }
+        catch (FileOpenError&) {
+            Log::Print("Error: failed to open corpus file <");
+            Log::Print(optionCorpus.Value());
+            Log::Print(">\n");
+            return;
+        }
+    }
+    else {
+        AudioFileCollection* collection = TestCodecFiles();
+        for (auto& f : collection->RequiredFiles()) {
+            files.push_back(new Brh(f.Filename()));
+        }
+        for (auto& f : collection->ExtraFiles()) {
+            files.push_back(new Brh(f.Filename()));
+        }
+        delete collection;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    WriterBwh json(4 * 1024);
+    {
+        CodecBenchmark benchmark(lib->Env(), optionPath.Value(), optionIterations.Value());
+        WriterJsonObject writer(json);
+        auto results = writer.CreateArray("files", WriterJsonArray::WriteOnEmpty::eEmptyArray);
+        for (auto file : files) {
+            benchmark.Run(*file, results);
+        }
+        results.WriteEnd();
+        writer.WriteEnd();
+    }
+    json.Write('\n');
+
+    if (optionOut.Value().Bytes() == 0) {
+        Log::Print(json.Buffer());
+    }
+    else {
+        Bwh filename(optionOut.Value().Bytes() + 1);
+        filename.Replace(optionOut.Value());
+        try {
+            IFile* file = new FileAnsi(filename.PtrZ(), eFileReadWrite);
+            file->Write(json.Buffer());
+            delete file;
+        }
+        catch (FileOpenError&) {
+            Log::Print("Error: failed to open output file <");
+            Log::Print(optionOut.Value());
+            Log::Print(">\n");
+        }
+    }
+
+    for (auto file : files) {
+        delete file;
+    }
+    delete lib;
+}
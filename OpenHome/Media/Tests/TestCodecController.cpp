@@ -10,6 +10,7 @@
 #include <OpenHome/Media/Utils/ProcessorAudioUtils.h>
 #include <OpenHome/Media/MimeTypeList.h>
 
+#include <algorithm>
 #include <list>
 #include <limits.h>
 
@@ -178,6 +179,7 @@ private:
     void TestTruncatedStream();
     void TestTrackTrack();
     void TestTrackMetatext();
+    void TestTrackBitRate();
     void TestTrackEncodedStreamMetatext();
     void TestSeek();
     void TestSeekNewStream();
@@ -289,6 +291,105 @@ private:
     TestCodecControllerDummyCodecBuffered* iCodec;
 };
 
+/*
+ * Codec that writes decoded audio directly into memory borrowed from CodecController.
+ *
+ * Each block read is written in two halves (via AppendAudioBuf()) then output as a single msg.
+ */
+class TestCodecControllerDummyCodecAudioBuf : public TestCodecControllerDummyCodec
+{
+public:
+    TestCodecControllerDummyCodecAudioBuf(TUint aReadBufBytes);
+public: // from TestCodecControllerDummyCodec
+    void Process() override;
+private:
+    void WriteAudio(const TByte* aSrc, TUint aSamples, TBool aOutput);
+};
+
+class SuiteCodecControllerAudioBuf : public SuiteCodecControllerBase
+{
+private:
+    static const TUint kBitsPerSample = 16;
+    static const TUint kSamplesPerMsg = 16;
+    static const TUint kAudioBytesPerMsg = 2*2*kSamplesPerMsg; // 16 bits (2 bytes) * 2 channels * kSamplesPerMsg
+public:
+    SuiteCodecControllerAudioBuf();
+private: // from SuiteCodecControllerBase
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestAudioBufIsExpectedSize();
+private:
+    TestCodecControllerDummyCodecAudioBuf* iCodec;
+};
+
+/*
+ * Codec that appends all decoded audio to memory borrowed from CodecController, only
+ * outputting it when the stream ends.
+ */
+class TestCodecControllerDummyCodecAudioBufHeld : public TestCodecControllerDummyCodec
+{
+public:
+    TestCodecControllerDummyCodecAudioBufHeld(TUint aReadBufBytes);
+public: // from TestCodecControllerDummyCodec
+    void Process() override;
+};
+
+class SuiteCodecControllerSeekAudioBuf : public SuiteCodecControllerBase, public ISeekObserver
+{
+private:
+    static const TUint kAudioBytesPerMsg = 256;
+public:
+    SuiteCodecControllerSeekAudioBuf();
+private: // from SuiteCodecControllerBase
+    void Setup() override;
+    void TearDown() override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+private: // from ISeekObserver
+    void NotifySeekComplete(TUint aHandle, TUint aFlushId) override;
+private:
+    void TestSeekThenStreamEnd();
+private:
+    TestCodecControllerDummyCodecAudioBufHeld* iCodec;
+    Semaphore* iSemSeek;
+    TUint iHandle;
+    TUint iFlushId;
+};
+
+/*
+ * Codec that declares a signature and counts how often it is asked to Recognise() a stream.
+ * Passing nullptr for aSignature declares no signature.
+ */
+class TestCodecControllerDummyCodecSignature : public TestCodecControllerDummyCodec
+{
+public:
+    TestCodecControllerDummyCodecSignature(TUint aReadBufBytes, const TChar* aSignature);
+    TUint RecogniseCount() const;
+public: // from TestCodecControllerDummyCodec
+    TBool Recognise(const EncodedStreamInfo& aStreamInfo) override;
+private:
+    TUint iRecogniseCount;
+};
+
+class SuiteCodecControllerSignature : public SuiteCodecControllerBase
+{
+private:
+    static const TUint kBitsPerSample = 16;
+    static const TUint kSamplesPerMsg = 16;
+    static const TUint kAudioBytesPerMsg = 2*2*kSamplesPerMsg; // 16 bits (2 bytes) * 2 channels * kSamplesPerMsg
+public:
+    SuiteCodecControllerSignature();
+private: // from SuiteCodecControllerBase
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestOnlyCandidatesRecognised();
+private:
+    TestCodecControllerDummyCodecSignature* iCodecNoSignature;
+    TestCodecControllerDummyCodecSignature* iCodecNoMatch;
+    TestCodecControllerDummyCodecSignature* iCodecMatch;
+};
+
 } // namespace Media
 } // namespace OpenHome
 
@@ -615,6 +716,7 @@ SuiteCodecControllerStream::SuiteCodecControllerStream()
     AddTest(MakeFunctor(*this, &SuiteCodecControllerStream::TestRecognitionFail), "TestRecognitionFail");
     AddTest(MakeFunctor(*this, &SuiteCodecControllerStream::TestTrackTrack), "TestTrackTrack");
     AddTest(MakeFunctor(*this, &SuiteCodecControllerStream::TestTrackMetatext), "TestTrackMetatext");
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerStream::TestTrackBitRate), "TestTrackBitRate");
     AddTest(MakeFunctor(*this, &SuiteCodecControllerStream::TestTrackEncodedStreamMetatext), "TestTrackEncodedStreamMetatext");
     AddTest(MakeFunctor(*this, &SuiteCodecControllerStream::TestTruncatedStreamInRecognition), "TestTruncatedStreamInRecognition");
     AddTest(MakeFunctor(*this, &SuiteCodecControllerStream::TestNoDataAfterRecognition), "TestNoDataAfterRecognition");
@@ -872,6 +974,14 @@ void SuiteCodecControllerStream::TestTrackMetatext()
     PullNext(EMsgMetaText);
 }
 
+void SuiteCodecControllerStream::TestTrackBitRate()
+{
+    Queue(CreateTrack());
+    PullNext(EMsgTrack);
+    Queue(iMsgFactory->CreateMsgBitRate(128000));
+    PullNext(EMsgBitRate);
+}
+
 void SuiteCodecControllerStream::TestTrackEncodedStreamMetatext()
 {
     Queue(CreateTrack());
@@ -1527,6 +1637,301 @@ void SuiteCodecControllerUnexpectedFlush::TestUnexpectedFlush()
 }
 
 
+// TestCodecControllerDummyCodecAudioBuf
+
+TestCodecControllerDummyCodecAudioBuf::TestCodecControllerDummyCodecAudioBuf(TUint aReadBufBytes)
+    : TestCodecControllerDummyCodec(aReadBufBytes)
+{
+}
+
+void TestCodecControllerDummyCodecAudioBuf::Process()
+{
+    iReadBuf.SetBytes(0);
+    iController->Read(iReadBuf, iReadBytes);
+    if (iReadBuf.Bytes() < iReadBytes) {
+        THROW(CodecStreamEnded);
+    }
+    const TUint bytesPerSample = (iBitDepth/8) * iChannels;
+    const TUint samples = iReadBuf.Bytes() / bytesPerSample;
+    const TUint firstHalf = samples / 2;
+    WriteAudio(iReadBuf.Ptr(), firstHalf, false);
+    WriteAudio(iReadBuf.Ptr() + firstHalf*bytesPerSample, samples - firstHalf, true);
+}
+
+void TestCodecControllerDummyCodecAudioBuf::WriteAudio(const TByte* aSrc, TUint aSamples, TBool aOutput)
+{
+    const TUint bytesPerSample = (iBitDepth/8) * iChannels;
+    while (aSamples > 0) {
+        TByte* dest;
+        TUint space;
+        iController->GetAudioBuf(dest, space);
+        const TUint samples = std::min(aSamples, space);
+        (void)memcpy(dest, aSrc, samples*bytesPerSample);
+        aSrc += samples*bytesPerSample;
+        aSamples -= samples;
+        if (samples == space) {
+            iController->OutputAudioBuf(samples, iTrackOffset);
+        }
+        else {
+            iController->AppendAudioBuf(samples);
+        }
+    }
+    if (aOutput) {
+        iController->OutputAudioBuf(0, iTrackOffset);
+    }
+}
+
+
+// SuiteCodecControllerAudioBuf
+
+SuiteCodecControllerAudioBuf::SuiteCodecControllerAudioBuf()
+    : SuiteCodecControllerBase("SuiteCodecControllerAudioBuf")
+{
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerAudioBuf::TestAudioBufIsExpectedSize), "TestAudioBufIsExpectedSize");
+}
+
+void SuiteCodecControllerAudioBuf::Setup()
+{
+    SuiteCodecControllerBase::Setup();
+    iCodec = new TestCodecControllerDummyCodecAudioBuf(kAudioBytesPerMsg);
+    iController->AddCodec(iCodec);  // Takes ownership.
+    iController->Start();
+}
+
+void SuiteCodecControllerAudioBuf::TearDown()
+{
+    SuiteCodecControllerBase::TearDown();
+}
+
+void SuiteCodecControllerAudioBuf::TestAudioBufIsExpectedSize()
+{
+    static const TUint kAudioBytes = 2048;
+    static const TUint64 kJiffiesPerEncodedMsg = (Jiffies::kPerSecond / kSampleRate) * kSamplesPerMsg;
+
+    iTotalBytes = kWavHeaderBytes + kAudioBytes;
+    iCodec->SetStreamInfo(kAudioBytesPerMsg, kNumChannels, kSampleRate, kBitsPerSample, AudioDataEndian::Big, kProfile);
+
+    Queue(CreateTrack());
+    PullNext(EMsgTrack);
+    Queue(CreateEncodedStream());
+    PullNext(EMsgEncodedStream);
+
+    TByte encodedAudioData[kAudioBytesPerMsg];
+    (void)memset(encodedAudioData, 0x7f, kAudioBytesPerMsg);
+    Brn encodedAudioBuf(encodedAudioData, kAudioBytesPerMsg);
+    while (iTrackOffsetBytes < kAudioBytes) {
+        Queue(iMsgFactory->CreateMsgAudioEncoded(encodedAudioBuf));
+        iTrackOffset += kJiffiesPerEncodedMsg;
+        iTrackOffsetBytes += kAudioBytesPerMsg;
+    }
+    Queue(CreateEncodedStream());
+
+    // Each block appended in two parts should still be output as a single msg.
+    PullNext(EMsgDecodedStream);
+    while (iJiffies < iTrackOffset) {
+        PullNext(EMsgAudioPcm, kJiffiesPerEncodedMsg);
+    }
+
+    PullNext(EMsgEncodedStream);
+    PullNext(EMsgDecodedStream);
+    TEST(iJiffies == iTrackOffset);
+}
+
+
+// TestCodecControllerDummyCodecAudioBufHeld
+
+TestCodecControllerDummyCodecAudioBufHeld::TestCodecControllerDummyCodecAudioBufHeld(TUint aReadBufBytes)
+    : TestCodecControllerDummyCodec(aReadBufBytes)
+{
+}
+
+void TestCodecControllerDummyCodecAudioBufHeld::Process()
+{
+    iReadBuf.SetBytes(0);
+    iController->Read(iReadBuf, iReadBytes);
+    if (iReadBuf.Bytes() < iReadBytes) {
+        iController->OutputAudioBuf(0, iTrackOffset); // output anything appended so far
+        THROW(CodecStreamEnded);
+    }
+    const TUint bytesPerSample = (iBitDepth/8) * iChannels;
+    const TUint samples = iReadBuf.Bytes() / bytesPerSample;
+    TByte* dest;
+    TUint space;
+    iController->GetAudioBuf(dest, space);
+    ASSERT(samples < space); // test only appends a few msgs
+    (void)memcpy(dest, iReadBuf.Ptr(), samples*bytesPerSample);
+    iController->AppendAudioBuf(samples);
+}
+
+
+// SuiteCodecControllerSeekAudioBuf
+
+SuiteCodecControllerSeekAudioBuf::SuiteCodecControllerSeekAudioBuf()
+    : SuiteCodecControllerBase("SuiteCodecControllerSeekAudioBuf")
+{
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerSeekAudioBuf::TestSeekThenStreamEnd), "TestSeekThenStreamEnd");
+}
+
+void SuiteCodecControllerSeekAudioBuf::Setup()
+{
+    SuiteCodecControllerBase::Setup();
+    iSemSeek = new Semaphore("SCSA", 0);
+    iHandle = ISeeker::kHandleError;
+    iFlushId = MsgFlush::kIdInvalid;
+    iCodec = new TestCodecControllerDummyCodecAudioBufHeld(kAudioBytesPerMsg);
+    iController->AddCodec(iCodec);  // Takes ownership.
+    iController->Start();
+}
+
+void SuiteCodecControllerSeekAudioBuf::TearDown()
+{
+    delete iSemSeek;
+    SuiteCodecControllerBase::TearDown();
+}
+
+TUint SuiteCodecControllerSeekAudioBuf::TrySeek(TUint /*aStreamId*/, TUint64 /*aOffset*/)
+{
+    return kExpectedFlushId;
+}
+
+void SuiteCodecControllerSeekAudioBuf::NotifySeekComplete(TUint aHandle, TUint aFlushId)
+{
+    iHandle = aHandle;
+    iFlushId = aFlushId;
+    iSemSeek->Signal();
+}
+
+void SuiteCodecControllerSeekAudioBuf::TestSeekThenStreamEnd()
+{
+    // A seek discards audio appended to CodecController's buffer.  Ending the stream before
+    // any more audio is appended should output nothing (rather than the discarded buffer).
+    iCodec->SetStreamInfo(kAudioBytesPerMsg, kNumChannels, kSampleRate, 16, AudioDataEndian::Big, kProfile);
+
+    Queue(CreateTrack());
+    PullNext(EMsgTrack);
+    Queue(CreateEncodedStream());
+    PullNext(EMsgEncodedStream);
+
+    TByte encodedAudioData[kAudioBytesPerMsg];
+    (void)memset(encodedAudioData, 0x7f, kAudioBytesPerMsg);
+    Brn encodedAudioBuf(encodedAudioData, kAudioBytesPerMsg);
+    Queue(iMsgFactory->CreateMsgAudioEncoded(encodedAudioBuf));
+    Queue(iMsgFactory->CreateMsgAudioEncoded(encodedAudioBuf));
+    PullNext(EMsgDecodedStream);
+    while (iPendingMsgs.size() > 0) {
+        Thread::Sleep(10); // leave time for audio to be appended to CodecController's buffer
+    }
+
+    ISeeker& seeker = *iController;
+    TUint handle = ISeeker::kHandleError;
+    seeker.StartSeek(iStreamId, 1, *this, handle);
+    // Send another audio msg down to cause CodecController to unblock and start the seek.
+    Queue(iMsgFactory->CreateMsgAudioEncoded(encodedAudioBuf));
+    iSemSeek->Wait(kSemWaitMs);
+    TEST(iHandle == handle);
+    TEST(iFlushId == kExpectedFlushId);
+
+    // End the stream part way through the first read following the seek
+    Queue(CreateFlush());
+    Queue(iMsgFactory->CreateMsgAudioEncoded(Brn(encodedAudioData, kAudioBytesPerMsg / 2)));
+    Queue(CreateEncodedStream());
+
+    do {
+        PullNext();
+        TEST(iLastReceivedMsg != EMsgAudioPcm);
+    } while (iLastReceivedMsg != EMsgEncodedStream);
+    PullNext(EMsgDecodedStream);
+}
+
+
+// TestCodecControllerDummyCodecSignature
+
+TestCodecControllerDummyCodecSignature::TestCodecControllerDummyCodecSignature(TUint aReadBufBytes, const TChar* aSignature)
+    : TestCodecControllerDummyCodec(aReadBufBytes)
+    , iRecogniseCount(0)
+{
+    if (aSignature != nullptr) {
+        AddSignature(aSignature);
+    }
+}
+
+TUint TestCodecControllerDummyCodecSignature::RecogniseCount() const
+{
+    return iRecogniseCount;
+}
+
+TBool TestCodecControllerDummyCodecSignature::Recognise(const EncodedStreamInfo& aStreamInfo)
+{
+    iRecogniseCount++;
+    return TestCodecControllerDummyCodec::Recognise(aStreamInfo);
+}
+
+
+// SuiteCodecControllerSignature
+
+SuiteCodecControllerSignature::SuiteCodecControllerSignature()
+    : SuiteCodecControllerBase("SuiteCodecControllerSignature")
+{
+    AddTest(MakeFunctor(*this, &SuiteCodecControllerSignature::TestOnlyCandidatesRecognised), "TestOnlyCandidatesRecognised");
+}
+
+void SuiteCodecControllerSignature::Setup()
+{
+    SuiteCodecControllerBase::Setup();
+    // All codecs have the same cost so, without signatures, would be tried in the order they're added.
+    iCodecNoSignature = new TestCodecControllerDummyCodecSignature(kAudioBytesPerMsg, nullptr);
+    iCodecNoMatch = new TestCodecControllerDummyCodecSignature(kAudioBytesPerMsg, "RIFF");
+    iCodecMatch = new TestCodecControllerDummyCodecSignature(kAudioBytesPerMsg, "\x7f\x7f\x7f\x7f");
+    iController->AddCodec(iCodecNoSignature);   // Takes ownership.
+    iController->AddCodec(iCodecNoMatch);       // Takes ownership.
+    iController->AddCodec(iCodecMatch);         // Takes ownership.
+    iController->Start();
+}
+
+void SuiteCodecControllerSignature::TearDown()
+{
+    SuiteCodecControllerBase::TearDown();
+}
+
+void SuiteCodecControllerSignature::TestOnlyCandidatesRecognised()
+{
+    static const TUint kAudioBytes = 512;
+    static const TUint64 kJiffiesPerEncodedMsg = (Jiffies::kPerSecond / kSampleRate) * kSamplesPerMsg;
+
+    iTotalBytes = kWavHeaderBytes + kAudioBytes;
+    iCodecNoSignature->SetStreamInfo(kAudioBytesPerMsg, kNumChannels, kSampleRate, kBitsPerSample, AudioDataEndian::Big, kProfile);
+    iCodecNoMatch->SetStreamInfo(kAudioBytesPerMsg, kNumChannels, kSampleRate, kBitsPerSample, AudioDataEndian::Big, kProfile);
+    iCodecMatch->SetStreamInfo(kAudioBytesPerMsg, kNumChannels, kSampleRate, kBitsPerSample, AudioDataEndian::Big, kProfile);
+
+    Queue(CreateTrack());
+    PullNext(EMsgTrack);
+    Queue(CreateEncodedStream());
+    PullNext(EMsgEncodedStream);
+
+    TByte encodedAudioData[kAudioBytesPerMsg];
+    (void)memset(encodedAudioData, 0x7f, kAudioBytesPerMsg);
+    Brn encodedAudioBuf(encodedAudioData, kAudioBytesPerMsg);
+    while (iTrackOffsetBytes < kAudioBytes) {
+        Queue(iMsgFactory->CreateMsgAudioEncoded(encodedAudioBuf));
+        iTrackOffset += kJiffiesPerEncodedMsg;
+        iTrackOffsetBytes += kAudioBytesPerMsg;
+    }
+    Queue(CreateEncodedStream());
+
+    PullNext(EMsgDecodedStream);
+    // Codec whose signature matched is tried first; codec whose signature didn't match is never tried.
+    TEST(iCodecMatch->RecogniseCount() == 1);
+    TEST(iCodecNoMatch->RecogniseCount() == 0);
+    TEST(iCodecNoSignature->RecogniseCount() == 0);
+    while (iJiffies < iTrackOffset) {
+        PullNext(EMsgAudioPcm, kJiffiesPerEncodedMsg);
+    }
+    PullNext(EMsgEncodedStream);
+    PullNext(EMsgDecodedStream);
+    TEST(iJiffies == iTrackOffset);
+}
+
+
 
 void TestCodecController()
 {
@@ -1536,6 +1941,9 @@ void TestCodecController()
     runner.Add(new SuiteCodecControllerStopDuringStreamInit());
     runner.Add(new SuiteCodecControllerSeekInvalid());
     runner.Add(new SuiteCodecControllerUnexpectedFlush());
+    runner.Add(new SuiteCodecControllerAudioBuf());
+    runner.Add(new SuiteCodecControllerSeekAudioBuf());
+    runner.Add(new SuiteCodecControllerSignature());
     runner.Run();
 }
 
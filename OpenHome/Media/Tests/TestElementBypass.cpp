@@ -0,0 +1,394 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/Pipeline/ElementBypass.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+
+#include <string.h>
+#include <limits.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class BypassableElement : public IPipelineElementUpstream, public IPipelineElementBypassable, private INonCopyable
+{
+public:
+    BypassableElement(IPipelineElementUpstream& aUpstream);
+    void SetBypassPull(TBool aBypass);
+    void SetBypassAudio(TBool aBypass);
+    void ConsumeNextControlMsg();
+    TUint Pulls() const;
+    TUint Processed() const;
+public: // from IPipelineElementUpstream
+    Msg* Pull() override;
+public: // from IPipelineElementBypassable
+    TBool BypassPull() const override;
+    TBool BypassAudio() const override;
+    Msg* ProcessBypassed(Msg* aMsg) override;
+private:
+    IPipelineElementUpstream& iUpstream;
+    TBool iBypassPull;
+    TBool iBypassAudio;
+    TBool iConsumeNext;
+    TUint iPulls;
+    TUint iProcessed;
+};
+
+class SuiteElementBypass : public SuiteUnitTest, private IPipelineElementUpstream
+{
+    static const TUint kSampleRate = 44100;
+    static const TUint kNumChannels = 2;
+public:
+    SuiteElementBypass();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IPipelineElementUpstream
+    Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
+private:
+    MsgAudioPcm* CreateAudio();
+    void TestIsAudioPcm();
+    void TestAudioSkipsIdleElements();
+    void TestAudioVisitsBusyElements();
+    void TestControlMsgVisitsAllElements();
+    void TestConsumedMsgPullsAgain();
+    void TestFallsBackWhenNotBypassable();
+    void TestBypassStateCachedUntilNewMode();
+    void TestPullBatchPassesAudioRun();
+    void TestPullBatchFallsBackWhenNotBypassable();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    MsgQueue iQueue;
+    BypassableElement* iElement1;
+    BypassableElement* iElement2;
+    BypassableElement* iElement3;
+    ElementBypass* iBypass;
+    TUint64 iTrackOffset;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// BypassableElement
+
+BypassableElement::BypassableElement(IPipelineElementUpstream& aUpstream)
+    : iUpstream(aUpstream)
+    , iBypassPull(true)
+    , iBypassAudio(true)
+    , iConsumeNext(false)
+    , iPulls(0)
+    , iProcessed(0)
+{
+}
+
+void BypassableElement::SetBypassPull(TBool aBypass)
+{
+    iBypassPull = aBypass;
+}
+
+void BypassableElement::SetBypassAudio(TBool aBypass)
+{
+    iBypassAudio = aBypass;
+}
+
+void BypassableElement::ConsumeNextControlMsg()
+{
+    iConsumeNext = true;
+}
+
+TUint BypassableElement::Pulls() const
+{
+    return iPulls;
+}
+
+TUint BypassableElement::Processed() const
+{
+    return iProcessed;
+}
+
+Msg* BypassableElement::Pull()
+{
+    iPulls++;
+    Msg* msg;
+    do {
+        msg = ProcessBypassed(iUpstream.Pull());
+    } while (msg == nullptr);
+    return msg;
+}
+
+TBool BypassableElement::BypassPull() const
+{
+    return iBypassPull;
+}
+
+TBool BypassableElement::BypassAudio() const
+{
+    return iBypassAudio;
+}
+
+Msg* BypassableElement::ProcessBypassed(Msg* aMsg)
+{
+    iProcessed++;
+    if (iConsumeNext && !aMsg->IsAudioPcm()) {
+        iConsumeNext = false;
+        aMsg->RemoveRef();
+        return nullptr;
+    }
+    return aMsg;
+}
+
+
+// SuiteElementBypass
+
+SuiteElementBypass::SuiteElementBypass()
+    : SuiteUnitTest("SuiteElementBypass")
+{
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestIsAudioPcm), "TestIsAudioPcm");
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestAudioSkipsIdleElements), "TestAudioSkipsIdleElements");
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestAudioVisitsBusyElements), "TestAudioVisitsBusyElements");
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestControlMsgVisitsAllElements), "TestControlMsgVisitsAllElements");
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestConsumedMsgPullsAgain), "TestConsumedMsgPullsAgain");
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestFallsBackWhenNotBypassable), "TestFallsBackWhenNotBypassable");
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestBypassStateCachedUntilNewMode), "TestBypassStateCachedUntilNewMode");
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestPullBatchPassesAudioRun), "TestPullBatchPassesAudioRun");
+    AddTest(MakeFunctor(*this, &SuiteElementBypass::TestPullBatchFallsBackWhenNotBypassable), "TestPullBatchFallsBackWhenNotBypassable");
+}
+
+void SuiteElementBypass::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioPcmCount(4, 4);
+    init.SetMsgSilenceCount(2);
+    init.SetMsgHaltCount(2);
+    init.SetMsgModeCount(2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iElement1 = new BypassableElement(*this);
+    iElement2 = new BypassableElement(*iElement1);
+    iElement3 = new BypassableElement(*iElement2);
+    iBypass = new ElementBypass(*this, *iElement3);
+    iBypass->AddElement(*iElement1);
+    iBypass->AddElement(*iElement2);
+    iBypass->AddElement(*iElement3);
+    iTrackOffset = 0;
+}
+
+void SuiteElementBypass::TearDown()
+{
+    iQueue.Clear();
+    delete iBypass;
+    delete iElement3;
+    delete iElement2;
+    delete iElement1;
+    delete iMsgFactory;
+}
+
+Msg* SuiteElementBypass::Pull()
+{
+    ASSERT(!iQueue.IsEmpty());
+    return iQueue.Dequeue();
+}
+
+void SuiteElementBypass::PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies)
+{
+    ASSERT(!iQueue.IsEmpty());
+    iQueue.DequeueBatch(aQueue, aMaxJiffies);
+}
+
+MsgAudioPcm* SuiteElementBypass::CreateAudio()
+{
+    static const TUint kDataBytes = 960;
+    TByte audioData[kDataBytes];
+    (void)memset(audioData, 0x7f, kDataBytes);
+    Brn audioBuf(audioData, kDataBytes);
+    MsgAudioPcm* audio = iMsgFactory->CreateMsgAudioPcm(audioBuf, kNumChannels, kSampleRate, 16, AudioDataEndian::Little, iTrackOffset);
+    iTrackOffset += audio->Jiffies();
+    return audio;
+}
+
+void SuiteElementBypass::TestIsAudioPcm()
+{
+    MsgAudioPcm* audio = CreateAudio();
+    TEST(audio->IsAudioPcm());
+    audio->RemoveRef();
+    Msg* silence = iMsgFactory->CreateMsgSilence(Jiffies::kPerMs, kSampleRate, 16, kNumChannels);
+    TEST(!silence->IsAudioPcm());
+    silence->RemoveRef();
+    Msg* halt = iMsgFactory->CreateMsgHalt();
+    TEST(!halt->IsAudioPcm());
+    halt->RemoveRef();
+}
+
+void SuiteElementBypass::TestAudioSkipsIdleElements()
+{
+    Msg* audio = CreateAudio();
+    iQueue.Enqueue(audio);
+    Msg* msg = iBypass->Pull();
+    TEST(msg == audio);
+    msg->RemoveRef();
+    TEST(iElement1->Pulls() == 0);
+    TEST(iElement2->Pulls() == 0);
+    TEST(iElement3->Pulls() == 0);
+    TEST(iElement1->Processed() == 0);
+    TEST(iElement2->Processed() == 0);
+    TEST(iElement3->Processed() == 0);
+}
+
+void SuiteElementBypass::TestAudioVisitsBusyElements()
+{
+    iElement2->SetBypassAudio(false);
+    iQueue.Enqueue(CreateAudio());
+    iBypass->Pull()->RemoveRef();
+    TEST(iElement1->Processed() == 0);
+    TEST(iElement2->Processed() == 1);
+    TEST(iElement3->Processed() == 0);
+    TEST(iElement3->Pulls() == 0);
+}
+
+void SuiteElementBypass::TestControlMsgVisitsAllElements()
+{
+    Msg* halt = iMsgFactory->CreateMsgHalt();
+    iQueue.Enqueue(halt);
+    Msg* msg = iBypass->Pull();
+    TEST(msg == halt);
+    msg->RemoveRef();
+    TEST(iElement1->Processed() == 1);
+    TEST(iElement2->Processed() == 1);
+    TEST(iElement3->Processed() == 1);
+    TEST(iElement3->Pulls() == 0);
+}
+
+void SuiteElementBypass::TestConsumedMsgPullsAgain()
+{
+    iElement2->ConsumeNextControlMsg();
+    iQueue.Enqueue(iMsgFactory->CreateMsgHalt());
+    Msg* audio = CreateAudio();
+    iQueue.Enqueue(audio);
+    Msg* msg = iBypass->Pull();
+    TEST(msg == audio);
+    msg->RemoveRef();
+    TEST(iElement1->Processed() == 1);
+    TEST(iElement2->Processed() == 1);
+    TEST(iElement3->Processed() == 0);
+    TEST(iQueue.IsEmpty());
+}
+
+void SuiteElementBypass::TestFallsBackWhenNotBypassable()
+{
+    iElement2->SetBypassPull(false);
+    Msg* audio = CreateAudio();
+    iQueue.Enqueue(audio);
+    Msg* msg = iBypass->Pull();
+    TEST(msg == audio);
+    msg->RemoveRef();
+    TEST(iElement1->Pulls() == 1);
+    TEST(iElement2->Pulls() == 1);
+    TEST(iElement3->Pulls() == 1);
+    TEST(iElement1->Processed() == 1);
+    TEST(iElement2->Processed() == 1);
+    TEST(iElement3->Processed() == 1);
+
+    // bypass state is only re-read after a new mode/stream
+    iElement2->SetBypassPull(true);
+    Msg* mode = iMsgFactory->CreateMsgMode(Brx::Empty());
+    iQueue.Enqueue(mode);
+    msg = iBypass->Pull();
+    TEST(msg == mode);
+    msg->RemoveRef();
+    TEST(iElement3->Pulls() == 2);
+    TEST(iElement3->Processed() == 2);
+
+    iQueue.Enqueue(CreateAudio());
+    iBypass->Pull()->RemoveRef();
+    TEST(iElement3->Pulls() == 2);
+    TEST(iElement3->Processed() == 2);
+}
+
+void SuiteElementBypass::TestBypassStateCachedUntilNewMode()
+{
+    iQueue.Enqueue(CreateAudio());
+    iBypass->Pull()->RemoveRef();
+    TEST(iElement2->Processed() == 0);
+
+    iElement2->SetBypassAudio(false);
+    iQueue.Enqueue(CreateAudio());
+    iBypass->Pull()->RemoveRef();
+    TEST(iElement2->Processed() == 0);
+
+    iQueue.Enqueue(iMsgFactory->CreateMsgHalt());
+    iBypass->Pull()->RemoveRef();
+    TEST(iElement2->Processed() == 1);
+    iQueue.Enqueue(CreateAudio());
+    iBypass->Pull()->RemoveRef();
+    TEST(iElement2->Processed() == 1);
+
+    iQueue.Enqueue(iMsgFactory->CreateMsgMode(Brx::Empty()));
+    iBypass->Pull()->RemoveRef();
+    TEST(iElement2->Processed() == 2);
+    iQueue.Enqueue(CreateAudio());
+    iBypass->Pull()->RemoveRef();
+    TEST(iElement2->Processed() == 3);
+}
+
+void SuiteElementBypass::TestPullBatchPassesAudioRun()
+{
+    iElement2->SetBypassAudio(false);
+    Msg* audio1 = CreateAudio();
+    Msg* audio2 = CreateAudio();
+    Msg* audio3 = CreateAudio();
+    iQueue.Enqueue(audio1);
+    iQueue.Enqueue(audio2);
+    iQueue.Enqueue(audio3);
+    Msg* halt = iMsgFactory->CreateMsgHalt();
+    iQueue.Enqueue(halt);
+
+    MsgQueueLite batch;
+    iBypass->PullBatch(batch, UINT_MAX);
+    TEST(batch.NumMsgs() == 3);
+    TEST(batch.Dequeue() == audio1);
+    TEST(batch.Dequeue() == audio2);
+    TEST(batch.Dequeue() == audio3);
+    audio1->RemoveRef();
+    audio2->RemoveRef();
+    audio3->RemoveRef();
+    TEST(iElement1->Processed() == 0);
+    TEST(iElement2->Processed() == 3);
+    TEST(iElement3->Processed() == 0);
+
+    iBypass->PullBatch(batch, UINT_MAX);
+    TEST(batch.NumMsgs() == 1);
+    TEST(batch.Dequeue() == halt);
+    halt->RemoveRef();
+    TEST(iElement1->Processed() == 1);
+    TEST(iElement2->Processed() == 4);
+    TEST(iElement3->Processed() == 1);
+    TEST(iElement3->Pulls() == 0);
+}
+
+void SuiteElementBypass::TestPullBatchFallsBackWhenNotBypassable()
+{
+    iElement2->SetBypassPull(false);
+    Msg* audio = CreateAudio();
+    iQueue.Enqueue(audio);
+    MsgQueueLite batch;
+    iBypass->PullBatch(batch, UINT_MAX);
+    TEST(batch.NumMsgs() == 1);
+    TEST(batch.Dequeue() == audio);
+    audio->RemoveRef();
+    TEST(iElement3->Pulls() == 1);
+    TEST(iElement3->Processed() == 1);
+}
+
+
+void TestElementBypass()
+{
+    Runner runner("ElementBypass tests\n");
+    runner.Add(new SuiteElementBypass());
+    runner.Run();
+}
@@ -5,8 +5,11 @@
 #include <OpenHome/Private/SuiteUnitTest.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/FlywheelRamper.h>
+#include <OpenHome/Media/Utils/LpcKernels.h>
 #include <OpenHome/Private/File.h>
 
+#include <algorithm>
+
 using namespace OpenHome;
 using namespace OpenHome::Net;
 using namespace OpenHome::TestFramework;
@@ -38,6 +41,8 @@ private:
     void Test5(); // FeedbackModel oscillator (periodic alternating polarity impulse output)
     void Test6(); // Burg Method testing
     void Test7(); // Speed testing (profiling)
+    void Test8(); // Vectorised kernels and channel parallel rendering match scalar output
+    void Test9(); // Incremental training matches training from a block of input
 
     void Setup();
     void TearDown();
@@ -47,6 +52,11 @@ private:
     static TInt32 Int32(const Brx& aBuf, TUint aIndex);
     static void Append32(Bwx& aBuf, TInt32 aSample);
     static double ToDouble(TInt32 aVal);
+    static void GenerateInput(Bwx& aBuf, TUint aSampleRate, TUint aChannelCount, TUint aJiffies);
+    static void RenderRamp(Bwx& aOutput, const Brx& aInput, TUint aSampleRate, TUint aChannelCount,
+                           TUint aInputJiffies, TUint aRampJiffies, FlywheelRamperManager::Render aRender);
+    static void RenderRampIncremental(Bwx& aOutput, const Brx& aStream, TUint aSampleRate, TUint aChannelCount,
+                                      TUint aSubsampleBytes, TUint aInputJiffies, TUint aRampJiffies);
 };
 
 //////////////////////////////////////////////////////////////
@@ -69,6 +79,23 @@ private:
     Bwx& iBuf;
 };
 
+class PcmProcessorAccumulate : public IPcmProcessor, public INonCopyable
+{
+public:
+    PcmProcessorAccumulate(Bwx& aBuf);
+
+    // IPcmProcessor
+    virtual void BeginBlock() override {};
+    virtual void EndBlock() override {};
+
+    void ProcessFragment(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override;
+    void ProcessSilence(const Brx& , TUint , TUint ) override { ASSERTS(); };
+    virtual void Flush() override {ASSERTS();};
+
+private:
+    Bwx& iBuf;
+};
+
 
 
 } // TestFlywheelRamper
@@ -104,6 +131,8 @@ SuiteFlywheelRamper::SuiteFlywheelRamper(Environment& aEnv)
     AddTest(MakeFunctor(*this, &SuiteFlywheelRamper::Test5));
 
     AddTest(MakeFunctor(*this, &SuiteFlywheelRamper::Test6)); // Burg Method testing
+    AddTest(MakeFunctor(*this, &SuiteFlywheelRamper::Test8)); // SIMD/channel parallel equivalence
+    AddTest(MakeFunctor(*this, &SuiteFlywheelRamper::Test9)); // incremental training
     //AddTest(MakeFunctor(*this, &SuiteFlywheelRamper::Test7)); // Burg Method profiling
 }
 
@@ -673,11 +702,193 @@ void SuiteFlywheelRamper::Test7() // Speed testing (profiling)
 
     Log::Print("processed = %d 32bit samples, expected %d (8*192 channels*samples) = %d bytes\n", rampOutput.Bytes()/4, rampByteCount/4, rampOutput.Bytes());
 
+    // incremental training, as StarvationRamper runs it on the animator's pull thread for every msg
+    const TUint kMsgJiffies = 5*Jiffies::kPerMs;
+    Bwh msg(FlywheelRamper::SampleCount(kSampleRate, kMsgJiffies)*FlywheelRamper::kBytesPerSample*kChanCount);
+    msg.SetBytes(msg.MaxBytes());
+    TUint32 noise = 0x12345678;
+    for (TUint i=0; i<msg.Bytes(); i++) {
+        noise = noise*1664525 + 1013904223;
+        msg[i] = (TByte)(noise >> 24);
+    }
+    ramper->TrainingReset(kSampleRate, kChanCount);
+    TUint64 appendUs = 0;
+    TUint64 updateUs = 0;
+    TUint64 worstUpdateUs = 0;
+    for (TUint i=0; i<1000; i++) {
+        const TUint64 start = Os::TimeInUs(iEnv.OsCtx());
+        ramper->TrainingAppend(msg, FlywheelRamper::kBytesPerSample);
+        const TUint64 appended = Os::TimeInUs(iEnv.OsCtx());
+        ramper->TrainingUpdate();
+        const TUint64 updated = Os::TimeInUs(iEnv.OsCtx());
+        appendUs += appended - start;
+        updateUs += updated - appended;
+        worstUpdateUs = std::max(worstUpdateUs, updated - appended);
+    }
+    Log::Print("incremental training per 5ms msg (8 channels, 192kHz): append = %lluus  update = %lluus  worst update = %lluus (1000 msgs)\n",
+               appendUs, updateUs, worstUpdateUs);
+
     delete ramper;
 
 }
 
 
+void SuiteFlywheelRamper::Test8() // Vectorised kernels and channel parallel rendering match scalar output
+{
+    const TUint kSampleRates[] = { 44100, 48000, 96000, 192000 };
+    const TUint kChannelCounts[] = { 1, 2, 6, 8, 10 };
+    const TUint kGenJiffies = 10*Jiffies::kPerMs;
+    const TUint kRampJiffies = 20*Jiffies::kPerMs;
+    const LpcKernels::Impl kImpls[] = { LpcKernels::Impl::Scalar, LpcKernels::Impl::Sse2,
+                                        LpcKernels::Impl::Avx2, LpcKernels::Impl::Neon };
+    const LpcKernels::Impl initialImpl = LpcKernels::Current();
+
+    const TUint maxInputBytes = FlywheelRamper::SampleCount(192000, kGenJiffies)*FlywheelRamper::kBytesPerSample*10;
+    const TUint maxRampBytes = FlywheelRamper::SampleCount(192000, kRampJiffies)*FlywheelRamper::kBytesPerSample*10;
+    Bwh input(maxInputBytes);
+    Bwh expected(maxRampBytes);
+    Bwh output(maxRampBytes);
+
+    for (auto sampleRate : kSampleRates) {
+        for (auto channelCount : kChannelCounts) {
+            GenerateInput(input, sampleRate, channelCount, kGenJiffies);
+            LpcKernels::Select(LpcKernels::Impl::Scalar);
+            RenderRamp(expected, input, sampleRate, channelCount, kGenJiffies, kRampJiffies, FlywheelRamperManager::Render::PerChannel);
+            TEST(expected.Bytes() == FlywheelRamper::SampleCount(sampleRate, kRampJiffies)*FlywheelRamper::kBytesPerSample*channelCount);
+
+            for (auto impl : kImpls) {
+                if (!LpcKernels::IsSupported(impl)) {
+                    continue;
+                }
+                LpcKernels::Select(impl);
+                RenderRamp(output, input, sampleRate, channelCount, kGenJiffies, kRampJiffies, FlywheelRamperManager::Render::PerChannel);
+                TEST(output == expected);
+                RenderRamp(output, input, sampleRate, channelCount, kGenJiffies, kRampJiffies, FlywheelRamperManager::Render::ChannelParallel);
+                TEST(output == expected);
+            }
+        }
+    }
+    LpcKernels::Select(initialImpl);
+}
+
+void SuiteFlywheelRamper::Test9() // Incremental training matches training from a block of input
+{
+    const TUint kSampleRates[] = { 44100, 48000, 88200, 96000, 176400, 192000 };
+    const TUint kChannelCounts[] = { 1, 2, 6, 8 };
+    const TUint kSubsampleBytes[] = { 2, 3, 4 };
+    const TUint kGenJiffies = Jiffies::kPerMs; // as StarvationRamper
+    const TUint kRampJiffies = 20*Jiffies::kPerMs;
+    const TUint kMaxStreamJiffies = 8*Jiffies::kPerMs;
+
+    const TUint maxFrames = FlywheelRamper::SampleCount(192000, kMaxStreamJiffies) + 5;
+    const TUint maxRampBytes = FlywheelRamper::SampleCount(192000, kRampJiffies)*FlywheelRamper::kBytesPerSample*8;
+    Bwh stream(maxFrames*FlywheelRamper::kBytesPerSample*8);
+    Bwh input(FlywheelRamper::SampleCount(192000, kGenJiffies)*FlywheelRamper::kBytesPerSample*8);
+    Bwh expected(maxRampBytes);
+    Bwh output(maxRampBytes);
+
+    for (auto sampleRate : kSampleRates) {
+        const TUint windowFrames = FlywheelRamper::SampleCount(sampleRate, kGenJiffies);
+        // a full window preceded by a lead-in that leaves decimation out of phase with the
+        // stream start, then less than a window (classic training pads this with silence)
+        const TUint kStreamFrames[] = { FlywheelRamper::SampleCount(sampleRate, 7*Jiffies::kPerMs) + 5, windowFrames/2 };
+        for (auto channelCount : kChannelCounts) {
+            for (auto subsampleBytes : kSubsampleBytes) {
+                for (auto frames : kStreamFrames) {
+                    // interleaved, big endian stream
+                    TUint32 noise = 0x87654321;
+                    stream.SetBytes(0);
+                    for (TUint i=0; i<frames; i++) {
+                        for (TUint ch=0; ch<channelCount; ch++) {
+                            noise = noise*1664525 + 1013904223;
+                            const TInt32 tone = (TInt32)(((i*(ch+3)*0x01000000u) ^ (i*0x00400000u)) & 0x7fffffff) - 0x40000000;
+                            const TInt32 sample = tone/2 + (TInt32)(noise>>5);
+                            for (TUint b=0; b<subsampleBytes; b++) {
+                                stream.Append((TByte)(sample >> (24-8*b)));
+                            }
+                        }
+                    }
+
+                    // the final window, deinterleaved and padded to 32 bits as StarvationRamper does
+                    const TUint frameBytes = subsampleBytes*channelCount;
+                    const TUint silentFrames = (frames < windowFrames? windowFrames - frames : 0);
+                    input.SetBytes(0);
+                    for (TUint ch=0; ch<channelCount; ch++) {
+                        for (TUint i=0; i<silentFrames; i++) {
+                            Append32(input, 0);
+                        }
+                        for (TUint i=frames+silentFrames-windowFrames; i<frames; i++) {
+                            const TByte* p = stream.Ptr() + i*frameBytes + ch*subsampleBytes;
+                            TUint32 sample = 0;
+                            for (TUint b=0; b<4; b++) {
+                                sample = (sample << 8) | (b < subsampleBytes? p[b] : 0);
+                            }
+                            Append32(input, (TInt32)sample);
+                        }
+                    }
+
+                    RenderRamp(expected, input, sampleRate, channelCount, kGenJiffies, kRampJiffies, FlywheelRamperManager::Render::ChannelParallel);
+                    RenderRampIncremental(output, stream, sampleRate, channelCount, subsampleBytes, kGenJiffies, kRampJiffies);
+                    TEST(output == expected);
+                }
+            }
+        }
+    }
+}
+
+void SuiteFlywheelRamper::GenerateInput(Bwx& aBuf, TUint aSampleRate, TUint aChannelCount, TUint aJiffies)
+{
+    // deinterleaved, a different mix of tones plus noise per channel
+    // Includes full scale samples to check that all implementations wrap identically.
+    const TUint sampleCount = FlywheelRamper::SampleCount(aSampleRate, aJiffies);
+    TUint32 noise = 0x12345678;
+    aBuf.SetBytes(0);
+    for (TUint ch=0; ch<aChannelCount; ch++) {
+        for (TUint i=0; i<sampleCount; i++) {
+            noise = noise*1664525 + 1013904223;
+            const TInt32 tone = (TInt32)(((i*(ch+3)*0x01000000u) ^ (i*0x00400000u)) & 0x7fffffff) - 0x40000000;
+            TInt32 sample = tone + (TInt32)(noise>>4) - 0x08000000;
+            if (i % 97 == ch) {
+                sample = (ch & 1)? 0x7fffffff : (TInt32)0x80000000;
+            }
+            Append32(aBuf, sample);
+        }
+    }
+}
+
+void SuiteFlywheelRamper::RenderRamp(Bwx& aOutput, const Brx& aInput, TUint aSampleRate, TUint aChannelCount,
+                                     TUint aInputJiffies, TUint aRampJiffies, FlywheelRamperManager::Render aRender)
+{
+    aOutput.SetBytes(0);
+    PcmProcessorAccumulate opProc(aOutput);
+    FlywheelRamperManager ramper(opProc, aInputJiffies, aRampJiffies, aRender);
+    ramper.Ramp(aInput, aSampleRate, aChannelCount);
+}
+
+void SuiteFlywheelRamper::RenderRampIncremental(Bwx& aOutput, const Brx& aStream, TUint aSampleRate, TUint aChannelCount,
+                                                TUint aSubsampleBytes, TUint aInputJiffies, TUint aRampJiffies)
+{
+    aOutput.SetBytes(0);
+    PcmProcessorAccumulate opProc(aOutput);
+    FlywheelRamperManager ramper(opProc, aInputJiffies, aRampJiffies);
+    ramper.TrainingReset(aSampleRate, aChannelCount);
+
+    // feed the stream in irregular chunks, updating the model after each (as StarvationRamper does per msg)
+    const TUint frameBytes = aSubsampleBytes*aChannelCount;
+    const TUint frames = aStream.Bytes()/frameBytes;
+    TUint chunkFrames = 17;
+    for (TUint i=0; i<frames; ) {
+        const TUint count = std::min(chunkFrames, frames-i);
+        Brn chunk(aStream.Ptr() + i*frameBytes, count*frameBytes);
+        ramper.TrainingAppend(chunk, aSubsampleBytes);
+        ramper.TrainingUpdate();
+        i += count;
+        chunkFrames = (chunkFrames*7) % 251 + 1;
+    }
+
+    ramper.RampFromTraining();
+}
+
 
 void SuiteFlywheelRamper::Setup()
 {
@@ -721,6 +932,18 @@ void PcmProcessorFeedback::ProcessFragment(const Brx& aData, TUint /*aNumChannel
     iBuf.Replace(aData);
 }
 
+/////////////////////////////////////////////////////////////////
+
+PcmProcessorAccumulate::PcmProcessorAccumulate(Bwx& aBuf)
+    :iBuf(aBuf)
+{
+}
+
+void PcmProcessorAccumulate::ProcessFragment(const Brx& aData, TUint /*aNumChannels*/, TUint /*aSubsampleBytes*/)
+{
+    iBuf.Append(aData);
+}
+
 
 
 
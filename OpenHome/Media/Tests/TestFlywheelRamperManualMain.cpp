@@ -2,9 +2,11 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/OsWrapper.h>
 #include <OpenHome/Net/Cpp/OhNet.h>
+#include <OpenHome/Private/Env.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/FlywheelRamper.h>
+#include <OpenHome/Media/Utils/LpcKernels.h>
 #include <OpenHome/Private/File.h>
 #include <OpenHome/Private/Ascii.h>
 #include <OpenHome/Media/Tests/Cdecl.h>
@@ -90,6 +92,38 @@ private:
 };
 
 
+//////////////////////////////////////////////////////////////
+
+class PcmProcessorNull : public IPcmProcessor
+{
+public:
+    // IPcmProcessor
+    void BeginBlock() override {}
+    void ProcessFragment(const Brx& /*aData*/, TUint /*aNumChannels*/, TUint /*aSubsampleBytes*/) override {}
+    void ProcessSilence(const Brx& , TUint , TUint ) override { ASSERTS(); }
+    void EndBlock() override {}
+    void Flush() override {}
+};
+
+//////////////////////////////////////////////////////////////
+
+// Reports time taken to generate a ramp (training + rendering) for a range of sample rates
+// and channel counts, for each supported LpcKernels implementation and render mode.
+class FlywheelRamperBenchmark : public INonCopyable
+{
+    static const TUint kIterations = 100;
+public:
+    FlywheelRamperBenchmark(Environment& aEnv, TUint aGenMs, TUint aRampMs);
+    void Run();
+private:
+    TUint64 TimeRampUs(TUint aSampleRate, TUint aChannelCount, FlywheelRamperManager::Render aRender);
+private:
+    Environment& iEnv;
+    const TUint iGenJiffies;
+    const TUint iRampJiffies;
+    Bwh iInput;
+};
+
 //////////////////////////////////////////////////////////////
 
 class FormatConverter : public IWriter, public INonCopyable
@@ -613,6 +647,69 @@ void FormatConverter::WriteFlush()
 
 /////////////////////////////////////////////////////////////////
 
+FlywheelRamperBenchmark::FlywheelRamperBenchmark(Environment& aEnv, TUint aGenMs, TUint aRampMs)
+    :iEnv(aEnv)
+    ,iGenJiffies(aGenMs*Jiffies::kPerMs)
+    ,iRampJiffies(aRampMs*Jiffies::kPerMs)
+    ,iInput(FlywheelRamper::SampleCount(192000, aGenMs*Jiffies::kPerMs)*FlywheelRamper::kBytesPerSample*8)
+{
+    // low level noise; content doesn't affect timing
+    TUint32 noise = 1;
+    iInput.SetBytes(iInput.MaxBytes());
+    TByte* ptr = (TByte*)iInput.Ptr();
+    for (TUint i=0; i<iInput.Bytes(); i++) {
+        noise = noise*1664525 + 1013904223;
+        ptr[i] = (TByte)(noise>>24);
+    }
+}
+
+void FlywheelRamperBenchmark::Run()
+{
+    const TUint kSampleRates[] = { 44100, 48000, 96000, 192000 };
+    const TUint kChannelCounts[] = { 2, 6, 8 };
+    const LpcKernels::Impl kImpls[] = { LpcKernels::Impl::Scalar, LpcKernels::Impl::Sse2,
+                                        LpcKernels::Impl::Avx2, LpcKernels::Impl::Neon };
+    const LpcKernels::Impl initialImpl = LpcKernels::Current();
+
+    Log::Print("FlywheelRamper benchmark: input=%ums, ramp=%ums, average of %u ramps (us per ramp)\n",
+               iGenJiffies/Jiffies::kPerMs, iRampJiffies/Jiffies::kPerMs, kIterations);
+    Log::Print("%-8s %-16s %8s %8s %10s\n", "impl", "render", "rate", "channels", "us");
+    for (auto impl : kImpls) {
+        if (!LpcKernels::IsSupported(impl)) {
+            continue;
+        }
+        LpcKernels::Select(impl);
+        for (auto render : { FlywheelRamperManager::Render::PerChannel, FlywheelRamperManager::Render::ChannelParallel }) {
+            for (auto sampleRate : kSampleRates) {
+                for (auto channelCount : kChannelCounts) {
+                    const TUint64 us = TimeRampUs(sampleRate, channelCount, render);
+                    Log::Print("%-8s %-16s %8u %8u %10llu\n", LpcKernels::Name(impl),
+                               render == FlywheelRamperManager::Render::PerChannel? "PerChannel" : "ChannelParallel",
+                               sampleRate, channelCount, us);
+                }
+            }
+        }
+    }
+    LpcKernels::Select(initialImpl);
+}
+
+TUint64 FlywheelRamperBenchmark::TimeRampUs(TUint aSampleRate, TUint aChannelCount, FlywheelRamperManager::Render aRender)
+{
+    PcmProcessorNull output;
+    FlywheelRamperManager ramper(output, iGenJiffies, iRampJiffies, aRender);
+    const TUint inputBytes = FlywheelRamper::SampleCount(aSampleRate, iGenJiffies)*FlywheelRamper::kBytesPerSample*aChannelCount;
+    Brn input(iInput.Ptr(), inputBytes);
+
+    ramper.Ramp(input, aSampleRate, aChannelCount); // warm caches
+    const TUint64 start = Os::TimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<kIterations; i++) {
+        ramper.Ramp(input, aSampleRate, aChannelCount);
+    }
+    return (Os::TimeInUs(iEnv.OsCtx()) - start) / kIterations;
+}
+
+/////////////////////////////////////////////////////////////////
+
 PcmProcessorFwrMan::PcmProcessorFwrMan(Bwx& aBuf)
     :iBuf(aBuf)
 {
@@ -668,6 +765,8 @@ int CDECL main(int aArgc, TChar* aArgv[])
     OptionUint optionBlock("-b", "--block", 0, "index of single block to process (ramp will only be applied to a single block of the input file (defaults to multi block mode))");
     parser.AddOption(&optionBlock);
 
+    OptionBool optionBenchmark("-m", "--benchmark", "report ramp generation time per sample rate and channel count (no input file required)");
+    parser.AddOption(&optionBenchmark);
 
     if (!parser.Parse(args) || parser.HelpDisplayed()) {
         return(0);
@@ -677,6 +776,12 @@ int CDECL main(int aArgc, TChar* aArgv[])
     ASSERT(optionGenMs.Value()<1000);
     ASSERT(optionRampMs.Value()<1000);
 
+    if (optionBenchmark.Value()) {
+        FlywheelRamperBenchmark benchmark(lib.Env(), optionGenMs.Value(), optionRampMs.Value());
+        benchmark.Run();
+        return(0);
+    }
+
     auto test = new TestFWRManual(  optionInput.Value(),
                                     optionOutput.Value(),
                                     optionDegree.Value(),
@@ -3,6 +3,12 @@
 #include <OpenHome/Media/Pipeline/RampArray.h>
 #include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
 #include <OpenHome/Media/Utils/ProcessorAudioUtils.h>
+#include <OpenHome/Media/Utils/ByteSwap.h>
+#include <OpenHome/Media/Utils/PcmGain.h>
+#include <OpenHome/Media/Utils/PcmInterleave.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Net/Private/Globals.h>
 
 #include <string.h>
 #include <vector>
@@ -19,22 +25,132 @@ class SuiteAllocator : public Suite
 public:
     SuiteAllocator();
     void Test() override;
+private:
+    void Test(AllocatorMode aMode);
+private:
+    static const TUint kNumTestCells = 10;
+    AllocatorInfoLogger iInfoAggregator;
+};
+
+class SuiteAllocatorLazy : public Suite
+{
+public:
+    SuiteAllocatorLazy();
+    void Test() override;
+private:
+    void TestLazy(AllocatorMode aMode);
+    void TestReleaseIdle();
 private:
     static const TUint kNumTestCells = 10;
     AllocatorInfoLogger iInfoAggregator;
 };
 
+class TestCell;
+
+class SuiteAllocatorThroughput : public Suite
+{
+public:
+    SuiteAllocatorThroughput();
+    void Test() override;
+private:
+    void Run(AllocatorMode aMode, const TChar* aModeName);
+    void AllocateFreeThread();
+private:
+    static const TUint kNumThreads = 4;
+    static const TUint kNumCells = 512;
+    static const TUint kBatchSize = 16;
+    static const TUint kIterations = 20000;
+    AllocatorInfoLogger iInfoAggregator;
+    Allocator<TestCell>* iAllocator;
+    Semaphore iSemComplete;
+    std::atomic<TUint> iNextThreadIndex;
+    std::atomic<TUint> iCorruptCells;
+};
+
 class TestCell : public Allocated
 {
 public:
     TestCell(AllocatorBase& aAllocator);
     void Fill(TChar aVal);
     void CheckIsFilled(TChar aVal) const;
+    TBool IsFilled(TChar aVal) const;
 private:
     static const TUint kNumBytes = 10;
     TChar iBytes[kNumBytes];
 };
 
+class SuiteByteSwap : public Suite
+{
+    static const TUint kBenchmarkIterations = 20000;
+public:
+    SuiteByteSwap();
+    void Test() override;
+private:
+    typedef void (*ConvertFunc)(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    void TestMatchesScalar(ByteSwap::Impl aImpl, ConvertFunc aConvert, TUint aBytesPerSubsample);
+    void Benchmark(ByteSwap::Impl aImpl, ConvertFunc aConvert, TUint aBytesPerSubsample);
+private:
+    Bwh iSrc;
+    Bwh iExpected;
+    Bwh iDest;
+};
+
+class SuitePcmGain : public Suite
+{
+    static const TUint kBenchmarkIterations = 20000;
+public:
+    SuitePcmGain();
+    void Test() override;
+private:
+    void TestMatchesScalar(PcmGain::Impl aImpl, TUint aBitDepth);
+    void Benchmark(PcmGain::Impl aImpl, TUint aBitDepth);
+private:
+    Bwh iSrc;
+    Bwh iExpected;
+    Bwh iDest;
+    TUint iGains[DecodedAudio::kMaxBytes / 4];
+};
+
+class SuitePcmInterleave : public Suite
+{
+    static const TUint kMaxChannels = 8;
+    static const TUint kMaxSamples = 1152; // one MP3 frame
+    static const TUint kBenchmarkIterations = 5000;
+public:
+    SuitePcmInterleave();
+    void Test() override;
+private:
+    void TestMatchesReference(PcmInterleave::Impl aImpl, TUint aChannels, TUint aBitDepth);
+    void TestScaledClips(PcmInterleave::Impl aImpl);
+    void Benchmark(PcmInterleave::Impl aImpl, TUint aBitDepth);
+    TInt32 Expected(TInt32 aSubsample, TUint aBitDepth, TUint aShift) const;
+private:
+    std::vector<TInt32> iPlanes[kMaxChannels];
+    const TInt32* iPlanePtrs[kMaxChannels];
+    Bwh iDest;
+};
+
+class TestCellLarge : public Allocated
+{
+public:
+    static const TUint kNumBytes = 20 * 1024; // large enough that an allocator needs several slabs
+public:
+    TestCellLarge(AllocatorBase& aAllocator);
+private:
+    TByte iBytes[kNumBytes];
+};
+
+class PcmProcessorFragmentCount : public ProcessorPcmBufTest
+{
+public:
+    PcmProcessorFragmentCount();
+    TUint Fragments() const;
+private: // from IPcmProcessor
+    void ProcessFragment(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override;
+private:
+    TUint iFragments;
+};
+
 class SuiteMsgAudioEncoded : public Suite
 {
     static const TUint kMsgCount = 8;
@@ -306,6 +422,23 @@ private:
     AllocatorInfoLogger iInfoAggregator;
 };
 
+class SuiteMsgQueueSpsc : public Suite
+{
+    static const TUint kNumMsgs = 150; // spans several of MsgQueueSpsc's internal blocks
+public:
+    SuiteMsgQueueSpsc();
+    ~SuiteMsgQueueSpsc();
+    void Test() override;
+private:
+    void ProducerThread();
+private:
+    MsgFactory* iMsgFactory;
+    TrackFactory* iTrackFactory;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgQueueSpsc* iQueue;
+    std::vector<Msg*> iMsgs;
+};
+
 class SuiteMsgReservoir : public Suite
 {
     static const TUint kMsgCount = 8;
@@ -444,6 +577,44 @@ void TestCell::CheckIsFilled(TChar aVal) const
     }
 }
 
+TBool TestCell::IsFilled(TChar aVal) const
+{
+    for (TUint i=0; i<kNumBytes; i++) {
+        if (iBytes[i] != aVal) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// PcmProcessorFragmentCount
+
+PcmProcessorFragmentCount::PcmProcessorFragmentCount()
+    : iFragments(0)
+{
+}
+
+TUint PcmProcessorFragmentCount::Fragments() const
+{
+    return iFragments;
+}
+
+void PcmProcessorFragmentCount::ProcessFragment(const Brx& aData, TUint /*aNumChannels*/, TUint /*aSubsampleBytes*/)
+{
+    iFragments++;
+    ProcessorPcmBufTest::ProcessFragment(aData);
+}
+
+
+// TestCellLarge
+
+TestCellLarge::TestCellLarge(AllocatorBase& aAllocator)
+    : Allocated(aAllocator)
+{
+    memset(iBytes, 0, kNumBytes);
+}
+
 
 // SuiteAllocator
 
@@ -453,9 +624,15 @@ SuiteAllocator::SuiteAllocator()
 }
 
 void SuiteAllocator::Test()
+{
+    Test(AllocatorMode::Locked);
+    Test(AllocatorMode::LockFree);
+}
+
+void SuiteAllocator::Test(AllocatorMode aMode)
 {
     //Print("\nCreate Allocator with 10 TestCells.  Check that 10 TestCells can be allocated\n");
-    Allocator<TestCell>* allocator = new Allocator<TestCell>("TestCell", kNumTestCells, iInfoAggregator);
+    Allocator<TestCell>* allocator = new Allocator<TestCell>("TestCell", kNumTestCells, iInfoAggregator, aMode);
     TestCell* cells[kNumTestCells];
     for (TUint i=0; i<kNumTestCells; i++) {
         cells[i] = allocator->Allocate();
@@ -511,6 +688,440 @@ void SuiteAllocator::Test()
 }
 
 
+// SuiteAllocatorLazy
+
+SuiteAllocatorLazy::SuiteAllocatorLazy()
+    : Suite("Lazy allocator tests")
+{
+}
+
+void SuiteAllocatorLazy::Test()
+{
+    TestLazy(AllocatorMode::Locked);
+    TestLazy(AllocatorMode::LockFree);
+    TestReleaseIdle();
+}
+
+void SuiteAllocatorLazy::TestLazy(AllocatorMode aMode)
+{
+    auto allocator = new Allocator<TestCellLarge>("TestCellLarge", kNumTestCells, iInfoAggregator, aMode, AllocatorReserve::Lazy);
+    TEST(allocator->CellsReserved() == 0);
+    TestCellLarge* cells[kNumTestCells];
+    cells[0] = allocator->Allocate();
+    const TUint slabCells = allocator->CellsReserved();
+    TEST(slabCells > 0);
+    TEST(slabCells < kNumTestCells);
+    for (TUint i=1; i<kNumTestCells; i++) {
+        cells[i] = allocator->Allocate();
+        TEST(cells[i] != nullptr);
+        TEST(allocator->CellsReserved() <= kNumTestCells);
+    }
+    TEST(allocator->CellsReserved() == kNumTestCells);
+    TEST(allocator->CellsUsed() == kNumTestCells);
+    iInfoAggregator.PrintStats();
+
+    // Lazy pools grow but never shrink
+    for (TUint i=0; i<kNumTestCells; i++) {
+        cells[i]->RemoveRef();
+    }
+    TEST(allocator->CellsUsed() == 0);
+    TEST(allocator->CellsUsedMax() == kNumTestCells);
+    TEST(allocator->CellsReserved() == kNumTestCells);
+    delete allocator;
+}
+
+void SuiteAllocatorLazy::TestReleaseIdle()
+{
+    auto allocator = new Allocator<TestCellLarge>("TestCellLarge", kNumTestCells, iInfoAggregator, AllocatorMode::Locked, AllocatorReserve::LazyReleaseIdle);
+    TestCellLarge* cells[kNumTestCells];
+    for (TUint i=0; i<kNumTestCells; i++) {
+        cells[i] = allocator->Allocate();
+    }
+    TEST(allocator->CellsReserved() == kNumTestCells);
+
+    // idle slabs are released once all their cells are free, leaving (at least) one slab reserved
+    for (TUint i=0; i<kNumTestCells; i++) {
+        cells[i]->RemoveRef();
+    }
+    TEST(allocator->CellsUsed() == 0);
+    TEST(allocator->CellsReserved() > 0);
+    TEST(allocator->CellsReserved() < kNumTestCells);
+
+    // released slabs can be re-reserved
+    for (TUint i=0; i<kNumTestCells; i++) {
+        cells[i] = allocator->Allocate();
+        TEST(cells[i] != nullptr);
+    }
+    TEST(allocator->CellsReserved() == kNumTestCells);
+    for (TUint i=0; i<kNumTestCells; i++) {
+        cells[i]->RemoveRef();
+    }
+    delete allocator;
+}
+
+
+// SuiteAllocatorThroughput
+
+SuiteAllocatorThroughput::SuiteAllocatorThroughput()
+    : Suite("Allocator multi-threaded throughput")
+    , iAllocator(nullptr)
+    , iSemComplete("SATP", 0)
+    , iNextThreadIndex(0)
+    , iCorruptCells(0)
+{
+}
+
+void SuiteAllocatorThroughput::Test()
+{
+    Run(AllocatorMode::Locked, "Locked");
+    Run(AllocatorMode::LockFree, "LockFree");
+}
+
+void SuiteAllocatorThroughput::Run(AllocatorMode aMode, const TChar* aModeName)
+{
+    iAllocator = new Allocator<TestCell>("TestCell", kNumCells, iInfoAggregator, aMode);
+    iNextThreadIndex = 0;
+    iCorruptCells = 0;
+    std::vector<ThreadFunctor*> threads;
+    for (TUint i=0; i<kNumThreads; i++) {
+        threads.push_back(new ThreadFunctor("AllocTP", MakeFunctor(*this, &SuiteAllocatorThroughput::AllocateFreeThread)));
+    }
+    const TUint start = Os::TimeInMs(gEnv->OsCtx());
+    for (auto thread : threads) {
+        thread->Start();
+    }
+    for (TUint i=0; i<kNumThreads; i++) {
+        iSemComplete.Wait();
+    }
+    const TUint durationMs = Os::TimeInMs(gEnv->OsCtx()) - start;
+    for (auto thread : threads) {
+        delete thread;
+    }
+
+    TEST(iCorruptCells == 0);
+    TEST(iAllocator->CellsUsed() == 0);
+    TEST(iAllocator->CellsUsedMax() >= kBatchSize);
+    TEST(iAllocator->CellsUsedMax() <= kNumThreads * kBatchSize);
+    const TUint64 ops = (TUint64)kNumThreads * kIterations * kBatchSize * 2; // each cell is allocated then freed
+    Print("%s: %llu allocate/free ops from %u threads in %ums (%llu ops/ms), peak %u cells\n",
+          aModeName, ops, kNumThreads, durationMs, ops / (durationMs == 0? 1 : durationMs), iAllocator->CellsUsedMax());
+    delete iAllocator;
+    iAllocator = nullptr;
+}
+
+void SuiteAllocatorThroughput::AllocateFreeThread()
+{
+    const TChar fill = (TChar)iNextThreadIndex++;
+    TestCell* cells[kBatchSize];
+    for (TUint i=0; i<kIterations; i++) {
+        for (TUint j=0; j<kBatchSize; j++) {
+            cells[j] = iAllocator->Allocate();
+            cells[j]->Fill(fill);
+        }
+        for (TUint j=0; j<kBatchSize; j++) {
+            if (!cells[j]->IsFilled(fill)) { // another thread was handed the same cell
+                iCorruptCells++;
+            }
+            cells[j]->RemoveRef();
+        }
+    }
+    iSemComplete.Signal();
+}
+
+
+// SuiteByteSwap
+
+SuiteByteSwap::SuiteByteSwap()
+    : Suite("Little to big endian conversion")
+    , iSrc(DecodedAudio::kMaxBytes + 1)
+    , iExpected(DecodedAudio::kMaxBytes)
+    , iDest(DecodedAudio::kMaxBytes + 2)
+{
+    for (TUint i=0; i<iSrc.MaxBytes(); i++) {
+        iSrc.Append((TByte)((i * 97) + 13));
+    }
+}
+
+void SuiteByteSwap::Test()
+{
+    const ByteSwap::Impl initial = ByteSwap::Current();
+    const ByteSwap::Impl impls[] = { ByteSwap::Impl::Scalar, ByteSwap::Impl::Sse2, ByteSwap::Impl::Ssse3,
+                                     ByteSwap::Impl::Avx2, ByteSwap::Impl::Neon };
+    Print("Default implementation is %s\n", ByteSwap::Name(initial));
+    for (auto impl : impls) {
+        if (!ByteSwap::IsSupported(impl)) {
+            continue;
+        }
+        TestMatchesScalar(impl, ByteSwap::ToBigEndian16, 2);
+        TestMatchesScalar(impl, ByteSwap::ToBigEndian24, 3);
+        TestMatchesScalar(impl, ByteSwap::ToBigEndian32, 4);
+        Benchmark(impl, ByteSwap::ToBigEndian16, 2);
+        Benchmark(impl, ByteSwap::ToBigEndian24, 3);
+        Benchmark(impl, ByteSwap::ToBigEndian32, 4);
+    }
+    ByteSwap::Select(initial);
+}
+
+void SuiteByteSwap::TestMatchesScalar(ByteSwap::Impl aImpl, ConvertFunc aConvert, TUint aBytesPerSubsample)
+{
+    // odd offsets check unaligned access; every length up to a few vectors checks tail handling
+    const TByte* src = iSrc.Ptr() + 1;
+    TByte* dest = const_cast<TByte*>(iDest.Ptr()) + 1;
+    TByte* expected = const_cast<TByte*>(iExpected.Ptr());
+    const TUint maxSubsamples = DecodedAudio::kMaxBytes / aBytesPerSubsample;
+    for (TUint subsamples=0; subsamples<=maxSubsamples; subsamples += (subsamples < 80? 1 : 61)) {
+        const TUint bytes = subsamples * aBytesPerSubsample;
+        ByteSwap::Select(ByteSwap::Impl::Scalar);
+        aConvert(src, expected, bytes);
+        ByteSwap::Select(aImpl);
+        memset(dest, 0xff, bytes + 1);
+        aConvert(src, dest, bytes);
+        TEST(memcmp(dest, expected, bytes) == 0);
+        TEST(dest[bytes] == 0xff);
+    }
+    for (TUint i=0; i<aBytesPerSubsample; i++) {
+        TEST(expected[i] == src[aBytesPerSubsample - 1 - i]);
+    }
+}
+
+void SuiteByteSwap::Benchmark(ByteSwap::Impl aImpl, ConvertFunc aConvert, TUint aBytesPerSubsample)
+{
+    ByteSwap::Select(aImpl);
+    const TUint bytes = (DecodedAudio::kMaxBytes / aBytesPerSubsample) * aBytesPerSubsample;
+    TByte* dest = const_cast<TByte*>(iDest.Ptr());
+    const TUint64 start = Os::TimeInUs(gEnv->OsCtx());
+    for (TUint i=0; i<kBenchmarkIterations; i++) {
+        aConvert(iSrc.Ptr(), dest, bytes);
+    }
+    const TUint64 durationUs = Os::TimeInUs(gEnv->OsCtx()) - start;
+    const TUint64 totalBytes = (TUint64)bytes * kBenchmarkIterations;
+    Print("%6s %u-bit: %llu MB/s\n", ByteSwap::Name(aImpl), aBytesPerSubsample * 8,
+          totalBytes / (durationUs == 0? 1 : durationUs)); // bytes/us == MB/s
+}
+
+
+// SuitePcmGain
+
+SuitePcmGain::SuitePcmGain()
+    : Suite("PCM gain")
+    , iSrc(DecodedAudio::kMaxBytes + 1)
+    , iExpected(DecodedAudio::kMaxBytes)
+    , iDest(DecodedAudio::kMaxBytes + 2)
+{
+    for (TUint i=0; i<iSrc.MaxBytes(); i++) {
+        iSrc.Append((TByte)((i * 97) + 13));
+    }
+    const TUint numGains = sizeof(iGains) / sizeof(iGains[0]);
+    for (TUint i=0; i<numGains; i++) {
+        iGains[i] = PcmGain::kUnity - ((i * PcmGain::kUnity) / (numGains - 1));
+    }
+}
+
+void SuitePcmGain::Test()
+{
+    const PcmGain::Impl initial = PcmGain::Current();
+    const PcmGain::Impl impls[] = { PcmGain::Impl::Scalar, PcmGain::Impl::Sse2,
+                                    PcmGain::Impl::Avx2, PcmGain::Impl::Neon };
+    Print("Default implementation is %s\n", PcmGain::Name(initial));
+    for (auto impl : impls) {
+        if (!PcmGain::IsSupported(impl)) {
+            continue;
+        }
+        TestMatchesScalar(impl, 16);
+        TestMatchesScalar(impl, 32);
+        Benchmark(impl, 16);
+        Benchmark(impl, 32);
+    }
+    PcmGain::Select(initial);
+}
+
+void SuitePcmGain::TestMatchesScalar(PcmGain::Impl aImpl, TUint aBitDepth)
+{
+    // odd offsets check unaligned access; every length up to a few vectors checks tail handling
+    const TUint bytesPerSample = (aBitDepth / 8) * 2;
+    const TByte* src = iSrc.Ptr() + 1;
+    TByte* dest = const_cast<TByte*>(iDest.Ptr()) + 1;
+    TByte* expected = const_cast<TByte*>(iExpected.Ptr());
+    const TUint maxSamples = DecodedAudio::kMaxBytes / bytesPerSample;
+    const TUint gains[] = { 0, 1, PcmGain::kUnity / 3, PcmGain::kUnity - 1, PcmGain::kUnity };
+    for (TUint samples=0; samples<=maxSamples; samples += (samples < 80? 1 : 61)) {
+        const TUint bytes = samples * bytesPerSample;
+        for (auto gain : gains) {
+            PcmGain::Select(PcmGain::Impl::Scalar);
+            PcmGain::ApplyConstant(src, expected, samples * 2, aBitDepth, gain);
+            PcmGain::Select(aImpl);
+            memset(dest, 0xff, bytes + 1);
+            PcmGain::ApplyConstant(src, dest, samples * 2, aBitDepth, gain);
+            TEST(memcmp(dest, expected, bytes) == 0);
+            TEST(dest[bytes] == 0xff);
+        }
+        PcmGain::Select(PcmGain::Impl::Scalar);
+        PcmGain::Apply(src, expected, samples, aBitDepth, 2, iGains);
+        PcmGain::Select(aImpl);
+        memset(dest, 0xff, bytes + 1);
+        PcmGain::Apply(src, dest, samples, aBitDepth, 2, iGains);
+        TEST(memcmp(dest, expected, bytes) == 0);
+        TEST(dest[bytes] == 0xff);
+    }
+    // in place gives the same result as a separate destination
+    const TUint samples = maxSamples;
+    PcmGain::Apply(src, expected, samples, aBitDepth, 2, iGains);
+    memcpy(dest, src, samples * bytesPerSample);
+    PcmGain::Apply(dest, dest, samples, aBitDepth, 2, iGains);
+    TEST(memcmp(dest, expected, samples * bytesPerSample) == 0);
+}
+
+void SuitePcmGain::Benchmark(PcmGain::Impl aImpl, TUint aBitDepth)
+{
+    PcmGain::Select(aImpl);
+    const TUint bytesPerSample = (aBitDepth / 8) * 2;
+    const TUint samples = DecodedAudio::kMaxBytes / bytesPerSample;
+    const TUint bytes = samples * bytesPerSample;
+    TByte* dest = const_cast<TByte*>(iDest.Ptr());
+    const TUint64 start = Os::TimeInUs(gEnv->OsCtx());
+    for (TUint i=0; i<kBenchmarkIterations; i++) {
+        PcmGain::Apply(iSrc.Ptr(), dest, samples, aBitDepth, 2, iGains);
+    }
+    const TUint64 durationUs = Os::TimeInUs(gEnv->OsCtx()) - start;
+    const TUint64 totalBytes = (TUint64)bytes * kBenchmarkIterations;
+    Print("%6s %u-bit: %llu MB/s\n", PcmGain::Name(aImpl), aBitDepth,
+          totalBytes / (durationUs == 0? 1 : durationUs)); // bytes/us == MB/s
+}
+
+
+// SuitePcmInterleave
+
+SuitePcmInterleave::SuitePcmInterleave()
+    : Suite("Planar to interleaved PCM conversion")
+    , iDest(kMaxChannels * kMaxSamples * 4 + 1)
+{
+    for (TUint ch=0; ch<kMaxChannels; ch++) {
+        iPlanes[ch].resize(kMaxSamples);
+        for (TUint i=0; i<kMaxSamples; i++) {
+            iPlanes[ch][i] = (TInt32)(((i + 1) * 2654435761u) ^ (ch * 40503u));
+        }
+        iPlanePtrs[ch] = &iPlanes[ch][0];
+    }
+}
+
+void SuitePcmInterleave::Test()
+{
+    const PcmInterleave::Impl initial = PcmInterleave::Current();
+    const PcmInterleave::Impl impls[] = { PcmInterleave::Impl::Scalar, PcmInterleave::Impl::Ssse3,
+                                          PcmInterleave::Impl::Neon };
+    const TUint bitDepths[] = { 8, 16, 24, 32 };
+    Print("Default implementation is %s\n", PcmInterleave::Name(initial));
+    for (auto impl : impls) {
+        if (!PcmInterleave::IsSupported(impl)) {
+            continue;
+        }
+        for (TUint channels=1; channels<=kMaxChannels; channels++) {
+            for (auto bitDepth : bitDepths) {
+                TestMatchesReference(impl, channels, bitDepth);
+            }
+        }
+        TestScaledClips(impl);
+        Benchmark(impl, 16);
+        Benchmark(impl, 24);
+    }
+    PcmInterleave::Select(initial);
+}
+
+TInt32 SuitePcmInterleave::Expected(TInt32 aSubsample, TUint aBitDepth, TUint aShift) const
+{
+    // clip to the range that fits in aBitDepth after shifting
+    const TInt64 limit = (TInt64)1 << (aBitDepth + aShift - 1);
+    TInt64 val = aSubsample;
+    if (val >= limit) {
+        val = limit - 1;
+    }
+    else if (val < -limit) {
+        val = -limit;
+    }
+    return (TInt32)(val >> aShift);
+}
+
+void SuitePcmInterleave::TestMatchesReference(PcmInterleave::Impl aImpl, TUint aChannels, TUint aBitDepth)
+{
+    // every length up to a few vectors checks tail handling; odd start offsets check unaligned access
+    PcmInterleave::Select(aImpl);
+    const TUint bytes = aBitDepth / 8;
+    const TUint shift = 32 - aBitDepth;
+    TByte* dest = const_cast<TByte*>(iDest.Ptr());
+    for (TUint first=0; first<2; first++) {
+        for (TUint samples=0; samples<40; samples++) {
+            const TUint destBytes = samples * aChannels * bytes;
+            memset(dest, 0xff, destBytes + 1);
+            PcmInterleave::PackScaled(iPlanePtrs, first, samples, aChannels, shift, aBitDepth, dest);
+            TBool ok = (dest[destBytes] == 0xff);
+            const TByte* p = dest;
+            for (TUint i=first; i<first+samples; i++) {
+                for (TUint ch=0; ch<aChannels; ch++) {
+                    const TInt32 expected = Expected(iPlanes[ch][i], aBitDepth, shift);
+                    for (TUint b=0; b<bytes; b++) {
+                        ok = ok && (*p++ == (TByte)(expected >> (8 * (bytes - 1 - b))));
+                    }
+                }
+            }
+            TEST(ok);
+        }
+    }
+
+    // Pack() should write subsamples that already fit in aBitDepth unchanged
+    const TUint samples = 37;
+    std::vector<TInt32> planes[kMaxChannels];
+    const TInt32* planePtrs[kMaxChannels];
+    for (TUint ch=0; ch<aChannels; ch++) {
+        for (TUint i=0; i<samples; i++) {
+            planes[ch].push_back(iPlanes[ch][i] >> shift);
+        }
+        planePtrs[ch] = &planes[ch][0];
+    }
+    PcmInterleave::Pack(planePtrs, 0, samples, aChannels, aBitDepth, dest);
+    TBool ok = true;
+    const TByte* p = dest;
+    for (TUint i=0; i<samples; i++) {
+        for (TUint ch=0; ch<aChannels; ch++) {
+            for (TUint b=0; b<bytes; b++) {
+                ok = ok && (*p++ == (TByte)(planes[ch][i] >> (8 * (bytes - 1 - b))));
+            }
+        }
+    }
+    TEST(ok);
+}
+
+void SuitePcmInterleave::TestScaledClips(PcmInterleave::Impl aImpl)
+{
+    // libmad style fixed point (28 fractional bits) with values either side of +/-1.0
+    PcmInterleave::Select(aImpl);
+    const TInt32 kOne = 1 << 28;
+    const TInt32 mono[] = { kOne, kOne - 1, -kOne, -kOne - 1, kOne * 2, -kOne * 2, 0, 32, -32 };
+    const TUint samples = sizeof(mono) / sizeof(mono[0]);
+    const TInt32* planes[] = { mono };
+    TByte* dest = const_cast<TByte*>(iDest.Ptr());
+    PcmInterleave::PackScaled(planes, 0, samples, 1, 5, 24, dest);
+    const TUint32 expected[] = { 0x7fffff, 0x7fffff, 0x800000, 0x800000, 0x7fffff, 0x800000, 0, 1, 0xffffff };
+    for (TUint i=0; i<samples; i++) {
+        const TUint32 val = (dest[i*3] << 16) | (dest[i*3 + 1] << 8) | dest[i*3 + 2];
+        TEST(val == expected[i]);
+    }
+}
+
+void SuitePcmInterleave::Benchmark(PcmInterleave::Impl aImpl, TUint aBitDepth)
+{
+    PcmInterleave::Select(aImpl);
+    TByte* dest = const_cast<TByte*>(iDest.Ptr());
+    const TUint64 start = Os::TimeInUs(gEnv->OsCtx());
+    for (TUint i=0; i<kBenchmarkIterations; i++) {
+        PcmInterleave::PackScaled(iPlanePtrs, 0, kMaxSamples, 2, 32 - aBitDepth, aBitDepth, dest);
+    }
+    const TUint64 durationUs = Os::TimeInUs(gEnv->OsCtx()) - start;
+    const TUint64 totalSamples = (TUint64)kMaxSamples * kBenchmarkIterations;
+    Print("%6s stereo %u-bit: %llu samples/s\n", PcmInterleave::Name(aImpl), aBitDepth,
+          (totalSamples * 1000000) / (durationUs == 0? 1 : durationUs));
+}
+
+
 // SuiteMsgAudioEncoded
 
 SuiteMsgAudioEncoded::SuiteMsgAudioEncoded()
@@ -996,6 +1607,88 @@ void SuiteMsgAudio::Test()
         TInt16 expected = ((b << 8) + b) / 4;
         TEST(subsample == expected);
     }
+    {
+        const TUint64 bytesBefore = iMsgFactory->GainStats().Bytes();
+        const TByte b = 0x7f;
+        TByte sample[] = { b, b, b, b, b, b };
+        Brn sampleBuf(sample, sizeof sample);
+        auto pcm = iMsgFactory->CreateMsgAudioPcm(sampleBuf, 2, 44100, 24, AudioDataEndian::Little, Jiffies::kPerSecond);
+        pcm->SetAttenuation(MsgAudioPcm::kUnityAttenuation / 4);
+        playable = pcm->CreatePlayable();
+        playable->Read(pcmProcessor);
+        playable->RemoveRef();
+        ptr = pcmProcessor.Ptr();
+        const TUint subsample = (ptr[0] << 16) | (ptr[1] << 8) | ptr[2];
+        TEST(subsample == 0x7f7f7fu / 4);
+        TEST(subsample == (TUint)((ptr[3] << 16) | (ptr[4] << 8) | ptr[5]));
+        TEST(iMsgFactory->GainStats().Bytes() == bytesBefore + sizeof sample);
+    }
+    {
+        // attenuation of audio shared with another msg leaves the shared audio unchanged
+        const TByte b = 0x7f;
+        TByte sample[] = { b, b, b, b };
+        Brn sampleBuf(sample, sizeof sample);
+        auto pcm = iMsgFactory->CreateMsgAudioPcm(sampleBuf, 2, 44100, 16, AudioDataEndian::Little, Jiffies::kPerSecond);
+        pcm->SetAttenuation(MsgAudioPcm::kUnityAttenuation / 4);
+        MsgAudio* clone = pcm->Clone();
+        const TInt16 expected = ((b << 8) + b) / 4;
+        for (auto msg : { static_cast<MsgAudio*>(pcm), clone }) {
+            playable = msg->CreatePlayable();
+            playable->Read(pcmProcessor);
+            playable->RemoveRef();
+            ptr = pcmProcessor.Ptr();
+            TEST((TInt16)((ptr[0] << 8) + ptr[1]) == expected);
+            TEST((TInt16)((ptr[2] << 8) + ptr[3]) == expected);
+        }
+    }
+    {
+        // attenuation is applied alongside any ramp
+        const TUint kBytes = 24;
+        TByte pcmData[kBytes];
+        (void)memset(pcmData, 0x7f, kBytes);
+        Brn pcmBuf(pcmData, kBytes);
+        auto pcm = iMsgFactory->CreateMsgAudioPcm(pcmBuf, 2, 44100, 16, AudioDataEndian::Little, 0);
+        pcm->SetAttenuation(MsgAudioPcm::kUnityAttenuation / 2);
+        TUint remainingDuration = pcm->Jiffies() * 2;
+        MsgAudio* split = nullptr;
+        (void)pcm->SetRamp(Ramp::kMax, remainingDuration, Ramp::EDown, split);
+        TEST(split == nullptr);
+        playable = pcm->CreatePlayable();
+        playable->Read(pcmProcessor);
+        playable->RemoveRef();
+        ptr = pcmProcessor.Ptr();
+        TEST(pcmProcessor.Buf().Bytes() == kBytes);
+        const TUint first = (ptr[0] << 8) | ptr[1];
+        TEST(first == ((0x7f7fu * ((kRampArray[0] * (PcmGain::kUnity / 2)) >> PcmGain::kShift)) >> PcmGain::kShift));
+        const TUint last = (ptr[kBytes-2] << 8) | ptr[kBytes-1];
+        TEST(last < first);
+    }
+    {
+        // ramped msgs are passed on as a single fragment, even at the largest msg size.
+        // Audio shared with another msg is ramped into a copy, leaving the shared audio unchanged
+        const TUint kBytes = DecodedAudio::kMaxBytes - (DecodedAudio::kMaxBytes % 6);
+        Bws<DecodedAudio::kMaxBytes> pcmData(kBytes);
+        (void)memset(const_cast<TByte*>(pcmData.Ptr()), 0x7f, kBytes);
+        auto pcm = iMsgFactory->CreateMsgAudioPcm(pcmData, 2, 44100, 24, AudioDataEndian::Little, 0);
+        TUint remainingDuration = pcm->Jiffies();
+        MsgAudio* split = nullptr;
+        (void)pcm->SetRamp(Ramp::kMax, remainingDuration, Ramp::EDown, split);
+        TEST(split == nullptr);
+        MsgAudio* clone = pcm->Clone();
+        PcmProcessorFragmentCount processorShared;
+        playable = pcm->CreatePlayable();
+        playable->Read(processorShared);
+        playable->RemoveRef();
+        TEST(processorShared.Fragments() == 1);
+        TEST(processorShared.Buf().Bytes() == kBytes);
+        TEST(processorShared.Ptr()[kBytes-1] != 0x7f);
+        PcmProcessorFragmentCount processorInPlace;
+        playable = clone->CreatePlayable();
+        playable->Read(processorInPlace);
+        playable->RemoveRef();
+        TEST(processorInPlace.Fragments() == 1);
+        TEST(processorInPlace.Buf() == processorShared.Buf());
+    }
 
     // IPipelineBufferObserver
     BufferObserver bufferObserver;
@@ -1600,6 +2293,53 @@ void SuiteRamp::Test()
     endValGuess = (((TUint64)0x7f * kRampArray[384])>>15);
     TEST(endValGuess - sampleVal <= 0x02);
 
+    // Apply ramp [Max...Min] to a whole 16-bit buffer.  Check output matches per-sample ramping
+    const TUint kAudioDataSize16 = 768;
+    TByte audioData16[kAudioDataSize16];
+    for (TUint i=0; i<kAudioDataSize16; i++) {
+        audioData16[i] = (TByte)(0x80 + i);
+    }
+    Brn audioBuf16(audioData16, kAudioDataSize16);
+    TByte rampedData[kAudioDataSize16];
+    ramp.Reset();
+    TEST(!ramp.Set(Ramp::kMax, kAudioDataSize16, kAudioDataSize16, Ramp::EDown, split, splitPos));
+    numSamples = applicator.Apply(audioBuf16, rampedData, 16, 2);
+    TEST(numSamples == kAudioDataSize16 / 4);
+    (void)applicator.Start(audioBuf16, 16, 2);
+    for (TUint i=0; i<numSamples; i++) {
+        applicator.GetNextSample(sample);
+        TEST(memcmp(sample, &rampedData[i*4], 4) == 0);
+    }
+
+    // Apply ramp [Max...Min] to a whole 24-bit buffer.  Check full precision is retained
+    const TUint kAudioDataSize24 = 768;
+    TByte audioData24[kAudioDataSize24];
+    (void)memset(audioData24, 0x7f, kAudioDataSize24);
+    Brn audioBuf24(audioData24, kAudioDataSize24);
+    ramp.Reset();
+    TEST(!ramp.Set(Ramp::kMax, kAudioDataSize24, kAudioDataSize24, Ramp::EDown, split, splitPos));
+    numSamples = applicator.Apply(audioBuf24, rampedData, 24, 2);
+    TEST(numSamples == kAudioDataSize24 / 6);
+    prevSampleVal = 0x7f7f7f;
+    TBool lowByteSet = false;
+    for (TUint i=0; i<numSamples; i++) {
+        const TByte* p = &rampedData[i*6];
+        sampleVal = (p[0]<<16) | (p[1]<<8) | p[2];
+        if (i == 0) {
+            TEST(sampleVal == (TUint)(((TUint64)0x7f7f7f * kRampArray[0]) >> 15));
+        }
+        TEST(sampleVal == (TUint)((p[3]<<16) | (p[4]<<8) | p[5]));
+        TEST(prevSampleVal >= sampleVal);
+        lowByteSet = lowByteSet || (p[2] != 0);
+        prevSampleVal = sampleVal;
+    }
+    TEST(lowByteSet);
+    TEST(sampleVal == 0);
+
+    // Apply the same ramp in place.  Check output matches ramping into a separate buffer
+    TEST(applicator.Apply(audioBuf24, audioData24, 24, 2) == numSamples);
+    TEST(memcmp(audioData24, rampedData, kAudioDataSize24) == 0);
+
     // Create [50%...Min] ramp.  Add [Min...50%] ramp.  Check this splits into [Min...25%], [25%...Min]
     ramp.Reset();
     TEST(!ramp.Set(Ramp::kMax / 2, jiffies, jiffies, Ramp::EDown, split, splitPos));
@@ -3140,6 +3880,99 @@ void SuiteMsgQueueLite::Test()
 }
 
 
+// SuiteMsgQueueSpsc
+
+SuiteMsgQueueSpsc::SuiteMsgQueueSpsc()
+    : Suite("MsgQueueSpsc tests")
+    , iQueue(nullptr)
+{
+    MsgFactoryInitParams init;
+    init.SetMsgSilenceCount(kNumMsgs);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iTrackFactory = new TrackFactory(iInfoAggregator, 1);
+}
+
+SuiteMsgQueueSpsc::~SuiteMsgQueueSpsc()
+{
+    delete iMsgFactory;
+    delete iTrackFactory;
+}
+
+void SuiteMsgQueueSpsc::Test()
+{
+    iQueue = new MsgQueueSpsc();
+    ProcessorMsgType processor;
+
+    // queue is fifo, including across internal block boundaries
+    TEST(iQueue->IsEmpty());
+    for (TUint i=0; i<kNumMsgs; i++) {
+        TUint size = Jiffies::kPerMs;
+        Msg* msg = iMsgFactory->CreateMsgSilence(size, 44100, 8, 2);
+        iMsgs.push_back(msg);
+        iQueue->Enqueue(msg);
+    }
+    TEST(iQueue->NumMsgs() == kNumMsgs);
+    for (TUint i=0; i<kNumMsgs; i++) {
+        Msg* dequeued = iQueue->Dequeue();
+        TEST(dequeued == iMsgs[i]);
+        dequeued->RemoveRef();
+    }
+    TEST(iQueue->IsEmpty());
+    iMsgs.clear();
+
+    // EnqueueAtHead skips existing items
+    Msg* msg = iMsgFactory->CreateMsgMetaText(Brn("blah"));
+    iQueue->Enqueue(msg);
+    msg = iMsgFactory->CreateMsgHalt();
+    iQueue->Enqueue(msg);
+    msg = iMsgFactory->CreateMsgFlush(1);
+    iQueue->EnqueueAtHead(msg);
+    TEST(iQueue->NumMsgs() == 3);
+    Msg* dequeued = iQueue->Dequeue();
+    dequeued->Process(processor);
+    TEST(processor.LastMsgType() == ProcessorMsgType::EMsgFlush);
+    dequeued->RemoveRef();
+    dequeued = iQueue->Dequeue();
+    dequeued->Process(processor);
+    TEST(processor.LastMsgType() == ProcessorMsgType::EMsgMetaText);
+    dequeued->RemoveRef();
+    dequeued = iQueue->Dequeue();
+    dequeued->Process(processor);
+    TEST(processor.LastMsgType() == ProcessorMsgType::EMsgHalt);
+    dequeued->RemoveRef();
+    TEST(iQueue->IsEmpty());
+
+    // Dequeue blocks until the producer thread enqueues
+    ThreadFunctor* producer = new ThreadFunctor("SPSC", MakeFunctor(*this, &SuiteMsgQueueSpsc::ProducerThread));
+    producer->Start();
+    for (TUint i=0; i<kNumMsgs; i++) {
+        dequeued = iQueue->Dequeue();
+        dequeued->Process(processor);
+        TEST(processor.LastMsgType() == ProcessorMsgType::EMsgSilence);
+        dequeued->RemoveRef();
+    }
+    delete producer;
+    TEST(iQueue->IsEmpty());
+
+    // msgs still queued are released on destruction
+    iQueue->Enqueue(iMsgFactory->CreateMsgHalt());
+    delete iQueue;
+    iQueue = nullptr;
+}
+
+void SuiteMsgQueueSpsc::ProducerThread()
+{
+    Thread::Sleep(20); // give consumer a chance to block on an empty queue
+    for (TUint i=0; i<kNumMsgs; i++) {
+        TUint size = Jiffies::kPerMs;
+        iQueue->Enqueue(iMsgFactory->CreateMsgSilence(size, 44100, 8, 2));
+        if (i % 16 == 0) {
+            Thread::Sleep(1);
+        }
+    }
+}
+
+
 // SuiteMsgReservoir
 
 SuiteMsgReservoir::SuiteMsgReservoir()
@@ -3733,6 +4566,11 @@ void TestMsg()
 {
     Runner runner("Basic Msg tests\n");
     runner.Add(new SuiteAllocator());
+    runner.Add(new SuiteAllocatorLazy());
+    runner.Add(new SuiteAllocatorThroughput());
+    runner.Add(new SuiteByteSwap());
+    runner.Add(new SuitePcmGain());
+    runner.Add(new SuitePcmInterleave());
     runner.Add(new SuiteMsgAudioEncoded());
     runner.Add(new SuiteRamp());
     runner.Add(new SuiteMsgAudio());
@@ -3749,6 +4587,7 @@ void TestMsg()
     runner.Add(new SuiteMsgProcessor());
     runner.Add(new SuiteMsgQueue());
     runner.Add(new SuiteMsgQueueLite());
+    runner.Add(new SuiteMsgQueueSpsc());
     runner.Add(new SuiteMsgReservoir());
     runner.Add(new SuitePipelineElement());
     runner.Run();
@@ -0,0 +1,509 @@
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Json.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/File.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Pipeline.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Pipeline/MuterVolume.h>
+#include <OpenHome/Media/Pipeline/VolumeRamper.h>
+#include <OpenHome/Media/Codec/CodecController.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+
+#include <atomic>
+#include <ctime>
+#include <string.h>
+
+/*
+ * Pipeline throughput benchmark.
+ *
+ * Runs a full Pipeline (mandatory elements only) between a source that pushes encoded audio as fast
+ * as the encoded reservoir accepts it and a sink that discards every msg it pulls.  The codec copies
+ * encoded audio straight to pcm so the run measures the cost of moving msgs through pipeline elements.
+ *
+ * Runs once with element bypass disabled then once with it enabled (see PipelineInitParams::SetElementBypass)
+ * and writes msgs/s, audio jiffies/s, wall time and process CPU time for each as JSON (stdout or --out).
+ */
+
+namespace OpenHome {
+namespace Media {
+
+class BenchmarkSource : public Thread, private IStreamHandler
+{
+public:
+    BenchmarkSource(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream, TrackFactory& aTrackFactory);
+    ~BenchmarkSource();
+    void Exit();
+private: // from Thread
+    void Run() override;
+private: // from IStreamHandler
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+    TUint TryDiscard(TUint aJiffies) override;
+    TUint TryStop(TUint aStreamId) override;
+    void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+private:
+    MsgFactory& iMsgFactory;
+    IPipelineElementDownstream& iDownstream;
+    TrackFactory& iTrackFactory;
+    std::atomic<TBool> iQuit;
+};
+
+// Accepts all content and does a 1-1 translation between encoded and decoded audio
+class BenchmarkCodec : public Codec::CodecBase
+{
+    static const TUint kChannels = 2;
+    static const TUint kSampleRate = 44100;
+    static const TUint kBitDepth = 16;
+public:
+    BenchmarkCodec();
+private: // from CodecBase
+    void StreamInitialise() override;
+    TBool Recognise(const Codec::EncodedStreamInfo& aStreamInfo) override;
+    void Process() override;
+    TBool TrySeek(TUint aStreamId, TUint64 aSample) override;
+private:
+    Bws<DecodedAudio::kMaxBytes> iReadBuf;
+    TUint64 iTrackOffsetJiffies;
+    TBool iSentDecodedInfo;
+};
+
+class PipelineBenchmark : private IPipelineObserver
+                        , private IMsgProcessor
+                        , private IStreamPlayObserver
+                        , private ISeekRestreamer
+                        , private IUrlBlockWriter
+                        , private IPipelineAnimator
+                        , private IVolumeRamper
+                        , private INonCopyable
+{
+public:
+    PipelineBenchmark(Environment& aEnv, TUint aDurationMs);
+    void Run(TBool aElementBypass, WriterJsonArray& aWriter);
+private:
+    void Pull();
+private: // from IPipelineObserver
+    void NotifyPipelineState(EPipelineState aState) override;
+    void NotifyMode(const Brx& aMode, const ModeInfo& aInfo,
+                    const ModeTransportControls& aTransportControls) override;
+    void NotifyTrack(Track& aTrack, TBool aStartOfStream) override;
+    void NotifyMetaText(const Brx& aText) override;
+    void NotifyTime(TUint aSeconds) override;
+    void NotifyStreamInfo(const DecodedStreamInfo& aStreamInfo) override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgDelay* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgStreamSegment* aMsg) override;
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgMetaText* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgWait* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgBitRate* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgAudioDsd* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private: // from IStreamPlayObserver
+    void NotifyTrackFailed(TUint aTrackId) override;
+    void NotifyStreamPlayStatus(TUint aTrackId, TUint aStreamId, EStreamPlay aStatus) override;
+private: // from ISeekRestreamer
+    TUint SeekRestream(const Brx& aMode, TUint aTrackId) override;
+private: // from IUrlBlockWriter
+    TBool TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes) override;
+private: // from IPipelineAnimator
+    TUint PipelineAnimatorBufferJiffies() const override;
+    TUint PipelineAnimatorDelayJiffies(AudioFormat aFormat, TUint aSampleRate, TUint aBitDepth, TUint aNumChannels) const override;
+    TUint PipelineAnimatorDsdBlockSizeWords() const override;
+    TUint PipelineAnimatorMaxBitDepth() const override;
+    void PipelineAnimatorGetMaxSampleRates(TUint& aPcm, TUint& aDsd) const override;
+private: // from IVolumeRamper
+    void ApplyVolumeMultiplier(TUint aValue) override;
+private:
+    Environment& iEnv;
+    const TUint iDurationMs;
+    AllocatorInfoLogger iInfoAggregator;
+    VolumeRamperStub iVolumeMuter;
+    Pipeline* iPipeline;
+    TUint64 iMsgs;
+    TUint64 iPlayableMsgs;
+    TUint64 iPlayableJiffies;
+    TBool iPlayableSeen;
+    TBool iQuit;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+
+// BenchmarkSource
+
+BenchmarkSource::BenchmarkSource(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream, TrackFactory& aTrackFactory)
+    : Thread("TSRC")
+    , iMsgFactory(aMsgFactory)
+    , iDownstream(aDownstream)
+    , iTrackFactory(aTrackFactory)
+    , iQuit(false)
+{
+    Start();
+}
+
+BenchmarkSource::~BenchmarkSource()
+{
+    Join();
+}
+
+void BenchmarkSource::Exit()
+{
+    iQuit.store(true);
+}
+
+void BenchmarkSource::Run()
+{
+    TByte encodedAudioData[EncodedAudio::kMaxBytes];
+    (void)memset(encodedAudioData, 0x7f, sizeof(encodedAudioData));
+    Brn encodedAudioBuf(encodedAudioData, sizeof(encodedAudioData));
+
+    Track* track = iTrackFactory.CreateTrack(Brx::Empty(), Brx::Empty());
+    iDownstream.Push(iMsgFactory.CreateMsgTrack(*track));
+    track->RemoveRef();
+    iDownstream.Push(iMsgFactory.CreateMsgEncodedStream(Brx::Empty(), Brx::Empty(), 1LL<<32, 0, 1, false, false, Multiroom::Allowed, this));
+    // no delay between msgs - Push() blocks while the encoded reservoir is full
+    while (!iQuit.load()) {
+        iDownstream.Push(iMsgFactory.CreateMsgAudioEncoded(encodedAudioBuf));
+    }
+    iDownstream.Push(iMsgFactory.CreateMsgHalt());
+    iDownstream.Push(iMsgFactory.CreateMsgQuit());
+}
+
+EStreamPlay BenchmarkSource::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayYes;
+}
+
+TUint BenchmarkSource::TrySeek(TUint /*aStreamId*/, TUint64 /*aOffset*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+TUint BenchmarkSource::TryDiscard(TUint /*aJiffies*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+TUint BenchmarkSource::TryStop(TUint /*aStreamId*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+void BenchmarkSource::NotifyStarving(const Brx& /*aMode*/, TUint /*aStreamId*/, TBool /*aStarving*/)
+{
+}
+
+
+// BenchmarkCodec
+
+BenchmarkCodec::BenchmarkCodec()
+    : CodecBase("Benchmark")
+{
+}
+
+void BenchmarkCodec::StreamInitialise()
+{
+    iTrackOffsetJiffies = 0;
+    iSentDecodedInfo = false;
+}
+
+TBool BenchmarkCodec::Recognise(const EncodedStreamInfo& /*aStreamInfo*/)
+{
+    return true;
+}
+
+void BenchmarkCodec::Process()
+{
+    if (!iSentDecodedInfo) {
+        const TUint bitRate = kSampleRate * kBitDepth * kChannels;
+        iController->OutputDecodedStream(bitRate, kBitDepth, kSampleRate, kChannels, Brn("benchmark"), 1LL<<34, 0, true, SpeakerProfile(kChannels));
+        iSentDecodedInfo = true;
+    }
+    else {
+        // No exit condition required.  iController->Read will throw when the stream ends.
+        iReadBuf.SetBytes(0);
+        iController->Read(iReadBuf, iReadBuf.MaxBytes());
+        iTrackOffsetJiffies += iController->OutputAudioPcm(iReadBuf, kChannels, kSampleRate, kBitDepth, AudioDataEndian::Little, iTrackOffsetJiffies);
+    }
+}
+
+TBool BenchmarkCodec::TrySeek(TUint /*aStreamId*/, TUint64 /*aSample*/)
+{
+    return false;
+}
+
+
+// PipelineBenchmark
+
+PipelineBenchmark::PipelineBenchmark(Environment& aEnv, TUint aDurationMs)
+    : iEnv(aEnv)
+    , iDurationMs(aDurationMs)
+    , iPipeline(nullptr)
+{
+}
+
+void PipelineBenchmark::Run(TBool aElementBypass, WriterJsonArray& aWriter)
+{
+    Log::Print("PipelineBenchmark: element bypass %s\n", aElementBypass? "on" : "off");
+
+    auto initParams = PipelineInitParams::New();
+    initParams->SetSupportElements(EPipelineSupportElementsMandatory); // loggers and validators would dominate the results
+    initParams->SetElementBypass(aElementBypass);
+    auto trackFactory = new TrackFactory(iInfoAggregator, 1);
+    iPipeline = new Pipeline(initParams, iInfoAggregator, *trackFactory, *this, *this, *this, *this);
+    iPipeline->SetAnimator(*this);
+    iPipeline->AddCodec(new BenchmarkCodec());
+    iPipeline->Start(*this, iVolumeMuter);
+    auto source = new BenchmarkSource(iPipeline->Factory(), *iPipeline, *trackFactory);
+    iPipeline->Play();
+
+    // don't start timing until audio has made it all the way through the pipeline
+    iMsgs = iPlayableMsgs = iPlayableJiffies = 0;
+    iPlayableSeen = false;
+    iQuit = false;
+    while (!iPlayableSeen) {
+        Pull();
+    }
+
+    iMsgs = iPlayableMsgs = iPlayableJiffies = 0;
+    const TUint64 durationUs = (TUint64)iDurationMs * 1000;
+    const TUint64 wallStart = Os::TimeInUs(iEnv.OsCtx());
+    const std::clock_t cpuStart = std::clock();
+    TUint64 wallUs;
+    do {
+        // amortise the cost of reading the clock
+        for (TUint i=0; i<64; i++) {
+            Pull();
+        }
+        wallUs = Os::TimeInUs(iEnv.OsCtx()) - wallStart;
+    } while (wallUs < durationUs);
+    const TUint64 cpuUs = ((TUint64)(std::clock() - cpuStart) * 1000000) / CLOCKS_PER_SEC;
+    const TUint64 msgs = iMsgs;
+    const TUint64 playableMsgs = iPlayableMsgs;
+    const TUint64 playableJiffies = iPlayableJiffies;
+
+    source->Exit();
+    iPipeline->Quit();
+    while (!iQuit) {
+        Pull();
+    }
+    delete source;
+    delete iPipeline;
+    iPipeline = nullptr;
+    delete trackFactory;
+
+    const TUint64 us = (wallUs == 0? 1 : wallUs);
+    auto writer = aWriter.CreateObject();
+    writer.WriteBool("elementBypass", aElementBypass);
+    writer.WriteUint("msgs", (TUint)msgs);
+    writer.WriteUint("playableMsgs", (TUint)playableMsgs);
+    writer.WriteUint("wallUs", (TUint)wallUs);
+    writer.WriteUint("cpuUs", (TUint)cpuUs);
+    writer.WriteUint("msgsPerSecond", (TUint)((msgs * 1000000) / us));
+    writer.WriteUint("playableMsgsPerSecond", (TUint)((playableMsgs * 1000000) / us));
+    writer.WriteUint("realtimeFactor", (TUint)((playableJiffies * 1000000) / (us * Jiffies::kPerSecond)));
+    writer.WriteEnd();
+    Log::Print("    %llu msgs, wall: %llums, cpu: %llums, %llu msgs/s\n",
+               msgs, wallUs / 1000, cpuUs / 1000, (msgs * 1000000) / us);
+}
+
+void PipelineBenchmark::Pull()
+{
+    Msg* msg = iPipeline->Pull();
+    iMsgs++;
+    msg = msg->Process(*this);
+    if (msg != nullptr) {
+        msg->RemoveRef();
+    }
+}
+
+void PipelineBenchmark::NotifyPipelineState(EPipelineState /*aState*/)
+{
+}
+
+void PipelineBenchmark::NotifyMode(const Brx& /*aMode*/, const ModeInfo& /*aInfo*/,
+                                   const ModeTransportControls& /*aTransportControls*/)
+{
+}
+
+void PipelineBenchmark::NotifyTrack(Track& /*aTrack*/, TBool /*aStartOfStream*/)
+{
+}
+
+void PipelineBenchmark::NotifyMetaText(const Brx& /*aText*/)
+{
+}
+
+void PipelineBenchmark::NotifyTime(TUint /*aSeconds*/)
+{
+}
+
+void PipelineBenchmark::NotifyStreamInfo(const DecodedStreamInfo& /*aStreamInfo*/)
+{
+}
+
+Msg* PipelineBenchmark::ProcessMsg(MsgMode* aMsg)               { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgTrack* aMsg)              { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgDelay* aMsg)              { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgEncodedStream* aMsg)      { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgStreamSegment* aMsg)      { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgAudioEncoded* aMsg)       { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgMetaText* aMsg)           { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgStreamInterrupted* aMsg)  { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgFlush* aMsg)              { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgWait* aMsg)               { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgDecodedStream* aMsg)      { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgBitRate* aMsg)            { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgAudioPcm* aMsg)           { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgAudioDsd* aMsg)           { return aMsg; }
+Msg* PipelineBenchmark::ProcessMsg(MsgSilence* aMsg)            { return aMsg; }
+
+Msg* PipelineBenchmark::ProcessMsg(MsgDrain* aMsg)
+{
+    aMsg->ReportDrained();
+    return aMsg;
+}
+
+Msg* PipelineBenchmark::ProcessMsg(MsgHalt* aMsg)
+{
+    aMsg->ReportHalted();
+    return aMsg;
+}
+
+Msg* PipelineBenchmark::ProcessMsg(MsgPlayable* aMsg)
+{
+    iPlayableSeen = true;
+    iPlayableMsgs++;
+    iPlayableJiffies += aMsg->Jiffies();
+    return aMsg;
+}
+
+Msg* PipelineBenchmark::ProcessMsg(MsgQuit* aMsg)
+{
+    iQuit = true;
+    return aMsg;
+}
+
+void PipelineBenchmark::NotifyTrackFailed(TUint /*aTrackId*/)
+{
+}
+
+void PipelineBenchmark::NotifyStreamPlayStatus(TUint /*aTrackId*/, TUint /*aStreamId*/, EStreamPlay /*aStatus*/)
+{
+}
+
+TUint PipelineBenchmark::SeekRestream(const Brx& /*aMode*/, TUint /*aTrackId*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+TBool PipelineBenchmark::TryGet(IWriter& /*aWriter*/, const Brx& /*aUrl*/, TUint64 /*aOffset*/, TUint /*aBytes*/)
+{
+    return false;
+}
+
+TUint PipelineBenchmark::PipelineAnimatorBufferJiffies() const
+{
+    return 0;
+}
+
+TUint PipelineBenchmark::PipelineAnimatorDelayJiffies(AudioFormat /*aFormat*/, TUint /*aSampleRate*/, TUint /*aBitDepth*/, TUint /*aNumChannels*/) const
+{
+    return 0;
+}
+
+TUint PipelineBenchmark::PipelineAnimatorDsdBlockSizeWords() const
+{
+    return 1;
+}
+
+TUint PipelineBenchmark::PipelineAnimatorMaxBitDepth() const
+{
+    return 24;
+}
+
+void PipelineBenchmark::PipelineAnimatorGetMaxSampleRates(TUint& aPcm, TUint& aDsd) const
+{
+    aPcm = 192000;
+    aDsd = 5644800;
+}
+
+void PipelineBenchmark::ApplyVolumeMultiplier(TUint /*aValue*/)
+{
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    OptionParser parser;
+    OptionUint optionDuration("-d", "--duration", 5, "seconds to pull msgs for in each run");
+    parser.AddOption(&optionDuration);
+    OptionString optionOut("-o", "--out", Brn(""), "file to write JSON results to (default: stdout)");
+    parser.AddOption(&optionOut);
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        return;
+    }
+    if (optionDuration.Value() == 0) {
+        Log::Print("Error: --duration must be at least 1\n");
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    WriterBwh json(1024);
+    {
+        PipelineBenchmark benchmark(lib->Env(), optionDuration.Value() * 1000);
+        WriterJsonObject writer(json);
+        auto results = writer.CreateArray("runs", WriterJsonArray::WriteOnEmpty::eEmptyArray);
+        benchmark.Run(false, results);
+        benchmark.Run(true, results);
+        results.WriteEnd();
+        writer.WriteEnd();
+    }
+    json.Write('\n');
+
+    if (optionOut.Value().Bytes() == 0) {
+        Log::Print(json.Buffer());
+    }
+    else {
+        Bwh filename(optionOut.Value().Bytes() + 1);
+        filename.Replace(optionOut.Value());
+        try {
+            IFile* file = new FileAnsi(filename.PtrZ(), eFileReadWrite);
+            file->Write(json.Buffer());
+            delete file;
+        }
+        catch (FileOpenError&) {
+            Log::Print("Error: failed to open output file <");
+            Log::Print(optionOut.Value());
+            Log::Print(">\n");
+        }
+    }
+
+    delete lib;
+}
@@ -129,6 +129,11 @@ void SuitePipelineConfig::Test()
         RunTest(initParams);
     }
 
+    auto initParamsNoBypass = PipelineInitParams::New();
+    initParamsNoBypass->SetSupportElements(EPipelineSupportElementsMandatory);
+    initParamsNoBypass->SetElementBypass(false);
+    RunTest(initParamsNoBypass);
+
     auto initParams = PipelineInitParams::New();
     if (initParams->Muter() == PipelineInitParams::MuterImpl::eRampSamples) {
         initParams->SetMuter(PipelineInitParams::MuterImpl::eRampVolume);
@@ -0,0 +1,470 @@
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Functor.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/SocketSsl.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/PipelineManager.h>
+#include <OpenHome/Media/PipelineObserver.h>
+#include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Media/UriProviderSingleTrack.h>
+#include <OpenHome/Media/UriProviderRepeater.h>
+#include <OpenHome/Media/Pipeline/Pipeline.h>
+#include <OpenHome/Media/Pipeline/MuterVolume.h>
+#include <OpenHome/Media/Pipeline/VolumeRamper.h>
+#include <OpenHome/Media/Codec/CodecFactory.h>
+#include <OpenHome/Media/Codec/ContainerFactory.h>
+#include <OpenHome/Media/Protocol/ProtocolFactory.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Media/Utils/AnimatorFile.h>
+
+#include <ctime>
+#include <stdio.h>
+
+/*
+ * Headless pipeline soak test / throughput benchmark.
+ *
+ * Plays a uri (file path or http:// uri) through a complete PipelineManager - Protocol, Filler,
+ * every Container/Codec and all pipeline elements through to PreDriver - with AnimatorFile writing
+ * the output to a wav or raw pcm file, a FIFO or stdout.  No audio hardware is required.
+ *
+ * Without --loop, the track plays once and the output can be compared against a reference file
+ * for bit-exact regression testing.  --loop repeats the track until --duration expires for soak
+ * testing.  --free-run pulls audio as fast as the pipeline can produce it; the reported
+ * realtimeFactor then measures maximum throughput of the whole chain.
+ */
+
+namespace OpenHome {
+namespace Media {
+
+// Writes to a stdio stream.  Throws WriterError on failure.
+class SinkStdio : public IWriter, private INonCopyable
+{
+public:
+    SinkStdio(FILE* aFile);
+    ~SinkStdio();
+    TBool TryRewriteWavHeader(TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint64 aDataBytes); // fails for pipes
+public: // from IWriter
+    void Write(TByte aValue) override;
+    void Write(const Brx& aBuffer) override;
+    void WriteFlush() override;
+private:
+    FILE* iFile;
+};
+
+class PipelineSoak : private IPipelineObserver
+                   , private IVolumeRamper
+                   , private INonCopyable
+{
+    static const TChar* kMode;
+public:
+    PipelineSoak(Environment& aEnv, IWriter& aSink, AnimatorFile::Format aFormat, AnimatorFile::Pacing aPacing, TBool aLoop,
+                 ThreadSchedPolicy aSchedPolicy, TUint64 aCpuMask);
+    ~PipelineSoak();
+    void Run(const Brx& aUri, TUint aDurationSecs);
+    void Quit(); // returns once all audio has been written to the sink
+    const AnimatorFile& Animator() const;
+    TUint64 WallUs() const;
+    TUint64 CpuUs() const;
+    TBool Failed() const;
+private: // from IPipelineObserver
+    void NotifyPipelineState(EPipelineState aState) override;
+    void NotifyMode(const Brx& aMode, const ModeInfo& aInfo,
+                    const ModeTransportControls& aTransportControls) override;
+    void NotifyTrack(Track& aTrack, TBool aStartOfStream) override;
+    void NotifyMetaText(const Brx& aText) override;
+    void NotifyTime(TUint aSeconds) override;
+    void NotifyStreamInfo(const DecodedStreamInfo& aStreamInfo) override;
+private: // from IVolumeRamper
+    void ApplyVolumeMultiplier(TUint aValue) override;
+private:
+    Environment& iEnv;
+    const TBool iLoop;
+    AllocatorInfoLogger iInfoAggregator;
+    TrackFactory* iTrackFactory;
+    SslContext* iSsl;
+    MimeTypeList iMimeTypes;
+    VolumeRamperStub iVolumeMuter;
+    PipelineManager* iPipeline;
+    UriProviderSingleTrack* iUriProviderSingle;
+    UriProviderRepeater* iUriProviderRepeater;
+    AnimatorFile* iAnimator;
+    Semaphore iSemStopped;
+    TBool iPlaying;
+    TUint64 iWallUs;
+    TUint64 iCpuUs;
+    TBool iQuit;
+};
+
+// Routes Log output to stderr so that it can't corrupt audio written to stdout.
+class LogRedirectStderr : private INonCopyable
+{
+public:
+    LogRedirectStderr();
+    ~LogRedirectStderr();
+private:
+    void Log(const TChar* aMsg);
+private:
+    FunctorMsg iDownstream;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+
+// SinkStdio
+
+SinkStdio::SinkStdio(FILE* aFile)
+    : iFile(aFile)
+{
+}
+
+SinkStdio::~SinkStdio()
+{
+    if (iFile != stdout) {
+        (void)fclose(iFile);
+    }
+}
+
+TBool SinkStdio::TryRewriteWavHeader(TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint64 aDataBytes)
+{
+    if (iFile == stdout || fseek(iFile, 0, SEEK_SET) != 0) {
+        return false;
+    }
+    const TUint dataBytes = (aDataBytes > 0xffffffff? 0xffffffff : (TUint)aDataBytes);
+    AnimatorFile::WriteWavHeader(*this, aSampleRate, aNumChannels, aBitDepth, dataBytes);
+    WriteFlush();
+    (void)fseek(iFile, 0, SEEK_END);
+    return true;
+}
+
+void SinkStdio::Write(TByte aValue)
+{
+    if (fputc(aValue, iFile) == EOF) {
+        THROW(WriterError);
+    }
+}
+
+void SinkStdio::Write(const Brx& aBuffer)
+{
+    if (aBuffer.Bytes() > 0 && fwrite(aBuffer.Ptr(), 1, aBuffer.Bytes(), iFile) != aBuffer.Bytes()) {
+        THROW(WriterError);
+    }
+}
+
+void SinkStdio::WriteFlush()
+{
+    if (fflush(iFile) != 0) {
+        THROW(WriterError);
+    }
+}
+
+
+// PipelineSoak
+
+const TChar* PipelineSoak::kMode = "Soak";
+
+PipelineSoak::PipelineSoak(Environment& aEnv, IWriter& aSink, AnimatorFile::Format aFormat, AnimatorFile::Pacing aPacing, TBool aLoop,
+                           ThreadSchedPolicy aSchedPolicy, TUint64 aCpuMask)
+    : iEnv(aEnv)
+    , iLoop(aLoop)
+    , iUriProviderSingle(nullptr)
+    , iUriProviderRepeater(nullptr)
+    , iSemStopped("SOAK", 0)
+    , iPlaying(false)
+    , iWallUs(0)
+    , iCpuUs(0)
+    , iQuit(false)
+{
+    iTrackFactory = new TrackFactory(iInfoAggregator, 5);
+    iSsl = new SslContext();
+    auto initParams = PipelineInitParams::New();
+    initParams->SetSupportElements(EPipelineSupportElementsMandatory | EPipelineSupportElementsValidatorMinimal);
+    initParams->SetThreadSchedPolicy(aSchedPolicy);
+    for (TUint i=0; i<ThreadScheduler::kNumThreads; i++) {
+        initParams->SetThreadCpuMask((PipelineThread)i, aCpuMask);
+    }
+    iPipeline = new PipelineManager(initParams, iInfoAggregator, *iTrackFactory);
+    iPipeline->AddObserver(static_cast<IPipelineObserver&>(*this));
+
+    iPipeline->Add(ContainerFactory::NewId3v2());
+    iPipeline->Add(ContainerFactory::NewMpeg4(iMimeTypes));
+    iPipeline->Add(ContainerFactory::NewMpegTs(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewFlac(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewWav(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewAiff(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewAifc(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewAacFdkMp4(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewAacFdkAdts(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewAlacApple(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewMp3(iMimeTypes));
+    iPipeline->Add(CodecFactory::NewVorbis(iMimeTypes));
+    iPipeline->Add(ProtocolFactory::NewHttp(aEnv, *iSsl, Brx::Empty()));
+    iPipeline->Add(ProtocolFactory::NewHttp(aEnv, *iSsl, Brx::Empty())); // second instance allows out-of-band reads
+    iPipeline->Add(ProtocolFactory::NewFile(aEnv));
+    if (iLoop) {
+        iUriProviderRepeater = new UriProviderRepeater(kMode, false, *iTrackFactory);
+        iPipeline->AddObserver(static_cast<ITrackObserver&>(*iUriProviderRepeater));
+        iPipeline->Add(iUriProviderRepeater);
+    }
+    else {
+        iUriProviderSingle = new UriProviderSingleTrack(kMode, false, false, *iTrackFactory);
+        iPipeline->Add(iUriProviderSingle);
+    }
+    iAnimator = new AnimatorFile(aEnv, *iPipeline, aSink, aFormat, aPacing, false);
+    iPipeline->Start(*this, iVolumeMuter);
+}
+
+PipelineSoak::~PipelineSoak()
+{
+    Quit();
+    delete iAnimator;
+    delete iPipeline;
+    delete iSsl;
+    delete iTrackFactory;
+}
+
+void PipelineSoak::Run(const Brx& aUri, TUint aDurationSecs)
+{
+    Track* track = (iLoop? iUriProviderRepeater->SetTrack(aUri, Brx::Empty())
+                         : iUriProviderSingle->SetTrack(aUri, Brx::Empty()));
+    if (track == nullptr) {
+        Log::Print("PipelineSoak: failed to create track for ");
+        Log::Print(aUri);
+        Log::Print("\n");
+        return;
+    }
+    const TUint trackId = track->Id();
+    track->RemoveRef();
+
+    const TUint64 wallStart = Os::TimeInUs(iEnv.OsCtx());
+    const std::clock_t cpuStart = std::clock();
+    iPipeline->Begin(Brn(kMode), trackId);
+    iPipeline->Play();
+    if (aDurationSecs == 0) {
+        iSemStopped.Wait();
+    }
+    else {
+        try {
+            iSemStopped.Wait(aDurationSecs * 1000);
+        }
+        catch (Timeout&) {}
+        iPipeline->Stop();
+    }
+    iWallUs = Os::TimeInUs(iEnv.OsCtx()) - wallStart;
+    iCpuUs = ((TUint64)(std::clock() - cpuStart) * 1000000) / CLOCKS_PER_SEC;
+}
+
+void PipelineSoak::Quit()
+{
+    if (!iQuit) {
+        iQuit = true;
+        iPipeline->Quit();
+        iAnimator->WaitForQuit();
+    }
+}
+
+const AnimatorFile& PipelineSoak::Animator() const
+{
+    return *iAnimator;
+}
+
+TUint64 PipelineSoak::WallUs() const
+{
+    return iWallUs;
+}
+
+TUint64 PipelineSoak::CpuUs() const
+{
+    return iCpuUs;
+}
+
+TBool PipelineSoak::Failed() const
+{
+    return iAnimator->SinkFailed() || iAnimator->AudioJiffies() == 0;
+}
+
+void PipelineSoak::NotifyPipelineState(EPipelineState aState)
+{
+    if (aState == EPipelinePlaying) {
+        iPlaying = true;
+    }
+    else if (aState == EPipelineStopped && iPlaying) {
+        iPlaying = false;
+        iSemStopped.Signal();
+    }
+}
+
+void PipelineSoak::NotifyMode(const Brx& /*aMode*/, const ModeInfo& /*aInfo*/,
+                              const ModeTransportControls& /*aTransportControls*/)
+{
+}
+
+void PipelineSoak::NotifyTrack(Track& aTrack, TBool /*aStartOfStream*/)
+{
+    Log::Print("PipelineSoak: track ");
+    Log::Print(aTrack.Uri());
+    Log::Print("\n");
+}
+
+void PipelineSoak::NotifyMetaText(const Brx& /*aText*/)
+{
+}
+
+void PipelineSoak::NotifyTime(TUint /*aSeconds*/)
+{
+}
+
+void PipelineSoak::NotifyStreamInfo(const DecodedStreamInfo& aStreamInfo)
+{
+    Log::Print("PipelineSoak: stream %u/%u/%u %s\n", aStreamInfo.SampleRate(), aStreamInfo.BitDepth(),
+               aStreamInfo.NumChannels(), aStreamInfo.Format() == AudioFormat::Dsd? "dsd" : "pcm");
+}
+
+void PipelineSoak::ApplyVolumeMultiplier(TUint /*aValue*/)
+{
+}
+
+
+
+// LogRedirectStderr
+
+LogRedirectStderr::LogRedirectStderr()
+{
+    FunctorMsg functor = MakeFunctorMsg(*this, &LogRedirectStderr::Log);
+    iDownstream = Log::SwapOutput(functor);
+}
+
+LogRedirectStderr::~LogRedirectStderr()
+{
+    (void)Log::SwapOutput(iDownstream);
+}
+
+void LogRedirectStderr::Log(const TChar* aMsg)
+{
+    (void)fputs(aMsg, stderr);
+}
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    OptionParser parser;
+    OptionString optionUri("-u", "--uri", Brn(""), "file path or http:// uri to play");
+    parser.AddOption(&optionUri);
+    OptionString optionOut("-o", "--out", Brn("-"), "file or FIFO to write audio to ('-' for stdout)");
+    parser.AddOption(&optionOut);
+    OptionString optionFormat("-f", "--format", Brn("wav"), "output format: wav or raw (packed big endian)");
+    parser.AddOption(&optionFormat);
+    OptionBool optionFreeRun("-r", "--free-run", "pull audio as fast as possible rather than in real time");
+    parser.AddOption(&optionFreeRun);
+    OptionBool optionLoop("-l", "--loop", "repeat the track until --duration expires");
+    parser.AddOption(&optionLoop);
+    OptionUint optionDuration("-d", "--duration", 0, "seconds to play for (0 => until the track ends)");
+    parser.AddOption(&optionDuration);
+    OptionString optionSchedPolicy("", "--sched-policy", Brn("default"), "host scheduling for pipeline threads: default, fifo or rr (Linux only)");
+    parser.AddOption(&optionSchedPolicy);
+    OptionString optionCpus("", "--cpus", Brn("any"), "cpus pipeline threads may run on, e.g. 2-3 (Linux only)");
+    parser.AddOption(&optionCpus);
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        return;
+    }
+    if (optionUri.Value().Bytes() == 0) {
+        Log::Print("Error: --uri is required\n");
+        return;
+    }
+    if (optionLoop.Value() && optionDuration.Value() == 0) {
+        Log::Print("Error: --loop requires --duration\n");
+        return;
+    }
+    AnimatorFile::Format format;
+    if (optionFormat.Value() == Brn("wav")) {
+        format = AnimatorFile::Format::Wav;
+    }
+    else if (optionFormat.Value() == Brn("raw")) {
+        format = AnimatorFile::Format::Raw;
+    }
+    else {
+        Log::Print("Error: --format must be wav or raw\n");
+        return;
+    }
+    ThreadSchedPolicy schedPolicy;
+    if (!ThreadScheduler::TryParsePolicy(optionSchedPolicy.Value(), schedPolicy)) {
+        Log::Print("Error: --sched-policy must be default, fifo or rr\n");
+        return;
+    }
+    TUint64 cpuMask;
+    if (!ThreadScheduler::TryParseCpuMask(optionCpus.Value(), cpuMask)) {
+        Log::Print("Error: --cpus must be 'any' or a list of cpus, e.g. 0,2-3\n");
+        return;
+    }
+
+    FILE* out = stdout;
+    const TBool toStdout = (optionOut.Value() == Brn("-"));
+    LogRedirectStderr* logRedirect = nullptr;
+    if (toStdout) {
+        logRedirect = new LogRedirectStderr();
+    }
+    else {
+        Bwh filename(optionOut.Value().Bytes() + 1);
+        filename.Replace(optionOut.Value());
+        out = fopen(filename.PtrZ(), "wb");
+        if (out == nullptr) {
+            Log::Print("Error: failed to open output <%s>\n", filename.PtrZ());
+            return;
+        }
+    }
+    Bwh uri(optionUri.Value());
+    if (!uri.BeginsWith(Brn("http://")) && !uri.BeginsWith(Brn("https://")) && !uri.BeginsWith(Brn("file://"))) {
+        uri.Grow(uri.Bytes() + 7);
+        uri.Replace(Brn("file://"));
+        uri.Append(optionUri.Value());
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    SinkStdio* sink = new SinkStdio(out);
+    TBool failed;
+    {
+        const auto pacing = optionFreeRun.Value()? AnimatorFile::Pacing::FreeRun : AnimatorFile::Pacing::RealTime;
+        PipelineSoak soak(lib->Env(), *sink, format, pacing, optionLoop.Value(), schedPolicy, cpuMask);
+        soak.Run(uri, optionDuration.Value());
+        soak.Quit();
+        const AnimatorFile& animator = soak.Animator();
+        failed = soak.Failed();
+
+        TUint sampleRate, numChannels, bitDepth;
+        if (!failed && !toStdout && animator.GetWavFormat(sampleRate, numChannels, bitDepth)) {
+            // sizes in the header are only known now.  Leave them as 'unknown' for FIFOs
+            try {
+                (void)sink->TryRewriteWavHeader(sampleRate, numChannels, bitDepth, animator.AudioBytes());
+            }
+            catch (WriterError&) {
+                Log::Print("PipelineSoak: failed to rewrite wav header\n");
+            }
+        }
+
+        const TUint64 wallUs = (soak.WallUs() == 0? 1 : soak.WallUs());
+        const TUint64 audioMs = animator.AudioJiffies() / Jiffies::kPerMs;
+        const TUint64 factorX100 = (audioMs * 100 * 1000) / wallUs;
+        Log::Print("PipelineSoak: {\"playableMsgs\": %llu, \"audioBytes\": %llu, \"audioMs\": %llu, "
+                   "\"wallMs\": %llu, \"cpuMs\": %llu, \"realtimeFactor\": %llu.%02llu}\n",
+                   animator.PlayableMsgs(), animator.AudioBytes(), audioMs,
+                   wallUs / 1000, soak.CpuUs() / 1000, factorX100 / 100, factorX100 % 100);
+    }
+    delete sink;
+    delete lib;
+    if (failed) {
+        Log::Print("PipelineSoak: FAILED\n");
+    }
+    delete logRedirect;
+}
@@ -0,0 +1,276 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Media/Pipeline/PipelineTrace.h>
+#include <OpenHome/Media/Pipeline/Logger.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+
+#include <string.h>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuitePipelineTrace : public SuiteUnitTest, private IPipelineElementUpstream, private IPipelineElementDownstream
+{
+    static const TUint kSampleRate = 44100;
+    static const TUint kBitDepth = 16;
+    static const TUint kNumChannels = 2;
+public:
+    SuitePipelineTrace();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IPipelineElementUpstream
+    Msg* Pull() override;
+private: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private:
+    MsgSilence* CreateSilence(TUint& aJiffies);
+    static TBool Contains(const Brx& aBuf, const TChar* aStr);
+    void TestDisabledRecordsNothing();
+    void TestPullRecorded();
+    void TestPushRecorded();
+    void TestNestedPullSelfTime();
+    void TestRingWraps();
+    void TestReset();
+    void TestPercentiles();
+    void TestChromeTrace();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    PipelineTrace* iTrace;
+    Logger* iLoggerUpstream;
+    Logger* iLoggerDownstream;
+    PipelineTracePoint* iPointUpstream;
+    Msg* iNextMsg;
+    TUint iPushed;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuitePipelineTrace
+
+SuitePipelineTrace::SuitePipelineTrace()
+    : SuiteUnitTest("SuitePipelineTrace")
+{
+    AddTest(MakeFunctor(*this, &SuitePipelineTrace::TestDisabledRecordsNothing), "TestDisabledRecordsNothing");
+    AddTest(MakeFunctor(*this, &SuitePipelineTrace::TestPullRecorded), "TestPullRecorded");
+    AddTest(MakeFunctor(*this, &SuitePipelineTrace::TestPushRecorded), "TestPushRecorded");
+    AddTest(MakeFunctor(*this, &SuitePipelineTrace::TestNestedPullSelfTime), "TestNestedPullSelfTime");
+    AddTest(MakeFunctor(*this, &SuitePipelineTrace::TestRingWraps), "TestRingWraps");
+    AddTest(MakeFunctor(*this, &SuitePipelineTrace::TestReset), "TestReset");
+    AddTest(MakeFunctor(*this, &SuitePipelineTrace::TestPercentiles), "TestPercentiles");
+    AddTest(MakeFunctor(*this, &SuitePipelineTrace::TestChromeTrace), "TestChromeTrace");
+}
+
+void SuitePipelineTrace::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgHaltCount(2);
+    init.SetMsgSilenceCount(2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iTrace = new PipelineTrace();
+    iLoggerUpstream = new Logger(*this, "Upstream");
+    iPointUpstream = &iTrace->CreatePoint(iLoggerUpstream->Id());
+    iLoggerUpstream->SetTracePoint(*iPointUpstream);
+    iLoggerDownstream = new Logger("Downstream", *this);
+    iLoggerDownstream->SetTracePoint(iTrace->CreatePoint(iLoggerDownstream->Id()));
+    iNextMsg = nullptr;
+    iPushed = 0;
+}
+
+void SuitePipelineTrace::TearDown()
+{
+    delete iLoggerDownstream;
+    delete iLoggerUpstream;
+    delete iTrace;
+    delete iMsgFactory;
+}
+
+Msg* SuitePipelineTrace::Pull()
+{
+    ASSERT(iNextMsg != nullptr);
+    Msg* msg = iNextMsg;
+    iNextMsg = nullptr;
+    return msg;
+}
+
+void SuitePipelineTrace::Push(Msg* aMsg)
+{
+    iPushed++;
+    aMsg->RemoveRef();
+}
+
+MsgSilence* SuitePipelineTrace::CreateSilence(TUint& aJiffies)
+{
+    aJiffies = Jiffies::kPerMs * 5;
+    return iMsgFactory->CreateMsgSilence(aJiffies, kSampleRate, kBitDepth, kNumChannels);
+}
+
+TBool SuitePipelineTrace::Contains(const Brx& aBuf, const TChar* aStr)
+{ // static
+    Bwh buf(aBuf.Bytes() + 1);
+    buf.Replace(aBuf);
+    return strstr((const TChar*)buf.PtrZ(), aStr) != nullptr;
+}
+
+void SuitePipelineTrace::TestDisabledRecordsNothing()
+{
+    iNextMsg = iMsgFactory->CreateMsgHalt();
+    iLoggerUpstream->Pull()->RemoveRef();
+    std::vector<PipelineTrace::Stats> stats;
+    iTrace->GetStats(stats);
+    TEST(stats.size() == 2);
+    TEST(stats[0].iMsgs == 0);
+    TEST(stats[1].iMsgs == 0);
+}
+
+void SuitePipelineTrace::TestPullRecorded()
+{
+    iTrace->SetEnabled(true);
+    iNextMsg = iMsgFactory->CreateMsgHalt();
+    iLoggerUpstream->Pull()->RemoveRef();
+    TUint jiffies;
+    iNextMsg = CreateSilence(jiffies);
+    iLoggerUpstream->Pull()->RemoveRef();
+
+    std::vector<PipelineTrace::Stats> stats;
+    iTrace->GetStats(stats);
+    TEST(stats.size() == 2);
+    TEST(strcmp(stats[0].iName, "Upstream") == 0);
+    TEST(stats[0].iMsgs == 2);
+    TEST(stats[0].iJiffies == jiffies);
+    TEST(stats[1].iMsgs == 0);
+}
+
+void SuitePipelineTrace::TestPushRecorded()
+{
+    iTrace->SetEnabled(true);
+    TUint jiffies;
+    iLoggerDownstream->Push(CreateSilence(jiffies));
+    TEST(iPushed == 1);
+
+    std::vector<PipelineTrace::Stats> stats;
+    iTrace->GetStats(stats);
+    TEST(stats[0].iMsgs == 0);
+    TEST(strcmp(stats[1].iName, "Downstream") == 0);
+    TEST(stats[1].iMsgs == 1);
+    TEST(stats[1].iJiffies == jiffies);
+}
+
+void SuitePipelineTrace::TestNestedPullSelfTime()
+{
+    iTrace->SetEnabled(true);
+    Logger outer(*iLoggerUpstream, "Outer");
+    PipelineTracePoint& outerPoint = iTrace->CreatePoint(outer.Id());
+    outer.SetTracePoint(outerPoint);
+    TUint jiffies;
+    iNextMsg = CreateSilence(jiffies);
+    outer.Pull()->RemoveRef();
+    iNextMsg = CreateSilence(jiffies);
+    iLoggerUpstream->Pull()->RemoveRef();
+
+    std::vector<PipelineTracePoint::Event> upstream;
+    iPointUpstream->Snapshot(upstream);
+    std::vector<PipelineTracePoint::Event> events;
+    outerPoint.Snapshot(events);
+    TEST(upstream.size() == 2);
+    TEST(events.size() == 1);
+    // outer's self time excludes the nested upstream pull
+    TEST(events[0].iDurationNs - events[0].iSelfNs == upstream[0].iDurationNs);
+    // ...which, like the later unnested pull, is all self time
+    TEST(upstream[0].iSelfNs == upstream[0].iDurationNs);
+    TEST(upstream[1].iSelfNs == upstream[1].iDurationNs);
+}
+
+void SuitePipelineTrace::TestRingWraps()
+{
+    iTrace->SetEnabled(true);
+    PipelineTracePoint& point = iTrace->CreatePoint("Direct");
+    const TUint kExtra = 10;
+    for (TUint i=0; i<PipelineTracePoint::kCapacity + kExtra; i++) {
+        point.Record(PipelineTracePoint::Begin(), PipelineTracePoint::EMsgSilence, i);
+    }
+    std::vector<PipelineTracePoint::Event> events;
+    point.Snapshot(events);
+    // the oldest entry is treated as potentially overwritten so is discarded
+    TEST(events.size() == PipelineTracePoint::kCapacity - 1);
+    TEST(events[0].iJiffies == kExtra + 1);
+    TEST(events.back().iJiffies == PipelineTracePoint::kCapacity + kExtra - 1);
+}
+
+void SuitePipelineTrace::TestReset()
+{
+    iTrace->SetEnabled(true);
+    PipelineTracePoint& point = iTrace->CreatePoint("Direct");
+    for (TUint i=0; i<5; i++) {
+        point.Record(PipelineTracePoint::Begin(), PipelineTracePoint::EMsgSilence, i);
+    }
+    iTrace->Reset();
+    for (TUint i=0; i<3; i++) {
+        point.Record(PipelineTracePoint::Begin(), PipelineTracePoint::EMsgSilence, 100 + i);
+    }
+    std::vector<PipelineTracePoint::Event> events;
+    point.Snapshot(events);
+    TEST(events.size() == 3);
+    TEST(events[0].iJiffies == 100);
+}
+
+void SuitePipelineTrace::TestPercentiles()
+{
+    std::vector<PipelineTracePoint::Event> events;
+    for (TUint i=100; i>0; i--) {
+        PipelineTracePoint::Event ev;
+        ev.iStartNs = (100 - i) * 1000;
+        ev.iDurationNs = i + 10;
+        ev.iSelfNs = i;
+        ev.iJiffies = 2;
+        ev.iType = PipelineTracePoint::EMsgAudioPcm;
+        events.push_back(ev);
+    }
+    PipelineTrace::Stats stats;
+    PipelineTrace::ComputeStats(events, stats);
+    TEST(stats.iMsgs == 100);
+    TEST(stats.iJiffies == 200);
+    TEST(stats.iSpanNs == 99 * 1000 + 11);
+    TEST(stats.iP50Ns == 50);
+    TEST(stats.iP90Ns == 90);
+    TEST(stats.iP99Ns == 99);
+    TEST(stats.iMaxNs == 100);
+}
+
+void SuitePipelineTrace::TestChromeTrace()
+{
+    iTrace->SetEnabled(true);
+    TUint jiffies;
+    iNextMsg = CreateSilence(jiffies);
+    iLoggerUpstream->Pull()->RemoveRef();
+
+    WriterBwh writer(1024);
+    iTrace->WriteChromeTrace(writer);
+    const Brx& json = writer.Buffer();
+    TEST(Brn(json.Ptr(), 15) == Brn("{\"traceEvents\":"));
+    TEST(Contains(json, "\"thread_name\""));
+    TEST(Contains(json, "\"Upstream\""));
+    TEST(Contains(json, "\"Downstream\""));
+    TEST(Contains(json, "\"name\":\"Silence\""));
+    TEST(Contains(json, "\"ph\":\"X\""));
+    TEST(json[json.Bytes() - 1] == '}');
+}
+
+
+
+void TestPipelineTrace()
+{
+    Runner runner("PipelineTrace tests\n");
+    runner.Add(new SuitePipelineTrace());
+    runner.Run();
+}
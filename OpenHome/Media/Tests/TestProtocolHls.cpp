@@ -13,6 +13,7 @@
 #include <OpenHome/Tests/TestPipe.h>
 #include <OpenHome/Tests/Mock.h>
 
+#include <atomic>
 #include <limits>
 
 namespace OpenHome {
@@ -102,14 +103,63 @@ private:
     HlsPlaylistParser* iParser;
 };
 
+class SuiteHlsMasterPlaylistParser : public OpenHome::TestFramework::SuiteUnitTest
+{
+public:
+    SuiteHlsMasterPlaylistParser();
+public: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestVariantsSorted();
+    void TestRelativeVariantUri();
+    void TestMediaPlaylist();
+    void TestVariantWithoutBandwidth();
+    void TestVariantsWithOtherCodecs();
+    void TestIFrameStreamIgnored();
+    void TestNoUsableVariants();
+    void TestReset();
+    void TestMediaPlaylistReplayed();
+    void TestReplayTooLong();
+private:
+    static void ReadAll(IReader& aReader, Bwx& aBuf);
+private:
+    HlsMasterPlaylistParser* iParser;
+};
+
+class SuiteHlsVariantSelector : public OpenHome::TestFramework::SuiteUnitTest
+{
+public:
+    SuiteHlsVariantSelector();
+public: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void AddSegments(TUint aCount, TUint aBitsPerSecond);
+    void TestStartsOnLowest();
+    void TestNoStats();
+    void TestEstimate();
+    void TestEstimateRecentSegmentsOnly();
+    void TestUpSwitchOneStep();
+    void TestUpSwitchNeedsConsecutiveEstimates();
+    void TestDownSwitchToHighestThatFits();
+    void TestHoldBetweenThresholds();
+    void TestSingleVariant();
+private:
+    HlsVariantSelector* iSelector;
+    std::vector<HlsSegmentStats> iStats;
+};
+
 class MockHlsPlaylistProvider : public IHlsPlaylistProvider
 {
 public:
     MockHlsPlaylistProvider();
     ~MockHlsPlaylistProvider();
     void QueuePlaylist(const Brn aUri, const Brn aPlaylist);
+    const Brx& LastSetUri() const;
 public: // from IHlsPlaylistProvider
     IReader& Reload() override;
+    void SetUri(const Uri& aUri) override;
     const Uri& GetUri() const override;
     void InterruptPlaylistProvider(TBool aInterrupt) override;
 private:
@@ -119,6 +169,7 @@ private:
     TUint iCurrentIdx;
     TUint iNextIdx;
     TBool iInterrupted;
+    Bws<Uri::kMaxUriBytes> iLastSetUri;
 };
 
 class MockReloadTimer : public IHlsReloadTimer
@@ -152,6 +203,7 @@ private:
     void TestEndlist();
     void TestUnsupportedTag();
     void TestInvalidPlaylist();
+    void TestSwitchVariant();
 private:
     OpenHome::Test::TestPipeDynamic* iTestPipe;
     MockHlsPlaylistProvider* iProvider;
@@ -196,6 +248,101 @@ private:
     SegmentStreamer* iStreamer;
 };
 
+class MockHlsSegmentUriProvider : public ISegmentUriProvider
+{
+public:
+    MockHlsSegmentUriProvider();
+    void QueueSegmentUri(const Brn aUri, TUint aDurationMs);
+    void SetStreamEnd();
+    void Reset();
+public: // from ISegmentUriProvider
+    TUint NextSegmentUri(Uri& aUri) override;
+    void InterruptSegmentUriProvider(TBool aInterrupt) override;
+private:
+    std::vector<std::pair<Brn, TUint>> iSegments;
+    TUint iSegment;
+    TBool iStreamEndSet;
+};
+
+class MockHlsSegmentServer
+{
+public:
+    MockHlsSegmentServer();
+    void AddSegment(const Brn aUri, const Brn aContent);
+    void Block(const Brn aUri);
+    void Unblock();
+    TUint BlockedCount() const;
+    TBool Find(const Brx& aUri, Brn& aContent) const;
+    void WaitIfBlocked(const Brx& aUri, const std::atomic<TBool>& aInterrupted);
+private:
+    std::vector<std::pair<Brn, Brn>> iSegments;
+    Mutex iLock;
+    Bws<Uri::kMaxUriBytes> iBlockUri;
+    std::atomic<TUint> iBlockedCount;
+};
+
+class MockHlsUriLoader : public IUriLoader
+{
+public:
+    MockHlsUriLoader(MockHlsSegmentServer& aServer);
+public: // from IUriLoader
+    IReader& Load(const Uri& aUri) override;
+    void Reset() override;
+    void Interrupt(TBool aInterrupt) override;
+private:
+    MockHlsSegmentServer& iServer;
+    ReaderBuffer iReader;
+    std::atomic<TBool> iInterrupted;
+};
+
+class SuiteHlsSegmentPrefetcher : public OpenHome::TestFramework::SuiteUnitTest
+{
+    static const TUint kFetchers = 3;
+public:
+    SuiteHlsSegmentPrefetcher(Environment& aEnv);
+public: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Create(TUint aBufferBytes);
+    void ReadSegment(IReader& aReader, Bwx& aBuf);
+    void InterruptWhenBlocked();
+    void UnblockWhenPrefetched();
+    void TestSegmentsInOrder();
+    void TestOutOfOrderCompletion();
+    void TestSegmentLargerThanBuffer();
+    void TestSegmentLoadFailure();
+    void TestSegmentUriError();
+    void TestInterruptAndReset();
+    void TestStats();
+private:
+    Environment& iEnv;
+    MockHlsSegmentUriProvider* iUriProvider;
+    MockHlsSegmentServer* iServer;
+    std::vector<IUriLoader*> iLoaders;
+    SegmentPrefetcher* iPrefetcher;
+};
+
+class SuiteHlsSegmentLoader : public OpenHome::TestFramework::SuiteUnitTest
+{
+public:
+    SuiteHlsSegmentLoader(Environment& aEnv);
+public: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void ReadSegment(IReader& aReader, Bwx& aBuf);
+    void TestSegmentsInOrder();
+    void TestSegmentLoadFailure();
+    void TestStats();
+private:
+    Environment& iEnv;
+    MockHlsSegmentUriProvider* iUriProvider;
+    MockHlsSegmentServer* iServer;
+    MockHlsUriLoader* iLoader;
+    SegmentLoader* iSegmentLoader;
+};
+
 } // namespace Test
 } // namespace Media
 } // namespace OpenHome
@@ -831,6 +978,394 @@ void SuiteHlsPlaylistParser::TestInvalidAttributes()
 }
 
 
+// SuiteHlsMasterPlaylistParser
+
+SuiteHlsMasterPlaylistParser::SuiteHlsMasterPlaylistParser()
+    : SuiteUnitTest("SuiteHlsMasterPlaylistParser")
+{
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestVariantsSorted), "TestVariantsSorted");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestRelativeVariantUri), "TestRelativeVariantUri");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestMediaPlaylist), "TestMediaPlaylist");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestVariantWithoutBandwidth), "TestVariantWithoutBandwidth");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestVariantsWithOtherCodecs), "TestVariantsWithOtherCodecs");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestIFrameStreamIgnored), "TestIFrameStreamIgnored");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestNoUsableVariants), "TestNoUsableVariants");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestReset), "TestReset");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestMediaPlaylistReplayed), "TestMediaPlaylistReplayed");
+    AddTest(MakeFunctor(*this, &SuiteHlsMasterPlaylistParser::TestReplayTooLong), "TestReplayTooLong");
+}
+
+void SuiteHlsMasterPlaylistParser::Setup()
+{
+    iParser = new HlsMasterPlaylistParser();
+}
+
+void SuiteHlsMasterPlaylistParser::TearDown()
+{
+    delete iParser;
+}
+
+void SuiteHlsMasterPlaylistParser::TestVariantsSorted()
+{
+    // Quoted CODECS attribute contains a comma.
+    const Brn kMaster(
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=320000,CODECS=\"mp4a.40.2,avc1.4d401e\",RESOLUTION=416x234\n"
+    "http://www.example.com/high.m3u8\n"
+    "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=64000,CODECS=\"mp4a.40.2,avc1.4d401e\"\n"
+    "http://www.example.com/low.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=128000,CODECS=\"mp4a.40.2,avc1.4d401e\"\n"
+    "http://www.example.com/mid.m3u8\n"
+    );
+    ReaderBuffer reader(kMaster);
+    TEST(iParser->Parse(reader));
+    const auto& variants = iParser->Variants();
+    TEST(variants.size() == 3);
+    TEST(variants[0]->Bandwidth() == 64000);
+    TEST(variants[0]->VariantUri() == Brn("http://www.example.com/low.m3u8"));
+    TEST(variants[0]->Codecs() == Brn("mp4a.40.2,avc1.4d401e"));
+    TEST(variants[1]->Bandwidth() == 128000);
+    TEST(variants[1]->VariantUri() == Brn("http://www.example.com/mid.m3u8"));
+    TEST(variants[2]->Bandwidth() == 320000);
+    TEST(variants[2]->VariantUri() == Brn("http://www.example.com/high.m3u8"));
+}
+
+void SuiteHlsMasterPlaylistParser::TestRelativeVariantUri()
+{
+    const Brn kMaster(
+    "#EXTM3U\r\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=64000\r\n"
+    "low/playlist.m3u8\r\n"
+    );
+    ReaderBuffer reader(kMaster);
+    TEST(iParser->Parse(reader));
+    const auto& variants = iParser->Variants();
+    TEST(variants.size() == 1);
+    TEST(variants[0]->VariantUri() == Brn("low/playlist.m3u8"));
+    TEST(variants[0]->Codecs() == Brx::Empty());
+
+    const Uri kUriBase(Brn("http://www.example.com/radio/master.m3u8"));
+    Uri uri;
+    variants[0]->AbsoluteUri(kUriBase, uri);
+    TEST(uri.AbsoluteUri() == Brn("http://www.example.com/radio/low/playlist.m3u8"));
+}
+
+void SuiteHlsMasterPlaylistParser::TestMediaPlaylist()
+{
+    const Brn kMedia(
+    "#EXTM3U\n"
+    "#EXT-X-VERSION:2\n"
+    "#EXT-X-TARGETDURATION:6\n"
+    "#EXT-X-MEDIA-SEQUENCE:1234\n"
+    "\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/a.ts\n"
+    );
+    ReaderBuffer reader(kMedia);
+    TEST(iParser->Parse(reader) == false);
+    TEST(iParser->Variants().size() == 0);
+}
+
+void SuiteHlsMasterPlaylistParser::TestVariantWithoutBandwidth()
+{
+    const Brn kMaster(
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:PROGRAM-ID=1\n"
+    "http://www.example.com/unknown.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=abc\n"
+    "http://www.example.com/invalid.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=64000\n"
+    "http://www.example.com/low.m3u8\n"
+    );
+    ReaderBuffer reader(kMaster);
+    TEST(iParser->Parse(reader));
+    const auto& variants = iParser->Variants();
+    TEST(variants.size() == 1);
+    TEST(variants[0]->VariantUri() == Brn("http://www.example.com/low.m3u8"));
+}
+
+void SuiteHlsMasterPlaylistParser::TestVariantsWithOtherCodecs()
+{
+    // Only variants with the same codecs as the lowest bandwidth variant are usable.
+    const Brn kMaster(
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=48000,CODECS=\"mp4a.40.5\"\n"
+    "http://www.example.com/he-low.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=320000,CODECS=\"mp4a.40.2\"\n"
+    "http://www.example.com/lc.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=96000,CODECS=\"mp4a.40.5\"\n"
+    "http://www.example.com/he-high.m3u8\n"
+    );
+    ReaderBuffer reader(kMaster);
+    TEST(iParser->Parse(reader));
+    const auto& variants = iParser->Variants();
+    TEST(variants.size() == 2);
+    TEST(variants[0]->VariantUri() == Brn("http://www.example.com/he-low.m3u8"));
+    TEST(variants[1]->VariantUri() == Brn("http://www.example.com/he-high.m3u8"));
+}
+
+void SuiteHlsMasterPlaylistParser::TestIFrameStreamIgnored()
+{
+    const Brn kMaster(
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=64000\n"
+    "http://www.example.com/low.m3u8\n"
+    "#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=86000,URI=\"http://www.example.com/iframe.m3u8\"\n"
+    );
+    ReaderBuffer reader(kMaster);
+    TEST(iParser->Parse(reader));
+    const auto& variants = iParser->Variants();
+    TEST(variants.size() == 1);
+    TEST(variants[0]->Bandwidth() == 64000);
+}
+
+void SuiteHlsMasterPlaylistParser::TestNoUsableVariants()
+{
+    const Brn kMaster(
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:PROGRAM-ID=1\n"
+    "http://www.example.com/unknown.m3u8\n"
+    );
+    ReaderBuffer reader(kMaster);
+    TEST_THROWS(iParser->Parse(reader), HlsPlaylistInvalid);
+    TEST(iParser->Variants().size() == 0);
+}
+
+void SuiteHlsMasterPlaylistParser::TestReset()
+{
+    const Brn kMaster(
+    "#EXTM3U\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=64000\n"
+    "http://www.example.com/low.m3u8\n"
+    );
+    ReaderBuffer reader(kMaster);
+    TEST(iParser->Parse(reader));
+    TEST(iParser->Variants().size() == 1);
+    iParser->Reset();
+    TEST(iParser->Variants().size() == 0);
+
+    // Previous variants are discarded by Parse().
+    ReaderBuffer reader2(kMaster);
+    TEST(iParser->Parse(reader2));
+    TEST(iParser->Variants().size() == 1);
+    ReaderBuffer reader3(kMaster);
+    TEST(iParser->Parse(reader3));
+    TEST(iParser->Variants().size() == 1);
+}
+
+void SuiteHlsMasterPlaylistParser::ReadAll(IReader& aReader, Bwx& aBuf)
+{ // static
+    for (;;) {
+        Brn buf = aReader.Read(16);
+        if (buf.Bytes() == 0) {
+            break;
+        }
+        aBuf.Append(buf);
+    }
+}
+
+void SuiteHlsMasterPlaylistParser::TestMediaPlaylistReplayed()
+{
+    // Probing a media playlist only reads its start, which can then be replayed to a media playlist parser.
+    const Brn kMedia(
+    "#EXTM3U\n"
+    "#EXT-X-VERSION:2\n"
+    "#EXT-X-TARGETDURATION:6\n"
+    "#EXT-X-MEDIA-SEQUENCE:1234\n"
+    "\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/a.ts\n"
+    );
+    ReaderBuffer reader(kMedia);
+    ReaderReplay replay;
+    replay.Record(reader);
+    TEST(iParser->Parse(replay) == false);
+    TEST(replay.Replay());
+    Bws<256> buf;
+    ReadAll(replay, buf);
+    TEST(buf == kMedia);
+}
+
+void SuiteHlsMasterPlaylistParser::TestReplayTooLong()
+{
+    Bwh playlist(ReaderReplay::kMaxBytes + 32);
+    playlist.Append("#EXTM3U\n");
+    while (playlist.Bytes() < playlist.MaxBytes()) {
+        playlist.Append('#');
+    }
+    ReaderBuffer reader(playlist);
+    ReaderReplay replay;
+    replay.Record(reader);
+    Bwh buf(playlist.Bytes());
+    ReadAll(replay, buf);
+    TEST(!replay.Replay());
+    // reads continue from the underlying reader
+    TEST(replay.Read(16).Bytes() == 0);
+}
+
+
+// SuiteHlsVariantSelector
+
+SuiteHlsVariantSelector::SuiteHlsVariantSelector()
+    : SuiteUnitTest("SuiteHlsVariantSelector")
+{
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestStartsOnLowest), "TestStartsOnLowest");
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestNoStats), "TestNoStats");
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestEstimate), "TestEstimate");
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestEstimateRecentSegmentsOnly), "TestEstimateRecentSegmentsOnly");
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestUpSwitchOneStep), "TestUpSwitchOneStep");
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestUpSwitchNeedsConsecutiveEstimates), "TestUpSwitchNeedsConsecutiveEstimates");
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestDownSwitchToHighestThatFits), "TestDownSwitchToHighestThatFits");
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestHoldBetweenThresholds), "TestHoldBetweenThresholds");
+    AddTest(MakeFunctor(*this, &SuiteHlsVariantSelector::TestSingleVariant), "TestSingleVariant");
+}
+
+void SuiteHlsVariantSelector::Setup()
+{
+    iSelector = new HlsVariantSelector();
+    std::vector<TUint> bandwidths;
+    bandwidths.push_back(64000);
+    bandwidths.push_back(128000);
+    bandwidths.push_back(320000);
+    iSelector->SetVariants(bandwidths);
+}
+
+void SuiteHlsVariantSelector::TearDown()
+{
+    iStats.clear();
+    delete iSelector;
+}
+
+void SuiteHlsVariantSelector::AddSegments(TUint aCount, TUint aBitsPerSecond)
+{
+    // 1s downloads of aBitsPerSecond.
+    for (TUint i=0; i<aCount; i++) {
+        iStats.push_back(HlsSegmentStats(iStats.size(), aBitsPerSecond / 8, 6000, 50, 1000));
+    }
+}
+
+void SuiteHlsVariantSelector::TestStartsOnLowest()
+{
+    TEST(iSelector->Current() == 0);
+    TEST(iSelector->EstimateBps() == 0);
+}
+
+void SuiteHlsVariantSelector::TestNoStats()
+{
+    TEST(iSelector->Update(iStats) == false);
+    TEST(iSelector->Current() == 0);
+    TEST(iSelector->EstimateBps() == 0);
+}
+
+void SuiteHlsVariantSelector::TestEstimate()
+{
+    // 1Mb in 1s then 1Mb in 9s gives 2Mb in 10s.
+    iStats.push_back(HlsSegmentStats(0, 125000, 6000, 50, 1000));
+    iStats.push_back(HlsSegmentStats(1, 125000, 6000, 50, 9000));
+    (void)iSelector->Update(iStats);
+    TEST(iSelector->EstimateBps() == 200000);
+}
+
+void SuiteHlsVariantSelector::TestEstimateRecentSegmentsOnly()
+{
+    AddSegments(1, 8000);
+    AddSegments(HlsVariantSelector::kEstimateSegments, 1000000);
+    (void)iSelector->Update(iStats);
+    TEST(iSelector->EstimateBps() == 1000000);
+}
+
+void SuiteHlsVariantSelector::TestUpSwitchOneStep()
+{
+    // Throughput is enough for the highest variant but only step up one variant at a time.
+    AddSegments(1, 1000000);
+    for (TUint i=1; i<HlsVariantSelector::kUpSwitchCount; i++) {
+        TEST(iSelector->Update(iStats) == false);
+    }
+    TEST(iSelector->Update(iStats));
+    TEST(iSelector->Current() == 1);
+    for (TUint i=1; i<HlsVariantSelector::kUpSwitchCount; i++) {
+        TEST(iSelector->Update(iStats) == false);
+    }
+    TEST(iSelector->Update(iStats));
+    TEST(iSelector->Current() == 2);
+    TEST(iSelector->Update(iStats) == false);
+    TEST(iSelector->Current() == 2);
+}
+
+void SuiteHlsVariantSelector::TestUpSwitchNeedsConsecutiveEstimates()
+{
+    // 128000 needs an estimate of at least 128000 * 100 / kSafetyPercent.
+    AddSegments(HlsVariantSelector::kEstimateSegments, 200000);
+    for (TUint i=1; i<HlsVariantSelector::kUpSwitchCount; i++) {
+        TEST(iSelector->Update(iStats) == false);
+    }
+    // A single poor estimate restarts the count.
+    iStats.clear();
+    AddSegments(HlsVariantSelector::kEstimateSegments, 100000);
+    TEST(iSelector->Update(iStats) == false);
+    iStats.clear();
+    AddSegments(HlsVariantSelector::kEstimateSegments, 200000);
+    for (TUint i=1; i<HlsVariantSelector::kUpSwitchCount; i++) {
+        TEST(iSelector->Update(iStats) == false);
+    }
+    TEST(iSelector->Update(iStats));
+    TEST(iSelector->Current() == 1);
+}
+
+void SuiteHlsVariantSelector::TestDownSwitchToHighestThatFits()
+{
+    AddSegments(HlsVariantSelector::kEstimateSegments, 1000000);
+    while (iSelector->Current() < 2) {
+        (void)iSelector->Update(iStats);
+    }
+
+    // Drop straight from 320000 to 64000 without stepping through 128000.
+    AddSegments(HlsVariantSelector::kEstimateSegments, 100000);
+    TEST(iSelector->Update(iStats));
+    TEST(iSelector->Current() == 0);
+    TEST(iSelector->EstimateBps() == 100000);
+
+    // Lowest variant is kept regardless of throughput.
+    AddSegments(HlsVariantSelector::kEstimateSegments, 10000);
+    TEST(iSelector->Update(iStats) == false);
+    TEST(iSelector->Current() == 0);
+}
+
+void SuiteHlsVariantSelector::TestHoldBetweenThresholds()
+{
+    AddSegments(HlsVariantSelector::kEstimateSegments, 200000);
+    while (iSelector->Current() < 1) {
+        (void)iSelector->Update(iStats);
+    }
+
+    // 128000 is more than kSafetyPercent but less than kDownSwitchPercent of 150000.
+    AddSegments(HlsVariantSelector::kEstimateSegments, 150000);
+    for (TUint i=0; i<HlsVariantSelector::kUpSwitchCount+1; i++) {
+        TEST(iSelector->Update(iStats) == false);
+        TEST(iSelector->Current() == 1);
+    }
+
+    // 128000 is more than kDownSwitchPercent of 140000.
+    AddSegments(HlsVariantSelector::kEstimateSegments, 140000);
+    TEST(iSelector->Update(iStats));
+    TEST(iSelector->Current() == 0);
+}
+
+void SuiteHlsVariantSelector::TestSingleVariant()
+{
+    std::vector<TUint> bandwidths;
+    bandwidths.push_back(64000);
+    iSelector->SetVariants(bandwidths);
+    AddSegments(HlsVariantSelector::kEstimateSegments, 1000000);
+    for (TUint i=0; i<HlsVariantSelector::kUpSwitchCount+1; i++) {
+        TEST(iSelector->Update(iStats) == false);
+    }
+    AddSegments(HlsVariantSelector::kEstimateSegments, 10000);
+    TEST(iSelector->Update(iStats) == false);
+    TEST(iSelector->Current() == 0);
+}
+
+
 // MockHlsPlaylistProvider
 
 MockHlsPlaylistProvider::MockHlsPlaylistProvider()
@@ -853,6 +1388,11 @@ void MockHlsPlaylistProvider::QueuePlaylist(const Brn aUri, const Brn aPlaylist)
     iPlaylists.push_back(aPlaylist);
 }
 
+const Brx& MockHlsPlaylistProvider::LastSetUri() const
+{
+    return iLastSetUri;
+}
+
 IReader& MockHlsPlaylistProvider::Reload()
 {
     if (iInterrupted) {
@@ -868,6 +1408,11 @@ IReader& MockHlsPlaylistProvider::Reload()
     return iReader;
 }
 
+void MockHlsPlaylistProvider::SetUri(const Uri& aUri)
+{
+    iLastSetUri.Replace(aUri.AbsoluteUri());
+}
+
 const Uri& MockHlsPlaylistProvider::GetUri() const
 {
     if (iInterrupted) {
@@ -927,6 +1472,7 @@ SuiteHlsM3uReader::SuiteHlsM3uReader()
     AddTest(MakeFunctor(*this, &SuiteHlsM3uReader::TestEndlist), "TestEndlist");
     AddTest(MakeFunctor(*this, &SuiteHlsM3uReader::TestUnsupportedTag), "TestUnsupportedTag");
     AddTest(MakeFunctor(*this, &SuiteHlsM3uReader::TestInvalidPlaylist), "TestInvalidPlaylist");
+    AddTest(MakeFunctor(*this, &SuiteHlsM3uReader::TestSwitchVariant), "TestSwitchVariant");
 }
 
 void SuiteHlsM3uReader::Setup()
@@ -1489,6 +2035,75 @@ void SuiteHlsM3uReader::TestInvalidPlaylist()
     TEST_THROWS(iM3uReader->NextSegmentUri(uri), HlsSegmentUriError);
 }
 
+void SuiteHlsM3uReader::TestSwitchVariant()
+{
+    const Brn kUriLow("http://www.example.com/low.m3u8");
+    const Brn kFileLow(
+    "#EXTM3U\n"
+    "#EXT-X-VERSION:2\n"
+    "#EXT-X-TARGETDURATION:6\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/low/a.ts\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/low/b.ts\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/low/c.ts\n"
+    );
+    const Brn kUriHigh("http://www.example.com/high.m3u8");
+    const Brn kFileHigh(
+    "#EXTM3U\n"
+    "#EXT-X-VERSION:2\n"
+    "#EXT-X-TARGETDURATION:6\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/high/a.ts\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/high/b.ts\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/high/c.ts\n"
+    "#EXTINF:6,\n"
+    "https://priv.example.com/high/d.ts\n"
+    );
+    iProvider->QueuePlaylist(kUriLow, kFileLow);
+    iProvider->QueuePlaylist(kUriHigh, kFileHigh);
+
+    Uri uri;
+    (void)iM3uReader->NextSegmentUri(uri);
+    TEST(iTestPipe->Expect(Brn("MRT::Restart")));
+    TEST(uri.AbsoluteUri() == Brn("https://priv.example.com/low/a.ts"));
+    (void)iM3uReader->NextSegmentUri(uri);
+    TEST(uri.AbsoluteUri() == Brn("https://priv.example.com/low/b.ts"));
+    TEST(iM3uReader->LastSegment() == 11);
+
+    // New variant is loaded immediately (without waiting for reload timer) and continues from following segment.
+    iM3uReader->SwitchVariant(Uri(kUriHigh), 128000);
+    (void)iM3uReader->NextSegmentUri(uri);
+    TEST(iTestPipe->Expect(Brn("MRT::Restart")));
+    TEST(iProvider->LastSetUri() == kUriHigh);
+    TEST(uri.AbsoluteUri() == Brn("https://priv.example.com/high/c.ts"));
+    TEST(iM3uReader->LastSegment() == 12);
+    (void)iM3uReader->NextSegmentUri(uri);
+    TEST(uri.AbsoluteUri() == Brn("https://priv.example.com/high/d.ts"));
+    TEST(iM3uReader->LastSegment() == 13);
+
+    TUint bandwidth = 0;
+    TEST(iM3uReader->VariantChanged(0, bandwidth) == false);
+    TEST(iM3uReader->VariantChanged(1, bandwidth) == false);
+    TEST(iM3uReader->VariantChanged(2, bandwidth));
+    TEST(bandwidth == 128000);
+    TEST(iM3uReader->VariantChanged(2, bandwidth) == false);
+    TEST(iM3uReader->VariantChanged(3, bandwidth) == false);
+
+    // Pending switch is discarded by Reset().
+    iM3uReader->SwitchVariant(Uri(kUriLow), 64000);
+    iM3uReader->Reset();
+    TEST(iTestPipe->Expect(Brn("MRT::Restart")));
+    TEST(iProvider->LastSetUri() == kUriHigh);
+}
+
 
 // MockHlsSegmentProvider
 
@@ -1744,13 +2359,523 @@ void SuiteHlsSegmentStreamer::TestEndOfStreamReadMoreThan()
 }
 
 
+// MockHlsSegmentUriProvider
+
+MockHlsSegmentUriProvider::MockHlsSegmentUriProvider()
+    : iSegment(0)
+    , iStreamEndSet(false)
+{
+}
+
+void MockHlsSegmentUriProvider::QueueSegmentUri(const Brn aUri, TUint aDurationMs)
+{
+    ASSERT(!iStreamEndSet);
+    iSegments.push_back(std::pair<Brn, TUint>(aUri, aDurationMs));
+}
+
+void MockHlsSegmentUriProvider::SetStreamEnd()
+{
+    iStreamEndSet = true;
+}
+
+void MockHlsSegmentUriProvider::Reset()
+{
+    iSegment = 0;
+}
+
+TUint MockHlsSegmentUriProvider::NextSegmentUri(Uri& aUri)
+{
+    if (iSegment >= iSegments.size()) {
+        if (iStreamEndSet) {
+            THROW(HlsEndOfStream);
+        }
+        THROW(HlsSegmentUriError);
+    }
+    const auto& segment = iSegments[iSegment++];
+    aUri.Replace(segment.first);
+    return segment.second;
+}
+
+void MockHlsSegmentUriProvider::InterruptSegmentUriProvider(TBool /*aInterrupt*/)
+{
+}
+
+
+// MockHlsSegmentServer
+
+MockHlsSegmentServer::MockHlsSegmentServer()
+    : iLock("MHSS")
+    , iBlockedCount(0)
+{
+}
+
+void MockHlsSegmentServer::AddSegment(const Brn aUri, const Brn aContent)
+{
+    iSegments.push_back(std::pair<Brn, Brn>(aUri, aContent));
+}
+
+void MockHlsSegmentServer::Block(const Brn aUri)
+{
+    AutoMutex _(iLock);
+    iBlockUri.Replace(aUri);
+}
+
+void MockHlsSegmentServer::Unblock()
+{
+    AutoMutex _(iLock);
+    iBlockUri.SetBytes(0);
+}
+
+TUint MockHlsSegmentServer::BlockedCount() const
+{
+    return iBlockedCount;
+}
+
+TBool MockHlsSegmentServer::Find(const Brx& aUri, Brn& aContent) const
+{
+    for (const auto& segment : iSegments) {
+        if (segment.first == aUri) {
+            aContent.Set(segment.second);
+            return true;
+        }
+    }
+    return false;
+}
+
+void MockHlsSegmentServer::WaitIfBlocked(const Brx& aUri, const std::atomic<TBool>& aInterrupted)
+{
+    TBool blocked = false;
+    for (;;) {
+        {
+            AutoMutex _(iLock);
+            if (iBlockUri != aUri || aInterrupted) {
+                break;
+            }
+        }
+        if (!blocked) {
+            blocked = true;
+            iBlockedCount++;
+        }
+        Thread::Sleep(1);
+    }
+    if (blocked) {
+        iBlockedCount--;
+    }
+}
+
+
+// MockHlsUriLoader
+
+MockHlsUriLoader::MockHlsUriLoader(MockHlsSegmentServer& aServer)
+    : iServer(aServer)
+    , iInterrupted(false)
+{
+}
+
+IReader& MockHlsUriLoader::Load(const Uri& aUri)
+{
+    iServer.WaitIfBlocked(aUri.AbsoluteUri(), iInterrupted);
+    Brn content;
+    if (iInterrupted || !iServer.Find(aUri.AbsoluteUri(), content)) {
+        THROW(UriLoaderError);
+    }
+    iReader.Set(content);
+    return iReader;
+}
+
+void MockHlsUriLoader::Reset()
+{
+}
+
+void MockHlsUriLoader::Interrupt(TBool aInterrupt)
+{
+    iInterrupted = aInterrupt;
+}
+
+
+// SuiteHlsSegmentPrefetcher
+
+SuiteHlsSegmentPrefetcher::SuiteHlsSegmentPrefetcher(Environment& aEnv)
+    : SuiteUnitTest("SuiteHlsSegmentPrefetcher")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::TestSegmentsInOrder), "TestSegmentsInOrder");
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::TestOutOfOrderCompletion), "TestOutOfOrderCompletion");
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::TestSegmentLargerThanBuffer), "TestSegmentLargerThanBuffer");
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::TestSegmentLoadFailure), "TestSegmentLoadFailure");
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::TestSegmentUriError), "TestSegmentUriError");
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::TestInterruptAndReset), "TestInterruptAndReset");
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::TestStats), "TestStats");
+}
+
+void SuiteHlsSegmentPrefetcher::Setup()
+{
+    iUriProvider = new MockHlsSegmentUriProvider();
+    iServer = new MockHlsSegmentServer();
+    for (TUint i=0; i<kFetchers; i++) {
+        iLoaders.push_back(new MockHlsUriLoader(*iServer));
+    }
+    iPrefetcher = nullptr;
+}
+
+void SuiteHlsSegmentPrefetcher::TearDown()
+{
+    delete iPrefetcher;
+    for (auto loader : iLoaders) {
+        delete loader;
+    }
+    iLoaders.clear();
+    delete iServer;
+    delete iUriProvider;
+}
+
+void SuiteHlsSegmentPrefetcher::Create(TUint aBufferBytes)
+{
+    iPrefetcher = new SegmentPrefetcher(iEnv, *iUriProvider, iLoaders, aBufferBytes, kPriorityNormal);
+}
+
+void SuiteHlsSegmentPrefetcher::ReadSegment(IReader& aReader, Bwx& aBuf)
+{
+    aBuf.SetBytes(0);
+    for (;;) {
+        Brn buf = aReader.Read(5);
+        if (buf.Bytes() == 0) {
+            break;
+        }
+        aBuf.Append(buf);
+    }
+}
+
+void SuiteHlsSegmentPrefetcher::InterruptWhenBlocked()
+{
+    while (iServer->BlockedCount() == 0) {
+        Thread::Sleep(1);
+    }
+    iPrefetcher->InterruptSegmentProvider(true);
+}
+
+void SuiteHlsSegmentPrefetcher::UnblockWhenPrefetched()
+{
+    std::vector<HlsSegmentStats> stats;
+    for (;;) {
+        iPrefetcher->GetStats(stats);
+        if (stats.size() == kFetchers - 1) {
+            break;
+        }
+        Thread::Sleep(1);
+    }
+    iServer->Unblock();
+}
+
+void SuiteHlsSegmentPrefetcher::TestSegmentsInOrder()
+{
+    const Brn kSegments[] = { Brn("segment0"), Brn("segment1 content"), Brn("2"), Brn("segment3"), Brn("segment four") };
+    const Brn kUris[] = { Brn("http://example.com/0.ts"), Brn("http://example.com/1.ts"), Brn("http://example.com/2.ts"), Brn("http://example.com/3.ts"), Brn("http://example.com/4.ts") };
+    for (TUint i=0; i<5; i++) {
+        iUriProvider->QueueSegmentUri(kUris[i], 6000);
+        iServer->AddSegment(kUris[i], kSegments[i]);
+    }
+    iUriProvider->SetStreamEnd();
+    Create(1024);
+
+    Bws<64> buf;
+    for (TUint i=0; i<5; i++) {
+        ReadSegment(iPrefetcher->NextSegment(), buf);
+        TEST(buf == kSegments[i]);
+    }
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsEndOfStream);
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsEndOfStream);
+}
+
+void SuiteHlsSegmentPrefetcher::TestOutOfOrderCompletion()
+{
+    const Brn kUri0("http://example.com/0.ts");
+    const Brn kUri1("http://example.com/1.ts");
+    const Brn kUri2("http://example.com/2.ts");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iUriProvider->QueueSegmentUri(kUri1, 6000);
+    iUriProvider->QueueSegmentUri(kUri2, 6000);
+    iUriProvider->SetStreamEnd();
+    iServer->AddSegment(kUri0, Brn("000"));
+    iServer->AddSegment(kUri1, Brn("111"));
+    iServer->AddSegment(kUri2, Brn("222"));
+    iServer->Block(kUri0);
+    Create(1024);
+
+    // Prefetch starts on first call to NextSegment(), which blocks until segment 0 is available.
+    // Unblock segment 0 only once 1 and 2 have been fetched.
+    ThreadFunctor* unblocker = new ThreadFunctor("HlsUnblocker", MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::UnblockWhenPrefetched));
+    unblocker->Start();
+
+    Bws<16> buf;
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == Brn("000"));
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == Brn("111"));
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == Brn("222"));
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsEndOfStream);
+    delete unblocker;
+
+    std::vector<HlsSegmentStats> stats;
+    iPrefetcher->GetStats(stats);
+    TEST(stats.size() == 3);
+    TEST(stats[0].Index() != 0);
+    TEST(stats[1].Index() != 0);
+    TEST(stats[2].Index() == 0);
+}
+
+void SuiteHlsSegmentPrefetcher::TestSegmentLargerThanBuffer()
+{
+    const Brn kUri0("http://example.com/0.ts");
+    const Brn kUri1("http://example.com/1.ts");
+    const Brn kSegment0("0123456789abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+    const Brn kSegment1("zyxwvutsrqponmlkjihgfedcba9876543210");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iUriProvider->QueueSegmentUri(kUri1, 6000);
+    iUriProvider->SetStreamEnd();
+    iServer->AddSegment(kUri0, kSegment0);
+    iServer->AddSegment(kUri1, kSegment1);
+    Create(7); // reads of 5 bytes regularly wrap around end of buffer
+
+    Bws<128> buf;
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == kSegment0);
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == kSegment1);
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsEndOfStream);
+}
+
+void SuiteHlsSegmentPrefetcher::TestSegmentLoadFailure()
+{
+    const Brn kUri0("http://example.com/0.ts");
+    const Brn kUri1("http://example.com/1.ts"); // not available from server
+    const Brn kUri2("http://example.com/2.ts");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iUriProvider->QueueSegmentUri(kUri1, 6000);
+    iUriProvider->QueueSegmentUri(kUri2, 6000);
+    iUriProvider->SetStreamEnd();
+    iServer->AddSegment(kUri0, Brn("000"));
+    iServer->AddSegment(kUri2, Brn("222"));
+    Create(1024);
+
+    Bws<16> buf;
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == Brn("000"));
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsSegmentError);
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == Brn("222"));
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsEndOfStream);
+}
+
+void SuiteHlsSegmentPrefetcher::TestSegmentUriError()
+{
+    const Brn kUri0("http://example.com/0.ts");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iServer->AddSegment(kUri0, Brn("000"));
+    // No stream end set so HlsSegmentUriError is thrown after first segment.
+    Create(1024);
+
+    Bws<16> buf;
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == Brn("000"));
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsSegmentError);
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsSegmentError);
+}
+
+void SuiteHlsSegmentPrefetcher::TestInterruptAndReset()
+{
+    const Brn kUri0("http://example.com/0.ts");
+    const Brn kUri1("http://example.com/1.ts");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iUriProvider->QueueSegmentUri(kUri1, 6000);
+    iUriProvider->SetStreamEnd();
+    iServer->AddSegment(kUri0, Brn("000"));
+    iServer->AddSegment(kUri1, Brn("111"));
+    iServer->Block(kUri0);
+    Create(1024);
+
+    ThreadFunctor* interrupter = new ThreadFunctor("HlsInterrupter", MakeFunctor(*this, &SuiteHlsSegmentPrefetcher::InterruptWhenBlocked));
+    interrupter->Start();
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsSegmentError);
+    delete interrupter;
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsSegmentError);
+
+    iPrefetcher->Reset();
+    iPrefetcher->InterruptSegmentProvider(false);
+    iUriProvider->Reset();
+    iServer->Unblock();
+
+    Bws<16> buf;
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == Brn("000"));
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST(buf == Brn("111"));
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsEndOfStream);
+}
+
+void SuiteHlsSegmentPrefetcher::TestStats()
+{
+    const Brn kUri0("http://example.com/0.ts");
+    const Brn kUri1("http://example.com/1.ts");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iUriProvider->QueueSegmentUri(kUri1, 4000);
+    iUriProvider->SetStreamEnd();
+    iServer->AddSegment(kUri0, Brn("0000000000"));
+    iServer->AddSegment(kUri1, Brn("11111"));
+    Create(1024);
+
+    Bws<16> buf;
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    ReadSegment(iPrefetcher->NextSegment(), buf);
+    TEST_THROWS(iPrefetcher->NextSegment(), HlsEndOfStream);
+
+    std::vector<HlsSegmentStats> stats;
+    iPrefetcher->GetStats(stats);
+    TEST(stats.size() == 2);
+    TBool seen[2] = { false, false };
+    for (const auto& s : stats) {
+        TEST(s.Index() < 2);
+        seen[s.Index()] = true;
+        TEST(s.Bytes() == (s.Index() == 0? 10u : 5u));
+        TEST(s.DurationMs() == (s.Index() == 0? 6000u : 4000u));
+        TEST(s.LatencyMs() <= s.DownloadMs());
+        TEST(s.BitsPerSecond() > 0);
+    }
+    TEST(seen[0] && seen[1]);
+}
+
+
+// SuiteHlsSegmentLoader
+
+SuiteHlsSegmentLoader::SuiteHlsSegmentLoader(Environment& aEnv)
+    : SuiteUnitTest("SuiteHlsSegmentLoader")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentLoader::TestSegmentsInOrder), "TestSegmentsInOrder");
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentLoader::TestSegmentLoadFailure), "TestSegmentLoadFailure");
+    AddTest(MakeFunctor(*this, &SuiteHlsSegmentLoader::TestStats), "TestStats");
+}
+
+void SuiteHlsSegmentLoader::Setup()
+{
+    iUriProvider = new MockHlsSegmentUriProvider();
+    iServer = new MockHlsSegmentServer();
+    iLoader = new MockHlsUriLoader(*iServer);
+    iSegmentLoader = new SegmentLoader(iEnv, *iUriProvider, *iLoader);
+}
+
+void SuiteHlsSegmentLoader::TearDown()
+{
+    delete iSegmentLoader;
+    delete iLoader;
+    delete iServer;
+    delete iUriProvider;
+}
+
+void SuiteHlsSegmentLoader::ReadSegment(IReader& aReader, Bwx& aBuf)
+{
+    aBuf.SetBytes(0);
+    for (;;) {
+        Brn buf = aReader.Read(5);
+        if (buf.Bytes() == 0) {
+            break;
+        }
+        aBuf.Append(buf);
+    }
+}
+
+void SuiteHlsSegmentLoader::TestSegmentsInOrder()
+{
+    const Brn kUri0("http://example.com/0.ts");
+    const Brn kUri1("http://example.com/1.ts");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iUriProvider->QueueSegmentUri(kUri1, 6000);
+    iUriProvider->SetStreamEnd();
+    iServer->AddSegment(kUri0, Brn("segment0"));
+    iServer->AddSegment(kUri1, Brn("segment1 content"));
+
+    Bws<32> buf;
+    ReadSegment(iSegmentLoader->NextSegment(), buf);
+    TEST(buf == Brn("segment0"));
+    ReadSegment(iSegmentLoader->NextSegment(), buf);
+    TEST(buf == Brn("segment1 content"));
+    TEST_THROWS(iSegmentLoader->NextSegment(), HlsEndOfStream);
+}
+
+void SuiteHlsSegmentLoader::TestSegmentLoadFailure()
+{
+    const Brn kUri0("http://example.com/0.ts"); // not available from server
+    const Brn kUri1("http://example.com/1.ts");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iUriProvider->QueueSegmentUri(kUri1, 6000);
+    iUriProvider->SetStreamEnd();
+    iServer->AddSegment(kUri1, Brn("111"));
+
+    Bws<16> buf;
+    TEST_THROWS(iSegmentLoader->NextSegment(), HlsSegmentError);
+    ReadSegment(iSegmentLoader->NextSegment(), buf);
+    TEST(buf == Brn("111"));
+    TEST_THROWS(iSegmentLoader->NextSegment(), HlsEndOfStream);
+
+    std::vector<HlsSegmentStats> stats;
+    iSegmentLoader->GetStats(stats);
+    TEST(stats.size() == 1);
+    TEST(stats[0].Index() == 1);
+}
+
+void SuiteHlsSegmentLoader::TestStats()
+{
+    const Brn kUri0("http://example.com/0.ts");
+    const Brn kUri1("http://example.com/1.ts");
+    iUriProvider->QueueSegmentUri(kUri0, 6000);
+    iUriProvider->QueueSegmentUri(kUri1, 4000);
+    iUriProvider->SetStreamEnd();
+    iServer->AddSegment(kUri0, Brn("0000000000"));
+    iServer->AddSegment(kUri1, Brn("11111"));
+
+    std::vector<HlsSegmentStats> stats;
+    Bws<16> buf;
+    IReader& reader = iSegmentLoader->NextSegment();
+    (void)reader.Read(5);
+    iSegmentLoader->GetStats(stats);
+    TEST(stats.size() == 0); // segment not yet read to its end
+    (void)reader.Read(5);
+    TEST(reader.Read(5).Bytes() == 0);
+    TEST(reader.Read(5).Bytes() == 0);
+    ReadSegment(iSegmentLoader->NextSegment(), buf);
+    TEST_THROWS(iSegmentLoader->NextSegment(), HlsEndOfStream);
+
+    iSegmentLoader->GetStats(stats);
+    TEST(stats.size() == 2);
+    for (TUint i=0; i<stats.size(); i++) {
+        TEST(stats[i].Index() == i);
+        TEST(stats[i].Bytes() == (i == 0? 10u : 5u));
+        TEST(stats[i].DurationMs() == (i == 0? 6000u : 4000u));
+        TEST(stats[i].LatencyMs() <= stats[i].DownloadMs());
+        TEST(stats[i].BitsPerSecond() > 0);
+    }
+
+    // Stats are retained across Reset(); segment indices restart from 0.
+    iSegmentLoader->Reset();
+    iUriProvider->Reset();
+    ReadSegment(iSegmentLoader->NextSegment(), buf);
+    iSegmentLoader->GetStats(stats);
+    TEST(stats.size() == 3);
+    TEST(stats[2].Index() == 0);
+    TEST(stats[2].Bytes() == 10);
+}
 
-void TestProtocolHls(Environment& /*aEnv*/)
+void TestProtocolHls(Environment& aEnv)
 {
     Runner runner("HLS tests\n");
     runner.Add(new SuiteHlsSegmentDescriptor());
     runner.Add(new SuiteHlsPlaylistParser());
+    runner.Add(new SuiteHlsMasterPlaylistParser());
+    runner.Add(new SuiteHlsVariantSelector());
     runner.Add(new SuiteHlsM3uReader());
     runner.Add(new SuiteHlsSegmentStreamer());
+    runner.Add(new SuiteHlsSegmentLoader(aEnv));
+    runner.Add(new SuiteHlsSegmentPrefetcher(aEnv));
     runner.Run();
 }
@@ -1,6 +1,7 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Protocol/Protocol.h>
 #include <OpenHome/Media/Protocol/ProtocolFactory.h>
+#include <OpenHome/Media/Protocol/HttpConnectionPool.h>
 #include <OpenHome/Private/Http.h>
 #include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
 #include <OpenHome/Net/Private/Globals.h>
@@ -10,6 +11,8 @@
 #include <OpenHome/Private/TestFramework.h>
 #include <OpenHome/SocketSsl.h>
 
+#include <atomic>
+
 using namespace OpenHome;
 using namespace OpenHome::TestFramework;
 
@@ -180,6 +183,19 @@ private:
     EMode iMode;
 };
 
+class TestHttpSessionKeepAlive : public TestHttpSession
+{
+public:
+    TestHttpSessionKeepAlive();
+    TUint Connections() const;
+    TUint Requests() const;
+private: // from TestHttpSession
+    void Respond();
+private:
+    std::atomic<TUint> iConnections;
+    std::atomic<TUint> iRequests;
+};
+
 class TestHttpSessionSeek : public SocketTcpSession
 {
 public:
@@ -238,7 +254,8 @@ public:
         eReconnect        = 2,
         eStreamLive       = 3,
         eLiveReconnect    = 4,
-        eChunked          = 5
+        eChunked          = 5,
+        eKeepAlive        = 6
     };
 public:
     static TestHttpSession* Create(ESession aSession);
@@ -413,6 +430,22 @@ private: // from SuiteHttp
     void Test();
 };
 
+class SuiteHttpGetPersistent : public SuiteHttpStreamBase
+{
+public:
+    SuiteHttpGetPersistent();
+private: // from SuiteHttp
+    void Test();
+};
+
+class SuiteHttpStreamPersistent : public SuiteHttpStreamBase
+{
+public:
+    SuiteHttpStreamPersistent();
+private: // from SuiteHttp
+    void Test();
+};
+
 class SuiteHttpChunked : public Suite
 {
 public:
@@ -793,6 +826,56 @@ void TestHttpSessionLiveReconnect::Respond()
 }
 
 
+// TestHttpSessionKeepAlive
+
+TestHttpSessionKeepAlive::TestHttpSessionKeepAlive()
+    : TestHttpSession()
+    , iConnections(0)
+    , iRequests(0)
+{
+}
+
+TUint TestHttpSessionKeepAlive::Connections() const
+{
+    return iConnections.load();
+}
+
+TUint TestHttpSessionKeepAlive::Requests() const
+{
+    return iRequests.load();
+}
+
+void TestHttpSessionKeepAlive::Respond()
+{
+    iConnections++;
+    for (;;) {
+        if (!iHeaderRange.Received()) {
+            ASSERTS();
+        }
+        iRequests++;
+        const TUint startByte = iHeaderRange.Start();
+        // Stream() requests an open ended range
+        const TUint endByte = (iHeaderRange.End() == 0? kStreamLen-1 : iHeaderRange.End());
+        iWriterResponse->WriteStatus(HttpStatus::kPartialContent, Http::eHttp11);
+        TestHttpServer::WriteHeaderPartialContent(*iWriterResponse, startByte, endByte, kStreamLen);
+        Http::WriteHeaderContentLength(*iWriterResponse, endByte-startByte+1);
+        iWriterResponse->WriteFlush();
+        Stream(startByte, endByte+1);
+
+        // Serve further requests until the client closes the connection.
+        try {
+            WaitOnReadRequest();
+        }
+        catch (HttpError&) {
+            return;
+        }
+        catch (ReaderError&) {
+            return;
+        }
+    }
+}
+
+
 // TestHttpSessionChunked
 
 TestHttpSessionChunked::TestHttpSessionChunked()
@@ -961,6 +1044,8 @@ TestHttpSession* SessionFactory::Create(ESession aSession)
         return new TestHttpSessionLiveReconnect();
     case eChunked:
         return new TestHttpSessionChunked();
+    case eKeepAlive:
+        return new TestHttpSessionKeepAlive();
     default:
         ASSERTS();
         return nullptr;    // Will never reach here.
@@ -1439,6 +1524,80 @@ void SuiteHttpLiveReconnect::Test()
 }
 
 
+// SuiteHttpGetPersistent : SuiteHttp
+
+SuiteHttpGetPersistent::SuiteHttpGetPersistent()
+    : SuiteHttpStreamBase("HTTP persistent connection tests", SessionFactory::eKeepAlive)
+{
+}
+
+void SuiteHttpGetPersistent::Test()
+{
+    static const TUint kReads = 4;
+    static const TUint kReadBytes = 10000;
+    const Brx& uri = iServer->ServingUri().AbsoluteUri();
+    Bwh buf(kReadBytes);
+    for (TUint i=0; i<kReads; i++) {
+        buf.SetBytes(0);
+        WriterBuffer writer(buf);
+        TEST(iProtocolManager->TryGet(writer, uri, i*kReadBytes, kReadBytes));
+        TEST(buf.Bytes() == kReadBytes);
+    }
+
+    // Test if all reads were made over a single connection.
+    auto session = static_cast<TestHttpSessionKeepAlive*>(iHttpSession);
+    TEST(session->Connections() == 1);
+    TEST(session->Requests() == kReads);
+
+    TUint64 hits, misses, handshakes, handshakeUs;
+    HttpConnectionPool& pool = iProtocolManager->ConnectionPool();
+    pool.GetStats(hits, misses, handshakes, handshakeUs);
+    TEST(misses == 1);
+    TEST(hits == kReads-1);
+    TEST(handshakes == 1);
+    TEST(pool.IdleCount() == 1);
+}
+
+
+// SuiteHttpStreamPersistent : SuiteHttp
+
+SuiteHttpStreamPersistent::SuiteHttpStreamPersistent()
+    : SuiteHttpStreamBase("HTTP persistent stream connection tests", SessionFactory::eKeepAlive)
+{
+}
+
+void SuiteHttpStreamPersistent::Test()
+{
+    static const TUint kReadBytes = 1000;
+    const Brx& uri = iServer->ServingUri().AbsoluteUri();
+
+    // A range read (e.g. a codec reading tags) leaves an idle connection for the stream to use
+    Bwh buf(kReadBytes);
+    WriterBuffer writer(buf);
+    TEST(iProtocolManager->TryGet(writer, uri, 0, kReadBytes));
+
+    // Streams that are read in full return their connection to the pool for the next request
+    Track* track = iTrackFactory->CreateTrack(uri, Brx::Empty());
+    TEST(iProtocolManager->DoStream(*track) == EProtocolStreamSuccess);
+    TEST(iSupply->DataTotal() == iHttpSession->DataSize());
+    TEST(iProtocolManager->DoStream(*track) == EProtocolStreamSuccess);
+    TEST(iSupply->DataTotal() == 2*iHttpSession->DataSize());
+    track->RemoveRef();
+
+    auto session = static_cast<TestHttpSessionKeepAlive*>(iHttpSession);
+    TEST(session->Connections() == 1);
+    TEST(session->Requests() == 3);
+
+    TUint64 hits, misses, handshakes, handshakeUs;
+    HttpConnectionPool& pool = iProtocolManager->ConnectionPool();
+    pool.GetStats(hits, misses, handshakes, handshakeUs);
+    TEST(misses == 1);
+    TEST(hits == 2);
+    TEST(handshakes == 1);
+    TEST(pool.IdleCount() == 1);
+}
+
+
 // SuiteHttpChunked
 
 SuiteHttpChunked::SuiteHttpChunked()
@@ -1577,6 +1736,8 @@ void TestProtocolHttp()
     runner.Add(new SuiteHttpStreamLive());
     runner.Add(new SuiteHttpLiveReconnect());
     runner.Add(new SuiteHttpChunked());
+    runner.Add(new SuiteHttpGetPersistent());
+    runner.Add(new SuiteHttpStreamPersistent());
     runner.Add(new SuiteHttpSeekInvalid());
     runner.Run();
 }
@@ -31,6 +31,7 @@ private: // from SuiteUnitTest
     void TearDown() override;
 private: // from IPipelineElementUpstream
     Msg* Pull() override;
+    void PullBatch(MsgQueueLite& aQueue, TUint aMaxJiffies) override;
 private: // from IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgTrack* aMsg) override;
@@ -85,6 +86,7 @@ private:
     void TestNonLiveStreamInMiddleRamps();
     void TestLiveStreamRamps();
     void TestRampDurationTakenFromModeInfo();
+    void TestPullBatchPreservesOrderAcrossRampEnd();
 private:
     AllocatorInfoLogger iInfoAggregator;
     TrackFactory* iTrackFactory;
@@ -122,6 +124,7 @@ SuiteRamper::SuiteRamper()
     AddTest(MakeFunctor(*this, &SuiteRamper::TestNonLiveStreamInMiddleRamps), "TestNonLiveStreamInMiddleRamps");
     AddTest(MakeFunctor(*this, &SuiteRamper::TestLiveStreamRamps), "TestLiveStreamRamps");
     AddTest(MakeFunctor(*this, &SuiteRamper::TestRampDurationTakenFromModeInfo), "TestRampDurationTakenFromModeInfo");
+    AddTest(MakeFunctor(*this, &SuiteRamper::TestPullBatchPreservesOrderAcrossRampEnd), "TestPullBatchPreservesOrderAcrossRampEnd");
 }
 
 SuiteRamper::~SuiteRamper()
@@ -172,6 +175,17 @@ Msg* SuiteRamper::Pull()
     return msg;
 }
 
+void SuiteRamper::PullBatch(MsgQueueLite& aQueue, TUint /*aMaxJiffies*/)
+{
+    Msg* msg = Pull();
+    aQueue.Enqueue(msg);
+    if (msg->IsAudioPcm()) {
+        while (iPendingMsgs.size() > 0 && iPendingMsgs.front()->IsAudioPcm()) {
+            aQueue.Enqueue(Pull());
+        }
+    }
+}
+
 Msg* SuiteRamper::ProcessMsg(MsgMode* aMsg)
 {
     iLastPulledMsg = EMsgMode;
@@ -482,6 +496,46 @@ void SuiteRamper::TestRampDurationTakenFromModeInfo()
 }
 
 
+void SuiteRamper::TestPullBatchPreservesOrderAcrossRampEnd()
+{
+    iLive = true;
+    iSampleStart = 0;
+    iPendingMsgs.push_back(CreateMode());
+    iPendingMsgs.push_back(CreateTrack());
+    iPendingMsgs.push_back(CreateDecodedStream());
+    PullNext(EMsgMode);
+    PullNext(EMsgTrack);
+    PullNext(EMsgDecodedStream);
+    TEST(iRamper->iRamping);
+
+    static const TUint kNumMsgs = 8; // ~90ms of audio, comfortably longer than kRampDurationLong
+    for (TUint i=0; i<kNumMsgs; i++) {
+        iPendingMsgs.push_back(CreateAudio());
+    }
+    const TUint64 endOffset = iTrackOffset;
+    TUint64 offset = 0;
+    TUint numBatches = 0;
+    MsgQueueLite batch;
+    while (offset < endOffset) {
+        iRamper->PullBatch(batch, UINT_MAX);
+        numBatches++;
+        TEST(!batch.IsEmpty());
+        while (!batch.IsEmpty()) {
+            Msg* msg = batch.Dequeue();
+            ASSERT(msg->IsAudioPcm());
+            auto audio = static_cast<MsgAudioPcm*>(msg);
+            TEST(audio->TrackOffset() == offset);
+            offset += audio->Jiffies();
+            audio->RemoveRef();
+        }
+    }
+    TEST(offset == endOffset);
+    TEST(!iRamper->iRamping);
+    // ending the ramp splits a msg; the split and the rest of the upstream batch must follow in order
+    TEST(numBatches > 1);
+    TEST(iPendingMsgs.size() == 0);
+}
+
 
 void TestRamper()
 {
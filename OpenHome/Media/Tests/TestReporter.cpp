@@ -1,4 +1,7 @@
 #include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Net/Private/Globals.h>
 #include <OpenHome/Media/Pipeline/Reporter.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
@@ -93,6 +96,33 @@ private:
     Semaphore iSemTime;
 };
 
+class SuitePipelineElementObserverThread : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kTimeoutMs = 5000;
+    static const TUint kThrottleMs = 50;
+public:
+    SuitePipelineElementObserverThread();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void BlockingCallback();
+    void Callback();
+    void TestScheduleWhilePendingCoalesced();
+    void TestPendingCallbacksBatched();
+    void TestThrottledCallbackDeferred();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    PipelineElementObserverThread* iObserverThread;
+    IPipelineElementObserverThread* iObserver;
+    Semaphore iSemBlocked;
+    Semaphore iSemRelease;
+    Semaphore iSemBlockingRun;
+    Semaphore iSemRun;
+    TUint iBlockingRuns;
+    std::vector<TUint> iRunTimesMs;
+};
+
 } // namespace Media
 } // namespace OpenHome
 
@@ -126,7 +156,7 @@ SuiteReporter::SuiteReporter()
     init.SetMsgMetaTextCount(3);
     iMsgFactory = new MsgFactory(iInfoAggregator, init);
     iTrackFactory = new TrackFactory(iInfoAggregator, 3);
-    iEventThread = new PipelineElementObserverThread(kThreadPriorityReporter-1);
+    iEventThread = new PipelineElementObserverThread(iInfoAggregator, kThreadPriorityReporter-1);
     iReporter = new Reporter(*this, *this, *iEventThread); // aim for a priority just below thread that runs Reporter
     iEventThread->Start();
 }
@@ -507,9 +537,143 @@ void SuiteReporter::NotifyStreamInfo(const DecodedStreamInfo& /*aStreamInfo*/)
 
 
 
+// SuitePipelineElementObserverThread
+
+SuitePipelineElementObserverThread::SuitePipelineElementObserverThread()
+    : SuiteUnitTest("PipelineElementObserverThread")
+    , iObserverThread(nullptr)
+    , iObserver(nullptr)
+    , iSemBlocked("SPE1", 0)
+    , iSemRelease("SPE2", 0)
+    , iSemBlockingRun("SPE3", 0)
+    , iSemRun("SPE4", 0)
+    , iBlockingRuns(0)
+{
+    AddTest(MakeFunctor(*this, &SuitePipelineElementObserverThread::TestScheduleWhilePendingCoalesced), "TestScheduleWhilePendingCoalesced");
+    AddTest(MakeFunctor(*this, &SuitePipelineElementObserverThread::TestPendingCallbacksBatched), "TestPendingCallbacksBatched");
+    AddTest(MakeFunctor(*this, &SuitePipelineElementObserverThread::TestThrottledCallbackDeferred), "TestThrottledCallbackDeferred");
+}
+
+void SuitePipelineElementObserverThread::Setup()
+{
+    iObserverThread = new PipelineElementObserverThread(iInfoAggregator, kPriorityNormal);
+    iObserver = iObserverThread;
+    iSemBlocked.Clear();
+    iSemRelease.Clear();
+    iSemBlockingRun.Clear();
+    iSemRun.Clear();
+    iBlockingRuns = 0;
+    iRunTimesMs.clear();
+}
+
+void SuitePipelineElementObserverThread::TearDown()
+{
+    iObserverThread->Stop();
+    delete iObserverThread;
+}
+
+void SuitePipelineElementObserverThread::BlockingCallback()
+{
+    // blocks on its first run only
+    if (iBlockingRuns++ == 0) {
+        iSemBlocked.Signal();
+        iSemRelease.Wait();
+    }
+    iSemBlockingRun.Signal();
+}
+
+void SuitePipelineElementObserverThread::Callback()
+{
+    iRunTimesMs.push_back(Os::TimeInMs(gEnv->OsCtx()));
+    iSemRun.Signal();
+}
+
+void SuitePipelineElementObserverThread::TestScheduleWhilePendingCoalesced()
+{
+    const TUint id = iObserver->Register(MakeFunctor(*this, &SuitePipelineElementObserverThread::BlockingCallback));
+    iObserverThread->Start();
+    iObserver->Schedule(id);
+    iSemBlocked.Wait(kTimeoutMs);
+    for (TUint i=0; i<5; i++) {
+        iObserver->Schedule(id);
+    }
+    iSemRelease.Signal();
+    iSemBlockingRun.Wait(kTimeoutMs);
+    iSemBlockingRun.Wait(kTimeoutMs);
+    TEST(iBlockingRuns == 2);
+
+    TUint64 scheduled, coalesced, dispatched;
+    iObserverThread->GetStats(id, scheduled, coalesced, dispatched);
+    TEST(scheduled == 6);
+    TEST(coalesced == 4);
+    TEST(dispatched == 2);
+}
+
+void SuitePipelineElementObserverThread::TestPendingCallbacksBatched()
+{
+    const TUint idBlocking = iObserver->Register(MakeFunctor(*this, &SuitePipelineElementObserverThread::BlockingCallback));
+    const TUint id = iObserver->Register(MakeFunctor(*this, &SuitePipelineElementObserverThread::Callback));
+    iObserverThread->Start();
+    iObserver->Schedule(idBlocking);
+    iSemBlocked.Wait(kTimeoutMs);
+    for (TUint i=0; i<3; i++) {
+        iObserver->Schedule(id);
+        iObserver->Schedule(idBlocking);
+    }
+    iSemRelease.Signal();
+    iSemBlockingRun.Wait(kTimeoutMs);
+    iSemBlockingRun.Wait(kTimeoutMs);
+    iSemRun.Wait(kTimeoutMs);
+    TEST(iRunTimesMs.size() == 1);
+
+    // the first schedule of both callbacks woke the thread.  All other calls were coalesced
+    TUint64 scheduled, coalesced, dispatched, batches;
+    iObserverThread->GetStats(scheduled, coalesced, dispatched, batches);
+    TEST(scheduled == 7);
+    TEST(coalesced == 4);
+    TEST(dispatched == 3);
+    TEST(batches == 2);
+}
+
+void SuitePipelineElementObserverThread::TestThrottledCallbackDeferred()
+{
+    const TUint id = iObserver->RegisterThrottled(MakeFunctor(*this, &SuitePipelineElementObserverThread::Callback), kThrottleMs);
+    iObserverThread->Start();
+
+    // first call is run immediately
+    iObserver->Schedule(id);
+    iSemRun.Wait(kTimeoutMs);
+
+    // further calls within kThrottleMs are deferred then run once
+    for (TUint i=0; i<3; i++) {
+        iObserver->Schedule(id);
+    }
+    iSemRun.Wait(kTimeoutMs);
+    TEST(iRunTimesMs.size() == 2);
+    TEST(iRunTimesMs[1] - iRunTimesMs[0] >= kThrottleMs - 10); // allow for timer resolution
+    TEST(!iSemRun.Clear());
+
+    TUint64 scheduled, coalesced, dispatched;
+    iObserverThread->GetStats(id, scheduled, coalesced, dispatched);
+    TEST(scheduled == 4);
+    TEST(coalesced == 2);
+    TEST(dispatched == 2);
+
+    // a call made after kThrottleMs has elapsed is not deferred
+    Thread::Sleep(kThrottleMs + 10);
+    const TUint start = Os::TimeInMs(gEnv->OsCtx());
+    iObserver->Schedule(id);
+    iSemRun.Wait(kTimeoutMs);
+    TEST(iRunTimesMs.size() == 3);
+    TEST(iRunTimesMs[2] - start < kThrottleMs);
+}
+
+
+
 void TestReporter()
 {
     Runner runner("Reporter tests\n");
     runner.Add(new SuiteReporter());
+    runner.Add(new SuitePipelineElementObserverThread());
     runner.Run();
 }
@@ -24,6 +24,9 @@ SIMPLE_TEST_DECLARATION(TestMsg);
 SIMPLE_TEST_DECLARATION(TestPipeline);
 SIMPLE_TEST_DECLARATION(TestPipelineConfig);
 SIMPLE_TEST_DECLARATION(TestPreDriver);
+SIMPLE_TEST_DECLARATION(TestPipelineTrace);
+SIMPLE_TEST_DECLARATION(TestElementBypass);
+SIMPLE_TEST_DECLARATION(TestThreadScheduler);
 SIMPLE_TEST_DECLARATION(TestProtocolHttp);
 SIMPLE_TEST_DECLARATION(TestRamper);
 SIMPLE_TEST_DECLARATION(TestReporter);
@@ -44,6 +47,7 @@ SIMPLE_TEST_DECLARATION(TestSupplyAggregator);
 SIMPLE_TEST_DECLARATION(TestTrackDatabase);
 SIMPLE_TEST_DECLARATION(TestTrackInspector);
 SIMPLE_TEST_DECLARATION(TestUriProviderRepeater);
+SIMPLE_TEST_DECLARATION(TestUrlBlockCache);
 SIMPLE_TEST_DECLARATION(TestVariableDelay);
 SIMPLE_TEST_DECLARATION(TestWaiter);
 SIMPLE_TEST_DECLARATION(TestJson);
@@ -99,6 +103,9 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestProtocolHls", ShellTestProtocolHls));
     shellTests.push_back(ShellTest("TestSsl", ShellTestSsl));
     shellTests.push_back(ShellTest("TestPreDriver", ShellTestPreDriver));
+    shellTests.push_back(ShellTest("TestPipelineTrace", ShellTestPipelineTrace));
+    shellTests.push_back(ShellTest("TestElementBypass", ShellTestElementBypass));
+    shellTests.push_back(ShellTest("TestThreadScheduler", ShellTestThreadScheduler));
     shellTests.push_back(ShellTest("TestProtocolHttp", ShellTestProtocolHttp));
     shellTests.push_back(ShellTest("TestRamper", ShellTestRamper));
     shellTests.push_back(ShellTest("TestReporter", ShellTestReporter));
@@ -118,6 +125,7 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestTrackDatabase", ShellTestTrackDatabase));
     shellTests.push_back(ShellTest("TestTrackInspector", ShellTestTrackInspector));
     shellTests.push_back(ShellTest("TestUriProviderRepeater", ShellTestUriProviderRepeater));
+    shellTests.push_back(ShellTest("TestUrlBlockCache", ShellTestUrlBlockCache));
     shellTests.push_back(ShellTest("TestVariableDelay", ShellTestVariableDelay));
     shellTests.push_back(ShellTest("TestWaiter", ShellTestWaiter));
     shellTests.push_back(ShellTest("TestRewinder", ShellTestRewinder));
@@ -7,6 +7,7 @@
 #include <OpenHome/Media/Pipeline/ElementObserver.h>
 
 #include <list>
+#include <atomic>
 #include <limits.h>
 
 using namespace OpenHome;
@@ -21,6 +22,7 @@ class SuiteStarvationRamper : public SuiteUnitTest
                             , private IMsgProcessor
                             , private IStreamHandler
                             , private IStarvationRamperObserver
+                            , private IPipelineThreadScheduler
 {
     static const TUint kMaxAudioBuffer = Jiffies::kPerMs * 100;
     static const TUint kRampUpDuration = Jiffies::kPerMs * 50;
@@ -33,7 +35,7 @@ class SuiteStarvationRamper : public SuiteUnitTest
     static const TUint kAudioPcmBytesDefault = 960; // 5ms of 48k, 16-bit stereo
     static const Brn kMode;
 public:
-    SuiteStarvationRamper();
+    SuiteStarvationRamper(FlywheelTraining aFlywheelTraining);
     ~SuiteStarvationRamper();
 private: // from SuiteUnitTest
     void Setup() override;
@@ -68,6 +70,8 @@ private: // from IStreamHandler
     void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
 private: // from IStarvationRamperObserver
     void NotifyStarvationRamperBuffering(TBool aBuffering) override;
+private: // from IPipelineThreadScheduler
+    void ApplyToCurrentThread(PipelineThread aThread) override;
 private:
     enum EMsgType
     {
@@ -117,7 +121,10 @@ private:
     void TestDsdRampsUpAfterStarvation();
     void TestDsdNoRampAtEndOfStream();
     void TestDsdStarvationDuringRampUp();
+    void TestPullBatchWhenRunning();
+    void TestThreadsScheduled();
 private:
+    const FlywheelTraining iFlywheelTraining;
     AllocatorInfoLogger iInfoAggregator;
     TrackFactory* iTrackFactory;
     MsgFactory* iMsgFactory;
@@ -140,6 +147,8 @@ private:
     TUint iStarvingStreamId;
     TUint iSampleRate;
     TUint iBitDepth;
+    Semaphore iThreadScheduled;
+    std::atomic<TUint> iScheduledThreads;
 };
 
 } // namespace Media
@@ -149,10 +158,12 @@ private:
 const Brn SuiteStarvationRamper::kMode("DummyMode");
 const SpeakerProfile SuiteStarvationRamper::kProfile(2);
 
-SuiteStarvationRamper::SuiteStarvationRamper()
-    : SuiteUnitTest("StarvationRamper")
+SuiteStarvationRamper::SuiteStarvationRamper(FlywheelTraining aFlywheelTraining)
+    : SuiteUnitTest(aFlywheelTraining == FlywheelTraining::Incremental? "StarvationRamper (incremental training)" : "StarvationRamper")
+    , iFlywheelTraining(aFlywheelTraining)
     , iPendingMsgLock("SSR1")
     , iMsgAvailable("SSR2", 0)
+    , iThreadScheduled("SSR3", 0)
 {
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestMsgsPassWhenRunning), "TestMsgsPassWhenRunning");
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestBlocksWhenHasMaxAudio), "TestBlocksWhenHasMaxAudio");
@@ -171,6 +182,8 @@ SuiteStarvationRamper::SuiteStarvationRamper()
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestDsdRampsUpAfterStarvation), "TestDsdRampsUpAfterStarvation");
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestDsdNoRampAtEndOfStream), "TestDsdNoRampAtEndOfStream");
     AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestDsdStarvationDuringRampUp), "TestDsdStarvationDuringRampUp");
+    AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestPullBatchWhenRunning), "TestPullBatchWhenRunning");
+    AddTest(MakeFunctor(*this, &SuiteStarvationRamper::TestThreadsScheduled), "TestThreadsScheduled");
 
     // audio data with left=0x7f, right=0x00
     iPcmData.SetBytes(kAudioPcmBytesDefault);
@@ -217,8 +230,11 @@ void SuiteStarvationRamper::Setup()
     init.SetMsgWaitCount(2);
     init.SetMsgDelayCount(2);
     iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iScheduledThreads.store(0);
+    (void)iThreadScheduled.Clear();
     iStarvationRamper = new StarvationRamper(*iMsgFactory, *this, *this, *iEventCallback,
-                                             kMaxAudioBuffer, kPriorityHigh, kRampUpDuration, 10);
+                                             kMaxAudioBuffer, kPriorityHigh, kRampUpDuration, 10,
+                                             Optional<IPipelineThreadScheduler>(this), iFlywheelTraining);
     (void)iMsgAvailable.Clear();
 }
 
@@ -420,6 +436,12 @@ void SuiteStarvationRamper::NotifyStarvationRamperBuffering(TBool aBuffering)
     iBuffering = aBuffering;
 }
 
+void SuiteStarvationRamper::ApplyToCurrentThread(PipelineThread aThread)
+{
+    iScheduledThreads.fetch_or(1 << (TUint)aThread);
+    iThreadScheduled.Signal();
+}
+
 void SuiteStarvationRamper::AddPending(Msg* aMsg)
 {
     iPendingMsgLock.Wait();
@@ -1089,11 +1111,69 @@ void SuiteStarvationRamper::TestDsdStarvationDuringRampUp()
     Quit();
 }
 
+void SuiteStarvationRamper::TestPullBatchWhenRunning()
+{
+    AddPending(iMsgFactory->CreateMsgMode(kMode));
+    AddPending(CreateDecodedStream());
+    for (TUint i=0; i<8; i++) {
+        AddPending(CreateAudio());
+    }
+    AddPending(iMsgFactory->CreateMsgHalt()); // prevents a ramp down as the reservoir empties
+
+    PullNext(EMsgMode);
+    PullNext(EMsgDecodedStream);
+    PullNext(EMsgAudioPcm); // first audio moves StarvationRamper into its Running state
+    TInt retries = 100;
+    while (iPendingMsgs.size() != 0 && retries-- > 0) {
+        Thread::Sleep(10);
+    }
+    TEST(iPendingMsgs.size() == 0);
+
+    TUint batches = 0;
+    TUint msgs = 0;
+    MsgQueueLite batch;
+    while (iJiffies < iTrackOffset) {
+        iStarvationRamper->PullBatch(batch, kMaxAudioBuffer);
+        batches++;
+        while (!batch.IsEmpty()) {
+            Msg* msg = batch.Dequeue()->Process(*this);
+            msg->RemoveRef();
+            TEST(iLastPulledMsg == EMsgAudioPcm);
+            msgs++;
+        }
+    }
+    TEST(iJiffies == iTrackOffset);
+    TEST(batches < msgs);
+
+    // halt is never batched with audio
+    iStarvationRamper->PullBatch(batch, kMaxAudioBuffer);
+    TEST(batch.NumMsgs() == 1);
+    Msg* msg = batch.Dequeue()->Process(*this);
+    msg->RemoveRef();
+    TEST(iLastPulledMsg == EMsgHalt);
+
+    AddPending(iMsgFactory->CreateMsgQuit());
+    PullNext(EMsgQuit);
+}
+
+void SuiteStarvationRamper::TestThreadsScheduled()
+{
+    // both threads apply scheduling as soon as they start, before any msg is pulled
+    iThreadScheduled.Wait(1000);
+    iThreadScheduled.Wait(1000);
+    const TUint expected = (1 << (TUint)PipelineThread::StarvationRamper)
+                         | (1 << (TUint)PipelineThread::FlywheelRamper);
+    TEST(iScheduledThreads.load() == expected);
+
+    AddPending(iMsgFactory->CreateMsgQuit());
+    PullNext(EMsgQuit);
+}
 
 
 void TestStarvationRamper()
 {
     Runner runner("StarvationRamper tests\n");
-    runner.Add(new SuiteStarvationRamper());
+    runner.Add(new SuiteStarvationRamper(FlywheelTraining::OnStarvation));
+    runner.Add(new SuiteStarvationRamper(FlywheelTraining::Incremental));
     runner.Run();
 }
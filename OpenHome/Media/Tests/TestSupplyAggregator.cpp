@@ -85,7 +85,7 @@ private:
     MsgFactory* iMsgFactory;
     TrackFactory* iTrackFactory;
     AllocatorInfoLogger iInfoAggregator;
-    SupplyAggregator* iSupply;
+    SupplyAggregatorBytes* iSupply;
     DummyStreamHandler iDummyStreamHandler;
     EMsgType iLastMsg;
     EMsgType iGenMsgType;
@@ -203,6 +203,45 @@ void SuiteSupplyAggregator::Test()
         TEST(iMsgPushCount == expectedMsgCount);
     }
     TEST(iMsgPushCount == ++expectedMsgCount);
+
+    // data read into WriteBuffer() space is passed on without being copied, filling msgs
+    iExpectFullAudioMsg = true;
+    iTestAudioData = true;
+    const TUint kWriteBytes = 40;
+    TUint written = 0;
+    do {
+        TUint bytes = kWriteBytes;
+        TByte* ptr = iSupply->WriteBuffer(bytes);
+        TEST(bytes > 0 && bytes <= kWriteBytes);
+        Bwn buf(ptr, 0, bytes);
+        for (TUint i=0; i<bytes; i++) {
+            buf.Append((TByte)('0' + (written++ % 10)));
+        }
+        iSupply->OutputData(buf);
+    } while (expectedMsgCount == iMsgPushCount);
+    TEST(++expectedMsgCount == iMsgPushCount);
+    TEST(written == EncodedAudio::kMaxBytes + kWriteBytes);
+    iExpectFullAudioMsg = false;
+    iSupply->Flush();
+    TEST(iMsgPushCount == ++expectedMsgCount);
+    TEST(iAudio.Bytes() == kWriteBytes);
+
+    // data from part way into WriteBuffer() space is moved to its start
+    TUint bytes = kWriteBytes;
+    TByte* ptr = iSupply->WriteBuffer(bytes);
+    Bwn buf(ptr, 0, bytes);
+    buf.Append(Brn("hdr"));
+    buf.Append(Brn("0123456789"));
+    iSupply->OutputData(buf.Split(3));
+    iSupply->Flush();
+    TEST(iMsgPushCount == ++expectedMsgCount);
+    TEST(iAudio == Brn("0123456789"));
+
+    // unused WriteBuffer() space doesn't result in an empty msg
+    bytes = kWriteBytes;
+    (void)iSupply->WriteBuffer(bytes);
+    iSupply->Flush();
+    TEST(iMsgPushCount == expectedMsgCount);
 }
 
 void SuiteSupplyAggregator::OutputNextNonAudioMsg()
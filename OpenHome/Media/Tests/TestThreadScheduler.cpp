@@ -0,0 +1,212 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Utils/ThreadScheduler.h>
+
+#include <string.h>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteThreadScheduler : public SuiteUnitTest, private IInfoAggregator
+{
+public:
+    SuiteThreadScheduler();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IInfoAggregator
+    void Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries) override;
+private:
+    void Query(const Brx& aQuery, WriterBwh& aWriter);
+    static TBool Contains(const Brx& aBuf, const TChar* aStr);
+    void TestParseCpuMask();
+    void TestParseCpuMaskInvalid();
+    void TestParsePolicy();
+    void TestHostPriorityPreservesOrder();
+    void TestQueryRegistered();
+    void TestQueryNotStarted();
+    void TestQueryApplied();
+    void TestQueryOtherIgnored();
+private:
+    ThreadScheduler* iScheduler;
+    IInfoProvider* iProvider;
+    std::vector<Brn> iQueries;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuiteThreadScheduler
+
+SuiteThreadScheduler::SuiteThreadScheduler()
+    : SuiteUnitTest("ThreadScheduler")
+{
+    AddTest(MakeFunctor(*this, &SuiteThreadScheduler::TestParseCpuMask), "TestParseCpuMask");
+    AddTest(MakeFunctor(*this, &SuiteThreadScheduler::TestParseCpuMaskInvalid), "TestParseCpuMaskInvalid");
+    AddTest(MakeFunctor(*this, &SuiteThreadScheduler::TestParsePolicy), "TestParsePolicy");
+    AddTest(MakeFunctor(*this, &SuiteThreadScheduler::TestHostPriorityPreservesOrder), "TestHostPriorityPreservesOrder");
+    AddTest(MakeFunctor(*this, &SuiteThreadScheduler::TestQueryRegistered), "TestQueryRegistered");
+    AddTest(MakeFunctor(*this, &SuiteThreadScheduler::TestQueryNotStarted), "TestQueryNotStarted");
+    AddTest(MakeFunctor(*this, &SuiteThreadScheduler::TestQueryApplied), "TestQueryApplied");
+    AddTest(MakeFunctor(*this, &SuiteThreadScheduler::TestQueryOtherIgnored), "TestQueryOtherIgnored");
+}
+
+void SuiteThreadScheduler::Setup()
+{
+    iProvider = nullptr;
+    iQueries.clear();
+    iScheduler = new ThreadScheduler(*this, ThreadSchedPolicy::Default);
+}
+
+void SuiteThreadScheduler::TearDown()
+{
+    delete iScheduler;
+}
+
+void SuiteThreadScheduler::Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries)
+{
+    iProvider = &aProvider;
+    iQueries = aSupportedQueries;
+}
+
+void SuiteThreadScheduler::Query(const Brx& aQuery, WriterBwh& aWriter)
+{
+    ASSERT(iProvider != nullptr);
+    iProvider->QueryInfo(aQuery, aWriter);
+}
+
+TBool SuiteThreadScheduler::Contains(const Brx& aBuf, const TChar* aStr)
+{ // static
+    Bwh buf(aBuf.Bytes() + 1);
+    buf.Replace(aBuf);
+    return strstr((const TChar*)buf.PtrZ(), aStr) != nullptr;
+}
+
+void SuiteThreadScheduler::TestParseCpuMask()
+{
+    TUint64 mask = 0xff;
+    TEST(ThreadScheduler::TryParseCpuMask(Brn("any"), mask));
+    TEST(mask == 0);
+    TEST(ThreadScheduler::TryParseCpuMask(Brn("0"), mask));
+    TEST(mask == 0x1);
+    TEST(ThreadScheduler::TryParseCpuMask(Brn("0,2"), mask));
+    TEST(mask == 0x5);
+    TEST(ThreadScheduler::TryParseCpuMask(Brn("1-3"), mask));
+    TEST(mask == 0xe);
+    TEST(ThreadScheduler::TryParseCpuMask(Brn("2-2"), mask));
+    TEST(mask == 0x4);
+    TEST(ThreadScheduler::TryParseCpuMask(Brn("0,4-5,63"), mask));
+    TEST(mask == (0x31 | ((TUint64)1 << 63)));
+    TEST(ThreadScheduler::TryParseCpuMask(Brn("3,1"), mask));
+    TEST(mask == 0xa);
+}
+
+void SuiteThreadScheduler::TestParseCpuMaskInvalid()
+{
+    const TChar* invalid[] = { "", "Any", "a", "-1", "1-", "3-1", "1--2", "1,", ",1", "1,,2", "1 ", "64", "0-64", "100000000000" };
+    for (auto str : invalid) {
+        TUint64 mask = 0x5;
+        TEST(!ThreadScheduler::TryParseCpuMask(Brn(str), mask));
+        TEST(mask == 0x5);
+    }
+}
+
+void SuiteThreadScheduler::TestParsePolicy()
+{
+    const ThreadSchedPolicy policies[] = { ThreadSchedPolicy::Default, ThreadSchedPolicy::Fifo, ThreadSchedPolicy::RoundRobin };
+    for (auto policy : policies) {
+        ThreadSchedPolicy parsed = (policy == ThreadSchedPolicy::Default? ThreadSchedPolicy::Fifo : ThreadSchedPolicy::Default);
+        TEST(ThreadScheduler::TryParsePolicy(Brn(ThreadScheduler::Name(policy)), parsed));
+        TEST(parsed == policy);
+    }
+    ThreadSchedPolicy parsed = ThreadSchedPolicy::Fifo;
+    TEST(!ThreadScheduler::TryParsePolicy(Brn("FIFO"), parsed));
+    TEST(!ThreadScheduler::TryParsePolicy(Brn("other"), parsed));
+    TEST(!ThreadScheduler::TryParsePolicy(Brx::Empty(), parsed));
+    TEST(parsed == ThreadSchedPolicy::Fifo);
+}
+
+void SuiteThreadScheduler::TestHostPriorityPreservesOrder()
+{
+    const ThreadSchedPolicy policies[] = { ThreadSchedPolicy::Fifo, ThreadSchedPolicy::RoundRobin };
+    for (auto policy : policies) {
+        const TInt lowest = ThreadScheduler::HostPriority(policy, kPriorityLowest);
+        const TInt highest = ThreadScheduler::HostPriority(policy, kPriorityHighest);
+        TEST(lowest < highest);
+#ifdef __linux__
+        // priorities outside the pipeline's range are clamped to the host's real-time range
+        TEST(ThreadScheduler::HostPriority(policy, kPrioritySystemLowest) == lowest);
+        TEST(ThreadScheduler::HostPriority(policy, kPrioritySystemHighest) == highest);
+#endif
+        TInt prev = lowest;
+        for (TUint priority=kPriorityLowest+1; priority<=kPriorityHighest; priority++) {
+            const TInt host = ThreadScheduler::HostPriority(policy, priority);
+            TEST(host >= prev);
+            TEST(host <= highest);
+            prev = host;
+        }
+    }
+}
+
+void SuiteThreadScheduler::TestQueryRegistered()
+{
+    TEST(iProvider != nullptr);
+    TEST(iQueries.size() == 1);
+    TEST(iQueries[0] == ThreadScheduler::kQueryThreads);
+    TEST(ThreadScheduler::kQueryThreads == Brn("threads"));
+}
+
+void SuiteThreadScheduler::TestQueryNotStarted()
+{
+    iScheduler->SetCpuMask(PipelineThread::Codec, 0x5);
+    iScheduler->SetPriority(PipelineThread::Codec, 48);
+    WriterBwh writer(1024);
+    Query(ThreadScheduler::kQueryThreads, writer);
+    const Brx& info = writer.Buffer();
+    TEST(Contains(info, "policy=default memoryLocked=false\n"));
+    TEST(Contains(info, "CodecController: cpus=0,2 priority=48 (not started)\n"));
+    TEST(Contains(info, "Filler: cpus=any"));
+    TEST(Contains(info, "StarvationRamper: cpus=any"));
+    TEST(Contains(info, "FlywheelRamper: cpus=any"));
+    TEST(Contains(info, "Animator: cpus=any"));
+    TEST(!Contains(info, "hostPriority"));
+}
+
+void SuiteThreadScheduler::TestQueryApplied()
+{
+    // default policy and no cpu mask leave this thread's host scheduling untouched
+    iScheduler->SetPriority(PipelineThread::Animator, 50);
+    iScheduler->ApplyToCurrentThread(PipelineThread::Animator);
+    WriterBwh writer(1024);
+    Query(ThreadScheduler::kQueryThreads, writer);
+    const Brx& info = writer.Buffer();
+    TEST(Contains(info, "Animator: cpus=any priority=50\n"));
+    TEST(Contains(info, "Filler: cpus=any priority="));
+    TEST(Contains(info, "(not started)"));
+    TEST(!Contains(info, "errno"));
+}
+
+void SuiteThreadScheduler::TestQueryOtherIgnored()
+{
+    WriterBwh writer(1024);
+    Query(Brn("msgs"), writer);
+    TEST(writer.Buffer().Bytes() == 0);
+}
+
+
+
+void TestThreadScheduler()
+{
+    Runner runner("ThreadScheduler tests\n");
+    runner.Add(new SuiteThreadScheduler());
+    runner.Run();
+}
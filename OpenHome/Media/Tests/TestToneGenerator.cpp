@@ -523,7 +523,7 @@ void SuiteGeneratorAny::Setup()
     init.SetMsgQuitCount(kMsgCountQuit);
     iMsgFactory = new MsgFactory(*iAllocatorInfoLogger, init);
 
-    iEncodedAudioReservoir = new EncodedAudioReservoir(*iMsgFactory, *this, kMsgCountEncodedAudio - 10, kEncodedReservoirMaxStreams);
+    iEncodedAudioReservoir = new EncodedAudioReservoir(*iMsgFactory, *this, kMsgCountEncodedAudio - 10, kEncodedReservoirMaxStreams, ReservoirQueue::Locked);
     iContainer = new Codec::ContainerController(*iMsgFactory, *iEncodedAudioReservoir, *this, true);
     iCodecController = new Codec::CodecController(*iMsgFactory, *iContainer, /*IPipelineElementDownstream*/ *this, *this, Jiffies::kPerMs * 5, kPriorityNormal, true);
     iCodecController->AddCodec(Codec::CodecFactory::NewWav(*this));
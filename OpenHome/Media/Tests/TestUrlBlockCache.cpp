@@ -0,0 +1,369 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/Protocol/UrlBlockCache.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Private/Stream.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+namespace TestUrlBlockCache {
+
+class UrlBlockWriterSource : public IUrlBlockWriter
+{
+public:
+    UrlBlockWriterSource();
+    void SetStreamBytes(TUint64 aBytes);
+    static TByte ByteAt(TUint64 aOffset);
+    TUint Requests() const;
+    TUint64 LastOffset() const;
+    TUint LastBytes() const;
+    const Brx& LastUrl() const;
+public: // from IUrlBlockWriter
+    TBool TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes) override;
+private:
+    TUint64 iStreamBytes;
+    TUint iRequests;
+    TUint64 iLastOffset;
+    TUint iLastBytes;
+    Bws<64> iLastUrl;
+};
+
+class WriterBuffer : public IWriter
+{
+public:
+    WriterBuffer();
+    const Brx& Buffer() const;
+    void Reset();
+public: // from IWriter
+    void Write(TByte aValue) override;
+    void Write(const Brx& aBuffer) override;
+    void WriteFlush() override;
+private:
+    Bws<2 * UrlBlockCache::kBlockBytes> iBuf;
+};
+
+class SuiteUrlBlockCache : public SuiteUnitTest
+{
+    static const TUint kStreamBytes = 10 * UrlBlockCache::kBlockBytes + 100;
+public:
+    SuiteUrlBlockCache();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    TBool Read(TUint64 aOffset, TUint aBytes, const TChar* aUrl = "http://host/a.m4a");
+    TBool DataValid(TUint64 aOffset, TUint aBytes) const;
+    void TestSequentialReadsShareFetch();
+    void TestReadAhead();
+    void TestReadSpansBlocks();
+    void TestEndOfStream();
+    void TestLargeReadNotCached();
+    void TestUrlChangeDiscards();
+    void TestLruEviction();
+    void TestUpstreamFailure();
+    void TestStats();
+private:
+    UrlBlockWriterSource* iSource;
+    UrlBlockCache* iCache;
+    WriterBuffer iWriter;
+};
+
+} // namespace TestUrlBlockCache
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestUrlBlockCache;
+
+
+// UrlBlockWriterSource
+
+UrlBlockWriterSource::UrlBlockWriterSource()
+    : iStreamBytes(0)
+    , iRequests(0)
+    , iLastOffset(0)
+    , iLastBytes(0)
+{
+}
+
+void UrlBlockWriterSource::SetStreamBytes(TUint64 aBytes)
+{
+    iStreamBytes = aBytes;
+}
+
+TByte UrlBlockWriterSource::ByteAt(TUint64 aOffset)
+{ // static
+    return (TByte)(aOffset % 251);
+}
+
+TUint UrlBlockWriterSource::Requests() const
+{
+    return iRequests;
+}
+
+TUint64 UrlBlockWriterSource::LastOffset() const
+{
+    return iLastOffset;
+}
+
+TUint UrlBlockWriterSource::LastBytes() const
+{
+    return iLastBytes;
+}
+
+const Brx& UrlBlockWriterSource::LastUrl() const
+{
+    return iLastUrl;
+}
+
+TBool UrlBlockWriterSource::TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes)
+{
+    iRequests++;
+    iLastOffset = aOffset;
+    iLastBytes = aBytes;
+    iLastUrl.Replace(aUrl);
+    // behave like ProtocolHttp: a range starting past the end of the stream is rejected
+    // outright; one that runs past the end returns the bytes up to the end then fails
+    if (aOffset >= iStreamBytes) {
+        return false;
+    }
+    const TUint64 end = aOffset + aBytes;
+    Bws<1024> buf;
+    for (TUint64 offset = aOffset; offset < end && offset < iStreamBytes; offset++) {
+        buf.Append(ByteAt(offset));
+        if (buf.Bytes() == buf.MaxBytes()) {
+            aWriter.Write(buf);
+            buf.SetBytes(0);
+        }
+    }
+    aWriter.Write(buf);
+    return (end <= iStreamBytes);
+}
+
+
+// WriterBuffer
+
+WriterBuffer::WriterBuffer()
+{
+}
+
+const Brx& WriterBuffer::Buffer() const
+{
+    return iBuf;
+}
+
+void WriterBuffer::Reset()
+{
+    iBuf.SetBytes(0);
+}
+
+void WriterBuffer::Write(TByte aValue)
+{
+    iBuf.Append(aValue);
+}
+
+void WriterBuffer::Write(const Brx& aBuffer)
+{
+    iBuf.Append(aBuffer);
+}
+
+void WriterBuffer::WriteFlush()
+{
+}
+
+
+// SuiteUrlBlockCache
+
+SuiteUrlBlockCache::SuiteUrlBlockCache()
+    : SuiteUnitTest("SuiteUrlBlockCache")
+{
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestSequentialReadsShareFetch), "TestSequentialReadsShareFetch");
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestReadAhead), "TestReadAhead");
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestReadSpansBlocks), "TestReadSpansBlocks");
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestEndOfStream), "TestEndOfStream");
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestLargeReadNotCached), "TestLargeReadNotCached");
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestUrlChangeDiscards), "TestUrlChangeDiscards");
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestLruEviction), "TestLruEviction");
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestUpstreamFailure), "TestUpstreamFailure");
+    AddTest(MakeFunctor(*this, &SuiteUrlBlockCache::TestStats), "TestStats");
+}
+
+void SuiteUrlBlockCache::Setup()
+{
+    iSource = new UrlBlockWriterSource();
+    iSource->SetStreamBytes(kStreamBytes);
+    iCache = new UrlBlockCache(*iSource);
+}
+
+void SuiteUrlBlockCache::TearDown()
+{
+    delete iCache;
+    delete iSource;
+}
+
+TBool SuiteUrlBlockCache::Read(TUint64 aOffset, TUint aBytes, const TChar* aUrl)
+{
+    iWriter.Reset();
+    return iCache->TryGet(iWriter, Brn(aUrl), aOffset, aBytes);
+}
+
+TBool SuiteUrlBlockCache::DataValid(TUint64 aOffset, TUint aBytes) const
+{
+    const Brx& buf = iWriter.Buffer();
+    if (buf.Bytes() != aBytes) {
+        return false;
+    }
+    for (TUint i=0; i<aBytes; i++) {
+        if (buf[i] != UrlBlockWriterSource::ByteAt(aOffset + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SuiteUrlBlockCache::TestSequentialReadsShareFetch()
+{
+    static const TUint kReadBytes = 1024;
+    for (TUint64 offset=0; offset<UrlBlockCache::kBlockBytes; offset+=kReadBytes) {
+        TEST(Read(offset, kReadBytes));
+        TEST(DataValid(offset, kReadBytes));
+    }
+    TEST(iSource->Requests() == 1);
+}
+
+void SuiteUrlBlockCache::TestReadAhead()
+{
+    const TUint64 offset = 3 * UrlBlockCache::kBlockBytes + 10;
+    TEST(Read(offset, 100));
+    TEST(DataValid(offset, 100));
+    TEST(iSource->Requests() == 1);
+    TEST(iSource->LastOffset() == 3 * UrlBlockCache::kBlockBytes);
+    TEST(iSource->LastBytes() == (1 + UrlBlockCache::kReadAheadBlocks) * UrlBlockCache::kBlockBytes);
+
+    // blocks that were read ahead are served without another fetch
+    const TUint64 aheadOffset = (3 + UrlBlockCache::kReadAheadBlocks) * UrlBlockCache::kBlockBytes;
+    TEST(Read(aheadOffset, 100));
+    TEST(DataValid(aheadOffset, 100));
+    TEST(iSource->Requests() == 1);
+
+    // read ahead stops at a cached block
+    TEST(Read(UrlBlockCache::kBlockBytes, 100));
+    TEST(iSource->Requests() == 2);
+    TEST(iSource->LastOffset() == UrlBlockCache::kBlockBytes);
+    TEST(iSource->LastBytes() == 2 * UrlBlockCache::kBlockBytes);
+}
+
+void SuiteUrlBlockCache::TestReadSpansBlocks()
+{
+    const TUint64 offset = UrlBlockCache::kBlockBytes - 10;
+    TEST(Read(offset, 20));
+    TEST(DataValid(offset, 20));
+    TEST(iSource->Requests() == 1);
+    TEST(iSource->LastOffset() == 0);
+
+    const TUint64 offset2 = 2 * UrlBlockCache::kBlockBytes - 1000;
+    TEST(Read(offset2, UrlBlockCache::kBlockBytes));
+    TEST(DataValid(offset2, UrlBlockCache::kBlockBytes));
+    TEST(iSource->Requests() == 1);
+}
+
+void SuiteUrlBlockCache::TestEndOfStream()
+{
+    TEST(Read(kStreamBytes - 50, 50));
+    TEST(DataValid(kStreamBytes - 50, 50));
+    // the short read ahead still returns the tail so no second request is needed
+    TEST(iSource->Requests() == 1);
+
+    // data up to the end of the stream is cached even though the read ahead failed
+    TEST(Read(kStreamBytes - 100, 100));
+    TEST(DataValid(kStreamBytes - 100, 100));
+    TEST(iSource->Requests() == 1);
+
+    TEST(!Read(kStreamBytes - 10, 20));
+    TEST(!Read(kStreamBytes + 10, 20));
+}
+
+void SuiteUrlBlockCache::TestLargeReadNotCached()
+{
+    const TUint bytes = UrlBlockCache::kBlockBytes + 1;
+    TEST(Read(100, bytes));
+    TEST(DataValid(100, bytes));
+    TEST(iSource->Requests() == 1);
+    TEST(iSource->LastOffset() == 100);
+    TEST(iSource->LastBytes() == bytes);
+    TEST(Read(100, 10));
+    TEST(iSource->Requests() == 2);
+}
+
+void SuiteUrlBlockCache::TestUrlChangeDiscards()
+{
+    TEST(Read(0, 100, "http://host/a.m4a"));
+    TEST(Read(0, 100, "http://host/a.m4a"));
+    TEST(iSource->Requests() == 1);
+    TEST(Read(0, 100, "http://host/b.m4a"));
+    TEST(DataValid(0, 100));
+    TEST(iSource->Requests() == 2);
+    TEST(iSource->LastUrl() == Brn("http://host/b.m4a"));
+    TEST(Read(0, 100, "http://host/a.m4a"));
+    TEST(iSource->Requests() == 3);
+}
+
+void SuiteUrlBlockCache::TestLruEviction()
+{
+    static const TUint kFetchBlocks = 1 + UrlBlockCache::kReadAheadBlocks;
+    const TUint fetches = (UrlBlockCache::kMaxBlocks + kFetchBlocks - 1) / kFetchBlocks;
+    TUint64 offset = 0;
+    TUint requests = 0;
+    // fetch non-overlapping ranges until the cache's capacity is exceeded
+    iSource->SetStreamBytes(100 * UrlBlockCache::kBlockBytes);
+    for (TUint i=0; i<fetches; i++) {
+        TEST(Read(offset, 10));
+        TEST(iSource->Requests() == ++requests);
+        offset += 10 * UrlBlockCache::kBlockBytes;
+    }
+    if (fetches * kFetchBlocks > UrlBlockCache::kMaxBlocks) {
+        // the first block fetched was least recently used so was evicted
+        TEST(Read(0, 10));
+        TEST(iSource->Requests() == ++requests);
+    }
+    // the most recent fetch is still cached
+    TEST(Read(offset - 10 * UrlBlockCache::kBlockBytes, 10));
+    TEST(iSource->Requests() == requests);
+}
+
+void SuiteUrlBlockCache::TestUpstreamFailure()
+{
+    iSource->SetStreamBytes(0);
+    TEST(!Read(0, 100));
+    TEST(iWriter.Buffer().Bytes() == 0);
+    // failure isn't cached
+    iSource->SetStreamBytes(kStreamBytes);
+    TEST(Read(0, 100));
+    TEST(DataValid(0, 100));
+}
+
+void SuiteUrlBlockCache::TestStats()
+{
+    TEST(Read(0, 100));
+    TEST(Read(100, 100));
+    TEST(Read(200, 100));
+    TEST(Read(0, UrlBlockCache::kBlockBytes + 1));
+    TUint64 requests, hits, fetches, fetchedBytes;
+    iCache->GetStats(requests, hits, fetches, fetchedBytes);
+    TEST(requests == 4);
+    TEST(hits == 2);
+    TEST(fetches == 2);
+    TEST(fetchedBytes == (1 + UrlBlockCache::kReadAheadBlocks) * UrlBlockCache::kBlockBytes + UrlBlockCache::kBlockBytes + 1);
+}
+
+
+
+void TestUrlBlockCache()
+{
+    Runner runner("UrlBlockCache tests\n");
+    runner.Add(new SuiteUrlBlockCache());
+    runner.Run();
+}
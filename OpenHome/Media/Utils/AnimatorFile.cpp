@@ -0,0 +1,378 @@
+#include <OpenHome/Media/Utils/AnimatorFile.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/ByteSwap.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Media/Debug.h>
+
+#include <algorithm>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// AnimatorFile
+
+const TUint AnimatorFile::kSupportedMsgTypes =   eMode
+                                               | eDrain
+                                               | eHalt
+                                               | eDecodedStream
+                                               | ePlayable
+                                               | eQuit;
+
+AnimatorFile::AnimatorFile(Environment& aEnv, IPipeline& aPipeline, IWriter& aSink, Format aFormat, Pacing aPacing, TBool aPullable)
+    : PipelineElement(kSupportedMsgTypes)
+    , iPipeline(aPipeline)
+    , iSink(aSink)
+    , iFormat(aFormat)
+    , iPacing(aPacing)
+    , iPullable(aPullable)
+    , iOsCtx(aEnv.OsCtx())
+    , iSem("DRVF", 0)
+    , iSemQuit("DRVQ", 0)
+    , iStreamFormat(AudioFormat::Undefined)
+    , iSampleRate(0)
+    , iNumChannels(0)
+    , iBitDepth(0)
+    , iWavSampleRate(0)
+    , iWavNumChannels(0)
+    , iWavBitDepth(0)
+    , iWavHeaderWritten(false)
+    , iBudgetJiffies(0)
+    , iLastTimeUs(0)
+    , iPullValue(IPullableClock::kNominalFreq)
+    , iAudioBytes(0)
+    , iAudioJiffies(0)
+    , iPlayableMsgs(0)
+    , iSinkFailed(false)
+    , iQuit(false)
+{
+    iPipeline.SetAnimator(*this);
+    iThread = new ThreadFunctor("PipelineAnimator", MakeFunctor(*this, &AnimatorFile::DriverThread), kPrioritySystemHighest);
+    iThread->Start();
+}
+
+AnimatorFile::~AnimatorFile()
+{
+    delete iThread;
+}
+
+void AnimatorFile::WaitForQuit()
+{
+    iSemQuit.Wait();
+    iSemQuit.Signal(); // allow for multiple callers
+}
+
+TUint64 AnimatorFile::AudioBytes() const
+{
+    return iAudioBytes.load();
+}
+
+TUint64 AnimatorFile::AudioJiffies() const
+{
+    return iAudioJiffies.load();
+}
+
+TUint64 AnimatorFile::PlayableMsgs() const
+{
+    return iPlayableMsgs.load();
+}
+
+TBool AnimatorFile::SinkFailed() const
+{
+    return iSinkFailed.load();
+}
+
+TBool AnimatorFile::GetWavFormat(TUint& aSampleRate, TUint& aNumChannels, TUint& aBitDepth) const
+{
+    if (!iWavHeaderWritten) {
+        return false;
+    }
+    aSampleRate = iWavSampleRate;
+    aNumChannels = iWavNumChannels;
+    aBitDepth = iWavBitDepth;
+    return true;
+}
+
+void AnimatorFile::WriteWavHeader(IWriter& aWriter, TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint aDataBytes)
+{ // static
+    static const TUint kFmtChunkBytes = 16;
+    static const TUint kAudioFormatPcm = 1;
+    const TUint riffBytes = (aDataBytes > 0xffffffff - (4+8+kFmtChunkBytes+8)? 0xffffffff : 4+8+kFmtChunkBytes+8+aDataBytes);
+    WriterBinary writerBin(aWriter);
+    aWriter.Write(Brn("RIFF"));
+    writerBin.WriteUint32Le(riffBytes);
+    aWriter.Write(Brn("WAVE"));
+    aWriter.Write(Brn("fmt "));
+    writerBin.WriteUint32Le(kFmtChunkBytes);
+    writerBin.WriteUint16Le(kAudioFormatPcm);
+    writerBin.WriteUint16Le(aNumChannels);
+    writerBin.WriteUint32Le(aSampleRate);
+    writerBin.WriteUint32Le(aSampleRate * aNumChannels * (aBitDepth/8)); // byte rate
+    writerBin.WriteUint16Le(aNumChannels * (aBitDepth/8));               // block align
+    writerBin.WriteUint16Le(aBitDepth);
+    aWriter.Write(Brn("data"));
+    writerBin.WriteUint32Le(aDataBytes);
+}
+
+void AnimatorFile::DriverThread()
+{
+    iLastTimeUs = OsTimeInUs(iOsCtx);
+    iBudgetJiffies = kTimerFrequencyMs * Jiffies::kPerMs;
+    try {
+        while (!iQuit) {
+            if (iPacing == Pacing::FreeRun) {
+                PullAndProcess();
+                continue;
+            }
+            // consume whole msgs, carrying any overrun into the next period
+            while (iBudgetJiffies > 0 && !iQuit) {
+                PullAndProcess();
+            }
+            if (iQuit) {
+                break;
+            }
+            try {
+                iSem.Wait(kTimerFrequencyMs);
+            }
+            catch (Timeout&) {}
+            const TUint64 now = OsTimeInUs(iOsCtx);
+            TUint64 elapsedUs = now - iLastTimeUs;
+            iLastTimeUs = now;
+            if (elapsedUs > 100 * 1000) { // assume delay caused by drop-out.  process regular amount of audio
+                elapsedUs = kTimerFrequencyMs * 1000;
+            }
+            TUint64 jiffies = (elapsedUs * Jiffies::kPerMs) / 1000;
+            const TUint64 pull = iPullValue.load();
+            if (pull != IPullableClock::kNominalFreq) {
+                jiffies = (jiffies * pull) / IPullableClock::kNominalFreq;
+            }
+            iBudgetJiffies += (TInt64)jiffies;
+        }
+    }
+    catch (ThreadKill&) {}
+
+    // pull until the pipeline is emptied
+    while (!iQuit) {
+        PullAndProcess();
+    }
+    try {
+        iSink.WriteFlush();
+    }
+    catch (WriterError&) {
+        iSinkFailed.store(true);
+    }
+    iSemQuit.Signal();
+}
+
+void AnimatorFile::PullAndProcess()
+{
+    Msg* msg = iPipeline.Pull();
+    msg = msg->Process(*this);
+    ASSERT(msg == nullptr);
+}
+
+void AnimatorFile::Write(const Brx& aData)
+{
+    if (iSinkFailed.load()) {
+        return;
+    }
+    try {
+        iSink.Write(aData);
+        iAudioBytes.fetch_add(aData.Bytes());
+    }
+    catch (WriterError&) {
+        LOG_ERROR(kPipeline, "AnimatorFile - error writing to sink.  Discarding further audio\n");
+        iSinkFailed.store(true);
+    }
+}
+
+void AnimatorFile::WriteWav(const Brx& aData, TUint aSubsampleBytes)
+{
+    const TByte* src = aData.Ptr();
+    TUint remaining = aData.Bytes();
+    const TUint maxBytes = (iWavBuf.MaxBytes() / (aSubsampleBytes * 2)) * (aSubsampleBytes * 2);
+    while (remaining > 0) {
+        const TUint bytes = std::min(remaining, maxBytes);
+        TByte* dest = const_cast<TByte*>(iWavBuf.Ptr());
+        switch (aSubsampleBytes)
+        {
+        case 1: // wav stores 8-bit pcm as unsigned
+            for (TUint i=0; i<bytes; i++) {
+                dest[i] = src[i] ^ 0x80;
+            }
+            break;
+        case 2: // byte swapping is its own inverse so ToBigEndian* also converts big to little endian
+            ByteSwap::ToBigEndian16(src, dest, bytes);
+            break;
+        case 3:
+            ByteSwap::ToBigEndian24(src, dest, bytes);
+            break;
+        case 4:
+            ByteSwap::ToBigEndian32(src, dest, bytes);
+            break;
+        default:
+            ASSERTS();
+        }
+        iWavBuf.SetBytes(bytes);
+        Write(iWavBuf);
+        src += bytes;
+        remaining -= bytes;
+    }
+}
+
+Msg* AnimatorFile::ProcessMsg(MsgMode* aMsg)
+{
+    iPullValue.store(IPullableClock::kNominalFreq);
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorFile::ProcessMsg(MsgDrain* aMsg)
+{
+    if (iSampleRate != 0) {
+        PullClock(IPullableClock::kNominalFreq);
+    }
+    aMsg->ReportDrained();
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorFile::ProcessMsg(MsgHalt* aMsg)
+{
+    // don't accumulate time while halted; the next Pull() may block indefinitely
+    iBudgetJiffies = 0;
+    aMsg->ReportHalted();
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorFile::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    const DecodedStreamInfo& stream = aMsg->StreamInfo();
+    iStreamFormat = stream.Format();
+    iSampleRate = stream.SampleRate();
+    iNumChannels = stream.NumChannels();
+    iBitDepth = stream.BitDepth();
+    LOG(kPipeline, "AnimatorFile - MsgDecodedStream - %u/%u/%u\n", iSampleRate, iBitDepth, iNumChannels);
+    if (iFormat == Format::Wav && iStreamFormat == AudioFormat::Pcm) {
+        if (!iWavHeaderWritten) {
+            iWavSampleRate = iSampleRate;
+            iWavNumChannels = iNumChannels;
+            iWavBitDepth = iBitDepth;
+            iWavHeaderWritten = true;
+            if (!iSinkFailed.load()) {
+                try {
+                    WriteWavHeader(iSink, iSampleRate, iNumChannels, iBitDepth, 0xffffffff);
+                }
+                catch (WriterError&) {
+                    iSinkFailed.store(true);
+                }
+            }
+        }
+        else if (iSampleRate != iWavSampleRate || iNumChannels != iWavNumChannels || iBitDepth != iWavBitDepth) {
+            Log::Print("AnimatorFile - WARNING: stream format %u/%u/%u differs from wav header %u/%u/%u\n",
+                       iSampleRate, iBitDepth, iNumChannels, iWavSampleRate, iWavBitDepth, iWavNumChannels);
+        }
+    }
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorFile::ProcessMsg(MsgPlayable* aMsg)
+{
+    iPlayableMsgs.fetch_add(1);
+    const TUint jiffies = aMsg->Jiffies();
+    iAudioJiffies.fetch_add(jiffies);
+    iBudgetJiffies -= jiffies;
+    if (!iSinkFailed.load()) {
+        if (iStreamFormat == AudioFormat::Dsd) {
+            aMsg->Read(static_cast<IDsdProcessor&>(*this));
+        }
+        else {
+            aMsg->Read(static_cast<IPcmProcessor&>(*this));
+        }
+    }
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorFile::ProcessMsg(MsgQuit* aMsg)
+{
+    iQuit = true;
+    iBudgetJiffies = 0;
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+void AnimatorFile::BeginBlock()
+{
+}
+
+void AnimatorFile::ProcessFragment(const Brx& aData, TUint /*aNumChannels*/, TUint aSubsampleBytes)
+{
+    if (iFormat == Format::Wav && iStreamFormat == AudioFormat::Pcm) {
+        WriteWav(aData, aSubsampleBytes);
+    }
+    else {
+        Write(aData);
+    }
+}
+
+void AnimatorFile::ProcessSilence(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes)
+{
+    ProcessFragment(aData, aNumChannels, aSubsampleBytes);
+}
+
+void AnimatorFile::EndBlock()
+{
+}
+
+void AnimatorFile::Flush()
+{
+}
+
+void AnimatorFile::PullClock(TUint aMultiplier)
+{
+    if (!iPullable || iPullValue.load() == aMultiplier) {
+        return;
+    }
+    iPullValue.store(aMultiplier);
+    LOG(kPipeline, "AnimatorFile::PullClock now at %u%%\n", (TUint)((aMultiplier * 100ULL) / IPullableClock::kNominalFreq));
+}
+
+TUint AnimatorFile::MaxPull() const
+{
+    static const TUint kMaxPull = (kNominalFreq / 100) * 4; // 4% of nominal
+    return kMaxPull;
+}
+
+TUint AnimatorFile::PipelineAnimatorBufferJiffies() const
+{
+    return 0;
+}
+
+TUint AnimatorFile::PipelineAnimatorDelayJiffies(AudioFormat /*aFormat*/, TUint /*aSampleRate*/,
+                                                 TUint /*aBitDepth*/, TUint /*aNumChannels*/) const
+{
+    return 0;
+}
+
+TUint AnimatorFile::PipelineAnimatorDsdBlockSizeWords() const
+{
+    return 1;
+}
+
+TUint AnimatorFile::PipelineAnimatorMaxBitDepth() const
+{
+    return 32;
+}
+
+void AnimatorFile::PipelineAnimatorGetMaxSampleRates(TUint& aPcm, TUint& aDsd) const
+{
+    aPcm = 384000;
+    aDsd = (iFormat == Format::Wav? 0 : 11289600);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Media/Pipeline/Pipeline.h>
+
+#include <atomic>
+
+namespace OpenHome {
+    class Environment;
+    class IWriter;
+namespace Media {
+
+/*
+ * Animator that writes the pipeline's output to an IWriter (file, FIFO, stdout...) instead of
+ * audio hardware.
+ *
+ * RealTime pacing consumes audio at the stream's sample rate (adjusted by PullClock), as
+ * AnimatorBasic does.  FreeRun pulls as fast as the pipeline can deliver audio.
+ *
+ * Raw output is packed big endian pcm (or dsd) exactly as read from MsgPlayable.
+ * Wav output is little endian pcm preceded by a single header describing the first stream.
+ * Its sizes are unknown while streaming so are written as 0xffffffff; callers writing to a
+ * seekable file can rewrite the header using WriteWavHeader() and AudioBytes() once finished.
+ * Dsd is not supported for Wav output.
+ */
+class AnimatorFile : public PipelineElement
+                   , public IPullableClock
+                   , public IPipelineAnimator
+                   , private IPcmProcessor
+                   , private IDsdProcessor
+                   , private INonCopyable
+{
+    static const TUint kTimerFrequencyMs = 5;
+    static const TUint kSupportedMsgTypes;
+public:
+    static const TUint kWavHeaderBytes = 44;
+    enum class Format
+    {
+        Raw,
+        Wav
+    };
+    enum class Pacing
+    {
+        RealTime,
+        FreeRun
+    };
+public:
+    AnimatorFile(Environment& aEnv, IPipeline& aPipeline, IWriter& aSink, Format aFormat, Pacing aPacing, TBool aPullable);
+    ~AnimatorFile();
+    void WaitForQuit(); // blocks until MsgQuit has been pulled and the sink flushed
+    TUint64 AudioBytes() const;
+    TUint64 AudioJiffies() const;
+    TUint64 PlayableMsgs() const;
+    TBool SinkFailed() const; // sink threw WriterError.  Audio is discarded from then on
+    TBool GetWavFormat(TUint& aSampleRate, TUint& aNumChannels, TUint& aBitDepth) const; // false if no header written yet
+    static void WriteWavHeader(IWriter& aWriter, TUint aSampleRate, TUint aNumChannels, TUint aBitDepth, TUint aDataBytes);
+private:
+    void DriverThread();
+    void PullAndProcess();
+    void Write(const Brx& aData);
+    void WriteWav(const Brx& aData, TUint aSubsampleBytes);
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private: // from IPcmProcessor, IDsdProcessor
+    void BeginBlock() override;
+    void ProcessFragment(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override; // also IDsdProcessor
+    void ProcessSilence(const Brx& aData, TUint aNumChannels, TUint aSubsampleBytes) override;
+    void EndBlock() override;
+    void Flush() override;
+private: // from IPullableClock
+    void PullClock(TUint aMultiplier) override;
+    TUint MaxPull() const override;
+private: // from IPipelineAnimator
+    TUint PipelineAnimatorBufferJiffies() const override;
+    TUint PipelineAnimatorDelayJiffies(AudioFormat aFormat, TUint aSampleRate, TUint aBitDepth, TUint aNumChannels) const override;
+    TUint PipelineAnimatorDsdBlockSizeWords() const override;
+    TUint PipelineAnimatorMaxBitDepth() const override;
+    void PipelineAnimatorGetMaxSampleRates(TUint& aPcm, TUint& aDsd) const override;
+private:
+    IPipeline& iPipeline;
+    IWriter& iSink;
+    const Format iFormat;
+    const Pacing iPacing;
+    const TBool iPullable;
+    OsContext* iOsCtx;
+    Semaphore iSem;
+    Semaphore iSemQuit;
+    ThreadFunctor* iThread;
+    Bws<DecodedAudio::kMaxBytes> iWavBuf;
+    AudioFormat iStreamFormat;
+    TUint iSampleRate;
+    TUint iNumChannels;
+    TUint iBitDepth;
+    TUint iWavSampleRate;
+    TUint iWavNumChannels;
+    TUint iWavBitDepth;
+    TBool iWavHeaderWritten;
+    TInt64 iBudgetJiffies;
+    TUint64 iLastTimeUs;
+    std::atomic<TUint64> iPullValue;
+    std::atomic<TUint64> iAudioBytes;
+    std::atomic<TUint64> iAudioJiffies;
+    std::atomic<TUint64> iPlayableMsgs;
+    std::atomic<TBool> iSinkFailed;
+    TBool iQuit;
+};
+
+} // namespace Media
+} // namespace OpenHome
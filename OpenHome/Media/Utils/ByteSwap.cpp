@@ -0,0 +1,311 @@
+#include <OpenHome/Media/Utils/ByteSwap.h>
+#include <OpenHome/Media/Utils/CpuFeatures.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+#if defined(OH_SIMD_X86)
+# include <immintrin.h>
+#endif
+#if defined(OH_SIMD_NEON)
+# include <arm_neon.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// Kernels
+// Each vectorised kernel handles as many whole vectors as it can then passes the remainder to its scalar equivalent.
+
+static void Scalar16(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    for (TUint i=0; i<aBytes; i+=2) {
+        *aDest++ = aSrc[i+1];
+        *aDest++ = aSrc[i];
+    }
+}
+
+static void Scalar24(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    for (TUint i=0; i<aBytes; i+=3) {
+        *aDest++ = aSrc[i+2];
+        *aDest++ = aSrc[i+1];
+        *aDest++ = aSrc[i];
+    }
+}
+
+static void Scalar32(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    for (TUint i=0; i<aBytes; i+=4) {
+        *aDest++ = aSrc[i+3];
+        *aDest++ = aSrc[i+2];
+        *aDest++ = aSrc[i+1];
+        *aDest++ = aSrc[i];
+    }
+}
+
+#if defined(OH_SIMD_X86)
+
+OH_SIMD_TARGET("sse2") static void Sse2_16(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    TUint i = 0;
+    for (; i+16 <= aBytes; i+=16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i));
+        const __m128i swapped = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), swapped);
+    }
+    Scalar16(aSrc + i, aDest + i, aBytes - i);
+}
+
+OH_SIMD_TARGET("sse2") static void Sse2_32(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    TUint i = 0;
+    for (; i+16 <= aBytes; i+=16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i));
+        v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16)); // swap 16-bit halves...
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));   // ...then bytes within each half
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), v);
+    }
+    Scalar32(aSrc + i, aDest + i, aBytes - i);
+}
+
+OH_SIMD_TARGET("ssse3") static void Ssse3_16(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const __m128i mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    TUint i = 0;
+    for (; i+16 <= aBytes; i+=16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), _mm_shuffle_epi8(v, mask));
+    }
+    Scalar16(aSrc + i, aDest + i, aBytes - i);
+}
+
+OH_SIMD_TARGET("ssse3") static void Ssse3_24(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    // Converts 4 subsamples (12 bytes) per iteration but reads/writes 16.
+    // The 4 extra bytes written are overwritten by the following iteration (or the scalar tail).
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -1, -1, -1, -1);
+    TUint i = 0;
+    for (; i+16 <= aBytes; i+=12) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), _mm_shuffle_epi8(v, mask));
+    }
+    Scalar24(aSrc + i, aDest + i, aBytes - i);
+}
+
+OH_SIMD_TARGET("ssse3") static void Ssse3_32(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    TUint i = 0;
+    for (; i+16 <= aBytes; i+=16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + i), _mm_shuffle_epi8(v, mask));
+    }
+    Scalar32(aSrc + i, aDest + i, aBytes - i);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2_16(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const __m256i mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    TUint i = 0;
+    for (; i+32 <= aBytes; i+=32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + i), _mm256_shuffle_epi8(v, mask));
+    }
+    Ssse3_16(aSrc + i, aDest + i, aBytes - i);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2_24(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    // vpshufb can't cross 128-bit lanes so first spread 24 bytes so that each lane holds 12,
+    // swap within lanes, then pack the 24 result bytes back together.
+    // As with Ssse3_24, each iteration writes 8 bytes beyond those it converts.
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+    const __m256i pack   = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -1, -1, -1, -1,
+                                          2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -1, -1, -1, -1);
+    TUint i = 0;
+    for (; i+32 <= aBytes; i+=24) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + i));
+        v = _mm256_permutevar8x32_epi32(v, spread);
+        v = _mm256_shuffle_epi8(v, mask);
+        v = _mm256_permutevar8x32_epi32(v, pack);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + i), v);
+    }
+    Ssse3_24(aSrc + i, aDest + i, aBytes - i);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2_32(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    TUint i = 0;
+    for (; i+32 <= aBytes; i+=32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + i), _mm256_shuffle_epi8(v, mask));
+    }
+    Ssse3_32(aSrc + i, aDest + i, aBytes - i);
+}
+
+#endif // OH_SIMD_X86
+
+#if defined(OH_SIMD_NEON)
+
+static void Neon16(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    TUint i = 0;
+    for (; i+16 <= aBytes; i+=16) {
+        vst1q_u8(aDest + i, vrev16q_u8(vld1q_u8(aSrc + i)));
+    }
+    Scalar16(aSrc + i, aDest + i, aBytes - i);
+}
+
+static void Neon24(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    // vld3 de-interleaves 16 subsamples into low/mid/high byte planes; store them back in reverse order
+    TUint i = 0;
+    for (; i+48 <= aBytes; i+=48) {
+        uint8x16x3_t v = vld3q_u8(aSrc + i);
+        const uint8x16_t low = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = low;
+        vst3q_u8(aDest + i, v);
+    }
+    Scalar24(aSrc + i, aDest + i, aBytes - i);
+}
+
+static void Neon32(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{
+    TUint i = 0;
+    for (; i+16 <= aBytes; i+=16) {
+        vst1q_u8(aDest + i, vrev32q_u8(vld1q_u8(aSrc + i)));
+    }
+    Scalar32(aSrc + i, aDest + i, aBytes - i);
+}
+
+#endif // OH_SIMD_NEON
+
+
+// ByteSwap
+
+void ByteSwap::ToBigEndian16(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    Instance().i16(aSrc, aDest, aBytes);
+}
+
+void ByteSwap::ToBigEndian24(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    Instance().i24(aSrc, aDest, aBytes);
+}
+
+void ByteSwap::ToBigEndian32(const TByte* aSrc, TByte* aDest, TUint aBytes)
+{ // static
+    Instance().i32(aSrc, aDest, aBytes);
+}
+
+ByteSwap::Impl ByteSwap::Current()
+{ // static
+    return Instance().iImpl;
+}
+
+const TChar* ByteSwap::Name(Impl aImpl)
+{ // static
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        return "Scalar";
+    case Impl::Sse2:
+        return "SSE2";
+    case Impl::Ssse3:
+        return "SSSE3";
+    case Impl::Avx2:
+        return "AVX2";
+    case Impl::Neon:
+        return "NEON";
+    }
+    return "Unknown";
+}
+
+TBool ByteSwap::IsSupported(Impl aImpl)
+{ // static
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        return true;
+    case Impl::Sse2:
+        return CpuFeatures::HasSse2();
+    case Impl::Ssse3:
+        return CpuFeatures::HasSsse3();
+    case Impl::Avx2:
+        return CpuFeatures::HasAvx2();
+    case Impl::Neon:
+        return CpuFeatures::HasNeon();
+    }
+    return false;
+}
+
+void ByteSwap::Select(Impl aImpl)
+{ // static
+    ASSERT(IsSupported(aImpl));
+    Instance().Set(aImpl);
+}
+
+ByteSwap::Kernels& ByteSwap::Instance()
+{ // static
+    static Kernels kernels;
+    return kernels;
+}
+
+
+// ByteSwap::Kernels
+
+ByteSwap::Kernels::Kernels()
+{
+    const Impl preferred[] = { Impl::Avx2, Impl::Ssse3, Impl::Sse2, Impl::Neon };
+    Impl impl = Impl::Scalar;
+    for (auto candidate : preferred) {
+        if (IsSupported(candidate)) {
+            impl = candidate;
+            break;
+        }
+    }
+    Set(impl);
+}
+
+void ByteSwap::Kernels::Set(Impl aImpl)
+{
+    iImpl = aImpl;
+    i16 = Scalar16;
+    i24 = Scalar24;
+    i32 = Scalar32;
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        break;
+#if defined(OH_SIMD_X86)
+    case Impl::Sse2:
+        i16 = Sse2_16;
+        i32 = Sse2_32;
+        break;
+    case Impl::Ssse3:
+        i16 = Ssse3_16;
+        i24 = Ssse3_24;
+        i32 = Ssse3_32;
+        break;
+    case Impl::Avx2:
+        i16 = Avx2_16;
+        i24 = Avx2_24;
+        i32 = Avx2_32;
+        break;
+#endif
+#if defined(OH_SIMD_NEON)
+    case Impl::Neon:
+        i16 = Neon16;
+        i24 = Neon24;
+        i32 = Neon32;
+        break;
+#endif
+    default:
+        ASSERTS();
+    }
+}
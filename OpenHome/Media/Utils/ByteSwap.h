@@ -0,0 +1,51 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Converts packed little endian PCM to big endian.
+ * Vectorised kernels are selected once, on first use, based on CpuFeatures.
+ * Source and destination must not overlap.
+ */
+
+class ByteSwap
+{
+public:
+    enum class Impl
+    {
+        Scalar,
+        Sse2,   // 16 and 32-bit only; 24-bit falls back to Scalar
+        Ssse3,
+        Avx2,
+        Neon
+    };
+public:
+    static void ToBigEndian16(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    static void ToBigEndian24(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    static void ToBigEndian32(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    static Impl Current();
+    static const TChar* Name(Impl aImpl);
+    static TBool IsSupported(Impl aImpl);
+    static void Select(Impl aImpl); // test/benchmark use only.  Not thread safe; aImpl must be supported
+private:
+    typedef void (*Kernel)(const TByte* aSrc, TByte* aDest, TUint aBytes);
+    class Kernels
+    {
+    public:
+        Kernels();
+        void Set(Impl aImpl);
+    public:
+        Impl iImpl;
+        Kernel i16;
+        Kernel i24;
+        Kernel i32;
+    };
+    static Kernels& Instance();
+};
+
+} // namespace Media
+} // namespace OpenHome
+
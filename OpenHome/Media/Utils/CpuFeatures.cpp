@@ -0,0 +1,69 @@
+#include <OpenHome/Media/Utils/CpuFeatures.h>
+#include <OpenHome/Types.h>
+
+#if defined(OH_SIMD_X86) && defined(_MSC_VER)
+# include <intrin.h>
+# include <immintrin.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// CpuFeatures
+
+TBool CpuFeatures::HasSse2()
+{ // static
+    return Instance().iSse2;
+}
+
+TBool CpuFeatures::HasSsse3()
+{ // static
+    return Instance().iSsse3;
+}
+
+TBool CpuFeatures::HasAvx2()
+{ // static
+    return Instance().iAvx2;
+}
+
+TBool CpuFeatures::HasNeon()
+{ // static
+    return Instance().iNeon;
+}
+
+CpuFeatures::CpuFeatures()
+    : iSse2(false)
+    , iSsse3(false)
+    , iAvx2(false)
+    , iNeon(false)
+{
+#if defined(OH_SIMD_X86)
+# if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    iSse2 = (info[3] & (1 << 26)) != 0;
+    iSsse3 = (info[2] & (1 << 9)) != 0;
+    const TBool osSavesAvx = ((info[2] & (1 << 27)) != 0) && ((_xgetbv(0) & 6) == 6);
+    if (maxLeaf >= 7 && osSavesAvx) {
+        __cpuidex(info, 7, 0);
+        iAvx2 = (info[1] & (1 << 5)) != 0;
+    }
+# else
+    __builtin_cpu_init();
+    iSse2 = __builtin_cpu_supports("sse2") != 0;
+    iSsse3 = __builtin_cpu_supports("ssse3") != 0;
+    iAvx2 = __builtin_cpu_supports("avx2") != 0; // also checks that the OS saves ymm registers
+# endif
+#endif // OH_SIMD_X86
+#if defined(OH_SIMD_NEON)
+    iNeon = true;
+#endif
+}
+
+const CpuFeatures& CpuFeatures::Instance()
+{ // static
+    static CpuFeatures features; // detect once, on first use
+    return features;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+
+// Instruction sets that SIMD kernels may be compiled for.
+// x86 kernels are compiled using per-function target attributes so don't need any
+// extra compiler flags; callers must check CpuFeatures before running them.
+// NEON kernels are only compiled when the toolchain already targets NEON.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+# define OH_SIMD_X86
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define OH_SIMD_NEON
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+# define OH_SIMD_TARGET(aTarget) __attribute__((target(aTarget)))
+#else
+# define OH_SIMD_TARGET(aTarget)
+#endif
+
+namespace OpenHome {
+namespace Media {
+
+class CpuFeatures
+{
+public:
+    static TBool HasSse2();
+    static TBool HasSsse3();
+    static TBool HasAvx2();
+    static TBool HasNeon();
+private:
+    CpuFeatures();
+    static const CpuFeatures& Instance();
+private:
+    TBool iSse2;
+    TBool iSsse3;
+    TBool iAvx2;
+    TBool iNeon;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
@@ -0,0 +1,439 @@
+#include <OpenHome/Media/Utils/LpcKernels.h>
+#include <OpenHome/Media/Utils/CpuFeatures.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+#if defined(OH_SIMD_X86)
+# include <immintrin.h>
+#endif
+#if defined(OH_SIMD_NEON)
+# include <arm_neon.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// Kernels
+// Integer arithmetic wraps identically in every implementation so results are bit-exact.
+// Sums are accumulated modulo 2^32 which allows them to be split across vector lanes.
+// Each vectorised kernel handles as many whole vectors as it can then passes the remainder to its scalar equivalent.
+
+static void ScalarSums(const TInt16* aFwd, const TInt16* aPef, const TInt16* aBwd, const TInt16* aPer,
+                       TUint aCount, TInt32& aSn, TInt32& aSd)
+{
+    TInt32 sn = aSn;
+    TInt32 sd = aSd;
+    for (TUint j=0; j<aCount; j++) {
+        const TInt16 t1 = (TInt16)(aFwd[j] + aPef[j]);
+        const TInt16 t2 = (TInt16)(aBwd[j] + aPer[j]);
+        const TInt32 t1t1 = (TInt32)t1*(TInt32)t1;
+        const TInt32 t2t2 = (TInt32)t2*(TInt32)t2;
+        const TInt32 t1t2 = (TInt32)t1*(TInt32)t2;
+        sn -= (2*t1t2);  // 2.30
+        sd += t1t1 + t2t2; // 2.30
+    }
+    aSn = sn;
+    aSd = sd;
+}
+
+static void ScalarUpdate(const TInt16* aFwd, const TInt16* aBwd, TInt16* aPer, TInt16* aPef,
+                         TUint aCount, TInt16 aK, TUint aShift)
+{
+    for (TUint j=0; j<aCount; j++) {
+        TInt32 per = aPef[j] + aFwd[j];
+        per *= aK;
+        aPer[j] += (TInt16)(per>>aShift);
+
+        TInt32 pef = aPer[j+1] + aBwd[j];
+        pef *= aK;
+        aPef[j] = (TInt16)(pef>>aShift);
+        aPef[j] += aPef[j+1];
+    }
+}
+
+static void ScalarFeedback(const TInt32* aCoeffs, TInt32* aStates, TUint aDegree, TUint aChannels,
+                           TUint aCoeffFormat, TInt aOutputShift, TInt32* aOut)
+{
+    const TUint kStride = LpcKernels::kFeedbackStride;
+    for (TUint ch=0; ch<aChannels; ch++) {
+        TInt32 sum = 0;
+        for (TUint j=0; j<aDegree; j++) {
+            const TInt64 product = ((TInt64)aStates[j*kStride + ch]) * ((TInt64)aCoeffs[j*kStride + ch]);
+            sum += (TInt32)(product>>32);
+        }
+        for (TUint j=aDegree-1; j>0; j--) {
+            aStates[j*kStride + ch] = aStates[(j-1)*kStride + ch];
+        }
+        sum <<= aCoeffFormat;
+        aStates[ch] = sum;
+        if (aOutputShift < 0) {
+            sum >>= (-aOutputShift);
+        }
+        else {
+            sum <<= aOutputShift;
+        }
+        aOut[ch] = sum;
+    }
+}
+
+#if defined(OH_SIMD_X86)
+
+OH_SIMD_TARGET("sse2") static TUint32 HorizontalSum(__m128i aV)
+{
+    aV = _mm_add_epi32(aV, _mm_shuffle_epi32(aV, _MM_SHUFFLE(1, 0, 3, 2)));
+    aV = _mm_add_epi32(aV, _mm_shuffle_epi32(aV, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (TUint32)_mm_cvtsi128_si32(aV);
+}
+
+// ((aA+aB)*aK)>>aShift for 8 16-bit lanes, truncated to 16 bits
+OH_SIMD_TARGET("sse2") static __m128i MulShift(__m128i aA, __m128i aB, __m128i aK, __m128i aShift)
+{
+    const __m128i aLo = _mm_mullo_epi16(aA, aK);
+    const __m128i aHi = _mm_mulhi_epi16(aA, aK);
+    const __m128i bLo = _mm_mullo_epi16(aB, aK);
+    const __m128i bHi = _mm_mulhi_epi16(aB, aK);
+    __m128i p0 = _mm_add_epi32(_mm_unpacklo_epi16(aLo, aHi), _mm_unpacklo_epi16(bLo, bHi));
+    __m128i p1 = _mm_add_epi32(_mm_unpackhi_epi16(aLo, aHi), _mm_unpackhi_epi16(bLo, bHi));
+    p0 = _mm_sra_epi32(p0, aShift);
+    p1 = _mm_sra_epi32(p1, aShift);
+    // sign extend the low 16 bits so that packing truncates rather than saturates
+    p0 = _mm_srai_epi32(_mm_slli_epi32(p0, 16), 16);
+    p1 = _mm_srai_epi32(_mm_slli_epi32(p1, 16), 16);
+    return _mm_packs_epi32(p0, p1);
+}
+
+OH_SIMD_TARGET("sse2") static void Sse2Sums(const TInt16* aFwd, const TInt16* aPef, const TInt16* aBwd, const TInt16* aPer,
+                                            TUint aCount, TInt32& aSn, TInt32& aSd)
+{
+    __m128i accSn = _mm_setzero_si128();
+    __m128i accSd = _mm_setzero_si128();
+    TUint j = 0;
+    for (; j+8 <= aCount; j+=8) {
+        const __m128i t1 = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aFwd + j)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(aPef + j)));
+        const __m128i t2 = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aBwd + j)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(aPer + j)));
+        accSd = _mm_add_epi32(accSd, _mm_add_epi32(_mm_madd_epi16(t1, t1), _mm_madd_epi16(t2, t2)));
+        accSn = _mm_add_epi32(accSn, _mm_madd_epi16(t1, t2));
+    }
+    aSd = (TInt32)((TUint32)aSd + HorizontalSum(accSd));
+    aSn = (TInt32)((TUint32)aSn - (HorizontalSum(accSn) << 1));
+    ScalarSums(aFwd + j, aPef + j, aBwd + j, aPer + j, aCount - j, aSn, aSd);
+}
+
+OH_SIMD_TARGET("sse2") static void Sse2Update(const TInt16* aFwd, const TInt16* aBwd, TInt16* aPer, TInt16* aPef,
+                                              TUint aCount, TInt16 aK, TUint aShift)
+{
+    const __m128i k = _mm_set1_epi16(aK);
+    const __m128i shift = _mm_cvtsi32_si128((int)aShift);
+    TUint j = 0;
+    for (; j+8 <= aCount; j+=8) {
+        // load everything before storing; scalar code reads [j+1] before it is updated
+        const __m128i fwd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aFwd + j));
+        const __m128i bwd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aBwd + j));
+        const __m128i per = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aPer + j));
+        const __m128i per1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aPer + j + 1));
+        const __m128i pef = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aPef + j));
+        const __m128i pef1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aPef + j + 1));
+        const __m128i newPer = _mm_add_epi16(per, MulShift(pef, fwd, k, shift));
+        const __m128i newPef = _mm_add_epi16(MulShift(per1, bwd, k, shift), pef1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aPer + j), newPer);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aPef + j), newPef);
+    }
+    ScalarUpdate(aFwd + j, aBwd + j, aPer + j, aPef + j, aCount - j, aK, aShift);
+}
+
+OH_SIMD_TARGET("avx2") static TUint32 HorizontalSum(__m256i aV)
+{
+    return HorizontalSum(_mm_add_epi32(_mm256_castsi256_si128(aV), _mm256_extracti128_si256(aV, 1)));
+}
+
+OH_SIMD_TARGET("avx2") static __m256i MulShift(__m256i aA, __m256i aB, __m256i aK, __m128i aShift)
+{
+    // unpack/pack operate within 128-bit lanes so element order is preserved
+    const __m256i aLo = _mm256_mullo_epi16(aA, aK);
+    const __m256i aHi = _mm256_mulhi_epi16(aA, aK);
+    const __m256i bLo = _mm256_mullo_epi16(aB, aK);
+    const __m256i bHi = _mm256_mulhi_epi16(aB, aK);
+    __m256i p0 = _mm256_add_epi32(_mm256_unpacklo_epi16(aLo, aHi), _mm256_unpacklo_epi16(bLo, bHi));
+    __m256i p1 = _mm256_add_epi32(_mm256_unpackhi_epi16(aLo, aHi), _mm256_unpackhi_epi16(bLo, bHi));
+    p0 = _mm256_sra_epi32(p0, aShift);
+    p1 = _mm256_sra_epi32(p1, aShift);
+    p0 = _mm256_srai_epi32(_mm256_slli_epi32(p0, 16), 16);
+    p1 = _mm256_srai_epi32(_mm256_slli_epi32(p1, 16), 16);
+    return _mm256_packs_epi32(p0, p1);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2Sums(const TInt16* aFwd, const TInt16* aPef, const TInt16* aBwd, const TInt16* aPer,
+                                            TUint aCount, TInt32& aSn, TInt32& aSd)
+{
+    __m256i accSn = _mm256_setzero_si256();
+    __m256i accSd = _mm256_setzero_si256();
+    TUint j = 0;
+    for (; j+16 <= aCount; j+=16) {
+        const __m256i t1 = _mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(aFwd + j)),
+                                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPef + j)));
+        const __m256i t2 = _mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(aBwd + j)),
+                                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPer + j)));
+        accSd = _mm256_add_epi32(accSd, _mm256_add_epi32(_mm256_madd_epi16(t1, t1), _mm256_madd_epi16(t2, t2)));
+        accSn = _mm256_add_epi32(accSn, _mm256_madd_epi16(t1, t2));
+    }
+    aSd = (TInt32)((TUint32)aSd + HorizontalSum(accSd));
+    aSn = (TInt32)((TUint32)aSn - (HorizontalSum(accSn) << 1));
+    Sse2Sums(aFwd + j, aPef + j, aBwd + j, aPer + j, aCount - j, aSn, aSd);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2Update(const TInt16* aFwd, const TInt16* aBwd, TInt16* aPer, TInt16* aPef,
+                                              TUint aCount, TInt16 aK, TUint aShift)
+{
+    const __m256i k = _mm256_set1_epi16(aK);
+    const __m128i shift = _mm_cvtsi32_si128((int)aShift);
+    TUint j = 0;
+    for (; j+16 <= aCount; j+=16) {
+        const __m256i fwd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aFwd + j));
+        const __m256i bwd = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aBwd + j));
+        const __m256i per = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPer + j));
+        const __m256i per1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPer + j + 1));
+        const __m256i pef = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPef + j));
+        const __m256i pef1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aPef + j + 1));
+        const __m256i newPer = _mm256_add_epi16(per, MulShift(pef, fwd, k, shift));
+        const __m256i newPef = _mm256_add_epi16(MulShift(per1, bwd, k, shift), pef1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aPer + j), newPer);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aPef + j), newPef);
+    }
+    Sse2Update(aFwd + j, aBwd + j, aPer + j, aPef + j, aCount - j, aK, aShift);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2Feedback(const TInt32* aCoeffs, TInt32* aStates, TUint aDegree, TUint aChannels,
+                                                TUint aCoeffFormat, TInt aOutputShift, TInt32* aOut)
+{
+    const TUint kStride = LpcKernels::kFeedbackStride;
+    const __m128i coeffShift = _mm_cvtsi32_si128((int)aCoeffFormat);
+    const __m128i outShift = _mm_cvtsi32_si128(aOutputShift < 0? -aOutputShift : aOutputShift);
+    for (TUint ch=0; ch<aChannels; ch+=8) { // may process up to 7 unused channels
+        __m256i sum = _mm256_setzero_si256();
+        for (TUint j=0; j<aDegree; j++) {
+            const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aStates + j*kStride + ch));
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aCoeffs + j*kStride + ch));
+            // high 32 bits of each 64-bit product
+            const __m256i even = _mm256_mul_epi32(s, c);
+            const __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(s, 32), _mm256_srli_epi64(c, 32));
+            sum = _mm256_add_epi32(sum, _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA));
+        }
+        for (TUint j=aDegree-1; j>0; j--) {
+            const __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aStates + (j-1)*kStride + ch));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(aStates + j*kStride + ch), prev);
+        }
+        sum = _mm256_sll_epi32(sum, coeffShift);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aStates + ch), sum);
+        sum = (aOutputShift < 0? _mm256_sra_epi32(sum, outShift) : _mm256_sll_epi32(sum, outShift));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aOut + ch), sum);
+    }
+}
+
+#endif // OH_SIMD_X86
+
+#if defined(OH_SIMD_NEON)
+
+static TUint32 HorizontalSum(int32x4_t aV)
+{
+    int32x2_t s = vadd_s32(vget_low_s32(aV), vget_high_s32(aV));
+    s = vpadd_s32(s, s);
+    return (TUint32)vget_lane_s32(s, 0);
+}
+
+static int16x8_t MulShift(int16x8_t aA, int16x8_t aB, int16x4_t aK, int32x4_t aNegShift)
+{
+    int32x4_t p0 = vmlal_s16(vmull_s16(vget_low_s16(aA), aK), vget_low_s16(aB), aK);
+    int32x4_t p1 = vmlal_s16(vmull_s16(vget_high_s16(aA), aK), vget_high_s16(aB), aK);
+    p0 = vshlq_s32(p0, aNegShift);
+    p1 = vshlq_s32(p1, aNegShift);
+    return vcombine_s16(vmovn_s32(p0), vmovn_s32(p1)); // vmovn truncates
+}
+
+static void NeonSums(const TInt16* aFwd, const TInt16* aPef, const TInt16* aBwd, const TInt16* aPer,
+                     TUint aCount, TInt32& aSn, TInt32& aSd)
+{
+    int32x4_t accSn = vdupq_n_s32(0);
+    int32x4_t accSd = vdupq_n_s32(0);
+    TUint j = 0;
+    for (; j+8 <= aCount; j+=8) {
+        const int16x8_t t1 = vaddq_s16(vld1q_s16(aFwd + j), vld1q_s16(aPef + j));
+        const int16x8_t t2 = vaddq_s16(vld1q_s16(aBwd + j), vld1q_s16(aPer + j));
+        accSd = vmlal_s16(accSd, vget_low_s16(t1), vget_low_s16(t1));
+        accSd = vmlal_s16(accSd, vget_high_s16(t1), vget_high_s16(t1));
+        accSd = vmlal_s16(accSd, vget_low_s16(t2), vget_low_s16(t2));
+        accSd = vmlal_s16(accSd, vget_high_s16(t2), vget_high_s16(t2));
+        accSn = vmlal_s16(accSn, vget_low_s16(t1), vget_low_s16(t2));
+        accSn = vmlal_s16(accSn, vget_high_s16(t1), vget_high_s16(t2));
+    }
+    aSd = (TInt32)((TUint32)aSd + HorizontalSum(accSd));
+    aSn = (TInt32)((TUint32)aSn - (HorizontalSum(accSn) << 1));
+    ScalarSums(aFwd + j, aPef + j, aBwd + j, aPer + j, aCount - j, aSn, aSd);
+}
+
+static void NeonUpdate(const TInt16* aFwd, const TInt16* aBwd, TInt16* aPer, TInt16* aPef,
+                       TUint aCount, TInt16 aK, TUint aShift)
+{
+    const int16x4_t k = vdup_n_s16(aK);
+    const int32x4_t negShift = vdupq_n_s32(-(TInt)aShift);
+    TUint j = 0;
+    for (; j+8 <= aCount; j+=8) {
+        const int16x8_t fwd = vld1q_s16(aFwd + j);
+        const int16x8_t bwd = vld1q_s16(aBwd + j);
+        const int16x8_t per = vld1q_s16(aPer + j);
+        const int16x8_t per1 = vld1q_s16(aPer + j + 1);
+        const int16x8_t pef = vld1q_s16(aPef + j);
+        const int16x8_t pef1 = vld1q_s16(aPef + j + 1);
+        vst1q_s16(aPer + j, vaddq_s16(per, MulShift(pef, fwd, k, negShift)));
+        vst1q_s16(aPef + j, vaddq_s16(MulShift(per1, bwd, k, negShift), pef1));
+    }
+    ScalarUpdate(aFwd + j, aBwd + j, aPer + j, aPef + j, aCount - j, aK, aShift);
+}
+
+static void NeonFeedback(const TInt32* aCoeffs, TInt32* aStates, TUint aDegree, TUint aChannels,
+                         TUint aCoeffFormat, TInt aOutputShift, TInt32* aOut)
+{
+    const TUint kStride = LpcKernels::kFeedbackStride;
+    const int32x4_t coeffShift = vdupq_n_s32((int32_t)aCoeffFormat);
+    const int32x4_t outShift = vdupq_n_s32(aOutputShift); // negative shifts right
+    for (TUint ch=0; ch<aChannels; ch+=4) { // may process up to 3 unused channels
+        int32x4_t sum = vdupq_n_s32(0);
+        for (TUint j=0; j<aDegree; j++) {
+            const int32x4_t s = vld1q_s32(aStates + j*kStride + ch);
+            const int32x4_t c = vld1q_s32(aCoeffs + j*kStride + ch);
+            const int64x2_t lo = vmull_s32(vget_low_s32(s), vget_low_s32(c));
+            const int64x2_t hi = vmull_s32(vget_high_s32(s), vget_high_s32(c));
+            sum = vaddq_s32(sum, vcombine_s32(vshrn_n_s64(lo, 32), vshrn_n_s64(hi, 32)));
+        }
+        for (TUint j=aDegree-1; j>0; j--) {
+            vst1q_s32(aStates + j*kStride + ch, vld1q_s32(aStates + (j-1)*kStride + ch));
+        }
+        sum = vshlq_s32(sum, coeffShift);
+        vst1q_s32(aStates + ch, sum);
+        vst1q_s32(aOut + ch, vshlq_s32(sum, outShift));
+    }
+}
+
+#endif // OH_SIMD_NEON
+
+
+// LpcKernels
+
+void LpcKernels::BurgSums(const TInt16* aFwd, const TInt16* aPef, const TInt16* aBwd, const TInt16* aPer,
+                          TUint aCount, TInt32& aSn, TInt32& aSd)
+{ // static
+    Instance().iSums(aFwd, aPef, aBwd, aPer, aCount, aSn, aSd);
+}
+
+void LpcKernels::BurgUpdate(const TInt16* aFwd, const TInt16* aBwd, TInt16* aPer, TInt16* aPef,
+                            TUint aCount, TInt16 aK, TUint aShift)
+{ // static
+    Instance().iUpdate(aFwd, aBwd, aPer, aPef, aCount, aK, aShift);
+}
+
+void LpcKernels::Feedback(const TInt32* aCoeffs, TInt32* aStates, TUint aDegree, TUint aChannels,
+                          TUint aCoeffFormat, TInt aOutputShift, TInt32* aOut)
+{ // static
+    ASSERT(aChannels <= kFeedbackStride);
+    ASSERT(aDegree > 0);
+    Instance().iFeedback(aCoeffs, aStates, aDegree, aChannels, aCoeffFormat, aOutputShift, aOut);
+}
+
+LpcKernels::Impl LpcKernels::Current()
+{ // static
+    return Instance().iImpl;
+}
+
+const TChar* LpcKernels::Name(Impl aImpl)
+{ // static
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        return "Scalar";
+    case Impl::Sse2:
+        return "SSE2";
+    case Impl::Avx2:
+        return "AVX2";
+    case Impl::Neon:
+        return "NEON";
+    }
+    return "Unknown";
+}
+
+TBool LpcKernels::IsSupported(Impl aImpl)
+{ // static
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        return true;
+    case Impl::Sse2:
+        return CpuFeatures::HasSse2();
+    case Impl::Avx2:
+        return CpuFeatures::HasAvx2();
+    case Impl::Neon:
+        return CpuFeatures::HasNeon();
+    }
+    return false;
+}
+
+void LpcKernels::Select(Impl aImpl)
+{ // static
+    ASSERT(IsSupported(aImpl));
+    Instance().Set(aImpl);
+}
+
+LpcKernels::Kernels& LpcKernels::Instance()
+{ // static
+    static Kernels kernels;
+    return kernels;
+}
+
+
+// LpcKernels::Kernels
+
+LpcKernels::Kernels::Kernels()
+{
+    const Impl preferred[] = { Impl::Avx2, Impl::Sse2, Impl::Neon };
+    Impl impl = Impl::Scalar;
+    for (auto candidate : preferred) {
+        if (IsSupported(candidate)) {
+            impl = candidate;
+            break;
+        }
+    }
+    Set(impl);
+}
+
+void LpcKernels::Kernels::Set(Impl aImpl)
+{
+    iImpl = aImpl;
+    iSums = ScalarSums;
+    iUpdate = ScalarUpdate;
+    iFeedback = ScalarFeedback;
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        break;
+#if defined(OH_SIMD_X86)
+    case Impl::Sse2:
+        iSums = Sse2Sums;
+        iUpdate = Sse2Update;
+        break;
+    case Impl::Avx2:
+        iSums = Avx2Sums;
+        iUpdate = Avx2Update;
+        iFeedback = Avx2Feedback;
+        break;
+#endif
+#if defined(OH_SIMD_NEON)
+    case Impl::Neon:
+        iSums = NeonSums;
+        iUpdate = NeonUpdate;
+        iFeedback = NeonFeedback;
+        break;
+#endif
+    default:
+        ASSERTS();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Fixed point kernels used by FlywheelRamper's Burg training and feedback filter.
+ * All implementations produce bit-identical results; vectorised kernels are selected
+ * once, on first use, based on CpuFeatures.
+ *
+ * BurgSums/BurgUpdate operate on one channel's 16-bit training data.
+ * Feedback advances the filters for several channels at once.  Coefficients and states
+ * are stored by tap then channel (aCoeffs[tap*kFeedbackStride + channel]) so that each
+ * tap's values for all channels are contiguous.
+ */
+
+class LpcKernels
+{
+public:
+    static const TUint kFeedbackStride = 16; // max channels; multiple of every vector width
+    enum class Impl
+    {
+        Scalar,
+        Sse2,   // Burg only; Feedback falls back to Scalar
+        Avx2,
+        Neon
+    };
+public:
+    // aSn -= 2*sum(t1*t2); aSd += sum(t1*t1 + t2*t2) where t1=aFwd[j]+aPef[j], t2=aBwd[j]+aPer[j]
+    static void BurgSums(const TInt16* aFwd, const TInt16* aPef, const TInt16* aBwd, const TInt16* aPer,
+                         TUint aCount, TInt32& aSn, TInt32& aSd);
+    // aPer[j] += ((aPef[j]+aFwd[j])*aK)>>aShift; aPef[j] = (((aPer[j+1]+aBwd[j])*aK)>>aShift) + aPef[j+1]
+    // using values of aPer/aPef from before the call.  Reads aPer[aCount] and aPef[aCount].
+    static void BurgUpdate(const TInt16* aFwd, const TInt16* aBwd, TInt16* aPer, TInt16* aPef,
+                           TUint aCount, TInt16 aK, TUint aShift);
+    // Writes the next output of aChannels filters with aDegree taps to aOut, updating aStates.
+    // Equivalent to FeedbackModel::NextSample() run for each channel.
+    // aCoeffs, aStates and aOut may be accessed beyond aChannels, up to kFeedbackStride.
+    static void Feedback(const TInt32* aCoeffs, TInt32* aStates, TUint aDegree, TUint aChannels,
+                         TUint aCoeffFormat, TInt aOutputShift, TInt32* aOut);
+    static Impl Current();
+    static const TChar* Name(Impl aImpl);
+    static TBool IsSupported(Impl aImpl);
+    static void Select(Impl aImpl); // test/benchmark use only.  Not thread safe; aImpl must be supported
+private:
+    typedef void (*KernelSums)(const TInt16* aFwd, const TInt16* aPef, const TInt16* aBwd, const TInt16* aPer,
+                               TUint aCount, TInt32& aSn, TInt32& aSd);
+    typedef void (*KernelUpdate)(const TInt16* aFwd, const TInt16* aBwd, TInt16* aPer, TInt16* aPef,
+                                 TUint aCount, TInt16 aK, TUint aShift);
+    typedef void (*KernelFeedback)(const TInt32* aCoeffs, TInt32* aStates, TUint aDegree, TUint aChannels,
+                                   TUint aCoeffFormat, TInt aOutputShift, TInt32* aOut);
+    class Kernels
+    {
+    public:
+        Kernels();
+        void Set(Impl aImpl);
+    public:
+        Impl iImpl;
+        KernelSums iSums;
+        KernelUpdate iUpdate;
+        KernelFeedback iFeedback;
+    };
+    static Kernels& Instance();
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -0,0 +1,442 @@
+#include <OpenHome/Media/Utils/PcmGain.h>
+#include <OpenHome/Media/Utils/CpuFeatures.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+#if defined(OH_SIMD_X86)
+# include <immintrin.h>
+#endif
+#if defined(OH_SIMD_NEON)
+# include <arm_neon.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// Scalar kernels
+// Subsample width and channel count are template parameters so that the inner loops have
+// fixed trip counts and no per-sample branching.  kChannels==0 reads the channel count at run time.
+
+namespace {
+
+template<TUint kBytes> struct Subsample;
+
+template<> struct Subsample<1>
+{
+    static inline TInt Read(const TByte* aPtr) { return (TInt8)aPtr[0]; }
+    static inline void Write(TByte* aPtr, TInt aVal) { aPtr[0] = (TByte)aVal; }
+    static inline TInt Scale(TInt aVal, TUint aGain) { return (aVal * (TInt)aGain) >> PcmGain::kShift; }
+};
+
+template<> struct Subsample<2>
+{
+    static inline TInt Read(const TByte* aPtr)
+    {
+        return (TInt16)((aPtr[0] << 8) | aPtr[1]);
+    }
+    static inline void Write(TByte* aPtr, TInt aVal)
+    {
+        aPtr[0] = (TByte)(aVal >> 8);
+        aPtr[1] = (TByte)aVal;
+    }
+    static inline TInt Scale(TInt aVal, TUint aGain) { return (aVal * (TInt)aGain) >> PcmGain::kShift; }
+};
+
+template<> struct Subsample<3>
+{
+    static inline TInt Read(const TByte* aPtr)
+    {
+        const TUint32 packed = ((TUint32)aPtr[0] << 24) | ((TUint32)aPtr[1] << 16) | ((TUint32)aPtr[2] << 8);
+        return ((TInt32)packed) >> 8; // sign extend
+    }
+    static inline void Write(TByte* aPtr, TInt aVal)
+    {
+        aPtr[0] = (TByte)(aVal >> 16);
+        aPtr[1] = (TByte)(aVal >> 8);
+        aPtr[2] = (TByte)aVal;
+    }
+    static inline TInt Scale(TInt aVal, TUint aGain) { return (TInt)(((TInt64)aVal * aGain) >> PcmGain::kShift); }
+};
+
+template<> struct Subsample<4>
+{
+    static inline TInt Read(const TByte* aPtr)
+    {
+        return (TInt32)(((TUint32)aPtr[0] << 24) | ((TUint32)aPtr[1] << 16) | ((TUint32)aPtr[2] << 8) | aPtr[3]);
+    }
+    static inline void Write(TByte* aPtr, TInt aVal)
+    {
+        aPtr[0] = (TByte)(aVal >> 24);
+        aPtr[1] = (TByte)(aVal >> 16);
+        aPtr[2] = (TByte)(aVal >> 8);
+        aPtr[3] = (TByte)aVal;
+    }
+    static inline TInt Scale(TInt aVal, TUint aGain) { return (TInt)(((TInt64)aVal * aGain) >> PcmGain::kShift); }
+};
+
+template<TUint kBytes, TUint kChannels>
+void ApplyKernel(const TByte* aSrc, TByte* aDest, TUint aNumSamples, TUint aNumChannels, const TUint* aGains)
+{
+    const TUint channels = (kChannels == 0? aNumChannels : kChannels);
+    for (TUint i=0; i<aNumSamples; i++) {
+        const TUint gain = aGains[i];
+        for (TUint ch=0; ch<channels; ch++) {
+            const TInt subsample = Subsample<kBytes>::Read(aSrc);
+            Subsample<kBytes>::Write(aDest, Subsample<kBytes>::Scale(subsample, gain));
+            aSrc += kBytes;
+            aDest += kBytes;
+        }
+    }
+}
+
+template<TUint kBytes>
+void ApplyConstantKernel(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain)
+{
+    for (TUint i=0; i<aNumSubsamples; i++) {
+        const TInt subsample = Subsample<kBytes>::Read(aSrc);
+        Subsample<kBytes>::Write(aDest, Subsample<kBytes>::Scale(subsample, aGain));
+        aSrc += kBytes;
+        aDest += kBytes;
+    }
+}
+
+template<TUint kBytes>
+void ApplyForChannels(const TByte* aSrc, TByte* aDest, TUint aNumSamples, TUint aNumChannels, const TUint* aGains)
+{
+    switch (aNumChannels)
+    {
+    case 1:
+        ApplyKernel<kBytes, 1>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        break;
+    case 2:
+        ApplyKernel<kBytes, 2>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        break;
+    case 6:
+        ApplyKernel<kBytes, 6>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        break;
+    case 8:
+        ApplyKernel<kBytes, 8>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        break;
+    default:
+        ApplyKernel<kBytes, 0>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        break;
+    }
+}
+
+} // namespace
+
+static void ScalarConstant16(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain)
+{
+    ApplyConstantKernel<2>(aSrc, aDest, aNumSubsamples, aGain);
+}
+
+static void ScalarConstant32(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain)
+{
+    ApplyConstantKernel<4>(aSrc, aDest, aNumSubsamples, aGain);
+}
+
+static void ScalarStereo16(const TByte* aSrc, TByte* aDest, TUint aNumSamples, const TUint* aGains)
+{
+    ApplyKernel<2, 2>(aSrc, aDest, aNumSamples, 2, aGains);
+}
+
+// Vectorised kernels
+// Each handles as many whole vectors as it can then passes the remainder to its scalar equivalent.
+// Results match the scalar kernels exactly.
+
+#if defined(OH_SIMD_X86)
+
+OH_SIMD_TARGET("sse2") static inline __m128i Sse2Swap16(__m128i aVal)
+{
+    return _mm_or_si128(_mm_slli_epi16(aVal, 8), _mm_srli_epi16(aVal, 8));
+}
+
+OH_SIMD_TARGET("sse2") static inline __m128i Sse2Scale16(__m128i aVal, __m128i aGain)
+{
+    // 32-bit products are built from 16-bit halves.  _mm_mulhi_epu16 treats aVal as unsigned
+    // (so that gains of kUnity fit); subtracting aGain from the high half of negative products corrects this.
+    const __m128i lo = _mm_mullo_epi16(aVal, aGain);
+    const __m128i hi = _mm_sub_epi16(_mm_mulhi_epu16(aVal, aGain), _mm_and_si128(_mm_srai_epi16(aVal, 15), aGain));
+    const __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), PcmGain::kShift);
+    const __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), PcmGain::kShift);
+    return _mm_packs_epi32(p0, p1);
+}
+
+OH_SIMD_TARGET("sse2") static void Sse2Constant16(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain)
+{
+    const __m128i gain = _mm_set1_epi16((short)aGain);
+    TUint i = 0;
+    for (; i+8 <= aNumSubsamples; i+=8) {
+        const __m128i v = Sse2Swap16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + 2*i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + 2*i), Sse2Swap16(Sse2Scale16(v, gain)));
+    }
+    ScalarConstant16(aSrc + 2*i, aDest + 2*i, aNumSubsamples - i, aGain);
+}
+
+OH_SIMD_TARGET("sse2") static void Sse2Stereo16(const TByte* aSrc, TByte* aDest, TUint aNumSamples, const TUint* aGains)
+{
+    TUint i = 0;
+    for (; i+4 <= aNumSamples; i+=4) {
+        // gains are no more than 16 bits so (g | g<<16) gives the same gain for left and right subsamples
+        const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aGains + i));
+        const __m128i gains = _mm_or_si128(g, _mm_slli_epi32(g, 16));
+        const __m128i v = Sse2Swap16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(aSrc + 4*i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + 4*i), Sse2Swap16(Sse2Scale16(v, gains)));
+    }
+    ScalarStereo16(aSrc + 4*i, aDest + 4*i, aNumSamples - i, aGains + i);
+}
+
+OH_SIMD_TARGET("avx2") static inline __m256i Avx2Swap16(__m256i aVal)
+{
+    return _mm256_or_si256(_mm256_slli_epi16(aVal, 8), _mm256_srli_epi16(aVal, 8));
+}
+
+OH_SIMD_TARGET("avx2") static inline __m256i Avx2Scale16(__m256i aVal, __m256i aGain)
+{
+    // as Sse2Scale16; unpack and pack both operate within 128-bit lanes so subsample order is preserved
+    const __m256i lo = _mm256_mullo_epi16(aVal, aGain);
+    const __m256i hi = _mm256_sub_epi16(_mm256_mulhi_epu16(aVal, aGain), _mm256_and_si256(_mm256_srai_epi16(aVal, 15), aGain));
+    const __m256i p0 = _mm256_srai_epi32(_mm256_unpacklo_epi16(lo, hi), PcmGain::kShift);
+    const __m256i p1 = _mm256_srai_epi32(_mm256_unpackhi_epi16(lo, hi), PcmGain::kShift);
+    return _mm256_packs_epi32(p0, p1);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2Constant16(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain)
+{
+    const __m256i gain = _mm256_set1_epi16((short)aGain);
+    TUint i = 0;
+    for (; i+16 <= aNumSubsamples; i+=16) {
+        const __m256i v = Avx2Swap16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + 2*i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + 2*i), Avx2Swap16(Avx2Scale16(v, gain)));
+    }
+    Sse2Constant16(aSrc + 2*i, aDest + 2*i, aNumSubsamples - i, aGain);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2Stereo16(const TByte* aSrc, TByte* aDest, TUint aNumSamples, const TUint* aGains)
+{
+    TUint i = 0;
+    for (; i+8 <= aNumSamples; i+=8) {
+        const __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aGains + i));
+        const __m256i gains = _mm256_or_si256(g, _mm256_slli_epi32(g, 16));
+        const __m256i v = Avx2Swap16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + 4*i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + 4*i), Avx2Swap16(Avx2Scale16(v, gains)));
+    }
+    Sse2Stereo16(aSrc + 4*i, aDest + 4*i, aNumSamples - i, aGains + i);
+}
+
+OH_SIMD_TARGET("avx2") static void Avx2Constant32(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain)
+{
+    // _mm256_mul_epi32 forms 64-bit products of even 32-bit lanes; odd lanes are shifted down to use it too.
+    // There's no 64-bit arithmetic shift but bits 15..46 of each product are the same for a logical one.
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i gain = _mm256_set1_epi32((int)aGain);
+    TUint i = 0;
+    for (; i+8 <= aNumSubsamples; i+=8) {
+        const __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(aSrc + 4*i)), swap);
+        const __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(v, gain), PcmGain::kShift);
+        const __m256i odd = _mm256_srli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(v, 32), gain), PcmGain::kShift);
+        const __m256i scaled = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aDest + 4*i), _mm256_shuffle_epi8(scaled, swap));
+    }
+    ScalarConstant32(aSrc + 4*i, aDest + 4*i, aNumSubsamples - i, aGain);
+}
+
+#endif // OH_SIMD_X86
+
+#if defined(OH_SIMD_NEON)
+
+static inline int16x8_t NeonScale16(int16x8_t aVal, int32x4_t aGainLo, int32x4_t aGainHi)
+{
+    const int32x4_t lo = vshrq_n_s32(vmulq_s32(vmovl_s16(vget_low_s16(aVal)), aGainLo), PcmGain::kShift);
+    const int32x4_t hi = vshrq_n_s32(vmulq_s32(vmovl_s16(vget_high_s16(aVal)), aGainHi), PcmGain::kShift);
+    return vcombine_s16(vmovn_s32(lo), vmovn_s32(hi));
+}
+
+static void NeonConstant16(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain)
+{
+    const int32x4_t gain = vdupq_n_s32((int32_t)aGain);
+    TUint i = 0;
+    for (; i+8 <= aNumSubsamples; i+=8) {
+        const int16x8_t v = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(aSrc + 2*i)));
+        vst1q_u8(aDest + 2*i, vrev16q_u8(vreinterpretq_u8_s16(NeonScale16(v, gain, gain))));
+    }
+    ScalarConstant16(aSrc + 2*i, aDest + 2*i, aNumSubsamples - i, aGain);
+}
+
+static void NeonStereo16(const TByte* aSrc, TByte* aDest, TUint aNumSamples, const TUint* aGains)
+{
+    TUint i = 0;
+    for (; i+4 <= aNumSamples; i+=4) {
+        const int32x4_t g = vreinterpretq_s32_u32(vld1q_u32(aGains + i));
+        const int32x4x2_t gains = vzipq_s32(g, g); // each gain repeated for left and right
+        const int16x8_t v = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(aSrc + 4*i)));
+        vst1q_u8(aDest + 4*i, vrev16q_u8(vreinterpretq_u8_s16(NeonScale16(v, gains.val[0], gains.val[1]))));
+    }
+    ScalarStereo16(aSrc + 4*i, aDest + 4*i, aNumSamples - i, aGains + i);
+}
+
+static void NeonConstant32(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain)
+{
+    const int32x2_t gain = vdup_n_s32((int32_t)aGain);
+    TUint i = 0;
+    for (; i+4 <= aNumSubsamples; i+=4) {
+        const int32x4_t v = vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(aSrc + 4*i)));
+        const int32x2_t lo = vshrn_n_s64(vmull_s32(vget_low_s32(v), gain), PcmGain::kShift);
+        const int32x2_t hi = vshrn_n_s64(vmull_s32(vget_high_s32(v), gain), PcmGain::kShift);
+        vst1q_u8(aDest + 4*i, vrev32q_u8(vreinterpretq_u8_s32(vcombine_s32(lo, hi))));
+    }
+    ScalarConstant32(aSrc + 4*i, aDest + 4*i, aNumSubsamples - i, aGain);
+}
+
+#endif // OH_SIMD_NEON
+
+
+// PcmGain
+
+void PcmGain::Apply(const TByte* aSrc, TByte* aDest, TUint aNumSamples,
+                    TUint aBitDepth, TUint aNumChannels, const TUint* aGains)
+{ // static
+    switch (aBitDepth)
+    {
+    case 8:
+        ApplyForChannels<1>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        break;
+    case 16:
+        if (aNumChannels == 2) {
+            Instance().iStereo16(aSrc, aDest, aNumSamples, aGains);
+        }
+        else {
+            ApplyForChannels<2>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        }
+        break;
+    case 24:
+        ApplyForChannels<3>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        break;
+    case 32:
+        ApplyForChannels<4>(aSrc, aDest, aNumSamples, aNumChannels, aGains);
+        break;
+    default:
+        ASSERTS();
+    }
+}
+
+void PcmGain::ApplyConstant(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples,
+                            TUint aBitDepth, TUint aGain)
+{ // static
+    switch (aBitDepth)
+    {
+    case 8:
+        ApplyConstantKernel<1>(aSrc, aDest, aNumSubsamples, aGain);
+        break;
+    case 16:
+        Instance().iConstant16(aSrc, aDest, aNumSubsamples, aGain);
+        break;
+    case 24:
+        ApplyConstantKernel<3>(aSrc, aDest, aNumSubsamples, aGain);
+        break;
+    case 32:
+        Instance().iConstant32(aSrc, aDest, aNumSubsamples, aGain);
+        break;
+    default:
+        ASSERTS();
+    }
+}
+
+PcmGain::Impl PcmGain::Current()
+{ // static
+    return Instance().iImpl;
+}
+
+const TChar* PcmGain::Name(Impl aImpl)
+{ // static
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        return "Scalar";
+    case Impl::Sse2:
+        return "SSE2";
+    case Impl::Avx2:
+        return "AVX2";
+    case Impl::Neon:
+        return "NEON";
+    }
+    return "Unknown";
+}
+
+TBool PcmGain::IsSupported(Impl aImpl)
+{ // static
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        return true;
+    case Impl::Sse2:
+        return CpuFeatures::HasSse2();
+    case Impl::Avx2:
+        return CpuFeatures::HasAvx2();
+    case Impl::Neon:
+        return CpuFeatures::HasNeon();
+    }
+    return false;
+}
+
+void PcmGain::Select(Impl aImpl)
+{ // static
+    ASSERT(IsSupported(aImpl));
+    Instance().Set(aImpl);
+}
+
+PcmGain::Kernels& PcmGain::Instance()
+{ // static
+    static Kernels kernels;
+    return kernels;
+}
+
+
+// PcmGain::Kernels
+
+PcmGain::Kernels::Kernels()
+{
+    const Impl preferred[] = { Impl::Avx2, Impl::Sse2, Impl::Neon };
+    Impl impl = Impl::Scalar;
+    for (auto candidate : preferred) {
+        if (IsSupported(candidate)) {
+            impl = candidate;
+            break;
+        }
+    }
+    Set(impl);
+}
+
+void PcmGain::Kernels::Set(Impl aImpl)
+{
+    iImpl = aImpl;
+    iConstant16 = ScalarConstant16;
+    iConstant32 = ScalarConstant32;
+    iStereo16 = ScalarStereo16;
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        break;
+#if defined(OH_SIMD_X86)
+    case Impl::Sse2:
+        iConstant16 = Sse2Constant16;
+        iStereo16 = Sse2Stereo16;
+        break;
+    case Impl::Avx2:
+        iConstant16 = Avx2Constant16;
+        iConstant32 = Avx2Constant32;
+        iStereo16 = Avx2Stereo16;
+        break;
+#endif
+#if defined(OH_SIMD_NEON)
+    case Impl::Neon:
+        iConstant16 = NeonConstant16;
+        iConstant32 = NeonConstant32;
+        iStereo16 = NeonStereo16;
+        break;
+#endif
+    default:
+        ASSERTS();
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Applies a per-sample gain to packed big endian PCM at its full bit depth.
+ * Gains are Q15 fixed point (kUnity leaves audio unchanged) and must not exceed kUnity.
+ * Apply() scales every subsample of sample n by aGains[n]; ApplyConstant() scales all subsamples by aGain.
+ * aSrc and aDest may be the same buffer but must not otherwise overlap.
+ *
+ * Vectorised kernels are selected once, on first use, based on CpuFeatures.  They cover
+ * ApplyConstant() for 16 and 32-bit audio and Apply() for 16-bit stereo.  Other formats
+ * (including all 8 and 24-bit audio) use scalar kernels, specialised at compile time for each
+ * bit depth and common channel count.
+ */
+
+class PcmGain
+{
+public:
+    static const TUint kShift = 15;
+    static const TUint kUnity = 1 << kShift;
+    enum class Impl
+    {
+        Scalar,
+        Sse2,   // 16-bit only; 32-bit falls back to Scalar
+        Avx2,
+        Neon
+    };
+public:
+    static void Apply(const TByte* aSrc, TByte* aDest, TUint aNumSamples,
+                      TUint aBitDepth, TUint aNumChannels, const TUint* aGains);
+    static void ApplyConstant(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples,
+                              TUint aBitDepth, TUint aGain);
+    static Impl Current();
+    static const TChar* Name(Impl aImpl);
+    static TBool IsSupported(Impl aImpl);
+    static void Select(Impl aImpl); // test/benchmark use only.  Not thread safe; aImpl must be supported
+private:
+    typedef void (*KernelConstant)(const TByte* aSrc, TByte* aDest, TUint aNumSubsamples, TUint aGain);
+    typedef void (*KernelStereo)(const TByte* aSrc, TByte* aDest, TUint aNumSamples, const TUint* aGains);
+    class Kernels
+    {
+    public:
+        Kernels();
+        void Set(Impl aImpl);
+    public:
+        Impl iImpl;
+        KernelConstant iConstant16;
+        KernelConstant iConstant32;
+        KernelStereo iStereo16;
+    };
+    static Kernels& Instance();
+};
+
+} // namespace Media
+} // namespace OpenHome
+
@@ -0,0 +1,437 @@
+#include <OpenHome/Media/Utils/PcmInterleave.h>
+#include <OpenHome/Media/Utils/CpuFeatures.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <limits.h>
+
+#if defined(OH_SIMD_X86)
+# include <immintrin.h>
+#endif
+#if defined(OH_SIMD_NEON)
+# include <arm_neon.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// Kernels
+// Output width, channel count and clipping are template parameters so that the inner loops have
+// fixed trip counts and no per-sample branching.  kChannels==0 reads the channel count at run time.
+// Vectorised kernels produce 8 subsamples per iteration (8 mono or 4 stereo samples).
+
+namespace {
+
+template<TUint kBytes> struct Subsample;
+
+template<> struct Subsample<1>
+{
+    static inline void Write(TByte* aPtr, TInt32 aVal)
+    {
+        aPtr[0] = (TByte)aVal;
+    }
+};
+
+template<> struct Subsample<2>
+{
+    static inline void Write(TByte* aPtr, TInt32 aVal)
+    {
+        aPtr[0] = (TByte)(aVal >> 8);
+        aPtr[1] = (TByte)aVal;
+    }
+};
+
+template<> struct Subsample<3>
+{
+    static inline void Write(TByte* aPtr, TInt32 aVal)
+    {
+        aPtr[0] = (TByte)(aVal >> 16);
+        aPtr[1] = (TByte)(aVal >> 8);
+        aPtr[2] = (TByte)aVal;
+    }
+};
+
+template<> struct Subsample<4>
+{
+    static inline void Write(TByte* aPtr, TInt32 aVal)
+    {
+        aPtr[0] = (TByte)(aVal >> 24);
+        aPtr[1] = (TByte)(aVal >> 16);
+        aPtr[2] = (TByte)(aVal >> 8);
+        aPtr[3] = (TByte)aVal;
+    }
+};
+
+template<TUint kBytes, TUint kChannels, TBool kClip>
+void ScalarKernel(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples, TUint aNumChannels,
+                  TUint aShift, TInt32 aMin, TInt32 aMax, TByte* aDest)
+{
+    const TUint channels = (kChannels == 0? aNumChannels : kChannels);
+    const TUint end = aFirstSample + aNumSamples;
+    for (TUint i=aFirstSample; i<end; i++) {
+        for (TUint ch=0; ch<channels; ch++) {
+            TInt32 subsample = aPlanes[ch][i];
+            if (kClip) {
+                if (subsample > aMax) {
+                    subsample = aMax;
+                }
+                else if (subsample < aMin) {
+                    subsample = aMin;
+                }
+                subsample >>= aShift;
+            }
+            Subsample<kBytes>::Write(aDest, subsample);
+            aDest += kBytes;
+        }
+    }
+}
+
+template<TUint kBytes, TBool kClip>
+void ScalarForChannels(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples, TUint aNumChannels,
+                       TUint aShift, TInt32 aMin, TInt32 aMax, TByte* aDest)
+{
+    switch (aNumChannels)
+    {
+    case 1:
+        ScalarKernel<kBytes, 1, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    case 2:
+        ScalarKernel<kBytes, 2, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    case 6:
+        ScalarKernel<kBytes, 6, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    case 8:
+        ScalarKernel<kBytes, 8, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    default:
+        ScalarKernel<kBytes, 0, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    }
+}
+
+template<TBool kClip>
+void ScalarForBitDepth(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples, TUint aNumChannels,
+                       TUint aBitDepth, TUint aShift, TInt32 aMin, TInt32 aMax, TByte* aDest)
+{
+    switch (aBitDepth)
+    {
+    case 8:
+        ScalarForChannels<1, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    case 16:
+        ScalarForChannels<2, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    case 24:
+        ScalarForChannels<3, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    case 32:
+        ScalarForChannels<4, kClip>(aPlanes, aFirstSample, aNumSamples, aNumChannels, aShift, aMin, aMax, aDest);
+        break;
+    default:
+        ASSERTS();
+    }
+}
+
+TUint NoVectorKernel(const TInt32* const /*aPlanes*/[], TUint /*aFirstSample*/, TUint /*aNumSamples*/,
+                     TUint /*aNumChannels*/, TUint /*aBitDepth*/, TUint /*aShift*/, TInt32 /*aMin*/, TInt32 /*aMax*/,
+                     TByte* /*aDest*/)
+{
+    return 0;
+}
+
+#if defined(OH_SIMD_X86)
+
+OH_SIMD_TARGET("ssse3") inline __m128i Ssse3Clip(__m128i aVal, __m128i aMin, __m128i aMax, __m128i aShift)
+{
+    // no SSE4.1 min/max so select using compare masks
+    const __m128i above = _mm_cmpgt_epi32(aVal, aMax);
+    aVal = _mm_or_si128(_mm_and_si128(above, aMax), _mm_andnot_si128(above, aVal));
+    const __m128i below = _mm_cmplt_epi32(aVal, aMin);
+    aVal = _mm_or_si128(_mm_and_si128(below, aMin), _mm_andnot_si128(below, aVal));
+    return _mm_sra_epi32(aVal, aShift);
+}
+
+template<TUint kBytes, TUint kChannels>
+OH_SIMD_TARGET("ssse3") TUint Ssse3Kernel(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                                          TUint aShift, TInt32 aMin, TInt32 aMax, TByte* aDest)
+{
+    const __m128i shift = _mm_cvtsi32_si128((int)aShift);
+    const __m128i vmin = _mm_set1_epi32(aMin);
+    const __m128i vmax = _mm_set1_epi32(aMax);
+    const __m128i swap16 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    const __m128i swap24 = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m128i swap32 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const TUint kStep = 8 / kChannels;
+    const TInt32* left = aPlanes[0] + aFirstSample;
+    const TInt32* right = aPlanes[kChannels - 1] + aFirstSample;
+    TUint i = 0;
+    for (; i+kStep <= aNumSamples; i+=kStep) {
+        __m128i lo, hi;
+        if (kChannels == 1) {
+            lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+            hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i + 4));
+        }
+        else {
+            const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+            const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+            lo = _mm_unpacklo_epi32(l, r);
+            hi = _mm_unpackhi_epi32(l, r);
+        }
+        lo = Ssse3Clip(lo, vmin, vmax, shift);
+        hi = Ssse3Clip(hi, vmin, vmax, shift);
+        if (kBytes == 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest), _mm_shuffle_epi8(_mm_packs_epi32(lo, hi), swap16));
+        }
+        else if (kBytes == 3) {
+            // 12 bytes from each vector; write exactly 24 bytes
+            const __m128i a = _mm_shuffle_epi8(lo, swap24);
+            const __m128i b = _mm_shuffle_epi8(hi, swap24);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest), _mm_or_si128(a, _mm_slli_si128(b, 12)));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(aDest + 16), _mm_srli_si128(b, 4));
+        }
+        else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest), _mm_shuffle_epi8(lo, swap32));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(aDest + 16), _mm_shuffle_epi8(hi, swap32));
+        }
+        aDest += 8 * kBytes;
+    }
+    return i;
+}
+
+#endif // OH_SIMD_X86
+
+#if defined(OH_SIMD_NEON)
+
+template<TUint kBytes, TUint kChannels>
+TUint NeonKernel(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                 TUint aShift, TInt32 aMin, TInt32 aMax, TByte* aDest)
+{
+    const int32x4_t shift = vdupq_n_s32(-(TInt)aShift); // negative left shift is an arithmetic right shift
+    const int32x4_t vmin = vdupq_n_s32(aMin);
+    const int32x4_t vmax = vdupq_n_s32(aMax);
+    const TUint kStep = 8 / kChannels;
+    const TInt32* left = aPlanes[0] + aFirstSample;
+    const TInt32* right = aPlanes[kChannels - 1] + aFirstSample;
+    TUint i = 0;
+    for (; i+kStep <= aNumSamples; i+=kStep) {
+        int32x4_t lo, hi;
+        if (kChannels == 1) {
+            lo = vld1q_s32(left + i);
+            hi = vld1q_s32(left + i + 4);
+        }
+        else {
+            const int32x4x2_t zipped = vzipq_s32(vld1q_s32(left + i), vld1q_s32(right + i));
+            lo = zipped.val[0];
+            hi = zipped.val[1];
+        }
+        lo = vshlq_s32(vminq_s32(vmaxq_s32(lo, vmin), vmax), shift);
+        hi = vshlq_s32(vminq_s32(vmaxq_s32(hi, vmin), vmax), shift);
+        if (kBytes == 2) {
+            const int16x8_t packed = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+            vst1q_u8(aDest, vrev16q_u8(vreinterpretq_u8_s16(packed)));
+        }
+        else if (kBytes == 3) {
+            // split into high/mid/low byte planes then let vst3 interleave them
+            const uint32x4_t ulo = vreinterpretq_u32_s32(lo);
+            const uint32x4_t uhi = vreinterpretq_u32_s32(hi);
+            const uint16x8_t low16 = vcombine_u16(vmovn_u32(ulo), vmovn_u32(uhi));
+            const uint16x8_t high16 = vcombine_u16(vshrn_n_u32(ulo, 16), vshrn_n_u32(uhi, 16));
+            uint8x8x3_t planes;
+            planes.val[0] = vmovn_u16(high16);
+            planes.val[1] = vshrn_n_u16(low16, 8);
+            planes.val[2] = vmovn_u16(low16);
+            vst3_u8(aDest, planes);
+        }
+        else {
+            vst1q_u8(aDest, vrev32q_u8(vreinterpretq_u8_s32(lo)));
+            vst1q_u8(aDest + 16, vrev32q_u8(vreinterpretq_u8_s32(hi)));
+        }
+        aDest += 8 * kBytes;
+    }
+    return i;
+}
+
+#endif // OH_SIMD_NEON
+
+// Vectorised kernels handle mono/stereo output at 16, 24 and 32 bits.  Anything else is left to the scalar kernels.
+
+#if defined(OH_SIMD_X86)
+
+TUint Ssse3Dispatch(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples, TUint aNumChannels,
+                    TUint aBitDepth, TUint aShift, TInt32 aMin, TInt32 aMax, TByte* aDest)
+{
+    if (aNumChannels == 1) {
+        switch (aBitDepth)
+        {
+        case 16: return Ssse3Kernel<2, 1>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        case 24: return Ssse3Kernel<3, 1>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        case 32: return Ssse3Kernel<4, 1>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        }
+    }
+    else if (aNumChannels == 2) {
+        switch (aBitDepth)
+        {
+        case 16: return Ssse3Kernel<2, 2>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        case 24: return Ssse3Kernel<3, 2>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        case 32: return Ssse3Kernel<4, 2>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        }
+    }
+    return 0;
+}
+
+#endif // OH_SIMD_X86
+
+#if defined(OH_SIMD_NEON)
+
+TUint NeonDispatch(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples, TUint aNumChannels,
+                   TUint aBitDepth, TUint aShift, TInt32 aMin, TInt32 aMax, TByte* aDest)
+{
+    if (aNumChannels == 1) {
+        switch (aBitDepth)
+        {
+        case 16: return NeonKernel<2, 1>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        case 24: return NeonKernel<3, 1>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        case 32: return NeonKernel<4, 1>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        }
+    }
+    else if (aNumChannels == 2) {
+        switch (aBitDepth)
+        {
+        case 16: return NeonKernel<2, 2>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        case 24: return NeonKernel<3, 2>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        case 32: return NeonKernel<4, 2>(aPlanes, aFirstSample, aNumSamples, aShift, aMin, aMax, aDest);
+        }
+    }
+    return 0;
+}
+
+#endif // OH_SIMD_NEON
+
+} // namespace
+
+
+// PcmInterleave
+
+void PcmInterleave::Pack(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                         TUint aNumChannels, TUint aBitDepth, TByte* aDest)
+{ // static
+    Interleave(aPlanes, aFirstSample, aNumSamples, aNumChannels, aBitDepth, 0, false, aDest);
+}
+
+void PcmInterleave::PackScaled(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                               TUint aNumChannels, TUint aShift, TUint aBitDepth, TByte* aDest)
+{ // static
+    Interleave(aPlanes, aFirstSample, aNumSamples, aNumChannels, aBitDepth, aShift, true, aDest);
+}
+
+PcmInterleave::Impl PcmInterleave::Current()
+{ // static
+    return Instance().iImpl;
+}
+
+const TChar* PcmInterleave::Name(Impl aImpl)
+{ // static
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        return "Scalar";
+    case Impl::Ssse3:
+        return "SSSE3";
+    case Impl::Neon:
+        return "NEON";
+    }
+    return "Unknown";
+}
+
+TBool PcmInterleave::IsSupported(Impl aImpl)
+{ // static
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        return true;
+    case Impl::Ssse3:
+        return CpuFeatures::HasSsse3();
+    case Impl::Neon:
+        return CpuFeatures::HasNeon();
+    }
+    return false;
+}
+
+void PcmInterleave::Select(Impl aImpl)
+{ // static
+    ASSERT(IsSupported(aImpl));
+    Instance().Set(aImpl);
+}
+
+void PcmInterleave::Interleave(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                               TUint aNumChannels, TUint aBitDepth, TUint aShift, TBool aClip, TByte* aDest)
+{ // static
+    ASSERT(aBitDepth + aShift <= 32);
+    TInt32 min = INT_MIN;
+    TInt32 max = INT_MAX;
+    if (aClip) {
+        const TInt64 limit = (TInt64)1 << (aBitDepth + aShift - 1);
+        min = (TInt32)-limit;
+        max = (TInt32)(limit - 1);
+    }
+    const TUint done = Instance().iKernel(aPlanes, aFirstSample, aNumSamples, aNumChannels,
+                                          aBitDepth, aShift, min, max, aDest);
+    if (done == aNumSamples) {
+        return;
+    }
+    aDest += done * aNumChannels * (aBitDepth / 8);
+    if (aClip) {
+        ScalarForBitDepth<true>(aPlanes, aFirstSample + done, aNumSamples - done, aNumChannels,
+                                aBitDepth, aShift, min, max, aDest);
+    }
+    else {
+        ScalarForBitDepth<false>(aPlanes, aFirstSample + done, aNumSamples - done, aNumChannels,
+                                 aBitDepth, aShift, min, max, aDest);
+    }
+}
+
+PcmInterleave::Kernels& PcmInterleave::Instance()
+{ // static
+    static Kernels kernels;
+    return kernels;
+}
+
+
+// PcmInterleave::Kernels
+
+PcmInterleave::Kernels::Kernels()
+{
+    const Impl preferred[] = { Impl::Ssse3, Impl::Neon };
+    Impl impl = Impl::Scalar;
+    for (auto candidate : preferred) {
+        if (IsSupported(candidate)) {
+            impl = candidate;
+            break;
+        }
+    }
+    Set(impl);
+}
+
+void PcmInterleave::Kernels::Set(Impl aImpl)
+{
+    iImpl = aImpl;
+    iKernel = NoVectorKernel;
+    switch (aImpl)
+    {
+    case Impl::Scalar:
+        break;
+#if defined(OH_SIMD_X86)
+    case Impl::Ssse3:
+        iKernel = Ssse3Dispatch;
+        break;
+#endif
+#if defined(OH_SIMD_NEON)
+    case Impl::Neon:
+        iKernel = NeonDispatch;
+        break;
+#endif
+    default:
+        ASSERTS();
+    }
+}
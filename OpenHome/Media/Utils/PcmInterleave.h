@@ -0,0 +1,55 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Interleaves planar 32-bit decoder output into packed big endian PCM.
+ * aPlanes holds one array per channel; samples [aFirstSample, aFirstSample+aNumSamples) are packed to aDest.
+ * Pack() expects subsamples that already fit in aBitDepth.  PackScaled() first clips each subsample
+ * to the range that fits after an arithmetic right shift by aShift, then shifts it.
+ * Kernels are specialised at compile time for output depth and common channel counts.
+ * Vectorised kernels (mono and stereo) are selected once, on first use, based on CpuFeatures.
+ */
+
+class PcmInterleave
+{
+public:
+    enum class Impl
+    {
+        Scalar,
+        Ssse3,
+        Neon
+    };
+public:
+    static void Pack(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                     TUint aNumChannels, TUint aBitDepth, TByte* aDest);
+    static void PackScaled(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                           TUint aNumChannels, TUint aShift, TUint aBitDepth, TByte* aDest);
+    static Impl Current();
+    static const TChar* Name(Impl aImpl);
+    static TBool IsSupported(Impl aImpl);
+    static void Select(Impl aImpl); // test/benchmark use only.  Not thread safe; aImpl must be supported
+private:
+    // Returns number of samples packed.  Any remainder is packed using the scalar kernels.
+    typedef TUint (*Kernel)(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                            TUint aNumChannels, TUint aBitDepth, TUint aShift, TInt32 aMin, TInt32 aMax,
+                            TByte* aDest);
+    static void Interleave(const TInt32* const aPlanes[], TUint aFirstSample, TUint aNumSamples,
+                           TUint aNumChannels, TUint aBitDepth, TUint aShift, TBool aClip, TByte* aDest);
+    class Kernels
+    {
+    public:
+        Kernels();
+        void Set(Impl aImpl);
+    public:
+        Impl iImpl;
+        Kernel iKernel;
+    };
+    static Kernels& Instance();
+};
+
+} // namespace Media
+} // namespace OpenHome
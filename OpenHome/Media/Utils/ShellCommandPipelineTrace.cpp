@@ -0,0 +1,63 @@
+#include <OpenHome/Media/Utils/ShellCommandPipelineTrace.h>
+#include <OpenHome/Private/Shell.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Media/Pipeline/PipelineTrace.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+const TChar ShellCommandPipelineTrace::kShellCommand[] = "pipeline_trace";
+
+ShellCommandPipelineTrace::ShellCommandPipelineTrace(IShell& aShell, PipelineTrace& aTrace)
+    : iShell(aShell)
+    , iTrace(aTrace)
+{
+    iShell.AddCommandHandler(kShellCommand, *this);
+}
+
+ShellCommandPipelineTrace::~ShellCommandPipelineTrace()
+{
+    iShell.RemoveCommandHandler(kShellCommand);
+}
+
+void ShellCommandPipelineTrace::HandleShellCommand(Brn /*aCommand*/, const std::vector<Brn>& aArgs, IWriter& aResponse)
+{
+    if (aArgs.size() != 1) {
+        aResponse.Write(Brn("Unexpected number of arguments for \'pipeline_trace\' command\n"));
+        return;
+    }
+    const Brx& arg = aArgs[0];
+    if (arg == Brn("on")) {
+        iTrace.SetEnabled(true);
+    }
+    else if (arg == Brn("off")) {
+        iTrace.SetEnabled(false);
+    }
+    else if (arg == Brn("reset")) {
+        iTrace.Reset();
+    }
+    else if (arg == Brn("stats")) {
+        iTrace.WriteStats(aResponse);
+    }
+    else if (arg == Brn("chrome")) {
+        iTrace.WriteChromeTrace(aResponse);
+        aResponse.Write(Brn("\n"));
+    }
+    else {
+        aResponse.Write(Brn("Error: unrecognised option - "));
+        aResponse.Write(arg);
+        aResponse.Write(Brn("\n"));
+    }
+}
+
+void ShellCommandPipelineTrace::DisplayHelp(IWriter& aResponse)
+{
+    aResponse.Write(Brn("pipeline_trace [on|off|reset|stats|chrome]\n"));
+    aResponse.Write(Brn("  time msgs passing through each pipeline element\n"));
+    aResponse.Write(Brn("  on/off - start/stop recording (elements must be built with EPipelineSupportElementsLogger)\n"));
+    aResponse.Write(Brn("  reset  - discard all recorded msgs\n"));
+    aResponse.Write(Brn("  stats  - per element percentile self time (excluding upstream elements), msgs/s and jiffies/s\n"));
+    aResponse.Write(Brn("  chrome - dump recorded msgs as Chrome trace-event JSON (load via chrome://tracing)\n"));
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <OpenHome/Private/Shell.h>
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Media {
+
+class PipelineTrace;
+
+class ShellCommandPipelineTrace : private IShellCommandHandler
+{
+    static const TChar kShellCommand[];
+public:
+    ShellCommandPipelineTrace(IShell& aShell, PipelineTrace& aTrace);
+    ~ShellCommandPipelineTrace();
+private: // from IShellCommandHandler
+    void HandleShellCommand(Brn aCommand, const std::vector<Brn>& aArgs, IWriter& aResponse) override;
+    void DisplayHelp(IWriter& aResponse) override;
+private:
+    IShell& iShell;
+    PipelineTrace& iTrace;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -0,0 +1,291 @@
+#include <OpenHome/Media/Utils/ThreadScheduler.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Debug.h>
+#include <OpenHome/Media/Debug.h>
+
+#include <vector>
+
+#ifdef __linux__
+# include <pthread.h>
+# include <sched.h>
+# include <sys/mman.h>
+# include <errno.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// ThreadScheduler::ThreadState
+
+ThreadScheduler::ThreadState::ThreadState()
+    : iCpuMask(0)
+    , iPriority(kPriorityNormal)
+    , iApplied(false)
+    , iHostPriority(0)
+    , iError(0)
+{
+}
+
+
+// ThreadScheduler
+
+const Brn ThreadScheduler::kQueryThreads("threads");
+
+ThreadScheduler::ThreadScheduler(IInfoAggregator& aInfoAggregator, ThreadSchedPolicy aPolicy)
+    : iLock("THSC")
+    , iPolicy(aPolicy)
+    , iMemoryLocked(false)
+    , iMemoryLockError(0)
+{
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryThreads);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+void ThreadScheduler::SetCpuMask(PipelineThread aThread, TUint64 aCpuMask)
+{
+    AutoMutex _(iLock);
+    iThreads[(TUint)aThread].iCpuMask = aCpuMask;
+}
+
+void ThreadScheduler::SetPriority(PipelineThread aThread, TUint aPriority)
+{
+    AutoMutex _(iLock);
+    iThreads[(TUint)aThread].iPriority = aPriority;
+}
+
+void ThreadScheduler::LockMemory()
+{
+    AutoMutex _(iLock);
+    if (iMemoryLocked) {
+        return;
+    }
+#ifdef __linux__
+    if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        iMemoryLockError = errno;
+        LOG_ERROR(kPipeline, "ThreadScheduler::LockMemory failed (errno=%d)\n", iMemoryLockError);
+        return;
+    }
+    iMemoryLocked = true;
+#endif
+}
+
+const TChar* ThreadScheduler::Name(PipelineThread aThread)
+{ // static
+    switch (aThread)
+    {
+    case PipelineThread::Filler:
+        return "Filler";
+    case PipelineThread::Codec:
+        return "CodecController";
+    case PipelineThread::StarvationRamper:
+        return "StarvationRamper";
+    case PipelineThread::FlywheelRamper:
+        return "FlywheelRamper";
+    case PipelineThread::Animator:
+        return "Animator";
+    }
+    return "Unknown";
+}
+
+const TChar* ThreadScheduler::Name(ThreadSchedPolicy aPolicy)
+{ // static
+    switch (aPolicy)
+    {
+    case ThreadSchedPolicy::Default:
+        return "default";
+    case ThreadSchedPolicy::Fifo:
+        return "fifo";
+    case ThreadSchedPolicy::RoundRobin:
+        return "rr";
+    }
+    return "unknown";
+}
+
+TBool ThreadScheduler::TryParseCpuMask(const Brx& aCpus, TUint64& aCpuMask)
+{ // static
+    if (aCpus == Brn("any")) {
+        aCpuMask = 0;
+        return true;
+    }
+    const TUint bytes = aCpus.Bytes();
+    TUint64 mask = 0;
+    TUint index = 0;
+    for (;;) {
+        TUint first, last;
+        if (!TryParseCpu(aCpus, index, first)) {
+            return false;
+        }
+        last = first;
+        if (index < bytes && aCpus[index] == '-') {
+            index++;
+            if (!TryParseCpu(aCpus, index, last) || last < first) {
+                return false;
+            }
+        }
+        for (TUint cpu=first; cpu<=last; cpu++) {
+            mask |= (TUint64)1 << cpu;
+        }
+        if (index == bytes) {
+            break;
+        }
+        if (aCpus[index] != ',') {
+            return false;
+        }
+        index++; // a trailing ',' fails TryParseCpu() on the next pass
+    }
+    aCpuMask = mask;
+    return true;
+}
+
+TBool ThreadScheduler::TryParsePolicy(const Brx& aPolicy, ThreadSchedPolicy& aPolicyOut)
+{ // static
+    const ThreadSchedPolicy policies[] = { ThreadSchedPolicy::Default, ThreadSchedPolicy::Fifo, ThreadSchedPolicy::RoundRobin };
+    for (auto policy : policies) {
+        if (aPolicy == Brn(Name(policy))) {
+            aPolicyOut = policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+TBool ThreadScheduler::TryParseCpu(const Brx& aCpus, TUint& aIndex, TUint& aCpu)
+{ // static
+    const TUint start = aIndex;
+    TUint cpu = 0;
+    while (aIndex < aCpus.Bytes() && aCpus[aIndex] >= '0' && aCpus[aIndex] <= '9') {
+        cpu = (cpu * 10) + (aCpus[aIndex] - '0');
+        if (cpu >= kMaxCpus) {
+            return false;
+        }
+        aIndex++;
+    }
+    if (aIndex == start) {
+        return false;
+    }
+    aCpu = cpu;
+    return true;
+}
+
+void ThreadScheduler::ApplyToCurrentThread(PipelineThread aThread)
+{
+    AutoMutex _(iLock);
+    ThreadState& state = iThreads[(TUint)aThread];
+    state.iApplied = true;
+    state.iError = 0;
+#ifdef __linux__
+    if (state.iCpuMask != 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (TUint i=0; i<kMaxCpus && i<CPU_SETSIZE; i++) {
+            if (state.iCpuMask & ((TUint64)1 << i)) {
+                CPU_SET(i, &cpus);
+            }
+        }
+        const int err = ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus);
+        if (err != 0) {
+            state.iError = err;
+            LOG_ERROR(kPipeline, "ThreadScheduler: failed to set affinity for %s (errno=%d)\n", Name(aThread), err);
+        }
+    }
+    if (iPolicy != ThreadSchedPolicy::Default) {
+        const int policy = (iPolicy == ThreadSchedPolicy::Fifo? SCHED_FIFO : SCHED_RR);
+        struct sched_param param;
+        param.sched_priority = HostPriority(iPolicy, state.iPriority);
+        const int err = ::pthread_setschedparam(::pthread_self(), policy, &param);
+        if (err != 0) {
+            if (state.iError == 0) {
+                state.iError = err;
+            }
+            LOG_ERROR(kPipeline, "ThreadScheduler: failed to set %s policy for %s (errno=%d)\n", Name(iPolicy), Name(aThread), err);
+        }
+        else {
+            state.iHostPriority = param.sched_priority;
+        }
+    }
+#else
+    (void)aThread;
+#endif
+}
+
+TInt ThreadScheduler::HostPriority(ThreadSchedPolicy aPolicy, TUint aPriority)
+{ // static
+#ifdef __linux__
+    const int policy = (aPolicy == ThreadSchedPolicy::Fifo? SCHED_FIFO : SCHED_RR);
+    const TInt min = ::sched_get_priority_min(policy);
+    const TInt max = ::sched_get_priority_max(policy);
+    if (aPriority <= kPriorityLowest) {
+        return min;
+    }
+    if (aPriority >= kPriorityHighest) {
+        return max;
+    }
+    // linear mapping preserves relative ordering of pipeline threads
+    return min + (TInt)(((aPriority - kPriorityLowest) * (TUint)(max - min)) / (kPriorityHighest - kPriorityLowest));
+#else
+    (void)aPolicy;
+    return (TInt)aPriority;
+#endif
+}
+
+void ThreadScheduler::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    if (aQuery != kQueryThreads) {
+        return;
+    }
+    AutoMutex _(iLock);
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("Pipeline threads: policy="));
+    writer.Write(Brn(Name(iPolicy)));
+    writer.Write(Brn(" memoryLocked="));
+    writer.Write(Brn(iMemoryLocked? "true" : "false"));
+    if (iMemoryLockError != 0) {
+        writer.Write(Brn(" (errno="));
+        writer.WriteInt(iMemoryLockError);
+        writer.Write(Brn(")"));
+    }
+    writer.Write(Brn("\n"));
+    for (TUint i=0; i<kNumThreads; i++) {
+        const ThreadState& state = iThreads[i];
+        writer.Write(Brn("    "));
+        writer.Write(Brn(Name((PipelineThread)i)));
+        writer.Write(Brn(": cpus="));
+        if (state.iCpuMask == 0) {
+            writer.Write(Brn("any"));
+        }
+        else {
+            TBool first = true;
+            for (TUint cpu=0; cpu<kMaxCpus; cpu++) {
+                if (state.iCpuMask & ((TUint64)1 << cpu)) {
+                    if (!first) {
+                        writer.Write(',');
+                    }
+                    writer.WriteUint(cpu);
+                    first = false;
+                }
+            }
+        }
+        writer.Write(Brn(" priority="));
+        writer.WriteUint(state.iPriority);
+        if (!state.iApplied) {
+            writer.Write(Brn(" (not started)"));
+        }
+        else {
+            if (iPolicy != ThreadSchedPolicy::Default) {
+                writer.Write(Brn(" hostPriority="));
+                writer.WriteInt(state.iHostPriority);
+            }
+            if (state.iError != 0) {
+                writer.Write(Brn(" errno="));
+                writer.WriteInt(state.iError);
+            }
+        }
+        writer.Write(Brn("\n"));
+    }
+}
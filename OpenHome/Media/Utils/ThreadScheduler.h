@@ -0,0 +1,87 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/InfoProvider.h>
+
+namespace OpenHome {
+namespace Media {
+
+enum class PipelineThread
+{
+    Filler,
+    Codec,
+    StarvationRamper,
+    FlywheelRamper,
+    Animator
+};
+
+enum class ThreadSchedPolicy
+{
+    Default,    // leave host scheduling to the OpenHome thread priority
+    Fifo,       // SCHED_FIFO
+    RoundRobin  // SCHED_RR
+};
+
+class IPipelineThreadScheduler
+{
+public:
+    virtual ~IPipelineThreadScheduler() {}
+    virtual void ApplyToCurrentThread(PipelineThread aThread) = 0; // call from the thread's entry point
+};
+
+/*
+ * Host scheduling for the pipeline's audio-critical threads.
+ * Each thread may be pinned to a set of CPUs and/or run under a real-time policy, with
+ * real-time priorities preserving the ordering of the threads' OpenHome priorities.
+ * LockMemory() locks current and future mappings (msg allocator pools, thread stacks)
+ * into RAM, faulting in any pages not yet touched.
+ * Only implemented on Linux; elsewhere settings are recorded but have no effect.
+ * Reported via IInfoAggregator's "threads" query.
+ */
+class ThreadScheduler : public IPipelineThreadScheduler, private IInfoProvider
+{
+    friend class SuiteThreadScheduler;
+public:
+    static const Brn kQueryThreads;
+    static const TUint kNumThreads = (TUint)PipelineThread::Animator + 1;
+    static const TUint kMaxCpus = 64;
+public:
+    ThreadScheduler(IInfoAggregator& aInfoAggregator, ThreadSchedPolicy aPolicy);
+    void SetCpuMask(PipelineThread aThread, TUint64 aCpuMask); // 0 => no restriction
+    void SetPriority(PipelineThread aThread, TUint aPriority); // OpenHome priority
+    void LockMemory();
+    static const TChar* Name(PipelineThread aThread);
+    static const TChar* Name(ThreadSchedPolicy aPolicy);
+    static TBool TryParseCpuMask(const Brx& aCpus, TUint64& aCpuMask); // "any" or a list of cpus/ranges, e.g. "0,2-3"
+    static TBool TryParsePolicy(const Brx& aPolicy, ThreadSchedPolicy& aPolicyOut); // any name returned by Name()
+public: // from IPipelineThreadScheduler
+    void ApplyToCurrentThread(PipelineThread aThread) override;
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
+private:
+    static TBool TryParseCpu(const Brx& aCpus, TUint& aIndex, TUint& aCpu);
+    static TInt HostPriority(ThreadSchedPolicy aPolicy, TUint aPriority);
+private:
+    class ThreadState
+    {
+    public:
+        ThreadState();
+    public:
+        TUint64 iCpuMask;
+        TUint iPriority;
+        TBool iApplied;
+        TInt iHostPriority;
+        TInt iError; // errno from first failing call, 0 on success
+    };
+private:
+    Mutex iLock;
+    const ThreadSchedPolicy iPolicy;
+    ThreadState iThreads[kNumThreads];
+    TBool iMemoryLocked;
+    TInt iMemoryLockError;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -238,7 +238,7 @@ const Brn SocketHttp::GetRequestMethod() const
 
 void SocketHttp::SetRequestMethod(const Brx& aMethod)
 {
-    if (iConnected) {
+    if (iRequestHeadersSent) {
         THROW(SocketHttpError);
     }
     // Invalid operation to set this following a call to Connect().
@@ -255,7 +255,7 @@ void SocketHttp::SetRequestMethod(const Brx& aMethod)
 
 void SocketHttp::SetRequestChunked()
 {
-    if (iConnected) {
+    if (iRequestHeadersSent) {
         THROW(SocketHttpError);
     }
 
@@ -266,7 +266,7 @@ void SocketHttp::SetRequestChunked()
 
 void SocketHttp::SetRequestContentLength(TUint64 aContentLength)
 {
-    if (iConnected) {
+    if (iRequestHeadersSent) {
         THROW(SocketHttpError);
     }
 
@@ -277,7 +277,7 @@ void SocketHttp::SetRequestContentLength(TUint64 aContentLength)
 
 void SocketHttp::SetRequestHeader(const Brx& aField, const Brx& aValue)
 {
-    if (iConnected) {
+    if (iRequestHeadersSent) {
         THROW(SocketHttpError);
     }
 
@@ -338,6 +338,11 @@ void SocketHttp::Reset()
     iMethod.Set(Http::kMethodGet);
 }
 
+TBool SocketHttp::IsConnected() const
+{
+    return iConnected;
+}
+
 IReader& SocketHttp::GetInputStream()
 {
     Connect();
@@ -375,6 +380,11 @@ void SocketHttp::Interrupt(TBool aInterrupt)
     iSocket.Interrupt(aInterrupt);
 }
 
+SocketSsl& SocketHttp::Socket()
+{
+    return iSocket;
+}
+
 Brn SocketHttp::Read(TUint aBytes)
 {
     if (!iConnected || !iResponseReceived) {
@@ -106,7 +106,7 @@ public:
     /*
      * Default request method is GET.
      *
-     * Throws SocketHttpMethodInvalid if method not supported; SocketHttpError if socket already connected.
+     * Throws SocketHttpMethodInvalid if method not supported; SocketHttpError if the request has already been sent.
      */
     void SetRequestMethod(const Brx& aMethod);
     /*
@@ -115,7 +115,7 @@ public:
      *
      * This will override any previous SetRequestContentLength() call.
      *
-     * Throws SocketHttpError if already connected.
+     * Throws SocketHttpError if the request has already been sent.
      */
     void SetRequestChunked();
     /*
@@ -124,13 +124,13 @@ public:
      *
      * This will override any previous SetRequestChunked() call.
      *
-     * Throws SocketHttpError if already connected.
+     * Throws SocketHttpError if the request has already been sent.
      */
     void SetRequestContentLength(TUint64 aContentLength);
     /*
      * Set any custom request headers to be sent up with requests.
      *
-     * Throws SocketHttpError if already connected.
+     * Throws SocketHttpError if the request has already been sent.
      */
     void SetRequestHeader(const OpenHome::Brx& aField, const OpenHome::Brx& aValue);
     /*
@@ -154,12 +154,23 @@ public:
      * Does not clear URI.
      */
     void Reset();
+    /*
+     * Returns true if the underlying socket is open, either following Connect() or
+     * because a previous response allowed its connection to be reused.
+     */
+    TBool IsConnected() const;
 
     IReader& GetInputStream();
     IWriter& GetOutputStream();
     TInt GetResponseCode();     // Returns -1 if unknown code.
     TInt GetContentLength();    // Returns -1 if unknown (e.g., chunked data).
     void Interrupt(TBool aInterrupt);
+    /*
+     * Underlying socket, for clients that write their own requests and read their own responses over a connection opened by Connect().
+     *
+     * Only valid between request/response pairs made through this class. Any response read directly must be read in full before this class is used again on the same connection.
+     */
+    SocketSsl& Socket();
 private: // from IReader
     Brn Read(TUint aBytes) override;
     void ReadFlush() override;
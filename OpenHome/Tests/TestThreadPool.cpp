@@ -68,6 +68,29 @@ private:
     TUint iCountCbLow;
 };
 
+class SuiteThreadPoolStealing : public SuiteUnitTest
+{
+    static const TUint kTimeoutMs = 5000;
+public:
+    SuiteThreadPoolStealing();
+public: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void CbBlocking();
+    void Cb();
+    void TestBlockedHighCallbackStolen();
+    void TestLowCallbackNotStolen();
+    void TestQueuedBehindWokenThreadStolen();
+private:
+    ThreadPool* iPool;
+    IThreadPoolHandle* iHandleBlocking;
+    IThreadPoolHandle* iHandle;
+    Semaphore iSemBlockingEntry;
+    Semaphore iSemBlockingExit;
+    Semaphore iSemCb;
+};
+
 } // namespace OpenHome
 
 
@@ -315,10 +338,108 @@ void SuiteThreadPool::CbLow()
 
 
 
+// SuiteThreadPoolStealing
+
+SuiteThreadPoolStealing::SuiteThreadPoolStealing()
+    : SuiteUnitTest("ThreadPoolStealing")
+    , iSemBlockingEntry("STS1", 0)
+    , iSemBlockingExit("STS2", 0)
+    , iSemCb("STS3", 0)
+{
+    AddTest(MakeFunctor(*this, &SuiteThreadPoolStealing::TestBlockedHighCallbackStolen), "TestBlockedHighCallbackStolen");
+    AddTest(MakeFunctor(*this, &SuiteThreadPoolStealing::TestLowCallbackNotStolen), "TestLowCallbackNotStolen");
+    AddTest(MakeFunctor(*this, &SuiteThreadPoolStealing::TestQueuedBehindWokenThreadStolen), "TestQueuedBehindWokenThreadStolen");
+}
+
+void SuiteThreadPoolStealing::Setup()
+{
+    iPool = new ThreadPool(1, 1, 1);
+    iHandleBlocking = nullptr;
+    iHandle = nullptr;
+    (void)iSemBlockingEntry.Clear();
+    (void)iSemBlockingExit.Clear();
+    (void)iSemCb.Clear();
+}
+
+void SuiteThreadPoolStealing::TearDown()
+{
+    iHandleBlocking->Destroy();
+    iHandle->Destroy();
+    delete iPool;
+}
+
+void SuiteThreadPoolStealing::CbBlocking()
+{
+    iSemBlockingEntry.Signal();
+    iSemBlockingExit.Wait();
+}
+
+void SuiteThreadPoolStealing::Cb()
+{
+    iSemCb.Signal();
+}
+
+void SuiteThreadPoolStealing::TestBlockedHighCallbackStolen()
+{
+    iHandleBlocking = iPool->CreateHandle(MakeFunctor(*this, &SuiteThreadPoolStealing::CbBlocking), "CbBlocking", ThreadPoolPriority::High);
+    iHandle = iPool->CreateHandle(MakeFunctor(*this, &SuiteThreadPoolStealing::Cb), "Cb", ThreadPoolPriority::High);
+    TEST(iHandleBlocking->TrySchedule());
+    iSemBlockingEntry.Wait();
+    // only high priority thread is blocked.  A lower priority thread should run the second callback
+    TEST(iHandle->TrySchedule());
+    iSemCb.Wait(kTimeoutMs);
+    TEST(iPool->StolenCount(ThreadPoolPriority::High) == 1);
+    iSemBlockingExit.Signal();
+    TEST(iHandle->TrySchedule());
+    iSemCb.Wait(kTimeoutMs);
+    // Cancel() waits for any running callback to complete, including its stats update
+    iHandleBlocking->Cancel();
+    iHandle->Cancel();
+    TEST(iPool->RunCount(ThreadPoolPriority::High) == 3);
+    TEST(iPool->RunCount(ThreadPoolPriority::Medium) == 0);
+    TEST(iPool->RunCount(ThreadPoolPriority::Low) == 0);
+}
+
+void SuiteThreadPoolStealing::TestLowCallbackNotStolen()
+{
+    iHandleBlocking = iPool->CreateHandle(MakeFunctor(*this, &SuiteThreadPoolStealing::CbBlocking), "CbBlocking", ThreadPoolPriority::Low);
+    iHandle = iPool->CreateHandle(MakeFunctor(*this, &SuiteThreadPoolStealing::Cb), "Cb", ThreadPoolPriority::Low);
+    TEST(iHandleBlocking->TrySchedule());
+    iSemBlockingEntry.Wait();
+    // higher priority threads never run lower priority callbacks
+    TEST(iHandle->TrySchedule());
+    TEST_THROWS(iSemCb.Wait(50), Timeout);
+    iSemBlockingExit.Signal();
+    iSemCb.Wait(kTimeoutMs);
+    iHandleBlocking->Cancel();
+    iHandle->Cancel();
+    TEST(iPool->RunCount(ThreadPoolPriority::Low) == 2);
+    TEST(iPool->StolenCount(ThreadPoolPriority::Low) == 0);
+}
+
+void SuiteThreadPoolStealing::TestQueuedBehindWokenThreadStolen()
+{
+    iHandleBlocking = iPool->CreateHandle(MakeFunctor(*this, &SuiteThreadPoolStealing::CbBlocking), "CbBlocking", ThreadPoolPriority::High);
+    iHandle = iPool->CreateHandle(MakeFunctor(*this, &SuiteThreadPoolStealing::Cb), "Cb", ThreadPoolPriority::High);
+    // schedule both before the high priority thread can run either.  Its one idle thread
+    // has been claimed by the first callback so a lower priority thread must run the second
+    TEST(iHandleBlocking->TrySchedule());
+    TEST(iHandle->TrySchedule());
+    iSemBlockingEntry.Wait();
+    iSemCb.Wait(kTimeoutMs);
+    iSemBlockingExit.Signal();
+    iHandleBlocking->Cancel();
+    iHandle->Cancel();
+    TEST(iPool->RunCount(ThreadPoolPriority::High) == 2);
+}
+
+
+
 void TestThreadPool()
 {
     Runner runner("ThreadPool tests\n");
     runner.Add(new SuitePriorityQueue());
     runner.Add(new SuiteThreadPool());
+    runner.Add(new SuiteThreadPoolStealing());
     runner.Run();
 }
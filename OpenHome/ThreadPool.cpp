@@ -3,28 +3,94 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Functor.h>
 #include <OpenHome/Debug-ohMediaPlayer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Ascii.h>
 #include <OpenHome/Private/Debug.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Stream.h>
 #include <OpenHome/Private/Thread.h>
+#include <OpenHome/Net/Private/Globals.h>
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <vector>
 
 using namespace OpenHome;
 
+static TUint64 TimeNowUs()
+{
+    return Os::TimeInUs(gEnv->OsCtx());
+}
+
+static void UpdateMax(std::atomic<TUint64>& aMax, TUint64 aVal)
+{
+    TUint64 prev = aMax.load();
+    while (aVal > prev && !aMax.compare_exchange_weak(prev, aVal)) {
+    }
+}
+
 // ThreadPool
 
+const Brn ThreadPool::kQueryThreadPool("threadpool");
+
 ThreadPool::ThreadPool(TUint aCountHigh, TUint aCountMedium, TUint aCountLow)
 {
-    LOG_DEBUG(kThreadPool, "ThreadPool: high=%u, medium=%u, low=%u\n", aCountHigh, aCountMedium, aCountLow);
-    iQueueHigh.reset(new PriorityQueue("PoolHigh", aCountHigh, kPriorityHigh));
-    iQueueMed.reset(new PriorityQueue("PoolMed", aCountMedium, kPriorityNormal));
-    iQueueLow.reset(new PriorityQueue("PoolLow", aCountLow, kPriorityLow));
+    CreateQueues(aCountHigh, aCountMedium, aCountLow);
+}
+
+ThreadPool::ThreadPool(IInfoAggregator& aInfoAggregator, TUint aCountHigh, TUint aCountMedium, TUint aCountLow)
+{
+    CreateQueues(aCountHigh, aCountMedium, aCountLow);
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryThreadPool);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+TUint64 ThreadPool::RunCount(ThreadPoolPriority aPriority) const
+{
+    return Queue(aPriority).RunCount();
+}
+
+TUint64 ThreadPool::StolenCount(ThreadPoolPriority aPriority) const
+{
+    return Queue(aPriority).StolenCount();
 }
 
 IThreadPoolHandle* ThreadPool::CreateHandle(Functor aCb, const TChar* aId, ThreadPoolPriority aPriority)
 {
     LOG_DEBUG(kThreadPool, "ThreadPool::CreateHandle %s\n", aId);
+    return Queue(aPriority).CreateHandle(aCb, aId);
+}
+
+void ThreadPool::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    if (aQuery != kQueryThreadPool) {
+        return;
+    }
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("ThreadPool\n"));
+    writer.Write(Brn("    high: "));
+    iQueueHigh->WriteStats(aWriter);
+    writer.Write(Brn("    medium: "));
+    iQueueMed->WriteStats(aWriter);
+    writer.Write(Brn("    low: "));
+    iQueueLow->WriteStats(aWriter);
+}
+
+void ThreadPool::CreateQueues(TUint aCountHigh, TUint aCountMedium, TUint aCountLow)
+{
+    LOG_DEBUG(kThreadPool, "ThreadPool: high=%u, medium=%u, low=%u\n", aCountHigh, aCountMedium, aCountLow);
+    std::vector<PriorityQueue*> stealFrom;
+    iQueueHigh.reset(new PriorityQueue("PoolHigh", aCountHigh, kPriorityHigh));
+    stealFrom.push_back(iQueueHigh.get());
+    iQueueMed.reset(new PriorityQueue("PoolMed", aCountMedium, kPriorityNormal, stealFrom));
+    stealFrom.push_back(iQueueMed.get());
+    iQueueLow.reset(new PriorityQueue("PoolLow", aCountLow, kPriorityLow, stealFrom));
+}
+
+ThreadPool::PriorityQueue& ThreadPool::Queue(ThreadPoolPriority aPriority) const
+{
     PriorityQueue* queue = nullptr;
     switch (aPriority)
     {
@@ -40,7 +106,44 @@ IThreadPoolHandle* ThreadPool::CreateHandle(Functor aCb, const TChar* aId, Threa
     default:
         ASSERTS();
     }
-    return queue->CreateHandle(aCb, aId);
+    return *queue;
+}
+
+
+// ThreadPool::Stats
+
+ThreadPool::Stats::Stats()
+    : iRuns(0)
+    , iWaitUsTotal(0)
+    , iWaitUsMax(0)
+    , iExecUsTotal(0)
+    , iExecUsMax(0)
+{
+}
+
+void ThreadPool::Stats::AddRun(TUint64 aWaitUs, TUint64 aExecUs)
+{
+    iRuns++;
+    iWaitUsTotal += aWaitUs;
+    iExecUsTotal += aExecUs;
+    UpdateMax(iWaitUsMax, aWaitUs);
+    UpdateMax(iExecUsMax, aExecUs);
+}
+
+void ThreadPool::Stats::Write(IWriter& aWriter) const
+{
+    const TUint64 runs = iRuns.load();
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("runs="));
+    writer.WriteUint64(runs);
+    writer.Write(Brn(" waitAvgUs="));
+    writer.WriteUint64(runs == 0? 0 : iWaitUsTotal.load() / runs);
+    writer.Write(Brn(" waitMaxUs="));
+    writer.WriteUint64(iWaitUsMax.load());
+    writer.Write(Brn(" execAvgUs="));
+    writer.WriteUint64(runs == 0? 0 : iExecUsTotal.load() / runs);
+    writer.Write(Brn(" execMaxUs="));
+    writer.WriteUint64(iExecUsMax.load());
 }
 
 
@@ -48,7 +151,7 @@ IThreadPoolHandle* ThreadPool::CreateHandle(Functor aCb, const TChar* aId, Threa
 
 void ThreadPool::Handle::Destroy()
 {
-    iQueue.Cancel(*this);
+    iQueue.Destroy(*this);
     RemoveRef();
 }
 
@@ -73,6 +176,7 @@ ThreadPool::Handle::Handle(IPriorityQueue& aQueue, Functor aCb, const TChar* aId
     , iId(aId)
     , iPending(false)
     , iCancelled(false)
+    , iScheduledUs(0)
 {
 }
 
@@ -80,17 +184,24 @@ ThreadPool::Handle::~Handle()
 {
 }
 
-void ThreadPool::Handle::Run()
+void ThreadPool::Handle::Run(TUint64 aWaitUs)
 {
     LOG_INFO(kThreadPool, "ThreadPool::Handle::Run %s, iCancelled=%u\n", iId, iCancelled);
+    const TBool run = !iCancelled;
+    const TUint64 startUs = TimeNowUs();
     try {
-        if (!iCancelled) {
+        if (run) {
             iCb();
         }
     }
     catch (Exception& ex) {
         LOG_ERROR(kThreadPool, "ThreadPool::Handle::Run %s exception - %s\n", iId, ex.Message());
     }
+    if (run) {
+        const TUint64 execUs = TimeNowUs() - startUs;
+        iStats.AddRun(aWaitUs, execUs);
+        iQueue.NotifyRun(aWaitUs, execUs);
+    }
     iLock.Signal();
     RemoveRef();
 }
@@ -111,11 +222,24 @@ void ThreadPool::Handle::RemoveRef()
 // ThreadPool::PriorityQueue
 
 ThreadPool::PriorityQueue::PriorityQueue(const TChar* aNamePrefix, TUint aThCount, TUint aThPriority)
-    : iLock("TPL1")
+    : PriorityQueue(aNamePrefix, aThCount, aThPriority, std::vector<PriorityQueue*>())
+{
+}
+
+ThreadPool::PriorityQueue::PriorityQueue(const TChar* aNamePrefix, TUint aThCount, TUint aThPriority,
+                                         const std::vector<PriorityQueue*>& aStealFrom)
+    : iStealFrom(aStealFrom)
+    , iLock("TPL1")
     , iSem("TPL2", 0)
     , iHead(nullptr)
     , iTail(nullptr)
+    , iIdleCount(0)
+    , iWakesPending(0)
+    , iStolen(0)
 {
+    for (auto q : iStealFrom) {
+        q->AddHelper(*this);
+    }
     Bws<20> thNameBase(aNamePrefix);
     thNameBase.Append("%u");
     const TChar* fmt = thNameBase.PtrZ();
@@ -130,11 +254,14 @@ ThreadPool::PriorityQueue::PriorityQueue(const TChar* aNamePrefix, TUint aThCoun
 
 ThreadPool::PriorityQueue::~PriorityQueue()
 {
+    for (auto q : iStealFrom) {
+        q->RemoveHelper(*this);
+    }
     for (auto it = iThreads.begin(); it != iThreads.end(); ++it) {
         (*it)->Kill();
     }
     for (TUint i = 0; i < iThreads.size(); i++) {
-        iSem.Signal();
+        Wake();
     }
     for (auto it = iThreads.begin(); it != iThreads.end(); ++it) {
         delete *it;
@@ -151,17 +278,57 @@ ThreadPool::PriorityQueue::~PriorityQueue()
 
 IThreadPoolHandle* ThreadPool::PriorityQueue::CreateHandle(Functor aCb, const TChar* aId)
 {
-    return new ThreadPool::Handle(*this, aCb, aId);
+    auto handle = new ThreadPool::Handle(*this, aCb, aId);
+    AutoMutex _(iLock);
+    iHandles.push_back(handle);
+    return handle;
+}
+
+TUint64 ThreadPool::PriorityQueue::RunCount() const
+{
+    return iStats.iRuns.load();
+}
+
+TUint64 ThreadPool::PriorityQueue::StolenCount() const
+{
+    return iStolen.load();
+}
+
+void ThreadPool::PriorityQueue::WriteStats(IWriter& aWriter)
+{
+    WriterAscii writer(aWriter);
+    writer.Write(Brn("threads="));
+    writer.WriteUint((TUint)iThreads.size());
+    writer.Write(Brn(" stolen="));
+    writer.WriteUint64(iStolen.load());
+    writer.Write(Brn(" "));
+    iStats.Write(aWriter);
+    writer.Write(Brn("\n"));
+    AutoMutex _(iLock);
+    for (auto h : iHandles) {
+        writer.Write(Brn("        "));
+        writer.Write(Brn(h->iId));
+        writer.Write(Brn(": "));
+        h->iStats.Write(aWriter);
+        writer.Write(Brn("\n"));
+    }
 }
 
 TBool ThreadPool::PriorityQueue::TrySchedule(Handle& aHandle)
 {
+    // Avoid the lock in the common case of a callback that is already queued.
+    // Only Dequeue() or Cancel() can clear iPending; either way the caller can't
+    // expect a callback that has already been queued to run again.
+    if (aHandle.iPending.load()) {
+        return false;
+    }
     AutoMutex _(iLock);
-    if (aHandle.iPending) {
+    if (aHandle.iPending.load()) {
         return false;
     }
-    aHandle.iPending = true;
+    aHandle.iPending.store(true);
     aHandle.iCancelled = false;
+    aHandle.iScheduledUs = TimeNowUs();
     if (iHead == nullptr) {
         iHead = &aHandle;
     }
@@ -169,7 +336,18 @@ TBool ThreadPool::PriorityQueue::TrySchedule(Handle& aHandle)
         iTail->iNext = &aHandle;
     }
     iTail = &aHandle;
-    iSem.Signal();
+    const TBool idle = HasUnclaimedIdle();
+    Wake();
+    if (!idle) {
+        /* Every one of our threads is busy or has already been woken for an earlier
+           callback.  Wake an idle lower priority thread to steal this callback. */
+        for (auto q : iHelpers) {
+            if (q->HasUnclaimedIdle()) {
+                q->Wake();
+                break;
+            }
+        }
+    }
     return true;
 }
 
@@ -198,33 +376,103 @@ void ThreadPool::PriorityQueue::Cancel(Handle& aHandle)
             iTail = prev;
         }
         h->iNext = nullptr;
-        h->iPending = false;
+        h->iPending.store(false);
+    }
+}
+
+void ThreadPool::PriorityQueue::Destroy(Handle& aHandle)
+{
+    Cancel(aHandle);
+    AutoMutex _(iLock);
+    auto it = std::find(iHandles.begin(), iHandles.end(), &aHandle);
+    if (it != iHandles.end()) {
+        iHandles.erase(it);
+    }
+}
+
+void ThreadPool::PriorityQueue::NotifyRun(TUint64 aWaitUs, TUint64 aExecUs)
+{
+    iStats.AddRun(aWaitUs, aExecUs);
+}
+
+ThreadPool::ICallback* ThreadPool::PriorityQueue::Dequeue(TUint64& aWaitUs)
+{
+    /* Check for work before blocking.  The wake for a callback queued here may have
+       been used to steal from a higher priority queue so we can't rely on iSem to
+       tell us about all callbacks. */
+    auto cb = TryDequeueAny(aWaitUs);
+    if (cb == nullptr) {
+        iIdleCount++;
+        iSem.Wait();
+        iWakesPending--;
+        iIdleCount--;
+        cb = TryDequeueAny(aWaitUs);
+    }
+    return cb;
+}
+
+TBool ThreadPool::PriorityQueue::HasUnclaimedIdle() const
+{
+    // an idle thread that has been signalled but not yet run is already claimed
+    return iIdleCount.load() > iWakesPending.load();
+}
+
+void ThreadPool::PriorityQueue::Wake()
+{
+    iWakesPending++;
+    iSem.Signal();
+}
+
+void ThreadPool::PriorityQueue::AddHelper(PriorityQueue& aQueue)
+{
+    AutoMutex _(iLock);
+    iHelpers.push_back(&aQueue);
+}
+
+void ThreadPool::PriorityQueue::RemoveHelper(PriorityQueue& aQueue)
+{
+    AutoMutex _(iLock);
+    auto it = std::find(iHelpers.begin(), iHelpers.end(), &aQueue);
+    if (it != iHelpers.end()) {
+        iHelpers.erase(it);
     }
 }
 
-ThreadPool::ICallback* ThreadPool::PriorityQueue::Dequeue()
+ThreadPool::Handle* ThreadPool::PriorityQueue::TryDequeue(TUint64& aWaitUs)
 {
-    iSem.Wait();
     ThreadPool::Handle* h = nullptr;
     {
         AutoMutex _(iLock);
         h = iHead;
-        if (h != nullptr) {
-            iHead = h->iNext;
-            if (iHead == nullptr) {
-                iTail = nullptr;
-            }
-            h->iNext = nullptr;
-            h->iPending = false;
-            h->AddRef();
+        if (h == nullptr) {
+            return nullptr;
         }
+        iHead = h->iNext;
+        if (iHead == nullptr) {
+            iTail = nullptr;
+        }
+        h->iNext = nullptr;
+        h->iPending.store(false);
+        h->AddRef();
+        const TUint64 now = TimeNowUs();
+        aWaitUs = (now > h->iScheduledUs? now - h->iScheduledUs : 0);
     }
-    if (h != nullptr) {
-        h->iLock.Wait();
-    }
+    h->iLock.Wait();
     return h;
 }
 
+ThreadPool::ICallback* ThreadPool::PriorityQueue::TryDequeueAny(TUint64& aWaitUs)
+{
+    for (auto q : iStealFrom) {
+        auto h = q->TryDequeue(aWaitUs);
+        if (h != nullptr) {
+            q->iStolen++;
+            return h;
+        }
+    }
+    return TryDequeue(aWaitUs);
+}
+
 
 // ThreadPool::PoolThread
 
@@ -237,9 +485,10 @@ ThreadPool::PoolThread::PoolThread(const TChar* aName, TUint aPriority, IQueueRe
 void ThreadPool::PoolThread::Run()
 {
     for (;;) {
-        auto cb = iQueueReader.Dequeue();
+        TUint64 waitUs = 0;
+        auto cb = iQueueReader.Dequeue(waitUs);
         if (cb != nullptr) {
-            cb->Run();
+            cb->Run(waitUs);
         }
         CheckForKill();
     }
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
 #include <OpenHome/Functor.h>
 #include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/InfoProvider.h>
 
 #include <atomic>
 #include <memory>
@@ -34,13 +36,31 @@ public:
     virtual IThreadPoolHandle* CreateHandle(Functor aCb, const TChar* aId, ThreadPoolPriority aPriority) = 0;
 };
 
-class ThreadPool : public IThreadPool
+/*
+ * Each priority has its own threads and queue of callbacks.
+ * Threads whose own queue is empty help with (steal) the backlog of higher priority
+ * queues, so a slow callback can't hold up others of higher priority that are queued
+ * behind it.  Higher priority threads never run lower priority callbacks.
+ * A stolen callback runs at the OS priority of the thread that stole it, so a High
+ * callback run by a Medium or Low thread is not boosted.
+ *
+ * Per-priority and per-handle counts of runs, time spent queued and time spent running
+ * are reported via IInfoAggregator's "threadpool" query.
+ */
+class ThreadPool : public IThreadPool, private IInfoProvider
 {
     friend class SuitePriorityQueue;
+public:
+    static const Brn kQueryThreadPool;
 public:
     ThreadPool(TUint aCountHigh, TUint aCountMedium, TUint aCountLow);
+    ThreadPool(IInfoAggregator& aInfoAggregator, TUint aCountHigh, TUint aCountMedium, TUint aCountLow);
+    TUint64 RunCount(ThreadPoolPriority aPriority) const;
+    TUint64 StolenCount(ThreadPoolPriority aPriority) const; // callbacks run by threads of a lower priority
 public: // from IThreadPool
     IThreadPoolHandle* CreateHandle(Functor aCb, const TChar* aId, ThreadPoolPriority aPriority) override;
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
 private:
     class IPriorityQueue;
     class PriorityQueue;
@@ -48,7 +68,20 @@ private:
     {
     public:
         virtual ~ICallback() {}
-        virtual void Run() = 0;
+        virtual void Run(TUint64 aWaitUs) = 0;
+    };
+    class Stats
+    {
+    public:
+        Stats();
+        void AddRun(TUint64 aWaitUs, TUint64 aExecUs);
+        void Write(IWriter& aWriter) const;
+    public:
+        std::atomic<TUint64> iRuns;
+        std::atomic<TUint64> iWaitUsTotal;
+        std::atomic<TUint64> iWaitUsMax;
+        std::atomic<TUint64> iExecUsTotal;
+        std::atomic<TUint64> iExecUsMax;
     };
     class Handle : public IThreadPoolHandle, private ICallback
     {
@@ -58,7 +91,7 @@ private:
         TBool TrySchedule() override;
         void Cancel() override;
     private: // from ICallback
-        void Run() override;
+        void Run(TUint64 aWaitUs) override;
     private:
         Handle(IPriorityQueue& aQueue, Functor aCb, const TChar* aId);
         ~Handle();
@@ -71,8 +104,10 @@ private:
         Handle* iNext;
         Functor iCb;
         const TChar* iId;
-        TBool iPending;
+        std::atomic<TBool> iPending; // written with queue lock held; read without it by TrySchedule
         TBool iCancelled;
+        TUint64 iScheduledUs;
+        Stats iStats;
     };
     class IPriorityQueue
     {
@@ -80,12 +115,14 @@ private:
         virtual ~IPriorityQueue() {}
         virtual TBool TrySchedule(Handle& aHandle) = 0;
         virtual void Cancel(Handle& aHandle) = 0;
+        virtual void Destroy(Handle& aHandle) = 0;
+        virtual void NotifyRun(TUint64 aWaitUs, TUint64 aExecUs) = 0;
     };
     class IQueueReader
     {
     public:
         virtual ~IQueueReader() {}
-        virtual ICallback* Dequeue() = 0;
+        virtual ICallback* Dequeue(TUint64& aWaitUs) = 0;
     };
     class PoolThread;
     class PriorityQueue : private IPriorityQueue, private IQueueReader
@@ -93,19 +130,40 @@ private:
         friend class SuitePriorityQueue;
     public:
         PriorityQueue(const TChar* aNamePrefix, TUint aThCount, TUint aThPriority);
+        PriorityQueue(const TChar* aNamePrefix, TUint aThCount, TUint aThPriority,
+                      const std::vector<PriorityQueue*>& aStealFrom); // aStealFrom ordered highest priority first
         ~PriorityQueue();
         IThreadPoolHandle* CreateHandle(Functor aCb, const TChar* aId);
+        TUint64 RunCount() const;
+        TUint64 StolenCount() const;
+        void WriteStats(IWriter& aWriter);
     private: // from IPriorityQueue
         TBool TrySchedule(Handle& aHandle) override;
         void Cancel(Handle& aHandle) override;
+        void Destroy(Handle& aHandle) override;
+        void NotifyRun(TUint64 aWaitUs, TUint64 aExecUs) override;
     private: // from IQueueReader
-        ICallback* Dequeue() override;
+        ICallback* Dequeue(TUint64& aWaitUs) override;
+    private:
+        void AddHelper(PriorityQueue& aQueue);
+        void RemoveHelper(PriorityQueue& aQueue);
+        TBool HasUnclaimedIdle() const;
+        void Wake();
+        Handle* TryDequeue(TUint64& aWaitUs);
+        ICallback* TryDequeueAny(TUint64& aWaitUs);
     private:
         std::vector<PoolThread*> iThreads;
+        const std::vector<PriorityQueue*> iStealFrom;
+        std::vector<PriorityQueue*> iHelpers; // lower priority queues whose threads may steal from us
         Mutex iLock;
         Semaphore iSem;
         Handle* iHead;
         Handle* iTail;
+        std::vector<Handle*> iHandles;
+        std::atomic<TUint> iIdleCount;
+        std::atomic<TUint> iWakesPending; // iSem signals not yet consumed by a waiting thread
+        std::atomic<TUint64> iStolen;
+        Stats iStats;
     };
     class PoolThread : public Thread
     {
@@ -117,6 +175,11 @@ private:
         IQueueReader& iQueueReader;
     };
 private:
+    void CreateQueues(TUint aCountHigh, TUint aCountMedium, TUint aCountLow);
+    PriorityQueue& Queue(ThreadPoolPriority aPriority) const;
+private:
+    // declared highest priority first so are destroyed lowest first, stopping any
+    // threads that steal from a queue before it is deleted
     std::unique_ptr<PriorityQueue> iQueueHigh;
     std::unique_ptr<PriorityQueue> iQueueMed;
     std::unique_ptr<PriorityQueue> iQueueLow;